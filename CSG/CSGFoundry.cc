@@ -23,6 +23,7 @@
 #include "SPath.hh"
 #include "s_time.h"
 #include "SBitSet.h"
+#include "sbundle.h"
 
 #include "SEventConfig.hh"
 #include "SGeoConfig.hh"
@@ -48,6 +49,7 @@
 #include "CSGMaker.h"
 #include "CSGImport.h"
 #include "CSGCopy.h"
+#include "CSGSelection.h"
 
 const unsigned CSGFoundry::IMAX = 50000 ;
 
@@ -115,6 +117,7 @@ CSGFoundry::CSGFoundry()
     loaddir(nullptr),
     origin(nullptr),
     elv(nullptr),
+    selection(nullptr),
     save_opt(ssys::getenvvar(SAVE_OPT))
 {
     LOG_IF(fatal, sim == nullptr) << "must SSim::Create before CSGFoundry::CSGFoundry " ;
@@ -287,6 +290,22 @@ bool CSGFoundry::isSolidTrimesh(int gas_idx) const
     return trimesh ;
 }
 
+/**
+CSGFoundry::hasSolidTrimesh
+-----------------------------
+
+True when any solid is configured to use triangulated geometry,
+the in-place applySelection does not support that.
+
+**/
+
+bool CSGFoundry::hasSolidTrimesh() const
+{
+    int num_solid = getNumSolid();
+    for(int i=0 ; i < num_solid ; i++) if(isSolidTrimesh(i)) return true ;
+    return false ;
+}
+
 
 
 
@@ -1527,6 +1546,7 @@ SCSGPrimSpec CSGFoundry::getPrimSpec(unsigned solidIdx) const
 }
 SCSGPrimSpec CSGFoundry::getPrimSpecHost(unsigned solidIdx) const
 {
+    if(selection) return selection->getPrimSpecHost(solidIdx) ;
     const CSGSolid* so = solid.data() + solidIdx ;
     SCSGPrimSpec ps = CSGPrim::MakeSpec( prim.data(),  so->primOffset, so->numPrim ); ;
     ps.device = false ;
@@ -1535,6 +1555,7 @@ SCSGPrimSpec CSGFoundry::getPrimSpecHost(unsigned solidIdx) const
 SCSGPrimSpec CSGFoundry::getPrimSpecDevice(unsigned solidIdx) const
 {
     assert( d_prim );
+    if(selection) return selection->getPrimSpecDevice(solidIdx) ;
     const CSGSolid* so = solid.data() + solidIdx ;  // get the primOffset from CPU side solid
     SCSGPrimSpec ps = CSGPrim::MakeSpec( d_prim,  so->primOffset, so->numPrim ); ;
     ps.device = true ;
@@ -2666,7 +2687,13 @@ void CSGFoundry::save_(const char* dir_) const
     const char* dir = SPath::Resolve(dir_, DIRPATH);
     LOG(LEVEL) << dir ;
 
-    if(meshname.size() > 0 && save__("meshname")) NP::WriteNames( dir, "meshname.txt", meshname );
+    if(meshname.size() > 0 && save__("meshname"))
+    {
+        NP::WriteNames( dir, "meshname.txt", meshname );
+        const SNameIndex* meshname_index = id->index ? id->index : SNameIndex::Create(meshname) ;
+        meshname_index->save( dir, "meshname" );   // meshname_index folder used by SName queries
+        if( meshname_index != id->index ) delete meshname_index ;
+    }
 
     std::vector<std::string> primname ;
     getPrimName(primname);
@@ -2877,6 +2904,7 @@ void CSGFoundry::load( const char* dir_ )
     LOG(LEVEL) << "[ loaddir " << loaddir ;
 
     NP::ReadNames( dir, "meshname.txt", meshname );
+    id->set_index( SNameIndex::Load( meshname, dir, "meshname" ) );
     NP::ReadNames( dir, "mmlabel.txt", mmlabel );
 
     const char* meta_str = U::ReadString( dir, "meta.txt" ) ;
@@ -2905,6 +2933,55 @@ void CSGFoundry::load( const char* dir_ )
 }
 
 
+/**
+CSGFoundry::load from bundle
+------------------------------
+
+As CSGFoundry::load from directory but with the names and arrays taken
+from the sections of an sbundle, see CSGFoundry::LoadBundle.
+The POD arrays are memcpy from the mapping with no file opening or parsing.
+Returns non-zero when any non-optional array is missing or has an
+unexpected item size.
+
+**/
+
+int CSGFoundry::load( const sbundle* b )
+{
+    loaddir = strdup(b->path) ;
+    LOG(LEVEL) << "[ loaddir " << loaddir ;
+
+    b->lines( meshname, "meshname.txt" );
+    id->set_index( SNameIndex::Load( meshname, b->fold("meshname_index") ) );
+    b->lines( mmlabel, "mmlabel.txt" );
+
+    std::string meta_str = b->string("meta.txt") ;
+    if(!meta_str.empty())
+    {
+       meta = meta_str ;
+    }
+    else
+    {
+       LOG(warning) << " no meta.txt in " << loaddir ;
+    }
+
+    int rc = 0 ;
+    rc += b->copy( solid, "solid.npy" );
+    rc += b->copy( prim,  "prim.npy" );
+    rc += b->copy( node,  "node.npy" );
+    rc += b->copy( tran,  "tran.npy" );
+    rc += b->copy( itra,  "itra.npy" );
+    rc += b->copy( inst,  "inst.npy" );
+    if(b->has("plan.npy")) rc += b->copy( plan, "plan.npy" );
+
+    LOG_IF(fatal, rc != 0) << " FAIL to load arrays from bundle " << loaddir << " rc " << rc ;
+
+    mtime = SPath::mtime(b->path);
+
+    LOG(LEVEL) << "] loaddir " << loaddir ;
+    return rc ;
+}
+
+
 /**
 CSGFoundry::loadAux
 ----------------------
@@ -2952,6 +3029,42 @@ void CSGFoundry::setElv(const SBitSet* elv_)
     elv = elv_ ;
 }
 
+/**
+CSGFoundry::applySelection
+----------------------------
+
+In-place alternative to CopySelect : the ELV selection is applied
+as a CSGSelection view leaving the solids, prims and nodes unchanged.
+Subsequent calls with different *elv* only change the prims of meshes
+with changed bits, the changed solids are in getSelection()->dirty
+for SBT::updateSelection to rebuild just those acceleration structures.
+
+Returns the number of solids changed, or -1 when the selection is
+rejected because some solids are triangulated : the selection
+view only changes the analytic prim bounds, it cannot change the
+SScene meshgroups of triangulated solids which CopySelect handles
+with SScene::copy. In that case the selection is left unchanged.
+
+**/
+
+int CSGFoundry::applySelection(const SBitSet* elv_)
+{
+    bool trimesh = hasSolidTrimesh() ;
+    LOG_IF(fatal, trimesh) << " in-place selection view does not support triangulated solids, use CopySelect " ;
+    if(trimesh) return -1 ;
+
+    if(selection == nullptr) selection = new CSGSelection(this) ;
+    unsigned num_dirty = selection->apply(elv_) ;
+    if(isUploaded() && !selection->isUploaded()) selection->upload();
+    setElv(elv_);
+    return int(num_dirty) ;
+}
+
+const CSGSelection* CSGFoundry::getSelection() const
+{
+    return selection ;
+}
+
 
 
 /**
@@ -3011,6 +3124,12 @@ python analysis machinery.
 
 This is taking 0.48s for full JUNO, thats 27% of single event gxt.sh runtime
 
+With CSGFoundry__Load_ELV_VIEW the ELV selection is instead applied in-place
+with CSGFoundry::applySelection, avoiding the copy. The prim and solid
+indices then remain those of the full geometry. As the triangulated SScene
+can only be selected by copying, which changes its solid indices, geometries
+with triangulated solids fall back to CopySelect.
+
 
 Q: Where is the SSim handover ? How to apply selection to the SScene ?
 
@@ -3018,6 +3137,8 @@ Q: Where is the SSim handover ? How to apply selection to the SScene ?
 **/
 
 bool CSGFoundry::Load_saveAlt = ssys::getenvbool("CSGFoundry_Load_saveAlt") ;
+bool CSGFoundry::Load_ELV_VIEW = ssys::getenvbool("CSGFoundry__Load_ELV_VIEW") ;
+bool CSGFoundry::Load_BUNDLE = ssys::getenvbool("CSGFoundry__Load_BUNDLE") ;
 
 CSGFoundry* CSGFoundry::Load() // static
 {
@@ -3032,10 +3153,15 @@ CSGFoundry* CSGFoundry::Load() // static
     SGeoConfig::GeometrySpecificSetup(src->id);
 
     const SBitSet* elv = SGeoConfig::ELV(src->id);
-    CSGFoundry* dst = elv ? CSGFoundry::CopySelect(src, elv) : src  ;
+    CSGFoundry* dst = src ;
+    bool view = elv && Load_ELV_VIEW && src->applySelection(elv) > -1 ;
+    if( elv && !view )
+    {
+        dst = CSGFoundry::CopySelect(src, elv) ;
+    }
 
 
-    if(elv)
+    if(elv && !view)
     {
         LOG(LEVEL) << " apply ELV selection to triangulated SScene " ;
         SScene* src_sc = dst->sim->scene ;
@@ -3044,7 +3170,7 @@ CSGFoundry* CSGFoundry::Load() // static
     }
 
 
-    if( elv != nullptr && Load_saveAlt)
+    if( elv != nullptr && Load_saveAlt && dst != src )
     {
         LOG(error) << " non-standard dynamic selection CSGFoundry_Load_saveAlt " ;
         dst->saveAlt() ;
@@ -3106,7 +3232,7 @@ The former use of CFBASE envvar with SOpticksResource::CFBase is removed.
 const char* CSGFoundry::ResolveCFBase()
 {
     const char* cfbase = spath::CFBaseFromGEOM();
-    bool readable = spath::is_readable(cfbase, "CSGFoundry" );
+    bool readable = spath::is_readable(cfbase, "CSGFoundry" ) || ( Load_BUNDLE && spath::is_readable(cfbase, BUNDLE ) ) ;
     LOG_IF(fatal, !readable) << " cfbase/CSGFoundry directory [" << cfbase << "]/CSGFoundry" << " IS NOT READABLE " ;
     return readable ? cfbase : nullptr ;
 }
@@ -3140,6 +3266,8 @@ CSGFoundry* CSGFoundry::Load_() // static
     const char* cfbase = ResolveCFBase() ;
     if(ssys::getenvbool(_Load_DUMP)) std::cout << "CSGFoundry::Load_[" << cfbase << "]\n" ;
 
+    if( cfbase && Load_BUNDLE && spath::is_readable(cfbase, BUNDLE) ) return LoadBundle(cfbase) ;
+
     LOG(LEVEL) << "[ SSim::Load cfbase " << ( cfbase ? cfbase : "-" )  ;
     SSim* sim = SSim::Load(cfbase, "CSGFoundry/SSim");
     LOG(LEVEL) << "] SSim::Load " ;
@@ -3162,6 +3290,79 @@ CSGFoundry*  CSGFoundry::Load(const char* base, const char* rel) // static
 }
 
 
+/**
+CSGFoundry bundle
+-------------------
+
+The directory form cfbase/CSGFoundry including its SSim subfold is
+converted into the single file cfbase/CSGFoundry.bundle with CreateBundle
+and back with ExtractBundle. With CSGFoundry__Load_BUNDLE CSGFoundry::Load
+uses the bundle when present, which opens one file rather than the
+hundreds of the directory form, so is much faster on networked filesystems.
+See sysrap/sbundle.h for the layout.
+
+**/
+
+const char* CSGFoundry::BundlePath(const char* cfbase) // static
+{
+    return spath::Resolve(cfbase, BUNDLE) ;
+}
+
+int CSGFoundry::CreateBundle(const char* cfbase) // static
+{
+    const char* path = BundlePath(cfbase) ;
+    const char* dir = spath::Resolve(cfbase, RELDIR) ;
+    int rc = sbundle::Create(path, dir) ;
+    LOG(LEVEL) << " path " << path << " dir " << dir << " rc " << rc ;
+    return rc ;
+}
+
+int CSGFoundry::ExtractBundle(const char* cfbase, const char* dst_cfbase) // static
+{
+    sbundle* b = sbundle::Load(BundlePath(cfbase)) ;
+    if( b == nullptr ) return 1 ;
+    int rc = b->extract( spath::Resolve(dst_cfbase, RELDIR) ) ;
+    delete b ;
+    return rc ;
+}
+
+/**
+CSGFoundry::LoadBundle
+------------------------
+
+Equivalent of CSGFoundry::Load_ from the bundle, the SSim is imported from
+the bundled SSim subfold prior to instanciating the CSGFoundry as SSim::Load
+is used from CSGFoundry::Load_.
+
+**/
+
+CSGFoundry* CSGFoundry::LoadBundle(const char* cfbase) // static
+{
+    const char* path = BundlePath(cfbase) ;
+    LOG(LEVEL) << "[ " << path ;
+
+    sbundle* b = sbundle::Load(path) ;
+    LOG_IF(fatal, b == nullptr) << " FAILED to open bundle " << path ;
+    if( b == nullptr ) return nullptr ;
+
+    NPFold* top = b->fold(SSim::RELDIR) ;
+    LOG_IF(fatal, top == nullptr) << " sim(SSim) required before CSGFoundry::Load : bundle lacks " << SSim::RELDIR ;
+    assert(top);
+
+    SSim* sim = SSim::Import(top) ;
+    assert(sim);
+
+    CSGFoundry* fd = new CSGFoundry();
+    fd->setCFBase(cfbase);
+    int rc = fd->load(b) ;
+    assert( rc == 0 );
+    delete b ;
+
+    LOG(LEVEL) << "] " << path << " rc " << rc ;
+    return rc == 0 ? fd : nullptr ;
+}
+
+
 void CSGFoundry::setOverrideSim( const SSim* override_sim )
 {
     sim = override_sim ;
@@ -3265,6 +3466,8 @@ void CSGFoundry::upload()
     d_plan = plan.size() > 0 ? CU::UploadArray<float4>(plan.data(), plan.size() ) : nullptr ;
     d_itra = itra.size() > 0 ? CU::UploadArray<qat4>(itra.data(), itra.size() ) : nullptr ;
 
+    if(selection) selection->upload();
+
     bool is_uploaded_1 = isUploaded();
     LOG_IF(fatal, !is_uploaded_1) << "FAILED TO UPLOAD" ;
     assert(is_uploaded_1 == true);
@@ -3302,11 +3505,13 @@ unsigned CSGFoundry::getNumUniqueINS() const
 
 unsigned CSGFoundry::getNumInstancesIAS(int ias_idx, unsigned long long emm) const
 {
-    return qat4::count_ias(inst, ias_idx, emm );
+    unsigned long long _emm = selection ? selection->solidMask(emm) : emm ;
+    return qat4::count_ias(inst, ias_idx, _emm );
 }
 void CSGFoundry::getInstanceTransformsIAS(std::vector<qat4>& select_inst, int ias_idx, unsigned long long emm ) const
 {
-    qat4::select_instances_ias(inst, select_inst, ias_idx, emm ) ;
+    unsigned long long _emm = selection ? selection->solidMask(emm) : emm ;
+    qat4::select_instances_ias(inst, select_inst, ias_idx, _emm ) ;
 }
 
 
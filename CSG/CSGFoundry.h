@@ -8,6 +8,7 @@
 struct SBitSet ;
 struct NP ;
 struct SSim ;
+struct sbundle ;
 struct stree ;
 struct SScene ;
 
@@ -23,6 +24,7 @@ struct SName ;
 struct CSGTarget ;
 struct CSGMaker ;
 struct CSGImport ;
+struct CSGSelection ;
 
 #include "CSGEnum.h"
 #include "CSGSolid.h"
@@ -108,6 +110,8 @@ struct CSG_API CSGFoundry : public SGeo
 
 
     static bool Load_saveAlt ;
+    static bool Load_ELV_VIEW ;
+    static bool Load_BUNDLE ;
     static CSGFoundry* CreateFromSim();
     static CSGFoundry* Load();
     static CSGFoundry* CopySelect(const CSGFoundry* src, const SBitSet* elv );
@@ -119,6 +123,12 @@ struct CSG_API CSGFoundry : public SGeo
     static CSGFoundry* Load_();
     static CSGFoundry* Load(const char* base, const char* rel=RELDIR );
 
+    static constexpr const char* BUNDLE = "CSGFoundry.bundle" ;
+    static const char* BundlePath(const char* cfbase);
+    static int CreateBundle(const char* cfbase);
+    static int ExtractBundle(const char* cfbase, const char* dst_cfbase);
+    static CSGFoundry* LoadBundle(const char* cfbase);
+
     void setOverrideSim( const SSim* ssim );
     const SSim* getSim() const ;
 
@@ -154,6 +164,9 @@ struct CSG_API CSGFoundry : public SGeo
     void setOrigin(const CSGFoundry* origin);
     void setElv(const SBitSet* elv);
 
+    int applySelection(const SBitSet* elv);
+    const CSGSelection* getSelection() const ;
+
     std::string brief() const ;
     std::string desc() const ;
     std::string descBase() const ;
@@ -336,6 +349,7 @@ struct CSG_API CSGFoundry : public SGeo
 
     static const char* LOAD_FAIL_NOTES ;
     void load( const char* dir ) ;
+    int  load( const sbundle* b ) ;
     NP* loadAux(const char* auxrel="Values/values.npy" ) const ;
 
     static int MTime(const char* dir, const char* fname_);
@@ -397,6 +411,7 @@ struct CSG_API CSGFoundry : public SGeo
     int findSolidWithLabel(const char* q_mml) const ;
     bool isSolidTrimesh_posthoc_kludge(int gas_idx) const ;  // see SGeoConfig::SolidTrimesh
     bool isSolidTrimesh(int gas_idx) const ;  // see notes/issues/flexible_forced_triangulation.rst
+    bool hasSolidTrimesh() const ;
 
     static void CopyNames(    CSGFoundry* dst, const CSGFoundry* src );
     static void CopyMeshName( CSGFoundry* dst, const CSGFoundry* src );
@@ -475,6 +490,7 @@ struct CSG_API CSGFoundry : public SGeo
 
     const CSGFoundry* origin ;
     const SBitSet*    elv ;
+    CSGSelection*     selection ;
     const char* save_opt ;
 };
 
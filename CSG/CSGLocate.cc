@@ -0,0 +1,272 @@
+#include <sstream>
+
+#include "SLOG.hh"
+#include "ssys.h"
+#include "NP.hh"
+#include "SSim.hh"
+#include "stree.h"
+#include "sparallel.h"
+
+#include "CSGFoundry.h"
+#include "CSGRayQuery.h"
+#include "CSGLocate.h"
+
+#include "csg_intersect_leaf.h"
+#include "csg_intersect_node.h"
+#include "csg_intersect_tree.h"
+
+
+const plog::Severity CSGLocate::LEVEL = SLOG::EnvLevel("CSGLocate", "DEBUG") ;
+
+CSGLocate::CSGLocate( const CSGFoundry* fd_, const CSGRayQuery* rq_ )
+    :
+    fd(fd_),
+    rq(rq_ ? rq_ : new CSGRayQuery(fd_)),
+    own_rq(rq_ == nullptr),
+    st(fd->getSim() ? fd->getSim()->tree : nullptr),
+    num_thread(ssys::getenvint(CSGLocate__NUM_THREAD, 0)),
+    num_lvid_mismatch(0)
+{
+    init();
+}
+
+CSGLocate::~CSGLocate()
+{
+    if(own_rq) delete rq ;
+}
+
+/**
+CSGLocate::init
+-----------------
+
+The stree is only used when its instances correspond to those of the CSGFoundry,
+as they do when both are from the same translation. The node of every item
+must also have the lvid of the prim meshIdx, when any differ the prim to node
+mapping of get_nidx does not apply so the stree is not used.
+
+**/
+
+void CSGLocate::init()
+{
+    bool st_match = st && st->inst_nidx.size() == fd->inst.size() && st->nds.size() > 0 ;
+    LOG_IF(error, st && !st_match)
+        << " stree instances do not match CSGFoundry, nidx not available "
+        << " st.inst_nidx " << st->inst_nidx.size()
+        << " fd.inst " << fd->inst.size()
+        ;
+    if(!st_match) st = nullptr ;
+
+    int num_item = rq->item.size() ;
+    item_nidx.resize(num_item);
+    item_depth.resize(num_item);
+    item_volume.resize(num_item);
+
+    for(int i=0 ; i < num_item ; i++)
+    {
+        const CSGRayQuery::Item& it = rq->item[i] ;
+        int nidx = get_nidx(it.inst, it.prim) ;
+        item_nidx[i] = nidx ;
+        item_depth[i] = nidx > -1 ? st->nds[nidx].depth : -1 ;
+        item_volume[i] = ( it.bb[3] - it.bb[0] )*( it.bb[4] - it.bb[1] )*( it.bb[5] - it.bb[2] ) ;
+
+        const CSGPrim* pr = rq->prim0 + it.prim ;
+        if( nidx > -1 && st->nds[nidx].lvid != int(pr->meshIdx()) ) num_lvid_mismatch += 1 ;
+    }
+
+    LOG_IF(error, num_lvid_mismatch > 0 )
+        << " stree node lvid differ from prim meshIdx, nidx not available "
+        << " num_lvid_mismatch " << num_lvid_mismatch
+        << " num_item " << num_item
+        ;
+
+    if( num_lvid_mismatch > 0 )
+    {
+        st = nullptr ;
+        for(int i=0 ; i < num_item ; i++)
+        {
+            item_nidx[i] = -1 ;
+            item_depth[i] = -1 ;
+        }
+    }
+    LOG(LEVEL) << desc() ;
+}
+
+/**
+CSGLocate::get_nidx
+---------------------
+
+Maps (instance, globalPrimIdx) to stree node index following the
+prim ordering of CSGImport::importSolid. The remainder and triangulated
+solids have one prim for each node of stree::rem and stree::tri.
+The prims of factor solids follow the contiguous nodes of the repeated
+subtree starting from the outer node of the instance.
+
+**/
+
+int CSGLocate::get_nidx(int inst, int primIdx) const
+{
+    if( st == nullptr ) return -1 ;
+
+    int ins_idx, gas_idx, sensor_identifier, sensor_index ;
+    fd->inst[inst].getIdentity(ins_idx, gas_idx, sensor_identifier, sensor_index );
+    if( gas_idx < 0 || gas_idx >= st->get_num_ridx() ) return -1 ;
+
+    const CSGSolid* so = fd->getSolid(gas_idx) ;
+    int primRel = primIdx - so->primOffset ;
+
+    int nidx = -1 ;
+    char ridx_type = st->get_ridx_type(gas_idx) ;
+    switch(ridx_type)
+    {
+        case 'R': nidx = primRel < int(st->rem.size()) ? st->rem[primRel].index : -1 ; break ;
+        case 'T': nidx = primRel < int(st->tri.size()) ? st->tri[primRel].index : -1 ; break ;
+        case 'F': nidx = st->inst_nidx[inst] + primRel                              ; break ;
+    }
+    return nidx > -1 && nidx < int(st->nds.size()) ? nidx : -1 ;
+}
+
+/**
+CSGLocate::is_inner
+---------------------
+
+Returns true when item a is within item b, assuming both contain
+the same point : descendant nodes are deeper and in case of overlaps
+later in the preorder node ordering.
+
+**/
+
+bool CSGLocate::is_inner(int a, int b) const
+{
+    if( item_nidx[a] > -1 && item_nidx[b] > -1 )
+    {
+        return item_depth[a] == item_depth[b] ? item_nidx[a] > item_nidx[b] : item_depth[a] > item_depth[b] ;
+    }
+    return item_volume[a] < item_volume[b] ;
+}
+
+/**
+CSGLocate::distance_item
+--------------------------
+
+Signed distance of the world frame position to the prim of item j,
+evaluated in the instance frame, negative inside.
+
+**/
+
+float CSGLocate::distance_item( int j, const float3& pos ) const
+{
+    const CSGRayQuery::Item& it = rq->item[j] ;
+    float3 lpos = rq->w2m[it.inst].right_multiply( pos, 1.f );
+    const CSGPrim* pr = rq->prim0 + it.prim ;
+    return distance_prim( lpos, rq->node0 + pr->nodeOffset(), rq->plan0, rq->itra0 );
+}
+
+/**
+CSGLocate::locate_item
+------------------------
+
+Returns the CSGRayQuery item index of the innermost prim containing
+the world frame position, or -1 when outside all prims.
+The optional sd is set to the signed distance to that prim.
+
+**/
+
+int CSGLocate::locate_item( const float3& pos, float* sd ) const
+{
+    std::vector<int> items ;
+    rq->collect(items, pos);
+
+    int best = -1 ;
+    float best_sd = 0.f ;
+    for(unsigned i=0 ; i < items.size() ; i++)
+    {
+        int j = items[i] ;
+        float d = distance_item( j, pos );
+        if( d < 0.f && ( best == -1 || is_inner(j, best) ))
+        {
+            best = j ;
+            best_sd = d ;
+        }
+    }
+    if(sd) *sd = best_sd ;
+    return best ;
+}
+
+void CSGLocate::locate( int* loc, const float3& pos ) const
+{
+    for(int k=0 ; k < NV ; k++) loc[k] = -1 ;
+
+    int j = locate_item(pos) ;
+    if( j == -1 ) return ;
+
+    const CSGRayQuery::Item& it = rq->item[j] ;
+    const CSGPrim* pr = rq->prim0 + it.prim ;
+    int boundary = rq->prim_boundary[it.prim] ;
+
+    int ins_idx, gas_idx, sensor_identifier, sensor_index ;
+    fd->inst[it.inst].getIdentity(ins_idx, gas_idx, sensor_identifier, sensor_index );
+
+    loc[NIDX] = item_nidx[j] ;
+    loc[IINDEX] = it.inst ;
+    loc[GPRIM] = pr->globalPrimIdx() ;
+    loc[BOUNDARY] = boundary ;
+    loc[IMAT] = st && boundary > -1 && boundary < int(st->vbd.size()) ? st->vbd[boundary].w : -1 ;
+    loc[SENSOR_ID] = sensor_identifier ;
+    loc[SENSOR_INDEX] = sensor_index ;
+    loc[LVID] = pr->meshIdx() ;
+}
+
+/**
+CSGLocate::locate
+-------------------
+
+pos
+    shape (N,3) or (N,4) float or double, only xyz used
+
+Returns (N,8) int32 array with names as described in the header.
+
+**/
+
+NP* CSGLocate::locate( const NP* pos ) const
+{
+    NP* p = NP::MakeNarrowIfWide(pos) ;
+    int num = p ? p->shape[0] : 0 ;
+    int nv = p ? p->num_itemvalues() : 0 ;
+    bool expected = p && p->uifc == 'f' && ( nv == 3 || nv == 4 ) ;
+
+    LOG_IF(error, !expected) << " unexpected pos " << ( pos ? pos->sstr() : "-" ) ;
+
+    NP* loc = expected ? NP::Make<int>(num, NV) : nullptr ;
+    if( loc )
+    {
+        const float* pp = p->cvalues<float>() ;
+        int* ll = loc->values<int>() ;
+
+        int nt = sparallel::NumThread(num, num_thread, 256) ;
+        sparallel::For(num, nt, [&](int, int i0, int i1)
+        {
+            for(int i=i0 ; i < i1 ; i++) locate( ll + i*NV, make_float3( pp[i*nv+0], pp[i*nv+1], pp[i*nv+2] ) );
+        });
+
+        std::vector<std::string> names ;
+        U::Split(NAMES, ',', names );
+        loc->set_names(names);
+        loc->set_meta<int>("num_thread", nt );
+        loc->set_meta<std::string>("creator", "CSGLocate::locate" );
+    }
+    delete p ;
+    return loc ;
+}
+
+std::string CSGLocate::desc() const
+{
+    std::stringstream ss ;
+    ss << "CSGLocate::desc"
+       << " num_item " << item_nidx.size()
+       << " stree " << ( st ? "YES" : "NO " )
+       << " num_lvid_mismatch " << num_lvid_mismatch
+       << " num_thread " << num_thread
+       ;
+    std::string str = ss.str();
+    return str ;
+}
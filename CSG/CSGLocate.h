@@ -0,0 +1,81 @@
+#pragma once
+/**
+CSGLocate : batched host point-in-volume location over all instances of a CSGFoundry
+=======================================================================================
+
+Classifies points into their containing volume without Geant4 navigation.
+Candidates are the (instance, prim) items of CSGRayQuery with world frame AABB
+containing the point, each is tested by evaluating the CSG signed distance with
+distance_prim in the instance frame, negative distance meaning inside.
+Of the containing prims the innermost is chosen, that is the one with the deepest
+stree node or when the stree is not available the one with the smallest AABB.
+
+The locate array is int32 with shape (N,8) and names::
+
+    nidx          stree node index, -1 when outside all volumes or stree not available
+    iindex        instance index
+    gprim         globalPrimIdx
+    boundary      boundary index of the prim
+    imat          material index within the volume, inner material of the boundary
+    sensor_id     sensor_identifier of the instance, 0 when not a sensor
+    sensor_index  sensor_index of the instance
+    lvid          meshIdx of the prim
+
+All values are -1 for points outside the world. Batches are split over
+CSGLocate__NUM_THREAD threads (default 0 for hardware_concurrency).
+
+Usage::
+
+    CSGFoundry* fd = CSGFoundry::Load();
+    CSGLocate lo(fd);
+    NP* loc = lo.locate(pos) ;    // pos (N,3|4) float or double
+
+**/
+
+#include <string>
+#include <vector>
+#include "plog/Severity.h"
+
+#include "scuda.h"
+
+struct NP ;
+struct CSGFoundry ;
+struct CSGRayQuery ;
+struct stree ;
+
+#include "CSG_API_EXPORT.hh"
+
+struct CSG_API CSGLocate
+{
+    static const plog::Severity LEVEL ;
+    static constexpr const char* CSGLocate__NUM_THREAD = "CSGLocate__NUM_THREAD" ;
+    static constexpr const int NV = 8 ;
+    static constexpr const char* NAMES = "nidx,iindex,gprim,boundary,imat,sensor_id,sensor_index,lvid" ;
+
+    enum { NIDX, IINDEX, GPRIM, BOUNDARY, IMAT, SENSOR_ID, SENSOR_INDEX, LVID } ;
+
+    const CSGFoundry*  fd ;
+    const CSGRayQuery* rq ;
+    bool               own_rq ;        // rq created here, deleted in dtor
+    const stree*       st ;
+    int                num_thread ;
+    int                num_lvid_mismatch ;   // items with stree node lvid differing from prim meshIdx
+
+    std::vector<int>   item_nidx ;     // stree node index of each CSGRayQuery item, -1 without stree
+    std::vector<int>   item_depth ;
+    std::vector<float> item_volume ;   // AABB volume used to order containing items when there is no stree
+
+    CSGLocate(const CSGFoundry* fd, const CSGRayQuery* rq=nullptr );
+    ~CSGLocate();
+
+    void init();
+    int  get_nidx(int inst, int primIdx) const ;
+    bool is_inner(int a, int b) const ;
+
+    float distance_item( int j, const float3& pos ) const ;
+    int  locate_item( const float3& pos, float* sd=nullptr ) const ;
+    void locate( int* loc, const float3& pos ) const ;
+    NP*  locate( const NP* pos ) const ;
+
+    std::string desc() const ;
+};
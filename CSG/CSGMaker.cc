@@ -467,6 +467,68 @@ CSGSolid* CSGMaker::makeClustered(const char* label,  int i0, int i1, int is, in
     return so ; 
 }
 
+/**
+CSGMaker::makeOverlapDemo
+---------------------------
+
+Creates a CSGSolid with 7 CSGPrim each with a single CSGNode, forming a
+volume tree with deliberate overlap problems for testing CSGOverlap.
+The meshIdx of each prim is its index within the solid and the index
+of the parent prim is collected into *parent* when provided::
+
+    0 world    box halfside 500
+    1 mother   box halfside 200, daughter of world
+    2 protrude sphere r 50 at x  180, daughter of mother, protrudes mother by 30
+    3 left     sphere r 50 at x -100, daughter of mother, overlaps right by 30
+    4 right    sphere r 50 at x  -30, daughter of mother
+    5 top0     box halfside 50 at z 150, top face coincident with mother
+    6 top1     box halfside 50 at x 100 z 150, faces coincident with mother and top0
+
+**/
+
+CSGSolid* CSGMaker::makeOverlapDemo(const char* label, std::vector<int>* parent )
+{
+    struct Vol { const char* name ; int parent ; CSGNode nd ; float x ; float z ; } ;
+    std::vector<Vol> vol = {
+        { "world",    -1, CSGNode::Box3(1000.f),    0.f,   0.f },
+        { "mother",    0, CSGNode::Box3(400.f),     0.f,   0.f },
+        { "protrude",  1, CSGNode::Sphere(50.f),  180.f,   0.f },
+        { "left",      1, CSGNode::Sphere(50.f), -100.f,   0.f },
+        { "right",     1, CSGNode::Sphere(50.f),  -30.f,   0.f },
+        { "top0",      1, CSGNode::Box3(100.f),     0.f, 150.f },
+        { "top1",      1, CSGNode::Box3(100.f),   100.f, 150.f }
+    };
+
+    unsigned numPrim = vol.size() ;
+    CSGSolid* so = fd->addSolid(numPrim, label);
+    AABB bb = {} ;
+
+    for(unsigned i=0 ; i < numPrim ; i++)
+    {
+        const Vol& v = vol[i] ;
+        CSGPrim* p = fd->addPrim(1, -1);  // numNode, nodeOffset
+        p->setMeshIdx(i);
+        CSGNode* n = fd->addNode(v.nd);
+
+        if( v.x != 0.f || v.z != 0.f )
+        {
+            const Tran<float>* translate = Tran<float>::make_translate( v.x, 0.f, v.z );
+            unsigned transform_idx = 1 + fd->addTran(translate);  // 1-based idx, 0 meaning None
+            delete translate ;
+            n->setTransform(transform_idx);
+            fd->getTran(transform_idx-1u)->transform_aabb_inplace( n->AABB() );
+        }
+
+        p->setAABB( n->AABB() );
+        bb.include_aabb( n->AABB() );
+        fd->addMeshName(v.name);
+        if(parent) parent->push_back(v.parent) ;
+    }
+
+    so->center_extent = bb.center_extent() ;
+    return so ;
+}
+
 /**
 CSGMaker::makeSolid11 makes 1-CSGPrim with 1-CSGNode
 ---------------------------------------------------------
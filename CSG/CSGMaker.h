@@ -56,6 +56,7 @@ struct CSG_API CSGMaker
     CSGSolid* makeBoxedSphere(const char* label); 
     CSGSolid* makeScaled(const char* label, const char* demo_node_type, float outer_scale, unsigned layers );
     CSGSolid* makeClustered(const char* name,  int i0, int i1, int is, int j0, int j1, int js, int k0, int k1, int ks, double unit, bool inbox ) ;
+    CSGSolid* makeOverlapDemo(const char* label="OverlapDemo", std::vector<int>* parent=nullptr );
 
     CSGSolid* makeSolid11(const char* label, CSGNode nd, const std::vector<float4>* pl=nullptr, int meshIdx=-1, const Tran<double>* tr=nullptr );
     CSGSolid* makeBooleanBoxSphere( const char* label, unsigned op, float radius, float fullside, int meshIdx = -1  ) ;
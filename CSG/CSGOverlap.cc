@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+#include "SLOG.hh"
+#include "ssys.h"
+#include "NP.hh"
+#include "stree.h"
+#include "sparallel.h"
+
+#include "CSGFoundry.h"
+#include "CSGRayQuery.h"
+#include "CSGLocate.h"
+#include "CSGOverlap.h"
+
+#include "csg_intersect_leaf.h"
+#include "csg_intersect_node.h"
+#include "csg_intersect_tree.h"
+
+
+const plog::Severity CSGOverlap::LEVEL = SLOG::EnvLevel("CSGOverlap", "DEBUG") ;
+
+const char* CSGOverlap::Kind(int kind) // static
+{
+    const char* s = nullptr ;
+    switch(kind)
+    {
+        case PARENT_PROTRUDE:    s = "PARENT_PROTRUDE"    ; break ;
+        case SIBLING_OVERLAP:    s = "SIBLING_OVERLAP"    ; break ;
+        case PARENT_COINCIDENT:  s = "PARENT_COINCIDENT"  ; break ;
+        case SIBLING_COINCIDENT: s = "SIBLING_COINCIDENT" ; break ;
+        default:                 s = "-"                  ; break ;
+    }
+    return s ;
+}
+
+CSGOverlap::CSGOverlap( const CSGFoundry* fd_, const CSGLocate* lo_ )
+    :
+    fd(fd_),
+    lo(lo_ ? lo_ : new CSGLocate(fd_)),
+    own_lo(lo_ == nullptr),
+    rq(lo->rq),
+    num_thread(ssys::getenvint(CSGOverlap__NUM_THREAD, 0)),
+    num_ray(ssys::getenvint(CSGOverlap__NUM_RAY, 500)),
+    max_hit(ssys::getenvint(CSGOverlap__MAX_HIT, 4)),
+    tol(ssys::getenvfloat(CSGOverlap__TOL, 0.01f)),
+    lvid(ssys::getenvintvec(CSGOverlap__LVID, ','))
+{
+    init();
+}
+
+CSGOverlap::~CSGOverlap()
+{
+    delete lvid ;
+    if(own_lo) delete lo ;
+}
+
+void CSGOverlap::init()
+{
+    LOG_IF(error, lo->st == nullptr) << " stree not available, parent and sibling relations unknown, nothing to scan " ;
+    init_dirs();
+    init_items();
+    LOG(LEVEL) << desc() ;
+}
+
+/**
+CSGOverlap::init_dirs
+-----------------------
+
+Fibonacci sphere directions giving near uniform deterministic coverage.
+
+**/
+
+void CSGOverlap::init_dirs()
+{
+    const float golden = M_PI*(3.f - sqrtf(5.f)) ;
+    dirs.resize(num_ray);
+    for(int i=0 ; i < num_ray ; i++)
+    {
+        float z = 1.f - 2.f*(float(i) + 0.5f)/float(num_ray) ;
+        float r = sqrtf( std::max( 0.f, 1.f - z*z ) ) ;
+        float phi = golden*float(i) ;
+        dirs[i] = make_float3( r*cosf(phi), r*sinf(phi), z );
+    }
+}
+
+/**
+CSGOverlap::init_items
+------------------------
+
+Maps each item to the item of its stree parent node and decides
+which items to scan, see header for the first instance restriction.
+
+**/
+
+void CSGOverlap::init_items()
+{
+    int num_item = rq->item.size() ;
+    item_parent.assign(num_item, -1);
+    item_scan.assign(num_item, 0);
+    if( lo->st == nullptr ) return ;
+
+    for(int i=0 ; i < num_item ; i++) if( lo->item_nidx[i] > -1 ) nidx_item[lo->item_nidx[i]] = i ;
+
+    std::vector<int> first_inst(fd->getNumSolid(), -1) ;
+    for(int i=0 ; i < int(fd->inst.size()) ; i++)
+    {
+        int ins_idx, gas_idx, sensor_identifier, sensor_index ;
+        fd->inst[i].getIdentity(ins_idx, gas_idx, sensor_identifier, sensor_index );
+        if( gas_idx > -1 && gas_idx < int(first_inst.size()) && first_inst[gas_idx] == -1 ) first_inst[gas_idx] = i ;
+    }
+
+    for(int i=0 ; i < num_item ; i++)
+    {
+        int nidx = lo->item_nidx[i] ;
+        if( nidx == -1 ) continue ;
+
+        int parent = lo->st->nds[nidx].parent ;
+        auto it = nidx_item.find(parent) ;
+        item_parent[i] = it == nidx_item.end() ? -1 : it->second ;
+
+        const CSGRayQuery::Item& item = rq->item[i] ;
+        const CSGPrim* pr = rq->prim0 + item.prim ;
+        int ins_idx, gas_idx, sensor_identifier, sensor_index ;
+        fd->inst[item.inst].getIdentity(ins_idx, gas_idx, sensor_identifier, sensor_index );
+        int primRel = item.prim - fd->getSolid(gas_idx)->primOffset ;
+
+        bool inner_repeat = primRel > 0 && item.inst != first_inst[gas_idx] ;
+        bool lvid_select = lvid == nullptr || std::find( lvid->begin(), lvid->end(), pr->meshIdx() ) != lvid->end() ;
+        item_scan[i] = !inner_repeat && lvid_select ;
+    }
+}
+
+/**
+CSGOverlap::sample
+--------------------
+
+Collects world frame surface points of item i from rays starting at the
+center of the prim AABB in the instance frame. Successive intersects along
+each ray start a little beyond the previous one.
+
+**/
+
+int CSGOverlap::sample( std::vector<float3>& wpos, int i ) const
+{
+    const CSGRayQuery::Item& it = rq->item[i] ;
+    const CSGPrim* pr = rq->prim0 + it.prim ;
+    const CSGNode* nd = rq->node0 + pr->nodeOffset() ;
+    const float* bb = pr->AABB() ;
+
+    qat4 t(fd->inst[it.inst].cdata()) ;
+    t.clearIdentity();
+
+    float3 ori = make_float3( 0.5f*(bb[0]+bb[3]), 0.5f*(bb[1]+bb[4]), 0.5f*(bb[2]+bb[5]) );
+    float extent = std::max( bb[3]-bb[0], std::max( bb[4]-bb[1], bb[5]-bb[2] )) ;
+    float step = std::max( tol, 1e-5f*extent ) ;
+
+    for(int r=0 ; r < num_ray ; r++)
+    {
+        const float3& dir = dirs[r] ;
+        float tmin = 0.f ;
+        for(int h=0 ; h < max_hit ; h++)
+        {
+            float4 isect ;
+            if(!intersect_prim( isect, nd, rq->plan0, rq->itra0, tmin, ori, dir, false )) break ;
+            wpos.push_back( t.right_multiply( ori + isect.w*dir, 1.f ) );
+            tmin = isect.w + step ;
+        }
+    }
+    return wpos.size() ;
+}
+
+/**
+CSGOverlap::check
+-------------------
+
+Checks surface point wpos of item i against its parent and siblings,
+signed distances are evaluated in the frame of the other item.
+
+**/
+
+void CSGOverlap::check( std::vector<quad4>& rec, int i, const float3& wpos ) const
+{
+    int p = item_parent[i] ;
+    int parent_nidx = lo->st->nds[lo->item_nidx[i]].parent ;
+
+    auto distance = [this, &wpos](int j)
+    {
+        const CSGRayQuery::Item& it = rq->item[j] ;
+        const CSGPrim* pr = rq->prim0 + it.prim ;
+        float3 lpos = rq->w2m[it.inst].right_multiply( wpos, 1.f );
+        return distance_prim( lpos, rq->node0 + pr->nodeOffset(), rq->plan0, rq->itra0 );
+    };
+
+    if( p > -1 )
+    {
+        float sd = distance(p) ;
+        if(      sd >  tol ) add( rec, i, p, PARENT_PROTRUDE,   sd, wpos );
+        else if( sd > -tol ) add( rec, i, p, PARENT_COINCIDENT, sd, wpos );
+    }
+
+    if( parent_nidx == -1 ) return ;
+
+    std::vector<int> cands ;
+    rq->collect( cands, wpos );
+    for(unsigned c=0 ; c < cands.size() ; c++)
+    {
+        int j = cands[c] ;
+        int nidx = lo->item_nidx[j] ;
+        if( j == i || j == p || nidx == -1 || lo->st->nds[nidx].parent != parent_nidx ) continue ;
+
+        float sd = distance(j) ;
+        if(      sd < -tol ) add( rec, i, j, SIBLING_OVERLAP,    sd, wpos );
+        else if( sd <  tol ) add( rec, i, j, SIBLING_COINCIDENT, sd, wpos );
+    }
+}
+
+/**
+CSGOverlap::add
+-----------------
+
+Accumulates into the record for (i, j, kind), keeping the sample
+with largest absolute signed distance. There are few records per item
+so a linear search is used.
+
+**/
+
+void CSGOverlap::add( std::vector<quad4>& rec, int i, int j, int kind, float sd, const float3& wpos ) const
+{
+    const CSGRayQuery::Item& a = rq->item[i] ;
+    const CSGRayQuery::Item& b = rq->item[j] ;
+    const CSGPrim* pa = rq->prim0 + a.prim ;
+    const CSGPrim* pb = rq->prim0 + b.prim ;
+
+    quad4* r = nullptr ;
+    for(unsigned k=0 ; k < rec.size() ; k++)
+    {
+        if( rec[k].q1.i.z == kind && rec[k].q2.i.z == b.inst && rec[k].q2.i.w == int(pb->globalPrimIdx()) )
+        {
+            r = &rec[k] ;
+            break ;
+        }
+    }
+
+    if( r == nullptr )
+    {
+        rec.push_back( {} );
+        r = &rec.back() ;
+        r->zero();
+        r->q1.i.x = lo->item_nidx[i] ;
+        r->q1.i.y = lo->item_nidx[j] ;
+        r->q1.i.z = kind ;
+        r->q2.i.x = a.inst ;
+        r->q2.i.y = pa->globalPrimIdx() ;
+        r->q2.i.z = b.inst ;
+        r->q2.i.w = pb->globalPrimIdx() ;
+        r->q3.i.x = pa->meshIdx() ;
+        r->q3.i.y = pb->meshIdx() ;
+    }
+
+    r->q1.i.w += 1 ;
+    if( r->q1.i.w == 1 || std::abs(sd) > std::abs(r->q0.f.w) )
+    {
+        r->q0.f.x = wpos.x ;
+        r->q0.f.y = wpos.y ;
+        r->q0.f.z = wpos.z ;
+        r->q0.f.w = sd ;
+    }
+}
+
+void CSGOverlap::scan_item( std::vector<quad4>& rec, int i ) const
+{
+    if( item_scan[i] == 0 ) return ;
+
+    std::vector<float3> wpos ;
+    int num_sample = sample( wpos, i );
+
+    std::vector<quad4> irec ;
+    for(int s=0 ; s < num_sample ; s++) check( irec, i, wpos[s] );
+    for(unsigned k=0 ; k < irec.size() ; k++) irec[k].q3.i.z = num_sample ;
+
+    rec.insert( rec.end(), irec.begin(), irec.end() );
+}
+
+/**
+CSGOverlap::scan
+------------------
+
+Scans all selected items, the per-thread records are concatenated
+in thread order so the result does not depend on the number of threads.
+Returns (M,4,4) float array with the layout described in the header.
+
+**/
+
+NP* CSGOverlap::scan() const
+{
+    int num_item = rq->item.size() ;
+    int nt = sparallel::NumThread(num_item, num_thread, 16) ;
+
+    std::vector<std::vector<quad4>> trec(nt) ;
+    sparallel::For(num_item, nt, [&](int t, int i0, int i1)
+    {
+        for(int i=i0 ; i < i1 ; i++) scan_item( trec[t], i );
+    });
+
+    std::vector<quad4> rec ;
+    for(int t=0 ; t < nt ; t++) rec.insert( rec.end(), trec[t].begin(), trec[t].end() );
+
+    NP* a = NP::Make<float>( rec.size(), 4, 4 );
+    if(rec.size() > 0) memcpy( a->bytes(), rec.data(), a->arr_bytes() );
+
+    a->set_meta<int>("num_thread", nt );
+    a->set_meta<int>("num_ray", num_ray );
+    a->set_meta<int>("max_hit", max_hit );
+    a->set_meta<float>("tol", tol );
+    a->set_meta<std::string>("creator", "CSGOverlap::scan" );
+    return a ;
+}
+
+std::string CSGOverlap::desc() const
+{
+    int num_scan = std::count( item_scan.begin(), item_scan.end(), 1 ) ;
+    std::stringstream ss ;
+    ss << "CSGOverlap::desc"
+       << " num_item " << item_scan.size()
+       << " num_scan " << num_scan
+       << " num_ray " << num_ray
+       << " max_hit " << max_hit
+       << " tol " << tol
+       << " lvid " << ( lvid ? lvid->size() : 0 )
+       << " num_thread " << num_thread
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+/**
+CSGOverlap::desc
+------------------
+
+Counts of each kind followed by the worst num_worst records, overlaps
+before coincidences and larger absolute distances first.
+
+**/
+
+std::string CSGOverlap::desc( const NP* a, int num_worst ) const
+{
+    const quad4* rec = a ? (const quad4*)a->cvalues<float>() : nullptr ;
+    int num = a ? a->shape[0] : 0 ;
+
+    int count[5] = {0,0,0,0,0} ;
+    std::vector<int> idx(num) ;
+    for(int i=0 ; i < num ; i++)
+    {
+        idx[i] = i ;
+        int kind = rec[i].q1.i.z ;
+        if( kind > 0 && kind < 5 ) count[kind] += 1 ;
+    }
+
+    std::sort( idx.begin(), idx.end(), [rec](int i, int j)
+    {
+        bool ci = rec[i].q1.i.z > SIBLING_OVERLAP ;
+        bool cj = rec[j].q1.i.z > SIBLING_OVERLAP ;
+        return ci == cj ? std::abs(rec[i].q0.f.w) > std::abs(rec[j].q0.f.w) : cj ;
+    });
+
+    std::stringstream ss ;
+    ss << desc() << "\n" ;
+    for(int k=1 ; k < 5 ; k++) ss << std::setw(20) << Kind(k) << " : " << count[k] << "\n" ;
+
+    for(int n=0 ; n < std::min(num, num_worst) ; n++)
+    {
+        const quad4& r = rec[idx[n]] ;
+        const char* mn_a = fd->getMeshName(r.q3.i.x) ;
+        const char* mn_b = fd->getMeshName(r.q3.i.y) ;
+        ss << std::setw(20) << Kind(r.q1.i.z)
+           << " sd " << std::setw(10) << std::fixed << std::setprecision(4) << r.q0.f.w
+           << " count " << std::setw(6) << r.q1.i.w << "/" << std::setw(6) << r.q3.i.z
+           << " nidx " << std::setw(7) << r.q1.i.x << ":" << std::setw(7) << r.q1.i.y
+           << " ii " << std::setw(6) << r.q2.i.x << ":" << std::setw(6) << r.q2.i.z
+           << " " << ( mn_a ? mn_a : "-" ) << " : " << ( mn_b ? mn_b : "-" )
+           << "\n"
+           ;
+    }
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,115 @@
+#pragma once
+/**
+CSGOverlap : host scan for overlaps and coincident surfaces between CSGPrim
+==============================================================================
+
+CSGQuery::IsSpurious and CSGSimtraceSample look at single intersects,
+CSGOverlap systematically scans the full geometry. Surface points of every
+(instance, prim) item of CSGRayQuery are sampled by intersecting NUM_RAY rays
+from the center of the prim AABB (up to MAX_HIT intersects along each ray,
+so inner surfaces of shells are also sampled). Each surface point is then
+checked against the related prims using distance_prim in their instance frames:
+
+parent
+    the stree parent volume of the prim, found directly via its node index,
+    the surface point of a daughter must be inside its mother : sd <= 0
+siblings
+    prims of the items with AABB containing the point that share the stree parent,
+    the surface point must be outside its siblings : sd >= 0
+
+Points within TOL of the other surface are coincident, points beyond
+TOL on the wrong side are overlaps. Coincident surfaces are what cause
+float precision intersect problems on GPU, so they are reported too.
+
+All instances of a factor solid share the same inner structure, so the
+inner prims are only scanned for the first instance of each solid, the
+outer prim of every instance is scanned against its parent and siblings
+in the remainder. The stree is required for the parent/sibling relations,
+it is used only when it corresponds to the CSGFoundry (see CSGLocate::init).
+
+The overlap array is float with shape (M,4,4), one quad4 for every
+(item, other item, kind) with at least one sample::
+
+    q0.f.xyz : world frame position of the worst sample, max |sd|
+    q0.f.w   : signed distance of the worst sample to the other prim
+    q1.i     : nidx, other_nidx, kind, count of samples
+    q2.i     : iindex, gprim, other_iindex, other_gprim
+    q3.i     : lvid, other_lvid, number of surface samples of the prim, 0
+
+With kind PARENT_PROTRUDE, SIBLING_OVERLAP, PARENT_COINCIDENT, SIBLING_COINCIDENT.
+Items are split over CSGOverlap__NUM_THREAD threads (default 0 for hardware_concurrency).
+Config envvars::
+
+    CSGOverlap__NUM_RAY  : rays per prim, default 500
+    CSGOverlap__MAX_HIT  : intersects per ray, default 4
+    CSGOverlap__TOL      : coincidence tolerance in mm, default 0.01
+    CSGOverlap__LVID     : comma delimited lvid selection, default all
+
+Usage::
+
+    CSGFoundry* fd = CSGFoundry::Load();
+    CSGOverlap ov(fd);
+    NP* a = ov.scan() ;
+    LOG(info) << ov.desc(a) ;
+
+**/
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "plog/Severity.h"
+
+#include "scuda.h"
+#include "squad.h"
+
+struct NP ;
+struct CSGFoundry ;
+struct CSGRayQuery ;
+struct CSGLocate ;
+
+#include "CSG_API_EXPORT.hh"
+
+struct CSG_API CSGOverlap
+{
+    static const plog::Severity LEVEL ;
+    static constexpr const char* CSGOverlap__NUM_THREAD = "CSGOverlap__NUM_THREAD" ;
+    static constexpr const char* CSGOverlap__NUM_RAY = "CSGOverlap__NUM_RAY" ;
+    static constexpr const char* CSGOverlap__MAX_HIT = "CSGOverlap__MAX_HIT" ;
+    static constexpr const char* CSGOverlap__TOL = "CSGOverlap__TOL" ;
+    static constexpr const char* CSGOverlap__LVID = "CSGOverlap__LVID" ;
+
+    enum { PARENT_PROTRUDE=1, SIBLING_OVERLAP=2, PARENT_COINCIDENT=3, SIBLING_COINCIDENT=4 } ;
+    static const char* Kind(int kind);
+
+    const CSGFoundry*  fd ;
+    const CSGLocate*   lo ;
+    bool               own_lo ;        // lo created here, deleted in dtor
+    const CSGRayQuery* rq ;
+    int                num_thread ;
+    int                num_ray ;
+    int                max_hit ;
+    float              tol ;
+    std::vector<int>*  lvid ;
+
+    std::vector<float3>          dirs ;          // Fibonacci sphere ray directions
+    std::unordered_map<int,int>  nidx_item ;     // stree node index to CSGRayQuery item index
+    std::vector<int>             item_parent ;   // item index of the stree parent, -1 when none
+    std::vector<char>            item_scan ;
+
+    CSGOverlap(const CSGFoundry* fd, const CSGLocate* lo=nullptr );
+    ~CSGOverlap();
+
+    void init();
+    void init_dirs();
+    void init_items();
+
+    int  sample( std::vector<float3>& wpos, int i ) const ;
+    void check( std::vector<quad4>& rec, int i, const float3& wpos ) const ;
+    void add( std::vector<quad4>& rec, int i, int j, int kind, float sd, const float3& wpos ) const ;
+    void scan_item( std::vector<quad4>& rec, int i ) const ;
+
+    NP* scan() const ;
+
+    std::string desc() const ;
+    std::string desc( const NP* a, int num_worst=20 ) const ;
+};
@@ -0,0 +1,437 @@
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+
+#include "SLOG.hh"
+#include "ssys.h"
+#include "NP.hh"
+#include "stran.h"
+#include "sparallel.h"
+
+#include "CSGFoundry.h"
+#include "CSGRayQuery.h"
+
+#include "csg_intersect_leaf.h"
+#include "csg_intersect_node.h"
+#include "csg_intersect_tree.h"
+
+
+const plog::Severity CSGRayQuery::LEVEL = SLOG::EnvLevel("CSGRayQuery", "DEBUG") ;
+
+CSGRayQuery::CSGRayQuery( const CSGFoundry* fd_ )
+    :
+    fd(fd_),
+    prim0(fd->getPrim(0)),
+    node0(fd->getNode(0)),
+    plan0(fd->getPlan(0)),
+    itra0(fd->getItra(0)),
+    num_thread(ssys::getenvint(CSGRayQuery__NUM_THREAD, 0))
+{
+    init();
+}
+
+void CSGRayQuery::init()
+{
+    init_inverse();
+    init_items();
+    init_bvh();
+    LOG(LEVEL) << desc() ;
+}
+
+/**
+CSGRayQuery::init_inverse
+----------------------------
+
+The instance transforms carry identity info in their 4th column
+which is cleared before inverting, as done by CSGTarget::getInstanceTransform.
+
+**/
+
+void CSGRayQuery::init_inverse()
+{
+    int num_inst = fd->inst.size() ;
+    w2m.resize(num_inst);
+    for(int i=0 ; i < num_inst ; i++)
+    {
+        qat4 t(fd->inst[i].cdata()) ;
+        t.clearIdentity();
+        const qat4* v = Tran<double>::Invert(&t) ;
+        assert(v);
+        qat4::copy(w2m[i], *v);
+        w2m[i].clearIdentity();
+        delete v ;
+    }
+
+    int num_prim = fd->getNumPrim() ;
+    prim_boundary.resize(num_prim);
+    for(int i=0 ; i < num_prim ; i++) prim_boundary[i] = fd->getPrimBoundary_( prim0 + i ) ;
+}
+
+/**
+CSGRayQuery::init_items
+-------------------------
+
+One item for every prim of every instance with the prim AABB transformed
+into the world frame. The AABB are padded slightly so that intersects
+onto faces of tight bounding boxes are not missed by the slab test.
+
+**/
+
+void CSGRayQuery::init_items()
+{
+    int num_inst = fd->inst.size() ;
+    for(int i=0 ; i < num_inst ; i++)
+    {
+        qat4 t(fd->inst[i].cdata()) ;
+        int ins_idx, gas_idx, sensor_identifier, sensor_index ;
+        t.getIdentity(ins_idx, gas_idx, sensor_identifier, sensor_index );
+        t.clearIdentity();
+
+        const CSGSolid* so = fd->getSolid(gas_idx) ;
+        assert(so);
+        for(int p=0 ; p < so->numPrim ; p++)
+        {
+            int primIdx = so->primOffset + p ;
+            const CSGPrim* pr = prim0 + primIdx ;
+
+            Item it ;
+            memcpy( it.bb, pr->AABB(), 6*sizeof(float) );
+            t.transform_aabb_inplace( it.bb );
+
+            float pad = 1e-4f*std::max( it.bb[3] - it.bb[0], std::max( it.bb[4] - it.bb[1], it.bb[5] - it.bb[2] )) + 1e-3f ;
+            for(int k=0 ; k < 3 ; k++)
+            {
+                it.bb[k]   -= pad ;
+                it.bb[k+3] += pad ;
+            }
+            it.inst = i ;
+            it.prim = primIdx ;
+            item.push_back(it);
+        }
+    }
+}
+
+void CSGRayQuery::init_bvh()
+{
+    bvh.clear();
+    bvh.reserve( 2*item.size()/LEAF_SIZE + 2 );
+    bvh.push_back( {} );
+    if(item.size() > 0) build(0, 0, item.size() );
+}
+
+/**
+CSGRayQuery::build
+--------------------
+
+Sets the bounds of node n and either makes it a leaf or splits its
+items at the median of their centers along the longest axis of the
+bounds of the centers, appending the two children at consecutive indices.
+
+**/
+
+void CSGRayQuery::build(int n, int i0, int i1)
+{
+    float bb[6] = {  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),
+                    -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() } ;
+    float cb[6] = { bb[0], bb[1], bb[2], bb[3], bb[4], bb[5] } ;
+
+    for(int i=i0 ; i < i1 ; i++)
+    {
+        const float* ib = item[i].bb ;
+        for(int k=0 ; k < 3 ; k++)
+        {
+            float c = 0.5f*( ib[k] + ib[k+3] ) ;
+            bb[k]   = std::min( bb[k],   ib[k] );
+            bb[k+3] = std::max( bb[k+3], ib[k+3] );
+            cb[k]   = std::min( cb[k],   c );
+            cb[k+3] = std::max( cb[k+3], c );
+        }
+    }
+    memcpy( bvh[n].bb, bb, 6*sizeof(float) );
+
+    if( i1 - i0 <= LEAF_SIZE )
+    {
+        bvh[n].first = i0 ;
+        bvh[n].count = i1 - i0 ;
+        return ;
+    }
+
+    int axis = 0 ;
+    if( cb[4] - cb[1] > cb[3+axis] - cb[axis] ) axis = 1 ;
+    if( cb[5] - cb[2] > cb[3+axis] - cb[axis] ) axis = 2 ;
+
+    int mid = (i0 + i1)/2 ;
+    std::nth_element( item.begin() + i0, item.begin() + mid, item.begin() + i1,
+         [axis](const Item& a, const Item& b){ return a.bb[axis] + a.bb[axis+3] < b.bb[axis] + b.bb[axis+3] ; } );
+
+    int c = bvh.size() ;
+    bvh.push_back( {} );
+    bvh.push_back( {} );
+    bvh[n].first = c ;
+    bvh[n].count = 0 ;
+
+    build(c,   i0, mid );
+    build(c+1, mid, i1 );
+}
+
+/**
+CSGRayQuery::SlabTest
+-----------------------
+
+Ray AABB overlap within [tmin,tmax] using the inverse direction,
+fminf/fmaxf are used as they ignore the NaN from 0*inf for rays
+within a slab plane.
+
+**/
+
+bool CSGRayQuery::SlabTest(float& t0, const float* bb, const float3& ori, const float3& inv, float tmin, float tmax ) // static
+{
+    float tx0 = ( bb[0] - ori.x )*inv.x ;
+    float tx1 = ( bb[3] - ori.x )*inv.x ;
+    float ty0 = ( bb[1] - ori.y )*inv.y ;
+    float ty1 = ( bb[4] - ori.y )*inv.y ;
+    float tz0 = ( bb[2] - ori.z )*inv.z ;
+    float tz1 = ( bb[5] - ori.z )*inv.z ;
+
+    float tlo = fmaxf( fmaxf( fminf(tx0, tx1), fminf(ty0, ty1) ), fmaxf( fminf(tz0, tz1), tmin ) );
+    float thi = fminf( fminf( fmaxf(tx0, tx1), fmaxf(ty0, ty1) ), fminf( fmaxf(tz0, tz1), tmax ) );
+    t0 = tlo ;
+    return tlo <= thi ;
+}
+
+bool CSGRayQuery::Contains(const float* bb, const float3& pos ) // static
+{
+    return pos.x >= bb[0] && pos.x <= bb[3] && pos.y >= bb[1] && pos.y <= bb[4] && pos.z >= bb[2] && pos.z <= bb[5] ;
+}
+
+/**
+CSGRayQuery::intersect_item
+-----------------------------
+
+The affine instance transform leaves the ray parameter t unchanged,
+so the instance frame t_min and distance are the world frame ones.
+Normals transform with the inverse-transform-transposed, hence the
+left_multiply by w2m as done for CSGNode transforms in intersect_leaf.
+
+**/
+
+bool CSGRayQuery::intersect_item( float4& isect, float& lposcost, const Item& it, const float3& ori, const float3& dir, float tmin ) const
+{
+    const qat4& v = w2m[it.inst] ;
+    float3 lori = v.right_multiply( ori, 1.f );
+    float3 ldir = v.right_multiply( dir, 0.f );
+
+    const CSGPrim* pr = prim0 + it.prim ;
+    bool valid_intersect = intersect_prim( isect, node0 + pr->nodeOffset(), plan0, itra0, tmin, lori, ldir, false );
+    if(!valid_intersect) return false ;
+
+    float3 lpos = lori + isect.w*ldir ;
+    lposcost = normalize_z(lpos) ;
+
+    float3 nrm = normalize( v.left_multiply( make_float3( isect.x, isect.y, isect.z ), 0.f ) );
+    isect.x = nrm.x ;
+    isect.y = nrm.y ;
+    isect.z = nrm.z ;
+    return true ;
+}
+
+/**
+CSGRayQuery::intersect
+------------------------
+
+Closest intersect of a single world frame ray, traversing the BVH
+nearest child first and skipping nodes beyond the closest intersect so far.
+The direction is expected to be normalized, as with propagate, so that
+tmin and the intersect t are distances.
+
+**/
+
+bool CSGRayQuery::intersect( quad2& prd, const float3& ori, const float3& dir, float tmin ) const
+{
+    float3 inv = make_float3( 1.f/dir.x, 1.f/dir.y, 1.f/dir.z );
+    float t_best = std::numeric_limits<float>::max() ;
+    float4 best = make_float4( 0.f, 0.f, 0.f, 0.f );
+    float best_lposcost = 0.f ;
+    int best_item = -1 ;
+
+    int stack[STACK_SIZE] ;
+    int sp = 0 ;
+    if(!item.empty()) stack[sp++] = 0 ;
+
+    while( sp > 0 )
+    {
+        const Node& nd = bvh[stack[--sp]] ;
+        float t0 ;
+        if(!SlabTest(t0, nd.bb, ori, inv, tmin, t_best)) continue ;
+
+        if( nd.count > 0 )
+        {
+            for(int i=nd.first ; i < nd.first + nd.count ; i++)
+            {
+                float4 isect ;
+                float lposcost ;
+                if(intersect_item( isect, lposcost, item[i], ori, dir, tmin ) && isect.w < t_best )
+                {
+                    t_best = isect.w ;
+                    best = isect ;
+                    best_lposcost = lposcost ;
+                    best_item = i ;
+                }
+            }
+        }
+        else
+        {
+            int a = nd.first ;
+            int b = nd.first + 1 ;
+            float ta, tb ;
+            bool ha = SlabTest(ta, bvh[a].bb, ori, inv, tmin, t_best) ;
+            bool hb = SlabTest(tb, bvh[b].bb, ori, inv, tmin, t_best) ;
+            assert( sp + 2 <= STACK_SIZE );
+            if( ha && hb )
+            {
+                if( tb < ta ) std::swap(a, b) ;   // push far then near, so near is popped first
+                stack[sp++] = b ;
+                stack[sp++] = a ;
+            }
+            else if( ha ) stack[sp++] = a ;
+            else if( hb ) stack[sp++] = b ;
+        }
+    }
+
+    prd.q0.f = best ;
+    prd.q1.f.x = best_lposcost ;
+    if( best_item > -1 )
+    {
+        const Item& it = item[best_item] ;
+        const CSGPrim* pr = prim0 + it.prim ;
+        int ins_idx, gas_idx, sensor_identifier, sensor_index ;
+        fd->inst[it.inst].getIdentity(ins_idx, gas_idx, sensor_identifier, sensor_index );
+        prd.set_iindex( it.inst );
+        prd.set_identity( sensor_identifier );
+        prd.set_globalPrimIdx_boundary( pr->globalPrimIdx(), prim_boundary[it.prim] );
+    }
+    else
+    {
+        prd.set_iindex( 0u );
+        prd.set_identity( MISS_IDENTITY );
+        prd.set_globalPrimIdx_boundary_( MISS_BOUNDARY );   // as __miss__ms
+    }
+    return best_item > -1 ;
+}
+
+/**
+CSGRayQuery::collect
+----------------------
+
+Collects indices of the items with world frame AABB containing the position.
+
+**/
+
+void CSGRayQuery::collect( std::vector<int>& items, const float3& pos ) const
+{
+    int stack[STACK_SIZE] ;
+    int sp = 0 ;
+    if(!item.empty()) stack[sp++] = 0 ;
+
+    while( sp > 0 )
+    {
+        const Node& nd = bvh[stack[--sp]] ;
+        if(!Contains(nd.bb, pos)) continue ;
+
+        if( nd.count > 0 )
+        {
+            for(int i=nd.first ; i < nd.first + nd.count ; i++) if(Contains(item[i].bb, pos)) items.push_back(i) ;
+        }
+        else
+        {
+            assert( sp + 2 <= STACK_SIZE );
+            stack[sp++] = nd.first + 1 ;
+            stack[sp++] = nd.first ;
+        }
+    }
+}
+
+/**
+CSGRayQuery::intersect
+------------------------
+
+origin, direction
+    shape (N,3) or (N,4) float or double, only xyz used, direction is normalized
+    before intersecting so that tmin and q0.w are distances, as with propagate_epsilon
+tmin
+    shape (N,) float or double, when nullptr tmin_default is used for all rays
+
+Returns (N,2,4) float array with the quad2 layout described in the header.
+
+**/
+
+NP* CSGRayQuery::intersect( const NP* origin, const NP* direction, const NP* tmin, float tmin_default ) const
+{
+    NP* ori = NP::MakeNarrowIfWide(origin) ;
+    NP* dir = NP::MakeNarrowIfWide(direction) ;
+    NP* tmn = tmin ? NP::MakeNarrowIfWide(tmin) : nullptr ;
+
+    int num = ori ? ori->shape[0] : 0 ;
+    int ori_nv = ori ? ori->num_itemvalues() : 0 ;
+    int dir_nv = dir ? dir->num_itemvalues() : 0 ;
+
+    bool expected =
+           ori && dir
+        && ori->uifc == 'f' && dir->uifc == 'f'
+        && ( ori_nv == 3 || ori_nv == 4 )
+        && ( dir_nv == 3 || dir_nv == 4 )
+        && dir->shape[0] == num
+        && ( tmn == nullptr || ( tmn->uifc == 'f' && tmn->num_values() == num ))
+        ;
+
+    LOG_IF(error, !expected)
+        << " unexpected inputs "
+        << " origin " << ( origin ? origin->sstr() : "-" )
+        << " direction " << ( direction ? direction->sstr() : "-" )
+        << " tmin " << ( tmin ? tmin->sstr() : "-" )
+        ;
+
+    NP* isect = expected ? NP::Make<float>(num, 2, 4) : nullptr ;
+    if( isect )
+    {
+        const float* oo = ori->cvalues<float>() ;
+        const float* dd = dir->cvalues<float>() ;
+        const float* tt = tmn ? tmn->cvalues<float>() : nullptr ;
+        quad2* prd = (quad2*)isect->values<float>() ;
+
+        int nt = sparallel::NumThread(num, num_thread, 256) ;
+        sparallel::For(num, nt, [&](int, int i0, int i1)
+        {
+            for(int i=i0 ; i < i1 ; i++)
+            {
+                float3 o = make_float3( oo[i*ori_nv+0], oo[i*ori_nv+1], oo[i*ori_nv+2] );
+                float3 d = normalize(make_float3( dd[i*dir_nv+0], dd[i*dir_nv+1], dd[i*dir_nv+2] ));
+                intersect( prd[i], o, d, tt ? tt[i] : tmin_default );
+            }
+        });
+
+        isect->set_meta<int>("num_thread", nt );
+        isect->set_meta<std::string>("creator", "CSGRayQuery::intersect" );
+    }
+
+    delete ori ;
+    delete dir ;
+    delete tmn ;
+    return isect ;
+}
+
+std::string CSGRayQuery::desc() const
+{
+    std::stringstream ss ;
+    ss << "CSGRayQuery::desc"
+       << " num_inst " << w2m.size()
+       << " num_prim " << prim_boundary.size()
+       << " num_item " << item.size()
+       << " num_bvh_node " << bvh.size()
+       << " num_thread " << num_thread
+       ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,117 @@
+#pragma once
+/**
+CSGRayQuery : batched host ray intersection against all instances of a CSGFoundry
+=====================================================================================
+
+CSGQuery intersects one ray with one selected CSGPrim, CSGRayQuery
+intersects batches of rays with the full geometry : every CSGPrim
+of every instance, including the global remainder instance 0.
+
+Acceleration is with a host BVH over the world frame AABB of every
+(instance, prim) pair. The per-prim AABB of CSGPrim are in the frame
+of the CSGSolid so the instance transform is applied to them. Rays that
+reach a leaf are transformed into the instance frame with the inverted
+instance transform and intersected with intersect_prim, the same code
+that runs on GPU within __intersection__is.
+
+The intersect array has the quad2 layout of the GPU PRD populated by
+__closesthit__ch so the results can be compared directly with
+simtrace/propagate intersects::
+
+    q0.f.xyz : world frame surface normal at intersect, normalized
+    q0.f.w   : distance t along the ray direction
+    q1.f.x   : lposcost, cosTheta of instance frame intersect position
+    q1.u.y   : iindex, instance index
+    q1.u.z   : identity, sensor_identifier of the instance (0 when not a sensor, 0xffffffff for misses)
+    q1.u.w   : globalPrimIdx << 16 | boundary, with boundary 0xffff for misses
+
+The same BVH provides the items with AABB containing a point
+for point location by CSGLocate.
+
+Batches are split over CSGRayQuery__NUM_THREAD threads (default 0 for
+hardware_concurrency) using sparallel.h, each ray is independent so
+results do not depend on the number of threads.
+
+Usage::
+
+    CSGFoundry* fd = CSGFoundry::Load();
+    CSGRayQuery rq(fd);
+    NP* isect = rq.intersect(origin, direction, tmin) ;   // (N,3|4) (N,3|4) (N,) or nullptr
+
+From python via the opticks_CSG nanobind module::
+
+    import opticks_CSG as csg
+    rq = csg._CSGRayQuery()
+    isect = rq.intersect(origin, direction, tmin)
+
+**/
+
+#include <string>
+#include <vector>
+#include "plog/Severity.h"
+
+#include "scuda.h"
+#include "squad.h"
+#include "sqat4.h"
+
+struct NP ;
+struct CSGFoundry ;
+struct CSGPrim ;
+struct CSGNode ;
+
+#include "CSG_API_EXPORT.hh"
+
+struct CSG_API CSGRayQuery
+{
+    static const plog::Severity LEVEL ;
+    static constexpr const char* CSGRayQuery__NUM_THREAD = "CSGRayQuery__NUM_THREAD" ;
+    static constexpr const int LEAF_SIZE = 4 ;
+    static constexpr const int STACK_SIZE = 64 ;
+    static constexpr const unsigned MISS_BOUNDARY = 0xffffu ;
+    static constexpr const unsigned MISS_IDENTITY = 0xffffffffu ;
+
+    struct Item    // world frame AABB of one prim of one instance
+    {
+        float bb[6] ;
+        int   inst ;
+        int   prim ;
+    };
+
+    struct Node    // BVH node, leaf when count > 0 with items [first, first+count) otherwise children at first and first+1
+    {
+        float bb[6] ;
+        int   first ;
+        int   count ;
+    };
+
+    const CSGFoundry* fd ;
+    const CSGPrim*    prim0 ;
+    const CSGNode*    node0 ;
+    const float4*     plan0 ;
+    const qat4*       itra0 ;
+    int               num_thread ;
+
+    std::vector<qat4>  w2m ;          // inverted instance transforms, identity info cleared
+    std::vector<int>   prim_boundary ;
+    std::vector<Item>  item ;
+    std::vector<Node>  bvh ;
+
+    CSGRayQuery(const CSGFoundry* fd);
+
+    void init();
+    void init_inverse();
+    void init_items();
+    void init_bvh();
+    void build(int n, int i0, int i1);
+
+    static bool SlabTest(float& t0, const float* bb, const float3& ori, const float3& inv, float tmin, float tmax );
+    static bool Contains(const float* bb, const float3& pos );
+
+    bool intersect_item( float4& isect, float& lposcost, const Item& it, const float3& ori, const float3& dir, float tmin ) const ;
+    bool intersect( quad2& prd, const float3& ori, const float3& dir, float tmin ) const ;
+    void collect( std::vector<int>& items, const float3& pos ) const ;
+
+    NP* intersect( const NP* origin, const NP* direction, const NP* tmin=nullptr, float tmin_default=0.f ) const ;
+
+    std::string desc() const ;
+};
@@ -0,0 +1,279 @@
+#include <limits>
+#include <sstream>
+#include <iomanip>
+#include <cassert>
+
+#include "SLOG.hh"
+#include "SBitSet.h"
+
+#include "CSGFoundry.h"
+#include "CSGSolid.h"
+#include "CSGPrim.h"
+#include "CU.h"
+
+#include "CSGSelection.h"
+
+const plog::Severity CSGSelection::LEVEL = SLOG::EnvLevel("CSGSelection", "DEBUG" );
+
+/**
+CSGSelection::Disable
+-----------------------
+
+NaN bounds make the custom primitive inactive for the OptiX GAS build,
+the rest of the prim including sbtIndexOffset is unchanged.
+
+**/
+
+void CSGSelection::Disable( CSGPrim& p ) // static
+{
+    float nan = std::numeric_limits<float>::quiet_NaN() ;
+    p.setAABB( nan, nan, nan, nan, nan, nan );
+}
+
+CSGSelection::CSGSelection(const CSGFoundry* fd_)
+    :
+    fd(fd_),
+    num_solid(fd->getNumSolid()),
+    num_prim(fd->getNumPrim()),
+    num_mesh(0),
+    num_apply(0),
+    d_prim(nullptr)
+{
+    init();
+}
+
+/**
+CSGSelection::init
+--------------------
+
+Starts with everything enabled, collecting the prims of each meshIdx
+so that subsequent *apply* only needs to visit the prims of meshes
+with changed ELV bits.
+
+**/
+
+void CSGSelection::init()
+{
+    prim = fd->prim ;
+    prim_solid.resize(num_prim, ~0u);
+
+    for(unsigned i=0 ; i < num_solid ; i++)
+    {
+        const CSGSolid* so = fd->getSolid(i);
+        for(int p=so->primOffset ; p < so->primOffset + so->numPrim ; p++) prim_solid[p] = i ;
+    }
+
+    for(unsigned p=0 ; p < num_prim ; p++)
+    {
+        unsigned meshIdx = prim[p].meshIdx() ;
+        if( meshIdx >= mesh_prim.size() ) mesh_prim.resize(meshIdx+1) ;
+        mesh_prim[meshIdx].push_back(p);
+    }
+    num_mesh = mesh_prim.size() ;
+
+    mesh_enabled.resize(num_mesh, 1);
+    prim_enabled.resize(num_prim, 1);
+    solid_num_enabled.resize(num_solid, 0);
+    solid_map.resize(num_solid, -1);
+    prim_map.resize(num_prim, -1);
+
+    for(unsigned p=0 ; p < num_prim ; p++) if(prim_solid[p] < num_solid) solid_num_enabled[prim_solid[p]] += 1 ;
+    update_maps();
+}
+
+/**
+CSGSelection::apply
+---------------------
+
+*elv* nullptr or bits beyond elv->num_bits enable the mesh, as CSGCopy.
+Returns the number of solids changed, which are listed in *dirty*.
+
+**/
+
+unsigned CSGSelection::apply(const SBitSet* elv)
+{
+    std::vector<char> solid_dirty(num_solid, 0) ;
+    unsigned num_toggle = 0 ;
+
+    for(unsigned m=0 ; m < num_mesh ; m++)
+    {
+        char want = elv == nullptr || m >= elv->num_bits || elv->is_set(m) ? 1 : 0 ;
+        if( want == mesh_enabled[m] ) continue ;
+        mesh_enabled[m] = want ;
+
+        const std::vector<unsigned>& mp = mesh_prim[m] ;
+        for(unsigned i=0 ; i < mp.size() ; i++)
+        {
+            unsigned p = mp[i] ;
+            unsigned s = prim_solid[p] ;
+            prim_enabled[p] = want ;
+            if( want ) prim[p] = fd->prim[p] ; else Disable(prim[p]) ;
+            if( s < num_solid )
+            {
+                solid_num_enabled[s] += want ? 1 : -1 ;
+                solid_dirty[s] = 1 ;
+            }
+            num_toggle += 1 ;
+        }
+    }
+
+    dirty.clear();
+    for(unsigned s=0 ; s < num_solid ; s++) if(solid_dirty[s]) dirty.push_back(s) ;
+
+    if( num_toggle > 0 ) update_maps();
+    if( d_prim ) upload();
+    num_apply += 1 ;
+
+    LOG(LEVEL) << " num_toggle " << num_toggle << " " << desc() ;
+    return dirty.size() ;
+}
+
+/**
+CSGSelection::update_maps
+---------------------------
+
+The compacted indices shift with any change so are recomputed,
+this is just a pass over the prims without touching nodes.
+
+**/
+
+void CSGSelection::update_maps()
+{
+    int dSolidIdx = 0 ;
+    int dPrimIdx = 0 ;
+    for(unsigned s=0 ; s < num_solid ; s++)
+    {
+        const CSGSolid* so = fd->getSolid(s);
+        solid_map[s] = solid_num_enabled[s] > 0 ? dSolidIdx++ : -1 ;
+        for(int p=so->primOffset ; p < so->primOffset + so->numPrim ; p++)
+        {
+            prim_map[p] = prim_enabled[p] ? dPrimIdx++ : -1 ;
+        }
+    }
+}
+
+/**
+CSGSelection::upload
+----------------------
+
+First call uploads the entire shadow, subsequently only
+the prims of the dirty solids are copied.
+
+**/
+
+void CSGSelection::upload()
+{
+    if( num_prim == 0 ) return ;
+    if( d_prim == nullptr )
+    {
+        d_prim = CU::UploadArray<CSGPrim>(prim.data(), num_prim ) ;
+        return ;
+    }
+    for(unsigned i=0 ; i < dirty.size() ; i++)
+    {
+        const CSGSolid* so = fd->getSolid(dirty[i]);
+        if( so->numPrim == 0 ) continue ;
+        CU::CopyToDevice<CSGPrim>( d_prim + so->primOffset, prim.data() + so->primOffset, so->numPrim );
+    }
+}
+
+bool CSGSelection::isUploaded() const
+{
+    return d_prim != nullptr ;
+}
+
+bool CSGSelection::is_all_enabled() const
+{
+    for(unsigned m=0 ; m < num_mesh ; m++) if(!mesh_enabled[m]) return false ;
+    return true ;
+}
+
+bool CSGSelection::is_prim_enabled(unsigned primIdx) const
+{
+    return primIdx < num_prim && prim_enabled[primIdx] ;
+}
+
+bool CSGSelection::is_solid_enabled(unsigned solidIdx) const
+{
+    return solidIdx < num_solid && solid_num_enabled[solidIdx] > 0 ;
+}
+
+unsigned CSGSelection::getNumEnabledPrim(unsigned solidIdx) const
+{
+    return solidIdx < num_solid ? solid_num_enabled[solidIdx] : 0 ;
+}
+
+unsigned CSGSelection::getNumEnabledPrim() const
+{
+    unsigned n = 0 ;
+    for(unsigned s=0 ; s < num_solid ; s++) n += solid_num_enabled[s] ;
+    return n ;
+}
+
+unsigned CSGSelection::getNumEnabledSolid() const
+{
+    unsigned n = 0 ;
+    for(unsigned s=0 ; s < num_solid ; s++) n += unsigned(solid_num_enabled[s] > 0) ;
+    return n ;
+}
+
+/**
+CSGSelection::solidMask
+-------------------------
+
+Clears the bits of solids with no enabled prim from the EMM *emm*
+so their instances are skipped from the IAS.
+
+**/
+
+unsigned long long CSGSelection::solidMask(unsigned long long emm) const
+{
+    unsigned long long mask = emm ;
+    for(unsigned s=0 ; s < num_solid && s < 64 ; s++) if(solid_num_enabled[s] == 0) mask &= ~( 0x1ull << s ) ;
+    return mask ;
+}
+
+SCSGPrimSpec CSGSelection::getPrimSpecHost(unsigned solidIdx) const
+{
+    const CSGSolid* so = fd->getSolid(solidIdx);
+    SCSGPrimSpec ps = CSGPrim::MakeSpec( prim.data(), so->primOffset, so->numPrim );
+    ps.device = false ;
+    return ps ;
+}
+
+SCSGPrimSpec CSGSelection::getPrimSpecDevice(unsigned solidIdx) const
+{
+    assert( d_prim );
+    const CSGSolid* so = fd->getSolid(solidIdx);
+    SCSGPrimSpec ps = CSGPrim::MakeSpec( d_prim, so->primOffset, so->numPrim );
+    ps.device = true ;
+    return ps ;
+}
+
+std::string CSGSelection::desc() const
+{
+    std::stringstream ss ;
+    ss << "CSGSelection::desc"
+       << " num_apply " << num_apply
+       << " num_mesh " << num_mesh
+       << " num_solid " << num_solid
+       << " num_prim " << num_prim
+       << " enabled_solid " << getNumEnabledSolid()
+       << " enabled_prim " << getNumEnabledPrim()
+       << " dirty " << dirty.size()
+       << " uploaded " << ( d_prim ? "YES" : "NO " )
+       << std::endl
+       ;
+    for(unsigned s=0 ; s < num_solid ; s++)
+    {
+        const CSGSolid* so = fd->getSolid(s);
+        ss << " s " << std::setw(3) << s
+           << " numPrim " << std::setw(5) << so->numPrim
+           << " enabled " << std::setw(5) << solid_num_enabled[s]
+           << " map " << std::setw(3) << solid_map[s]
+           << std::endl
+           ;
+    }
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,87 @@
+#pragma once
+/**
+CSGSelection : in-place ELV prim selection view over a CSGFoundry
+===================================================================
+
+CSGCopy::Select applies an ELV (LV exclusion) SBitSet by deep copying all
+surviving solids, prims, nodes, transforms and planes into a new CSGFoundry.
+That is slow and doubles geometry memory when scanning many ELV combinations
+(eg cxr_scan_elv). CSGSelection instead leaves the CSGFoundry untouched and
+keeps a per-prim enable mask:
+
+* *prim* is a shadow of CSGFoundry::prim where the disabled prims have NaN
+  bounds, which OptiX treats as inactive primitives. As the shadow has the same
+  layout, counts and sbtIndexOffset as the original the SCSGPrimSpec obtained
+  from it can be used for the GAS build without any change to the hitgroup
+  records, and the primIdx obtained in intersects still index CSGFoundry::prim
+
+* solids with no enabled prim are removed from the IAS by *solidMask*
+  which is ANDed with the EMM solid mask for instance selection
+
+* *solid_map* and *prim_map* give the compacted indices that
+  CSGCopy::Select would have produced, -1 for excluded
+
+Changing the selection with *apply* only visits the prims of meshes whose
+ELV bit changed. The solids affected are collected in *dirty*, so that only
+their acceleration structures need to be rebuilt (see SBT::updateSelection).
+When uploaded, only the shadow prims of the dirty solids are copied to device.
+
+Node bounds, solid center_extent and frames are those of the full geometry,
+so render framing does not change between selections.
+
+**/
+
+#include <vector>
+#include <string>
+#include "plog/Severity.h"
+#include "SCSGPrimSpec.h"
+#include "CSGPrim.h"
+#include "CSG_API_EXPORT.hh"
+
+struct SBitSet ;
+struct CSGFoundry ;
+
+struct CSG_API CSGSelection
+{
+    static const plog::Severity LEVEL ;
+    static void Disable( CSGPrim& p );
+
+    const CSGFoundry* fd ;
+    unsigned num_solid ;
+    unsigned num_prim ;
+    unsigned num_mesh ;
+    unsigned num_apply ;
+
+    std::vector<std::vector<unsigned>> mesh_prim ;  // global prim indices of each meshIdx (aka lvIdx)
+    std::vector<unsigned> prim_solid ;              // solid index of each global prim
+    std::vector<char>     mesh_enabled ;
+    std::vector<char>     prim_enabled ;
+    std::vector<unsigned> solid_num_enabled ;
+    std::vector<int>      solid_map ;   // src solid -> compacted solid as CSGCopy::solidMap, -1 when no prim enabled
+    std::vector<int>      prim_map ;    // src global prim -> compacted global prim, -1 when disabled
+    std::vector<CSGPrim>  prim ;        // shadow of CSGFoundry::prim with disabled bounds inactive
+    std::vector<unsigned> dirty ;       // solids changed by the last apply
+
+    CSGPrim* d_prim ;
+
+    CSGSelection(const CSGFoundry* fd);
+    void init();
+
+    unsigned apply(const SBitSet* elv);
+    void     update_maps();
+    void     upload();
+    bool     isUploaded() const ;
+
+    bool     is_all_enabled() const ;
+    bool     is_prim_enabled(unsigned primIdx) const ;
+    bool     is_solid_enabled(unsigned solidIdx) const ;
+    unsigned getNumEnabledPrim(unsigned solidIdx) const ;
+    unsigned getNumEnabledPrim() const ;
+    unsigned getNumEnabledSolid() const ;
+    unsigned long long solidMask(unsigned long long emm) const ;
+
+    SCSGPrimSpec getPrimSpecHost(  unsigned solidIdx) const ;
+    SCSGPrimSpec getPrimSpecDevice(unsigned solidIdx) const ;
+
+    std::string desc() const ;
+};
@@ -1,6 +1,7 @@
 #include "SLOG.hh"
 #include "SEventConfig.hh"
 #include "SSys.hh"
+#include "ssys.h"
 #include "SEvt.hh"
 #include "SSim.hh"
 #include "CSGFoundry.h"
@@ -9,8 +10,10 @@
 #include "CSGDraw.h"
 #include "NP.hh"
 #include "NPFold.h"
+#include "ssimtrace_refine.h"
 
 const plog::Severity CSGSimtrace::LEVEL = SLOG::EnvLevel("CSGSimtrace", "DEBUG");
+const int CSGSimtrace::ADAPTIVE = ssys::getenvint(CSGSimtrace__ADAPTIVE, 0) ;
 
 int CSGSimtrace::Preinit()    // static
 {
@@ -68,6 +71,7 @@ int CSGSimtrace::simtrace()
     sev->beginOfEvent(eventID);
 
     int num_intersect = qss ? simtrace_selection() : simtrace_all() ;
+    if(ADAPTIVE > 0) simtrace_adaptive();
 
     sev->gather();
     sev->topfold->concat();
@@ -128,3 +132,32 @@ int CSGSimtrace::simtrace_selection()
 }
 
 
+
+/**
+CSGSimtrace::simtrace_adaptive
+--------------------------------
+
+Refines the uniform CEGS gensteps of the frame, the grid spacing follows
+SFrameGenstep::MakeCenterExtentGenstep_FromFrame.
+
+**/
+
+int CSGSimtrace::simtrace_adaptive()
+{
+    const sframe& fr = sev->frame ;
+    bool ce_scale_off = ssys::getenvbool("CE_SCALE_OFF") ;
+    float local_scale = ce_scale_off ? fr.gridscale() : fr.gridscale()*fr.ce.w ;
+
+    ssimtrace_refine rf( [this](quad4& p){ return q->simtrace(p) ; }, 0, ADAPTIVE ) ;
+    rf.init( sev->genstep, local_scale );
+    int num_intersect = rf.run();
+
+    LOG(LEVEL) << rf.desc() ;
+
+    if(outdir)
+    {
+        NPFold* fold = rf.serialize() ;
+        fold->save(outdir, "simtrace_adaptive") ;
+    }
+    return num_intersect ;
+}
@@ -7,6 +7,12 @@ Canonical usage from tests/CSGSimtraceTest.cc
 
 The heart of this is CSGQuery on CPU intersect functionality using the csg headers
 
+With envvar CSGSimtrace__ADAPTIVE set to a number of levels the uniform
+CEGS gensteps are also used as the coarse base for sysrap/ssimtrace_refine.h
+which recursively adds finer gensteps only close to surfaces and where the
+region changes between neighbouring grid points. The refined genstep, simtrace
+and cell arrays are saved into the simtrace_adaptive subfold of the outdir.
+
 
 **/
 
@@ -27,6 +33,8 @@ struct quad4 ;
 struct CSG_API CSGSimtrace
 {
     static const plog::Severity LEVEL ;
+    static constexpr const char* CSGSimtrace__ADAPTIVE = "CSGSimtrace__ADAPTIVE" ;
+    static const int ADAPTIVE ;
     static int Preinit();
 
     int prc ;
@@ -52,6 +60,7 @@ struct CSG_API CSGSimtrace
     int simtrace();
     int simtrace_all();
     int simtrace_selection();
+    int simtrace_adaptive();
 
 };
 
@@ -79,6 +79,24 @@ T* CU::DownloadArray(const T* d_array, unsigned num_items ) // static
 }
 
 
+/**
+CU::CopyToDevice
+-----------------
+
+Copy from host into an existing device allocation, used for partial updates
+
+**/
+
+template <typename T>
+void CU::CopyToDevice(T* d_array, const T* array, unsigned num_items ) // static
+{
+#ifdef WITH_SLOG
+    LOG(LEVEL) << " num_items " << num_items  ; 
+#endif
+    CUDA_CHECK( cudaMemcpy(reinterpret_cast<void*>( d_array ), array, sizeof(T)*num_items, cudaMemcpyHostToDevice ));
+}
+
+
 template CSG_API float* CU::UploadArray<float>(const float* array, unsigned num_items) ;
 template CSG_API float* CU::DownloadArray<float>(const float* d_array, unsigned num_items) ;
 
@@ -101,6 +119,7 @@ template CSG_API qat4* CU::DownloadArray<qat4>(const qat4* d_array, unsigned num
 
 template CSG_API CSGPrim* CU::UploadArray<CSGPrim>(const CSGPrim* d_array, unsigned num_items) ;
 template CSG_API CSGPrim* CU::DownloadArray<CSGPrim>(const CSGPrim* d_array, unsigned num_items) ;
+template CSG_API void     CU::CopyToDevice<CSGPrim>(CSGPrim* d_array, const CSGPrim* array, unsigned num_items) ;
 
 template CSG_API CSGSolid* CU::UploadArray<CSGSolid>(const CSGSolid* d_array, unsigned num_items) ;
 template CSG_API CSGSolid* CU::DownloadArray<CSGSolid>(const CSGSolid* d_array, unsigned num_items) ;
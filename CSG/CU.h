@@ -41,6 +41,9 @@ struct CSG_API CU
     template <typename T>
     static T* DownloadArray(const T* array, unsigned num_items ) ; 
 
+    template <typename T>
+    static void CopyToDevice(T* d_array, const T* array, unsigned num_items ) ; 
+
 
     template <typename T>
     static T* UploadVec(const std::vector<T>& vec);
@@ -0,0 +1,135 @@
+/**
+opticks_CSG.cc
+================
+
+nanobind python module giving access to host side CSG geometry queries::
+
+    import numpy as np
+    import opticks_CSG as csg
+
+    rq = csg._CSGRayQuery()           # loads CSGFoundry geometry from GEOM envvar
+    ori = np.zeros( (1000000,3), dtype=np.float32 )
+    dir = np.random.normal(size=(1000000,3)).astype(np.float32)
+    isect = rq.intersect(ori, dir)               # (N,2,4) float32, quad2 PRD layout
+    isect = rq.intersect(ori, dir, tmin)         # per-ray tmin of shape (N,)
+
+    t = isect[:,0,3]
+    nrm = isect[:,0,:3]
+    iindex = isect[:,1,1].view(np.uint32)
+    bnd = isect[:,1,3].view(np.uint32) & 0xffff   # 0xffff for misses
+
+    loc = rq.locate(pos)    # (N,8) int32 : nidx,iindex,gprim,boundary,imat,sensor_id,sensor_index,lvid
+
+**/
+
+#include <nanobind/nanobind.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/ndarray.h>
+#include "NP_nanobind.h"
+
+#include "CSGFoundry.h"
+#include "CSGRayQuery.h"
+#include "CSGLocate.h"
+
+namespace nb = nanobind;
+
+
+struct _CSGRayQuery
+{
+   const CSGFoundry* fd ;
+   CSGRayQuery rq ;
+   CSGLocate   lo ;
+
+   _CSGRayQuery();
+
+   nb::ndarray<nb::numpy> intersect( nb::ndarray<nb::numpy, nb::c_contig> _ori, nb::ndarray<nb::numpy, nb::c_contig> _dir ) const ;
+   nb::ndarray<nb::numpy> intersect_tmin( nb::ndarray<nb::numpy, nb::c_contig> _ori, nb::ndarray<nb::numpy, nb::c_contig> _dir, nb::ndarray<nb::numpy, nb::c_contig> _tmin ) const ;
+   nb::ndarray<nb::numpy> locate( nb::ndarray<nb::numpy, nb::c_contig> _pos ) const ;
+   std::string desc() const ;
+
+   static const CSGFoundry* Load();
+};
+
+inline const CSGFoundry* _CSGRayQuery::Load()
+{
+    const CSGFoundry* fd = CSGFoundry::Load();
+    if(fd == nullptr) throw std::runtime_error("_CSGRayQuery::Load failed to load CSGFoundry, check GEOM envvar");
+    return fd ;
+}
+
+inline _CSGRayQuery::_CSGRayQuery()
+    :
+    fd(Load()),
+    rq(fd),
+    lo(fd, &rq)
+{
+}
+
+/**
+_CSGRayQuery::intersect
+-------------------------
+
+The inputs are copied into NP and the returned array adopts the data
+of the NP intersect array, as done by _CSGOptiXService::simulate.
+As the copy reads the data bytes in C order the inputs are c_contig,
+so nanobind converts non-contiguous arrays such as slices to contiguous copies.
+
+**/
+
+inline nb::ndarray<nb::numpy> _CSGRayQuery::intersect( nb::ndarray<nb::numpy, nb::c_contig> _ori, nb::ndarray<nb::numpy, nb::c_contig> _dir ) const
+{
+    NP* ori = NP_nanobind::NP_copy_of_numpy_array(_ori);
+    NP* dir = NP_nanobind::NP_copy_of_numpy_array(_dir);
+
+    NP* isect = rq.intersect(ori, dir);
+    delete ori ;
+    delete dir ;
+    if(isect == nullptr) throw std::invalid_argument("_CSGRayQuery::intersect expects float (N,3|4) origin and direction arrays");
+
+    return NP_nanobind::numpy_array_view_of_NP(isect);
+}
+
+inline nb::ndarray<nb::numpy> _CSGRayQuery::intersect_tmin( nb::ndarray<nb::numpy, nb::c_contig> _ori, nb::ndarray<nb::numpy, nb::c_contig> _dir, nb::ndarray<nb::numpy, nb::c_contig> _tmin ) const
+{
+    NP* ori = NP_nanobind::NP_copy_of_numpy_array(_ori);
+    NP* dir = NP_nanobind::NP_copy_of_numpy_array(_dir);
+    NP* tmin = NP_nanobind::NP_copy_of_numpy_array(_tmin);
+
+    NP* isect = rq.intersect(ori, dir, tmin);
+    delete ori ;
+    delete dir ;
+    delete tmin ;
+    if(isect == nullptr) throw std::invalid_argument("_CSGRayQuery::intersect expects float (N,3|4) origin and direction and (N,) tmin arrays");
+
+    return NP_nanobind::numpy_array_view_of_NP(isect);
+}
+
+inline nb::ndarray<nb::numpy> _CSGRayQuery::locate( nb::ndarray<nb::numpy, nb::c_contig> _pos ) const
+{
+    NP* pos = NP_nanobind::NP_copy_of_numpy_array(_pos);
+    NP* loc = lo.locate(pos);
+    delete pos ;
+    if(loc == nullptr) throw std::invalid_argument("_CSGRayQuery::locate expects float (N,3|4) position array");
+
+    return NP_nanobind::numpy_array_view_of_NP(loc);
+}
+
+inline std::string _CSGRayQuery::desc() const
+{
+    return rq.desc() + "\n" + lo.desc() ;
+}
+
+
+// First argument is module name which must match the first arg to nanobind_add_module in CMakeLists.txt
+NB_MODULE(opticks_CSG, m)
+{
+    m.doc() = "nanobind host side CSG geometry queries";
+
+    nb::class_<_CSGRayQuery>(m, "_CSGRayQuery")
+        .def(nb::init<>())
+        .def("__repr__", &_CSGRayQuery::desc)
+        .def("intersect", &_CSGRayQuery::intersect, nb::arg("origin"), nb::arg("direction") )
+        .def("intersect", &_CSGRayQuery::intersect_tmin, nb::arg("origin"), nb::arg("direction"), nb::arg("tmin") )
+        .def("locate", &_CSGRayQuery::locate, nb::arg("position") )
+        ;
+}
@@ -0,0 +1,137 @@
+/**
+CSGFoundry_Bundle_Test.cc
+===========================
+
+::
+
+   ~/o/CSG/tests/CSGFoundry_Bundle_Test.sh
+   TEST=bench REPEAT=5 ~/o/CSG/tests/CSGFoundry_Bundle_Test.sh
+
+create
+    converts the directory form $cfbase/CSGFoundry into $cfbase/CSGFoundry.bundle
+
+extract
+    converts the bundle back into the directory form beneath $FOLD/CSGFoundry
+
+check
+    loads from the directory and from the bundle comparing the arrays and names
+
+bench
+    load times from directory and bundle, repeated REPEAT times
+
+**/
+
+#include "OPTICKS_LOG.hh"
+#include "ssys.h"
+#include "sstamp.h"
+#include "SSim.hh"
+#include "CSGFoundry.h"
+
+struct CSGFoundry_Bundle_Test
+{
+    const char* cfbase ;
+    const char* FOLD ;
+    const char* TEST ;
+
+    CSGFoundry_Bundle_Test();
+
+    CSGFoundry* load_dir() const ;
+    int create() const ;
+    int extract() const ;
+    int check() const ;
+    int bench() const ;
+    int run() const ;
+};
+
+CSGFoundry_Bundle_Test::CSGFoundry_Bundle_Test()
+    :
+    cfbase(CSGFoundry::ResolveCFBase()),
+    FOLD(ssys::getenvvar("FOLD", "/tmp/CSGFoundry_Bundle_Test")),
+    TEST(ssys::getenvvar("TEST", "ALL"))
+{
+}
+
+CSGFoundry* CSGFoundry_Bundle_Test::load_dir() const
+{
+    SSim::Load(cfbase, "CSGFoundry/SSim");
+    return CSGFoundry::Load(cfbase, "CSGFoundry");
+}
+
+int CSGFoundry_Bundle_Test::create() const
+{
+    int rc = CSGFoundry::CreateBundle(cfbase) ;
+    LOG(info) << " cfbase " << cfbase << " rc " << rc ;
+    return rc ;
+}
+
+int CSGFoundry_Bundle_Test::extract() const
+{
+    int rc = CSGFoundry::ExtractBundle(cfbase, FOLD) ;
+    LOG(info) << " FOLD " << FOLD << " rc " << rc ;
+    return rc ;
+}
+
+int CSGFoundry_Bundle_Test::check() const
+{
+    CSGFoundry* a = load_dir() ;
+    CSGFoundry* b = CSGFoundry::LoadBundle(cfbase) ;
+    if( a == nullptr || b == nullptr ) return 1 ;
+
+    int rc = 0 ;
+    rc += CSGFoundry::Compare(a, b) ;
+    rc += int( a->meshname != b->meshname ) ;
+    rc += int( a->mmlabel != b->mmlabel ) ;
+    rc += int( a->meta != b->meta ) ;
+    rc += int( a->getNumSolid() != b->getNumSolid() ) ;
+
+    LOG(info)
+        << " a " << a->brief()
+        << "\n b " << b->brief()
+        << "\n rc " << rc
+        ;
+    return rc ;
+}
+
+int CSGFoundry_Bundle_Test::bench() const
+{
+    int REPEAT = ssys::getenvint("REPEAT", 3) ;
+    int rc = 0 ;
+    for(int i=0 ; i < REPEAT ; i++)
+    {
+        int64_t t0 = sstamp::Now() ;
+        CSGFoundry* a = load_dir() ;
+        int64_t t1 = sstamp::Now() ;
+        CSGFoundry* b = CSGFoundry::LoadBundle(cfbase) ;
+        int64_t t2 = sstamp::Now() ;
+
+        rc += int( a == nullptr || b == nullptr ) ;
+
+        std::cout
+            << "CSGFoundry_Bundle_Test::bench"
+            << " i " << i
+            << " dir " << std::setw(10) << (t1 - t0) << " us"
+            << " bundle " << std::setw(10) << (t2 - t1) << " us"
+            << "\n"
+            ;
+    }
+    return rc ;
+}
+
+int CSGFoundry_Bundle_Test::run() const
+{
+    if( cfbase == nullptr ) return 1 ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"create")==0)  rc += create();
+    if(ALL||strcmp(TEST,"check")==0)   rc += check();
+    if(ALL||strcmp(TEST,"extract")==0) rc += extract();
+    if(ALL||strcmp(TEST,"bench")==0)   rc += bench();
+    return rc ;
+}
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+    CSGFoundry_Bundle_Test t ;
+    return t.run() ;
+}
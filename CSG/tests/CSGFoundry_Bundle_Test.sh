@@ -0,0 +1,42 @@
+#!/bin/bash
+usage(){ cat << EOU
+CSGFoundry_Bundle_Test.sh
+===========================
+
+Converts the CSGFoundry geometry specified by GEOM envvar into the single
+file bundle $CFBase/CSGFoundry.bundle, checks it against the directory
+form and compares load times::
+
+   ~/o/CSG/tests/CSGFoundry_Bundle_Test.sh
+   TEST=bench REPEAT=5 ~/o/CSG/tests/CSGFoundry_Bundle_Test.sh
+
+Loading from the bundle with CSGFoundry::Load is enabled with::
+
+   export CSGFoundry__Load_BUNDLE=1
+
+EOU
+}
+
+source $HOME/.opticks/GEOM/GEOM.sh  # sets GEOM envvar, edit with GEOM bash function
+
+export ${GEOM}_CFBaseFromGEOM=$HOME/.opticks/GEOM/$GEOM
+
+bin=CSGFoundry_Bundle_Test
+export FOLD=${TMP:-/tmp/$USER/opticks}/$bin
+mkdir -p $FOLD
+
+defarg="info_run"
+arg=${1:-$defarg}
+
+vars="BASH_SOURCE GEOM FOLD bin TEST"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 1
+fi
+
+exit 0
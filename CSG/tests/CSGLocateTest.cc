@@ -0,0 +1,267 @@
+/**
+CSGLocateTest.cc
+==================
+
+::
+
+   ~/o/CSG/tests/CSGLocateTest.sh
+   TEST=bench NUM=1000000 ~/o/CSG/tests/CSGLocateTest.sh
+   TEST=genstep GSPATH=/path/to/genstep.npy ~/o/CSG/tests/CSGLocateTest.sh
+
+threads
+    serial and multithreaded batch results for NUM random points
+    within the remainder solid must be identical
+
+instance
+    centers of the solids of up to NUM_INST instances transformed into
+    the world frame are expected to be located within those instances,
+    when the center is inside the outer prim of the instance (not so for
+    eg rings), also fails when the stree node lvid do not match the prims
+
+bench
+    points per second, the locations are saved to $FOLD/locate.npy
+
+genstep
+    positions of the gensteps from GSPATH are located, reporting the
+    number outside the world and the counts by material index
+
+**/
+
+#include <random>
+#include <cstring>
+#include <sstream>
+#include <map>
+
+#include "OPTICKS_LOG.hh"
+#include "ssys.h"
+#include "sstamp.h"
+#include "NP.hh"
+#include "CSGFoundry.h"
+#include "CSGRayQuery.h"
+#include "CSGLocate.h"
+
+struct CSGLocateTest
+{
+    const char* FOLD ;
+    const char* TEST ;
+    int NUM ;
+    const CSGFoundry* fd ;
+    CSGLocate* lo ;
+    NP* pos ;
+
+    CSGLocateTest(const CSGFoundry* fd);
+    void init();
+
+    int threads() const ;
+    int instance() const ;
+    int bench() const ;
+    int genstep() const ;
+    int run() const ;
+};
+
+CSGLocateTest::CSGLocateTest(const CSGFoundry* fd_)
+    :
+    FOLD(ssys::getenvvar("FOLD", "/tmp/CSGLocateTest")),
+    TEST(ssys::getenvvar("TEST", "ALL")),
+    NUM(ssys::getenvint("NUM", 100000)),
+    fd(fd_),
+    lo(new CSGLocate(fd)),
+    pos(NP::Make<float>(NUM, 4))
+{
+    init();
+}
+
+void CSGLocateTest::init()
+{
+    float4 ce = fd->getSolid(0)->center_extent ;
+
+    std::mt19937 rng(1) ;
+    std::uniform_real_distribution<float> uni(-1.f, 1.f) ;
+
+    float* pp = pos->values<float>() ;
+    for(int i=0 ; i < NUM ; i++)
+    {
+        pp[i*4+0] = ce.x + ce.w*uni(rng) ;
+        pp[i*4+1] = ce.y + ce.w*uni(rng) ;
+        pp[i*4+2] = ce.z + ce.w*uni(rng) ;
+        pp[i*4+3] = 1.f ;
+    }
+    LOG(info) << lo->desc() ;
+}
+
+int CSGLocateTest::threads() const
+{
+    int num_thread = lo->num_thread ;
+
+    lo->num_thread = 1 ;
+    NP* a = lo->locate(pos) ;
+    lo->num_thread = num_thread ;
+    NP* b = lo->locate(pos) ;
+
+    int rc = int( a == nullptr || b == nullptr ) ;
+    if(rc == 0) rc += int( a->arr_bytes() != b->arr_bytes() || memcmp( a->bytes(), b->bytes(), a->arr_bytes() ) != 0 ) ;
+
+    LOG(info)
+        << " a.num_thread " << ( a ? a->get_meta<int>("num_thread") : -1 )
+        << " b.num_thread " << ( b ? b->get_meta<int>("num_thread") : -1 )
+        << " rc " << rc
+        ;
+    delete a ;
+    delete b ;
+    return rc ;
+}
+
+int CSGLocateTest::instance() const
+{
+    int num_inst = fd->inst.size() ;
+    int NUM_INST = std::min( num_inst - 1, ssys::getenvint("NUM_INST", 10000) ) ;
+    if( NUM_INST < 1 ) return int( lo->num_lvid_mismatch > 0 ) ;
+
+    std::vector<int> outer_item(num_inst, -1) ;   // item of the outer prim of each instance
+    const CSGRayQuery* rq = lo->rq ;
+    for(int j=0 ; j < int(rq->item.size()) ; j++)
+    {
+        const CSGRayQuery::Item& it = rq->item[j] ;
+        int ins_idx, gas_idx, sensor_identifier, sensor_index ;
+        fd->inst[it.inst].getIdentity(ins_idx, gas_idx, sensor_identifier, sensor_index );
+        if( it.prim == fd->getSolid(gas_idx)->primOffset ) outer_item[it.inst] = j ;
+    }
+
+    NP* ipos = NP::Make<float>(NUM_INST, 4) ;
+    float* pp = ipos->values<float>() ;
+    for(int i=0 ; i < NUM_INST ; i++)
+    {
+        int ii = 1 + i*( num_inst - 1 )/NUM_INST ;
+        qat4 t(fd->inst[ii].cdata()) ;
+        int ins_idx, gas_idx, sensor_identifier, sensor_index ;
+        t.getIdentity(ins_idx, gas_idx, sensor_identifier, sensor_index );
+        t.clearIdentity();
+        float4 ce = fd->getSolid(gas_idx)->center_extent ;
+        float3 wpos = t.right_multiply( make_float3(ce.x, ce.y, ce.z), 1.f );
+        pp[i*4+0] = wpos.x ;
+        pp[i*4+1] = wpos.y ;
+        pp[i*4+2] = wpos.z ;
+        pp[i*4+3] = float(ii) ;
+    }
+
+    NP* loc = lo->locate(ipos) ;
+    const int* ll = loc->cvalues<int>() ;
+
+    int num_expect = 0 ;
+    int num_match = 0 ;
+    for(int i=0 ; i < NUM_INST ; i++)
+    {
+        int ii = int(pp[i*4+3]) ;
+        int j = outer_item[ii] ;
+        bool expect = j > -1 && lo->distance_item( j, make_float3( pp[i*4+0], pp[i*4+1], pp[i*4+2] )) < 0.f ;
+        if(!expect) continue ;
+        num_expect += 1 ;
+
+        int iindex = ll[i*CSGLocate::NV + CSGLocate::IINDEX] ;
+        if( iindex == ii ) num_match += 1 ;
+        LOG_IF(error, iindex != ii ) << " i " << i << " expected iindex " << ii << " located iindex " << iindex ;
+    }
+
+    int rc = int( num_match != num_expect ) + int( lo->num_lvid_mismatch > 0 ) ;
+
+    LOG(info)
+        << " NUM_INST " << NUM_INST
+        << " num_expect " << num_expect
+        << " num_match " << num_match
+        << " num_lvid_mismatch " << lo->num_lvid_mismatch
+        << " rc " << rc
+        ;
+
+    delete loc ;
+    delete ipos ;
+    return rc ;
+}
+
+int CSGLocateTest::bench() const
+{
+    int64_t t0 = sstamp::Now() ;
+    NP* loc = lo->locate(pos) ;
+    int64_t t1 = sstamp::Now() ;
+    if( loc == nullptr ) return 1 ;
+
+    const int* ll = loc->cvalues<int>() ;
+    int num_outside = 0 ;
+    for(int i=0 ; i < NUM ; i++) if( ll[i*CSGLocate::NV + CSGLocate::IINDEX] == -1 ) num_outside += 1 ;
+
+    double us = double(t1 - t0) ;
+    LOG(info)
+        << " NUM " << NUM
+        << " num_outside " << num_outside
+        << " num_thread " << loc->get_meta<int>("num_thread")
+        << " time " << us << " us"
+        << " points/s " << ( us > 0. ? 1e6*NUM/us : 0. )
+        ;
+
+    loc->save(FOLD, "locate.npy");
+    pos->save(FOLD, "pos.npy");
+    return 0 ;
+}
+
+/**
+CSGLocateTest::genstep
+------------------------
+
+Genstep positions are at q1.f.xyz of the (N,6,4) float gensteps.
+
+**/
+
+int CSGLocateTest::genstep() const
+{
+    const char* GSPATH = ssys::getenvvar("GSPATH", nullptr) ;
+    if( GSPATH == nullptr ) return 0 ;
+
+    NP* gs = NP::Load(GSPATH) ;
+    if( gs == nullptr || !gs->has_shape(-1, 6, 4) || gs->uifc != 'f' || gs->ebyte != 4 ) return 1 ;
+
+    int num_gs = gs->shape[0] ;
+    NP* gpos = NP::Make<float>(num_gs, 4) ;
+    const float* gg = gs->cvalues<float>() ;
+    float* pp = gpos->values<float>() ;
+    for(int i=0 ; i < num_gs ; i++) for(int k=0 ; k < 4 ; k++) pp[i*4+k] = gg[i*6*4 + 4 + k] ;
+
+    NP* loc = lo->locate(gpos) ;
+    const int* ll = loc->cvalues<int>() ;
+
+    std::map<int,int> imat_count ;
+    for(int i=0 ; i < num_gs ; i++) imat_count[ll[i*CSGLocate::NV + CSGLocate::IMAT]] += 1 ;
+
+    std::stringstream ss ;
+    for(auto it=imat_count.begin() ; it != imat_count.end() ; it++) ss << " imat " << it->first << " : " << it->second << "\n" ;
+    LOG(info)
+        << " GSPATH " << GSPATH
+        << " num_gs " << num_gs
+        << " outside(imat -1) " << ( imat_count.count(-1) ? imat_count[-1] : 0 )
+        << "\n"
+        << ss.str()
+        ;
+
+    loc->save(FOLD, "genstep_locate.npy");
+    return 0 ;
+}
+
+int CSGLocateTest::run() const
+{
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"threads")==0)  rc += threads();
+    if(ALL||strcmp(TEST,"instance")==0) rc += instance();
+    if(ALL||strcmp(TEST,"bench")==0)    rc += bench();
+    if(ALL||strcmp(TEST,"genstep")==0)  rc += genstep();
+    return rc ;
+}
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+
+    const CSGFoundry* fd = CSGFoundry::Load();   // also loads SSim with the stree
+    if( fd == nullptr ) return 1 ;
+
+    CSGLocateTest t(fd) ;
+    return t.run() ;
+}
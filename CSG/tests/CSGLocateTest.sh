@@ -0,0 +1,42 @@
+#!/bin/bash
+usage(){ cat << EOU
+CSGLocateTest.sh
+==================
+
+Batched host point-in-volume location with the CSGFoundry geometry
+specified by GEOM envvar::
+
+   ~/o/CSG/tests/CSGLocateTest.sh
+   TEST=bench NUM=1000000 ~/o/CSG/tests/CSGLocateTest.sh
+   TEST=genstep GSPATH=/path/to/genstep.npy ~/o/CSG/tests/CSGLocateTest.sh
+
+The number of threads is controlled with::
+
+   export CSGLocate__NUM_THREAD=8
+
+EOU
+}
+
+source $HOME/.opticks/GEOM/GEOM.sh  # sets GEOM envvar, edit with GEOM bash function
+
+export ${GEOM}_CFBaseFromGEOM=$HOME/.opticks/GEOM/$GEOM
+
+bin=CSGLocateTest
+export FOLD=${TMP:-/tmp/$USER/opticks}/$bin
+mkdir -p $FOLD
+
+defarg="info_run"
+arg=${1:-$defarg}
+
+vars="BASH_SOURCE GEOM FOLD bin TEST NUM CSGLocate__NUM_THREAD"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 1
+fi
+
+exit 0
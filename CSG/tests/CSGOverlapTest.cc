@@ -0,0 +1,253 @@
+/**
+CSGOverlapTest.cc
+===================
+
+::
+
+   ~/o/CSG/tests/CSGOverlapTest.sh
+   TEST=scan CSGOverlap__NUM_RAY=2000 ~/o/CSG/tests/CSGOverlapTest.sh
+   TEST=scan CSGOverlap__LVID=105,106 ~/o/CSG/tests/CSGOverlapTest.sh
+   TEST=detect ~/o/CSG/tests/CSGOverlapTest.sh
+
+threads
+    serial and multithreaded scans must give identical records,
+    the number of rays is reduced to NUM_RAY_THREADS to keep this quick
+
+scan
+    full scan with the configured number of rays, reports counts of each
+    kind and the worst records, saving the records to $FOLD/overlap.npy
+
+detect
+    does not need GEOM, scans CSGMaker::makeOverlapDemo with a matching
+    remainder only stree and checks that the deliberate protrusion, sibling
+    overlap and coincident faces are found with the expected signed distances
+    and that no other overlaps are reported
+
+**/
+
+#include <cstring>
+#include <algorithm>
+
+#include "OPTICKS_LOG.hh"
+#include "ssys.h"
+#include "sstamp.h"
+#include "NP.hh"
+#include "SSim.hh"
+#include "stree.h"
+#include "CSGFoundry.h"
+#include "CSGMaker.h"
+#include "CSGLocate.h"
+#include "CSGOverlap.h"
+
+struct CSGOverlapTest
+{
+    const char* FOLD ;
+    const char* TEST ;
+    const CSGFoundry* fd ;
+    CSGLocate* lo ;
+    CSGOverlap* ov ;
+
+    CSGOverlapTest(const CSGFoundry* fd);
+    ~CSGOverlapTest();
+
+    int threads() const ;
+    int scan() const ;
+    int run() const ;
+
+    static int Detect();
+};
+
+CSGOverlapTest::CSGOverlapTest(const CSGFoundry* fd_)
+    :
+    FOLD(ssys::getenvvar("FOLD", "/tmp/CSGOverlapTest")),
+    TEST(ssys::getenvvar("TEST", "ALL")),
+    fd(fd_),
+    lo(new CSGLocate(fd)),
+    ov(new CSGOverlap(fd, lo))
+{
+    LOG(info) << ov->desc() ;
+}
+
+CSGOverlapTest::~CSGOverlapTest()
+{
+    delete ov ;
+    delete lo ;
+}
+
+int CSGOverlapTest::threads() const
+{
+    int num_thread = ov->num_thread ;
+    int num_ray = ov->num_ray ;
+
+    ov->num_ray = std::min( num_ray, ssys::getenvint("NUM_RAY_THREADS", 50) ) ;
+    ov->init_dirs();
+
+    ov->num_thread = 1 ;
+    NP* a = ov->scan() ;
+    ov->num_thread = num_thread ;
+    NP* b = ov->scan() ;
+
+    ov->num_ray = num_ray ;
+    ov->init_dirs();
+
+    int rc = int( a->arr_bytes() != b->arr_bytes() || ( a->arr_bytes() > 0 && memcmp( a->bytes(), b->bytes(), a->arr_bytes() ) != 0 )) ;
+
+    LOG(info)
+        << " a.num_thread " << a->get_meta<int>("num_thread")
+        << " b.num_thread " << b->get_meta<int>("num_thread")
+        << " a " << a->sstr()
+        << " b " << b->sstr()
+        << " rc " << rc
+        ;
+    delete a ;
+    delete b ;
+    return rc ;
+}
+
+int CSGOverlapTest::scan() const
+{
+    int64_t t0 = sstamp::Now() ;
+    NP* a = ov->scan() ;
+    int64_t t1 = sstamp::Now() ;
+
+    LOG(info)
+        << " num_thread " << a->get_meta<int>("num_thread")
+        << " time " << double(t1 - t0)/1e6 << " s"
+        << "\n"
+        << ov->desc(a, ssys::getenvint("NUM_WORST", 20))
+        ;
+
+    a->save(FOLD, "overlap.npy");
+    delete a ;
+    return 0 ;
+}
+
+int CSGOverlapTest::run() const
+{
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"threads")==0) rc += threads();
+    if(ALL||strcmp(TEST,"scan")==0)    rc += scan();
+    return rc ;
+}
+
+/**
+CSGOverlapTest::Detect
+------------------------
+
+The stree has one node for each prim of the single global solid, in the
+same order, so CSGLocate maps each prim to the node of the same index.
+The expected records are (nidx, other_nidx, kind) with signed distance range,
+the ranges allow for the sampling not hitting the extreme points exactly.
+
+**/
+
+int CSGOverlapTest::Detect() // static
+{
+    SSim* sim = SSim::Create();
+    CSGFoundry* fd = new CSGFoundry ;
+
+    std::vector<int> parent ;
+    fd->maker->makeOverlapDemo("OverlapDemo", &parent);
+    fd->setGeom("OverlapDemo");
+    fd->addInstancePlaceholder();
+    fd->addSolidMMLabel("OverlapDemo");
+
+    stree* st = sim->tree ;
+    for(int i=0 ; i < int(parent.size()) ; i++)
+    {
+        snode nd = {} ;
+        nd.index = i ;
+        nd.parent = parent[i] ;
+        nd.depth = nd.parent == -1 ? 0 : st->nds[nd.parent].depth + 1 ;
+        nd.sibdex = nd.parent == -1 ? 0 : st->nds[nd.parent].num_child++ ;
+        nd.first_child = -1 ;
+        nd.next_sibling = -1 ;
+        nd.lvid = i ;
+        nd.sensor_id = -1 ;
+        nd.sensor_index = -1 ;
+        st->nds.push_back(nd);
+    }
+    st->rem = st->nds ;
+    st->inst_nidx.push_back(0) ;
+
+    CSGOverlap ov(fd) ;
+    ov.num_ray = 500 ;
+    ov.init_dirs();
+    NP* a = ov.scan() ;
+
+    const quad4* rec = (const quad4*)a->cvalues<float>() ;
+    int num = a->shape[0] ;
+    float tol = ov.tol ;
+
+    struct Expect { int nidx ; int other ; int kind ; float sd0 ; float sd1 ; } ;
+    std::vector<Expect> expect = {
+        { 2, 1, CSGOverlap::PARENT_PROTRUDE,     25.f,       30.f + tol },
+        { 3, 4, CSGOverlap::SIBLING_OVERLAP,    -30.f - tol, -25.f      },
+        { 4, 3, CSGOverlap::SIBLING_OVERLAP,    -30.f - tol, -25.f      },
+        { 5, 1, CSGOverlap::PARENT_COINCIDENT,  -tol,        tol        },
+        { 6, 1, CSGOverlap::PARENT_COINCIDENT,  -tol,        tol        },
+        { 5, 6, CSGOverlap::SIBLING_COINCIDENT, -tol,        tol        },
+        { 6, 5, CSGOverlap::SIBLING_COINCIDENT, -tol,        tol        }
+    };
+
+    auto find_rec = [rec, num](int nidx, int other, int kind)
+    {
+        int k = -1 ;
+        for(int i=0 ; i < num ; i++) if( rec[i].q1.i.x == nidx && rec[i].q1.i.y == other && rec[i].q1.i.z == kind ) k = i ;
+        return k ;
+    };
+
+    int rc = 0 ;
+    for(unsigned e=0 ; e < expect.size() ; e++)
+    {
+        const Expect& x = expect[e] ;
+        int k = find_rec( x.nidx, x.other, x.kind ) ;
+        float sd = k > -1 ? rec[k].q0.f.w : 0.f ;
+        bool ok = k > -1 && rec[k].q1.i.w > 0 && sd >= x.sd0 && sd <= x.sd1 ;
+        rc += int(!ok) ;
+        LOG_IF(error, !ok)
+            << " MISSING OR UNEXPECTED SD " << CSGOverlap::Kind(x.kind)
+            << " nidx " << x.nidx << ":" << x.other
+            << " k " << k
+            << " sd " << sd
+            << " expect [" << x.sd0 << "," << x.sd1 << "]"
+            ;
+    }
+
+    // coincidences can also occur where overlapping surfaces cross, but any other overlap is a false positive
+    for(int i=0 ; i < num ; i++)
+    {
+        int kind = rec[i].q1.i.z ;
+        if( kind != CSGOverlap::PARENT_PROTRUDE && kind != CSGOverlap::SIBLING_OVERLAP ) continue ;
+        bool listed = false ;
+        for(unsigned e=0 ; e < expect.size() ; e++) if( expect[e].nidx == rec[i].q1.i.x && expect[e].other == rec[i].q1.i.y && expect[e].kind == kind ) listed = true ;
+        rc += int(!listed) ;
+        LOG_IF(error, !listed) << " FALSE POSITIVE " << CSGOverlap::Kind(kind) << " nidx " << rec[i].q1.i.x << ":" << rec[i].q1.i.y << " sd " << rec[i].q0.f.w ;
+    }
+
+    LOG(info) << " rc " << rc << "\n" << ov.desc(a) ;
+    delete a ;
+    return rc ;
+}
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+
+    const char* TEST = ssys::getenvvar("TEST", "ALL") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+
+    if(ALL||strcmp(TEST,"threads")==0||strcmp(TEST,"scan")==0)
+    {
+        const CSGFoundry* fd = CSGFoundry::Load();   // also loads SSim with the stree
+        if( fd == nullptr ) return 1 ;
+
+        CSGOverlapTest t(fd) ;
+        rc += t.run() ;
+    }
+
+    if(ALL||strcmp(TEST,"detect")==0) rc += CSGOverlapTest::Detect() ;   // after Load as replaces SSim
+    return rc ;
+}
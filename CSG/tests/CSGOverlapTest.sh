@@ -0,0 +1,45 @@
+#!/bin/bash
+usage(){ cat << EOU
+CSGOverlapTest.sh
+==================
+
+Host scan for overlaps and coincident surfaces between each prim and its
+stree parent and siblings, with the CSGFoundry geometry specified by GEOM envvar::
+
+   ~/o/CSG/tests/CSGOverlapTest.sh
+   TEST=scan CSGOverlap__NUM_RAY=2000 ~/o/CSG/tests/CSGOverlapTest.sh
+   TEST=scan CSGOverlap__LVID=105,106 ~/o/CSG/tests/CSGOverlapTest.sh
+   TEST=detect ~/o/CSG/tests/CSGOverlapTest.sh
+
+Threads, rays per prim and coincidence tolerance are controlled with::
+
+   export CSGOverlap__NUM_THREAD=8
+   export CSGOverlap__NUM_RAY=500
+   export CSGOverlap__TOL=0.01
+
+EOU
+}
+
+source $HOME/.opticks/GEOM/GEOM.sh  # sets GEOM envvar, edit with GEOM bash function
+
+export ${GEOM}_CFBaseFromGEOM=$HOME/.opticks/GEOM/$GEOM
+
+bin=CSGOverlapTest
+export FOLD=${TMP:-/tmp/$USER/opticks}/$bin
+mkdir -p $FOLD
+
+defarg="info_run"
+arg=${1:-$defarg}
+
+vars="BASH_SOURCE GEOM FOLD bin TEST CSGOverlap__NUM_THREAD CSGOverlap__NUM_RAY CSGOverlap__TOL CSGOverlap__LVID"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 1
+fi
+
+exit 0
@@ -0,0 +1,242 @@
+/**
+CSGRayQueryTest.cc
+====================
+
+::
+
+   ~/o/CSG/tests/CSGRayQueryTest.sh
+   TEST=bench NUM=1000000 ~/o/CSG/tests/CSGRayQueryTest.sh
+
+Rays with random directions from the center of the remainder solid
+are intersected with the full geometry.
+
+threads
+    serial and multithreaded batch results must be identical
+
+scaled
+    scaling the directions must not change the intersects, as they are normalized,
+    and misses must have the identity of __miss__ms
+
+brute
+    BVH closest intersects of the first NUM_BRUTE rays are compared with
+    a brute force loop over all the (instance,prim) items
+
+bench
+    rays per second of the batched query, the intersects are saved to $FOLD/isect.npy
+
+**/
+
+#include <random>
+#include <cstring>
+
+#include "OPTICKS_LOG.hh"
+#include "ssys.h"
+#include "sstamp.h"
+#include "NP.hh"
+#include "CSGFoundry.h"
+#include "CSGRayQuery.h"
+
+struct CSGRayQueryTest
+{
+    const char* FOLD ;
+    const char* TEST ;
+    int NUM ;
+    const CSGFoundry* fd ;
+    CSGRayQuery* rq ;
+    NP* origin ;
+    NP* direction ;
+
+    CSGRayQueryTest(const CSGFoundry* fd);
+    void init();
+
+    int threads() const ;
+    int scaled() const ;
+    int brute() const ;
+    int bench() const ;
+    int run() const ;
+};
+
+CSGRayQueryTest::CSGRayQueryTest(const CSGFoundry* fd_)
+    :
+    FOLD(ssys::getenvvar("FOLD", "/tmp/CSGRayQueryTest")),
+    TEST(ssys::getenvvar("TEST", "ALL")),
+    NUM(ssys::getenvint("NUM", 100000)),
+    fd(fd_),
+    rq(new CSGRayQuery(fd)),
+    origin(NP::Make<float>(NUM, 4)),
+    direction(NP::Make<float>(NUM, 4))
+{
+    init();
+}
+
+void CSGRayQueryTest::init()
+{
+    const CSGSolid* so = fd->getSolid(0) ;
+    float4 ce = so->center_extent ;
+
+    std::mt19937 rng(1) ;
+    std::normal_distribution<float> norm(0.f, 1.f) ;
+
+    float* oo = origin->values<float>() ;
+    float* dd = direction->values<float>() ;
+    for(int i=0 ; i < NUM ; i++)
+    {
+        float3 d = normalize(make_float3( norm(rng), norm(rng), norm(rng) ));
+        oo[i*4+0] = ce.x ; oo[i*4+1] = ce.y ; oo[i*4+2] = ce.z ; oo[i*4+3] = 1.f ;
+        dd[i*4+0] = d.x  ; dd[i*4+1] = d.y  ; dd[i*4+2] = d.z  ; dd[i*4+3] = 0.f ;
+    }
+    LOG(info) << rq->desc() ;
+}
+
+int CSGRayQueryTest::threads() const
+{
+    int num_thread = rq->num_thread ;
+
+    rq->num_thread = 1 ;
+    NP* a = rq->intersect(origin, direction) ;
+    rq->num_thread = num_thread ;
+    NP* b = rq->intersect(origin, direction) ;
+
+    int rc = int( a == nullptr || b == nullptr ) ;
+    if(rc == 0) rc += int( a->arr_bytes() != b->arr_bytes() || memcmp( a->bytes(), b->bytes(), a->arr_bytes() ) != 0 ) ;
+
+    LOG(info)
+        << " a.num_thread " << ( a ? a->get_meta<int>("num_thread") : -1 )
+        << " b.num_thread " << ( b ? b->get_meta<int>("num_thread") : -1 )
+        << " rc " << rc
+        ;
+    delete a ;
+    delete b ;
+    return rc ;
+}
+
+int CSGRayQueryTest::scaled() const
+{
+    NP* big = NP::MakeCopy(direction) ;
+    float* bb = big->values<float>() ;
+    for(int i=0 ; i < NUM*4 ; i++) bb[i] *= 4.f ;   // power of two scaling keeps normalize bitwise identical
+
+    NP* a = rq->intersect(origin, direction) ;
+    NP* b = rq->intersect(origin, big) ;
+
+    int rc = int( a == nullptr || b == nullptr ) ;
+    if(rc == 0) rc += int( a->arr_bytes() != b->arr_bytes() || memcmp( a->bytes(), b->bytes(), a->arr_bytes() ) != 0 ) ;
+
+    int num_miss = 0 ;
+    int num_miss_identity = 0 ;
+    const quad2* prd = a ? (const quad2*)a->cvalues<float>() : nullptr ;
+    for(int i=0 ; prd && i < NUM ; i++)
+    {
+        if( prd[i].boundary() != CSGRayQuery::MISS_BOUNDARY ) continue ;
+        num_miss += 1 ;
+        num_miss_identity += int( prd[i].identity() == CSGRayQuery::MISS_IDENTITY ) ;
+    }
+    rc += int( num_miss != num_miss_identity ) ;
+
+    LOG(info)
+        << " num_miss " << num_miss
+        << " num_miss_identity " << num_miss_identity
+        << " rc " << rc
+        ;
+    delete a ;
+    delete b ;
+    delete big ;
+    return rc ;
+}
+
+int CSGRayQueryTest::brute() const
+{
+    int NUM_BRUTE = std::min( NUM, ssys::getenvint("NUM_BRUTE", 1000) ) ;
+    const float4* oo = (const float4*)origin->cvalues<float>() ;
+    const float4* dd = (const float4*)direction->cvalues<float>() ;
+
+    int num_hit = 0 ;
+    int num_mismatch = 0 ;
+    for(int i=0 ; i < NUM_BRUTE ; i++)
+    {
+        float3 o = make_float3( oo[i].x, oo[i].y, oo[i].z );
+        float3 d = make_float3( dd[i].x, dd[i].y, dd[i].z );
+
+        quad2 prd ;
+        bool hit = rq->intersect( prd, o, d, 0.f );
+        num_hit += int(hit) ;
+
+        float t_brute = 0.f ;
+        int best = -1 ;
+        for(int j=0 ; j < int(rq->item.size()) ; j++)
+        {
+            float4 isect ;
+            float lposcost ;
+            if(rq->intersect_item( isect, lposcost, rq->item[j], o, d, 0.f ) && ( best == -1 || isect.w < t_brute ))
+            {
+                t_brute = isect.w ;
+                best = j ;
+            }
+        }
+
+        bool match = hit == ( best > -1 ) && ( !hit || prd.q0.f.w == t_brute ) ;
+        if(!match) num_mismatch += 1 ;
+
+        LOG_IF(error, !match)
+            << " i " << i
+            << " hit " << hit
+            << " t " << prd.q0.f.w
+            << " best " << best
+            << " t_brute " << t_brute
+            ;
+    }
+    LOG(info)
+        << " NUM_BRUTE " << NUM_BRUTE
+        << " num_hit " << num_hit
+        << " num_mismatch " << num_mismatch
+        ;
+    return int( num_mismatch > 0 ) ;
+}
+
+int CSGRayQueryTest::bench() const
+{
+    int64_t t0 = sstamp::Now() ;
+    NP* isect = rq->intersect(origin, direction) ;
+    int64_t t1 = sstamp::Now() ;
+    if( isect == nullptr ) return 1 ;
+
+    const quad2* prd = (const quad2*)isect->cvalues<float>() ;
+    int num_miss = 0 ;
+    for(int i=0 ; i < NUM ; i++) if( prd[i].boundary() == CSGRayQuery::MISS_BOUNDARY ) num_miss += 1 ;
+
+    double us = double(t1 - t0) ;
+    LOG(info)
+        << " NUM " << NUM
+        << " num_miss " << num_miss
+        << " num_thread " << isect->get_meta<int>("num_thread")
+        << " time " << us << " us"
+        << " rays/s " << ( us > 0. ? 1e6*NUM/us : 0. )
+        ;
+
+    isect->save(FOLD, "isect.npy");
+    origin->save(FOLD, "origin.npy");
+    direction->save(FOLD, "direction.npy");
+    return 0 ;
+}
+
+int CSGRayQueryTest::run() const
+{
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"threads")==0) rc += threads();
+    if(ALL||strcmp(TEST,"scaled")==0)  rc += scaled();
+    if(ALL||strcmp(TEST,"brute")==0)   rc += brute();
+    if(ALL||strcmp(TEST,"bench")==0)   rc += bench();
+    return rc ;
+}
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+
+    const CSGFoundry* fd = CSGFoundry::Load();   // also loads SSim with the stree
+    if( fd == nullptr ) return 1 ;
+
+    CSGRayQueryTest t(fd) ;
+    return t.run() ;
+}
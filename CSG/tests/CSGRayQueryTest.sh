@@ -0,0 +1,42 @@
+#!/bin/bash
+usage(){ cat << EOU
+CSGRayQueryTest.sh
+====================
+
+Batched host ray intersection with the full CSGFoundry geometry
+specified by GEOM envvar::
+
+   ~/o/CSG/tests/CSGRayQueryTest.sh
+   TEST=bench NUM=1000000 ~/o/CSG/tests/CSGRayQueryTest.sh
+   TEST=brute NUM_BRUTE=100 ~/o/CSG/tests/CSGRayQueryTest.sh
+
+The number of threads is controlled with::
+
+   export CSGRayQuery__NUM_THREAD=8
+
+EOU
+}
+
+source $HOME/.opticks/GEOM/GEOM.sh  # sets GEOM envvar, edit with GEOM bash function
+
+export ${GEOM}_CFBaseFromGEOM=$HOME/.opticks/GEOM/$GEOM
+
+bin=CSGRayQueryTest
+export FOLD=${TMP:-/tmp/$USER/opticks}/$bin
+mkdir -p $FOLD
+
+defarg="info_run"
+arg=${1:-$defarg}
+
+vars="BASH_SOURCE GEOM FOLD bin TEST NUM CSGRayQuery__NUM_THREAD"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 1
+fi
+
+exit 0
@@ -0,0 +1,117 @@
+/**
+CSGSelectionTest.cc
+=====================
+
+Compares the in-place CSGSelection view with the CSGCopy::Select deep copy
+for a sequence of ELV specs, checking the solid mapping, the number of
+enabled prims in each solid and the number of IAS instances.
+Also times both approaches over the sequence.
+
+**/
+
+#include "OPTICKS_LOG.hh"
+#include "ssys.h"
+#include "sstr.h"
+#include "sstamp.h"
+#include "SBitSet.h"
+
+#include "SSim.hh"
+#include "CSGFoundry.h"
+#include "CSGMaker.h"
+#include "CSGCopy.h"
+#include "CSGSelection.h"
+
+int Compare( const CSGFoundry* src, const SBitSet* elv, const CSGSelection* sel )
+{
+    CSGCopy cpy(src, elv);
+    cpy.copy();
+    const CSGFoundry* dst = cpy.dst ;
+
+    int mismatch = 0 ;
+    mismatch += int( dst->getNumSolid() != sel->getNumEnabledSolid() ) ;
+    mismatch += int( dst->getNumPrim() != sel->getNumEnabledPrim() ) ;
+
+    for(unsigned s=0 ; s < sel->num_solid ; s++)
+    {
+        int d = cpy.solidMap[s] ;
+        mismatch += int( d != sel->solid_map[s] ) ;
+        if( d < 0 ) continue ;
+        const CSGSolid* dso = dst->getSolid(d);
+        mismatch += int( unsigned(dso->numPrim) != sel->getNumEnabledPrim(s) ) ;
+    }
+
+    for(unsigned p=0 ; p < sel->num_prim ; p++)
+    {
+        int d = sel->prim_map[p] ;
+        if( d < 0 ) continue ;
+        mismatch += int( dst->getPrim(d)->meshIdx() != src->getPrim(p)->meshIdx() ) ;
+    }
+
+    unsigned long long emm = ~0ull ;
+    unsigned num_ias_dst = dst->getNumInstancesIAS(0, emm) ;
+    unsigned num_ias_sel = src->getNumInstancesIAS(0, emm) ;
+    mismatch += int( num_ias_dst != num_ias_sel ) ;
+
+    LOG(info)
+        << " elv.spec " << ( elv && elv->spec ? elv->spec : "-" )
+        << " dst.solid " << dst->getNumSolid()
+        << " sel.solid " << sel->getNumEnabledSolid()
+        << " dst.prim " << dst->getNumPrim()
+        << " sel.prim " << sel->getNumEnabledPrim()
+        << " num_ias_dst " << num_ias_dst
+        << " num_ias_sel " << num_ias_sel
+        << " dirty " << sel->dirty.size()
+        << " mismatch " << mismatch
+        ;
+
+    delete dst ;
+    return mismatch ;
+}
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+
+    char mode = argc > 1 ? argv[1][0] : 'D' ;
+    SSim::Create();
+
+    CSGFoundry* src = mode == 'D' ? CSGMaker::MakeDemo() : CSGFoundry::Load_() ;
+    LOG_IF(fatal , src == nullptr ) << " NO GEOMETRY " ;
+    if(src == nullptr) return 1 ;
+
+    unsigned num_bits = src->getNumMeshName() ;
+    const char* SPECS = ssys::getenvvar("SPECS", "t,t0,t1,1,t0;1,t") ;
+
+    std::vector<std::string> specs ;
+    sstr::Split(SPECS, ',', specs );
+    std::vector<const SBitSet*> elvs ;
+    for(unsigned i=0 ; i < specs.size() ; i++)
+    {
+        std::string spec = specs[i] ;
+        for(unsigned j=0 ; j < spec.size() ; j++) if(spec[j] == ';') spec[j] = ',' ;
+        elvs.push_back( SBitSet::Create(num_bits, spec.c_str()) );
+    }
+
+    int rc = 0 ;
+    for(unsigned i=0 ; i < elvs.size() ; i++)
+    {
+        src->applySelection(elvs[i]);
+        rc += Compare( src, elvs[i], src->getSelection() ) ;
+    }
+
+    int64_t t0 = sstamp::Now();
+    for(unsigned i=0 ; i < elvs.size() ; i++) delete CSGCopy::Select(src, elvs[i]) ;
+    int64_t t1 = sstamp::Now();
+    for(unsigned i=0 ; i < elvs.size() ; i++) src->applySelection(elvs[i]) ;
+    int64_t t2 = sstamp::Now();
+
+    LOG(info)
+        << " num_spec " << elvs.size()
+        << " CSGCopy::Select(us) " << ( t1 - t0 )
+        << " CSGFoundry::applySelection(us) " << ( t2 - t1 )
+        << " rc " << rc
+        ;
+
+    LOG_IF(fatal, rc != 0 ) << " UNEXPECTED MISMATCH " << src->getSelection()->desc() ;
+    return rc == 0 ? 0 : 1 ;
+}
@@ -557,6 +557,45 @@ void CSGOptiX::initGeometry()
 }
 
 
+/**
+CSGOptiX::applySelection
+--------------------------
+
+CSGOptiX only holds a const CSGFoundry, so the caller passes the
+same foundry as given to CSGOptiX::Create to change its ELV selection
+in-place with CSGFoundry::applySelection, followed by updateSelection.
+Returns the number of solids changed, -1 when the selection is rejected
+(see CSGFoundry::applySelection) in which case nothing is rebuilt.
+
+**/
+
+int CSGOptiX::applySelection(CSGFoundry* fd, const SBitSet* elv)
+{
+    assert( fd == foundry );
+    int num_dirty = fd->applySelection(elv) ;
+    if(num_dirty > -1) updateSelection();
+    return num_dirty ;
+}
+
+/**
+CSGOptiX::updateSelection
+---------------------------
+
+To be called after CSGFoundry::applySelection changes the ELV selection
+of the uploaded geometry, rebuilds the changed acceleration structures
+and updates the top handle without recreating the pipeline or SBT.
+
+**/
+
+void CSGOptiX::updateSelection()
+{
+    LOG(LEVEL) << "[" ;
+    sbt->updateSelection();
+    params->handle = sbt->getTOPHandle() ;
+    LOG(LEVEL) << "]" ;
+}
+
+
 /**
 CSGOptiX::initSimulate
 ------------------------
@@ -29,6 +29,7 @@ struct uchar4 ;
 struct scontext ;
 struct SGLM ;
 struct SSim ;
+struct SBitSet ;
 
 struct CSGFoundry ;
 struct CSGView ;
@@ -138,6 +139,9 @@ private:
     void initFrame();
     void initRender();
     void initPIDXYZ();
+ public:
+    int  applySelection(CSGFoundry* fd, const SBitSet* elv);
+    void updateSelection();
  public:
     void setExternalDevicePixels(uchar4* _d_pixel );
     void destroy();
@@ -22,6 +22,7 @@
 #include "CSGFoundry.h"
 #include "CSGSolid.h"
 #include "CSGNode.h"
+#include "CSGSelection.h"
 
 #include "Binding.h"
 #include "Params.h"
@@ -333,10 +334,13 @@ void SBT::createGAS(unsigned gas_idx)
     if(trimesh)
     {
         // note similarity to SOPTIX_Scene::init_GAS
-        const SMeshGroup* mg = scene->getMeshGroup(gas_idx) ;
+        // simulation LOD is full resolution unless SScene__SIM_LOD_MAX_ERROR permits a simplified level
+        int lod = scene->getSimulationLOD() ;
+        const SMeshGroup* mg = scene->getMeshGroup(gas_idx, lod) ;
         LOG_IF(fatal, mg == nullptr)
             << " FAILED to SScene::getMeshGroup"
             << " gas_idx " << gas_idx
+            << " lod " << lod
             << "\n"
             << scene->desc()
             ;
@@ -457,6 +461,59 @@ void SBT::createIAS(unsigned ias_idx)
 
 
 
+/**
+SBT::updateSelection
+----------------------
+
+Following CSGFoundry::applySelection rebuilds the GAS of the analytic solids
+changed by the selection, listed in CSGSelection::dirty, and then the IAS
+as the selection may have changed which solids have instances.
+The hitgroup records are unchanged as the selection keeps the prim counts
+and sbtIndexOffset, only the prim bounds of the disabled prims are changed.
+Geometries with trimesh solids are rejected by CSGFoundry::applySelection.
+
+After this the caller needs to update the TOP handle, see CSGOptiX::updateSelection
+
+**/
+
+void SBT::updateSelection()
+{
+    const CSGSelection* sel = foundry->getSelection();
+    if(sel == nullptr) return ;
+
+#ifdef WITH_SOPTIX_ACCEL
+    for(unsigned i=0 ; i < sel->dirty.size() ; i++)
+    {
+        unsigned gas_idx = sel->dirty[i] ;
+        if( vgas.count(gas_idx) == 0 ) continue ;      // emm skipped
+        if( xgas.count(gas_idx) == 1 ) continue ;      // trimesh
+
+        SOPTIX_Accel* gas = vgas[gas_idx] ;
+        CUDA_CHECK( cudaFree( (void*)gas->buffer ) );
+        delete gas ;
+
+        SCSGPrimSpec ps = foundry->getPrimSpec(gas_idx);
+        SOPTIX_BuildInput* bi = new SOPTIX_BuildInput_CPA(ps) ;
+        vgas[gas_idx] = SOPTIX_Accel::Create(Ctx::context, bi );
+    }
+
+    for(unsigned i=0 ; i < vias.size() ; i++)
+    {
+        CUDA_CHECK( cudaFree( (void*)vias[i]->buffer ) );
+        delete vias[i] ;
+    }
+    vias.clear();
+    instances.clear();
+    createIAS();
+
+    LOG(LEVEL) << " num_dirty " << sel->dirty.size() << " " << descGAS() ;
+#else
+    LOG(fatal) << " NOT:WITH_SOPTIX_ACCEL does not support selection update " ;
+    assert(0);
+#endif
+}
+
+
 /**
 SBT::collectInstances
 ----------------------
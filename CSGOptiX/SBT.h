@@ -113,6 +113,7 @@ struct SBT
     void createIAS();
     void createIAS(unsigned ias_idx);                             // dep. WITH_SOPTIX_ACCEL
     void collectInstances( const std::vector<qat4>& ias_inst ) ;
+    void updateSelection();                                       // dep. WITH_SOPTIX_ACCEL
     NP* serializeInstances() const ;
     std::string descIAS(const std::vector<qat4>& inst ) const ;
     OptixTraversableHandle getIASHandle(unsigned ias_idx) const ; // dep. WITH_SOPTIX_ACCEL
@@ -0,0 +1,72 @@
+/**
+CSGOptiXSelectionTest : in-place ELV selection changes of uploaded geometry
+=============================================================================
+
+Renders the geometry for a sequence of ELV specs using CSGOptiX::applySelection
+which changes the CSGSelection view of the foundry and rebuilds only the
+changed GAS and the IAS, without recreating the CSGOptiX pipeline or SBT.
+Checks that repeating a selection changes no solids and that each change
+gives a valid top handle.
+
+::
+
+    SPECS=t,t0,t1,t0 CSGOptiXSelectionTest
+
+**/
+
+#include "OPTICKS_LOG.hh"
+#include "ssys.h"
+#include "sstr.h"
+#include "SBitSet.h"
+#include "SEventConfig.hh"
+#include "CSGFoundry.h"
+#include "CSGOptiX.h"
+#include "Params.h"
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+    SEventConfig::SetRGModeRender();
+
+    CSGFoundry* fd = CSGFoundry::Load();
+    LOG_IF(fatal, fd == nullptr) << " NO GEOMETRY " ;
+    if(fd == nullptr) return 1 ;
+    if(fd->hasSolidTrimesh()) return 0 ;    // selection view is analytic only
+
+    CSGOptiX* cx = CSGOptiX::Create(fd) ;
+    cx->render("CSGOptiXSelectionTest_all");
+
+    unsigned num_bits = fd->getNumMeshName() ;
+    const char* SPECS = ssys::getenvvar("SPECS", "t,t0,t0,t1,t") ;
+    std::vector<std::string> specs ;
+    sstr::Split(SPECS, ',', specs );
+
+    int rc = 0 ;
+    std::string prev ;
+    for(unsigned i=0 ; i < specs.size() ; i++)
+    {
+        const std::string& spec = specs[i] ;
+        const SBitSet* elv = SBitSet::Create(num_bits, spec.c_str()) ;
+        int num_dirty = cx->applySelection(fd, elv) ;
+
+        bool repeat = spec == prev ;
+        bool expect = num_dirty > -1 && ( repeat ? num_dirty == 0 : true ) && cx->params->handle != 0 ;
+        if(!expect) rc += 1 ;
+
+        std::string stem = "CSGOptiXSelectionTest_" + std::to_string(i) ;
+        double dt = cx->render(stem.c_str()) ;
+
+        LOG(info)
+            << " spec " << spec
+            << " num_dirty " << num_dirty
+            << " repeat " << repeat
+            << " dt " << dt
+            << " expect " << expect
+            ;
+        prev = spec ;
+    }
+
+    LOG_IF(fatal, rc != 0 ) << " UNEXPECTED selection update rc " << rc ;
+    delete cx ;
+    return rc == 0 ? 0 : 1 ;
+}
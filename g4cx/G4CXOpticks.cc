@@ -12,6 +12,7 @@
 
 #include "U4VolumeMaker.hh"
 #include "U4Recorder.hh"
+#include "U4HitGet.h"
 
 #include "SEventConfig.hh"
 #include "U4GDML.h"
@@ -666,6 +667,9 @@ This SensitiveDetector pair of methods enables rearranging the order::
 Note that the Stepping and Tracking actions handled by
 the U4Recorder can proceed unchanged by this.
 
+The overload with hits argument does the simulate and the hit creation
+in batch, see below.
+
 **/
 
 void G4CXOpticks::SensitiveDetector_EndOfEvent(int eventID)
@@ -678,4 +682,39 @@ void G4CXOpticks::SensitiveDetector_EndOfEvent(int eventID)
     }
 }
 
+/**
+G4CXOpticks::SensitiveDetector_EndOfEvent (with hits)
+--------------------------------------------------------
+
+Completes the rearranged call order described above from
+G4VSensitiveDetector::EndOfEvent, returning the number of hits:
+
+1. U4Recorder::EndOfEventAction_ wraps up the gensteps
+2. simulate without reset so the hits remain available
+3. U4HitGet::FromEvt_Batch converts all hits in parallel via SEvt::getLocalHits :
+   local frame from the cached inverse instance transforms, sensor identity
+   and optional efficiency culling configured on *lh*
+4. reset
+
+This replaces a serial loop over U4HitGet::FromEvt in the sensitive detector,
+which only needs to create its G4 hits from the returned U4Hit.
+
+**/
+
+int G4CXOpticks::SensitiveDetector_EndOfEvent(int eventID, std::vector<U4Hit>& hits, SLocalHit& lh, int num_thread )
+{
+    SensitiveDetector_EndOfEvent(eventID);
+
+    hits.clear();
+    LOG_IF(fatal, NoGPU) << "NoGPU SKIP" ;
+    if(NoGPU) return 0 ;
+
+    simulate(eventID, false);
+    int num_hit = U4HitGet::FromEvt_Batch(hits, lh, SEvt::EGPU, num_thread );
+    reset(eventID);
+
+    LOG(LEVEL) << " eventID " << eventID << " num_hit " << num_hit ;
+    return num_hit ;
+}
+
 
@@ -14,7 +14,11 @@ and that needs the upload of QSim components first ?
 
 **/
 
+#include <vector>
+
 struct U4Tree ;
+struct U4Hit ;
+struct SLocalHit ;
 struct NPFold ;
 struct NP ;
 struct U4SensorIdentifier ;
@@ -94,6 +98,7 @@ public:
 
     void SensitiveDetector_Initialize(int eventID);
     void SensitiveDetector_EndOfEvent(int eventID);
+    int  SensitiveDetector_EndOfEvent(int eventID, std::vector<U4Hit>& hits, SLocalHit& lh, int num_thread=0 );
 
 };
 
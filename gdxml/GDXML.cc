@@ -8,11 +8,14 @@
 #include "GDXMLRead.hh"
 #include "GDXMLWrite.hh"
 #include "GDXML.hh"
+#include "GDXMLStream.hh"
 
+#include "ssys.h"
 #include "SStr.hh"
 #include "SLOG.hh"
 
 const plog::Severity GDXML::LEVEL = SLOG::EnvLevel("GDXML", "DEBUG" ); 
+const bool GDXML::STREAM = ssys::getenvbool(GDXML__STREAM) ; 
 
 /**
 GDXML::Fix
@@ -30,10 +33,21 @@ Instead of doing that its better to have a raw intermediate .gdml
 so the user who is not paying attention can be unaware of the fixup. 
 But file organization is left to the user.  
 
+With envvar GDXML__STREAM the same fixes are applied by GDXMLStream 
+in a single pass with bounded memory, falling back to the DOM 
+when that fails. 
+
 **/
 
 void GDXML::Fix(const char* dstpath, const char* srcpath)  // static
 {
+    if(STREAM)
+    {
+        int rc = GDXMLStream::Fix(dstpath, srcpath); 
+        LOG_IF(error, rc != 0) << " GDXMLStream::Fix FAILED rc " << rc << " falling back to DOM " ; 
+        if(rc == 0) return ; 
+    }
+
     xercesc::XMLPlatformUtils::Initialize();  // HMM: might clash with Geant4 ? 
 
     bool same = strcmp(dstpath, srcpath) == 0 ; 
@@ -22,6 +22,8 @@ struct GDXMLWrite ;
 struct GDXML_API GDXML
 {
     static const plog::Severity LEVEL ; 
+    static constexpr const char* GDXML__STREAM = "GDXML__STREAM" ; 
+    static const bool STREAM ;   // use GDXMLStream single pass fix-up rather than the DOM
     static void Fix(const char* dstpath, const char* srcpath); 
 
     GDXML(const char* srcpath) ; 
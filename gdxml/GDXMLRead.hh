@@ -66,7 +66,7 @@ struct GDXML_API GDXMLRead
 
 
     void KludgeTruncatedMatrix(xercesc::DOMElement* matrixElement );
-    std::string KludgeFix( const char* values );
+    static std::string KludgeFix( const char* values );
 
 
 };
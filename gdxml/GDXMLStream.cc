@@ -0,0 +1,525 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <csignal>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "GDXMLStream.hh"
+#include "GDXMLRead.hh"
+#include "GDXMLWrite.hh"
+
+#include "ssys.h"
+#include "sparallel.h"
+#include "SStr.hh"
+#include "SLOG.hh"
+
+const plog::Severity GDXMLStream::LEVEL = SLOG::EnvLevel("GDXMLStream", "DEBUG") ;
+
+static inline bool IsSpace(char c){ return c == ' ' || c == '\t' || c == '\n' || c == '\r' ; }
+
+/**
+GDXMLStream::Fix
+------------------
+
+Streaming equivalent of GDXML::Fix, also writing the _gdxml_report.txt
+Returns non-zero when the source cannot be read or the destination written.
+
+**/
+
+int GDXMLStream::Fix(const char* dstpath, const char* srcpath) // static
+{
+    bool same = strcmp(dstpath, srcpath) == 0 ;
+    bool expect = same == false ;
+    assert(expect);
+    if(!expect) std::raise(SIGINT);
+
+    std::ifstream in(srcpath, std::ios::in|std::ios::binary) ;
+    if(in.fail()) LOG(fatal) << "FAILED to open srcpath " << srcpath ;
+    if(in.fail()) return 1 ;
+
+    std::ofstream out(dstpath, std::ios::out|std::ios::binary) ;
+    if(out.fail()) LOG(fatal) << "FAILED to open dstpath " << dstpath ;
+    if(out.fail()) return 2 ;
+
+    auto t0 = std::chrono::steady_clock::now() ;
+    GDXMLStream gs(in, out) ;
+    int rc = gs.run() ;
+    out.close();
+    auto t1 = std::chrono::steady_clock::now() ;
+
+    std::string rep = gs.desc() ;
+    const char* txtpath = SStr::ReplaceEnd(dstpath, ".gdml", "_gdxml_report.txt" );
+    SStr::Save(txtpath, rep.c_str() );
+
+    LOG(LEVEL)
+        << " srcpath " << srcpath
+        << " dstpath " << dstpath
+        << " seconds " << std::chrono::duration<double>(t1 - t0).count()
+        << std::endl
+        << rep
+        ;
+    return rc == 0 && out.good() ? 0 : 3 ;
+}
+
+/**
+GDXMLStream::AttributeSpan
+----------------------------
+
+Finds the offsets of the raw (not entity decoded) value of attribute
+*key* within the start tag markup *tag*.
+
+**/
+
+bool GDXMLStream::AttributeSpan(const std::string& tag, const char* key, size_t& v0, size_t& v1) // static
+{
+    size_t p = 1 ;
+    size_t n = tag.size() ;
+    while( p < n && !IsSpace(tag[p]) && tag[p] != '>' && tag[p] != '/' ) p++ ;   // skip tag name
+    size_t klen = strlen(key) ;
+
+    while( p < n )
+    {
+        while( p < n && IsSpace(tag[p]) ) p++ ;
+        size_t a0 = p ;
+        while( p < n && tag[p] != '=' && !IsSpace(tag[p]) && tag[p] != '>' && tag[p] != '/' ) p++ ;
+        size_t a1 = p ;
+        while( p < n && IsSpace(tag[p]) ) p++ ;
+        if( p >= n || tag[p] != '=' ) return false ;
+        p++ ;
+        while( p < n && IsSpace(tag[p]) ) p++ ;
+        if( p >= n || ( tag[p] != '"' && tag[p] != '\'' )) return false ;
+        char q = tag[p++] ;
+        v0 = p ;
+        while( p < n && tag[p] != q ) p++ ;
+        if( p >= n ) return false ;
+        v1 = p++ ;
+        if( a1 - a0 == klen && tag.compare(a0, klen, key) == 0 ) return true ;
+    }
+    return false ;
+}
+
+bool GDXMLStream::Attribute(std::string& value, const std::string& tag, const char* key) // static
+{
+    size_t v0, v1 ;
+    if(!AttributeSpan(tag, key, v0, v1)) return false ;
+    value.assign(tag, v0, v1 - v0) ;
+    return true ;
+}
+
+bool GDXMLStream::SetAttribute(std::string& tag, const char* key, const std::string& value) // static
+{
+    size_t v0, v1 ;
+    if(!AttributeSpan(tag, key, v0, v1)) return false ;
+    tag.replace(v0, v1 - v0, value) ;
+    return true ;
+}
+
+std::string GDXMLStream::TagName(const std::string& tag) // static
+{
+    size_t p = tag.size() > 1 && tag[1] == '/' ? 2 : 1 ;
+    size_t q = p ;
+    while( q < tag.size() && !IsSpace(tag[q]) && tag[q] != '>' && tag[q] != '/' ) q++ ;
+    return tag.substr(p, q - p) ;
+}
+
+/**
+GDXMLStream::CountValues
+--------------------------
+
+Matches the std::getline space delimited split of GDXMLRead::MatrixRead
+after the XML attribute value normalization of whitespace done by Xerces.
+
+**/
+
+unsigned GDXMLStream::CountValues(const std::string& values) // static
+{
+    if(values.empty()) return 0 ;
+    unsigned count = 1 ;
+    for(size_t i=0 ; i < values.size() ; i++) if(IsSpace(values[i])) count += 1 ;
+    if(IsSpace(values.back())) count -= 1 ;
+    return count ;
+}
+
+
+GDXMLStream::GDXMLStream(std::istream& in_, std::ostream& out_, bool kludge_truncated_matrix_, int num_thread_, size_t batch_bytes_ )
+    :
+    in(in_),
+    out(out_),
+    kludge_truncated_matrix(kludge_truncated_matrix_),
+    num_thread(num_thread_),
+    batch_bytes(batch_bytes_ > 0 ? batch_bytes_ : ssys::getenvint(GDXMLStream__BATCH_BYTES, 64*1024*1024)),
+    buf(4*1024*1024),
+    buf_pos(0),
+    buf_len(0),
+    batch_size(0),
+    num_matrix(0),
+    num_duplicated_matrix(0),
+    num_truncated_matrix(0),
+    num_constants(0),
+    num_batch(0),
+    bytes_in(0)
+{
+}
+
+int GDXMLStream::get()
+{
+    if( buf_pos == buf_len )
+    {
+        in.read(buf.data(), buf.size()) ;
+        buf_len = in.gcount() ;
+        buf_pos = 0 ;
+        if( buf_len == 0 ) return -1 ;
+    }
+    return (unsigned char)buf[buf_pos++] ;
+}
+
+int GDXMLStream::peek()
+{
+    int c = get() ;
+    if( c > -1 ) buf_pos-- ;
+    return c ;
+}
+
+/**
+GDXMLStream::read_until
+-------------------------
+
+Appends to *tok* up to and including the terminator *term*,
+using memchr on the last char of the terminator across the buffer.
+
+**/
+
+void GDXMLStream::read_until(std::string& tok, const char* term)
+{
+    size_t n = strlen(term) ;
+    char last = term[n-1] ;
+    while( peek() > -1 )
+    {
+        const char* b = buf.data() + buf_pos ;
+        size_t len = buf_len - buf_pos ;
+        const char* p = (const char*)memchr(b, last, len) ;
+        size_t take = p ? p - b + 1 : len ;
+        tok.append(b, take) ;
+        buf_pos += take ;
+        if( p && tok.size() >= n && tok.compare(tok.size() - n, n, term) == 0 ) return ;
+    }
+}
+
+/**
+GDXMLStream::next
+-------------------
+
+Reads the next markup token or text run into *tok* returning its kind.
+Tags are read to the first '>' outside quoted attribute values.
+
+**/
+
+int GDXMLStream::next(std::string& tok)
+{
+    tok.clear() ;
+    int c = peek() ;
+    if( c < 0 ) return DONE ;
+
+    if( c != '<' )
+    {
+        while( peek() > -1 )
+        {
+            const char* b = buf.data() + buf_pos ;
+            size_t len = buf_len - buf_pos ;
+            const char* p = (const char*)memchr(b, '<', len) ;
+            size_t take = p ? p - b : len ;
+            tok.append(b, take) ;
+            buf_pos += take ;
+            if( p ) break ;
+        }
+        return TEXT ;
+    }
+
+    tok += char(get()) ;
+    c = peek() ;
+    if( c == '?' )
+    {
+        read_until(tok, "?>") ;
+        return OTHER ;
+    }
+    if( c == '!' )
+    {
+        tok += char(get()) ;
+        if( peek() == '-' )
+        {
+            read_until(tok, "-->") ;
+            return OTHER ;
+        }
+        if( peek() == '[' )
+        {
+            read_until(tok, "]]>") ;
+            return OTHER ;
+        }
+        int bracket = 0 ;          // DOCTYPE with possible internal subset
+        while( (c = get()) > -1 )
+        {
+            tok += char(c) ;
+            if( c == '[' ) bracket++ ;
+            if( c == ']' ) bracket-- ;
+            if( c == '>' && bracket == 0 ) break ;
+        }
+        return OTHER ;
+    }
+
+    char q = 0 ;
+    bool closed = false ;
+    while( !closed && peek() > -1 )
+    {
+        const char* b = buf.data() + buf_pos ;
+        size_t len = buf_len - buf_pos ;
+        size_t i = 0 ;
+        for( ; i < len ; i++ )
+        {
+            char ch = b[i] ;
+            if( q ) { if( ch == q ) q = 0 ; continue ; }
+            if( ch == '"' || ch == '\'' ) { q = ch ; continue ; }
+            if( ch == '>' ) { closed = true ; i++ ; break ; }
+        }
+        tok.append(b, i) ;
+        buf_pos += i ;
+    }
+    if( tok.size() > 1 && tok[1] == '/' ) return END ;
+    if( tok.size() > 1 && tok[tok.size()-2] == '/' ) return EMPTY ;
+    return START ;
+}
+
+/**
+GDXMLStream::run
+------------------
+
+Everything outside define is copied straight through.
+
+**/
+
+int GDXMLStream::run()
+{
+    std::string tok ;
+    std::string ws ;
+    bool in_define = false ;
+    int kind ;
+
+    while( (kind = next(tok)) != DONE )
+    {
+        bytes_in += tok.size() ;
+        if(!in_define)
+        {
+            out << tok ;
+            if( kind == START && TagName(tok) == "define" ) in_define = true ;
+            continue ;
+        }
+
+        if( kind == TEXT && tok.find_first_not_of(" \t\r\n") == std::string::npos )
+        {
+            ws += tok ;
+            continue ;
+        }
+
+        if( kind == END && TagName(tok) == "define" )
+        {
+            flush_batch() ;
+            emit_constants() ;
+            out << ws << tok ;
+            ws.clear() ;
+            in_define = false ;
+            continue ;
+        }
+
+        if( kind == START ) element(tok, kind) ;
+
+        Item item = {} ;
+        item.ws = ws ;
+        item.tag = tok ;
+        std::string name = kind == START || kind == EMPTY ? TagName(tok) : "" ;
+        item.matrix = name == "matrix" ;
+        item.constant = name == "constant" ;
+        ws.clear() ;
+        add_item(item) ;
+    }
+    flush_batch() ;
+    out << ws ;
+
+    bool ok = !in_define && !in.bad() ;
+    LOG_IF(error, !ok) << " UNEXPECTED end of input within define or read error " ;
+    return ok ? 0 : 1 ;
+}
+
+/**
+GDXMLStream::element
+----------------------
+
+Appends the content and end tag of a non-empty element to *tok*.
+
+**/
+
+void GDXMLStream::element(std::string& tok, int kind)
+{
+    assert( kind == START );
+    int depth = 1 ;
+    std::string t ;
+    int k ;
+    while( depth > 0 && (k = next(t)) != DONE )
+    {
+        bytes_in += t.size() ;
+        tok += t ;
+        if( k == START ) depth++ ;
+        if( k == END ) depth-- ;
+    }
+}
+
+void GDXMLStream::add_item(Item& item)
+{
+    if( ( item.matrix || item.constant ) && child_ws.empty() ) child_ws = item.ws ;
+    batch_size += item.tag.size() ;
+    batch.push_back(std::move(item)) ;
+    if( batch_size > batch_bytes ) flush_batch() ;
+}
+
+/**
+GDXMLStream::process
+----------------------
+
+Parses and checks a single matrix or constant element, invoked in parallel.
+item.values retains the original values for the duplicate check,
+as in GDXMLRead::MatrixRead.
+
+**/
+
+void GDXMLStream::process(Item& item) const
+{
+    if( item.constant )
+    {
+        Attribute(item.name, item.tag, "name") ;
+        Attribute(item.values, item.tag, "value") ;
+        return ;
+    }
+    if( !item.matrix ) return ;
+
+    Attribute(item.name, item.tag, "name") ;
+    Attribute(item.values, item.tag, "values") ;
+
+    unsigned num_values = CountValues(item.values) ;
+    item.truncated = item.values.length() >= 9999 || num_values % 2 != 0 ;
+    if( item.truncated && kludge_truncated_matrix )
+    {
+        std::string norm(item.values) ;
+        for(size_t i=0 ; i < norm.size() ; i++) if(IsSpace(norm[i])) norm[i] = ' ' ;
+        std::string kludged = GDXMLRead::KludgeFix(norm.c_str()) ;
+        SetAttribute(item.tag, "values", kludged) ;
+    }
+}
+
+/**
+GDXMLStream::flush_batch
+--------------------------
+
+Parallel parse of the matrix and constant elements of the batch
+followed by serial in order duplicate pruning and emission.
+The number of threads is from sparallel::NumThreadEnv with a minimum
+of one element per thread as each element parse is a sizable job,
+the threads take elements dynamically as the matrix sizes vary.
+
+**/
+
+void GDXMLStream::flush_batch()
+{
+    if( batch.empty() ) return ;
+
+    int nt = sparallel::NumThreadEnv( batch.size(), GDXMLStream__NUM_THREAD, num_thread, 1 ) ;
+    std::atomic<size_t> cursor(0) ;
+    sparallel::For(nt, nt, [this, &cursor](int, int, int)
+        {
+            size_t i ;
+            while( (i = cursor.fetch_add(1)) < batch.size() ) process(batch[i]) ;
+        });
+
+    std::hash<std::string> hasher ;
+    for(size_t i=0 ; i < batch.size() ; i++)
+    {
+        const Item& item = batch[i] ;
+        if( item.constant )
+        {
+            std::istringstream iss(item.values) ;
+            double value = 0. ;
+            iss >> value ;
+            constants.push_back( std::make_pair(item.name, value) ) ;
+            num_constants += 1 ;
+            continue ;
+        }
+        if( item.matrix )
+        {
+            num_matrix += 1 ;
+            if( item.truncated ) num_truncated_matrix += 1 ;
+            size_t h = hasher(item.values) ;
+            auto it = matrix_hash.find(item.name) ;
+            if( it != matrix_hash.end() )
+            {
+                bool expect = it->second == h ;
+                LOG_IF(fatal, !expect) << " duplicated matrix name with different values " << item.name ;
+                assert(expect) ;
+                if(!expect) std::raise(SIGINT);
+                LOG(LEVEL) << "pruning duplicated matrix " << item.name ;
+                num_duplicated_matrix += 1 ;
+                continue ;
+            }
+            matrix_hash[item.name] = h ;
+        }
+        out << item.ws << item.tag ;
+    }
+
+    num_batch += 1 ;
+    batch.clear() ;
+    batch_size = 0 ;
+}
+
+/**
+GDXMLStream::emit_constants
+-----------------------------
+
+Same replacement matrix as GDXML::replaceAllConstantWithMatrix
+
+**/
+
+void GDXMLStream::emit_constants()
+{
+    double nm_lo = 80. ;
+    double nm_hi = 800. ;
+    std::string ws = child_ws.empty() ? "\n" : child_ws ;
+    for(size_t i=0 ; i < constants.size() ; i++)
+    {
+        const std::string& name = constants[i].first ;
+        double value = constants[i].second ;
+        LOG(LEVEL) << " name " << std::setw(20) << name << " value " << std::setw(10) << value ;
+        std::string values = GDXMLWrite::ConstantToMatrixValues(value, nm_lo, nm_hi) ;
+        out << ws << "<matrix coldim=\"2\" name=\"" << name << "\" values=\"" << values << "\"/>" ;
+    }
+    constants.clear() ;
+}
+
+std::string GDXMLStream::desc() const
+{
+    std::stringstream ss ;
+    ss << "GDXMLStream::desc" << std::endl
+       << " bytes_in " << bytes_in << std::endl
+       << " num_thread " << num_thread << std::endl
+       << " batch_bytes " << batch_bytes << std::endl
+       << " num_batch " << num_batch << std::endl
+       << " num_matrix " << num_matrix << std::endl
+       << " num_duplicated_matrixElement " << num_duplicated_matrix << std::endl
+       << " num_pruned_matrixElement " << num_duplicated_matrix << std::endl
+       << " num_truncated_matrixElement " << num_truncated_matrix << std::endl
+       << " num_constants " << num_constants << std::endl
+       << " issues " << ( num_truncated_matrix > 0 || num_constants > 0 ? "YES" : "NO" ) << std::endl
+       ;
+    std::string s = ss.str();
+    return s ;
+}
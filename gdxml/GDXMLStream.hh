@@ -0,0 +1,107 @@
+#pragma once
+/**
+GDXMLStream.hh
+================
+
+Streaming alternative to the Xerces DOM based GDXML fix-up.
+GDXMLRead/GDXMLWrite parse the entire GDML into a DOM, apply the fix-ups
+and serialize it again, all on one thread and with memory proportional
+to the file. With detector GDML of hundreds of MB of inlined matrices
+that dominates the time before Geant4 parsing starts.
+
+GDXMLStream instead makes a single SAX-like pass over the markup tokens,
+copying everything verbatim apart from children of the define element
+where it applies the same fix-ups as the DOM route:
+
+1. constant elements are removed and replaced with two point matrix
+   elements appended at the end of define, see GDXMLWrite::ConstantToMatrixValues
+2. matrix elements with a name already seen are pruned
+3. matrix values that look truncated (length >= 9999 or odd number
+   of values) are trimmed with GDXMLRead::KludgeFix
+
+Define children are gathered into batches bounded by *batch_bytes*
+(envvar GDXMLStream__BATCH_BYTES, default 64MB) and the matrix elements
+of each batch are parsed and checked by *num_thread* sparallel.h threads
+(envvar GDXMLStream__NUM_THREAD, default hardware concurrency) before
+being emitted in order. So memory is bounded by the batch size rather
+than the file size.
+
+Select this route for GDXML::Fix with envvar GDXML__STREAM.
+
+**/
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+
+#include "plog/Severity.h"
+#include "GDXML_API_EXPORT.hh"
+
+struct GDXML_API GDXMLStream
+{
+    static const plog::Severity LEVEL ;
+    static constexpr const char* GDXMLStream__BATCH_BYTES = "GDXMLStream__BATCH_BYTES" ;
+    static constexpr const char* GDXMLStream__NUM_THREAD = "GDXMLStream__NUM_THREAD" ;
+
+    enum { TEXT, START, END, EMPTY, OTHER, DONE } ;
+
+    struct Item
+    {
+        std::string ws ;      // whitespace text preceding the element
+        std::string tag ;     // full markup, possibly with content and end tag
+        std::string name ;    // of matrix or constant
+        std::string values ;  // of matrix, possibly kludged
+        bool        matrix ;
+        bool        constant ;
+        bool        truncated ;
+    };
+
+    static int Fix(const char* dstpath, const char* srcpath);
+
+    static bool AttributeSpan(const std::string& tag, const char* key, size_t& v0, size_t& v1);
+    static bool Attribute(std::string& value, const std::string& tag, const char* key);
+    static bool SetAttribute(std::string& tag, const char* key, const std::string& value);
+    static std::string TagName(const std::string& tag);
+    static unsigned CountValues(const std::string& values);
+
+    std::istream&  in ;
+    std::ostream&  out ;
+    bool           kludge_truncated_matrix ;
+    int            num_thread ;
+    size_t         batch_bytes ;
+
+    std::vector<char> buf ;
+    size_t            buf_pos ;
+    size_t            buf_len ;
+
+    std::vector<Item> batch ;
+    size_t            batch_size ;
+    std::unordered_map<std::string, size_t> matrix_hash ;
+    std::vector<std::pair<std::string,double>> constants ;
+    std::string       child_ws ;
+
+    unsigned num_matrix ;
+    unsigned num_duplicated_matrix ;
+    unsigned num_truncated_matrix ;
+    unsigned num_constants ;
+    unsigned num_batch ;
+    size_t   bytes_in ;
+
+    GDXMLStream(std::istream& in, std::ostream& out, bool kludge_truncated_matrix=true, int num_thread=0, size_t batch_bytes=0 );
+
+    int  get();
+    int  peek();
+    int  next(std::string& tok);
+    void read_until(std::string& tok, const char* term);
+
+    int  run();
+    void element(std::string& tok, int kind);
+    void add_item(Item& item);
+    void flush_batch();
+    void process(Item& item) const ;
+    void emit_constants();
+
+    std::string desc() const ;
+};
@@ -20,7 +20,7 @@ struct GDXML_API GDXMLWrite
 
     xercesc::DOMElement* NewElement(const char* tagname);
     xercesc::DOMAttr*    NewAttribute(const char* name, const char* value);
-    std::string          ConstantToMatrixValues(double value, double nm_lo, double nm_hi);  
+    static std::string   ConstantToMatrixValues(double value, double nm_lo, double nm_hi);  
     xercesc::DOMElement* ConstantToMatrixElement(const char* name, double value, double nm_lo, double nm_hi ); 
 
 
@@ -0,0 +1,131 @@
+/**
+GDXMLStreamTest.cc
+=====================
+
+Generates a GDML with many inlined matrices together with constants,
+duplicated matrix names and truncated matrix values, then applies the
+fix-ups with the Xerces DOM route GDXML and the single pass GDXMLStream
+with one and with all threads. The outputs are read back with GDXMLRead
+and compared : same matrix names and values in the same order
+and no constants.
+
+::
+
+    GDXMLStreamTest                                      # default 20000 matrix of 200 pairs
+    GDXMLStreamTest__NUM_MATRIX=100000 GDXMLStreamTest   # ~400MB for benchmarking
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+
+#include "OPTICKS_LOG.hh"
+#include "ssys.h"
+#include "sparallel.h"
+#include "spath.h"
+#include "sdirectory.h"
+#include "GDXML.hh"
+#include "GDXMLRead.hh"
+#include "GDXMLStream.hh"
+
+struct GDXMLStreamTest
+{
+    static void Generate(const char* path, int num_matrix, int num_pair);
+    static int Compare(const char* a, const char* b);
+    static double Time(const char* dst, const char* src, int mode);
+};
+
+inline void GDXMLStreamTest::Generate(const char* path, int num_matrix, int num_pair)
+{
+    std::ofstream fp(path) ;
+    fp << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\" ?>\n"
+       << "<gdml xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">\n"
+       << "  <define>\n"
+       << "    <constant name=\"SCINTILLATIONYIELD0x1\" value=\"11522\"/>\n"
+       ;
+    for(int i=0 ; i < num_matrix ; i++)
+    {
+        int dupe = i % 100 == 99 ? i - 1 : i ;        // repeated name with same values
+        bool truncate = i % 1000 == 7 ;               // odd number of values
+        fp << "    <matrix coldim=\"2\" name=\"PROP" << dupe << "0x" << std::hex << ( 0x5f000 + dupe ) << std::dec << "\" values=\"" ;
+        for(int j=0 ; j < num_pair ; j++) fp << ( j > 0 ? " " : "" ) << 1.5e-6 + j*1e-8 << " " << 1.4 + 0.001*( (dupe + j) % 100 ) ;
+        if(truncate) fp << " 1.6e-05" ;
+        fp << "\"/>\n" ;
+        if( i == num_matrix/2 ) fp << "    <constant name=\"TIMECONSTANT0x2\" value=\"1.4\"/>\n" ;
+    }
+    fp << "  </define>\n"
+       << "  <materials/>\n"
+       << "</gdml>\n"
+       ;
+}
+
+inline int GDXMLStreamTest::Compare(const char* a, const char* b)
+{
+    GDXMLRead ra(a, false) ;
+    GDXMLRead rb(b, false) ;
+    int mismatch = 0 ;
+    mismatch += int( ra.matrix.size() != rb.matrix.size() ) ;
+    mismatch += int( ra.constants.size() != 0 || rb.constants.size() != 0 ) ;
+    for(unsigned i=0 ; i < std::min(ra.matrix.size(), rb.matrix.size()) ; i++)
+    {
+        const Matrix& ma = ra.matrix[i] ;
+        const Matrix& mb = rb.matrix[i] ;
+        mismatch += int( ma.name != mb.name || ma.values != mb.values ) ;
+    }
+    LOG(info)
+        << " a " << a
+        << " b " << b
+        << " num_matrix " << ra.matrix.size() << " " << rb.matrix.size()
+        << " mismatch " << mismatch
+        ;
+    return mismatch ;
+}
+
+inline double GDXMLStreamTest::Time(const char* dst, const char* src, int mode)
+{
+    auto t0 = std::chrono::steady_clock::now() ;
+    if( mode == 0 ) GDXML::Fix(dst, src) ;
+    if( mode > 0 ) setenv(GDXMLStream::GDXMLStream__NUM_THREAD, std::to_string(mode).c_str(), 1) ;
+    if( mode > 0 ) GDXMLStream::Fix(dst, src) ;
+    auto t1 = std::chrono::steady_clock::now() ;
+    return std::chrono::duration<double>(t1 - t0).count() ;
+}
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+
+    int num_matrix = ssys::getenvint("GDXMLStreamTest__NUM_MATRIX", 20000) ;
+    int num_pair = ssys::getenvint("GDXMLStreamTest__NUM_PAIR", 200) ;
+    const char* fold = spath::Resolve("$TMP/GDXMLStreamTest") ;
+    sdirectory::MakeDirs(fold, 0);
+
+    std::string src = std::string(fold) + "/big.gdml" ;
+    std::string dom = std::string(fold) + "/big_dom.gdml" ;
+    std::string st1 = std::string(fold) + "/big_stream1.gdml" ;
+    std::string stn = std::string(fold) + "/big_streamN.gdml" ;
+
+    Generate(src.c_str(), num_matrix, num_pair);
+
+    int nt = sparallel::NumThread(num_matrix, 0, 1) ;
+    double t_dom = Time(dom.c_str(), src.c_str(), 0) ;
+    double t_st1 = Time(st1.c_str(), src.c_str(), 1) ;
+    double t_stn = Time(stn.c_str(), src.c_str(), nt) ;
+
+    int rc = 0 ;
+    rc += Compare(dom.c_str(), st1.c_str()) ;
+    rc += Compare(dom.c_str(), stn.c_str()) ;
+
+    LOG(info)
+        << " num_matrix " << num_matrix
+        << " num_pair " << num_pair
+        << " dom " << std::fixed << std::setprecision(3) << t_dom
+        << " stream(1) " << t_st1
+        << " stream(" << nt << ") " << t_stn
+        << " rc " << rc
+        ;
+    return rc == 0 ? 0 : 1 ;
+}
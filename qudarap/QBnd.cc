@@ -6,6 +6,7 @@
 
 #include "SBnd.h"
 #include "NP.hh"
+#include "ssys.h"
 #include "NPFold.h"
 
 #include "scuda.h"
@@ -34,12 +35,15 @@ const plog::Severity QBnd::LEVEL = SLOG::EnvLevel("QBnd", "DEBUG");
 
 const QBnd* QBnd::INSTANCE = nullptr ; 
 const QBnd* QBnd::Get(){ return INSTANCE ; }
+const bool QBnd::DEDUP = ssys::getenvbool(QBnd__DEDUP) ; 
 
 /**
 QBnd::MakeInstance
 ---------------------
 
-static method used from QBnd::QBnd using the bnd array spec names
+static method used from QBnd::QBnd using the bnd array spec names.
+The tex is nullptr with the deduplicated layout, in which case the 
+material and surface textures are set by QBnd::initDedup
 
 **/
 
@@ -47,8 +51,15 @@ qbnd* QBnd::MakeInstance(const QTex<float4>* tex, const std::vector<std::string>
 {
     qbnd* qb = new qbnd ; 
 
-    qb->boundary_tex = tex->texObj ; 
-    qb->boundary_meta = tex->d_meta ; 
+    qb->boundary_tex = tex ? tex->texObj : 0 ; 
+    qb->boundary_meta = tex ? tex->d_meta : nullptr ; 
+    qb->material_tex = 0 ; 
+    qb->material_meta = nullptr ; 
+    qb->surface_tex = 0 ; 
+    qb->surface_meta = nullptr ; 
+    qb->boundary_index = nullptr ; 
+    qb->domain_remap = nullptr ; 
+    qb->domain_remap_num = 0 ; 
     qb->boundary_tex_MaterialLine_Water = SBnd::GetMaterialLine("Water", names) ; 
     qb->boundary_tex_MaterialLine_LS    = SBnd::GetMaterialLine("LS", names) ; 
 
@@ -63,7 +74,7 @@ qbnd* QBnd::MakeInstance(const QTex<float4>* tex, const std::vector<std::string>
     qb->optical = optical ? optical->d_optical : nullptr ; 
 
     assert( qb->optical != nullptr ); 
-    assert( qb->boundary_meta != nullptr ); 
+    assert( tex == nullptr || qb->boundary_meta != nullptr ); 
     return qb ; 
 }
 
@@ -73,15 +84,27 @@ QBnd::QBnd
 ------------
 
 Narrows the NP array if wide and creates GPU texture 
+or with dedup the material and surface textures
 
 **/
 
-QBnd::QBnd(const NP* buf)
+QBnd::QBnd(const NP* buf, bool dedup_, const NP* remap_)
     :
     dsrc(buf->ebyte == 8 ? buf : nullptr),
     src(NP::MakeNarrowIfWide(buf)),
     sbn(new SBnd(src)),
-    tex(MakeBoundaryTex(src)),
+    dedup(dedup_),
+    width(src->shape[3]),
+    height(src->shape[0]*src->shape[1]*src->shape[2]),
+    tex(dedup ? nullptr : MakeBoundaryTex(src)),
+    umat(nullptr),
+    usur(nullptr),
+    bidx(nullptr),
+    mtex(nullptr),
+    stex(nullptr),
+    d_bidx(nullptr),
+    remap(remap_),
+    d_remap(nullptr),
     qb(MakeInstance(tex, buf->names)),
     d_qb(nullptr)
 {
@@ -91,6 +114,8 @@ QBnd::QBnd(const NP* buf)
 void QBnd::init()
 {
     INSTANCE = this ; 
+    if(dedup) initDedup(); 
+    if(remap) initRemap(); 
 #if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
     d_qb = qb ;  
 #else
@@ -99,6 +124,81 @@ void QBnd::init()
 }
 
 
+/**
+QBnd::initDedup
+-----------------
+
+Splits src into unique material and surface payloads with a (num_bnd, 4)
+index using SBnd::Dedup, uploads them and points qbnd at them so that
+qbnd::boundary_lookup resolves lines via the index. 
+
+**/
+
+void QBnd::initDedup()
+{
+    SBnd::Dedup( umat, usur, bidx, src ); 
+    mtex = MakeBoundaryTex(umat) ; 
+    stex = MakeBoundaryTex(usur) ; 
+
+#if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
+    d_bidx = bidx->values<int>() ; 
+#else
+    d_bidx = QU::UploadArray<int>(bidx->cvalues<int>(), bidx->num_values(), "QBnd::initDedup/d_bidx") ; 
+    LOG(LEVEL) << SBnd::DescDedup(src, umat, usur, bidx) ; 
+#endif
+
+    qb->material_tex = mtex->texObj ; 
+    qb->material_meta = mtex->d_meta ; 
+    qb->surface_tex = stex->texObj ; 
+    qb->surface_meta = stex->d_meta ; 
+    qb->boundary_index = d_bidx ; 
+}
+
+/**
+QBnd::initRemap
+-----------------
+
+Uploads the remap for a bnd on the non-uniform domain. 
+The bnd domain_step metadata is the remap base step. 
+
+**/
+
+void QBnd::initRemap()
+{
+    assert( remap->uifc == 'f' && remap->ebyte == 4 && remap->shape.size() == 1 ); 
+    int domain_remap = src->get_meta<int>("domain_remap", 0) ; 
+    bool remap_expect = domain_remap == remap->shape[0] ; 
+    assert( remap_expect ); 
+    if(!remap_expect) std::raise(SIGINT); 
+
+#if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
+    d_remap = const_cast<NP*>(remap)->values<float>() ; 
+#else
+    d_remap = QU::UploadArray<float>(remap->cvalues<float>(), remap->num_values(), "QBnd::initRemap/d_remap") ; 
+#endif
+    qb->domain_remap = d_remap ; 
+    qb->domain_remap_num = remap->shape[0] ; 
+}
+
+/**
+QBnd::tex_bytes
+-----------------
+
+Bytes of texture memory, plus the index with dedup 
+
+**/
+
+size_t QBnd::tex_bytes() const 
+{
+    size_t sz = 0 ; 
+    if(tex)  sz += tex->width*tex->height*sizeof(float4) ; 
+    if(mtex) sz += mtex->width*mtex->height*sizeof(float4) ; 
+    if(stex) sz += stex->width*stex->height*sizeof(float4) ; 
+    if(bidx) sz += bidx->arr_bytes() ; 
+    if(remap) sz += remap->arr_bytes() ; 
+    return sz ; 
+}
+
 /**
 QBnd::MakeBoundaryTex
 ------------------------
@@ -122,6 +222,8 @@ Example of mapping from 5D array of floats into 2D texture of float4::
 
          nx*ny = 11232
 
+The 4D SBnd::Dedup umat and usur arrays (num_umat, 2, 761, 4) are 
+mapped in the same way with ny = num_umat*2 
 
 TODO: need to get boundary domain range metadata into buffer json sidecar and get it uploaded with the tex
 
@@ -130,12 +232,14 @@ TODO: need to get boundary domain range metadata into buffer json sidecar and ge
 QTex<float4>* QBnd::MakeBoundaryTex(const NP* buf )   // static 
 {
     assert( buf->uifc == 'f' && buf->ebyte == 4 );  
+    unsigned nd = buf->shape.size() ; 
+    assert( nd == 5 || nd == 4 ); 
 
-    unsigned ni = buf->shape[0];  // (~123) number of boundaries 
-    unsigned nj = buf->shape[1];  // (4)    number of species : omat/osur/isur/imat 
-    unsigned nk = buf->shape[2];  // (2)    number of float4 property groups per species 
-    unsigned nl = buf->shape[3];  // (39 or 761)   number of wavelength samples of the property
-    unsigned nm = buf->shape[4];  // (4)    number of prop within the float4
+    unsigned ni = buf->shape[0];        // (~123) number of boundaries  (or unique materials/surfaces)
+    unsigned nj = nd == 5 ? buf->shape[1] : 1 ;  // (4)    number of species : omat/osur/isur/imat 
+    unsigned nk = buf->shape[nd-3];     // (2)    number of float4 property groups per species 
+    unsigned nl = buf->shape[nd-2];     // (39 or 761)   number of wavelength samples of the property
+    unsigned nm = buf->shape[nd-1];     // (4)    number of prop within the float4
 
 
 
@@ -201,6 +305,13 @@ std::string QBnd::desc() const
        << " src " << ( src ? src->desc() : "-" )
        << " tex " << ( tex ? tex->desc() : "-" )
        << " tex " << tex 
+       << " dedup " << ( dedup ? "YES" : "NO " )
+       << " tex_bytes " << tex_bytes()
+       ; 
+    if(dedup) ss 
+       << " mtex " << mtex->desc()
+       << " stex " << stex->desc()
+       << " " << SBnd::DescDedup(src, umat, usur, bidx)
        ; 
     std::string str = ss.str(); 
     return str ; 
@@ -245,8 +356,6 @@ void QBnd::ConfigureLaunch( dim3& numBlocks, dim3& threadsPerBlock, int width, i
 
 NP* QBnd::lookup() const 
 {
-    unsigned width = tex->width ; 
-    unsigned height = tex->height ; 
     unsigned num_lookup = width*height ; 
 
     NP* out = NP::Make<float>(height, width, 4 ); 
@@ -284,6 +393,14 @@ extern "C" void QBnd_lookup_0_MOCK(
     int height 
     ); 
 
+extern "C" void QBnd_lookup_1_MOCK(
+    qbnd* qb, 
+    quad* lookup, 
+    int num_lookup, 
+    int width, 
+    int height 
+    ); 
+
 #include "QBnd_MOCK.h"
 
 #else
@@ -300,24 +417,50 @@ extern "C" void QBnd_lookup_0(
     int height 
     ); 
 
+extern "C" void QBnd_lookup_1(
+    dim3 numBlocks, 
+    dim3 threadsPerBlock, 
+    qbnd* qb, 
+    quad* lookup, 
+    int num_lookup, 
+    int width, 
+    int height 
+    ); 
+
 #endif
 
 
+/**
+QBnd::lookup
+--------------
+
+With the full layout the boundary texture is read directly with QBnd_lookup_0.
+With dedup QBnd_lookup_1 goes via qbnd::boundary_lookup and the index, 
+giving the same (height, width) rows as the full layout.
+
+**/
+
 void QBnd::lookup( quad* lookup, int num_lookup, int width, int height ) const 
 {
-    if( tex->d_meta == nullptr )
+    if( tex && tex->d_meta == nullptr )
     {
         tex->uploadMeta();    // TODO: not a good place to do this, needs to be more standard
     }
-    assert( tex->d_meta != nullptr && "must QTex::uploadMeta() before lookups" );
+    assert( ( tex == nullptr || tex->d_meta != nullptr ) && "must QTex::uploadMeta() before lookups" );
 
 
 #if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
 
-    std::cout << "QBnd::lookup MISSING MOCK IMPL " << std::endl ; 
     quad* d_lookup  = lookup ; 
 
-    QBnd_lookup_0_MOCK(tex->texObj, tex->d_meta, d_lookup, num_lookup, width, height );  
+    if(dedup)
+    {
+        QBnd_lookup_1_MOCK(d_qb, d_lookup, num_lookup, width, height );  
+    }
+    else
+    {
+        QBnd_lookup_0_MOCK(tex->texObj, tex->d_meta, d_lookup, num_lookup, width, height );  
+    }
 
 #else
 
@@ -333,7 +476,14 @@ void QBnd::lookup( quad* lookup, int num_lookup, int width, int height ) const
     quad* d_lookup  ;  
     QUDA_CHECK( cudaMalloc(reinterpret_cast<void**>( &d_lookup ), size )); 
 
-    QBnd_lookup_0(numBlocks, threadsPerBlock, tex->texObj, tex->d_meta, d_lookup, num_lookup, width, height );  
+    if(dedup)
+    {
+        QBnd_lookup_1(numBlocks, threadsPerBlock, d_qb, d_lookup, num_lookup, width, height );  
+    }
+    else
+    {
+        QBnd_lookup_0(numBlocks, threadsPerBlock, tex->texObj, tex->d_meta, d_lookup, num_lookup, width, height );  
+    }
 
     QUDA_CHECK( cudaMemcpy(reinterpret_cast<void*>(lookup), d_lookup, size, cudaMemcpyDeviceToHost )); 
     QUDA_CHECK( cudaFree(d_lookup) ); 
@@ -2,6 +2,8 @@
 #include "curand_kernel.h"
 #include "scuda.h"
 #include "qgs.h"
+#include "sstate.h"
+#include "qbnd.h"
 
 __global__ void _QBnd_lookup_0(cudaTextureObject_t tex, quad4* meta, quad* lookup, int num_lookup, int width, int height )
 {
@@ -50,3 +52,35 @@ extern "C" void QBnd_lookup_0(
 } 
 
 
+/**
+_QBnd_lookup_1
+----------------
+
+Same rows as _QBnd_lookup_0 but via qbnd::boundary_lookup which 
+also works with the deduplicated layout
+
+**/
+
+__global__ void _QBnd_lookup_1(qbnd* qb, quad* lookup, int num_lookup, int width, int height )
+{
+    int ix = blockIdx.x * blockDim.x + threadIdx.x;
+    int iy = blockIdx.y * blockDim.y + threadIdx.y;
+    int index = iy * width + ix ;
+    if (ix >= width | iy >= height ) return;
+
+    quad q ; 
+    q.f = qb->boundary_lookup( ix, iy ); 
+    lookup[index] = q ; 
+}
+
+extern "C" void QBnd_lookup_1(
+    dim3 numBlocks, 
+    dim3 threadsPerBlock, 
+    qbnd* qb, 
+    quad* lookup, 
+    int num_lookup, 
+    int width, 
+    int height  ) 
+{
+    _QBnd_lookup_1<<<numBlocks,threadsPerBlock>>>( qb, lookup, num_lookup, width, height );
+}
@@ -14,6 +14,23 @@ in order to facilitate reuse from eg U4Recorder.
 * anything data preparation related that is not using CUDA should be down in sysrap
 
 
+Deduplicated layout
+----------------------
+
+The full bnd array (num_bnd, 4, 2, num_wavelength, 4) repeats the property
+payload of each material and surface for every boundary that uses it.
+With envvar QBnd__DEDUP the bnd is split with SBnd::Dedup into unique
+material and surface arrays which are uploaded as two smaller textures
+together with a (num_bnd, 4) int index, see qbnd::boundary_resolve.
+The qbnd::boundary_lookup values are the same with either layout.
+
+Non-uniform domain
+--------------------
+
+When the bnd is on the adaptive wavelength domain of sdomain_adaptive.h 
+the remap array is uploaded too and qbnd::boundary_lookup goes via 
+qbnd::domain_remap_lookup to find the texel coordinate of the wavelength. 
+
 TODO: consider combine QBnd and QOptical into QOpticalBnd or incorporating 
       QOptical within QBnd as bnd and optical are so closely related 
       and require coordinated changes when adding dynamic boundaries
@@ -49,20 +66,38 @@ struct QUDARAP_API QBnd
 #endif
     static const QBnd*          INSTANCE ; 
     static const QBnd*          Get(); 
+    static constexpr const char* QBnd__DEDUP = "QBnd__DEDUP" ; 
+    static const bool           DEDUP ; 
 
     static qbnd* MakeInstance(const QTex<float4>* tex, const std::vector<std::string>& names ); 
 
     const NP*      dsrc ;  
     const NP*      src ;  
     SBnd*          sbn ; 
+    const bool     dedup ; 
+    unsigned       width ;   // full layout texture width  : wavelength samples
+    unsigned       height ;  // full layout texture height : num_bnd*4*2 
+
+    QTex<float4>*  tex ;     // full layout, nullptr when dedup
+
+    NP*            umat ;    // dedup layout, see SBnd::Dedup  
+    NP*            usur ; 
+    NP*            bidx ; 
+    QTex<float4>*  mtex ; 
+    QTex<float4>*  stex ; 
+    int*           d_bidx ; 
 
-    QTex<float4>*  tex ; 
+    const NP*      remap ;   // non-uniform domain, see sdomain_adaptive::get_remap
+    float*         d_remap ; 
 
     qbnd*          qb ;    // formerly bnd 
     qbnd*          d_qb ;  // formerly d_bnd
 
-    QBnd(const NP* buf); 
+    QBnd(const NP* buf, bool dedup=DEDUP, const NP* remap=nullptr); 
     void init(); 
+    void initDedup(); 
+    void initRemap(); 
+    size_t tex_bytes() const ; 
 
     std::string desc() const ; 
 
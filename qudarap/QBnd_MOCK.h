@@ -37,6 +37,24 @@ extern "C" void QBnd_lookup_0_MOCK(
     }
 }
 
+extern "C" void QBnd_lookup_1_MOCK(
+    qbnd* qb, 
+    quad* lookup, 
+    int num_lookup, 
+    int width, 
+    int height 
+    )
+{
+    for(int iy=0 ; iy < height ; iy++)
+    for(int ix=0 ; ix < width ; ix++)
+    {
+        int index = iy * width + ix ;
+        quad q ; 
+        q.f = qb->boundary_lookup( ix, iy ); 
+        lookup[index] = q ; 
+    }
+}
+
 #endif
 
 
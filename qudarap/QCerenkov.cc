@@ -8,6 +8,8 @@
 #include "squad.h"
 #include "sphoton.h"
 #include "scerenkov.h"
+#include "scerenkov_cdf.h"
+#include "ssys.h"
 
 #include "qrng.h"
 #include "qcerenkov.h"
@@ -33,6 +35,7 @@ const QCerenkov* QCerenkov::Get(){ return INSTANCE ;  }
 
 
 const char* QCerenkov::DEFAULT_FOLD = "$TMP/QCerenkovIntegralTest/test_makeICDF_SplitBin" ; 
+const bool QCerenkov::CDF = ssys::getenvbool(QCerenkov__CDF) ; 
 
 NP* QCerenkov::Load(const char* fold, const char* name)  // static
 {
@@ -63,9 +66,12 @@ QCerenkov::MakeInstance
 QProp was assuming a saved GGeo and IDPath and access to "$IDPath/GScintillatorLib/LS_ori/RINDEX.npy"
 see GGeo::convertSim_Prop
 
+When ckcdf is provided its arrays are uploaded and qcerenkov::generate
+uses the envelope ICDF sampling, see sysrap/scerenkov_cdf.h
+
 **/
 
-qcerenkov* QCerenkov::MakeInstance() // static 
+qcerenkov* QCerenkov::MakeInstance(const scerenkov_cdf* ckcdf) // static 
 {
     const QBase* base = QBase::Get(); 
     assert( base );  
@@ -80,6 +86,16 @@ qcerenkov* QCerenkov::MakeInstance() // static
     ck->base = base->d_base ;  
     ck->bnd = bnd->d_qb ;  
     ck->prop = prop ? prop->d_prop : nullptr ; 
+
+    ck->cdf = ckcdf ? QU::UploadArray<float>(ckcdf->cdf->cvalues<float>(), ckcdf->cdf->num_values(), "QCerenkov::MakeInstance/cdf") : nullptr ; 
+    ck->cdf_energy = ckcdf ? QU::UploadArray<float>(ckcdf->energy->cvalues<float>(), ckcdf->energy->num_values(), "QCerenkov::MakeInstance/cdf_energy") : nullptr ; 
+    ck->cdf_line = ckcdf ? QU::UploadArray<int>(ckcdf->line->cvalues<int>(), ckcdf->line->num_values(), "QCerenkov::MakeInstance/cdf_line") : nullptr ; 
+    ck->cdf_nb = ckcdf ? ckcdf->cdf->shape[1] : 0 ; 
+    ck->cdf_ne = ckcdf ? ckcdf->cdf->shape[2] : 0 ; 
+    ck->cdf_nline = ckcdf ? ckcdf->line->shape[0] : 0 ; 
+    ck->cdf_bi0 = ckcdf ? ckcdf->bi0 : 1.f ; 
+    ck->cdf_bistep = ckcdf ? ckcdf->bistep : 0.f ; 
+
     return ck ; 
 }
 
@@ -104,7 +120,8 @@ QCerenkov::QCerenkov(const char* fold_ )
     normalizedCoords(true), 
     tex(nullptr),
     look(nullptr),
-    cerenkov(MakeInstance()),
+    ckcdf(nullptr),
+    cerenkov(MakeInstance(ckcdf)),
     d_cerenkov(QU::UploadArray<qcerenkov>(cerenkov, 1, "QCerenkov::QCerenkov/d_cerenkov.1"))
 {
     init(); 
@@ -119,12 +136,29 @@ QCerenkov::QCerenkov()
     normalizedCoords(true),
     tex(nullptr),
     look(nullptr),
-    cerenkov(MakeInstance()),
+    ckcdf(nullptr),
+    cerenkov(MakeInstance(ckcdf)),
     d_cerenkov(QU::UploadArray<qcerenkov>(cerenkov, 1,"QCerenkov::QCerenkov/d_cerenkov.0"))
 {
     init(); 
 }
 
+QCerenkov::QCerenkov(const scerenkov_cdf* ckcdf_)
+    :
+    fold(nullptr),
+    icdf_(nullptr),
+    icdf(nullptr),
+    filterMode('P'),
+    normalizedCoords(true),
+    tex(nullptr),
+    look(nullptr),
+    ckcdf(ckcdf_),
+    cerenkov(MakeInstance(ckcdf)),
+    d_cerenkov(QU::UploadArray<qcerenkov>(cerenkov, 1,"QCerenkov::QCerenkov/d_cerenkov.2"))
+{
+    init(); 
+}
+
 
 
 /**
@@ -188,6 +222,7 @@ std::string QCerenkov::desc() const
        << " icdf_ " << ( icdf_ ? icdf_->sstr() : "-" )
        << " icdf " << ( icdf ? icdf->sstr() : "-" )
        << " tex " << tex 
+       << " ckcdf " << ( ckcdf ? ckcdf->desc() : "-" )
        ; 
 
     std::string s = ss.str(); 
@@ -12,6 +12,15 @@ Lookup sampling from ICDF is less sensitive.
 
 Loads icdf and creates GPU texture from it ready for energy sampling. 
 
+Production ICDF sampling
+--------------------------
+
+With envvar QCerenkov__CDF QSim creates the scerenkov_cdf envelope
+cumulatives for every material from the standard arrays and passes them
+to the ctor, they are uploaded and qcerenkov::generate then uses
+qcerenkov::wavelength_sampled_cdf in place of the rejection sampling
+of qcerenkov::wavelength_sampled_bndtex. 
+
 See also:
 
 QCerenkovIntegral 
@@ -29,6 +38,7 @@ ana/rindex.py
 
 struct float4 ; 
 struct qcerenkov ; 
+struct scerenkov_cdf ; 
 
 struct NP ; 
 template <typename T> struct QTex ; 
@@ -41,10 +51,12 @@ struct QUDARAP_API QCerenkov
     static const QCerenkov*     INSTANCE ; 
     static const QCerenkov*     Get(); 
     static const char*          DEFAULT_FOLD ; 
+    static constexpr const char* QCerenkov__CDF = "QCerenkov__CDF" ; 
+    static const bool           CDF ; 
     static NP*                  Load(const char* fold, const char* name) ; 
     static QTex<float4>*        MakeTex(const NP* icdf, char filterMode, bool normalizedCoords) ; 
 
-    static qcerenkov* MakeInstance(); 
+    static qcerenkov* MakeInstance(const scerenkov_cdf* ckcdf); 
 
     const char*             fold ; 
     const NP*               icdf_ ; 
@@ -53,11 +65,13 @@ struct QUDARAP_API QCerenkov
     bool                    normalizedCoords ; 
     QTex<float4>*           tex ; 
     QTexLookup<float4>*     look ; 
+    const scerenkov_cdf*    ckcdf ; 
     qcerenkov*              cerenkov ; 
     qcerenkov*              d_cerenkov ; 
 
     QCerenkov(); 
     QCerenkov(const char* fold); 
+    QCerenkov(const scerenkov_cdf* ckcdf); 
     void init(); 
     std::string desc() const ; 
 
@@ -44,6 +44,7 @@ extern "C" void QCurandState_curand_init_chunk(SLaunchSequence* lseq, scurandref
 
 struct QCurandState
 {
+    static constexpr const char* init_HOST = "QCurandState__init_HOST" ; 
     static QCurandState* Create(const char* _dir=nullptr); 
 
     SCurandState cs = {} ;
@@ -78,6 +79,9 @@ QCurandState::init
 
 Completeness means all the chunk files exist. 
 
+With QCurandState__init_HOST the missing chunks are generated 
+on the host with SCurandState::createHost instead of the GPU. 
+
 Outcome of instanciation is a complete set of
 chunk files. 
 
@@ -96,6 +100,13 @@ inline void QCurandState::init()
 
     if(complete) return ; 
 
+    if(ssys::getenvbool(init_HOST))
+    {
+        int num_created = cs.createHost(); 
+        std::cerr << "QCurandState::init " << init_HOST << " num_created " << num_created << "\n" ;
+        return ; 
+    }
+
     for(int i=0 ; i < num_chunk ; i++)
     {
         SCurandChunk& c = cs.chunk[i]; 
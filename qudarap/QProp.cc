@@ -2,6 +2,7 @@
 
 #if defined(MOCK_CURAND)
 #include "plog/Severity.h"
+#include "SPropInterp.h"
 #else
 #include "SLOG.hh"
 #include <cuda_runtime.h>
@@ -246,6 +247,10 @@ QProp::lookup
 
 Note that this is doing separate CUDA launches for each property
 
+With MOCK_CURAND the host batched SPropInterp is used, giving
+bitwise identical results to qprop::interpolate without the
+per-lookup binary search.
+
 **/
 
 template<typename T>
@@ -257,14 +262,8 @@ void QProp<T>::lookup( T* lookup, const T* domain,  unsigned num_prop, unsigned
 
 #if defined(MOCK_CURAND)
 
-    std::cout << "MOCK_CURAND QProp::lookup needs impl " << std::endl ;
-
-    for(int i=0 ; i < ni ; i++)
-    for(int j=0 ; j < nj ; j++)
-    {
-        int idx = i*nj + j ;
-        lookup[idx] = prop->interpolate( i, domain[j] ) ;
-    }
+    SPropInterp<T> pi( prop->pp, prop->height, prop->width ) ;
+    pi.lookup( lookup, domain, nj, ni );
 
 #else
     LOG(LEVEL)
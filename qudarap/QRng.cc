@@ -1,5 +1,6 @@
 #include <sstream>
 #include <cstring>
+#include <csignal>
 #include "SLOG.hh"
 
 #include "QRng.hh"
@@ -59,7 +60,10 @@ QRng::QRng(unsigned skipahead_event_offset_)
     rngmax(0)
 #else
     rngmax(SEventConfig::MaxCurand()),
-    cs(nullptr)
+    cs(nullptr),
+    lazy(ssys::getenvbool(QRng__LAZY)),
+    d_states(nullptr),
+    num_uploaded(0)
 #endif
 {
     init(); 
@@ -85,7 +89,11 @@ template<> void QRng::initStates<XORWOW>()
 #ifdef OLD_MONOLITHIC_CURANDSTATE
     XORWOW* d_uploaded_states = LoadAndUpload(rngmax, SCurandStateMonolithic::Path()) ;  
 #else
-    XORWOW* d_uploaded_states = LoadAndUpload(rngmax, cs); 
+    if( lazy && rngmax == 0 ) rngmax = cs.all.num ; 
+    d_states = lazy ? QU::device_alloc<XORWOW>( rngmax, "QRng::initStates/lazy" ) : LoadAndUpload(rngmax, cs) ; 
+    num_uploaded = lazy ? 0 : rngmax ; 
+    XORWOW* d_uploaded_states = d_states ; 
+    LOG(LEVEL) << " lazy " << ( lazy ? "YES" : "NO " ) << " rngmax " << rngmax ; 
 #endif
     qr->set_uploaded_states( d_uploaded_states ); 
 }
@@ -138,6 +146,54 @@ QRng::~QRng()
 {
 }
 
+/**
+QRng::prepare
+---------------
+
+Ensures that states for slots [0, num_slot) are on device, returning the 
+number of states uploaded by this call. Without QRng__LAZY all rngmax 
+states are uploaded at initialization so this does nothing. 
+With lazy only the slots beyond those already uploaded are loaded 
+via SCurandState::loadRange. Philox needs no states. 
+
+Must be called before every launch that uses sim->rng, see QSim launchers.
+Requesting more than rngmax slots is fatal rather than silently using
+uninitialized states, -1 is returned when the SIGINT is handled.
+
+**/
+
+int QRng::prepare(ULL num_slot) const 
+{
+#ifdef OLD_MONOLITHIC_CURANDSTATE
+    return 0 ; 
+#else
+    if( !lazy || d_states == nullptr || num_slot <= num_uploaded ) return 0 ; 
+
+    bool in_range = num_slot <= rngmax ; 
+    LOG_IF(fatal, !in_range) << " num_slot " << num_slot << " exceeds rngmax " << rngmax << " increase " << SEventConfig::kMaxCurand ; 
+    if(!in_range) std::raise(SIGINT); 
+    if(!in_range) return -1 ; 
+
+    ULL slot0 = num_uploaded ; 
+    ULL num = num_slot - slot0 ; 
+
+    scurandref<XORWOW> cr = cs.loadRange(slot0, num) ; 
+    assert( cr.states ); 
+    QU::copy_host_to_device<XORWOW>( d_states + slot0, cr.states, num ); 
+    free(cr.states); 
+
+    num_uploaded = num_slot ; 
+
+    LOG(LEVEL) 
+        << " slot0 " << slot0 
+        << " num " << num 
+        << " num_uploaded " << num_uploaded 
+        << " rngmax " << rngmax 
+        ;
+    return num ; 
+#endif
+}
+
 
 
 #ifdef OLD_MONOLITHIC_CURANDSTATE
@@ -485,6 +541,10 @@ std::string QRng::desc() const
        << std::setw(30) << " qr " << qr << "\n"
        << std::setw(30) << " qr.skipahead_event_offset " << qr->skipahead_event_offset << "\n"
        << std::setw(30) << " d_qr " << d_qr << "\n"
+#ifndef OLD_MONOLITHIC_CURANDSTATE
+       << std::setw(30) << " lazy " << ( lazy ? "YES" : "NO " ) << "\n"
+       << std::setw(30) << " num_uploaded " << num_uploaded << "\n"
+#endif
        ;
 
     std::string str = ss.str(); 
@@ -525,6 +585,8 @@ void QRng::generate( T* uu, unsigned ni, unsigned nv, unsigned evid )
 
     QU::ConfigureLaunch(numBlocks, threadsPerBlock, ni, 1 );  
 
+    prepare(ni); 
+
     QRng_generate<T>(numBlocks, threadsPerBlock, d_qr, evid, d_uu, ni, nv ); 
 
     QU::copy_device_to_host_and_free<T>( uu, d_uu, ni*nv, label );
@@ -12,6 +12,17 @@ randoms to simulate an item(photon).
 
 
 
+With QRng__LAZY (chunked XORWOW only) the device buffer for rngmax states
+is allocated at initialization but states are only uploaded as needed by
+QRng::prepare, invoked prior to every QSim launch that uses sim->rng
+with the number of slots the launch reads : the slot range of the genstep
+slice for QSim::simulate, the item count for the test launchers.
+SCurandState::loadRange memory maps just the part of the chunk files
+covering the newly needed slots, so an event needing only a few million
+photons touches only those states.
+Uploaded states are retained for subsequent events, so the upload is
+incremental up to the high water mark of slots.
+
 TODO : implement sanity check for use after loading::
 
     bool QRng::IsAllZero( RNG* states, unsigned num_states ) //  static
@@ -37,6 +48,7 @@ struct QUDARAP_API QRng
 {
     typedef unsigned long long ULL ; 
     static constexpr const char* init_VERBOSE = "QRng__init_VERBOSE" ; 
+    static constexpr const char* QRng__LAZY = "QRng__LAZY" ; 
     static constexpr const ULL M = 1000000 ;  
     static const plog::Severity LEVEL ; 
     static const QRng* INSTANCE ; 
@@ -72,6 +84,9 @@ struct QUDARAP_API QRng
 
 #ifndef OLD_MONOLITHIC_CURANDSTATE
     SCurandState   cs ; 
+    bool           lazy ; 
+    XORWOW*        d_states ;      // device buffer of rngmax states 
+    mutable ULL    num_uploaded ;  // lazy : states [0,num_uploaded) are on device 
 #endif
 
 
@@ -81,6 +96,7 @@ struct QUDARAP_API QRng
     template<typename R> void initStates();
 
     void initMeta(); 
+    int  prepare(ULL num_slot) const ; 
 
     virtual ~QRng(); 
 
@@ -18,6 +18,7 @@
 #include "SCSGOptiX.h"
 
 #include "SGenstep.h"
+#include "scerenkov_cdf.h"
 #include "sslice.h"
 
 #include "NP.hh"
@@ -143,7 +144,8 @@ void QSim::UploadComponents( const SSim* ssim  )
         QOptical* qopt = new QOptical(optical);
         LOG(LEVEL) << qopt->desc();
 
-        QBnd* qbnd = new QBnd(bnd); // boundary texture with standard domain, used for standard fast property lookup
+        const NP* remap = ssim->get(snam::REMAP);  // only with non-uniform adaptive domain
+        QBnd* qbnd = new QBnd(bnd, QBnd::DEDUP, remap); // boundary texture with standard domain, used for standard fast property lookup
         LOG(LEVEL) << qbnd->desc();
     }
 
@@ -182,7 +184,16 @@ void QSim::UploadComponents( const SSim* ssim  )
     bool is_simtrace = SEventConfig::IsRGModeSimtrace() ;
     if(is_simtrace == false )
     {
-        QCerenkov* cerenkov = new QCerenkov  ;
+        const scerenkov_cdf* ckcdf = nullptr ;
+        if( QCerenkov::CDF )   // envelope ICDF sampling in place of rejection sampling
+        {
+            const NP* wavelength = ssim->get(snam::WAVELENGTH);
+            const NP* mat = ssim->get(snam::MAT);
+            const NP* bd = ssim->get(snam::BD);
+            ckcdf = wavelength && mat && bd ? scerenkov_cdf::Create(wavelength, mat, bd) : nullptr ;
+            LOG_IF(error, ckcdf == nullptr) << " QCerenkov__CDF requires standard wavelength, mat, bd arrays " ;
+        }
+        QCerenkov* cerenkov = ckcdf ? new QCerenkov(ckcdf) : new QCerenkov ;
         LOG(LEVEL) << cerenkov->desc();
     }
     else
@@ -420,8 +431,12 @@ double QSim::simulate(int eventID, bool reset_)
     if( event == nullptr ) return -1. ;
 
 
+    std::unique_lock<std::recursive_mutex> lock = SEvt::LockMTGenstep() ;  // G4 workers simulate one at a time, see SEvt::LockMTGenstep
+
     sev->beginOfEvent(eventID);  // set SEvt index and tees up frame gensteps for simtrace and input photon simulate running
 
+    if(SEvt::MT_GENSTEP) SEvt::MergeThreadGenstep();  // per-thread gensteps from G4 worker threads
+
     NP* igs = sev->makeGenstepArrayFromVector();
 
     MaybeSaveIGS(eventID, igs);
@@ -449,6 +464,8 @@ double QSim::simulate(int eventID, bool reset_)
 
         LOG(info) << sl.idx_desc(i) ;
 
+        if(rng) rng->prepare( sl.ph_offset + sl.ph_count );  // lazy RNG state upload, see QRng.hh
+
         int rc = event->setGenstepUpload_NP(igs, &sl ) ;
         LOG_IF(error, rc != 0) << " QEvent::setGenstep ERROR : have event but no gensteps collected : will skip cx.simulate " ;
 
@@ -677,6 +694,8 @@ double QSim::simtrace(int eventID)
 
     LOG_IF(error, rc != 0) << " QEvent::setGenstep ERROR : no gensteps collected : will skip cx.simtrace " ;
 
+    if(rng) rng->prepare( event->getNumSimtrace() );  // lazy RNG state upload, see QRng.hh
+
     sev->t_PreLaunch = sstamp::Now() ;
     double dt = rc == 0 && cx != nullptr ? cx->simtrace_launch() : -1. ;
     sev->t_PostLaunch = sstamp::Now() ;
@@ -862,6 +881,8 @@ void QSim::rng_sequence( T* seq, unsigned ni_tranche, unsigned nv, unsigned id_o
 
     T* d_seq = QU::device_alloc<T>(num_rng, label );
 
+    if(rng) rng->prepare( id_offset + ni_tranche );  // lazy RNG state upload, see QRng.hh
+
     QSim_rng_sequence<T>( numBlocks, threadsPerBlock, d_sim, d_seq, ni_tranche, nv, id_offset );
 
     QU::copy_device_to_host_and_free<T>( seq, d_seq, num_rng, label );
@@ -985,6 +1006,8 @@ NP* QSim::scint_wavelength(unsigned num_wavelength, unsigned& hd_factor )
 
     float* d_wavelength = QU::device_alloc<float>(num_wavelength, "QSim::scint_wavelength/num_wavelength");
 
+    if(rng) rng->prepare( num_wavelength );
+
     QSim_scint_wavelength(numBlocks, threadsPerBlock, d_sim, d_wavelength, num_wavelength );
 
     NP* w = NP::Make<float>(num_wavelength) ;
@@ -1007,6 +1030,8 @@ NP* QSim::RandGaussQ_shoot(unsigned num_v )
 
     float* d_v = QU::device_alloc<float>(num_v, label );
 
+    if(rng) rng->prepare( num_v );
+
     QSim_RandGaussQ_shoot(numBlocks, threadsPerBlock, d_sim, d_v, num_v );
 
     cudaDeviceSynchronize();
@@ -1048,6 +1073,8 @@ NP* QSim::dbg_gs_generate(unsigned num_photon, unsigned type )
     sphoton* d_photon = QU::device_alloc<sphoton>(num_photon, "QSim::dbg_gs_generate:num_photon") ;
     QU::device_memset<sphoton>(d_photon, 0, num_photon);
 
+    if(rng) rng->prepare( num_photon );
+
     QSim_dbg_gs_generate(numBlocks, threadsPerBlock, d_sim, d_dbg, d_photon, num_photon, type );
 
     NP* p = NP::Make<float>(num_photon, 4, 4);
@@ -1084,6 +1111,8 @@ void QSim::generate_photon()
 
     configureLaunch( num_photon, 1 );
 
+    if(rng) rng->prepare( num_photon );
+
     LOG(info) << "QSim_generate_photon... " ;
 
     QSim_generate_photon(numBlocks, threadsPerBlock, d_sim );
@@ -1177,6 +1206,8 @@ NP* QSim::quad_launch_generate(unsigned num_quad, unsigned type )
     unsigned threads_per_block = 512 ;
     configureLaunch1D( num_quad, threads_per_block );
 
+    if(rng) rng->prepare( num_quad );
+
     QSim_quad_launch(numBlocks, threadsPerBlock, d_sim, d_q, num_quad, d_dbg, type );
 
     NP* q = NP::Make<float>( num_quad, 4 );
@@ -1231,6 +1262,8 @@ NP* QSim::photon_launch_generate(unsigned num_photon, unsigned type )
     unsigned threads_per_block = 512 ;
     configureLaunch1D( num_photon, threads_per_block );
 
+    if(rng) rng->prepare( num_photon );
+
     QSim_photon_launch(numBlocks, threadsPerBlock, d_sim, d_photon, num_photon, d_dbg, type );
 
     NP* p = NP::Make<float>(num_photon, 4, 4);
@@ -1279,6 +1312,7 @@ void QSim::photon_launch_mutate(sphoton* photon, unsigned num_photon, unsigned t
     {
         unsigned threads_per_block = 512 ;
         configureLaunch1D( u_num_photon, threads_per_block );
+        if(rng) rng->prepare( u_num_photon );
         QSim_photon_launch(numBlocks, threadsPerBlock, d_sim, d_photon, u_num_photon, d_dbg, type );
     }
 
@@ -1382,6 +1416,8 @@ void QSim::fake_propagate( const NP* prd, unsigned type )
     unsigned threads_per_block = 512 ;
     configureLaunch1D( num_photon, threads_per_block );
 
+    if(rng) rng->prepare( num_photon );
+
     QSim_fake_propagate_launch(numBlocks, threadsPerBlock, d_sim, d_prd );
 
     cudaDeviceSynchronize();
@@ -1631,11 +1667,11 @@ void QSim::multifilm_lookup_all( quad2 * sample , quad2 * result ,  unsigned wid
 
 unsigned QSim::getBoundaryTexWidth() const
 {
-    return bnd->tex->width ;
+    return bnd->width ;
 }
 unsigned QSim::getBoundaryTexHeight() const
 {
-    return bnd->tex->height ;
+    return bnd->height ;
 }
 const NP* QSim::getBoundaryTexSrc() const
 {
@@ -1,6 +1,7 @@
 
 #include <sstream>
 #include <cstring>
+#include <type_traits>
 #include <cassert>
 #include <iostream>
 
@@ -92,7 +93,11 @@ void QTex<T>::init()
 {
 #if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
     assert(a); 
-    MockTextureManager::Add(a) ; 
+    // zero-copy view of the float src with the same filter and coordinate modes as the GPU texture
+    bool is_float = !std::is_same<T,uchar4>::value ; 
+    const float* mock_data = is_float ? (const float*)src : nullptr ;  
+    int channels = std::is_same<T,float>::value ? 1 : 4 ; 
+    texObj = MockTextureManager::Add(a, mock_data, width, height, channels, filterMode, normalizedCoords, MockTexture::AddressWrap ) ; 
 #else
     createArray();   // cudaMallocArray using channelDesc for T 
     uploadToArray();
@@ -35,7 +35,17 @@ struct qbnd
     unsigned            boundary_tex_MaterialLine_LS ;
     quad*               optical ;
 
+    cudaTextureObject_t material_tex ;    // deduplicated layout, see SBnd::Dedup and QBnd::DEDUP
+    quad4*              material_meta ;
+    cudaTextureObject_t surface_tex ;
+    quad4*              surface_meta ;
+    int*                boundary_index ;  // (num_bnd*4) lines into material_tex or surface_tex, nullptr with full boundary_tex
+    float*              domain_remap ;    // texel coordinate on base grid for non-uniform domain, see sdomain_adaptive.h
+    unsigned            domain_remap_num ;
+
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined( MOCK_TEXTURE) || defined(MOCK_CUDA)
+    QBND_METHOD float   domain_remap_lookup( float fx ) const ;
+    QBND_METHOD void    boundary_resolve( cudaTextureObject_t& tex, const quad4*& meta, unsigned& iy, unsigned line, unsigned k ) const ;
     QBND_METHOD float4  boundary_lookup( unsigned ix, unsigned iy );
     QBND_METHOD float4  boundary_lookup( float nm, unsigned line, unsigned k );
     QBND_METHOD void    fill_state(sstate& s, unsigned boundary, float wavelength, float cosTheta, unsigned idx, unsigned base_pidx );
@@ -51,19 +61,78 @@ struct qbnd
 
 
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined( MOCK_TEXTURE) || defined(MOCK_CUDA)
+/**
+qbnd::boundary_resolve
+------------------------
+
+Picks the texture, its meta and the texture row iy for a line and property group k.
+
+With the full layout all lines are in boundary_tex at row 2*line+k.
+With the deduplicated layout boundary_index gives the unique material
+(OMAT, IMAT) or surface (OSUR, ISUR) of the line, which is at row
+2*index+k of material_tex or surface_tex. Those textures have the
+same wavelength domain and texel payloads as boundary_tex so the
+lookups give identical values.
+
+**/
+
+inline QBND_METHOD void qbnd::boundary_resolve( cudaTextureObject_t& tex, const quad4*& meta, unsigned& iy, unsigned line, unsigned k ) const
+{
+    tex = boundary_tex ;
+    meta = boundary_meta ;
+    iy = _BOUNDARY_NUM_FLOAT4*line + k ;    // 2*line+k (0/1)
+
+    if( boundary_index )
+    {
+        unsigned j = line % _BOUNDARY_NUM_MATSUR ;
+        bool is_mat = j == OMAT || j == IMAT ;
+        tex  = is_mat ? material_tex : surface_tex ;
+        meta = is_mat ? material_meta : surface_meta ;
+        iy = _BOUNDARY_NUM_FLOAT4*boundary_index[line] + k ;
+    }
+}
+
+/**
+qbnd::domain_remap_lookup
+---------------------------
+
+With the non-uniform wavelength domain of sdomain_adaptive the texture
+x samples are at the knots. fx is the fractional coordinate on the
+base grid, which the knots are a subset of, so linear interpolation
+of the remap gives the exact fractional knot index.
+Equivalent to sdomain_adaptive::Remap
+
+**/
+
+inline QBND_METHOD float qbnd::domain_remap_lookup( float fx ) const
+{
+    float fb = fminf( fmaxf( fx, 0.f ), float(domain_remap_num - 1) ) ;
+    unsigned i = unsigned(fb) ;
+    if( i > domain_remap_num - 2 ) i = domain_remap_num - 2 ;
+    float f = fb - float(i) ;
+    return domain_remap[i] + f*( domain_remap[i+1] - domain_remap[i] ) ;
+}
+
 /**
 qbnd::boundary_lookup ix iy : Low level integer addressing lookup
 --------------------------------------------------------------------
 
+iy addresses rows of the full layout, ie 2*line+k
+
 **/
 
 inline QBND_METHOD float4 qbnd::boundary_lookup( unsigned ix, unsigned iy )
 {
-    const unsigned& nx = boundary_meta->q0.u.x  ;
-    const unsigned& ny = boundary_meta->q0.u.y  ;
+    cudaTextureObject_t tex ;
+    const quad4* meta ;
+    unsigned ty ;
+    boundary_resolve( tex, meta, ty, iy/_BOUNDARY_NUM_FLOAT4, iy % _BOUNDARY_NUM_FLOAT4 );
+
+    const unsigned& nx = meta->q0.u.x  ;
+    const unsigned& ny = meta->q0.u.y  ;
     float x = (float(ix)+0.5f)/float(nx) ;
-    float y = (float(iy)+0.5f)/float(ny) ;
-    float4 props = tex2D<float4>( boundary_tex, x, y );
+    float y = (float(ty)+0.5f)/float(ny) ;
+    float4 props = tex2D<float4>( tex, x, y );
     return props ;
 }
 
@@ -77,7 +146,8 @@ k   :  property group index 0/1
 
 return float4 props
 
-boundary_meta is required to configure access to the texture,
+boundary_meta (or material_meta/surface_meta with the deduplicated
+layout, see qbnd::boundary_resolve) is required to configure access to the texture,
 it is uploaded by QTex::uploadMeta but requires calls to
 
 
@@ -90,7 +160,7 @@ QTex::setMetaDomainX::
 
    q1.f.x : nm0  wavelength minimum in nm
    q1.f.y : -
-   q1.f.z : nms  wavelength step size in nm
+   q1.f.z : nms  wavelength step size in nm, base step with domain_remap
 
 QTex::setMetaDomainY::
 
@@ -104,19 +174,24 @@ inline QBND_METHOD float4 qbnd::boundary_lookup( float nm, unsigned line, unsign
 {
     //printf("//qbnd.boundary_lookup nm %10.4f line %d k %d boundary_meta %p  \n", nm, line, k, boundary_meta  );
 
-    const unsigned& nx = boundary_meta->q0.u.x  ;
-    const unsigned& ny = boundary_meta->q0.u.y  ;
-    const float& nm0 = boundary_meta->q1.f.x ;
-    const float& nms = boundary_meta->q1.f.z ;
+    cudaTextureObject_t tex ;
+    const quad4* meta ;
+    unsigned iy ;
+    boundary_resolve( tex, meta, iy, line, k );
+
+    const unsigned& nx = meta->q0.u.x  ;
+    const unsigned& ny = meta->q0.u.y  ;
+    const float& nm0 = meta->q1.f.x ;
+    const float& nms = meta->q1.f.z ;
 
     float fx = (nm - nm0)/nms ;
+    if( domain_remap ) fx = domain_remap_lookup(fx) ;   // non-uniform domain knot coordinate
     float x = (fx+0.5f)/float(nx) ;   // ?? +0.5f ??
 
-    unsigned iy = _BOUNDARY_NUM_FLOAT4*line + k ;    // 2*line+k (0/1)
     float y = (float(iy)+0.5f)/float(ny) ;
 
 
-    float4 props = tex2D<float4>( boundary_tex, x, y );
+    float4 props = tex2D<float4>( tex, x, y );
 
     // printf("//qbnd.boundary_lookup nm %10.4f nm0 %10.4f nms %10.4f  x %10.4f nx %d ny %d y %10.4f props.x %10.4f %10.4f %10.4f %10.4f  \n",
     //     nm, nm0, nms, x, nx, ny, y, props.x, props.y, props.z, props.w );
@@ -40,12 +40,23 @@ struct qcerenkov
     qbnd*  bnd ;
     qprop<float>*  prop ;
 
+    float*    cdf ;          // (num_cdf, cdf_nb, cdf_ne) envelope cumulatives, see sysrap/scerenkov_cdf.h, nullptr for rejection sampling
+    float*    cdf_energy ;   // (cdf_ne) ascending energy edges in eV
+    int*      cdf_line ;     // (cdf_nline) cdf index of bnd lines, -1 for none
+    unsigned  cdf_nb ;
+    unsigned  cdf_ne ;
+    unsigned  cdf_nline ;
+    float     cdf_bi0 ;
+    float     cdf_bistep ;
+
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined(MOCK_CURAND) || defined(MOCK_CUDA)
     QCERENKOV_METHOD void generate( sphoton& p,  RNG& rng, const quad6& gs    , int idx, int genstep_id ) const ;
 
     template<typename T>
     QCERENKOV_METHOD void wavelength_sampled_enprop( float& wavelength, float& cosTheta, float& sin2Theta, RNG& rng, const scerenkov& gs, int idx, int genstep_id ) const ;
     QCERENKOV_METHOD void wavelength_sampled_bndtex( float& wavelength, float& cosTheta, float& sin2Theta, RNG& rng, const scerenkov& gs, int idx, int genstep_id ) const ;
+    QCERENKOV_METHOD void wavelength_sampled_cdf(    float& wavelength, float& cosTheta, float& sin2Theta, RNG& rng, const scerenkov& gs, int idx, int genstep_id ) const ;
+    QCERENKOV_METHOD static float cdf_at( const float* c, const float* e, unsigned ne, float energy ) ;
 
     QCERENKOV_METHOD void fraction_sampled(float& fraction, float& delta, RNG& rng, const scerenkov& gs, int idx, int gsid ) const ;
 #endif
@@ -66,7 +77,14 @@ inline QCERENKOV_METHOD void qcerenkov::generate( sphoton& p, RNG& rng, const qu
 
     //wavelength = 500.f ; cosTheta = 0.70710678f ; sin2Theta = 0.5f ;
 
-    wavelength_sampled_bndtex(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
+    if( cdf )
+    {
+        wavelength_sampled_cdf(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
+    }
+    else
+    {
+        wavelength_sampled_bndtex(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
+    }
     //wavelength_sampled_enprop<float>(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
     //wavelength_sampled_enprop<double>(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
 
@@ -329,6 +347,110 @@ inline QCERENKOV_METHOD void qcerenkov::wavelength_sampled_bndtex(float& wavelen
 }
 
 
+/**
+qcerenkov::wavelength_sampled_cdf
+-----------------------------------
+
+Samples the same distribution as wavelength_sampled_bndtex, energy flat
+weighted by sin2Theta within gs.Pmin():gs.Pmax(), using the cumulative
+envelope table of sysrap/scerenkov_cdf.h for the genstep material and the
+BetaInverse row at or below gs.BetaInverse, which bounds sin2Theta.
+
+1. invert the cumulative at a uniform random restricted to Pmin:Pmax,
+   the binary search has a fixed number of steps
+2. lookup RINDEX with the boundary texture as wavelength_sampled_bndtex
+3. accept with probability sin2Theta/envelope, the envelope being tight
+   this rarely loops so warps stay converged and few randoms are consumed
+
+Falls back to wavelength_sampled_bndtex for materials without a table
+and when there is no permissable Cerenkov within the range.
+
+**/
+
+inline QCERENKOV_METHOD float qcerenkov::cdf_at( const float* c, const float* e, unsigned ne, float energy ) // static
+{
+    if( energy <= e[0] ) return c[0] ;
+    if( energy >= e[ne-1] ) return c[ne-1] ;
+    unsigned lo = 0 ;
+    unsigned hi = ne - 1 ;
+    while( hi - lo > 1 )
+    {
+        unsigned mid = (lo + hi)/2 ;
+        if( e[mid] <= energy ) lo = mid ; else hi = mid ;
+    }
+    return c[lo] + (energy - e[lo])*(c[hi] - c[lo])/(e[hi] - e[lo]) ;
+}
+
+inline QCERENKOV_METHOD void qcerenkov::wavelength_sampled_cdf(float& wavelength, float& cosTheta, float& sin2Theta, RNG& rng, const scerenkov& gs, int idx, int gsid ) const
+{
+    int m = gs.matline < cdf_nline ? cdf_line[gs.matline] : -1 ;
+    float fb = (gs.BetaInverse - cdf_bi0)/cdf_bistep ;
+    unsigned j = fb < 0.f ? 0u : ( unsigned(fb) < cdf_nb - 1u ? unsigned(fb) : cdf_nb - 1u ) ;
+
+    const float* c = m > -1 ? cdf + (m*cdf_nb + j)*cdf_ne : nullptr ;
+    const float* e = cdf_energy ;
+
+    float c0 = c ? cdf_at( c, e, cdf_ne, gs.Pmin() ) : 0.f ;
+    float c1 = c ? cdf_at( c, e, cdf_ne, gs.Pmax() ) : 0.f ;
+
+    if( fb < 0.f || !(c1 > c0) )
+    {
+        wavelength_sampled_bndtex(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
+        return ;
+    }
+
+    float u0 ;
+    float u1 ;
+    float cu ;
+    float dc ;
+    float de ;
+    float energy ;
+    float sampledRI ;
+    unsigned count = 0 ;
+
+    do {
+        u0 = curand_uniform(&rng) ;
+
+        cu = c0 + u0*(c1 - c0) ;
+
+        unsigned lo = 0 ;
+        unsigned hi = cdf_ne - 1 ;
+        while( hi - lo > 1 )
+        {
+            unsigned mid = (lo + hi)/2 ;
+            if( c[mid] <= cu ) lo = mid ; else hi = mid ;
+        }
+
+        dc = c[hi] - c[lo] ;
+        de = e[hi] - e[lo] ;
+        energy = e[lo] + ( dc > 0.f ? (cu - c[lo])/dc : 0.f )*de ;
+        energy = fminf( fmaxf( energy, gs.Pmin() ), gs.Pmax() ) ;
+
+        wavelength = smath::hc_eVnm/energy ;
+
+        float4 props = bnd->boundary_lookup(wavelength, gs.matline, 0u);
+
+        sampledRI = props.x ;
+
+        cosTheta = gs.BetaInverse / sampledRI ;
+
+        sin2Theta = fmaxf( 0.f, (1.f - cosTheta)*(1.f + cosTheta));
+
+        u1 = curand_uniform(&rng) ;
+
+        count += 1 ;
+
+    } while ( u1*dc > sin2Theta*de && count < 100 );
+
+#if !defined(PRODUCTION) && defined(DEBUG_PIDX)
+    if(count > 10)
+    printf("//qcerenkov::wavelength_sampled_cdf idx %6d sampledRI %7.3f cosTheta %7.3f sin2Theta %7.3f wavelength %7.3f count %d matline %d \n",
+              idx , sampledRI, cosTheta, sin2Theta, wavelength, count, gs.matline );
+#endif
+}
+
+
+
 /**
 qcerenkov::wavelength_sampled_enprop
 --------------------------------------
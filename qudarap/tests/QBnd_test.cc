@@ -4,23 +4,285 @@ QBnd_test.cc
 
 Canonically built standalone with::
 
-   ./QBnd_test.sh 
+   ./QBnd_test.sh
+   TEST=dedup ./QBnd_test.sh
+   TEST=remap ./QBnd_test.sh
 
+save
+   creates QBnd from the GEOM bnd array and saves the src and lookup dst
 
+dedup
+   compares the full boundary texture layout with the deduplicated
+   material and surface textures plus index layout, see SBnd::Dedup.
+   Uses the GEOM bnd and optical arrays when available, otherwise a
+   synthetic bnd made with sstandard::make_bnd. The full lookups and
+   qbnd::boundary_lookup at wavelengths between the domain samples
+   are required to be the same with both layouts.
+
+remap
+   synthetic bnd on the non-uniform knots of sdomain_adaptive with the
+   remap array, qbnd::boundary_lookup with both layouts is compared
+   with the analytic property values at random wavelengths
 
 **/
 
+#include <chrono>
+#include <random>
+
+#include "scuda.h"
+#include "squad.h"
+#include "sstate.h"
+
 #include "NP.hh"
+#include "SBnd.h"
+#include "ssys.h"
+#include "sstandard.h"
+#include "sdomain_adaptive.h"
+
+#include "QTex.hh"
+#include "QOptical.hh"
 #include "QBnd.hh"
+#include "qbnd.h"
 
-int main()
+struct QBnd_test
+{
+    static constexpr const char* BASE = "$HOME/.opticks/GEOM/$GEOM/CSGFoundry/SSim/stree/standard" ;
+    static NP* MakeBnd(int num_bnd, int num_mat, int num_sur, unsigned seed);
+    static NP* MakeOptical(const NP* bnd);
+
+    static int save();
+    static int dedup();
+    static int remap();
+    static int Main();
+};
+
+
+/**
+QBnd_test::MakeBnd
+--------------------
+
+Random boundaries over num_mat materials and num_sur surfaces
+with about half of the surface slots empty, as typical of real geometry.
+
+**/
+
+inline NP* QBnd_test::MakeBnd(int num_bnd, int num_mat, int num_sur, unsigned seed)
 {
-    NP* bnd = NP::Load("$HOME/.opticks/GEOM/$GEOM/CSGFoundry/SSim/stree/standard/bnd.npy") ; 
-    std::cout << " bnd " << ( bnd ? bnd->sstr() : "-" ) << std::endl ; 
-    if(bnd == nullptr) return 1 ; 
+    int nl = sdomain::DomainLength() ;
+    NP* mat = NP::Make<double>(num_mat, 2, nl, 4) ;
+    NP* sur = NP::Make<double>(num_sur, 2, nl, 4) ;
+    double* mm = mat->values<double>() ;
+    double* ss = sur->values<double>() ;
+    for(int i=0 ; i < mat->num_values() ; i++) mm[i] = 1. + 0.001*(i % 9973) ;
+    for(int i=0 ; i < sur->num_values() ; i++) ss[i] = 0.0001*(i % 7919) ;
+
+    std::mt19937 rng(seed) ;
+    std::vector<int4> vbd ;
+    std::vector<std::string> bdname ;
+    for(int i=0 ; i < num_bnd ; i++)
+    {
+        int4 bd ;
+        bd.x = rng() % num_mat ;
+        bd.y = rng() % 2 ? int(rng() % num_sur) : -1 ;
+        bd.z = rng() % 2 ? int(rng() % num_sur) : -1 ;
+        bd.w = rng() % num_mat ;
+        vbd.push_back(bd);
+
+        std::stringstream nn ;
+        nn << "M" << bd.x << "/" << ( bd.y > -1 ? "S" + std::to_string(bd.y) : "" ) << "/" << ( bd.z > -1 ? "S" + std::to_string(bd.z) : "" ) << "/M" << bd.w ;
+        bdname.push_back(nn.str());
+    }
+    NP* bnd = sstandard::make_bnd(vbd, bdname, mat, sur );
+    delete mat ;
+    delete sur ;
+    return bnd ;
+}
+
+inline NP* QBnd_test::MakeOptical(const NP* bnd)
+{
+    int ni = bnd->shape[0] ;
+    NP* op = NP::Make<int>(ni, 4, 4) ;
+    int* oo = op->values<int>() ;
+    for(int i=0 ; i < ni*4 ; i++) oo[i*4+0] = i % 4 + 1 ;
+    return op ;
+}
 
-    QBnd qb(bnd) ; 
-    qb.save("$FOLD"); 
+inline int QBnd_test::save()
+{
+    NP* bnd = NP::Load(BASE, "bnd.npy") ;
+    std::cout << " bnd " << ( bnd ? bnd->sstr() : "-" ) << std::endl ;
+    if(bnd == nullptr) return 1 ;
+
+    QBnd qb(bnd) ;
+    qb.save("$FOLD");
+
+    return 0 ;
+}
+
+inline int QBnd_test::dedup()
+{
+    NP* bnd = NP::Load(BASE, "bnd.npy") ;
+    NP* optical = bnd ? NP::Load(BASE, "optical.npy") : nullptr ;
+    if( bnd == nullptr ) bnd = MakeBnd(ssys::getenvint("NUM_BND", 120), 20, 40, 1 ) ;
+    if( optical == nullptr ) optical = MakeOptical(bnd) ;
 
-    return 0 ; 
+    QOptical qo(optical) ;
+
+    auto t0 = std::chrono::steady_clock::now() ;
+    QBnd a(bnd, false) ;
+    auto t1 = std::chrono::steady_clock::now() ;
+    QBnd b(bnd, true) ;
+    auto t2 = std::chrono::steady_clock::now() ;
+
+    NP* la = a.lookup() ;
+    NP* lb = b.lookup() ;
+    NP* rb = SBnd::Redup( b.umat, b.usur, b.bidx ) ;
+
+    int rc = 0 ;
+    rc += int( la->shape != lb->shape ) ;
+    rc += int( memcmp( la->bytes(), lb->bytes(), la->arr_bytes() ) != 0 ) ;
+    rc += int( rb->shape != a.src->shape ) ;
+    rc += int( memcmp( rb->bytes(), a.src->bytes(), rb->arr_bytes() ) != 0 ) ;
+
+    // lookups between the domain samples exercise the linear interpolation with both layouts
+    float nm0 = a.src->get_meta<float>("domain_low", 0.f) ;
+    float nm1 = a.src->get_meta<float>("domain_high", 0.f) ;
+    unsigned num_line = a.src->shape[0]*a.src->shape[1] ;
+    std::mt19937 rng(2) ;
+    std::uniform_real_distribution<float> u(nm0, nm1) ;
+    int num_mismatch = 0 ;
+    int num_lookup = 0 ;
+    for(int n=0 ; n < 100 ; n++)
+    {
+        float nm = u(rng) ;
+        for(unsigned line=0 ; line < num_line ; line++)
+        for(unsigned k=0 ; k < 2 ; k++)
+        {
+            float4 pa = a.qb->boundary_lookup(nm, line, k) ;
+            float4 pb = b.qb->boundary_lookup(nm, line, k) ;
+            num_mismatch += int( memcmp(&pa, &pb, sizeof(float4)) != 0 ) ;
+            num_lookup += 1 ;
+        }
+    }
+    rc += int( num_mismatch > 0 ) ;
+
+    std::cout
+        << "QBnd_test::dedup"
+        << " src " << a.src->sstr()
+        << " umat " << b.umat->sstr()
+        << " usur " << b.usur->sstr()
+        << "\n"
+        << " full  tex_bytes " << std::setw(10) << a.tex_bytes() << " create " << std::fixed << std::setprecision(4) << std::chrono::duration<double>(t1 - t0).count()
+        << "\n"
+        << " dedup tex_bytes " << std::setw(10) << b.tex_bytes() << " create " << std::chrono::duration<double>(t2 - t1).count()
+        << "\n"
+        << " num_lookup " << num_lookup
+        << " num_mismatch " << num_mismatch
+        << " rc " << rc
+        << "\n"
+        ;
+
+    delete la ;
+    delete lb ;
+    delete rb ;
+    return rc ;
+}
+
+inline int QBnd_test::remap()
+{
+    // narrow features that need many more samples with uniform domain
+    auto f0 = [](double nm){ return 1.32 + 3.0e3/(nm*nm) ; } ;
+    auto f1 = [](double nm){ return 1e3/(1. + std::exp(-(nm - 390.)/2.)) ; } ;
+    auto f2 = [](double nm){ double d = (nm - 430.)/5. ; return 0.02 + std::exp(-0.5*d*d) ; } ;
+
+    sdomain_adaptive ad ;
+    ad.add_fn("f0", f0);
+    ad.add_fn("f1", f1);
+    ad.add_fn("f2", f2);
+    ad.finalize();
+
+    const std::vector<double>& kk = ad.knots ;
+    int nl = kk.size() ;
+    NP* mat = NP::Make<double>(2, 2, nl, 4) ;
+    NP* sur = NP::Make<double>(1, 2, nl, 4) ;
+    double* mm = mat->values<double>() ;
+    for(int i=0 ; i < 2 ; i++)
+    for(int l=0 ; l < nl ; l++)
+    {
+        double* m = mm + ((i*2 + 0)*nl + l)*4 ;
+        m[0] = f0(kk[l]) + i ;
+        m[1] = f1(kk[l]) ;
+        m[2] = f2(kk[l]) ;
+        m[3] = 0.5 ;
+    }
+    NP* rm = ad.get_remap() ;
+
+    std::vector<int4> vbd = { make_int4(0,-1,-1,1), make_int4(1,0,-1,0) } ;
+    std::vector<std::string> bdname = { "M0///M1", "M1/S0//M0" } ;
+    NP* bnd = sstandard::make_bnd(vbd, bdname, mat, sur, rm );
+    NP* optical = MakeOptical(bnd) ;
+    QOptical qo(optical) ;
+
+    QBnd a(bnd, false, rm) ;
+    QBnd b(bnd, true, rm) ;
+
+    std::mt19937 rng(3) ;
+    std::uniform_real_distribution<float> u(sdomain::DomainLow(), sdomain::DomainHigh()) ;
+    int num_mismatch = 0 ;
+    double dmax[3] = {0., 0., 0.} ;
+    for(int n=0 ; n < 10000 ; n++)
+    {
+        float nm = u(rng) ;
+        for(unsigned m=0 ; m < 4 ; m++)
+        {
+            unsigned line = m < 2 ? m*3 : 4 + (m-2)*3 ;   // omat and imat lines of both boundaries
+            float4 pa = a.qb->boundary_lookup(nm, line, 0) ;
+            float4 pb = b.qb->boundary_lookup(nm, line, 0) ;
+            num_mismatch += int( memcmp(&pa, &pb, sizeof(float4)) != 0 ) ;
+
+            int i = vbd[line/4].x*int(line % 4 == 0) + vbd[line/4].w*int(line % 4 == 3) ;
+            dmax[0] = std::max( dmax[0], std::abs( pa.x - (f0(nm) + i) )/(f0(nm) + i) ) ;
+            dmax[1] = std::max( dmax[1], std::abs( pa.y - f1(nm) )/std::max( f1(nm), 1e1 ) ) ;
+            dmax[2] = std::max( dmax[2], std::abs( pa.z - f2(nm) )/f2(nm) ) ;
+        }
+    }
+
+    // rtol knot interpolation error plus up to the same again from 8-bit texture filter weights
+    double tol = 3.*ad.rtol ;
+    int rc = int( num_mismatch > 0 ) + int( dmax[0] > tol ) + int( dmax[1] > tol ) + int( dmax[2] > tol ) ;
+
+    std::cout
+        << "QBnd_test::remap"
+        << " num_knots " << nl
+        << " remap " << rm->sstr()
+        << " bnd " << bnd->sstr()
+        << "\n"
+        << " full  tex_bytes " << a.tex_bytes()
+        << " dedup tex_bytes " << b.tex_bytes()
+        << "\n"
+        << " dmax " << std::scientific << std::setprecision(3) << dmax[0] << " " << dmax[1] << " " << dmax[2]
+        << " num_mismatch " << num_mismatch
+        << " rc " << rc
+        << "\n"
+        ;
+
+    delete mat ;
+    delete sur ;
+    return rc ;
+}
+
+inline int QBnd_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "save") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"save")==0)  rc += save();
+    if(ALL||strcmp(TEST,"dedup")==0) rc += dedup();
+    if(ALL||strcmp(TEST,"remap")==0) rc += remap();
+    return rc ;
+}
+
+int main()
+{
+    return QBnd_test::Main() ;
 }
@@ -7,6 +7,12 @@ Via MOCK_TEXTURE and MOCK_CUDA switches this builds and
 runs CUDA code including texture lookups on the CPU via
 mocking of the texture handling. 
 
+::
+
+    ~/o/qudarap/tests/QBnd_test.sh
+    TEST=dedup ~/o/qudarap/tests/QBnd_test.sh run   # full vs deduplicated boundary texture layout 
+    TEST=remap ~/o/qudarap/tests/QBnd_test.sh run   # non-uniform domain boundary texture via remap
+
 EOU
 }
 
@@ -0,0 +1,291 @@
+/**
+QCerenkov_MockTest.cc : CPU parity and benchmark of Cerenkov wavelength sampling
+==================================================================================
+
+Compares on CPU, using MOCK_CURAND/MOCK_CUDA/MOCK_TEXTURE, the rejection
+sampling qcerenkov::wavelength_sampled_bndtex with the envelope ICDF sampling
+qcerenkov::wavelength_sampled_cdf of sysrap/scerenkov_cdf.h::
+
+   ~/o/qudarap/tests/QCerenkov_MockTest.sh
+   NUM=1000000 ~/o/qudarap/tests/QCerenkov_MockTest.sh
+
+Synthetic Water, LS and Air RINDEX on the standard domain are used to form
+the boundary texture and the envelope cumulatives. The LS RINDEX has a
+narrow UV peak, as with real LS, which makes maxSin2 of the rejection
+sampling a loose bound. For several BetaInverse, from relativistic to
+close to threshold, NUM energies and cosTheta are sampled with each method and compared with two sample chi2 of 40 bin
+histograms. The randoms consumed per photon and the time per photon
+are reported for each. qcerenkov::generate is also run with the cdf.
+
+**/
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sphoton.h"
+#include "sstate.h"
+#include "scerenkov.h"
+#include "scerenkov_cdf.h"
+#include "sstandard.h"
+#include "OpticksPhoton.h"
+
+#include "srngcpu.h"
+
+struct srngcount : public srngcpu
+{
+    unsigned long long count = 0 ;
+};
+inline float curand_uniform(srngcount* state ){ state->count += 1 ; return state->generate_float() ; }
+using RNG = srngcount ;
+
+#include "stexture.h"
+
+#include "QOptical.hh"
+#include "QBnd.hh"
+#include "qbnd.h"
+#include "qcerenkov.h"
+
+
+struct QCerenkov_MockTest
+{
+    static constexpr const int NB = 40 ;
+    static double RINDEX(int m, double nm);
+    static double Chi2(const std::vector<int>& a, const std::vector<int>& b, int& ndf);
+
+    int num ;
+    sdomain dom ;
+    NP* mat ;
+    NP* sur ;
+    NP* bd ;
+    NP* bnd ;
+    NP* optical ;
+    QOptical* qo ;
+    QBnd* qb ;
+    scerenkov_cdf* ckcdf ;
+    qcerenkov ck_rej ;
+    qcerenkov ck_cdf ;
+
+    QCerenkov_MockTest();
+    void init();
+    double nmax(unsigned line, float Wmin, float Wmax) const ;
+    int parity(unsigned line, float BetaInverse);
+    int generate();
+    int run();
+};
+
+
+inline double QCerenkov_MockTest::RINDEX(int m, double nm)  // static
+{
+    double n = 1. ;
+    switch(m)
+    {
+        case 0: n = 1.33 + 2.0e3/(nm*nm) ; break ;                                       // Water
+        case 1: n = 1.48 + 4.0e3/(nm*nm) + 0.3/(1. + (nm - 200.)*(nm - 200.)/100.) ; break ;  // LS with UV peak
+        case 2: n = 1.0003 ; break ;                                                     // Air
+    }
+    return n ;
+}
+
+inline double QCerenkov_MockTest::Chi2(const std::vector<int>& a, const std::vector<int>& b, int& ndf) // static
+{
+    double c2 = 0. ;
+    ndf = 0 ;
+    for(unsigned i=0 ; i < a.size() ; i++)
+    {
+        double s = a[i] + b[i] ;
+        if( s == 0. ) continue ;
+        c2 += (a[i] - b[i])*(a[i] - b[i])/s ;
+        ndf += 1 ;
+    }
+    return c2 ;
+}
+
+inline QCerenkov_MockTest::QCerenkov_MockTest()
+    :
+    num(ssys::getenvint("NUM", 100000)),
+    mat(nullptr),
+    sur(nullptr),
+    bd(nullptr),
+    bnd(nullptr),
+    optical(nullptr),
+    qo(nullptr),
+    qb(nullptr),
+    ckcdf(nullptr)
+{
+    init();
+}
+
+inline void QCerenkov_MockTest::init()
+{
+    int nl = dom.length ;
+    int num_mat = 3 ;
+    mat = NP::Make<double>(num_mat, 2, nl, 4) ;
+    sur = NP::Make<double>(1, 2, nl, 4) ;
+    double* mm = mat->values<double>() ;
+    for(int m=0 ; m < num_mat ; m++)
+    for(int l=0 ; l < nl ; l++)
+    {
+        double* v = mm + ((m*2 + 0)*nl + l)*4 ;
+        v[0] = RINDEX(m, dom.wavelength_nm[l]) ;
+        v[1] = 1e6 ;
+        v[2] = 1e6 ;
+        v[3] = 0. ;
+    }
+
+    std::vector<int4> vbd = { make_int4(0,-1,-1,1), make_int4(1,-1,-1,2), make_int4(2,-1,-1,0) } ;
+    std::vector<std::string> bdname = { "Water///LS", "LS///Air", "Air///Water" } ;
+    bd = sstandard::make_bd(vbd, bdname) ;
+    bnd = sstandard::make_bnd(vbd, bdname, mat, sur) ;
+
+    optical = NP::Make<int>(bnd->shape[0], 4, 4) ;
+    qo = new QOptical(optical) ;
+    qb = new QBnd(bnd) ;
+
+    NP* wavelength = dom.get_wavelength_nm() ;
+    ckcdf = scerenkov_cdf::Create(wavelength, mat, bd) ;
+
+    ck_rej = {} ;
+    ck_rej.bnd = qb->d_qb ;
+
+    ck_cdf = ck_rej ;
+    ck_cdf.cdf = ckcdf->cdf->values<float>() ;
+    ck_cdf.cdf_energy = ckcdf->energy->values<float>() ;
+    ck_cdf.cdf_line = ckcdf->line->values<int>() ;
+    ck_cdf.cdf_nb = ckcdf->cdf->shape[1] ;
+    ck_cdf.cdf_ne = ckcdf->cdf->shape[2] ;
+    ck_cdf.cdf_nline = ckcdf->line->shape[0] ;
+    ck_cdf.cdf_bi0 = ckcdf->bi0 ;
+    ck_cdf.cdf_bistep = ckcdf->bistep ;
+
+    std::cout << ckcdf->desc() << "\n" ;
+}
+
+/**
+QCerenkov_MockTest::nmax
+--------------------------
+
+Max boundary texture RINDEX within the wavelength range, as G4Cerenkov
+does for maxSin2 of the rejection sampling.
+
+**/
+
+inline double QCerenkov_MockTest::nmax(unsigned line, float Wmin, float Wmax) const
+{
+    double mx = 0. ;
+    for(double nm = Wmin ; nm <= Wmax ; nm += 0.1 ) mx = std::max( mx, double(qb->qb->boundary_lookup(nm, line, 0u).x) ) ;
+    return mx ;
+}
+
+inline int QCerenkov_MockTest::parity(unsigned line, float BetaInverse)
+{
+    quad6 _gs ;
+    scerenkov& gs = (scerenkov&)_gs ;
+    scerenkov::FillGenstep( gs, line, num, false );
+    float nMax = nmax(line, gs.Wmin, gs.Wmax) ;
+    gs.BetaInverse = BetaInverse ;
+    gs.maxCos = BetaInverse/nMax ;
+    gs.maxSin2 = (1.f - gs.maxCos)*(1.f + gs.maxCos) ;
+
+    float e0 = gs.Pmin() ;
+    float e1 = gs.Pmax() ;
+    float c0 = BetaInverse/nMax ;
+    float c1 = 1.f ;
+
+    std::vector<int> he[2] ;
+    std::vector<int> hc[2] ;
+    unsigned long long nrng[2] ;
+    double dt[2] ;
+
+    for(int k=0 ; k < 2 ; k++)
+    {
+        const qcerenkov& ck = k == 0 ? ck_rej : ck_cdf ;
+        he[k].resize(NB, 0) ;
+        hc[k].resize(NB, 0) ;
+
+        RNG rng ;
+        float wavelength ;
+        float cosTheta ;
+        float sin2Theta ;
+
+        auto t0 = std::chrono::steady_clock::now() ;
+        for(int i=0 ; i < num ; i++)
+        {
+            if( k == 0 ) ck.wavelength_sampled_bndtex(wavelength, cosTheta, sin2Theta, rng, gs, i, 0 ) ;
+            if( k == 1 ) ck.wavelength_sampled_cdf(   wavelength, cosTheta, sin2Theta, rng, gs, i, 0 ) ;
+
+            float energy = smath::hc_eVnm/wavelength ;
+            int ie = int( NB*(energy - e0)/(e1 - e0) ) ;
+            int ic = int( NB*(cosTheta - c0)/(c1 - c0) ) ;
+            he[k][std::min(std::max(ie, 0), NB-1)] += 1 ;
+            hc[k][std::min(std::max(ic, 0), NB-1)] += 1 ;
+        }
+        auto t1 = std::chrono::steady_clock::now() ;
+        nrng[k] = rng.count ;
+        dt[k] = std::chrono::duration<double>(t1 - t0).count() ;
+    }
+
+    int ndf_e, ndf_c ;
+    double chi2_e = Chi2(he[0], he[1], ndf_e) ;
+    double chi2_c = Chi2(hc[0], hc[1], ndf_c) ;
+    double r_e = chi2_e/std::max(ndf_e, 1) ;
+    double r_c = chi2_c/std::max(ndf_c, 1) ;
+    int rc = int( r_e > 2. ) + int( r_c > 2. ) + int( nrng[1] > nrng[0] ) ;
+
+    std::cout
+        << "QCerenkov_MockTest::parity"
+        << " line " << line
+        << " BetaInverse " << std::fixed << std::setprecision(3) << BetaInverse
+        << " nMax " << nMax
+        << " num " << num
+        << "\n"
+        << "    rng/photon rej " << std::setw(7) << double(nrng[0])/num << " cdf " << std::setw(7) << double(nrng[1])/num
+        << " ns/photon rej " << std::setw(7) << std::setprecision(1) << 1e9*dt[0]/num << " cdf " << std::setw(7) << 1e9*dt[1]/num
+        << " chi2/ndf energy " << std::setprecision(3) << r_e << " cosTheta " << r_c
+        << " rc " << rc
+        << "\n"
+        ;
+    return rc ;
+}
+
+inline int QCerenkov_MockTest::generate()
+{
+    quad6 _gs ;
+    scerenkov& gs = (scerenkov&)_gs ;
+    scerenkov::FillGenstep( gs, 3, num, false );   // LS line
+    RNG rng ;
+    int rc = 0 ;
+    for(int i=0 ; i < 1000 ; i++)
+    {
+        sphoton p = {} ;
+        ck_cdf.generate(p, rng, _gs, i, 0) ;
+        rc += int( p.flagmask != CERENKOV ) ;
+        rc += int( p.wavelength < gs.Wmin || p.wavelength > gs.Wmax ) ;
+        rc += int( std::abs( length(p.mom) - 1.f ) > 1e-5f ) ;
+    }
+    std::cout << "QCerenkov_MockTest::generate rc " << rc << "\n" ;
+    return rc ;
+}
+
+inline int QCerenkov_MockTest::run()
+{
+    int rc = 0 ;
+    rc += parity(0, 1.00f) ;   // Water : relativistic
+    rc += parity(0, 1.30f) ;   //         below min RINDEX
+    rc += parity(0, 1.36f) ;   //         close to threshold, cut
+    rc += parity(3, 1.00f) ;   // LS
+    rc += parity(3, 1.45f) ;   //         below min RINDEX
+    rc += parity(3, 1.52f) ;   //         cut
+    rc += parity(3, 1.70f) ;   //         only the UV peak
+    rc += generate();
+    return rc ;
+}
+
+int main()
+{
+    QCerenkov_MockTest t ;
+    return t.run() == 0 ? 0 : 1 ;
+}
@@ -0,0 +1,58 @@
+#!/bin/bash
+usage(){ cat << EOU
+QCerenkov_MockTest.sh
+=======================
+
+CPU parity and benchmark of Cerenkov rejection sampling vs envelope ICDF sampling::
+
+   ~/o/qudarap/tests/QCerenkov_MockTest.sh
+   NUM=1000000 ~/o/qudarap/tests/QCerenkov_MockTest.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=QCerenkov_MockTest
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=${TMP:-/tmp/$USER/opticks}/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+vars="BASH_SOURCE PWD FOLD name bin CUDA_PREFIX OPTICKS_PREFIX NUM"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc \
+       ../QBnd.cc \
+       ../QTex.cc \
+       ../QOptical.cc \
+       -O2 \
+       -std=c++17 -lstdc++ -lm \
+       -DMOCK_CURAND \
+       -DMOCK_CUDA \
+       -DMOCK_TEXTURE \
+       -I.. \
+       -I../../sysrap \
+       -I$CUDA_PREFIX/include \
+       -I$OPTICKS_PREFIX/externals/glm/glm \
+       -I$OPTICKS_PREFIX/externals/plog/include \
+       -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
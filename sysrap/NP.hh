@@ -48,6 +48,7 @@ but the headers are also copied into opticks/sysrap.
 #include <map>
 #include <functional>
 #include <locale>
+#include <cctype>
 
 #include "NPU.hh"
 
@@ -107,6 +108,272 @@ inline int NP_slice<T>::count() const
 }
 
 
+/**
+NP_where
+----------
+
+Predicate over the elements of array items, compiled once from an
+expression string and evaluated on raw item bytes, used by
+NP::load_data_where to select items while streaming blocks from file.
+Expressions are disjunctions "||" of conjunctions "&&" of terms::
+
+    u[3,0]&0xffff==0x40               ## element [3,0] as uint, masked
+    f[0,3]>10&&f[0,3]<20              ## time window
+    u[3,3]&0x40                       ## no comparison : nonzero test
+
+Elements are addressed by their item indices, optionally prefixed by
+the type 'u' 'i' or 'f' used to interpret the element bits, the
+default being the array type. Modifiers ">>N" and "&M" are applied in order
+(integer types only).
+
+Names of sphoton fields of (4,4) items are aliases for the element
+forms, matching the python lambdas in sphoton.h::
+
+    flag==0x40&&boundary==3
+    time>10&&time<20
+    identity>=1000&&identity<2000
+    flagmask&0x40
+
+**/
+
+struct NP_where
+{
+    typedef std::int64_t INT ;
+    enum { NZ, EQ, NE, LT, LE, GT, GE } ;
+    enum { SHIFT, MASK } ;
+
+    struct Term
+    {
+        INT  elem ;
+        char type ;
+        std::vector<std::pair<int, std::uint64_t>> mods ;
+        int  op ;
+        double        fval ;
+        std::int64_t  ival ;
+        std::uint64_t uval ;
+    };
+
+    std::vector<INT> shape ;
+    char uifc ;
+    int  ebyte ;
+    std::vector<std::vector<Term>> any ;
+
+    static const char* Alias(const std::string& name);
+    static NP_where* Compile(const char* expr, const std::vector<INT>& shape, char uifc, int ebyte);
+
+    bool parse_term(Term& t, const std::string& s) const ;
+    bool select(const char* item) const ;
+    bool eval(const Term& t, const char* item) const ;
+};
+
+inline const char* NP_where::Alias(const std::string& name) // static
+{
+    static const char* ALIAS[][2] = {
+        { "pos_x", "f[0,0]" }, { "pos_y", "f[0,1]" }, { "pos_z", "f[0,2]" }, { "time", "f[0,3]" },
+        { "mom_x", "f[1,0]" }, { "mom_y", "f[1,1]" }, { "mom_z", "f[1,2]" }, { "iindex", "u[1,3]" },
+        { "pol_x", "f[2,0]" }, { "pol_y", "f[2,1]" }, { "pol_z", "f[2,2]" }, { "wavelength", "f[2,3]" },
+        { "boundary_flag", "u[3,0]" }, { "flag", "u[3,0]&0xffff" }, { "boundary", "u[3,0]>>16" },
+        { "identity", "u[3,1]" }, { "orient_idx", "u[3,2]" }, { "idx", "u[3,2]&0x7fffffff" },
+        { "flagmask", "u[3,3]" }
+    } ;
+    unsigned num_alias = sizeof(ALIAS)/sizeof(ALIAS[0]) ;
+    for(unsigned i=0 ; i < num_alias ; i++) if(name.compare(ALIAS[i][0]) == 0) return ALIAS[i][1] ;
+    return nullptr ;
+}
+
+/**
+NP_where::Compile
+-------------------
+
+Returns nullptr when the expression does not parse
+or addresses elements outside the item shape.
+
+**/
+
+inline NP_where* NP_where::Compile(const char* expr, const std::vector<INT>& shape, char uifc, int ebyte) // static
+{
+    if(expr == nullptr || shape.size() < 1 || ( ebyte != 4 && ebyte != 8 )) return nullptr ;
+
+    std::string s ;
+    for(const char* c=expr ; *c ; c++) if(!isspace(*c)) s += *c ;
+
+    NP_where* w = new NP_where ;
+    w->shape = shape ;
+    w->uifc = uifc ;
+    w->ebyte = ebyte ;
+
+    size_t a = 0 ;
+    while( a <= s.size() )
+    {
+        size_t b = s.find("||", a) ;
+        std::string alt = s.substr(a, b == std::string::npos ? std::string::npos : b - a ) ;
+        std::vector<Term> all ;
+        size_t c = 0 ;
+        while( c <= alt.size() )
+        {
+            size_t d = alt.find("&&", c) ;
+            Term t ;
+            if(!w->parse_term(t, alt.substr(c, d == std::string::npos ? std::string::npos : d - c)))
+            {
+                std::cerr << "NP_where::Compile FAILED to parse [" << expr << "]\n" ;
+                delete w ;
+                return nullptr ;
+            }
+            all.push_back(t);
+            if( d == std::string::npos ) break ;
+            c = d + 2 ;
+        }
+        w->any.push_back(all);
+        if( b == std::string::npos ) break ;
+        a = b + 2 ;
+    }
+    return w ;
+}
+
+inline bool NP_where::parse_term(Term& t, const std::string& _s) const
+{
+    const char* OPS[] = { "==", "!=", "<=", ">=", "<", ">" } ;
+    const int   OPV[] = {  EQ,   NE,   LE,   GE,   LT,  GT  } ;
+
+    std::string lhs = _s ;
+    std::string rhs ;
+    t.op = NZ ;
+    for(int i=0 ; i < 6 ; i++)
+    {
+        size_t p = _s.find(OPS[i]) ;
+        if( p != std::string::npos && _s.compare(p, 2, ">>") == 0 ) p = _s.find(OPS[i], p + 2) ;  // skip shift
+        if( p == std::string::npos ) continue ;
+        lhs = _s.substr(0, p) ;
+        rhs = _s.substr(p + strlen(OPS[i])) ;
+        t.op = OPV[i] ;
+        break ;
+    }
+    if(lhs.empty()) return false ;
+
+    // expand leading alias
+    size_t n = 0 ;
+    while( n < lhs.size() && ( isalpha(lhs[n]) || lhs[n] == '_' )) n++ ;
+    const char* alias = n > 1 ? Alias(lhs.substr(0, n)) : nullptr ;
+    if( n > 1 && alias == nullptr ) return false ;
+    if( alias ) lhs = std::string(alias) + lhs.substr(n) ;
+
+    const char* c = lhs.c_str() ;
+    t.type = uifc ;
+    if( *c == 'u' || *c == 'i' || *c == 'f' ) t.type = *c++ ;
+    if( *c != '[' ) return false ;
+    c++ ;
+
+    std::vector<INT> idx ;
+    char* end = nullptr ;
+    while( *c && *c != ']' )
+    {
+        idx.push_back( strtoll(c, &end, 10) );
+        if( end == c ) return false ;
+        c = end ;
+        if( *c == ',' ) c++ ;
+    }
+    if( *c != ']' ) return false ;
+    c++ ;
+
+    if( idx.size() != shape.size() - 1 ) return false ;
+    t.elem = 0 ;
+    for(unsigned d=0 ; d < idx.size() ; d++)
+    {
+        if( idx[d] < 0 || idx[d] >= shape[d+1] ) return false ;
+        t.elem = t.elem*shape[d+1] + idx[d] ;
+    }
+
+    while( *c )
+    {
+        int kind = -1 ;
+        if( c[0] == '>' && c[1] == '>' ) { kind = SHIFT ; c += 2 ; }
+        else if( c[0] == '&' )           { kind = MASK  ; c += 1 ; }
+        if( kind < 0 || t.type == 'f' ) return false ;
+        std::uint64_t v = strtoull(c, &end, 0) ;
+        if( end == c ) return false ;
+        t.mods.push_back( std::make_pair(kind, v) );
+        c = end ;
+    }
+
+    t.fval = 0. ;
+    t.ival = 0 ;
+    t.uval = 0 ;
+    if( t.op != NZ )
+    {
+        const char* r = rhs.c_str() ;
+        if( t.type == 'f' ) t.fval = strtod(r, &end) ;
+        if( t.type == 'i' ) t.ival = strtoll(r, &end, 0) ;
+        if( t.type == 'u' ) t.uval = strtoull(r, &end, 0) ;
+        if( end == r || *end != '\0' ) return false ;
+    }
+    return true ;
+}
+
+inline bool NP_where::eval(const Term& t, const char* item) const
+{
+    const char* e = item + t.elem*ebyte ;
+    if( t.type == 'f' )
+    {
+        double v ;
+        if( ebyte == 4 ) { float f ; memcpy(&f, e, 4) ; v = f ; } else { memcpy(&v, e, 8) ; }
+        switch(t.op)
+        {
+            case NZ: return v != 0. ;
+            case EQ: return v == t.fval ;
+            case NE: return v != t.fval ;
+            case LT: return v <  t.fval ;
+            case LE: return v <= t.fval ;
+            case GT: return v >  t.fval ;
+            case GE: return v >= t.fval ;
+        }
+        return false ;
+    }
+
+    std::uint64_t u ;
+    if( ebyte == 4 ) { std::uint32_t u4 ; memcpy(&u4, e, 4) ; u = u4 ; } else { memcpy(&u, e, 8) ; }
+    for(unsigned m=0 ; m < t.mods.size() ; m++) u = t.mods[m].first == SHIFT ? u >> t.mods[m].second : u & t.mods[m].second ;
+
+    if( t.type == 'i' )
+    {
+        std::int64_t v = ebyte == 4 && t.mods.empty() ? std::int64_t(std::int32_t(u)) : std::int64_t(u) ;
+        switch(t.op)
+        {
+            case NZ: return v != 0 ;
+            case EQ: return v == t.ival ;
+            case NE: return v != t.ival ;
+            case LT: return v <  t.ival ;
+            case LE: return v <= t.ival ;
+            case GT: return v >  t.ival ;
+            case GE: return v >= t.ival ;
+        }
+        return false ;
+    }
+
+    switch(t.op)
+    {
+        case NZ: return u != 0 ;
+        case EQ: return u == t.uval ;
+        case NE: return u != t.uval ;
+        case LT: return u <  t.uval ;
+        case LE: return u <= t.uval ;
+        case GT: return u >  t.uval ;
+        case GE: return u >= t.uval ;
+    }
+    return false ;
+}
+
+inline bool NP_where::select(const char* item) const
+{
+    for(unsigned a=0 ; a < any.size() ; a++)
+    {
+        const std::vector<Term>& all = any[a] ;
+        bool ok = true ;
+        for(unsigned i=0 ; i < all.size() && ok ; i++) ok = eval(all[i], item) ;
+        if(ok) return true ;
+    }
+    return false ;
+}
+
 struct NP
 {
     typedef std::int64_t INT ;
@@ -214,6 +481,7 @@ struct NP
     bool has_shape(INT ni=-1, INT nj=-1, INT nk=-1, INT nl=-1, INT nm=-1, INT no=-1 ) const ;
     void change_shape(INT ni=-1, INT nj=-1, INT nk=-1, INT nl=-1, INT nm=-1, INT no=-1 ) ;   // one dimension entry left at -1 can be auto-set
     void _change_shape_ni(INT ni, bool data_resize);
+    void swap_data(std::vector<char>& buf, INT ni);  // zero-copy exchange of data buffer, see sarena.h
 
     void change_shape_to_3D() ;
     void reshape( const std::vector<INT>& new_shape ); // product of shape before and after must be the same
@@ -388,6 +656,9 @@ struct NP
     static NP* Load_(const char* path);
     static NP* LoadSlice_(const char* path, const char* sli);
 
+    static NP* LoadWhere(const char* path, const char* expr, const char* idxpath=nullptr);
+    static NP* LoadWhereIndex(const char* path, const char* expr);
+
     static NP* Load(const char* dir, const char* name);
     static NP* Load(const char* dir, const char* reldir, const char* name);
 
@@ -586,6 +857,9 @@ struct NP
     void load_data( std::ifstream* fp, const char* sli );
     void load_data_sliced( std::ifstream* fp, const char* sli );
     void load_data_where(  std::ifstream* fp, const char* _sli );
+    static bool LooksLikeWherePredicate(const char* spec);
+    static constexpr const char* NP__WHERE_CHUNK = "NP__WHERE_CHUNK" ;
+    INT  load_data_where_predicate( std::ifstream* fp, const char* expr, std::vector<INT>* idx, bool keep );
 
 
     int load_string_(  const char* path, const char* ext, std::string& str );
@@ -1617,6 +1891,34 @@ inline void NP::_change_shape_ni(INT ni, bool data_resize)
 
 
 
+/**
+NP::swap_data
+---------------
+
+Exchanges the data buffer with *buf* without copying
+and changes the first dimension to *ni*, the item shape is unchanged.
+The incoming *buf* size must be consistent with *ni* items.
+Used by sarena.h to allow pooled hostside buffers to be viewed
+by arrays without copying.
+
+**/
+
+inline void NP::swap_data(std::vector<char>& buf, INT ni)
+{
+    unsigned ndim = shape.size() ;
+    assert( ndim > 0 );
+    INT xbytes = ni*item_bytes() ;
+    bool expect = INT(buf.size()) == xbytes ;
+    if(!expect) std::cerr << "NP::swap_data buf.size " << buf.size() << " xbytes " << xbytes << std::endl ;
+    assert( expect );
+
+    data.swap(buf);
+    shape[0] = ni ;
+    size = NPS::size(shape);
+}
+
+
+
 inline void NP::change_shape_to_3D()
 {
     unsigned ndim = shape.size() ;
@@ -7355,6 +7657,7 @@ Example spec that would cause this to be called::
 
     /tmp/w54.npy           ## first loads array of indices that controls which items to load
     /tmp/w54.npy[0:1]      ## first loads slice of indices array that controls which items to load
+    flag==0x40&&time<20    ## predicate on item elements, see NP_where and NP::load_data_where_predicate
 
 1. load the where array
 2. count *sliced_ni* indices from where array that are less than ni0
@@ -7366,6 +7669,12 @@ Example spec that would cause this to be called::
 
 inline void NP::load_data_where( std::ifstream* fp, const char* spec )
 {
+    if(LooksLikeWherePredicate(spec))   // eg "flag==0x40&&time<20"
+    {
+        load_data_where_predicate( fp, spec, nullptr, true );
+        return ;
+    }
+
     char* path = nullptr ;
     char* sli = nullptr ;
     bool with_suffix = LooksLikeSliceIndexStringSuffix(spec, &path, &sli );  // ends with eg "[0:5]"
@@ -7455,6 +7764,171 @@ inline void NP::load_data_where( std::ifstream* fp, const char* spec )
 
 
 
+/**
+NP::LooksLikeWherePredicate
+-----------------------------
+
+Where specs that are not paths to .npy index arrays are predicates.
+
+**/
+
+inline bool NP::LooksLikeWherePredicate(const char* spec) // static
+{
+    return spec && strlen(spec) > 0 && strstr(spec, EXT) == nullptr ;
+}
+
+/**
+NP::load_data_where_predicate
+-------------------------------
+
+Compiles *expr* into NP_where once and streams blocks of items from
+the file, evaluating the predicate on each item. Memory is constant
+apart from the selected items and indices, the block size in items
+is controlled by envvar NP__WHERE_CHUNK, default 65536.
+
+fp
+    positioned after the header
+idx
+    when non-null collects the indices of selected items
+keep
+    when true the selected items become the data of this array
+    with shape changed accordingly, otherwise the shape is unchanged
+    and data remains empty
+
+Returns the number of selected items, or -1 when *expr* does not compile.
+
+**/
+
+inline NP::INT NP::load_data_where_predicate( std::ifstream* fp, const char* expr, std::vector<INT>* idx, bool keep )
+{
+    NP_where* w = NP_where::Compile(expr, shape, uifc, ebyte) ;
+    if( w == nullptr )
+    {
+        std::cerr << "NP::load_data_where_predicate FAILED to compile [" << ( expr ? expr : "-" ) << "] for " << sstr() << "\n" ;
+        if(keep) _change_shape_ni(0, true) ;
+        return -1 ;
+    }
+
+    INT ni0 = shape[0] ;
+    INT itemsize = item_bytes() ;
+    INT chunk = std::max(1, U::GetEnvInt(NP__WHERE_CHUNK, 65536)) ;
+
+    std::vector<char> buf(chunk*itemsize) ;
+    data.clear();
+
+    INT count = 0 ;
+    for(INT i0=0 ; i0 < ni0 ; i0 += chunk )
+    {
+        INT n = std::min(chunk, ni0 - i0) ;
+        fp->read( buf.data(), n*itemsize );
+        if(fp->gcount() != n*itemsize) std::cerr << "NP::load_data_where_predicate TRUNCATED file at item " << i0 << "\n" ;
+        if(fp->gcount() != n*itemsize) break ;
+
+        for(INT i=0 ; i < n ; i++)
+        {
+            const char* item = buf.data() + i*itemsize ;
+            if(!w->select(item)) continue ;
+            if(keep) data.insert( data.end(), item, item + itemsize );
+            if(idx) idx->push_back(i0 + i) ;
+            count += 1 ;
+        }
+    }
+    delete w ;
+
+    if(keep) _change_shape_ni(count, false) ;
+
+    if(VERBOSE)
+    std::cout
+        << "NP::load_data_where_predicate"
+        << " expr " << expr
+        << " ni0 " << ni0
+        << " chunk " << chunk
+        << " count " << count
+        << "\n"
+        ;
+    return count ;
+}
+
+/**
+NP::LoadWhere
+---------------
+
+Loads only the items of the array at *path* that satisfy predicate
+*expr*, see NP_where for the syntax. When *idxpath* is provided the
+int64 indices of the selected items are saved there, usable as where
+array spec to load the same items from other arrays, eg::
+
+    NP* hit = NP::LoadWhere("/data/evt/A000/photon.npy", "flagmask&0x40", "/tmp/w.npy" );
+    NP* rec = NP::LoadSlice("/data/evt/A000/record.npy", "/tmp/w.npy" );
+
+The predicate is recorded in the "where" metadata of the array.
+
+**/
+
+inline NP* NP::LoadWhere(const char* _path, const char* expr, const char* idxpath) // static
+{
+    const char* path = U::Resolve(_path);
+    if(path == nullptr || !Exists(path)) return nullptr ;
+
+    NP* a = new NP ;
+    std::ifstream* fp = a->load_header(path, expr);
+    if(fp == nullptr) return nullptr ;
+
+    std::vector<INT> idx ;
+    INT count = a->load_data_where_predicate(fp, expr, idxpath ? &idx : nullptr, true );
+    delete fp ;
+
+    if(count < 0)
+    {
+        delete a ;
+        return nullptr ;
+    }
+    a->load_meta( path );
+    a->load_names( path );
+    a->load_labels( path );
+    a->set_meta<std::string>("where", expr );
+
+    if(idxpath)
+    {
+        NP* w = MakeFromValues<INT>(idx.data(), idx.size()) ;
+        w->set_meta<std::string>("where", expr );
+        w->save(idxpath);
+        delete w ;
+    }
+    return a ;
+}
+
+/**
+NP::LoadWhereIndex
+--------------------
+
+Returns int64 array of the indices of the items of the array at *path*
+that satisfy *expr* without retaining the items, so the memory is
+constant apart from the indices no matter the size of the file.
+
+**/
+
+inline NP* NP::LoadWhereIndex(const char* _path, const char* expr) // static
+{
+    const char* path = U::Resolve(_path);
+    if(path == nullptr || !Exists(path)) return nullptr ;
+
+    NP* a = new NP ;
+    std::ifstream* fp = a->load_header(path, expr);
+    if(fp == nullptr) return nullptr ;
+
+    std::vector<INT> idx ;
+    INT count = a->load_data_where_predicate(fp, expr, &idx, false );
+    delete fp ;
+    delete a ;
+    if(count < 0) return nullptr ;
+
+    NP* w = MakeFromValues<INT>(idx.data(), idx.size()) ;
+    w->set_meta<std::string>("where", expr );
+    return w ;
+}
+
+
 inline int NP::load_string_( const char* path, const char* ext, std::string& str )
 {
     std::string str_path = U::ChangeExt(path, ".npy", ext );
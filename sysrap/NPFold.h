@@ -290,6 +290,7 @@ public:
     void add( const char* k, const NP* a);
     void add_(const char* k, const NP* a);
     void set( const char* k, const NP* a);
+    const NP* remove( const char* k);
 
     static void SplitKeys( std::vector<std::string>& elem , const char* keylist, char delim=',');
     static std::string DescKeys( const std::vector<std::string>& elem, char delim=',' );
@@ -1814,6 +1815,27 @@ inline void NPFold::set(const char* k, const NP* a)
     }
 }
 
+/**
+NPFold::remove
+---------------
+
+Removes the (k,a) pair from the fold without deleting the array,
+returning it or nullptr when the key is not present.
+Ownership passes to the caller, which is needed when the fold
+is a shallowcopy that does not own its arrays.
+
+**/
+
+inline const NP* NPFold::remove(const char* k)
+{
+    int idx = find(k);
+    if(idx == UNDEF) return nullptr ;
+    const NP* a = aa[idx] ;
+    aa.erase( aa.begin() + idx );
+    kk.erase( kk.begin() + idx );
+    return a ;
+}
+
 
 
 
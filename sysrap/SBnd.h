@@ -21,6 +21,7 @@ Principal user QBnd.hh
 #include <array>
 #include <sstream>
 #include <set>
+#include <unordered_map>
 
 #include "NP.hh"
 #include "sstr.h"
@@ -108,6 +109,10 @@ be used::
     NP* mat_from_bd(const NP* bd) const ; 
     NP* reconstruct_sur() const ; 
 
+    static void Dedup( NP*& umat, NP*& usur, NP*& bidx, const NP* bnd ); 
+    static NP*  Redup( const NP* umat, const NP* usur, const NP* bidx ); 
+    static std::string DescDedup( const NP* bnd, const NP* umat, const NP* usur, const NP* bidx ); 
+
 };
 
 
@@ -733,3 +738,127 @@ inline NP* SBnd::reconstruct_sur() const
     return nullptr ; 
 }
 
+
+/**
+SBnd::Dedup
+-------------
+
+The bnd array eg (53, 4, 2, 761, 4) repeats the full (2,761,4) payload
+of a material or surface for every boundary that uses it, so the same
+Water or Acrylic table appears many times. This splits the bnd into::
+
+    umat  (num_umat, 2, 761, 4)   unique omat/imat payloads
+    usur  (num_usur, 2, 761, 4)   unique osur/isur payloads, including the -1 filled "no surface" one
+    bidx  (num_bnd, 4) int        index into umat for j=0,3 and into usur for j=1,2
+
+Uniqueness is by payload bytes rather than by the bd int pointers,
+so the split works with any bnd array including loaded ones and
+SBnd::Redup gives back exactly the original values.
+The umat/usur names are the spec elements of the first boundary using each
+payload and the domain metadata needed by QBnd::MakeBoundaryTex is copied.
+
+**/
+
+inline void SBnd::Dedup( NP*& umat, NP*& usur, NP*& bidx, const NP* bnd ) // static 
+{
+    assert( bnd && bnd->uifc == 'f' && bnd->shape.size() == 5 ); 
+    const std::vector<NP::INT>& sh = bnd->shape ; 
+    int ni = sh[0] ; 
+    int nj = sh[1] ; 
+    assert( nj == 4 ); 
+    NP::INT item_bytes = sh[2]*sh[3]*sh[4]*bnd->ebyte ; 
+    const char* src = bnd->bytes() ;  
+
+    bidx = NP::Make<int>(ni, nj) ; 
+    bidx->set_names( bnd->names ); 
+    int* bidx_v = bidx->values<int>() ; 
+
+    std::vector<NP::INT> first[2] ;   // (i*nj+j) of first occurrence for mat and sur
+    std::vector<std::string> names[2] ; 
+    std::unordered_map<std::string, int> seen[2] ; 
+
+    for(int i=0 ; i < ni ; i++)
+    {
+        std::vector<std::string> elem ; 
+        if( i < int(bnd->names.size()) ) sstr::Split(bnd->names[i].c_str(), '/', elem ); 
+
+        for(int j=0 ; j < nj ; j++)
+        {
+            int s = ( j == 0 || j == 3 ) ? 0 : 1 ; 
+            NP::INT item = i*nj + j ; 
+            std::string key(src + item*item_bytes, item_bytes) ; 
+            std::unordered_map<std::string, int>::const_iterator it = seen[s].find(key) ; 
+            int u = it == seen[s].end() ? int(first[s].size()) : it->second ; 
+            if( u == int(first[s].size()) )
+            {
+                seen[s][key] = u ; 
+                first[s].push_back(item) ; 
+                names[s].push_back( j < int(elem.size()) ? elem[j] : "" ) ; 
+            }
+            bidx_v[item] = u ; 
+        }
+    }
+
+    NP* uu[2] ; 
+    for(int s=0 ; s < 2 ; s++)
+    {
+        int nu = first[s].size() ; 
+        NP* u = new NP(bnd->dtype, nu, sh[2], sh[3], sh[4] ); 
+        for(int k=0 ; k < nu ; k++) memcpy( u->bytes() + k*item_bytes, src + first[s][k]*item_bytes, item_bytes ); 
+        u->set_names( names[s] ); 
+        u->meta = bnd->meta ; 
+        uu[s] = u ; 
+    }
+    umat = uu[0] ; 
+    usur = uu[1] ; 
+}
+
+/**
+SBnd::Redup
+-------------
+
+Converse of SBnd::Dedup, used to check the split layout
+
+**/
+
+inline NP* SBnd::Redup( const NP* umat, const NP* usur, const NP* bidx ) // static 
+{
+    assert( umat && usur && bidx && strcmp(umat->dtype, usur->dtype) == 0 ); 
+    assert( umat->shape.size() == 4 && usur->shape.size() == 4 ); 
+    for(int d=1 ; d < 4 ; d++) assert( umat->shape[d] == usur->shape[d] ); 
+    const std::vector<NP::INT>& sh = umat->shape ; 
+    int ni = bidx->shape[0] ; 
+    int nj = bidx->shape[1] ; 
+    NP::INT item_bytes = sh[1]*sh[2]*sh[3]*umat->ebyte ; 
+    const int* bidx_v = bidx->cvalues<int>() ; 
+
+    NP* bnd = new NP(umat->dtype, ni, nj, sh[1], sh[2], sh[3] ); 
+    bnd->set_names( bidx->names ); 
+    bnd->meta = umat->meta ; 
+
+    for(int i=0 ; i < ni ; i++)
+    for(int j=0 ; j < nj ; j++)
+    {
+        NP::INT item = i*nj + j ; 
+        const NP* u = ( j == 0 || j == 3 ) ? umat : usur ; 
+        int k = bidx_v[item] ;  
+        assert( k > -1 && k < u->shape[0] ); 
+        memcpy( bnd->bytes() + item*item_bytes, u->bytes() + k*item_bytes, item_bytes ); 
+    }
+    return bnd ; 
+}
+
+inline std::string SBnd::DescDedup( const NP* bnd, const NP* umat, const NP* usur, const NP* bidx ) // static 
+{
+    std::stringstream ss ; 
+    ss << "SBnd::DescDedup" 
+       << " bnd " << ( bnd ? bnd->sstr() : "-" ) 
+       << " bytes " << ( bnd ? bnd->arr_bytes() : 0 ) 
+       << " umat " << ( umat ? umat->sstr() : "-" ) 
+       << " usur " << ( usur ? usur->sstr() : "-" ) 
+       << " bidx " << ( bidx ? bidx->sstr() : "-" )
+       << " bytes " << ( umat && usur && bidx ? umat->arr_bytes() + usur->arr_bytes() + bidx->arr_bytes() : 0 ) 
+       ; 
+    std::string str = ss.str(); 
+    return str ; 
+}
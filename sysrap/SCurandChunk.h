@@ -8,6 +8,14 @@ The Load_ and Save methods are specific to curandStateXORWOW, most
 of the rest is more general. But there is no need 
 for saving states for counter based RNG such as Philox 
 
+load and loadRange use Map_ which memory maps only the pages
+covering the requested slots of the chunk file rather than
+reading the file through stdio, so loading the states needed
+for a range of photon slots does not touch the rest of the chunk.
+
+generate creates the chunk states on the host with SCurandXORWOW,
+bitwise matching the curand_init done on device by QCurandState::initChunk.
+
 ::
 
     ~/o/sysrap/tests/SCurandState_test.sh
@@ -15,6 +23,11 @@ for saving states for counter based RNG such as Philox
 **/
 
 #include <iomanip>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "sdirectory.h"
 #include "spath.h"
@@ -22,6 +35,7 @@ for saving states for counter based RNG such as Philox
 #include "ssys.h"
 #include "scurandref.h"
 #include "sdigest.h"
+#include "SCurandXORWOW.h"
 
 #include "SYSRAP_API_EXPORT.hh"
 
@@ -69,6 +83,11 @@ struct SYSRAP_API SCurandChunk
     static int OldLoad( SCurandChunk& chunk, const char* name, ULL q_num=0, const char* _dir=nullptr );
     static curandStateXORWOW* Load_( ULL& file_num, const char* path, ULL read_num, sdigest* dig ); 
 
+    scurandref<curandStateXORWOW> loadRange(ULL i0, ULL read_num, const char* _dir=nullptr, sdigest* dig=nullptr ) const ; 
+    static curandStateXORWOW* Map_( ULL& file_num, const char* path, ULL i0, ULL read_num, sdigest* dig ); 
+
+    curandStateXORWOW* generate(int num_thread=0) const ; 
+
     static int Save( curandStateXORWOW* states, unsigned num_states, const char* path ) ; 
     int save( const char* _dir=nullptr ) const ; 
 };
@@ -407,13 +426,29 @@ inline unsigned long long SCurandChunk::NumTotal_InRange( const std::vector<SCur
 
 
 inline scurandref<curandStateXORWOW> SCurandChunk::load( ULL read_num, const char* _dir, sdigest* dig ) const
+{
+    return loadRange(0, read_num, _dir, dig ); 
+}
+
+/**
+SCurandChunk::loadRange
+-------------------------
+
+Loads states for chunk local slots [i0, i0+read_num), read_num 0 means
+all slots from i0 to the end of the chunk. The returned ref has
+chunk_offset of the first loaded slot.
+
+**/
+
+inline scurandref<curandStateXORWOW> SCurandChunk::loadRange( ULL i0, ULL read_num, const char* _dir, sdigest* dig ) const
 {
     scurandref<curandStateXORWOW> lref(ref); 
     const char* p = path(_dir); 
 
     ULL file_num = 0 ; 
-    lref.states = Load_(file_num, p, read_num, dig );
-    lref.num = read_num ; 
+    lref.states = Map_(file_num, p, i0, read_num, dig );
+    lref.num = read_num == 0 && file_num > i0 ? file_num - i0 : read_num ; 
+    lref.chunk_offset = ref.chunk_offset + i0 ; 
 
     return lref ;
 }
@@ -535,6 +570,106 @@ inline curandStateXORWOW* SCurandChunk::Load_( ULL& file_num, const char* path,
 }
 
 
+/**
+SCurandChunk::Map_
+--------------------
+
+Memory maps the page aligned byte range of the STATE_SIZE records
+for slots [i0, i0+read_num) and unpacks them into malloc-ed states,
+which are padded in memory compared to the file records.
+The digest covers the loaded record bytes, so loading from slot zero
+matches the md5sum of the file bytes as for Load_.
+
+**/
+
+inline curandStateXORWOW* SCurandChunk::Map_( ULL& file_num, const char* path, ULL i0, ULL read_num, sdigest* dig )
+{
+    int fd = open(path, O_RDONLY);
+    bool open_failed = fd < 0 ; 
+    if(open_failed) std::cerr 
+        << "SCurandChunk::Map_"
+        << " unable to open file "
+        << "[" << path << "]" 
+        << "\n" 
+        ; 
+    if(open_failed) return nullptr ; 
+
+    struct stat st ; 
+    fstat(fd, &st); 
+    ULL file_size = st.st_size ; 
+
+    bool expected_size = file_size % STATE_SIZE == 0 ; 
+    file_num = file_size/STATE_SIZE ; 
+    if(read_num == 0 && i0 < file_num) read_num = file_num - i0 ;  // 0 means all remaining 
+
+    bool range_ok = expected_size && read_num > 0 && i0 + read_num <= file_num ; 
+    if(!range_ok) std::cerr 
+        << "SCurandChunk::Map_"
+        << " expected_size " << ( expected_size ? "YES" : "NO " )
+        << " i0 " << i0 
+        << " read_num " << read_num
+        << " file_num " << file_num
+        << "\n" 
+        ;  
+    if(!range_ok)
+    {
+        close(fd); 
+        return nullptr ; 
+    }
+
+    ULL page = sysconf(_SC_PAGESIZE) ; 
+    ULL byte0 = i0*STATE_SIZE ; 
+    ULL byte1 = (i0+read_num)*STATE_SIZE ; 
+    ULL map0 = byte0 - byte0 % page ; 
+    ULL map_size = byte1 - map0 ; 
+
+    void* m = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, map0 ); 
+    close(fd); 
+    if( m == MAP_FAILED ) std::cerr << "SCurandChunk::Map_ mmap FAILED [" << path << "]\n" ; 
+    if( m == MAP_FAILED ) return nullptr ; 
+    madvise(m, map_size, MADV_SEQUENTIAL); 
+
+    const char* rec = (const char*)m + (byte0 - map0) ; 
+    if(dig) 
+    {
+        ULL nbyte = read_num*STATE_SIZE ; 
+        ULL block = 1ull << 30 ; 
+        for(ULL b=0 ; b < nbyte ; b += block ) dig->add( rec + b, int(std::min(block, nbyte - b)) ); 
+    }
+
+    curandStateXORWOW* h_states = (curandStateXORWOW*)malloc(sizeof(curandStateXORWOW)*read_num);
+    for(ULL i = 0 ; i < read_num ; ++i )
+    {
+        curandStateXORWOW& rng = h_states[i] ;
+        const char* r = rec + i*STATE_SIZE ; 
+        memcpy(&rng.d,                      r +  0, sizeof(unsigned)   ); 
+        memcpy( rng.v,                      r +  4, sizeof(unsigned)*5 ); 
+        memcpy(&rng.boxmuller_flag,         r + 24, sizeof(int)        ); 
+        memcpy(&rng.boxmuller_flag_double,  r + 28, sizeof(int)        ); 
+        memcpy(&rng.boxmuller_extra,        r + 32, sizeof(float)      ); 
+        memcpy(&rng.boxmuller_extra_double, r + 36, sizeof(double)     ); 
+    }
+    munmap(m, map_size); 
+    return h_states ; 
+}
+
+/**
+SCurandChunk::generate
+------------------------
+
+Host equivalent of QCurandState::initChunk, curand_init for
+each slot of the chunk with subsequence chunk_offset+i.
+
+**/
+
+inline curandStateXORWOW* SCurandChunk::generate(int num_thread) const
+{
+    curandStateXORWOW* h_states = (curandStateXORWOW*)malloc(sizeof(curandStateXORWOW)*ref.num);
+    const SCurandXORWOW& x = SCurandXORWOW::Get(); 
+    x.fill( h_states, ref.num, ref.seed, ref.chunk_offset, ref.offset, num_thread ); 
+    return h_states ; 
+}
+
 inline int SCurandChunk::Save( curandStateXORWOW* states, unsigned num_states, const char* path ) // static
 {
     sdirectory::MakeDirsForFile(path);
@@ -25,6 +25,23 @@ Can load and upload chunk-by-chunk to complete the contiguous
 states GPU side. 
 
 
+Creating chunks without GPU 
+-----------------------------
+
+createHost generates any missing chunk files on the host using 
+SCurandXORWOW, which is bitwise compatible with curand_init, 
+so the GPU is not needed for QCurandState::initChunk.
+
+
+Loading ranges of slots
+-------------------------
+
+loadRange loads only the states for a range of slots, memory mapping 
+just the needed part of the chunk files that overlap the range.   
+With QRng__LAZY this is used by QRng::prepare to upload per event only 
+the slots needed beyond those already on device. 
+
+
 Related
 --------
 
@@ -67,6 +84,8 @@ struct SYSRAP_API SCurandState
     std::string desc() const ; 
  
     bool is_complete() const ; 
+    int createHost(int num_thread=0) ; 
+    scurandref<curandStateXORWOW> loadRange(ULL slot0, ULL num, sdigest* dig=nullptr ) const ; 
 
     template<typename T>
     T* loadAndUpload( unsigned rngmax ) ; 
@@ -274,6 +293,87 @@ inline bool SCurandState::is_complete() const
 } 
 
 
+/**
+SCurandState::createHost
+--------------------------
+
+Host alternative to QCurandState::init : generates and saves 
+any chunks that do not yet have valid files. Returns 
+the number of chunks created.   
+
+**/
+
+inline int SCurandState::createHost(int num_thread)
+{
+    int num_chunk = chunk.size(); 
+    int count = 0 ; 
+    for(int i=0 ; i < num_chunk ; i++)
+    {
+        SCurandChunk& c = chunk[i]; 
+        if(SCurandChunk::IsValid(c, dir)) continue ;
+
+        c.ref.states = c.generate(num_thread); 
+        int rc = c.save(dir); 
+        free(c.ref.states); 
+        c.ref.states = nullptr ; 
+
+        if(rc == 0) count += 1 ; 
+    }
+    return count ; 
+}
+
+/**
+SCurandState::loadRange
+-------------------------
+
+Returns malloc-ed states for the global slots [slot0, slot0+num), 
+only chunks overlapping the range are accessed and from those only 
+the needed slots are mapped. 
+
+**/
+
+inline scurandref<curandStateXORWOW> SCurandState::loadRange(ULL slot0, ULL num, sdigest* dig ) const
+{
+    scurandref<curandStateXORWOW> r = all ; 
+    r.chunk_offset = slot0 ; 
+    r.num = num ; 
+    r.states = nullptr ; 
+
+    bool range_ok = num > 0 && slot0 + num <= all.num ; 
+    if(!range_ok) std::cerr
+        << "SCurandState::loadRange"
+        << " slot0 " << slot0 
+        << " num " << num 
+        << " all.num " << all.num 
+        << "\n"
+        ;
+    if(!range_ok) return r ; 
+
+    r.states = (curandStateXORWOW*)malloc(sizeof(curandStateXORWOW)*num);
+
+    ULL slot1 = slot0 + num ; 
+    ULL count = 0 ; 
+    for(ULL i=0 ; i < chunk.size() ; i++)
+    {
+        const SCurandChunk& ck = chunk[i]; 
+        ULL c0 = ck.ref.chunk_offset ; 
+        ULL c1 = c0 + ck.ref.num ; 
+        if( c1 <= slot0 || c0 >= slot1 ) continue ;  
+
+        ULL lo = std::max(c0, slot0) ; 
+        ULL hi = std::min(c1, slot1) ; 
+
+        scurandref<curandStateXORWOW> cr = ck.loadRange( lo - c0, hi - lo, dir, dig ); 
+        assert( cr.states ); 
+        memcpy( r.states + (lo - slot0), cr.states, sizeof(curandStateXORWOW)*(hi - lo) ); 
+        free(cr.states); 
+        count += hi - lo ; 
+    }
+    assert( count == num ); 
+    return r ; 
+}
+
+
 /**
 SCurandState::loadAndUpload
 ----------------------------
@@ -0,0 +1,339 @@
+#pragma once
+/**
+SCurandXORWOW.h : host implementation of curand_init for curandStateXORWOW
+============================================================================
+
+Creating SCurandChunk files formerly required the GPU, via
+QCurandState::initChunk launching curand_init. This provides a
+multithreaded host equivalent that is bitwise compatible with
+curand_init(seed, subsequence, offset, &state) so the chunk files for
+billions of photon slots can be prepared on machines without a GPU.
+
+curand_init for XORWOW (see curand_kernel.h) amounts to:
+
+1. scramble seed into the initial (d, v[5]) state
+2. skipahead_sequence : advance v by subsequence*2^67 steps
+3. skipahead : advance v by offset steps and d by offset*362437
+
+The xorwow step is linear over GF(2) in the 160 bit v state, so
+advancing by n steps is the product with M^n where M is the 160x160
+bit matrix of a single step. curand uses precalculated tables of
+powers of M, here the same powers are computed at first use by
+repeated squaring:
+
+offset_pow[k]
+    M^(2^k)      k = 0..63
+
+seq_pow[k]
+    M^(2^(67+k)) k = 0..63
+
+As consecutive photon slots use consecutive subsequences, filling a
+range of states only needs the full skipahead for the first state of
+each thread, subsequent states are one matrix-vector product with
+M^(2^67) using 8-bit lookup tables. The range is split with sparallel.h
+over *num_thread* threads, envvar SCurandXORWOW__NUM_THREAD when 0. The d counter is not changed by
+subsequence skipping.
+
+The state type T is templated so this works with curandStateXORWOW
+when curand_kernel.h is available and with SCurandXORWOW::State
+(identical layout) when not.
+
+::
+
+    ~/o/sysrap/tests/SCurandXORWOW_test.sh
+
+**/
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#include "sparallel.h"
+
+struct SCurandXORWOW
+{
+    typedef unsigned long long ULL ;
+
+    static constexpr const char* SCurandXORWOW__NUM_THREAD = "SCurandXORWOW__NUM_THREAD" ;
+    static constexpr const int NBIT = 160 ;
+    static constexpr const int NWORD = 5 ;
+    static constexpr const int NBYTE = 20 ;
+    static constexpr const uint32_t DSTEP = 362437u ;
+    static constexpr const int SEQ_LOG2 = 67 ;   // subsequences are 2^67 steps apart
+
+    struct State     // same layout as curandStateXORWOW
+    {
+        unsigned int d, v[5] ;
+        int boxmuller_flag ;
+        int boxmuller_flag_double ;
+        float boxmuller_extra ;
+        double boxmuller_extra_double ;
+    };
+
+    struct Mat
+    {
+        uint32_t col[NBIT][NWORD] ;   // col[j] : image of the unit vector with bit j set
+    };
+
+    std::vector<Mat> offset_pow ;
+    std::vector<Mat> seq_pow ;
+    std::vector<uint32_t> seq_tab ;   // NBYTE*256*NWORD lookup of M^(2^67)
+
+    static const SCurandXORWOW& Get();
+
+    SCurandXORWOW();
+
+    static uint32_t Step(uint32_t* v);
+    static void StepMatrix(Mat& m);
+    static void MatVec(uint32_t* v, const Mat& m);
+    static void MatMul(Mat& c, const Mat& a, const Mat& b);
+    static void MakeTable(std::vector<uint32_t>& tab, const Mat& m);
+    static void TabVec(uint32_t* v, const uint32_t* tab);
+
+    void skipahead(ULL n, uint32_t* v, uint32_t& d) const ;
+    void skipahead_sequence(ULL n, uint32_t* v) const ;
+
+    template<typename T> static void Seed(T& st, ULL seed);
+    template<typename T> void init(ULL seed, ULL subsequence, ULL offset, T& st) const ;
+    template<typename T> void fill_range(T* states, ULL num, ULL seed, ULL subsequence0, ULL offset) const ;
+    template<typename T> void fill(T* states, ULL num, ULL seed, ULL subsequence0, ULL offset, int num_thread=0) const ;
+
+    template<typename T> static uint32_t Next(T& st);   // curand(&st) equivalent
+
+    std::string desc() const ;
+};
+
+
+/**
+SCurandXORWOW::Get
+--------------------
+
+The tables are built once, at first use. Function local static
+initialization is thread safe.
+
+**/
+
+inline const SCurandXORWOW& SCurandXORWOW::Get()
+{
+    static SCurandXORWOW INSTANCE ;
+    return INSTANCE ;
+}
+
+inline SCurandXORWOW::SCurandXORWOW()
+    :
+    offset_pow(64),
+    seq_pow(64)
+{
+    Mat p ;
+    StepMatrix(p);
+    for(int k=0 ; k < SEQ_LOG2 + 64 ; k++)
+    {
+        if( k < 64 ) offset_pow[k] = p ;
+        if( k >= SEQ_LOG2 ) seq_pow[k-SEQ_LOG2] = p ;
+        Mat sq ;
+        MatMul(sq, p, p);
+        p = sq ;
+    }
+    MakeTable(seq_tab, seq_pow[0]);
+}
+
+/**
+SCurandXORWOW::Step
+---------------------
+
+xorwow update of v as in curand_kernel.h, excluding the d counter
+
+**/
+
+inline uint32_t SCurandXORWOW::Step(uint32_t* v)
+{
+    uint32_t t = v[0] ^ (v[0] >> 2) ;
+    v[0] = v[1] ;
+    v[1] = v[2] ;
+    v[2] = v[3] ;
+    v[3] = v[4] ;
+    v[4] = (v[4] ^ (v[4] << 4)) ^ (t ^ (t << 1)) ;
+    return v[4] ;
+}
+
+inline void SCurandXORWOW::StepMatrix(Mat& m)
+{
+    for(int j=0 ; j < NBIT ; j++)
+    {
+        uint32_t* c = m.col[j] ;
+        for(int w=0 ; w < NWORD ; w++) c[w] = 0u ;
+        c[j/32] = 1u << (j % 32) ;
+        Step(c);
+    }
+}
+
+inline void SCurandXORWOW::MatVec(uint32_t* v, const Mat& m)
+{
+    uint32_t r[NWORD] = {} ;
+    for(int j=0 ; j < NBIT ; j++)
+    {
+        if( (v[j/32] >> (j % 32)) & 1u )
+        {
+            const uint32_t* c = m.col[j] ;
+            for(int w=0 ; w < NWORD ; w++) r[w] ^= c[w] ;
+        }
+    }
+    for(int w=0 ; w < NWORD ; w++) v[w] = r[w] ;
+}
+
+/**
+SCurandXORWOW::MatMul
+-----------------------
+
+c = a*b : column j of c is a applied to column j of b
+
+**/
+
+inline void SCurandXORWOW::MatMul(Mat& c, const Mat& a, const Mat& b)
+{
+    for(int j=0 ; j < NBIT ; j++)
+    {
+        for(int w=0 ; w < NWORD ; w++) c.col[j][w] = b.col[j][w] ;
+        MatVec(c.col[j], a);
+    }
+}
+
+inline void SCurandXORWOW::MakeTable(std::vector<uint32_t>& tab, const Mat& m)
+{
+    tab.assign( NBYTE*256*NWORD, 0u );
+    for(int p=0 ; p < NBYTE ; p++)
+    {
+        uint32_t* tp = tab.data() + p*256*NWORD ;
+        for(int x=1 ; x < 256 ; x++)
+        {
+            int low = 0 ;
+            while( ((x >> low) & 1) == 0 ) low++ ;
+            const uint32_t* prev = tp + (x & (x-1))*NWORD ;
+            const uint32_t* c = m.col[8*p + low] ;
+            for(int w=0 ; w < NWORD ; w++) tp[x*NWORD+w] = prev[w] ^ c[w] ;
+        }
+    }
+}
+
+inline void SCurandXORWOW::TabVec(uint32_t* v, const uint32_t* tab)
+{
+    uint32_t r[NWORD] = {} ;
+    for(int p=0 ; p < NBYTE ; p++)
+    {
+        uint32_t x = (v[p/4] >> (8*(p % 4))) & 0xffu ;
+        const uint32_t* e = tab + (p*256 + x)*NWORD ;
+        for(int w=0 ; w < NWORD ; w++) r[w] ^= e[w] ;
+    }
+    for(int w=0 ; w < NWORD ; w++) v[w] = r[w] ;
+}
+
+inline void SCurandXORWOW::skipahead(ULL n, uint32_t* v, uint32_t& d) const
+{
+    d += uint32_t(n)*DSTEP ;   // modulo 2^32, as curand
+    for(int k=0 ; n ; k++, n >>= 1) if( n & 1ull ) MatVec(v, offset_pow[k]) ;
+}
+
+inline void SCurandXORWOW::skipahead_sequence(ULL n, uint32_t* v) const
+{
+    for(int k=0 ; n ; k++, n >>= 1) if( n & 1ull ) MatVec(v, seq_pow[k]) ;
+}
+
+/**
+SCurandXORWOW::Seed
+---------------------
+
+Initial state from the seed, as _curand_init_scratch
+
+**/
+
+template<typename T>
+inline void SCurandXORWOW::Seed(T& st, ULL seed)
+{
+    uint32_t s0 = uint32_t(seed) ^ 0xaad26b49u ;
+    uint32_t s1 = uint32_t(seed >> 32) ^ 0xf7dcefddu ;
+    uint32_t t0 = 1099087573u * s0 ;
+    uint32_t t1 = 2591861531u * s1 ;
+    st.d    = 6615241u + t1 + t0 ;
+    st.v[0] = 123456789u + t0 ;
+    st.v[1] = 362436069u ^ t0 ;
+    st.v[2] = 521288629u + t1 ;
+    st.v[3] = 88675123u ^ t1 ;
+    st.v[4] = 5783321u + t0 ;
+    st.boxmuller_flag = 0 ;
+    st.boxmuller_flag_double = 0 ;
+    st.boxmuller_extra = 0.f ;
+    st.boxmuller_extra_double = 0. ;
+}
+
+template<typename T>
+inline void SCurandXORWOW::init(ULL seed, ULL subsequence, ULL offset, T& st) const
+{
+    Seed(st, seed);
+    uint32_t v[NWORD] ;
+    for(int w=0 ; w < NWORD ; w++) v[w] = st.v[w] ;
+    uint32_t d = st.d ;
+    skipahead_sequence(subsequence, v);
+    skipahead(offset, v, d);
+    for(int w=0 ; w < NWORD ; w++) st.v[w] = v[w] ;
+    st.d = d ;
+}
+
+/**
+SCurandXORWOW::fill_range
+---------------------------
+
+states[i] = curand_init(seed, subsequence0+i, offset) for i in [0,num)
+
+**/
+
+template<typename T>
+inline void SCurandXORWOW::fill_range(T* states, ULL num, ULL seed, ULL subsequence0, ULL offset) const
+{
+    if( num == 0 ) return ;
+    T st ;
+    init(seed, subsequence0, offset, st);
+
+    uint32_t v[NWORD] ;
+    for(int w=0 ; w < NWORD ; w++) v[w] = st.v[w] ;
+
+    for(ULL i=0 ; i < num ; i++)
+    {
+        if( i > 0 ) TabVec(v, seq_tab.data()) ;
+        for(int w=0 ; w < NWORD ; w++) st.v[w] = v[w] ;
+        states[i] = st ;
+    }
+}
+
+template<typename T>
+inline void SCurandXORWOW::fill(T* states, ULL num, ULL seed, ULL subsequence0, ULL offset, int num_thread) const
+{
+    int nt = sparallel::NumThreadEnv(num, SCurandXORWOW__NUM_THREAD, num_thread) ;
+    sparallel::For(num, nt, [=](int, ULL i0, ULL i1){ fill_range(states + i0, i1 - i0, seed, subsequence0 + i0, offset ) ; });
+}
+
+template<typename T>
+inline uint32_t SCurandXORWOW::Next(T& st)
+{
+    uint32_t v[NWORD] ;
+    for(int w=0 ; w < NWORD ; w++) v[w] = st.v[w] ;
+    uint32_t v4 = Step(v);
+    for(int w=0 ; w < NWORD ; w++) st.v[w] = v[w] ;
+    st.d += DSTEP ;
+    return v4 + st.d ;
+}
+
+inline std::string SCurandXORWOW::desc() const
+{
+    std::stringstream ss ;
+    ss << "SCurandXORWOW::desc"
+       << " offset_pow " << offset_pow.size()
+       << " seq_pow " << seq_pow.size()
+       << " seq_tab " << seq_tab.size()
+       << " sizeof(State) " << sizeof(State)
+       ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -10,6 +10,7 @@
 #include "sprof.h"
 
 #include "sphoton.h"
+#include "sphoton_soa.h"
 #include "srec.h"
 #include "sseq.h"
 #include "ssys.h"
@@ -43,6 +44,8 @@
 #include "SComp.h"
 #include "SProf.hh"
 #include "SRecord.h"
+#include "SGenstepCollector.h"
+#include "SLocalHit.h"
 
 
 bool SEvt::NPFOLD_VERBOSE = ssys::getenvbool(SEvt__NPFOLD_VERBOSE) ;
@@ -60,6 +63,10 @@ bool SEvt::EPH_ = ssys::getenvbool(SEvt__EPH) ;
 bool SEvt::RUNMETA = ssys::getenvbool(SEvt__RUNMETA) ;
 
 bool SEvt::SAVE_NOTHING = ssys::getenvbool(SEvt__SAVE_NOTHING);
+bool SEvt::ARENA_COPY = ssys::getenvbool(SEvt__ARENA_COPY);
+bool SEvt::MT_GENSTEP = ssys::getenvbool(SEvt__MT_GENSTEP);
+const char* SEvt::COLUMNAR = ssys::getenvvar(SEvt__COLUMNAR, nullptr);
+SGenstepCollector* SEvt::GSC = MT_GENSTEP ? new SGenstepCollector : nullptr ;
 
 
 const char* SEvt::descStage() const
@@ -1391,9 +1398,32 @@ int  SEvt::GetTagSlot(int idx)
 }
 #endif
 
+/**
+SEvt::AddGenstep
+------------------
+
+With SEvt__MT_GENSTEP (or SEvt::SetMTGenstep) the genstep is appended
+to the per-thread buffer of the calling thread without locking,
+making this safe to call from Geant4 worker threads.
+The gensteps only reach the SEvt instances at SEvt::MergeThreadGenstep,
+so the returned label has index and offset -1 as they are not yet known.
+Hence MT_GENSTEP is not usable with U4Recorder hostside running which
+requires the labels.
+
+**/
+
 sgs SEvt::AddGenstep(const quad6& q)
 {
     sgs label = {} ;
+    if(MT_GENSTEP)
+    {
+        GSC->add(q);
+        label.index = -1 ;
+        label.photons = q.numphoton() ;
+        label.offset = -1 ;
+        label.gentype = q.gentype() ;
+        return label ;
+    }
     if(Exists(0)) label = Get(0)->addGenstep(q) ;
     if(Exists(1)) label = Get(1)->addGenstep(q) ;
     return label ;
@@ -1401,10 +1431,109 @@ sgs SEvt::AddGenstep(const quad6& q)
 sgs SEvt::AddGenstep(const NP* a)
 {
     sgs label = {} ;
+    if(MT_GENSTEP)
+    {
+        int num_gs = a ? a->shape[0] : -1 ;
+        assert( num_gs > 0 );
+        const quad6* qq = (const quad6*)a->bytes();
+        for(int i=0 ; i < num_gs ; i++) label = AddGenstep(qq[i]) ;
+        return label ;
+    }
     if(Exists(0)) label = Get(0)->addGenstep(a) ;
     if(Exists(1)) label = Get(1)->addGenstep(a) ;
     return label ;
 }
+
+void SEvt::SetMTGenstep(bool enable)
+{
+    MT_GENSTEP = enable ;
+    if(MT_GENSTEP && GSC == nullptr) GSC = new SGenstepCollector ;
+}
+
+/**
+SEvt::SetGenstepThreadIndex
+-----------------------------
+
+Sets the index used to order the gensteps collected by the calling thread,
+eg G4Threading::G4GetThreadId(). Must be called before the first
+SEvt::AddGenstep from the thread, see SGenstepCollector.h
+
+**/
+
+void SEvt::SetGenstepThreadIndex(int idx)
+{
+    SGenstepCollector::SetThreadIndex(idx);
+}
+
+/**
+SEvt::MergeThreadGenstep
+--------------------------
+
+Merges the per-thread gensteps into the SEvt instances with SEvt::addGenstep
+in (thread, sequence) order giving deterministic genstep and photon offsets.
+Invoked from SEvt::endOfEvent and QSim::simulate prior to using the gensteps.
+Returns the number of gensteps merged.
+
+When the calling thread has an index from SEvt::SetGenstepThreadIndex,
+as Geant4 worker threads do, only the gensteps of that thread are merged
+so the gensteps of events running concurrently on other workers are not
+mixed into this event. Otherwise all buffers are merged, as appropriate
+at a run level barrier. Merging is safe while other threads are adding,
+see SGenstepCollector.h
+
+The merge holds SEvt::LockMTGenstep as it appends to the process wide
+SEvt instances.
+
+**/
+
+int SEvt::MergeThreadGenstep()
+{
+    if(GSC == nullptr) return 0 ;
+    std::unique_lock<std::recursive_mutex> lock = LockMTGenstep() ;
+    int thread = SGenstepCollector::ThreadIndex() ;
+    int num = GSC->merge( [](const quad6& q)
+        {
+            if(Exists(0)) Get(0)->addGenstep(q) ;
+            if(Exists(1)) Get(1)->addGenstep(q) ;
+        }, thread );
+    LOG(LEVEL) << " thread " << thread << " num " << num ;
+    return num ;
+}
+
+/**
+SEvt::LockMTGenstep
+---------------------
+
+With MT_GENSTEP returns a lock on SEvt::MTGenstepMutex otherwise an
+unowned lock. The SEvt instances are process wide, so with Geant4 worker
+threads ending events concurrently the merge of one worker must not be
+interleaved with the save, clear_output and clear_genstep of another.
+SEvt::beginOfEvent, SEvt::endOfEvent and QSim::simulate hold this lock
+so each of those sequences acts on the gensteps of a single event.
+
+The mutex is recursive as SEvt::endOfEvent invokes SEvt::MergeThreadGenstep
+and QSim::simulate invokes both.
+
+This does not make the SEvt instances per-event : callers that bracket
+an event with separate SEvt::beginOfEvent and SEvt::endOfEvent calls
+from different callbacks, such as U4Recorder or QSim::simulate with
+reset false, still need a single event in flight at a time.
+
+**/
+
+std::recursive_mutex& SEvt::MTGenstepMutex()
+{
+    static std::recursive_mutex mtx ;
+    return mtx ;
+}
+
+std::unique_lock<std::recursive_mutex> SEvt::LockMTGenstep()
+{
+    std::unique_lock<std::recursive_mutex> lock(MTGenstepMutex(), std::defer_lock) ;
+    if(MT_GENSTEP) lock.lock();
+    return lock ;
+}
+
 void SEvt::AddCarrierGenstep(){ AddGenstep(SEvent::MakeCarrierGenstep()); }
 void SEvt::AddTorchGenstep(){   AddGenstep(SEvent::MakeTorchGenstep());   }
 
@@ -1719,6 +1848,7 @@ as still need to collect the gensteps.
 
 void SEvt::beginOfEvent(int eventID)
 {
+    std::unique_lock<std::recursive_mutex> lock = LockMTGenstep() ;  // see SEvt::LockMTGenstep
     if(isFirstEvtInstance() && eventID == 0) BeginOfRun() ;
     if(eventID == 0) SetRunProf( isEGPU() ? "SEvt__beginOfEvent_FIRST_EGPU" : "SEvt__beginOfEvent_FIRST_ECPU" ) ;
 
@@ -1766,12 +1896,14 @@ so can switch off all saving wuth that config.
 
 void SEvt::endOfEvent(int eventID)
 {
+    std::unique_lock<std::recursive_mutex> lock = LockMTGenstep() ;  // merge through clear as one, see SEvt::LockMTGenstep
 
     setStage(SEvt__endOfEvent);
     LOG_IF(info, LIFECYCLE) << id() ;
     sprof::Stamp(p_SEvt__endOfEvent_0);
 
     endIndex(eventID);   // eventID is 0-based
+    if(MT_GENSTEP) MergeThreadGenstep();
     endMeta();
     gather_metadata();
 
@@ -1951,6 +2083,11 @@ Notice
 
 Note that most of the vectors are only used with hostside running.
 
+The sarena (photon, record, rec, seq, aux, sup, hit) clear is O(1)
+keeping capacity for reuse by the next event. Buffers lent to gathered
+arrays are reclaimed first, this must be done prior to the topfold
+clear in SEvt::clear_output that deletes those arrays.
+
 **/
 
 
@@ -1958,6 +2095,8 @@ void SEvt::clear_output_vector()
 {
     clear_output_vector_count += 1 ;
 
+    reclaim_arena();
+
     pho.clear();
     slot.clear();
     photon.clear();
@@ -1970,9 +2109,48 @@ void SEvt::clear_output_vector()
     simtrace.clear();
     aux.clear();
     sup.clear();
+    hit.clear();
     g4state = nullptr ;   // avoiding stale (g4state is special, as only used for 1st event)
 }
 
+/**
+SEvt::reclaim_arena
+---------------------
+
+Swaps back buffers lent to arrays by the zero-copy gather methods,
+so the capacity is reused by the next event.
+When the lent array is no longer in the topfold its buffer is lost,
+the corresponding sevent.h pointer would then be dangling so it is nulled.
+
+**/
+
+void SEvt::reclaim_arena()
+{
+    if(photon.lent && !photon.reclaim(topfold, SComp::Name(SCOMP_PHOTON))) evt->photon = nullptr ;
+    if(record.lent && !record.reclaim(topfold, SComp::Name(SCOMP_RECORD))) evt->record = nullptr ;
+    if(rec.lent    && !rec.reclaim(   topfold, SComp::Name(SCOMP_REC)))    evt->rec    = nullptr ;
+    if(seq.lent    && !seq.reclaim(   topfold, SComp::Name(SCOMP_SEQ)))    evt->seq    = nullptr ;
+    if(aux.lent    && !aux.reclaim(   topfold, SComp::Name(SCOMP_AUX)))    evt->aux    = nullptr ;
+    if(sup.lent    && !sup.reclaim(   topfold, SComp::Name(SCOMP_SUP)))    evt->sup    = nullptr ;
+    hit.reclaim(topfold, SComp::Name(SCOMP_HIT));
+}
+
+std::string SEvt::descArena() const
+{
+    std::stringstream ss ;
+    ss << "SEvt::descArena" << std::endl
+       << " photon " << photon.desc() << std::endl
+       << " record " << record.desc() << std::endl
+       << " rec    " << rec.desc() << std::endl
+       << " seq    " << seq.desc() << std::endl
+       << " aux    " << aux.desc() << std::endl
+       << " sup    " << sup.desc() << std::endl
+       << " hit    " << hit.desc() << std::endl
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
 
 
 
@@ -2507,40 +2685,43 @@ void SEvt::hostside_running_resize_()
     // pho and slot look essential for U4Recorder bookkeeping
 
 
+    photon.set_max_item( evt->max_photon );
+    record.set_max_item( size_t(evt->max_photon)*evt->max_record );
+    rec.set_max_item(    size_t(evt->max_photon)*evt->max_rec );
+    aux.set_max_item(    size_t(evt->max_photon)*evt->max_aux );
+    sup.set_max_item(    evt->max_photon );
+    seq.set_max_item(    evt->max_photon );
+    hit.set_max_item(    evt->max_photon );
+
+    // sarena resize reuses capacity from prior events, only growing past the high water mark
     if(evt->num_photon > 0)
     {
         photon.resize(evt->num_photon);
-        if(shrink) photon.shrink_to_fit();
         evt->photon = photon.data() ;
     }
     if(evt->num_record > 0)
     {
         record.resize(evt->num_record);
-        if(shrink) record.shrink_to_fit();
         evt->record = record.data() ;
     }
     if(evt->num_rec > 0)
     {
         rec.resize(evt->num_rec);
-        if(shrink) rec.shrink_to_fit();
         evt->rec = rec.data() ;
     }
     if(evt->num_aux > 0)
     {
         aux.resize(evt->num_aux);
-        if(shrink) aux.shrink_to_fit();
         evt->aux = aux.data() ;
     }
     if(evt->num_sup > 0)
     {
         sup.resize(evt->num_sup);
-        if(shrink) sup.shrink_to_fit();
         evt->sup = sup.data() ;
     }
     if(evt->num_seq > 0)
     {
         seq.resize(evt->num_seq);
-        if(shrink) seq.shrink_to_fit();
         evt->seq = seq.data() ;
     }
     if(evt->num_prd > 0)
@@ -3327,56 +3508,106 @@ bool SEvt::haveGenstepVec() const { return genstep.size() > 0 ; }
 SEvt::gatherPhoton
 --------------------
 
+Default zero-copy gather:
+
+1. creates array with zero items via NP::Make
+2. lends the sarena.h buffer to the array, which swaps the pooled
+   buffer into the array without copying, the buffer is
+   reclaimed by SEvt::clear_output_vector for reuse with the next event
+
+With SEvt__ARENA_COPY the former copying gather is used:
+
 1. allocates with NP::Make
 2. populates by reading from photon vector using the sevent.h pointer
    that makes things follow the on device approach
 
-NB this means the array holds an independent copy of the vector data,
-as do all(?) the gather methods.
+NB this means the array holds an independent copy of the vector data.
+
+The copying gather is also used for repeated gathers before SEvt::clear_output_vector,
+when the buffer is already lent : the sevent.h pointer then reads the data
+held by the previously gathered array.
+
+The same applies to gatherRecord, gatherRec, gatherAux, gatherSup, gatherSeq.
 
 **/
 
 NP* SEvt::gatherPhoton() const
 {
     if( evt->photon == nullptr ) return nullptr ;
-    NP* p = makePhoton();
-    p->read2( (float*)evt->photon );
+    if(ARENA_COPY || photon.lent)
+    {
+        NP* p = makePhoton();
+        p->read2( (float*)evt->photon );
+        return p ;
+    }
+    NP* p = makePhoton(0);
+    photon.lend(p);
     return p ;
 }
 
 NP* SEvt::gatherRecord() const
 {
     if( evt->record == nullptr ) return nullptr ;
-    NP* r = makeRecord();
-    r->read2( (float*)evt->record );
+    if(ARENA_COPY || record.lent)
+    {
+        NP* r = makeRecord();
+        r->read2( (float*)evt->record );
+        return r ;
+    }
+    NP* r = makeRecord(0);
+    record.lend(r);
     return r ;
 }
 NP* SEvt::gatherRec() const
 {
     if( evt->rec == nullptr ) return nullptr ;
-    NP* r = makeRec();
-    r->read2( (short*)evt->rec );
+    if(ARENA_COPY || rec.lent)
+    {
+        NP* r = makeRec();
+        r->read2( (short*)evt->rec );
+        return r ;
+    }
+    NP* r = makeRec(0);
+    rec.lend(r);
     return r ;
 }
 NP* SEvt::gatherAux() const
 {
     if( evt->aux == nullptr ) return nullptr ;
-    NP* r = makeAux();
-    r->read2( (float*)evt->aux );
+    if(ARENA_COPY || aux.lent)
+    {
+        NP* r = makeAux();
+        r->read2( (float*)evt->aux );
+        return r ;
+    }
+    NP* r = makeAux(0);
+    aux.lend(r);
     return r ;
 }
 NP* SEvt::gatherSup() const
 {
     if( evt->sup == nullptr ) return nullptr ;
-    NP* p = makeSup();
-    p->read2( (float*)evt->sup );
+    if(ARENA_COPY || sup.lent)
+    {
+        NP* p = makeSup();
+        p->read2( (float*)evt->sup );
+        return p ;
+    }
+    NP* p = makeSup(0);
+    sup.lend(p);
     return p ;
 }
 NP* SEvt::gatherSeq() const
 {
     if( evt->seq == nullptr ) return nullptr ;
-    NP* s = makeSeq();
-    s->read2( (unsigned long long*)evt->seq );
+    if(ARENA_COPY || seq.lent)
+    {
+        NP* s = makeSeq();
+        s->read2( (unsigned long long*)evt->seq );
+        return s ;
+    }
+    NP* s = makeSeq(0);
+    seq.lend(s);
     return s ;
 }
 NP* SEvt::gatherPrd() const
@@ -3420,13 +3651,32 @@ So cannot have HitOnly on B side ?
 
 This means that hit must come after photon in the component order
 
+Without SEvt__ARENA_COPY the selected hits are copied into the
+pooled *hit* sarena which is then lent to the returned array,
+avoiding a fresh allocation for every event.
+
 **/
 
 NP* SEvt::gatherHit() const
 {
     const NP* p = fold->get(SComp::PHOTON_) ;
     // cannot use getPhoton here as that gets the photons from topfold which is only populated after gather
-    NP* h = p ? p->copy_if<float, sphoton>(*selector) : nullptr ;
+    if( p == nullptr ) return nullptr ;
+
+    bool arena_busy = hit.lent != nullptr ;  // repeated gather without clear
+    if(ARENA_COPY || arena_busy) return p->copy_if<float, sphoton>(*selector) ;
+
+    const sphoton* pp = (const sphoton*)p->cvalues<float>() ;
+    int num_photon = p->shape[0] ;
+    int num_hit = p->count_if<sphoton>(*selector) ;
+
+    hit.resize(num_hit);
+    int ih = 0 ;
+    for(int i=0 ; i < num_photon ; i++) if((*selector)(pp[i])) hit[ih++] = pp[i] ;
+    assert( ih == num_hit );
+
+    NP* h = NP::Make<float>( 0, 4, 4 );
+    hit.lend(h);
     return h ;
 }
 
@@ -3447,38 +3697,38 @@ This is called by SEvt::gatherPhoton
 
 **/
 
-NP* SEvt::makePhoton() const
+NP* SEvt::makePhoton(int ni) const
 {
-    NP* p = NP::Make<float>( evt->num_photon, 4, 4 );
+    NP* p = NP::Make<float>( ni > -1 ? ni : evt->num_photon, 4, 4 );
     return p ;
 }
 
-NP* SEvt::makeRecord() const
+NP* SEvt::makeRecord(int ni) const
 {
-    NP* r = NP::Make<float>( evt->num_photon, evt->max_record, 4, 4 );
+    NP* r = NP::Make<float>( ni > -1 ? ni : evt->num_photon, evt->max_record, 4, 4 );
     r->set_meta<std::string>("rpos", "4,GL_FLOAT,GL_FALSE,64,0,false" );  // eg used by examples/UseGeometryShader
     return r ;
 }
-NP* SEvt::makeRec() const
+NP* SEvt::makeRec(int ni) const
 {
-    NP* r = NP::Make<short>( evt->num_photon, evt->max_rec, 2, 4);   // stride:  sizeof(short)*2*4 = 2*2*4 = 16
+    NP* r = NP::Make<short>( ni > -1 ? ni : evt->num_photon, evt->max_rec, 2, 4);   // stride:  sizeof(short)*2*4 = 2*2*4 = 16
     r->set_meta<std::string>("rpos", "4,GL_SHORT,GL_TRUE,16,0,false" );  // eg used by examples/UseGeometryShader
     return r ;
 }
-NP* SEvt::makeAux() const
+NP* SEvt::makeAux(int ni) const
 {
-    NP* r = NP::Make<float>( evt->num_photon, evt->max_aux, 4, 4 );
+    NP* r = NP::Make<float>( ni > -1 ? ni : evt->num_photon, evt->max_aux, 4, 4 );
     return r ;
 }
-NP* SEvt::makeSup() const
+NP* SEvt::makeSup(int ni) const
 {
-    NP* p = NP::Make<float>( evt->num_photon, 6, 4 );
+    NP* p = NP::Make<float>( ni > -1 ? ni : evt->num_photon, 6, 4 );
     return p ;
 }
 
-NP* SEvt::makeSeq() const
+NP* SEvt::makeSeq(int ni) const
 {
-    return NP::Make<unsigned long long>( evt->num_seq, 2, sseq::NSEQ );
+    return NP::Make<unsigned long long>( ni > -1 ? ni : evt->num_seq, 2, sseq::NSEQ );
 }
 NP* SEvt::makePrd() const
 {
@@ -4098,6 +4348,8 @@ int SEvt::loadfold( const char* dir )
     LOG(LEVEL) << "[ topfold.load " << dir ;
     int rc = topfold->load(dir);
     LOG(LEVEL) << "] topfold.load " << dir ;
+    int num_soa = sphoton_soa::Decolumnarize_r(topfold);
+    LOG_IF(LEVEL, num_soa > 0) << " combined num_soa " << num_soa << " columnar folds into photon arrays " ;
     is_loaded = true ;
     onload();
     return rc ;
@@ -4288,6 +4540,13 @@ void SEvt::save(const char* dir_)
     }
 
 
+    std::vector<NPFold*> soa ;
+    if(COLUMNAR)
+    {
+        int num_soa = sphoton_soa::Columnarize_r(save_fold, COLUMNAR, &soa);
+        LOG_IF(info, SAVE) << " COLUMNAR " << COLUMNAR << " num_soa " << num_soa ;
+    }
+
     int slic = save_fold->_save_local_item_count();
     if( slic > 0 )
     {
@@ -4312,6 +4571,11 @@ void SEvt::save(const char* dir_)
     // NB: NOT DELETING save_fold AS IT IS A SHALLOW COPY : IT DOES NOT OWN THE ARRAYS
     delete seqnib ;
     delete seqnib_table ;
+    for(unsigned i=0 ; i < soa.size() ; i++)
+    {
+        soa[i]->clear();   // the columns are owned by the soa folds
+        delete soa[i] ;
+    }
 }
 
 
@@ -4734,6 +4998,33 @@ void SEvt::getLocalHit(sphit& ht, sphoton& lp, unsigned idx) const
     ht.sensor_index = col3[3] ;
 }
 
+/**
+SEvt::getLocalHits
+--------------------
+
+Batch equivalent of SEvt::getLocalHit for all hits of the event,
+see SLocalHit.h. The conversion is spread over *num_thread*
+(0: hardware concurrency) with optional efficiency culling
+configured on the SLocalHit before the call.
+
+**/
+
+void SEvt::getLocalHits(SLocalHit& lh, int num_thread) const
+{
+    const NP* hit = getHit();
+    LOG_IF(fatal, tree == nullptr && hit != nullptr )
+         << " NO stree : WHEN TESTING NEEDS SSim::Load NOT SSim::Create" ;
+    assert( tree || hit == nullptr );
+
+    lh.convert( hit, tree, num_thread );
+
+    LOG_IF(error, lh.num_missing > 0 )
+         << " FAILED TO GET INSTANCE TRANSFORM FOR SOME HITS "
+         << lh.desc()
+         ;
+    LOG(LEVEL) << lh.desc() ;
+}
+
 
 
 
@@ -57,6 +57,7 @@ index and photon offset in addition to  gentype/trackid/matline/numphotons
 #include <vector>
 #include <string>
 #include <sstream>
+#include <mutex>
 #include "plog/Severity.h"
 
 #include "scuda.h"
@@ -70,6 +71,7 @@ index and photon offset in addition to  gentype/trackid/matline/numphotons
 #include "sevent.h"
 #include "sctx.h"
 #include "sprof.h"
+#include "sarena.h"
 
 #include "squad.h"
 #include "sframe.h"
@@ -86,6 +88,8 @@ struct SGeo ;
 struct S4RandomArray ;
 struct stimer ;
 struct stree ;
+struct SGenstepCollector ;
+struct SLocalHit ;
 
 #include "SYSRAP_API_EXPORT.hh"
 
@@ -139,6 +143,16 @@ struct SYSRAP_API SEvt : public SCompProvider
     static constexpr const char* SEvt__SAVE_NOTHING = "SEvt__SAVE_NOTHING" ;
     static bool SAVE_NOTHING ;
 
+    static constexpr const char* SEvt__ARENA_COPY = "SEvt__ARENA_COPY" ;
+    static bool ARENA_COPY ;
+
+    static constexpr const char* SEvt__COLUMNAR = "SEvt__COLUMNAR" ;
+    static const char* COLUMNAR ;   // keys of (n,4,4) arrays to save as sphoton_soa columns, eg "photon,hit"
+
+    static constexpr const char* SEvt__MT_GENSTEP = "SEvt__MT_GENSTEP" ;
+    static bool MT_GENSTEP ;
+    static SGenstepCollector* GSC ;   // per-thread genstep buffers used with MT_GENSTEP
+
 
 
 
@@ -254,18 +268,23 @@ struct SYSRAP_API SEvt : public SCompProvider
     // [--- these vectors are cleared by SEvt::clear_output_vector
     std::vector<spho>    pho ;   // spho are label structs holding 4*int
     std::vector<int>     slot ;
-    std::vector<sphoton> photon ;
-    std::vector<sphoton> record ;
-    std::vector<srec>    rec ;
-    std::vector<sseq>    seq ;
     std::vector<quad2>   prd ;
     std::vector<stag>    tag ;
     std::vector<sflat>   flat ;
     std::vector<quad4>   simtrace ;
-    std::vector<quad4>   aux ;
-    std::vector<quad6>   sup ;
     // ]---- these vectors are cleared by SEvt::clear_output_vector
 
+    // [--- pooled storage reused across events, see sarena.h
+    //      mutable as the const gather methods lend the buffers to the gathered arrays
+    mutable sarena<sphoton> photon ;
+    mutable sarena<sphoton> record ;
+    mutable sarena<srec>    rec ;
+    mutable sarena<sseq>    seq ;
+    mutable sarena<quad4>   aux ;
+    mutable sarena<quad6>   sup ;
+    mutable sarena<sphoton> hit ;
+    // ]--- arenas are reset by SEvt::clear_output_vector
+
 
     // current_* are saved into the vectors on calling SEvt::pointPhoton
     spho    current_pho = {} ;
@@ -439,6 +458,12 @@ public:
     static sgs AddGenstep(const quad6& q);
     static sgs AddGenstep(const NP* a);
     static void AddCarrierGenstep();
+
+    static void SetMTGenstep(bool enable);
+    static void SetGenstepThreadIndex(int idx);
+    static int  MergeThreadGenstep();
+    static std::recursive_mutex& MTGenstepMutex();
+    static std::unique_lock<std::recursive_mutex> LockMTGenstep();
     static void AddTorchGenstep();
     void addTorchGenstep();
 
@@ -555,6 +580,8 @@ public:
     void setNumSimtrace(unsigned num_simtrace);
     void hostside_running_resize();
     void hostside_running_resize_();
+    void reclaim_arena();
+    std::string descArena() const ;
 
     const sgs& get_gs(const spho& label) const ; // lookup genstep label from photon label
     unsigned get_genflag(const spho& label) const ;
@@ -622,12 +649,12 @@ public:
     NP* gatherSimtrace() const ;
 
 
-    NP* makePhoton() const ;
-    NP* makeRecord() const ;
-    NP* makeRec() const ;
-    NP* makeAux() const ;
-    NP* makeSup() const ;
-    NP* makeSeq() const ;
+    NP* makePhoton(int ni=-1) const ;
+    NP* makeRecord(int ni=-1) const ;
+    NP* makeRec(int ni=-1) const ;
+    NP* makeAux(int ni=-1) const ;
+    NP* makeSup(int ni=-1) const ;
+    NP* makeSeq(int ni=-1) const ;
     NP* makePrd() const ;
     NP* makeTag() const ;
     NP* makeFlat() const ;
@@ -729,6 +756,7 @@ public:
     void getLocalPhoton(  sphoton& p, unsigned idx) const ;
     void getLocalHit_LEAKY( sphit& ht, sphoton& p, unsigned idx) const ;
     void getLocalHit(       sphit& ht, sphoton& p, unsigned idx) const ;
+    void getLocalHits( SLocalHit& lh, int num_thread=0 ) const ;
     void getPhotonFrame( sframe& fr, const sphoton& p ) const ;
 
     std::string descNum() const ;
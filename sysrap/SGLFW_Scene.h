@@ -128,7 +128,8 @@ SGLFW_Scene::initMesh
 
 Traverses the meshmerge vector from SScene
 passing them to SGLFW_Mesh instances 
-which do the OpenGL uploads
+which do the OpenGL uploads. The meshmerge
+of the SScene::getRenderLOD level is used.
 
 HMM: how to match ray trace IAS/GAS handle selection ?
 
@@ -137,6 +138,7 @@ HMM: how to match ray trace IAS/GAS handle selection ?
 inline void SGLFW_Scene::initMesh()
 {
     int num_meshmerge = gm.scene->meshmerge.size(); 
+    int lod = gm.scene->getRenderLOD(); 
 
     const std::vector<glm::tmat4x4<float>>& inst_tran = gm.scene->inst_tran ; 
     const float* values = (const float*)inst_tran.data() ; 
@@ -145,6 +147,7 @@ inline void SGLFW_Scene::initMesh()
     if(DUMP) std::cout 
          << "SGLFW_Scene::initMesh"
          << " num_meshmerge " << num_meshmerge
+         << " lod " << lod
          << "\n"
          ;
 
@@ -165,7 +168,7 @@ inline void SGLFW_Scene::initMesh()
              << "\n"
              ;
 
-        const SMesh* _mm = gm.scene->meshmerge[i] ; 
+        const SMesh* _mm = gm.scene->getMeshMerge(i, lod) ; 
 
         SGLFW_Mesh* _mesh = new SGLFW_Mesh(_mm);
         if( is_instanced )
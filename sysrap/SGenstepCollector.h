@@ -0,0 +1,203 @@
+#pragma once
+/**
+SGenstepCollector.h : per-thread genstep buffers merged in deterministic order
+================================================================================
+
+SEvt::addGenstep appends to std::vector<quad6> and std::vector<sgs> shared by
+all threads with no synchronization, so the U4 Cerenkov and Scintillation
+collection cannot be used from the worker threads of G4MTRunManager.
+
+With SEvt__MT_GENSTEP enabled SEvt::AddGenstep instead appends to
+the buffer of the calling thread held by this collector:
+
+add
+    appends to the calling threads own buffer, taking only the mutex
+    of that buffer which is uncontended other than during a merge.
+    The collector mutex is only taken the first time a thread adds
+    to this collector in order to register its buffer
+
+merge
+    invokes the callback for every collected genstep ordered by
+    (thread, sequence) where *thread* is the index set with
+    SGenstepCollector::SetThreadIndex (eg from G4Threading::G4GetThreadId)
+    falling back to the thread registration order when not set.
+    The thread index must be set prior to the first add from each thread.
+    Buffers are cleared keeping their capacity.
+    With thread argument >= 0 only the buffers of that thread are merged.
+
+Each buffer is drained while holding its mutex so merge may run concurrently
+with add from other threads : gensteps added during a merge either make it into
+that merge or remain for the next one. Merges are serialized by the collector mutex.
+
+Under G4MTRunManager events run concurrently on the worker threads, so
+SEvt::MergeThreadGenstep from a worker merges only the buffer of that worker
+keeping gensteps of concurrent events apart. Merging all buffers, thread -1,
+is intended for a run level barrier or for collection from plain std::thread
+that have no event of their own.
+
+This collector only protects its own buffers. The merged gensteps go into
+the process wide SEvt instances, so the merge together with the consumption
+that follows (gather, save, clear_genstep in SEvt::endOfEvent) is serialized
+across threads by SEvt::LockMTGenstep.
+
+**/
+
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <sstream>
+
+#include "scuda.h"
+#include "squad.h"
+
+struct SGenstepCollector
+{
+    struct Buffer
+    {
+        int thread ;    // from SetThreadIndex, or -1
+        int order ;     // registration order
+        std::mutex mtx ;
+        std::vector<quad6> genstep ;
+    };
+
+    std::mutex mtx ;
+    std::vector<Buffer*> buffers ;
+    unsigned generation ;   // distinguishes collector instances at the same address
+
+    static int& ThreadIndex();
+    static void SetThreadIndex(int idx);
+
+    SGenstepCollector();
+    ~SGenstepCollector();
+
+    Buffer* local();
+    void add(const quad6& q);
+    int  num_genstep() ;
+    int  merge(std::function<void(const quad6&)> fn, int thread=-1);
+
+    std::string desc() ;
+};
+
+
+inline int& SGenstepCollector::ThreadIndex()
+{
+    static thread_local int idx = -1 ;
+    return idx ;
+}
+inline void SGenstepCollector::SetThreadIndex(int idx)
+{
+    ThreadIndex() = idx ;
+}
+
+
+inline SGenstepCollector::SGenstepCollector()
+{
+    static unsigned GENERATION = 0 ;
+    generation = ++GENERATION ;
+}
+
+inline SGenstepCollector::~SGenstepCollector()
+{
+    for(int i=0 ; i < int(buffers.size()) ; i++) delete buffers[i] ;
+}
+
+/**
+SGenstepCollector::local
+--------------------------
+
+The thread_local cache avoids taking the mutex other than on
+the first add from each thread.
+
+**/
+
+inline SGenstepCollector::Buffer* SGenstepCollector::local()
+{
+    struct Cache { const SGenstepCollector* owner ; unsigned generation ; Buffer* buf ; } ;
+    static thread_local Cache cache = { nullptr, 0u, nullptr } ;
+
+    if( cache.owner != this || cache.generation != generation )
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        Buffer* buf = new Buffer ;
+        buf->thread = ThreadIndex() ;
+        buf->order = buffers.size() ;
+        buffers.push_back(buf);
+
+        cache.owner = this ;
+        cache.generation = generation ;
+        cache.buf = buf ;
+    }
+    return cache.buf ;
+}
+
+inline void SGenstepCollector::add(const quad6& q)
+{
+    Buffer* buf = local();
+    std::lock_guard<std::mutex> lock(buf->mtx);
+    buf->genstep.push_back(q) ;
+}
+
+inline int SGenstepCollector::num_genstep()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    int num = 0 ;
+    for(int i=0 ; i < int(buffers.size()) ; i++)
+    {
+        std::lock_guard<std::mutex> block(buffers[i]->mtx);
+        num += buffers[i]->genstep.size() ;
+    }
+    return num ;
+}
+
+/**
+SGenstepCollector::merge
+--------------------------
+
+Buffers with thread index set sort ahead of those without,
+ties are broken by registration order. The collector mutex is
+taken before the buffer mutex, add only takes the buffer mutex
+so there is no lock order inversion.
+
+**/
+
+inline int SGenstepCollector::merge(std::function<void(const quad6&)> fn, int thread)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    std::vector<Buffer*> bb(buffers) ;
+    std::stable_sort( bb.begin(), bb.end(), [](const Buffer* a, const Buffer* b)
+        {
+            unsigned ta = unsigned(a->thread) ;  // -1 becomes large, sorting last
+            unsigned tb = unsigned(b->thread) ;
+            return ta == tb ? a->order < b->order : ta < tb ;
+        });
+
+    int num = 0 ;
+    for(int i=0 ; i < int(bb.size()) ; i++)
+    {
+        if( thread > -1 && bb[i]->thread != thread ) continue ;
+        std::lock_guard<std::mutex> block(bb[i]->mtx);
+        std::vector<quad6>& gs = bb[i]->genstep ;
+        for(int j=0 ; j < int(gs.size()) ; j++) fn(gs[j]) ;
+        num += gs.size() ;
+        gs.clear();
+    }
+    return num ;
+}
+
+inline std::string SGenstepCollector::desc()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::stringstream ss ;
+    ss << "SGenstepCollector::desc num_buffer " << buffers.size() << "\n" ;
+    for(int i=0 ; i < int(buffers.size()) ; i++)
+    {
+        Buffer* b = buffers[i] ;
+        std::lock_guard<std::mutex> block(b->mtx);
+        ss << " order " << b->order << " thread " << b->thread << " genstep " << b->genstep.size() << "\n" ;
+    }
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,319 @@
+#pragma once
+/**
+SGenstepShard.h : split genstep arrays into photon balanced shards, simulate each and merge hits
+==================================================================================================
+
+SGenstep::GetGenstepSlices splits gensteps into slices that fit within
+the MaxSlot of a single device, which are then launched sequentially by
+QSim::simulate. SGenstepShard adds a layer above that allowing events
+larger than one devices slot budget to be spread across multiple
+simulation backends (devices, processes or nodes):
+
+1. SGenstepShard::GetShards partitions the genstep array into *num_shard*
+   contiguous gs[start:stop] ranges with balanced photon counts.
+   Contiguous ranges keep the photon order of the unsharded event so the
+   sslice ph_offset of each shard is the global index of its first photon.
+
+2. SGenstepShard::Simulate dispatches each shard to a backend functor
+   on its own thread (a local stand-in for separate devices or processes).
+   Within each shard SGenstep::GetGenstepSlices is used to respect the
+   per-backend max_slot, just like QSim::simulate.
+
+3. SGenstepShard::Merge concatenates the hits in shard order, adding the
+   shard ph_offset to the sphoton idx so the result is identical and
+   deterministic regardless of the number of shards or thread scheduling.
+
+For dispatch to other processes or nodes the shards can be persisted
+with SGenstepShard::Save into shard_000, shard_001, ... subfolders
+and the hits merged back with SGenstepShard::LoadMerge after each
+process has written hit.npy into its shard folder.
+
+
+Backend functor protocol
+--------------------------
+
+::
+
+    NP* simulate(const NP* gs, int backend)
+
+*gs* holds the gensteps of one slice, the returned hits must carry
+sphoton idx local to that slice, ie starting from zero for the first
+photon of the first genstep of the slice.
+The returned arrays are adopted by SGenstepShard and deleted after merging.
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <functional>
+#include <cstring>
+#include <cassert>
+
+#include "SGenstep.h"
+#include "sslice.h"
+#include "sphoton.h"
+#include "NP.hh"
+#include "NPFold.h"
+#include "sparallel.h"
+
+struct SGenstepShard
+{
+    typedef std::function<NP*(const NP* gs, int backend)> Simulate_t ;
+
+    static constexpr const char* SHARD_PREFIX = "shard_" ;
+    static constexpr const char* GENSTEP = "genstep" ;
+    static constexpr const char* HIT = "hit" ;
+
+    static void GetShards(std::vector<sslice>& shard, const NP* gs, int num_shard );
+    static NP*  Slice(const NP* gs, const sslice& sl );
+    static void OffsetIdx(NP* hit, int ph_offset );
+    static NP*  Merge(const std::vector<NP*>& hits, const std::vector<sslice>& shard );
+
+    static NP*  SimulateShard(const NP* gs, const sslice& sh, int max_slot, Simulate_t fn, int backend );
+    static NP*  Simulate(const NP* gs, int num_shard, int max_slot, Simulate_t fn );
+
+    static std::string ShardName(int idx);
+    static void Save(const NP* gs, int num_shard, const char* dir );
+    static NP*  LoadMerge(const char* dir );
+};
+
+
+/**
+SGenstepShard::GetShards
+--------------------------
+
+Partitions gensteps into at most *num_shard* contiguous ranges.
+The boundary of shard k is placed at the genstep where the cumulative
+photon count is closest to k*total/num_shard. As gensteps are not split
+the balance is limited by the largest genstep. Empty shards are
+skipped so fewer than num_shard may be returned.
+
+**/
+
+inline void SGenstepShard::GetShards(std::vector<sslice>& shard, const NP* gs, int num_shard )
+{
+    SGenstep::Check(gs);
+    assert( num_shard > 0 );
+    int num_gs = gs ? gs->shape[0] : 0 ;
+    if( num_gs == 0 ) return ;
+
+    const quad6* qq = (const quad6*)gs->cvalues<float>() ;
+
+    std::vector<long> cum(num_gs+1, 0) ;   // cum[i] : photons in gs[0:i]
+    for(int i=0 ; i < num_gs ; i++) cum[i+1] = cum[i] + SGenstep::GetNumPhoton(qq[i]) ;
+    long total = cum[num_gs] ;
+
+    int start = 0 ;
+    for(int k=1 ; k <= num_shard ; k++)
+    {
+        int stop = num_gs ;
+        if( k < num_shard )
+        {
+            double target = double(total)*double(k)/double(num_shard) ;
+            stop = start ;
+            while( stop < num_gs && double(cum[stop]) < target ) stop++ ;
+            bool prev_closer = stop > start && ( target - double(cum[stop-1]) ) < ( double(cum[stop]) - target ) ;
+            if(prev_closer) stop -= 1 ;
+        }
+        if( stop > start )
+        {
+            sslice sl = {} ;
+            sl.gs_start = start ;
+            sl.gs_stop = stop ;
+            sl.ph_count = int(cum[stop] - cum[start]) ;
+            shard.push_back(sl);
+            start = stop ;
+        }
+    }
+    sslice::SetOffset(shard);
+    assert( sslice::TotalPhoton(shard) == total );
+}
+
+/**
+SGenstepShard::Slice
+----------------------
+
+Returns copy of gs[sl.gs_start:sl.gs_stop]
+
+**/
+
+inline NP* SGenstepShard::Slice(const NP* gs, const sslice& sl )
+{
+    int num = sl.gs_stop - sl.gs_start ;
+    assert( num >= 0 && sl.gs_stop <= gs->shape[0] );
+    NP* a = NP::Make<float>( num, 6, 4 );
+    const quad6* src = (const quad6*)gs->cvalues<float>() ;
+    if( num > 0 ) memcpy( a->bytes(), src + sl.gs_start, num*sizeof(quad6) );
+    return a ;
+}
+
+inline void SGenstepShard::OffsetIdx(NP* hit, int ph_offset )
+{
+    if( hit == nullptr || ph_offset == 0 ) return ;
+    sphoton* hh = (sphoton*)hit->bytes() ;
+    int num_hit = hit->shape[0] ;
+    for(int i=0 ; i < num_hit ; i++) hh[i].set_idx( hh[i].idx() + ph_offset ) ;
+}
+
+/**
+SGenstepShard::Merge
+----------------------
+
+Concatenates hits from each shard in shard order, offsetting
+the photon idx by the shard ph_offset. Deletes the shard hit arrays.
+
+**/
+
+inline NP* SGenstepShard::Merge(const std::vector<NP*>& hits, const std::vector<sslice>& shard )
+{
+    assert( hits.size() == shard.size() );
+    int num_shard = shard.size();
+
+    std::vector<const NP*> aa ;
+    for(int i=0 ; i < num_shard ; i++)
+    {
+        NP* h = hits[i] ;
+        if( h == nullptr ) continue ;
+        OffsetIdx(h, shard[i].ph_offset );
+        aa.push_back(h);
+    }
+    NP* hit = aa.size() > 0 ? NP::Concatenate(aa) : NP::Make<float>(0, 4, 4) ;
+    for(int i=0 ; i < num_shard ; i++) delete hits[i] ;
+    return hit ;
+}
+
+/**
+SGenstepShard::SimulateShard
+------------------------------
+
+Simulates the gensteps of a single shard, using max_slot limited
+slices in the same way as QSim::simulate. Returns hits with
+photon idx local to the shard.
+
+**/
+
+inline NP* SGenstepShard::SimulateShard(const NP* gs, const sslice& sh, int max_slot, Simulate_t fn, int backend )
+{
+    NP* sgs = Slice(gs, sh);
+
+    std::vector<sslice> slice ;
+    SGenstep::GetGenstepSlices(slice, sgs, max_slot );
+    int num_slice = slice.size();
+
+    std::vector<NP*> hits(num_slice, nullptr) ;
+    for(int i=0 ; i < num_slice ; i++)
+    {
+        NP* lgs = Slice(sgs, slice[i]);
+        hits[i] = fn(lgs, backend);
+        delete lgs ;
+    }
+    delete sgs ;
+    return Merge(hits, slice);
+}
+
+/**
+SGenstepShard::Simulate
+-------------------------
+
+Each shard is simulated on its own thread with backend index equal
+to the shard index, using sparallel::For with one shard per thread. The merge happens after all threads are joined
+so the result does not depend on scheduling.
+
+**/
+
+inline NP* SGenstepShard::Simulate(const NP* gs, int num_shard, int max_slot, Simulate_t fn )
+{
+    std::vector<sslice> shard ;
+    GetShards(shard, gs, num_shard);
+    int num = shard.size();
+
+    std::vector<NP*> hits(num, nullptr) ;
+    sparallel::For(num, num, [&](int, int i0, int i1)
+    {
+        for(int i=i0 ; i < i1 ; i++) hits[i] = SimulateShard(gs, shard[i], max_slot, fn, i ) ;
+    });
+
+    return Merge(hits, shard);
+}
+
+
+inline std::string SGenstepShard::ShardName(int idx)
+{
+    std::stringstream ss ;
+    ss << SHARD_PREFIX << std::setw(3) << std::setfill('0') << idx ;
+    std::string str = ss.str();
+    return str ;
+}
+
+/**
+SGenstepShard::Save
+---------------------
+
+Writes the gensteps of each shard into *dir/shard_NNN/genstep.npy*
+with the sslice values in the array metadata, for dispatch to
+separate processes or nodes.
+
+**/
+
+inline void SGenstepShard::Save(const NP* gs, int num_shard, const char* dir )
+{
+    std::vector<sslice> shard ;
+    GetShards(shard, gs, num_shard);
+
+    NPFold* fold = new NPFold ;
+    for(int i=0 ; i < int(shard.size()) ; i++)
+    {
+        const sslice& sh = shard[i] ;
+        NP* sgs = Slice(gs, sh);
+        sgs->set_meta<int>("gs_start",  sh.gs_start );
+        sgs->set_meta<int>("gs_stop",   sh.gs_stop );
+        sgs->set_meta<int>("ph_offset", sh.ph_offset );
+        sgs->set_meta<int>("ph_count",  sh.ph_count );
+
+        NPFold* sub = new NPFold ;
+        sub->add(GENSTEP, sgs );
+        fold->add_subfold( ShardName(i).c_str(), sub );
+    }
+    fold->save(dir);
+    delete fold ;
+}
+
+/**
+SGenstepShard::LoadMerge
+--------------------------
+
+Loads hit.npy from each shard folder written by the shard
+processes, merging in shard order with ph_offset from the genstep metadata.
+Direct NP loads are used as the hit.npy are not listed in the NPFold
+index written by SGenstepShard::Save. Shards without hits contribute none.
+
+**/
+
+inline NP* SGenstepShard::LoadMerge(const char* dir )
+{
+    std::vector<NP*> hits ;
+    std::vector<sslice> shard ;
+
+    for(int i=0 ; ; i++)
+    {
+        std::string name = ShardName(i) ;
+        const char* rel = name.c_str() ;
+        if(!NP::Exists(dir, rel, "genstep.npy")) break ;
+
+        NP* sgs = NP::Load(dir, rel, "genstep.npy") ;
+        NP* sht = NP::Exists(dir, rel, "hit.npy") ? NP::Load(dir, rel, "hit.npy") : nullptr ;
+
+        sslice sh = {} ;
+        sh.gs_start  = sgs->get_meta<int>("gs_start", 0 );
+        sh.gs_stop   = sgs->get_meta<int>("gs_stop", 0 );
+        sh.ph_offset = sgs->get_meta<int>("ph_offset", 0 );
+        sh.ph_count  = sgs->get_meta<int>("ph_count", 0 );
+        delete sgs ;
+
+        shard.push_back(sh);
+        hits.push_back(sht);
+    }
+    return Merge(hits, shard);
+}
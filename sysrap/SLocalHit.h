@@ -0,0 +1,236 @@
+#pragma once
+/**
+SLocalHit.h : batch conversion of hits into instance local frame with sensor identity
+=======================================================================================
+
+SEvt::getLocalHit transforms one hit at a time, so sensitive detector
+integrations that loop over all hits calling U4HitGet::FromEvt do the
+w2m transform, the sensor identity decoding and any efficiency culling
+serially on the Geant4 thread. SLocalHit converts the whole hit array
+in one call spread over *num_thread* threads with sparallel.h
+(envvar SLocalHit__NUM_THREAD when *num_thread* is 0, default hardware concurrency):
+
+1. stree::get_iinst provides the cached double precision inverse instance
+   transform (w2m) for the hit iindex, avoiding per-hit frame lookups or
+   transform inversion
+
+2. the sensor identity is decoded from the 4th column of the same
+   transform with strid::Decode, exactly as SEvt::getLocalHit
+
+3. optional culling : when *efficiency* is set hits are kept with that
+   probability, using a uniform derived from the photon idx and *seed*
+   so the selection is reproducible and independent of the number of threads
+
+Results are written into the SoA vectors held by this struct, compacted
+and in the original hit order, so *global[i]* *local[i]* *ht[i]* correspond
+to hit *hidx[i]* of the input array. The vectors keep their capacity
+across events when the SLocalHit instance is reused.
+
+Usage::
+
+    SLocalHit lh ;
+    lh.efficiency = [](const sphit& ht){ return 0.9 ; } ;  // optional
+    SEvt::Get_EGPU()->getLocalHits(lh) ;
+
+    for(int i=0 ; i < lh.num() ; i++) ... lh.global[i], lh.local[i], lh.ht[i]
+
+NB the efficiency functor is called concurrently from the worker threads.
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+#include "sphoton.h"
+#include "sphit.h"
+#include "strid.h"
+#include "stree.h"
+#include "NP.hh"
+#include "sparallel.h"
+
+struct SLocalHit
+{
+    static constexpr const char* SLocalHit__NUM_THREAD = "SLocalHit__NUM_THREAD" ;
+    typedef std::function<double(const sphit& ht)> Efficiency_t ;
+
+    Efficiency_t efficiency ;   // optional, probability to keep each hit
+    uint64_t     seed ;
+    int          num_hit ;      // input hits before culling
+    int          num_missing ;  // hits without instance transform, left in global frame
+
+    std::vector<sphoton> global ;
+    std::vector<sphoton> local ;
+    std::vector<sphit>   ht ;
+    std::vector<int>     hidx ;
+
+    static double Uniform(uint64_t idx, uint64_t seed);
+
+    SLocalHit();
+    int  num() const ;
+    void clear();
+
+    void convert(const NP* hit, const stree* tree, int num_thread=0 );
+    void convert(const sphoton* hh, int _num_hit, const stree* tree, int num_thread=0 );
+    void convert_range(const sphoton* hh, int i0, int i1, const stree* tree, std::vector<char>& keep, int& missing );
+
+    std::string desc() const ;
+};
+
+
+/**
+SLocalHit::Uniform
+--------------------
+
+splitmix64 finalizer of the photon idx, giving a uniform in [0,1)
+that does not depend on evaluation order.
+
+**/
+
+inline double SLocalHit::Uniform(uint64_t idx, uint64_t seed) // static
+{
+    uint64_t z = idx + seed + 0x9e3779b97f4a7c15ull ;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull ;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull ;
+    z = z ^ (z >> 31) ;
+    return double(z >> 11)*(1.0/9007199254740992.0) ;
+}
+
+inline SLocalHit::SLocalHit()
+    :
+    efficiency(nullptr),
+    seed(0),
+    num_hit(0),
+    num_missing(0)
+{
+}
+
+inline int SLocalHit::num() const
+{
+    return global.size() ;
+}
+
+inline void SLocalHit::clear()
+{
+    num_hit = 0 ;
+    num_missing = 0 ;
+    global.clear();
+    local.clear();
+    ht.clear();
+    hidx.clear();
+}
+
+inline void SLocalHit::convert(const NP* hit, const stree* tree, int num_thread )
+{
+    int _num_hit = hit ? hit->shape[0] : 0 ;
+    if(hit) assert( hit->item_bytes() == sizeof(sphoton) );
+    const sphoton* hh = hit ? (const sphoton*)hit->bytes() : nullptr ;
+    convert(hh, _num_hit, tree, num_thread );
+}
+
+/**
+SLocalHit::convert
+--------------------
+
+Each thread handles a contiguous range writing into slots of the
+full size vectors together with a keep flag. The compaction
+afterwards is serial but amounts only to copying kept hits down.
+
+**/
+
+inline void SLocalHit::convert(const sphoton* hh, int _num_hit, const stree* tree, int num_thread )
+{
+    clear();
+    num_hit = _num_hit ;
+    if( num_hit <= 0 ) return ;
+
+    global.resize(num_hit);
+    local.resize(num_hit);
+    ht.resize(num_hit);
+    hidx.resize(num_hit);
+    std::vector<char> keep(num_hit, 0) ;
+
+    int nt = sparallel::NumThreadEnv(num_hit, SLocalHit__NUM_THREAD, num_thread) ;
+    std::vector<int> missing(nt, 0) ;
+    sparallel::For(num_hit, nt, [&](int t, int i0, int i1){ convert_range(hh, i0, i1, tree, keep, missing[t] ) ; });
+    for(int t=0 ; t < nt ; t++) num_missing += missing[t] ;
+
+    int j = 0 ;
+    for(int i=0 ; i < num_hit ; i++)
+    {
+        if(!keep[i]) continue ;
+        if( j != i )
+        {
+            global[j] = global[i] ;
+            local[j] = local[i] ;
+            ht[j] = ht[i] ;
+            hidx[j] = hidx[i] ;
+        }
+        j++ ;
+    }
+    global.resize(j);
+    local.resize(j);
+    ht.resize(j);
+    hidx.resize(j);
+}
+
+/**
+SLocalHit::convert_range
+--------------------------
+
+Follows SEvt::getLocalHit for each hit in [i0,i1). NB no "-1" sensor_identifier
+offset here as the stree iinst identity is never incremented.
+
+**/
+
+inline void SLocalHit::convert_range(const sphoton* hh, int i0, int i1, const stree* tree, std::vector<char>& keep, int& missing )
+{
+    for(int i=i0 ; i < i1 ; i++)
+    {
+        const sphoton& p = hh[i] ;
+        global[i] = p ;
+        local[i] = p ;
+        hidx[i] = i ;
+        ht[i].zero();
+
+        const glm::tmat4x4<double>* tr = tree ? tree->get_iinst(p.iindex) : nullptr ;
+        if( tr == nullptr )
+        {
+            missing += 1 ;
+        }
+        else
+        {
+            bool normalize = true ;
+            local[i].transform( *tr, normalize );
+
+            glm::tvec4<int64_t> col3 = {} ;
+            strid::Decode( *tr, col3 );
+
+            ht[i].iindex = col3[0] ;
+            ht[i].sensor_identifier = col3[2] ;
+            ht[i].sensor_index = col3[3] ;
+        }
+
+        bool k = true ;
+        if( efficiency ) k = Uniform( p.idx(), seed ) < efficiency(ht[i]) ;
+        keep[i] = k ? 1 : 0 ;
+    }
+}
+
+inline std::string SLocalHit::desc() const
+{
+    std::stringstream ss ;
+    ss << "SLocalHit::desc"
+       << " num_hit " << num_hit
+       << " num " << num()
+       << " num_missing " << num_missing
+       << " efficiency " << ( efficiency ? "YES" : "NO " )
+       << " seed " << seed
+       ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -25,6 +25,7 @@ NB SMesh.h is used in two situtions
 
 #include "stra.h"
 #include "NPFold.h"
+#include "SMeshSimplify.h"
 
 struct SMesh
 {
@@ -63,6 +64,10 @@ struct SMesh
     static SMesh* MakeCopy( const SMesh* src );
     SMesh* copy() const ;
 
+    static SMesh* MakeSimplified( const SMesh* src, double max_error, double weld_tol=SMeshSimplify::WELD_TOL );
+    SMesh* simplify(double max_error) const ;
+    int num_tri() const ;
+
     static bool IsConcat( const NPFold* fold );
     void import(          const NPFold* fold, const glm::tmat4x4<double>* tr );
     void import_concat(   const NPFold* fold, const glm::tmat4x4<double>* tr );
@@ -238,6 +243,51 @@ inline SMesh* SMesh::copy() const
     return MakeCopy(this);
 }
 
+/**
+SMesh::MakeSimplified
+-----------------------
+
+Welds and simplifies the src mesh with SMeshSimplify, bounding the
+surface deviation by max_error in mm. As the vtx are already in
+the frame of the SMeshGroup the error applies in that frame.
+Normals are recomputed from the simplified triangles in double
+precision as in SMesh::set_vtx. A max_error of zero only welds.
+
+**/
+
+inline SMesh* SMesh::MakeSimplified( const SMesh* src, double max_error, double weld_tol ) // static
+{
+    NP* wvtx = nullptr ;
+    NP* stri = nullptr ;
+    SMeshSimplify::Apply( wvtx, stri, src->vtx, src->tri, max_error, weld_tol );
+    NP* wnrm = MakeNormals( wvtx, stri, NRM_SMOOTH, nullptr );
+
+    SMesh* dst = new SMesh ;
+    dst->name = src->name ? strdup(src->name) : nullptr ;
+    dst->tr0  = src->tr0 ;
+    dst->names = src->names ;
+    dst->lvid = src->lvid ;
+
+    dst->set_tri( stri );
+    dst->vtx = NP::MakeNarrowIfWide(wvtx);
+    dst->nrm = NP::MakeNarrowIfWide(wnrm);
+    dst->set_vtx_range();
+
+    delete wvtx ;
+    delete wnrm ;
+    return dst ;
+}
+
+inline SMesh* SMesh::simplify(double max_error) const
+{
+    return MakeSimplified(this, max_error);
+}
+
+inline int SMesh::num_tri() const
+{
+    return tri ? tri->shape[0] : 0 ;
+}
+
 
 
 
@@ -22,6 +22,10 @@ struct SMeshGroup
     static SMeshGroup* MakeCopy(const SMeshGroup* src, const SBitSet* elv ); 
     SMeshGroup* copy(const SBitSet* elv=nullptr) const ; 
 
+    static SMeshGroup* MakeSimplified(const SMeshGroup* src, double max_error ); 
+    SMeshGroup* simplify(double max_error) const ; 
+    int num_tri() const ; 
+
 
     NPFold* serialize() const ; 
     void save(const char* dir) const ; 
@@ -86,6 +90,38 @@ inline SMeshGroup* SMeshGroup::copy(const SBitSet* elv) const
     return MakeCopy(this, elv); 
 } 
 
+/**
+SMeshGroup::MakeSimplified
+---------------------------
+
+Each sub is simplified separately so the prim structure is retained
+and surfaces of different solids are never welded together.
+
+**/
+
+inline SMeshGroup* SMeshGroup::MakeSimplified(const SMeshGroup* src, double max_error ) // static
+{
+    SMeshGroup* dst = new SMeshGroup ; 
+    for(size_t i=0 ; i < src->subs.size() ; i++)
+    {
+        dst->subs.push_back( src->subs[i]->simplify(max_error) ); 
+        dst->names.push_back( src->names[i] ); 
+    }
+    return dst ; 
+}
+
+inline SMeshGroup* SMeshGroup::simplify(double max_error) const
+{
+    return MakeSimplified(this, max_error); 
+}
+
+inline int SMeshGroup::num_tri() const
+{
+    int num = 0 ; 
+    for(size_t i=0 ; i < subs.size() ; i++) num += subs[i]->num_tri() ; 
+    return num ; 
+}
+
 
 
 
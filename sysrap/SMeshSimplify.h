@@ -0,0 +1,716 @@
+#pragma once
+/**
+SMeshSimplify.h : vertex welding and quadric edge collapse of triangulated meshes
+====================================================================================
+
+Force triangulated solids and render meshes from U4Mesh are full
+resolution G4Polyhedron triangulations. SMeshSimplify reduces the
+triangle count while bounding the geometric error in mm, it is used
+via SMesh::MakeSimplified to form the SScene level-of-detail meshes.
+
+weld
+    vertices within *weld_tol* mm of an earlier vertex are merged into it
+    using a hash grid with cell size weld_tol, triangles that become
+    degenerate are dropped
+
+simplify
+    Garland-Heckbert quadric error edge collapse. Each vertex accumulates
+    the plane quadrics of its original faces so v^T Q v is the sum of
+    squared distances from v to those planes. Edges are collapsed in order
+    of increasing error until the cheapest remaining error exceeds
+    max_error^2 (or the optional target triangle count is reached).
+    As the error sums over all accumulated planes it bounds from
+    above the squared distance to each of them, making max_error a
+    conservative bound on the surface deviation in mm.
+
+Collapses are rejected when they would:
+
+1. break manifoldness (link condition)
+2. flip or degenerate a surrounding triangle (normal cosine below min_cos)
+3. move a vertex on a boundary or non-manifold edge, such vertices
+   are locked so open seams and shared edges are preserved
+
+The implementation is plain std containers over (num_vtx,3) double
+and (num_tri,3) int arrays so it has no glm dependency.
+
+::
+
+    ~/o/sysrap/tests/SMeshSimplify_test.sh
+
+**/
+
+#include <vector>
+#include <array>
+#include <queue>
+#include <iterator>
+#include <unordered_map>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <cassert>
+
+#include "NP.hh"
+
+struct SMeshSimplify
+{
+    static constexpr const double WELD_TOL = 1e-4 ;   // mm
+    static constexpr const double MIN_COS = 0.2 ;
+
+    struct Quadric
+    {
+        double m[10] ;   // symmetric 4x4 : aa ab ac ad bb bc bd cc cd dd
+        void zero(){ for(int i=0 ; i < 10 ; i++) m[i] = 0. ; }
+        void add(const Quadric& o){ for(int i=0 ; i < 10 ; i++) m[i] += o.m[i] ; }
+        void plane(double a, double b, double c, double d)
+        {
+            m[0] = a*a ; m[1] = a*b ; m[2] = a*c ; m[3] = a*d ;
+            m[4] = b*b ; m[5] = b*c ; m[6] = b*d ;
+            m[7] = c*c ; m[8] = c*d ;
+            m[9] = d*d ;
+        }
+        double eval(const double* p) const
+        {
+            double x = p[0], y = p[1], z = p[2] ;
+            return m[0]*x*x + 2.*m[1]*x*y + 2.*m[2]*x*z + 2.*m[3]*x
+                 + m[4]*y*y + 2.*m[5]*y*z + 2.*m[6]*y
+                 + m[7]*z*z + 2.*m[8]*z
+                 + m[9] ;
+        }
+        bool optimal(double* p) const ;
+    };
+
+    struct Collapse
+    {
+        double cost ;
+        int u, v ;          // v is removed, u survives at pos
+        int ver_u, ver_v ;
+        double pos[3] ;
+        bool operator<(const Collapse& o) const { return cost > o.cost ; }  // min-heap
+    };
+
+    double max_error ;
+    double weld_tol ;
+    double min_cos ;
+    int    target_tri ;
+
+    std::vector<double> vtx ;       // 3*num_vtx
+    std::vector<int>    tri ;       // 3*num_tri
+
+    std::vector<char>    vdead ;
+    std::vector<char>    tdead ;
+    std::vector<char>    locked ;
+    std::vector<int>     version ;
+    std::vector<Quadric> quad ;
+    std::vector<std::vector<int>> vtri ;   // vertex to face adjacency
+
+    int num_input_vtx ;
+    int num_input_tri ;
+    int num_weld ;
+    int num_collapse ;
+    int num_reject ;
+    int num_tri_alive ;
+    double max_cost ;
+
+    SMeshSimplify(double max_error, double weld_tol=WELD_TOL, double min_cos=MIN_COS, int target_tri=0 );
+
+    void load(const NP* a_vtx, const NP* a_tri );
+    int  num_vtx() const ;
+    int  num_tri() const ;
+
+    void weld();
+    void simplify();
+
+    void init_adjacency();
+    void init_quadrics();
+    void init_locked();
+    bool cost(Collapse& c, int u, int v) const ;
+    void push_edges(std::priority_queue<Collapse>& heap, int u) const ;
+    void neighbours(std::vector<int>& nn, int u) const ;
+    bool link_ok(int u, int v) const ;
+    bool flip_ok(int u, int v, const double* p) const ;
+    void collapse(const Collapse& c);
+
+    void compact();
+    NP*  get_vtx() const ;
+    NP*  get_tri() const ;
+
+    static void Apply(NP*& o_vtx, NP*& o_tri, const NP* a_vtx, const NP* a_tri, double max_error, double weld_tol=WELD_TOL );
+
+    std::string desc() const ;
+};
+
+
+/**
+SMeshSimplify::Quadric::optimal
+---------------------------------
+
+Minimizes v^T Q v by solving the 3x3 system A p = -b,
+returns false when A is near singular (flat or cylindrical
+neighbourhoods) leaving the caller to pick among candidate points.
+
+**/
+
+inline bool SMeshSimplify::Quadric::optimal(double* p) const
+{
+    double a00 = m[0], a01 = m[1], a02 = m[2] ;
+    double a11 = m[4], a12 = m[5], a22 = m[7] ;
+    double b0 = -m[3], b1 = -m[6], b2 = -m[8] ;
+
+    double c00 = a11*a22 - a12*a12 ;
+    double c01 = a02*a12 - a01*a22 ;
+    double c02 = a01*a12 - a02*a11 ;
+    double det = a00*c00 + a01*c01 + a02*c02 ;
+
+    double scale = a00 + a11 + a22 ;
+    if( !(std::abs(det) > 1e-10*scale*scale*scale) ) return false ;
+
+    double c11 = a00*a22 - a02*a02 ;
+    double c12 = a01*a02 - a00*a12 ;
+    double c22 = a00*a11 - a01*a01 ;
+
+    p[0] = (c00*b0 + c01*b1 + c02*b2)/det ;
+    p[1] = (c01*b0 + c11*b1 + c12*b2)/det ;
+    p[2] = (c02*b0 + c12*b1 + c22*b2)/det ;
+    return true ;
+}
+
+
+inline SMeshSimplify::SMeshSimplify(double max_error_, double weld_tol_, double min_cos_, int target_tri_ )
+    :
+    max_error(max_error_),
+    weld_tol(weld_tol_),
+    min_cos(min_cos_),
+    target_tri(target_tri_),
+    num_input_vtx(0),
+    num_input_tri(0),
+    num_weld(0),
+    num_collapse(0),
+    num_reject(0),
+    num_tri_alive(0),
+    max_cost(0.)
+{
+}
+
+/**
+SMeshSimplify::load
+---------------------
+
+Accepts float or double (num_vtx,3) vertices and int (num_tri,3) triangles.
+
+**/
+
+inline void SMeshSimplify::load(const NP* a_vtx, const NP* a_tri )
+{
+    assert( a_vtx && a_vtx->shape.size() == 2 && a_vtx->shape[1] == 3 );
+    assert( a_tri && a_tri->shape.size() == 2 && a_tri->shape[1] == 3 && a_tri->uifc == 'i' && a_tri->ebyte == 4 );
+
+    num_input_vtx = a_vtx->shape[0] ;
+    num_input_tri = a_tri->shape[0] ;
+
+    vtx.resize(3*num_input_vtx);
+    if( a_vtx->ebyte == 8 )
+    {
+        const double* vv = a_vtx->cvalues<double>() ;
+        for(int i=0 ; i < 3*num_input_vtx ; i++) vtx[i] = vv[i] ;
+    }
+    else
+    {
+        const float* vv = a_vtx->cvalues<float>() ;
+        for(int i=0 ; i < 3*num_input_vtx ; i++) vtx[i] = vv[i] ;
+    }
+
+    const int* tt = a_tri->cvalues<int>() ;
+    tri.assign( tt, tt + 3*num_input_tri );
+
+    vdead.assign(num_input_vtx, 0);
+    tdead.assign(num_input_tri, 0);
+    num_tri_alive = num_input_tri ;
+}
+
+inline int SMeshSimplify::num_vtx() const { return vtx.size()/3 ; }
+inline int SMeshSimplify::num_tri() const { return tri.size()/3 ; }
+
+/**
+SMeshSimplify::weld
+---------------------
+
+Each vertex is compared with the representatives already
+registered in its own and the 26 neighbouring cells,
+so all pairs closer than weld_tol are found.
+
+**/
+
+inline void SMeshSimplify::weld()
+{
+    if( !(weld_tol > 0.) ) return ;
+    int nv = num_vtx() ;
+
+    struct KeyHash
+    {
+        size_t operator()(const std::array<int64_t,3>& k) const
+        {
+            uint64_t h = uint64_t(k[0])*0x9e3779b97f4a7c15ull ;
+            h ^= uint64_t(k[1]) + 0x7f4a7c159e3779b9ull + (h << 6) + (h >> 2) ;
+            h ^= uint64_t(k[2]) + 0x94d049bb133111ebull + (h << 6) + (h >> 2) ;
+            return size_t(h) ;
+        }
+    };
+    std::unordered_map<std::array<int64_t,3>, std::vector<int>, KeyHash> grid ;
+    grid.reserve(nv);
+
+    std::vector<int> remap(nv, -1) ;
+    double tol2 = weld_tol*weld_tol ;
+
+    for(int i=0 ; i < nv ; i++)
+    {
+        const double* p = vtx.data() + 3*i ;
+        std::array<int64_t,3> k = {{ int64_t(std::floor(p[0]/weld_tol)), int64_t(std::floor(p[1]/weld_tol)), int64_t(std::floor(p[2]/weld_tol)) }} ;
+
+        int rep = -1 ;
+        for(int dx=-1 ; dx <= 1 && rep < 0 ; dx++)
+        for(int dy=-1 ; dy <= 1 && rep < 0 ; dy++)
+        for(int dz=-1 ; dz <= 1 && rep < 0 ; dz++)
+        {
+            std::array<int64_t,3> kk = {{ k[0]+dx, k[1]+dy, k[2]+dz }} ;
+            auto it = grid.find(kk) ;
+            if( it == grid.end() ) continue ;
+            for(int r : it->second)
+            {
+                const double* q = vtx.data() + 3*r ;
+                double d2 = (p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]) ;
+                if( d2 <= tol2 ) { rep = r ; break ; }
+            }
+        }
+        if( rep < 0 )
+        {
+            grid[k].push_back(i) ;
+            remap[i] = i ;
+        }
+        else
+        {
+            remap[i] = rep ;
+            vdead[i] = 1 ;
+            num_weld += 1 ;
+        }
+    }
+
+    int nt = num_tri() ;
+    for(int t=0 ; t < nt ; t++)
+    {
+        int* f = tri.data() + 3*t ;
+        for(int j=0 ; j < 3 ; j++) f[j] = remap[f[j]] ;
+        bool degenerate = f[0] == f[1] || f[1] == f[2] || f[2] == f[0] ;
+        if( degenerate && !tdead[t] )
+        {
+            tdead[t] = 1 ;
+            num_tri_alive -= 1 ;
+        }
+    }
+}
+
+inline void SMeshSimplify::init_adjacency()
+{
+    int nv = num_vtx() ;
+    int nt = num_tri() ;
+    vtri.assign(nv, std::vector<int>());
+    for(int t=0 ; t < nt ; t++)
+    {
+        if(tdead[t]) continue ;
+        for(int j=0 ; j < 3 ; j++) vtri[tri[3*t+j]].push_back(t) ;
+    }
+    version.assign(nv, 0);
+}
+
+inline void SMeshSimplify::init_quadrics()
+{
+    int nv = num_vtx() ;
+    int nt = num_tri() ;
+    quad.resize(nv);
+    for(int i=0 ; i < nv ; i++) quad[i].zero() ;
+
+    for(int t=0 ; t < nt ; t++)
+    {
+        if(tdead[t]) continue ;
+        const double* p0 = vtx.data() + 3*tri[3*t+0] ;
+        const double* p1 = vtx.data() + 3*tri[3*t+1] ;
+        const double* p2 = vtx.data() + 3*tri[3*t+2] ;
+
+        double e1[3] = { p1[0]-p0[0], p1[1]-p0[1], p1[2]-p0[2] } ;
+        double e2[3] = { p2[0]-p0[0], p2[1]-p0[1], p2[2]-p0[2] } ;
+        double n[3] = { e1[1]*e2[2]-e1[2]*e2[1], e1[2]*e2[0]-e1[0]*e2[2], e1[0]*e2[1]-e1[1]*e2[0] } ;
+        double len = std::sqrt( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] ) ;
+        if( !(len > 0.) ) continue ;
+        n[0] /= len ; n[1] /= len ; n[2] /= len ;
+        double d = -(n[0]*p0[0] + n[1]*p0[1] + n[2]*p0[2]) ;
+
+        Quadric k ;
+        k.plane(n[0], n[1], n[2], d);
+        for(int j=0 ; j < 3 ; j++) quad[tri[3*t+j]].add(k) ;
+    }
+}
+
+/**
+SMeshSimplify::init_locked
+----------------------------
+
+Edges used by other than exactly two live faces are boundary
+or non-manifold, their vertices are not moved.
+
+**/
+
+inline void SMeshSimplify::init_locked()
+{
+    int nv = num_vtx() ;
+    int nt = num_tri() ;
+    locked.assign(nv, 0);
+
+    std::unordered_map<uint64_t, int> edge ;
+    edge.reserve(3*num_tri_alive);
+    for(int t=0 ; t < nt ; t++)
+    {
+        if(tdead[t]) continue ;
+        for(int j=0 ; j < 3 ; j++)
+        {
+            uint32_t a = tri[3*t+j] ;
+            uint32_t b = tri[3*t+(j+1)%3] ;
+            uint64_t key = a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a) ;
+            edge[key] += 1 ;
+        }
+    }
+    for(auto it = edge.begin() ; it != edge.end() ; it++)
+    {
+        if( it->second == 2 ) continue ;
+        locked[it->first >> 32] = 1 ;
+        locked[it->first & 0xffffffffull] = 1 ;
+    }
+}
+
+/**
+SMeshSimplify::cost
+---------------------
+
+Candidate positions are the quadric optimum, the endpoints and
+the midpoint. A locked endpoint pins the position. Arranges
+for the survivor u to be the locked vertex when there is one.
+
+**/
+
+inline bool SMeshSimplify::cost(Collapse& c, int u, int v) const
+{
+    if( locked[u] && locked[v] ) return false ;
+    if( locked[v] ) std::swap(u, v) ;
+
+    Quadric q = quad[u] ;
+    q.add(quad[v]) ;
+
+    const double* pu = vtx.data() + 3*u ;
+    const double* pv = vtx.data() + 3*v ;
+
+    double cand[4][3] ;
+    int ncand = 0 ;
+    for(int j=0 ; j < 3 ; j++) cand[ncand][j] = pu[j] ;
+    ncand++ ;
+    if( !locked[u] )
+    {
+        for(int j=0 ; j < 3 ; j++) cand[ncand][j] = pv[j] ;
+        ncand++ ;
+        for(int j=0 ; j < 3 ; j++) cand[ncand][j] = 0.5*(pu[j] + pv[j]) ;
+        ncand++ ;
+        if(q.optimal(cand[ncand])) ncand++ ;
+    }
+
+    int best = 0 ;
+    double best_cost = q.eval(cand[0]) ;
+    for(int i=1 ; i < ncand ; i++)
+    {
+        double e = q.eval(cand[i]) ;
+        if( e < best_cost ) { best_cost = e ; best = i ; }
+    }
+
+    c.cost = std::max( 0., best_cost ) ;
+    c.u = u ;
+    c.v = v ;
+    c.ver_u = version[u] ;
+    c.ver_v = version[v] ;
+    for(int j=0 ; j < 3 ; j++) c.pos[j] = cand[best][j] ;
+    return true ;
+}
+
+inline void SMeshSimplify::neighbours(std::vector<int>& nn, int u) const
+{
+    nn.clear();
+    for(int t : vtri[u])
+    {
+        if(tdead[t]) continue ;
+        for(int j=0 ; j < 3 ; j++) if( tri[3*t+j] != u ) nn.push_back(tri[3*t+j]) ;
+    }
+    std::sort(nn.begin(), nn.end());
+    nn.erase( std::unique(nn.begin(), nn.end()), nn.end() );
+}
+
+inline void SMeshSimplify::push_edges(std::priority_queue<Collapse>& heap, int u) const
+{
+    std::vector<int> nn ;
+    neighbours(nn, u);
+    for(int v : nn)
+    {
+        Collapse c ;
+        if(cost(c, u, v)) heap.push(c) ;
+    }
+}
+
+/**
+SMeshSimplify::link_ok
+------------------------
+
+The vertices adjacent to both u and v must be exactly the
+opposite vertices of the faces sharing edge uv.
+
+**/
+
+inline bool SMeshSimplify::link_ok(int u, int v) const
+{
+    std::vector<int> nu, nv, common, opposite ;
+    neighbours(nu, u);
+    neighbours(nv, v);
+    std::set_intersection(nu.begin(), nu.end(), nv.begin(), nv.end(), std::back_inserter(common));
+
+    for(int t : vtri[u])
+    {
+        if(tdead[t]) continue ;
+        const int* f = tri.data() + 3*t ;
+        bool has_v = f[0] == v || f[1] == v || f[2] == v ;
+        if(!has_v) continue ;
+        for(int j=0 ; j < 3 ; j++) if( f[j] != u && f[j] != v ) opposite.push_back(f[j]) ;
+    }
+    std::sort(opposite.begin(), opposite.end());
+    return common == opposite ;
+}
+
+/**
+SMeshSimplify::flip_ok
+------------------------
+
+Faces around u or v that survive the collapse must keep
+their orientation and not become slivers.
+
+**/
+
+inline bool SMeshSimplify::flip_ok(int u, int v, const double* p) const
+{
+    for(int k=0 ; k < 2 ; k++)
+    {
+        int w = k == 0 ? u : v ;
+        for(int t : vtri[w])
+        {
+            if(tdead[t]) continue ;
+            const int* f = tri.data() + 3*t ;
+            bool has_u = f[0] == u || f[1] == u || f[2] == u ;
+            bool has_v = f[0] == v || f[1] == v || f[2] == v ;
+            if( has_u && has_v ) continue ;   // removed by the collapse
+
+            const double* q[3] ;
+            const double* r[3] ;
+            for(int j=0 ; j < 3 ; j++)
+            {
+                q[j] = vtx.data() + 3*f[j] ;
+                r[j] = f[j] == w ? p : q[j] ;
+            }
+            double a1[3] = { q[1][0]-q[0][0], q[1][1]-q[0][1], q[1][2]-q[0][2] } ;
+            double a2[3] = { q[2][0]-q[0][0], q[2][1]-q[0][1], q[2][2]-q[0][2] } ;
+            double b1[3] = { r[1][0]-r[0][0], r[1][1]-r[0][1], r[1][2]-r[0][2] } ;
+            double b2[3] = { r[2][0]-r[0][0], r[2][1]-r[0][1], r[2][2]-r[0][2] } ;
+            double na[3] = { a1[1]*a2[2]-a1[2]*a2[1], a1[2]*a2[0]-a1[0]*a2[2], a1[0]*a2[1]-a1[1]*a2[0] } ;
+            double nb[3] = { b1[1]*b2[2]-b1[2]*b2[1], b1[2]*b2[0]-b1[0]*b2[2], b1[0]*b2[1]-b1[1]*b2[0] } ;
+            double la = std::sqrt( na[0]*na[0] + na[1]*na[1] + na[2]*na[2] ) ;
+            double lb = std::sqrt( nb[0]*nb[0] + nb[1]*nb[1] + nb[2]*nb[2] ) ;
+            if( !(lb > 0.) ) return false ;
+            if( !(la > 0.) ) continue ;
+            double cs = ( na[0]*nb[0] + na[1]*nb[1] + na[2]*nb[2] )/(la*lb) ;
+            if( cs < min_cos ) return false ;
+        }
+    }
+    return true ;
+}
+
+/**
+SMeshSimplify::collapse
+-------------------------
+
+Moves u to the collapse position, retires v and the faces
+shared by u and v, redirects the other faces of v to u.
+
+**/
+
+inline void SMeshSimplify::collapse(const Collapse& c)
+{
+    int u = c.u ;
+    int v = c.v ;
+    for(int j=0 ; j < 3 ; j++) vtx[3*u+j] = c.pos[j] ;
+    quad[u].add(quad[v]);
+
+    for(int t : vtri[v])
+    {
+        if(tdead[t]) continue ;
+        int* f = tri.data() + 3*t ;
+        bool has_u = f[0] == u || f[1] == u || f[2] == u ;
+        if( has_u )
+        {
+            tdead[t] = 1 ;
+            num_tri_alive -= 1 ;
+        }
+        else
+        {
+            for(int j=0 ; j < 3 ; j++) if( f[j] == v ) f[j] = u ;
+            vtri[u].push_back(t);
+        }
+    }
+
+    std::vector<int>& ut = vtri[u] ;
+    ut.erase( std::remove_if(ut.begin(), ut.end(), [this](int t){ return tdead[t] != 0 ; }), ut.end() );
+    vtri[v].clear();
+
+    vdead[v] = 1 ;
+    version[u] += 1 ;
+    version[v] += 1 ;
+    num_collapse += 1 ;
+    max_cost = std::max( max_cost, c.cost ) ;
+}
+
+inline void SMeshSimplify::simplify()
+{
+    init_adjacency();
+    init_quadrics();
+    init_locked();
+
+    std::priority_queue<Collapse> heap ;
+    int nv = num_vtx() ;
+    for(int u=0 ; u < nv ; u++)
+    {
+        if(vdead[u]) continue ;
+        std::vector<int> nn ;
+        neighbours(nn, u);
+        for(int v : nn)
+        {
+            if( v < u ) continue ;
+            Collapse c ;
+            if(cost(c, u, v)) heap.push(c) ;
+        }
+    }
+
+    double limit = max_error*max_error ;
+
+    while(!heap.empty())
+    {
+        if( target_tri > 0 && num_tri_alive <= target_tri ) break ;
+        Collapse c = heap.top() ;
+        heap.pop();
+        if( c.cost > limit ) break ;
+        if( vdead[c.u] || vdead[c.v] ) continue ;
+        if( c.ver_u != version[c.u] || c.ver_v != version[c.v] ) continue ;   // stale
+
+        if( !link_ok(c.u, c.v) || !flip_ok(c.u, c.v, c.pos) )
+        {
+            num_reject += 1 ;
+            continue ;
+        }
+        collapse(c);
+        push_edges(heap, c.u);
+    }
+}
+
+/**
+SMeshSimplify::compact
+------------------------
+
+Drops dead faces and unreferenced vertices, keeping the
+original relative order of both.
+
+**/
+
+inline void SMeshSimplify::compact()
+{
+    int nv = num_vtx() ;
+    int nt = num_tri() ;
+    std::vector<int> used(nv, 0) ;
+    for(int t=0 ; t < nt ; t++) if(!tdead[t]) for(int j=0 ; j < 3 ; j++) used[tri[3*t+j]] = 1 ;
+
+    std::vector<int> remap(nv, -1) ;
+    std::vector<double> cvtx ;
+    for(int i=0 ; i < nv ; i++)
+    {
+        if(!used[i]) continue ;
+        remap[i] = cvtx.size()/3 ;
+        for(int j=0 ; j < 3 ; j++) cvtx.push_back(vtx[3*i+j]) ;
+    }
+    std::vector<int> ctri ;
+    for(int t=0 ; t < nt ; t++)
+    {
+        if(tdead[t]) continue ;
+        for(int j=0 ; j < 3 ; j++) ctri.push_back(remap[tri[3*t+j]]) ;
+    }
+    vtx.swap(cvtx);
+    tri.swap(ctri);
+    vdead.assign(num_vtx(), 0);
+    tdead.assign(num_tri(), 0);
+    vtri.clear();
+    quad.clear();
+    locked.clear();
+    version.clear();
+    num_tri_alive = num_tri() ;
+}
+
+inline NP* SMeshSimplify::get_vtx() const
+{
+    NP* a = NP::Make<double>( num_vtx(), 3 );
+    if(!vtx.empty()) memcpy( a->bytes(), vtx.data(), a->arr_bytes() );
+    return a ;
+}
+
+inline NP* SMeshSimplify::get_tri() const
+{
+    NP* a = NP::Make<int>( num_tri(), 3 );
+    if(!tri.empty()) memcpy( a->bytes(), tri.data(), a->arr_bytes() );
+    return a ;
+}
+
+/**
+SMeshSimplify::Apply
+----------------------
+
+Returns double precision vertices and int triangles of the welded
+and simplified mesh. A max_error of zero only welds.
+
+**/
+
+inline void SMeshSimplify::Apply(NP*& o_vtx, NP*& o_tri, const NP* a_vtx, const NP* a_tri, double max_error, double weld_tol ) // static
+{
+    SMeshSimplify ms(max_error, weld_tol) ;
+    ms.load(a_vtx, a_tri);
+    ms.weld();
+    if( max_error > 0. ) ms.simplify();
+    ms.compact();
+    o_vtx = ms.get_vtx();
+    o_tri = ms.get_tri();
+}
+
+inline std::string SMeshSimplify::desc() const
+{
+    std::stringstream ss ;
+    ss << "SMeshSimplify::desc"
+       << " max_error " << max_error
+       << " weld_tol " << weld_tol
+       << " num_input_vtx " << num_input_vtx
+       << " num_input_tri " << num_input_tri
+       << " num_weld " << num_weld
+       << " num_collapse " << num_collapse
+       << " num_reject " << num_reject
+       << " num_vtx " << num_vtx()
+       << " num_tri_alive " << num_tri_alive
+       << " max_cost " << max_cost
+       ;
+    std::string str = ss.str();
+    return str ;
+}
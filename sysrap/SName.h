@@ -7,6 +7,12 @@ SName.h  : formerly CSG/CSGName.h
 Identity machinery based around a referenced vector of string names.
 Canonical usage is with the meshnames.txt, aka the lv solid names.
 
+When an SNameIndex is set, with set_index or by SName::Load finding
+the persisted index alongside the names file, the queries use that
+instead of scanning all names. The index digest is checked against
+the names when it is set, after changing the names in-place call
+set_index or make_index again.
+
 An important user of this is::
 
     SGeoConfig::ELVSelection
@@ -23,6 +29,7 @@ An important user of this is::
 
 #include "spath.h"
 #include "sstr.h"
+#include "SNameIndex.h"
 
 
 enum { SName_EXACT, SName_START, SName_CONTAIN } ;
@@ -50,9 +57,14 @@ struct SName
 
 
     const std::vector<std::string>& name ;
+    const SNameIndex* index ;
 
     SName(const std::vector<std::string>& name );
 
+    void set_index(const SNameIndex* index_);
+    const SNameIndex* make_index();
+    bool has_index() const ;
+
     std::string desc() const ;
     std::string detail() const ;
 
@@ -109,6 +121,17 @@ inline SName* SName::Load(const char* path_)
     while(std::getline(ifs, line)) names->push_back(line) ;
 
     SName* id = new SName(*names) ;
+
+    std::string p(path);
+    size_t slash = p.rfind('/') ;
+    size_t dot = p.rfind('.') ;
+    bool with_dir = slash != std::string::npos && dot != std::string::npos && dot > slash ;
+    if(with_dir)
+    {
+        std::string dir = p.substr(0, slash) ;
+        std::string stem = p.substr(slash+1, dot-slash-1) ;
+        id->set_index( SNameIndex::Load(*names, dir.c_str(), stem.c_str()) ) ;
+    }
     return id ;
 }
 
@@ -117,8 +140,37 @@ inline SName* SName::GEOMLoad(){ return Load(GEOMLoadPath); }
 
 inline SName::SName( const std::vector<std::string>& name_ )
     :
-    name(name_)
+    name(name_),
+    index(nullptr)
+{
+}
+
+/**
+SName::set_index
+------------------
+
+The index must be for the same referenced names, an index with a digest
+that does not match the names is not used. When the number of names changes
+after setting the index it is ignored by the queries.
+
+**/
+
+inline void SName::set_index(const SNameIndex* index_)
+{
+    bool valid = index_ && index_->is_valid() && index_->digest == SNameIndex::Digest(name) ;
+    if(index_ && !valid) std::cerr << "SName::set_index IGNORING STALE INDEX " << index_->desc() << std::endl ;
+    index = valid ? index_ : nullptr ;
+}
+
+inline const SNameIndex* SName::make_index()
+{
+    index = SNameIndex::Create(name) ;
+    return index ;
+}
+
+inline bool SName::has_index() const
 {
+    return index && index->is_current() ;
 }
 
 inline std::string SName::desc() const
@@ -244,6 +296,8 @@ method when an array is being updated
 
 inline int SName::getIndex(const char* query, unsigned& count) const
 {
+    if(has_index()) return index->exact(query, count) ;
+
     int result(-1);
     count = 0 ;
     for(unsigned i=0 ; i < name.size() ; i++)
@@ -307,13 +361,20 @@ inline int SName::findIndex(const char* q, unsigned& count, int max_count, bool
 {
     int result(-1);
     count = 0 ;
-    for(unsigned i=0 ; i < name.size() ; i++)
+    if(has_index())
     {
-        const char* k = name[i].c_str() ;
-        if( sstr::Match( k, q, starting ))
+        result = index->find(q, count, starting ? 'S' : 'E' );
+    }
+    else
+    {
+        for(unsigned i=0 ; i < name.size() ; i++)
         {
-            if(count == 0) result = i ;
-            count += 1 ;
+            const char* k = name[i].c_str() ;
+            if( sstr::Match( k, q, starting ))
+            {
+                if(count == 0) result = i ;
+                count += 1 ;
+            }
         }
     }
     bool count_ok = max_count == -1 || count <= unsigned(max_count) ;
@@ -487,6 +548,11 @@ inline bool SName::Match( const char* n, const char* q, unsigned qtype ) // stat
 inline void SName::findIndices(std::vector<unsigned>& idxs, const char* q, char qt ) const
 {
     unsigned qtype = QType(qt);
+    if(has_index())
+    {
+        index->find_all(idxs, q, qtype == SName_START ? 'S' : ( qtype == SName_CONTAIN ? 'C' : 'E' ) );
+        return ;
+    }
     for(unsigned i=0 ; i < name.size() ; i++)
     {
         const char* n = name[i].c_str() ;
@@ -0,0 +1,562 @@
+#pragma once
+/**
+SNameIndex.h : prebuilt lookup index over a vector of names
+=============================================================
+
+SName and stree name queries formerly did linear scans with string
+compares over all names for every query, which with tens of thousands
+of names and many queries per job shows up in startup profiles.
+SNameIndex holds three structures giving the same results as the scans:
+
+exact (SName_EXACT)
+    open addressing hash table with slots (first_idx, count) keyed on
+    the FNV-1a hash of the name : O(1)
+
+start (SName_START)
+    name indices sorted by (name, idx), the names starting with the query
+    are a contiguous range found with two binary searches. The first
+    (lowest index) name in the range comes from a sparse table range
+    minimum over the sorted indices : O(log n)
+
+contain (SName_CONTAIN)
+    trigram posting lists : the candidate names are the intersection of the
+    lists of all query trigrams, which are then verified with strstr.
+    Queries shorter than 3 chars fall back to a scan.
+
+The index references the names, like SName, so the names must outlive it.
+It is persisted as an NPFold, eg CSGFoundry/meshname_index alongside
+CSGFoundry/meshname.txt, with the number of names and a digest of the names
+in the metadata such that a stale index is detected on loading and rebuilt.
+The sparse table is cheap to recreate so is not persisted.
+
+is_valid compares the digest of the referenced names, which costs a pass
+over all names so it is for checking an index when it is attached to the
+names (see SName::set_index). is_current is the cheap per query guard
+that the number of names is unchanged since the index was built.
+
+**/
+
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+
+#include "NPFold.h"
+
+struct SNameIndex
+{
+    static constexpr const char* NAME = "SNameIndex" ;
+    static constexpr const int EMPTY = -1 ;
+
+    static uint64_t Hash( const char* s );
+    static uint64_t Digest( const std::vector<std::string>& names );
+
+    static SNameIndex* Create( const std::vector<std::string>& names );
+    static SNameIndex* Load(   const std::vector<std::string>& names, const char* dir, const char* stem );
+    static SNameIndex* Load(   const std::vector<std::string>& names, const NPFold* fold );
+
+    const std::vector<std::string>& name ;
+    uint64_t digest ;
+
+    std::vector<int>      table ;      // (nslot, 2) first_idx, count
+    std::vector<int>      order ;      // name indices sorted by (name, idx)
+    std::vector<unsigned> tri_key ;    // sorted trigrams
+    std::vector<int>      tri_off ;    // tri_key.size()+1 offsets into tri_post
+    std::vector<int>      tri_post ;   // name indices containing each trigram, ascending
+    std::vector<std::vector<int>> rmq ; // sparse table : rmq[k][i] is min of order[i:i+2^k]
+
+    SNameIndex( const std::vector<std::string>& names );
+
+    void init();
+    void init_table();
+    void init_order();
+    void init_trigram();
+    void init_rmq();
+
+    unsigned getNumName() const ;
+    bool     is_valid() const ;
+    bool     is_current() const ;
+
+    int  exact(  const char* q, unsigned& count ) const ;
+    void start_range( const char* q, int& lo, int& hi ) const ;
+    int  start(  const char* q, unsigned& count ) const ;
+    int  range_min( int lo, int hi ) const ;
+    void contain_candidates( std::vector<int>& cand, const char* q ) const ;
+    int  contain( const char* q, unsigned& count ) const ;
+
+    int  find( const char* q, unsigned& count, char qt ) const ;
+    void find_all( std::vector<unsigned>& idxs, const char* q, char qt ) const ;
+
+    NPFold* serialize() const ;
+    bool    import( const NPFold* fold );
+    void    save( const char* dir, const char* stem ) const ;
+
+    std::string desc() const ;
+};
+
+
+/**
+SNameIndex::Hash
+------------------
+
+FNV-1a 64 bit
+
+**/
+
+inline uint64_t SNameIndex::Hash( const char* s ) // static
+{
+    uint64_t h = 0xcbf29ce484222325ull ;
+    for(const unsigned char* p = (const unsigned char*)s ; *p ; p++)
+    {
+        h ^= *p ;
+        h *= 0x100000001b3ull ;
+    }
+    return h ;
+}
+
+inline uint64_t SNameIndex::Digest( const std::vector<std::string>& names ) // static
+{
+    uint64_t h = 0xcbf29ce484222325ull ;
+    for(unsigned i=0 ; i < names.size() ; i++)
+    {
+        const std::string& n = names[i] ;
+        for(unsigned j=0 ; j <= n.size() ; j++)  // include terminator as separator
+        {
+            h ^= (unsigned char)n.c_str()[j] ;
+            h *= 0x100000001b3ull ;
+        }
+    }
+    return h ;
+}
+
+inline SNameIndex* SNameIndex::Create( const std::vector<std::string>& names ) // static
+{
+    SNameIndex* idx = new SNameIndex(names) ;
+    idx->init();
+    return idx ;
+}
+
+/**
+SNameIndex::Load
+------------------
+
+Loads the persisted index from *dir/stem_index*, when that does not exist
+or does not match the *names* the index is built instead.
+
+**/
+
+inline SNameIndex* SNameIndex::Load( const std::vector<std::string>& names, const char* dir, const char* stem ) // static
+{
+    std::string rel = std::string(stem) + "_index" ;
+    NPFold* fold = dir ? NPFold::LoadIfExists( (std::string(dir) + "/" + rel).c_str() ) : nullptr ;
+    return Load( names, fold );
+}
+
+/**
+SNameIndex::Load
+------------------
+
+From an already loaded fold, eg from sbundle::fold, builds the
+index when fold is nullptr or does not match the names.
+
+**/
+
+inline SNameIndex* SNameIndex::Load( const std::vector<std::string>& names, const NPFold* fold ) // static
+{
+    SNameIndex* idx = new SNameIndex(names) ;
+    bool loaded = fold && idx->import(fold) ;
+    if(!loaded) idx->init() ;
+    return idx ;
+}
+
+
+inline SNameIndex::SNameIndex( const std::vector<std::string>& names )
+    :
+    name(names),
+    digest(0)
+{
+}
+
+inline void SNameIndex::init()
+{
+    digest = Digest(name) ;
+    init_table();
+    init_order();
+    init_trigram();
+    init_rmq();
+}
+
+/**
+SNameIndex::init_table
+------------------------
+
+Linear probing with at least twice the number of names slots.
+As names are visited in index order the first_idx of duplicates
+is the lowest index.
+
+**/
+
+inline void SNameIndex::init_table()
+{
+    unsigned num_name = name.size() ;
+    unsigned nslot = 16 ;
+    while( nslot < 2*num_name ) nslot <<= 1 ;
+    table.assign( 2*nslot, int(EMPTY) );   // int() avoids odr-use with c++14
+
+    for(unsigned i=0 ; i < num_name ; i++)
+    {
+        const char* n = name[i].c_str() ;
+        unsigned s = Hash(n) & (nslot - 1) ;
+        while( table[2*s+0] != EMPTY && name[table[2*s+0]] != n ) s = (s + 1) & (nslot - 1) ;
+
+        if( table[2*s+0] == EMPTY )
+        {
+            table[2*s+0] = i ;
+            table[2*s+1] = 1 ;
+        }
+        else
+        {
+            table[2*s+1] += 1 ;
+        }
+    }
+}
+
+inline void SNameIndex::init_order()
+{
+    unsigned num_name = name.size() ;
+    order.resize(num_name);
+    for(unsigned i=0 ; i < num_name ; i++) order[i] = i ;
+    const std::vector<std::string>& n = name ;
+    std::sort( order.begin(), order.end(), [&n](int a, int b){ int c = n[a].compare(n[b]) ; return c < 0 || ( c == 0 && a < b ) ; } );
+}
+
+/**
+SNameIndex::init_trigram
+--------------------------
+
+Collects (trigram, idx) pairs, de-duplicating trigrams repeated within
+a name, then sorts to form the posting lists.
+
+**/
+
+inline void SNameIndex::init_trigram()
+{
+    unsigned num_name = name.size() ;
+    std::vector<uint64_t> pairs ;
+    std::vector<unsigned> tri ;
+
+    for(unsigned i=0 ; i < num_name ; i++)
+    {
+        const unsigned char* s = (const unsigned char*)name[i].c_str() ;
+        unsigned ns = name[i].size() ;
+        tri.clear();
+        for(unsigned j=0 ; j + 2 < ns ; j++) tri.push_back( (s[j] << 16) | (s[j+1] << 8) | s[j+2] ) ;
+        std::sort( tri.begin(), tri.end() );
+        tri.erase( std::unique( tri.begin(), tri.end() ), tri.end() );
+        for(unsigned j=0 ; j < tri.size() ; j++) pairs.push_back( ( uint64_t(tri[j]) << 32 ) | i ) ;
+    }
+    std::sort( pairs.begin(), pairs.end() );
+
+    tri_key.clear();
+    tri_off.clear();
+    tri_post.resize( pairs.size() );
+
+    for(unsigned p=0 ; p < pairs.size() ; p++)
+    {
+        unsigned key = pairs[p] >> 32 ;
+        if( tri_key.empty() || tri_key.back() != key )
+        {
+            tri_key.push_back(key);
+            tri_off.push_back(p);
+        }
+        tri_post[p] = pairs[p] & 0xffffffffu ;
+    }
+    tri_off.push_back( pairs.size() );
+}
+
+inline void SNameIndex::init_rmq()
+{
+    unsigned num_name = order.size() ;
+    rmq.clear();
+    rmq.push_back(order);
+    for(unsigned k=1 ; (1u << k) <= num_name ; k++)
+    {
+        const std::vector<int>& prev = rmq[k-1] ;
+        unsigned half = 1u << (k-1) ;
+        std::vector<int> cur( num_name - (1u << k) + 1 ) ;
+        for(unsigned i=0 ; i < cur.size() ; i++) cur[i] = std::min( prev[i], prev[i+half] ) ;
+        rmq.push_back(cur);
+    }
+}
+
+inline unsigned SNameIndex::getNumName() const
+{
+    return name.size() ;
+}
+
+inline bool SNameIndex::is_valid() const
+{
+    return order.size() == name.size() && digest == Digest(name) ;
+}
+
+inline bool SNameIndex::is_current() const
+{
+    return order.size() == name.size() ;
+}
+
+inline int SNameIndex::exact( const char* q, unsigned& count ) const
+{
+    count = 0 ;
+    if( q == nullptr || table.empty() ) return EMPTY ;
+    unsigned nslot = table.size()/2 ;
+    unsigned s = Hash(q) & (nslot - 1) ;
+    while( table[2*s+0] != EMPTY )
+    {
+        if( name[table[2*s+0]] == q )
+        {
+            count = table[2*s+1] ;
+            return table[2*s+0] ;
+        }
+        s = (s + 1) & (nslot - 1) ;
+    }
+    return EMPTY ;
+}
+
+/**
+SNameIndex::start_range
+-------------------------
+
+Range [lo,hi) of *order* with names starting with *q*
+
+**/
+
+inline void SNameIndex::start_range( const char* q, int& lo, int& hi ) const
+{
+    size_t nq = strlen(q) ;
+    const std::vector<std::string>& n = name ;
+
+    std::vector<int>::const_iterator b = std::lower_bound( order.begin(), order.end(), q,
+          [&n,nq](int a, const char* _q){ return strncmp( n[a].c_str(), _q, nq ) < 0 ; } );
+
+    std::vector<int>::const_iterator e = std::upper_bound( b, order.end(), q,
+          [&n,nq](const char* _q, int a){ return strncmp( _q, n[a].c_str(), nq ) < 0 ; } );
+
+    lo = b - order.begin() ;
+    hi = e - order.begin() ;
+}
+
+inline int SNameIndex::range_min( int lo, int hi ) const
+{
+    if( hi <= lo ) return EMPTY ;
+    unsigned len = hi - lo ;
+    unsigned k = 0 ;
+    while( (2u << k) <= len ) k++ ;
+    return std::min( rmq[k][lo], rmq[k][hi - (1 << k)] ) ;
+}
+
+inline int SNameIndex::start( const char* q, unsigned& count ) const
+{
+    count = 0 ;
+    if( q == nullptr ) return EMPTY ;
+    int lo, hi ;
+    start_range(q, lo, hi);
+    count = hi - lo ;
+    return range_min(lo, hi) ;
+}
+
+/**
+SNameIndex::contain_candidates
+--------------------------------
+
+Ascending name indices having all trigrams of *q*, starting from the
+shortest posting list. For queries shorter than a trigram all indices.
+
+**/
+
+inline void SNameIndex::contain_candidates( std::vector<int>& cand, const char* q ) const
+{
+    cand.clear();
+    const unsigned char* s = (const unsigned char*)q ;
+    size_t nq = strlen(q) ;
+    if( nq < 3 )
+    {
+        for(unsigned i=0 ; i < name.size() ; i++) cand.push_back(i) ;
+        return ;
+    }
+
+    std::vector<std::pair<int,int>> lists ;  // (off, num)
+    for(size_t j=0 ; j + 2 < nq ; j++)
+    {
+        unsigned key = (s[j] << 16) | (s[j+1] << 8) | s[j+2] ;
+        std::vector<unsigned>::const_iterator it = std::lower_bound( tri_key.begin(), tri_key.end(), key );
+        if( it == tri_key.end() || *it != key ) return ;   // a trigram without names : no match
+        int k = it - tri_key.begin() ;
+        lists.push_back( std::make_pair( tri_off[k], tri_off[k+1] - tri_off[k] ) );
+    }
+    std::sort( lists.begin(), lists.end(), [](const std::pair<int,int>& a, const std::pair<int,int>& b){ return a.second < b.second ; } );
+
+    cand.assign( tri_post.begin() + lists[0].first, tri_post.begin() + lists[0].first + lists[0].second );
+    std::vector<int> tmp ;
+    for(unsigned l=1 ; l < lists.size() && !cand.empty() ; l++)
+    {
+        std::vector<int>::const_iterator b = tri_post.begin() + lists[l].first ;
+        tmp.clear();
+        std::set_intersection( cand.begin(), cand.end(), b, b + lists[l].second, std::back_inserter(tmp) );
+        cand.swap(tmp);
+    }
+}
+
+inline int SNameIndex::contain( const char* q, unsigned& count ) const
+{
+    count = 0 ;
+    if( q == nullptr ) return EMPTY ;
+    std::vector<int> cand ;
+    contain_candidates(cand, q);
+    int first = EMPTY ;
+    for(unsigned i=0 ; i < cand.size() ; i++)
+    {
+        if( strstr( name[cand[i]].c_str(), q ) == nullptr ) continue ;
+        if( count == 0 ) first = cand[i] ;
+        count += 1 ;
+    }
+    return first ;
+}
+
+/**
+SNameIndex::find
+------------------
+
+*qt* as SName::QType 'E':exact 'S':start 'C':contain,
+returns the lowest matching index or -1 with *count* of matches.
+
+**/
+
+inline int SNameIndex::find( const char* q, unsigned& count, char qt ) const
+{
+    int idx = EMPTY ;
+    switch(qt)
+    {
+        case 'S': idx = start(q, count)   ; break ;
+        case 'C': idx = contain(q, count) ; break ;
+        default:  idx = exact(q, count)   ; break ;
+    }
+    return idx ;
+}
+
+/**
+SNameIndex::find_all
+----------------------
+
+All matching indices in ascending order, as the SName::findIndices scan.
+
+**/
+
+inline void SNameIndex::find_all( std::vector<unsigned>& idxs, const char* q, char qt ) const
+{
+    if( q == nullptr ) return ;
+    size_t i0 = idxs.size() ;
+    if( qt == 'S' )
+    {
+        int lo, hi ;
+        start_range(q, lo, hi);
+        for(int i=lo ; i < hi ; i++) idxs.push_back(order[i]) ;
+    }
+    else if( qt == 'C' )
+    {
+        std::vector<int> cand ;
+        contain_candidates(cand, q);
+        for(unsigned i=0 ; i < cand.size() ; i++) if(strstr( name[cand[i]].c_str(), q )) idxs.push_back(cand[i]) ;
+    }
+    else
+    {
+        int lo, hi ;
+        start_range(q, lo, hi);
+        for(int i=lo ; i < hi ; i++) if( name[order[i]] == q ) idxs.push_back(order[i]) ;
+    }
+    std::sort( idxs.begin() + i0, idxs.end() );
+}
+
+inline NPFold* SNameIndex::serialize() const
+{
+    NP* _table = NP::Make<int>( table.size()/2, 2 ) ;
+    NP* _order = NP::Make<int>( order.size() ) ;
+    NP* _tri_key = NP::Make<unsigned>( tri_key.size() ) ;
+    NP* _tri_off = NP::Make<int>( tri_off.size() ) ;
+    NP* _tri_post = NP::Make<int>( tri_post.size() ) ;
+
+    if(!table.empty())    memcpy( _table->bytes(),    table.data(),    sizeof(int)*table.size() );
+    if(!order.empty())    memcpy( _order->bytes(),    order.data(),    sizeof(int)*order.size() );
+    if(!tri_key.empty())  memcpy( _tri_key->bytes(),  tri_key.data(),  sizeof(unsigned)*tri_key.size() );
+    if(!tri_off.empty())  memcpy( _tri_off->bytes(),  tri_off.data(),  sizeof(int)*tri_off.size() );
+    if(!tri_post.empty()) memcpy( _tri_post->bytes(), tri_post.data(), sizeof(int)*tri_post.size() );
+
+    _order->set_meta<int>("num_name", int(name.size()) );
+    _order->set_meta<std::string>("digest", std::to_string(digest) );
+
+    NPFold* fold = new NPFold ;
+    fold->add("table", _table );
+    fold->add("order", _order );
+    fold->add("tri_key", _tri_key );
+    fold->add("tri_off", _tri_off );
+    fold->add("tri_post", _tri_post );
+    return fold ;
+}
+
+/**
+SNameIndex::import
+--------------------
+
+Returns false when the fold is incomplete or was created for different names.
+
+**/
+
+inline bool SNameIndex::import( const NPFold* fold )
+{
+    const NP* _table = fold->get("table") ;
+    const NP* _order = fold->get("order") ;
+    const NP* _tri_key = fold->get("tri_key") ;
+    const NP* _tri_off = fold->get("tri_off") ;
+    const NP* _tri_post = fold->get("tri_post") ;
+    if(!_table || !_order || !_tri_key || !_tri_off || !_tri_post ) return false ;
+
+    int num_name = _order->get_meta<int>("num_name", -1) ;
+    std::string _digest = _order->get_meta<std::string>("digest", "") ;
+    if( num_name != int(name.size()) ) return false ;
+
+    digest = Digest(name) ;
+    if( _digest != std::to_string(digest) ) return false ;
+
+    table.assign(    _table->cvalues<int>(),         _table->cvalues<int>() + _table->num_values() );
+    order.assign(    _order->cvalues<int>(),         _order->cvalues<int>() + _order->num_values() );
+    tri_key.assign(  _tri_key->cvalues<unsigned>(),  _tri_key->cvalues<unsigned>() + _tri_key->num_values() );
+    tri_off.assign(  _tri_off->cvalues<int>(),       _tri_off->cvalues<int>() + _tri_off->num_values() );
+    tri_post.assign( _tri_post->cvalues<int>(),      _tri_post->cvalues<int>() + _tri_post->num_values() );
+    init_rmq();
+    return true ;
+}
+
+inline void SNameIndex::save( const char* dir, const char* stem ) const
+{
+    std::string rel = std::string(stem) + "_index" ;
+    NPFold* fold = serialize();
+    fold->save( dir, rel.c_str() );
+    delete fold ;
+}
+
+inline std::string SNameIndex::desc() const
+{
+    std::stringstream ss ;
+    ss << "SNameIndex::desc"
+       << " num_name " << name.size()
+       << " nslot " << table.size()/2
+       << " num_trigram " << tri_key.size()
+       << " num_posting " << tri_post.size()
+       << " rmq_levels " << rmq.size()
+       << " valid " << ( is_valid() ? "YES" : "NO " )
+       ;
+    std::string str = ss.str();
+    return str ;
+}
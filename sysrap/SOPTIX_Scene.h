@@ -116,12 +116,13 @@ inline void SOPTIX_Scene::init()
 inline void SOPTIX_Scene::init_GAS()
 {
     int num_mg = scene->meshgroup.size() ;
-    if(level>0) std::cout << "[SOPTIX_Scene::init_GAS num_mg " << num_mg << std::endl ;
+    int lod = scene->getRenderLOD() ;
+    if(level>0) std::cout << "[SOPTIX_Scene::init_GAS num_mg " << num_mg << " lod " << lod << std::endl ;
 
     for(int i=0 ; i < num_mg ; i++)
     {
         if(level>0) std::cout << "-[SOPTIX_Scene::init_GAS i " << i << std::endl ;
-        const SMeshGroup*  mg = scene->meshgroup[i];
+        const SMeshGroup*  mg = scene->getMeshGroup(i, lod);
         SOPTIX_MeshGroup* xmg = SOPTIX_MeshGroup::Create(mg) ;
         meshgroup.push_back(xmg);
 
@@ -86,6 +86,7 @@ Related developments
 #include "sproc.h"
 #include "spath.h"
 #include "s_pmt.h"
+#include "SPropInterp.h"
 
 #ifdef WITH_CUSTOM4
 #include "C4MultiLayrStack.h"
@@ -224,6 +225,7 @@ struct SPMT
 
     void init_lcqs();
     void init_s_qescale();
+    void init_interp();
 
     static int TranslateCat(int lpmtcat);
 
@@ -248,9 +250,11 @@ struct SPMT
     float get_minus_cos_theta_linear_cosine(int k, int nk ) const ;
 
     float get_rindex(int cat, int layr, int prop, float energy_eV) const ;
+    void  get_rindex_many(float* ri, const float* energy_eV, int num, int cat, int layr, int prop) const ;
     NP* get_rindex() const ;
 
     float get_qeshape(int cat, float energy_eV) const ;
+    void  get_qeshape_many(float* qe, const float* energy_eV, int num, int cat) const ;
     float get_s_qeshape(int cat, float energy_eV) const ;
     NP* get_qeshape() const ;
     NP* get_s_qeshape() const ;
@@ -382,6 +386,10 @@ struct SPMT
     NP* s_qescale ;  // (NUM_SPMT, 1)
     float* s_qescale_v ;
 
+    SPropInterp<float>* rindex_interp ;    // bin indexed lookups, bitwise identical to NP::combined_interp_5
+    SPropInterp<float>* qeshape_interp ;   // and NP::combined_interp_3
+    SPropInterp<float>* s_qeshape_interp ;
+
 };
 
 
@@ -455,7 +463,10 @@ inline SPMT::SPMT(const NPFold* jpmt_)
     qeScale_v( qeScale ? qeScale->cvalues<double>() : nullptr ),
     s_qeshape(nullptr),
     s_qescale(NP::Make<float>(s_pmt::NUM_SPMT,1)),
-    s_qescale_v( s_qescale ? s_qescale->values<float>() : nullptr )
+    s_qescale_v( s_qescale ? s_qescale->values<float>() : nullptr ),
+    rindex_interp(nullptr),
+    qeshape_interp(nullptr),
+    s_qeshape_interp(nullptr)
 {
     init();
 }
@@ -508,6 +519,7 @@ inline void SPMT::init()
 
     init_lcqs();
     init_s_qescale();
+    init_interp();
 }
 
 
@@ -1020,6 +1032,25 @@ inline void SPMT::init_s_qescale()
 }
 
 
+/**
+SPMT::init_interp
+-------------------
+
+Precomputes the per-property bin index of SPropInterp.h for the
+rindex and qeshape tables, so the host lookups get_rindex, get_qeshape
+and their batched forms avoid the binary search of each
+NP::combined_interp call, giving identical values.
+
+**/
+
+inline void SPMT::init_interp()
+{
+    rindex_interp    = rindex    ? new SPropInterp<float>(rindex)    : nullptr ;
+    qeshape_interp   = qeshape   ? new SPropInterp<float>(qeshape)   : nullptr ;
+    s_qeshape_interp = s_qeshape ? new SPropInterp<float>(s_qeshape) : nullptr ;
+}
+
+
 
 
 
@@ -1199,7 +1230,23 @@ inline float SPMT::get_rindex(int cat, int layr, int prop, float energy_eV) cons
     assert( cat == 0 || cat == 1 || cat == 2 );
     assert( layr == 0 || layr == 1 || layr == 2 || layr == 3 );
     assert( prop == 0 || prop == 1 );
-    return rindex->combined_interp_5( cat, layr, prop,  energy_eV ) ;
+    int iprop = (cat*NUM_LAYER + layr)*NUM_PROP + prop ;
+    return rindex_interp ? rindex_interp->interpolate( iprop, energy_eV ) : rindex->combined_interp_5( cat, layr, prop,  energy_eV ) ;
+}
+
+/**
+SPMT::get_rindex_many
+-----------------------
+
+Batched form of get_rindex for many energies of one (cat,layr,prop)
+
+**/
+
+inline void SPMT::get_rindex_many(float* ri, const float* energy_eV, int num, int cat, int layr, int prop) const
+{
+    assert( rindex_interp );
+    int iprop = (cat*NUM_LAYER + layr)*NUM_PROP + prop ;
+    rindex_interp->interpolate_many( ri, energy_eV, num, iprop );
 }
 
 inline NP* SPMT::get_rindex() const
@@ -1215,16 +1262,21 @@ inline NP* SPMT::get_rindex() const
     NP* a = NP::Make<float>(ni,nj,nk,nl,nn) ;
     float* aa = a->values<float>();
 
+    std::vector<float> en(nl) ;
+    std::vector<float> ri(nl) ;
+    for(int l=0 ; l < nl ; l++) en[l] = get_energy(l, nl );
+
     for(int i=0 ; i < ni ; i++)
     for(int j=0 ; j < nj ; j++)
     for(int k=0 ; k < nk ; k++)
-    for(int l=0 ; l < nl ; l++)
     {
-        float en = get_energy(l, nl );
-        float ri = get_rindex(i, j, k, en) ;
-        int idx = i*nj*nk*nl*nn+j*nk*nl*nn+k*nl*nn+l*nn ;
-        aa[idx+0] = en ;
-        aa[idx+1] = ri ;
+        get_rindex_many( ri.data(), en.data(), nl, i, j, k );
+        for(int l=0 ; l < nl ; l++)
+        {
+            int idx = i*nj*nk*nl*nn+j*nk*nl*nn+k*nl*nn+l*nn ;
+            aa[idx+0] = en[l] ;
+            aa[idx+1] = ri[l] ;
+        }
     }
     return a ;
 }
@@ -1233,13 +1285,20 @@ inline NP* SPMT::get_rindex() const
 inline float SPMT::get_qeshape(int cat, float energy_eV) const
 {
     assert( cat == 0 || cat == 1 || cat == 2 );
-    return qeshape->combined_interp_3( cat, energy_eV ) ;
+    return qeshape_interp ? qeshape_interp->interpolate( cat, energy_eV ) : qeshape->combined_interp_3( cat, energy_eV ) ;
+}
+
+inline void SPMT::get_qeshape_many(float* qe, const float* energy_eV, int num, int cat) const
+{
+    assert( cat == 0 || cat == 1 || cat == 2 );
+    assert( qeshape_interp );
+    qeshape_interp->interpolate_many( qe, energy_eV, num, cat );
 }
 
 inline float SPMT::get_s_qeshape(int cat, float energy_eV) const
 {
     assert( cat == 0  );
-    return s_qeshape->combined_interp_3( cat, energy_eV ) ;
+    return s_qeshape_interp ? s_qeshape_interp->interpolate( cat, energy_eV ) : s_qeshape->combined_interp_3( cat, energy_eV ) ;
 }
 
 
@@ -1257,14 +1316,19 @@ inline NP* SPMT::get_qeshape() const
     NP* a = NP::Make<float>(ni,nj,nk) ;
     float* aa = a->values<float>();
 
+    std::vector<float> en(nj) ;
+    std::vector<float> qe(nj) ;
+    for(int j=0 ; j < nj ; j++) en[j] = get_energy(j, nj );
+
     for(int i=0 ; i < ni ; i++)
-    for(int j=0 ; j < nj ; j++)
     {
-        float en = get_energy(j, nj );
-        float qe = get_qeshape(i, en) ;
-        int idx = i*nj*nk+j*nk ;
-        aa[idx+0] = en ;
-        aa[idx+1] = qe ;
+        get_qeshape_many( qe.data(), en.data(), nj, i );
+        for(int j=0 ; j < nj ; j++)
+        {
+            int idx = i*nj*nk+j*nk ;
+            aa[idx+0] = en[j] ;
+            aa[idx+1] = qe[j] ;
+        }
     }
     return a ;
 }
@@ -1951,7 +2015,7 @@ inline NP* SPMT::get_s_qescale_from_spmtid() const
 inline float SPMT::get_pmtcat_qe(int cat, float energy_eV) const
 {
     assert( cat == 0 || cat == 1 || cat == 2 );
-    return qeshape->combined_interp_3( cat, energy_eV ) ;
+    return qeshape_interp ? qeshape_interp->interpolate( cat, energy_eV ) : qeshape->combined_interp_3( cat, energy_eV ) ;
 }
 inline NP* SPMT::get_pmtcat_qe() const
 {
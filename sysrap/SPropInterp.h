@@ -0,0 +1,471 @@
+#pragma once
+/**
+SPropInterp.h : batched host interpolation of NP::Combine property arrays
+===========================================================================
+
+qprop::interpolate and NP::_combined_interp binary search the domain
+of a single property for every lookup. On the host that is mostly
+branch mispredictions and dependent loads, and lookups such as
+QProp::lookup (MOCK_CURAND) or material/PMT table scans repeat it for
+every (prop, x) pair.
+
+SPropInterp precomputes a per-property bin index at construction:
+
+UNIFORM
+    domain spacing is uniform (to a relative tolerance), so the bin
+    is computed directly from (x-x0)*inv_dx with no search
+
+BUCKET
+    non-uniform but non-decreasing domain, the [x0,x1] range is divided
+    into BUCKET_PER_ITEM*ni equal buckets each recording the bin at its
+    start, so a lookup is one table read plus a short walk
+
+SEARCH
+    non-monotonic domain, falls back to the binary search
+
+The first guess of UNIFORM and BUCKET is followed by a fix-up walk to
+the unique bin lo with dom[lo] <= x < dom[lo+1], which is also the bin
+reached by the binary search. As the interpolation expression is
+unchanged results are bitwise identical to NP::_combined_interp
+and qprop::interpolate, see SPropInterp::reference.
+
+Batch API
+-----------
+
+interpolate_many
+    many x against one property : processed in blocks of BLOCK, the
+    bin guess for the block is simple arithmetic over contiguous arrays
+    that the compiler auto-vectorizes, the fix-up and gather is scalar
+
+interpolate_props
+    one x against many properties, eg all materials at one wavelength
+
+lookup
+    (num_prop, nx) table as QProp::lookup
+
+Layout
+--------
+
+Property arrays are as created by NP::Combine : each property row has
+*stride* values holding (dom,val) items of *nj* values with the item
+count encoded into the last value of the row.
+
+::
+
+    ~/o/sysrap/tests/SPropInterp_test.sh
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+#include "NP.hh"
+
+template<typename T>
+struct SPropInterp
+{
+    enum { UNIFORM, BUCKET, SEARCH } ;
+
+    static constexpr const int BLOCK = 64 ;
+    static constexpr const int BUCKET_PER_ITEM = 2 ;
+
+    struct Index
+    {
+        int mode ;
+        int ni ;       // number of (dom,val) items
+        int b0 ;       // offset into bucket table
+        int nb ;       // number of buckets
+        T   x0 ;
+        T   x1 ;
+        T   scale ;    // 1/dx for UNIFORM, nb/(x1-x0) for BUCKET
+    };
+
+    const T* pp ;
+    int height ;       // number of properties
+    int stride ;       // values per property row
+    int nj ;           // values per item, normally 2 (dom,val)
+    T   tolerance ;    // relative tolerance for UNIFORM detection
+
+    std::vector<Index> index ;
+    std::vector<int>   bucket ;
+
+    static const char* Mode(int mode);
+
+    SPropInterp(const NP* a, T tolerance=1e-6 );
+    SPropInterp(const T* pp, int height, int stride, int nj=2, T tolerance=1e-6 );
+
+    void init();
+    void init_index(int iprop);
+
+    const T* row(int iprop) const ;
+    int  num_items(int iprop) const ;
+
+    T    reference(int iprop, T x) const ;
+    int  bin(const Index& ix, const T* vv, T x) const ;
+    T    interpolate(int iprop, T x) const ;
+
+    void interpolate_many(T* y, const T* x, int nx, int iprop) const ;
+    void interpolate_props(T* y, T x, const int* iprops, int nprop) const ;
+    void lookup(T* y, const T* x, int nx, int nprop) const ;
+    NP*  lookup(const NP* x) const ;
+
+    int  count(int mode) const ;
+    std::string desc() const ;
+};
+
+
+template<typename T>
+inline const char* SPropInterp<T>::Mode(int mode) // static
+{
+    const char* s = nullptr ;
+    switch(mode)
+    {
+        case UNIFORM: s = "UNIFORM" ; break ;
+        case BUCKET:  s = "BUCKET"  ; break ;
+        case SEARCH:  s = "SEARCH"  ; break ;
+    }
+    return s ;
+}
+
+/**
+SPropInterp::SPropInterp
+--------------------------
+
+The NP ctor accepts combined arrays of any dimensionality >= 3,
+eg (num_prop, 1+max_item, 2) from NP::Combine or the 5D PMT
+rindex arrays used by SPMT. The leading dimensions are flattened
+into *height* in the same way as NP::combined_interp_5 forms iprop.
+The array must outlive this instance.
+
+**/
+
+template<typename T>
+inline SPropInterp<T>::SPropInterp(const NP* a, T tolerance_ )
+    :
+    pp(a->cvalues<T>()),
+    height(0),
+    stride(0),
+    nj(0),
+    tolerance(tolerance_)
+{
+    int ndim = a->shape.size() ;
+    assert( ndim >= 3 );
+    assert( a->ebyte == sizeof(T) );
+    nj = a->shape[ndim-1] ;
+    stride = a->shape[ndim-2]*nj ;
+    height = 1 ;
+    for(int d=0 ; d < ndim-2 ; d++) height *= a->shape[d] ;
+    init();
+}
+
+template<typename T>
+inline SPropInterp<T>::SPropInterp(const T* pp_, int height_, int stride_, int nj_, T tolerance_ )
+    :
+    pp(pp_),
+    height(height_),
+    stride(stride_),
+    nj(nj_),
+    tolerance(tolerance_)
+{
+    init();
+}
+
+template<typename T>
+inline void SPropInterp<T>::init()
+{
+    index.resize(height);
+    for(int i=0 ; i < height ; i++) init_index(i);
+}
+
+template<typename T>
+inline const T* SPropInterp<T>::row(int iprop) const
+{
+    return pp + stride*iprop ;
+}
+
+template<typename T>
+inline int SPropInterp<T>::num_items(int iprop) const
+{
+    return nview::int_from<T>( *(row(iprop)+stride-1) ) ;
+}
+
+/**
+SPropInterp::init_index
+-------------------------
+
+UNIFORM requires every domain value within tolerance*(x1-x0)
+of x0 + i*dx. BUCKET entries hold the last bin whose domain
+start is not beyond the bucket start.
+
+**/
+
+template<typename T>
+inline void SPropInterp<T>::init_index(int iprop)
+{
+    const T* vv = row(iprop) ;
+    Index& ix = index[iprop] ;
+    ix.ni = num_items(iprop) ;
+    assert( ix.ni >= 1 && ix.ni*nj <= stride );
+    ix.b0 = bucket.size() ;
+    ix.nb = 0 ;
+    ix.x0 = vv[0] ;
+    ix.x1 = vv[nj*(ix.ni-1)] ;
+    ix.scale = 0 ;
+    ix.mode = SEARCH ;
+
+    if( ix.ni < 2 || !(ix.x1 > ix.x0) ) return ;
+
+    bool monotonic = true ;
+    for(int i=1 ; i < ix.ni ; i++) if( vv[nj*i] < vv[nj*(i-1)] ) monotonic = false ;
+    if(!monotonic) return ;
+
+    double range = double(ix.x1) - double(ix.x0) ;
+    double dx = range/double(ix.ni-1) ;
+    bool uniform = true ;
+    for(int i=0 ; i < ix.ni && uniform ; i++)
+    {
+        double expect = double(ix.x0) + double(i)*dx ;
+        if( std::abs( double(vv[nj*i]) - expect ) > double(tolerance)*range ) uniform = false ;
+    }
+
+    if( uniform )
+    {
+        ix.mode = UNIFORM ;
+        ix.scale = T(1./dx) ;
+        return ;
+    }
+
+    ix.mode = BUCKET ;
+    ix.nb = BUCKET_PER_ITEM*ix.ni ;
+    ix.scale = T(double(ix.nb)/range) ;
+
+    int lo = 0 ;
+    for(int b=0 ; b < ix.nb ; b++)
+    {
+        T xb = ix.x0 + T(double(b)*range/double(ix.nb)) ;
+        while( lo < ix.ni-2 && vv[nj*(lo+1)] <= xb ) lo++ ;
+        bucket.push_back(lo);
+    }
+}
+
+/**
+SPropInterp::reference
+------------------------
+
+Binary search interpolation identical to NP::_combined_interp,
+for comparison and as the SEARCH fallback.
+
+**/
+
+template<typename T>
+inline T SPropInterp<T>::reference(int iprop, T x) const
+{
+    const T* vv = row(iprop) ;
+    int ni = num_items(iprop) ;
+    int jdom = 0 ;
+    int jval = nj - 1 ;
+
+    int lo = 0 ;
+    int hi = ni-1 ;
+
+    if( x <= vv[nj*lo+jdom] ) return vv[nj*lo+jval] ;
+    if( x >= vv[nj*hi+jdom] ) return vv[nj*hi+jval] ;
+
+    while (lo < hi-1)
+    {
+        int mi = (lo+hi)/2;
+        if (x < vv[nj*mi+jdom]) hi = mi ;
+        else lo = mi;
+    }
+
+    T dy = vv[nj*hi+jval] - vv[nj*lo+jval] ;
+    T dx = vv[nj*hi+jdom] - vv[nj*lo+jdom] ;
+    T y =  vv[nj*lo+jval] + dy*(x-vv[nj*lo+jdom])/dx ;
+    return y ;
+}
+
+/**
+SPropInterp::bin
+------------------
+
+Requires x0 < x < x1, returns lo with dom[lo] <= x < dom[lo+1]
+
+**/
+
+template<typename T>
+inline int SPropInterp<T>::bin(const Index& ix, const T* vv, T x) const
+{
+    int lo = 0 ;
+    if( ix.mode == UNIFORM )
+    {
+        lo = int( (x - ix.x0)*ix.scale ) ;
+    }
+    else if( ix.mode == BUCKET )
+    {
+        int b = std::min( ix.nb-1, std::max( 0, int( (x - ix.x0)*ix.scale ))) ;
+        lo = bucket[ix.b0+b] ;
+    }
+    else
+    {
+        int hi = ix.ni-1 ;
+        while (lo < hi-1)
+        {
+            int mi = (lo+hi)/2;
+            if (x < vv[nj*mi]) hi = mi ;
+            else lo = mi;
+        }
+        return lo ;
+    }
+    lo = std::min( ix.ni-2, std::max( 0, lo )) ;
+    while( lo > 0 && x < vv[nj*lo] ) lo-- ;
+    while( lo < ix.ni-2 && x >= vv[nj*(lo+1)] ) lo++ ;
+    return lo ;
+}
+
+template<typename T>
+inline T SPropInterp<T>::interpolate(int iprop, T x) const
+{
+    const Index& ix = index[iprop] ;
+    const T* vv = row(iprop) ;
+    int jval = nj - 1 ;
+
+    if( x <= ix.x0 ) return vv[jval] ;
+    if( x >= ix.x1 ) return vv[nj*(ix.ni-1)+jval] ;
+
+    int lo = bin(ix, vv, x) ;
+    int hi = lo + 1 ;
+
+    T dy = vv[nj*hi+jval] - vv[nj*lo+jval] ;
+    T dx = vv[nj*hi] - vv[nj*lo] ;
+    T y =  vv[nj*lo+jval] + dy*(x-vv[nj*lo])/dx ;
+    return y ;
+}
+
+/**
+SPropInterp::interpolate_many
+-------------------------------
+
+Per block: the clamped bin guess loop has no data dependent
+branches so it vectorizes, the fix-up and gather loop follows.
+
+**/
+
+template<typename T>
+inline void SPropInterp<T>::interpolate_many(T* y, const T* x, int nx, int iprop) const
+{
+    const Index& ix = index[iprop] ;
+    if( ix.mode == SEARCH )
+    {
+        for(int i=0 ; i < nx ; i++) y[i] = interpolate(iprop, x[i]) ;
+        return ;
+    }
+
+    const T* vv = row(iprop) ;
+    const int* bk = ix.mode == BUCKET ? bucket.data() + ix.b0 : nullptr ;
+    int jval = nj - 1 ;
+    int last = ix.mode == UNIFORM ? ix.ni - 2 : ix.nb - 1 ;
+    T v0 = vv[jval] ;
+    T v1 = vv[nj*(ix.ni-1)+jval] ;
+
+    int guess[BLOCK] ;
+
+    for(int i0=0 ; i0 < nx ; i0 += BLOCK)
+    {
+        int n = std::min( BLOCK, nx - i0 ) ;
+        const T* xb = x + i0 ;
+        T* yb = y + i0 ;
+
+        for(int i=0 ; i < n ; i++)
+        {
+            T f = (xb[i] - ix.x0)*ix.scale ;
+            f = f < T(0) || f != f ? T(0) : f ;
+            f = f > T(last) ? T(last) : f ;
+            guess[i] = int(f) ;
+        }
+
+        for(int i=0 ; i < n ; i++)
+        {
+            T xi = xb[i] ;
+            if( xi <= ix.x0 ) { yb[i] = v0 ; continue ; }
+            if( xi >= ix.x1 ) { yb[i] = v1 ; continue ; }
+
+            int lo = bk ? bk[guess[i]] : std::min( guess[i], ix.ni-2 ) ;
+            while( lo > 0 && xi < vv[nj*lo] ) lo-- ;
+            while( lo < ix.ni-2 && xi >= vv[nj*(lo+1)] ) lo++ ;
+            int hi = lo + 1 ;
+
+            T dy = vv[nj*hi+jval] - vv[nj*lo+jval] ;
+            T dx = vv[nj*hi] - vv[nj*lo] ;
+            yb[i] = vv[nj*lo+jval] + dy*(xi-vv[nj*lo])/dx ;
+        }
+    }
+}
+
+/**
+SPropInterp::interpolate_props
+--------------------------------
+
+When *iprops* is nullptr the properties [0,nprop) are used.
+
+**/
+
+template<typename T>
+inline void SPropInterp<T>::interpolate_props(T* y, T x, const int* iprops, int nprop) const
+{
+    for(int i=0 ; i < nprop ; i++) y[i] = interpolate( iprops ? iprops[i] : i, x ) ;
+}
+
+template<typename T>
+inline void SPropInterp<T>::lookup(T* y, const T* x, int nx, int nprop) const
+{
+    assert( nprop <= height );
+    for(int i=0 ; i < nprop ; i++) interpolate_many( y + i*nx, x, nx, i );
+}
+
+/**
+SPropInterp::lookup
+---------------------
+
+Returns (height, nx) array of all properties interpolated
+at the domain values of 1d array *x*.
+
+**/
+
+template<typename T>
+inline NP* SPropInterp<T>::lookup(const NP* x) const
+{
+    assert( x && x->shape.size() == 1 && x->ebyte == sizeof(T) );
+    int nx = x->shape[0] ;
+    NP* y = NP::Make<T>( height, nx );
+    lookup( y->values<T>(), x->cvalues<T>(), nx, height );
+    return y ;
+}
+
+template<typename T>
+inline int SPropInterp<T>::count(int mode) const
+{
+    int num = 0 ;
+    for(int i=0 ; i < height ; i++) if( index[i].mode == mode ) num += 1 ;
+    return num ;
+}
+
+template<typename T>
+inline std::string SPropInterp<T>::desc() const
+{
+    std::stringstream ss ;
+    ss << "SPropInterp::desc"
+       << " height " << height
+       << " stride " << stride
+       << " nj " << nj
+       << " " << Mode(UNIFORM) << " " << count(UNIFORM)
+       << " " << Mode(BUCKET) << " " << count(BUCKET)
+       << " " << Mode(SEARCH) << " " << count(SEARCH)
+       << " bucket " << bucket.size()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
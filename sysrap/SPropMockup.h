@@ -21,10 +21,12 @@ struct SPropMockup
 {
     static constexpr const char* DEMO_BASE = "$HOME/.opticks/GEOM/$GEOM" ;
     static constexpr const char* DEMO_RELP = "CSGFoundry/SSim/stree/material/LS/RINDEX.npy" ; 
+    static constexpr const char* MATERIAL_RELP = "CSGFoundry/SSim/stree/material" ; 
 
     static const NP* CombinationDemo(); 
     static const NP* Combination(const char* base, const char* relp ); 
     static const NP* Combination(const NP* a_ ); 
+    static const NP* MaterialCombination(const char* base=DEMO_BASE, const char* relp=MATERIAL_RELP ); 
 
     // TODO: below functionality belongs in NP.hh not here 
     static const NP* NarrowCombine(const std::vector<const NP*>& aa ); 
@@ -34,6 +36,7 @@ struct SPropMockup
 
 #include <vector>
 #include "NP.hh"
+#include "NPFold.h"
 #include "spath.h"
 
 
@@ -120,6 +123,52 @@ inline const NP* SPropMockup::Combination(const NP* a_ )
 }
 
 
+/**
+SPropMockup::MaterialCombination
+-----------------------------------
+
+Unlike the mockup this combines all the real material properties 
+of the stree material fold, eg RINDEX, ABSLENGTH, RAYLEIGH, REEMISSIONPROB 
+of every material, giving tables with realistic item counts and 
+domain spacings for benchmarking SPropInterp.h. 
+The energy domain is scaled from MeV to eV and narrowed to float. 
+Only double (N,2) properties with more than one item are included.
+
+**/
+
+inline const NP* SPropMockup::MaterialCombination(const char* base, const char* relp )  // static 
+{
+    const char* dir = spath::Resolve(base, relp); 
+    NPFold* mat = dir && NP::Exists(dir, "NPFold_index.txt") ? NPFold::Load(dir) : nullptr ;
+    if( mat == nullptr ) return nullptr ; 
+
+    std::vector<const NP*> aa ; 
+    for(int i=0 ; i < mat->get_num_subfold() ; i++)
+    {
+        const NPFold* f = mat->get_subfold(i) ; 
+        for(int j=0 ; j < f->num_items() ; j++)
+        {
+            const NP* a = f->get_array(j) ; 
+            bool prop = a && a->shape.size() == 2 && a->shape[0] > 1 && a->shape[1] == 2 && a->ebyte == 8 && a->uifc == 'f' ; 
+            if(!prop) continue ; 
+            NP* b = a->copy(); 
+            b->pscale<double>(1e6, 0u); 
+            aa.push_back(b); 
+        }
+    }
+
+    std::cout
+        << "SPropMockup::MaterialCombination"
+        << " dir " << dir 
+        << " num_subfold " << mat->get_num_subfold()
+        << " num_prop " << aa.size()
+        << std::endl 
+        ;
+
+    return aa.size() > 0 ? NarrowCombine(aa) : nullptr ; 
+}
+
+
 /**
 SPropMockup::NarrowCombine
 ------------------------------
@@ -0,0 +1,839 @@
+#pragma once
+/**
+SRaster.h : multithreaded tile based CPU rasterizer of instanced triangle meshes
+==================================================================================
+
+Renders depth buffered normal shaded images of the SScene triangulated
+geometry without OpenGL or OptiX, for headless nodes and batch production
+of geometry images. The glm/SScene/SGLM connection is in SRaster_Scene.h,
+this struct only sees raw float/int arrays so it stays usable from anywhere.
+
+Inputs
+    meshes : float vtx (num_vtx,3), float nrm (num_vtx,3), int tri (num_tri,3)
+    draws  : mesh index and optional 4x4 column major instance transform,
+             nullptr meaning identity as for the non-instanced SScene meshes
+    view   : column major world2clip matrix (SGLM::MVP) and image width, height
+
+Framing matches the SOPTIX/CSGOptiX ray traced renders, pixel (i,j)
+samples NDC (2i/width-1, 2j/height-1) with row 0 at the bottom, so the
+pixels are written with sppm::Write yflip=true exactly as the GPU pixels.
+
+Shading
+    SHADE_RT (default)
+        interpolated world frame normal, normalize(N)*0.5+0.5 and alpha
+        from the NDC depth as SOPTIX.cu render, misses are the same mid-grey
+        with alpha 0.999 as the OptiX miss with zero bg_color
+
+    SHADE_GL
+        per-vertex clamp(nrm*0.5+0.8) of the model frame normal interpolated
+        as by the SGLFW normal shaders, misses are the default
+        black transparent OpenGL clear color
+
+Algorithm
+    1. draws are frustum culled using their transformed mesh bbox, draws that
+       cover no pixel sample are also culled
+
+    2. remaining draws are split into pieces of at most PIECE triangles and
+       consecutive pieces are grouped into batches of around BATCH triangles
+       to bound the memory for triangle setup
+
+    3. within a batch the pieces are divided contiguously between the
+       sparallel.h threads, which transform vertices, clip against the near plane,
+       setup the triangles in screen space and bin them into TILE*TILE
+       pixel tiles into per-thread lists
+
+    4. the threads then take whole tiles, rasterizing every triangle binned
+       to the tile with edge functions, a top-left style fill rule (shared
+       edges are never drawn twice or missed) and a less-than depth test
+
+As tiles are visited by a single thread there is no locking of the depth
+and color buffers, and as triangles are rasterized in piece order the image
+does not depend on the number of threads.
+
+Config envvars: SRaster__NUM_THREAD SRaster__TILE SRaster__BATCH SRaster__SHADE
+
+The number of threads is num_thread when positive, otherwise SRaster__NUM_THREAD
+with 0 or unset meaning hardware_concurrency, limited via sparallel::NumThreadEnv
+such that each thread has at least sparallel::MIN_PER_THREAD triangles.
+
+**/
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <algorithm>
+#include <cassert>
+
+#include "ssys.h"
+#include "sparallel.h"
+#include "schrono.h"
+#include "sppm.h"
+#include "NP.hh"
+
+struct SRaster
+{
+    static constexpr const char* _NUM_THREAD = "SRaster__NUM_THREAD" ;
+    static constexpr const char* _TILE = "SRaster__TILE" ;
+    static constexpr const char* _BATCH = "SRaster__BATCH" ;
+    static constexpr const char* _SHADE = "SRaster__SHADE" ;
+
+    static constexpr const int PIECE = 65536 ;
+    enum { SHADE_RT, SHADE_GL } ;
+    static const char* Shade(int shade);
+    static int ShadeFromEnv();
+
+    struct Mesh
+    {
+        const float* vtx ;
+        const float* nrm ;
+        const int*   tri ;
+        int num_vtx ;
+        int num_tri ;
+        float mn[3] ;
+        float mx[3] ;
+    };
+
+    struct Draw
+    {
+        int mesh ;
+        const float* tran ;   // column major 4x4, nullptr for identity
+    };
+
+    struct Piece
+    {
+        int draw ;
+        int t0 ;
+        int t1 ;
+    };
+
+    struct Tri     // screen space setup
+    {
+        float x[3] ;
+        float y[3] ;
+        float z[3] ;    // NDC depth
+        float q[3] ;    // 1/w for perspective correct attribute interpolation
+        float a[9] ;    // per-vertex attribute : normal (SHADE_RT) or color (SHADE_GL)
+    };
+
+    struct Vert
+    {
+        float c[4] ;    // clip space
+        float a[3] ;
+        float s[4] ;    // screen x, y, NDC depth and 1/w, valid when w > 0
+        unsigned o ;    // outcode of the six clip planes
+    };
+
+    struct Worker
+    {
+        std::vector<Tri>  tri ;
+        std::vector<Vert> vert ;
+        std::vector<std::vector<uint32_t>> bin ;
+        int last_draw ;
+        uint64_t num_setup ;
+    };
+
+    int num_thread ;   // 0: SRaster__NUM_THREAD or hardware_concurrency
+    int num_worker ;   // threads used by the last render
+    int tile ;
+    int batch ;
+    int shade ;
+
+    int width ;
+    int height ;
+    int ntx ;
+    int nty ;
+    float world2clip[16] ;
+
+    std::vector<Mesh>  mesh ;
+    std::vector<Draw>  draw ;
+    std::vector<Piece> piece ;
+    std::vector<Worker> worker ;
+    std::vector<uint64_t> tile_frag ;
+
+    std::vector<float>         depth ;
+    std::vector<unsigned char> pixels ;   // RGBA, row 0 at bottom
+
+    int      num_cull ;
+    uint64_t num_tri ;      // triangles of the pieces after culling
+    uint64_t num_setup ;    // triangles binned after near clip and sample rejection
+    uint64_t num_frag ;     // fragments passing the depth test
+    double   t_bin ;
+    double   t_raster ;
+    double   t_total ;
+
+    SRaster();
+
+    void clear_geometry();
+    int  add_mesh( const float* vtx, const float* nrm, const int* tri, int num_vtx, int num_tri );
+    void add_draw( int m, const float* tran );
+    void set_view( const float* _world2clip, int _width, int _height );
+
+    static void Mul( float* r, const float* a, const float* b );          // r = a*b column major 4x4
+    static void Transform( float* c, const float* m, const float* p );    // c = m*(p,1)
+    static void NormalMatrix( float* n, const float* m );                 // cofactor of upper 3x3
+
+    bool cull( const Draw& d ) const ;
+    void render();
+    void clear_frame();
+
+    void bin_range( int t, int p0, int p1 );
+    void project( Vert& v ) const ;
+    void setup_tri( Worker& w, const Vert& v0, const Vert& v1, const Vert& v2 ) const ;
+    void raster_tile( int ti );
+    void raster_tri( const Tri& t, int x0, int y0, int x1, int y1, uint64_t& frag );
+
+    void miss_pixel( unsigned char* px ) const ;
+    void hit_pixel( unsigned char* px, const float* a, float z ) const ;
+
+    void save( const char* path ) const ;
+    NP*  get_pixels() const ;
+    std::string desc() const ;
+};
+
+
+inline const char* SRaster::Shade(int shade)
+{
+    return shade == SHADE_GL ? "GL" : "RT" ;
+}
+inline int SRaster::ShadeFromEnv()
+{
+    const char* s = ssys::getenvvar(_SHADE, "RT") ;
+    return strcmp(s, "GL") == 0 ? SHADE_GL : SHADE_RT ;
+}
+
+inline SRaster::SRaster()
+    :
+    num_thread(0),
+    num_worker(1),
+    tile(ssys::getenvint(_TILE, 32)),
+    batch(ssys::getenvint(_BATCH, 1 << 20)),
+    shade(ShadeFromEnv()),
+    width(0),
+    height(0),
+    ntx(0),
+    nty(0),
+    num_cull(0),
+    num_tri(0),
+    num_setup(0),
+    num_frag(0),
+    t_bin(0.),
+    t_raster(0.),
+    t_total(0.)
+{
+    for(int i=0 ; i < 16 ; i++) world2clip[i] = i % 5 == 0 ? 1.f : 0.f ;
+}
+
+inline void SRaster::clear_geometry()
+{
+    mesh.clear();
+    draw.clear();
+}
+
+/**
+SRaster::add_mesh
+-------------------
+
+The arrays are referenced not copied, so must outlive the render.
+
+**/
+
+inline int SRaster::add_mesh( const float* vtx, const float* nrm, const int* tri, int num_vtx, int num_tri )
+{
+    Mesh m = {} ;
+    m.vtx = vtx ;
+    m.nrm = nrm ;
+    m.tri = tri ;
+    m.num_vtx = num_vtx ;
+    m.num_tri = num_tri ;
+    for(int k=0 ; k < 3 ; k++)
+    {
+        m.mn[k] = num_vtx > 0 ?  1e30f : 0.f ;
+        m.mx[k] = num_vtx > 0 ? -1e30f : 0.f ;
+    }
+    for(int i=0 ; i < num_vtx ; i++)
+    for(int k=0 ; k < 3 ; k++)
+    {
+        m.mn[k] = std::min( m.mn[k], vtx[3*i+k] );
+        m.mx[k] = std::max( m.mx[k], vtx[3*i+k] );
+    }
+    mesh.push_back(m);
+    return int(mesh.size()) - 1 ;
+}
+
+inline void SRaster::add_draw( int m, const float* tran )
+{
+    assert( m > -1 && m < int(mesh.size()) );
+    Draw d = { m, tran } ;
+    draw.push_back(d);
+}
+
+inline void SRaster::set_view( const float* _world2clip, int _width, int _height )
+{
+    memcpy( world2clip, _world2clip, 16*sizeof(float) );
+    width = _width ;
+    height = _height ;
+    ntx = ( width + tile - 1 )/tile ;
+    nty = ( height + tile - 1 )/tile ;
+}
+
+inline void SRaster::Mul( float* r, const float* a, const float* b )
+{
+    for(int c=0 ; c < 4 ; c++)
+    for(int i=0 ; i < 4 ; i++)
+    {
+        float s = 0.f ;
+        for(int k=0 ; k < 4 ; k++) s += a[k*4+i]*b[c*4+k] ;
+        r[c*4+i] = s ;
+    }
+}
+
+inline void SRaster::Transform( float* c, const float* m, const float* p )
+{
+    for(int i=0 ; i < 4 ; i++) c[i] = m[0*4+i]*p[0] + m[1*4+i]*p[1] + m[2*4+i]*p[2] + m[3*4+i] ;
+}
+
+/**
+SRaster::NormalMatrix
+-----------------------
+
+Cofactor matrix of the upper 3x3, that is det*inverse-transpose,
+sign corrected for reflections. As normals are normalized after
+interpolation the det scaling does not matter. Result is column major 3x3.
+
+**/
+
+inline void SRaster::NormalMatrix( float* n, const float* m )
+{
+    auto e = [m](int r, int c){ return m[c*4+r] ; } ;
+    float c00 = e(1,1)*e(2,2) - e(1,2)*e(2,1) ;
+    float c01 = e(1,2)*e(2,0) - e(1,0)*e(2,2) ;
+    float c02 = e(1,0)*e(2,1) - e(1,1)*e(2,0) ;
+    float c10 = e(0,2)*e(2,1) - e(0,1)*e(2,2) ;
+    float c11 = e(0,0)*e(2,2) - e(0,2)*e(2,0) ;
+    float c12 = e(0,1)*e(2,0) - e(0,0)*e(2,1) ;
+    float c20 = e(0,1)*e(1,2) - e(0,2)*e(1,1) ;
+    float c21 = e(0,2)*e(1,0) - e(0,0)*e(1,2) ;
+    float c22 = e(0,0)*e(1,1) - e(0,1)*e(1,0) ;
+    float det = e(0,0)*c00 + e(0,1)*c01 + e(0,2)*c02 ;
+    float s = det < 0.f ? -1.f : 1.f ;
+    float r[9] = { c00, c10, c20,  c01, c11, c21,  c02, c12, c22 } ;  // column major
+    for(int i=0 ; i < 9 ; i++) n[i] = s*r[i] ;
+}
+
+/**
+SRaster::cull
+---------------
+
+True when all eight transformed bbox corners are outside one clip plane,
+or when the bbox is entirely in front of the near plane and its screen
+extent contains no pixel sample.
+
+**/
+
+inline bool SRaster::cull( const Draw& d ) const
+{
+    const Mesh& m = mesh[d.mesh] ;
+    if( m.num_tri == 0 ) return true ;
+
+    float M[16] ;
+    if( d.tran ) Mul(M, world2clip, d.tran) ; else memcpy(M, world2clip, sizeof(M)) ;
+
+    unsigned all_out = 0x3f ;
+    bool front = true ;
+    float xmin = 1e30f, xmax = -1e30f, ymin = 1e30f, ymax = -1e30f ;
+
+    for(int k=0 ; k < 8 ; k++)
+    {
+        float p[3] = { k & 1 ? m.mx[0] : m.mn[0], k & 2 ? m.mx[1] : m.mn[1], k & 4 ? m.mx[2] : m.mn[2] } ;
+        float c[4] ;
+        Transform(c, M, p);
+        unsigned out = 0 ;
+        if( c[0] < -c[3] ) out |= 0x01 ;
+        if( c[0] >  c[3] ) out |= 0x02 ;
+        if( c[1] < -c[3] ) out |= 0x04 ;
+        if( c[1] >  c[3] ) out |= 0x08 ;
+        if( c[2] < -c[3] ) out |= 0x10 ;
+        if( c[2] >  c[3] ) out |= 0x20 ;
+        all_out &= out ;
+
+        if( c[2] < -c[3] || c[3] <= 0.f ) front = false ;
+        if( front )
+        {
+            float sx = ( c[0]/c[3] + 1.f )*0.5f*float(width) ;
+            float sy = ( c[1]/c[3] + 1.f )*0.5f*float(height) ;
+            xmin = std::min(xmin, sx) ; xmax = std::max(xmax, sx) ;
+            ymin = std::min(ymin, sy) ; ymax = std::max(ymax, sy) ;
+        }
+    }
+    if( all_out ) return true ;
+    if( front && ( std::ceil(xmin) > std::floor(xmax) || std::ceil(ymin) > std::floor(ymax) )) return true ;
+    return false ;
+}
+
+inline void SRaster::clear_frame()
+{
+    size_t num_pixel = size_t(width)*size_t(height) ;
+    depth.assign( num_pixel, 1.f );
+    pixels.resize( 4*num_pixel );
+    for(size_t i=0 ; i < num_pixel ; i++) miss_pixel( pixels.data() + 4*i );
+}
+
+/**
+SRaster::render
+-----------------
+
+**/
+
+inline void SRaster::render()
+{
+    assert( width > 0 && height > 0 && tile > 0 );
+    schrono::TP t0 = schrono::stamp();
+
+    ntx = ( width + tile - 1 )/tile ;
+    nty = ( height + tile - 1 )/tile ;
+    int num_tile = ntx*nty ;
+
+    clear_frame();
+
+    num_cull = 0 ;
+    num_tri = 0 ;
+    num_setup = 0 ;
+    num_frag = 0 ;
+    t_bin = 0. ;
+    t_raster = 0. ;
+
+    piece.clear();
+    for(int i=0 ; i < int(draw.size()) ; i++)
+    {
+        if(cull(draw[i])) { num_cull += 1 ; continue ; }
+        int nt = mesh[draw[i].mesh].num_tri ;
+        for(int t0_=0 ; t0_ < nt ; t0_ += PIECE ) piece.push_back( { i, t0_, std::min(nt, t0_ + PIECE) } ) ;
+        num_tri += nt ;
+    }
+
+    num_worker = sparallel::NumThreadEnv(num_tri, _NUM_THREAD, num_thread) ;
+    worker.resize(num_worker);
+    for(int t=0 ; t < num_worker ; t++)
+    {
+        worker[t].bin.resize(num_tile) ;
+        worker[t].num_setup = 0 ;
+    }
+    tile_frag.assign(num_tile, 0) ;
+
+    int num_piece = piece.size() ;
+    int p0 = 0 ;
+    while( p0 < num_piece )
+    {
+        int p1 = p0 ;
+        uint64_t ntri = 0 ;
+        while( p1 < num_piece && ( p1 == p0 || ntri < uint64_t(batch) ))
+        {
+            ntri += piece[p1].t1 - piece[p1].t0 ;
+            p1++ ;
+        }
+
+        // contiguous division of the batch pieces between threads balanced by triangle count
+        std::vector<int> split(num_worker+1, p1) ;
+        split[0] = p0 ;
+        uint64_t acc = 0 ;
+        int t = 1 ;
+        for(int p=p0 ; p < p1 && t < num_worker ; p++)
+        {
+            acc += piece[p].t1 - piece[p].t0 ;
+            while( t < num_worker && acc*uint64_t(num_worker) >= ntri*uint64_t(t) ) split[t++] = p+1 ;
+        }
+
+        schrono::TP b0 = schrono::stamp();
+        sparallel::For(num_worker, num_worker, [this, &split](int, int i0, int i1){ for(int i=i0 ; i < i1 ; i++) bin_range(i, split[i], split[i+1]) ; });
+        schrono::TP b1 = schrono::stamp();
+
+        std::atomic<int> next(0) ;
+        sparallel::For(num_worker, num_worker, [this, &next, num_tile](int, int, int){ int ti ; while( (ti = next++) < num_tile ) raster_tile(ti) ; });
+        schrono::TP b2 = schrono::stamp();
+
+        t_bin += schrono::duration(b0, b1) ;
+        t_raster += schrono::duration(b1, b2) ;
+        p0 = p1 ;
+    }
+
+    for(int t=0 ; t < num_worker ; t++) num_setup += worker[t].num_setup ;
+    for(int i=0 ; i < num_tile ; i++) num_frag += tile_frag[i] ;
+    schrono::TP t1 = schrono::stamp();
+    t_total = schrono::duration(t0, t1) ;
+}
+
+/**
+SRaster::bin_range
+--------------------
+
+Transforms the vertices of the mesh of each piece once, reusing them
+for consecutive pieces of the same draw, then sets up and bins each
+triangle. The triangles are clipped against the near plane only, the
+other planes are handled by clamping the sample bbox to the image.
+
+**/
+
+inline void SRaster::bin_range( int t, int p0, int p1 )
+{
+    Worker& w = worker[t] ;
+    w.tri.clear();
+    for(size_t i=0 ; i < w.bin.size() ; i++) w.bin[i].clear() ;
+    w.last_draw = -1 ;
+
+    float M[16] ;
+    float N[9] ;
+
+    for(int p=p0 ; p < p1 ; p++)
+    {
+        const Piece& pc = piece[p] ;
+        const Draw& d = draw[pc.draw] ;
+        const Mesh& m = mesh[d.mesh] ;
+
+        if( pc.draw != w.last_draw )
+        {
+            if( d.tran ) Mul(M, world2clip, d.tran) ; else memcpy(M, world2clip, sizeof(M)) ;
+            if( d.tran ) NormalMatrix(N, d.tran) ; else for(int i=0 ; i < 9 ; i++) N[i] = i % 4 == 0 ? 1.f : 0.f ;
+
+            w.vert.resize(m.num_vtx);
+            for(int i=0 ; i < m.num_vtx ; i++)
+            {
+                Vert& v = w.vert[i] ;
+                Transform(v.c, M, m.vtx + 3*i );
+                const float* n = m.nrm ? m.nrm + 3*i : nullptr ;
+                for(int k=0 ; k < 3 ; k++)
+                {
+                    if( n == nullptr )
+                    {
+                        v.a[k] = 0.f ;
+                    }
+                    else if( shade == SHADE_GL )
+                    {
+                        v.a[k] = std::min( 1.f, std::max( 0.f, n[k]*0.5f + 0.8f )) ;
+                    }
+                    else
+                    {
+                        v.a[k] = N[0*3+k]*n[0] + N[1*3+k]*n[1] + N[2*3+k]*n[2] ;
+                    }
+                }
+                project(v);
+            }
+            w.last_draw = pc.draw ;
+        }
+
+        for(int i=pc.t0 ; i < pc.t1 ; i++)
+        {
+            const int* tt = m.tri + 3*i ;
+            const Vert* v[3] = { &w.vert[tt[0]], &w.vert[tt[1]], &w.vert[tt[2]] } ;
+
+            unsigned o[3] = { v[0]->o, v[1]->o, v[2]->o } ;
+            if( o[0] & o[1] & o[2] ) continue ;   // all outside one plane
+
+            if( (( o[0] | o[1] | o[2] ) & 0x10u ) == 0 )
+            {
+                setup_tri(w, *v[0], *v[1], *v[2] );
+                continue ;
+            }
+
+            // Sutherland-Hodgman against near plane z + w >= 0, giving 3 or 4 vertices
+            Vert poly[4] ;
+            int np = 0 ;
+            for(int k=0 ; k < 3 ; k++)
+            {
+                const Vert& a = *v[k] ;
+                const Vert& b = *v[(k+1)%3] ;
+                float da = a.c[2] + a.c[3] ;
+                float db = b.c[2] + b.c[3] ;
+                if( da >= 0.f ) poly[np++] = a ;
+                if( ( da >= 0.f ) != ( db >= 0.f ) )
+                {
+                    float f = da/(da - db) ;
+                    Vert& r = poly[np++] ;
+                    for(int j=0 ; j < 4 ; j++) r.c[j] = a.c[j] + f*(b.c[j] - a.c[j]) ;
+                    for(int j=0 ; j < 3 ; j++) r.a[j] = a.a[j] + f*(b.a[j] - a.a[j]) ;
+                    project(r);
+                }
+            }
+            for(int k=2 ; k < np ; k++) setup_tri(w, poly[0], poly[k-1], poly[k] );
+        }
+    }
+}
+
+/**
+SRaster::project
+------------------
+
+Outcode and, for w > 0, the perspective divide and viewport transform
+onto the sample grid where pixel i is at x = i.
+
+**/
+
+inline void SRaster::project( Vert& v ) const
+{
+    const float* c = v.c ;
+    v.o = ( c[0] < -c[3] ? 0x01u : 0u ) | ( c[0] > c[3] ? 0x02u : 0u )
+        | ( c[1] < -c[3] ? 0x04u : 0u ) | ( c[1] > c[3] ? 0x08u : 0u )
+        | ( c[2] < -c[3] ? 0x10u : 0u ) | ( c[2] > c[3] ? 0x20u : 0u ) ;
+
+    float q = c[3] > 0.f ? 1.f/c[3] : 0.f ;
+    v.s[0] = ( c[0]*q + 1.f )*0.5f*float(width) ;
+    v.s[1] = ( c[1]*q + 1.f )*0.5f*float(height) ;
+    v.s[2] = c[2]*q ;
+    v.s[3] = q ;
+}
+
+/**
+SRaster::setup_tri
+--------------------
+
+Rejects triangles with no sample inside their bbox, which is most
+of them for distant detail, before the degenerate check and binning.
+
+**/
+
+inline void SRaster::setup_tri( Worker& w, const Vert& v0, const Vert& v1, const Vert& v2 ) const
+{
+    if( !( v0.c[3] > 0.f && v1.c[3] > 0.f && v2.c[3] > 0.f )) return ;
+
+    float fx0 = std::ceil( std::max( 0.f,             std::min(v0.s[0], std::min(v1.s[0], v2.s[0])))) ;
+    float fx1 = std::floor(std::min( float(width-1),  std::max(v0.s[0], std::max(v1.s[0], v2.s[0])))) ;
+    if( fx0 > fx1 ) return ;
+    float fy0 = std::ceil( std::max( 0.f,             std::min(v0.s[1], std::min(v1.s[1], v2.s[1])))) ;
+    float fy1 = std::floor(std::min( float(height-1), std::max(v0.s[1], std::max(v1.s[1], v2.s[1])))) ;
+    if( fy0 > fy1 ) return ;
+
+    const Vert* v[3] = { &v0, &v1, &v2 } ;
+    Tri t ;
+    for(int k=0 ; k < 3 ; k++)
+    {
+        t.x[k] = v[k]->s[0] ;
+        t.y[k] = v[k]->s[1] ;
+        t.z[k] = v[k]->s[2] ;
+        t.q[k] = v[k]->s[3] ;
+        for(int j=0 ; j < 3 ; j++) t.a[3*k+j] = v[k]->a[j] ;
+    }
+
+    float area = (t.x[1]-t.x[0])*(t.y[2]-t.y[0]) - (t.y[1]-t.y[0])*(t.x[2]-t.x[0]) ;
+    if( !( area != 0.f ) || !std::isfinite(area) ) return ;
+    if( area < 0.f )    // no back face culling : make counter clockwise by swapping 1 and 2
+    {
+        std::swap(t.x[1], t.x[2]);
+        std::swap(t.y[1], t.y[2]);
+        std::swap(t.z[1], t.z[2]);
+        std::swap(t.q[1], t.q[2]);
+        for(int j=0 ; j < 3 ; j++) std::swap(t.a[3+j], t.a[6+j]);
+    }
+
+    int tx0 = int(fx0)/tile, tx1 = int(fx1)/tile ;
+    int ty0 = int(fy0)/tile, ty1 = int(fy1)/tile ;
+
+    uint32_t idx = w.tri.size() ;
+    w.tri.push_back(t);
+    w.num_setup += 1 ;
+    for(int ty=ty0 ; ty <= ty1 ; ty++)
+    for(int tx=tx0 ; tx <= tx1 ; tx++) w.bin[ty*ntx+tx].push_back(idx) ;
+}
+
+inline void SRaster::raster_tile( int ti )
+{
+    int tx = ti % ntx ;
+    int ty = ti / ntx ;
+    int x0 = tx*tile ;
+    int y0 = ty*tile ;
+    int x1 = std::min( width  - 1, x0 + tile - 1 ) ;
+    int y1 = std::min( height - 1, y0 + tile - 1 ) ;
+
+    uint64_t& frag = tile_frag[ti] ;
+    for(int t=0 ; t < num_worker ; t++)
+    {
+        const Worker& w = worker[t] ;
+        const std::vector<uint32_t>& b = w.bin[ti] ;
+        for(size_t i=0 ; i < b.size() ; i++) raster_tri( w.tri[b[i]], x0, y0, x1, y1, frag );
+    }
+}
+
+/**
+SRaster::raster_tri
+---------------------
+
+Edge functions are evaluated directly at each sample relative to the
+lexicographically lower vertex of the edge, so the two triangles sharing
+an edge compute bitwise negated values and samples exactly on the edge
+go to one of them only, according to the edge direction.
+
+Barycentrics weight the NDC depth linearly in screen space and the
+attributes with 1/w for perspective correction, as OpenGL interpolation.
+
+**/
+
+inline void SRaster::raster_tri( const Tri& t, int x0, int y0, int x1, int y1, uint64_t& frag )
+{
+    float ax[3], ay[3], dx[3], dy[3], sg[3] ;
+    bool own[3] ;
+    for(int k=0 ; k < 3 ; k++)    // edge k from vertex k to k+1 has weight of vertex k+2
+    {
+        int a = k ;
+        int b = (k+1) % 3 ;
+        float ex = t.x[b] - t.x[a] ;
+        float ey = t.y[b] - t.y[a] ;
+        own[k] = ey < 0.f || ( ey == 0.f && ex > 0.f ) ;
+        bool swap = t.x[b] < t.x[a] || ( t.x[b] == t.x[a] && t.y[b] < t.y[a] ) ;
+        int c = swap ? b : a ;
+        ax[k] = t.x[c] ;
+        ay[k] = t.y[c] ;
+        dx[k] = swap ? -ex : ex ;
+        dy[k] = swap ? -ey : ey ;
+        sg[k] = swap ? -1.f : 1.f ;
+    }
+
+    float area = (t.x[1]-t.x[0])*(t.y[2]-t.y[0]) - (t.y[1]-t.y[0])*(t.x[2]-t.x[0]) ;
+    float inv_area = 1.f/area ;
+
+    int bx0 = std::max( x0, int(std::ceil( std::min(t.x[0], std::min(t.x[1], t.x[2]))))) ;
+    int bx1 = std::min( x1, int(std::floor(std::max(t.x[0], std::max(t.x[1], t.x[2]))))) ;
+    int by0 = std::max( y0, int(std::ceil( std::min(t.y[0], std::min(t.y[1], t.y[2]))))) ;
+    int by1 = std::min( y1, int(std::floor(std::max(t.y[0], std::max(t.y[1], t.y[2]))))) ;
+
+    for(int y=by0 ; y <= by1 ; y++)
+    {
+        float py = float(y) ;
+        for(int x=bx0 ; x <= bx1 ; x++)
+        {
+            float px = float(x) ;
+            float e[3] ;
+            bool inside = true ;
+            for(int k=0 ; k < 3 ; k++)
+            {
+                e[k] = sg[k]*( dx[k]*(py - ay[k]) - dy[k]*(px - ax[k]) ) ;
+                inside = inside && ( e[k] > 0.f || ( e[k] == 0.f && own[k] )) ;
+            }
+            if(!inside) continue ;
+
+            float l0 = e[1]*inv_area ;
+            float l1 = e[2]*inv_area ;
+            float l2 = e[0]*inv_area ;
+            float z = l0*t.z[0] + l1*t.z[1] + l2*t.z[2] ;
+            if( z > 1.f ) continue ;
+
+            size_t idx = size_t(y)*size_t(width) + size_t(x) ;
+            if( !( z < depth[idx] )) continue ;
+            depth[idx] = z ;
+
+            float w0 = l0*t.q[0] ;
+            float w1 = l1*t.q[1] ;
+            float w2 = l2*t.q[2] ;
+            float iw = 1.f/(w0 + w1 + w2) ;
+            float a[3] ;
+            for(int j=0 ; j < 3 ; j++) a[j] = ( w0*t.a[j] + w1*t.a[3+j] + w2*t.a[6+j] )*iw ;
+
+            hit_pixel( pixels.data() + 4*idx, a, z );
+            frag += 1 ;
+        }
+    }
+}
+
+inline void SRaster::miss_pixel( unsigned char* px ) const
+{
+    if( shade == SHADE_GL )
+    {
+        px[0] = 0 ; px[1] = 0 ; px[2] = 0 ; px[3] = 0 ;
+    }
+    else
+    {
+        float a[3] = { 0.f, 0.f, 0.f } ;
+        hit_pixel( px, a, 0.999f );
+    }
+}
+
+/**
+SRaster::hit_pixel
+--------------------
+
+SHADE_RT follows make_normal_pixel from SOPTIX.cu including the
+truncating conversion, the zero normal of a miss giving mid-grey.
+
+**/
+
+inline void SRaster::hit_pixel( unsigned char* px, const float* a, float z ) const
+{
+    auto u8 = [](float f){ return static_cast<unsigned char>( std::min(1.f, std::max(0.f, f))*255.f ) ; } ;
+    if( shade == SHADE_GL )
+    {
+        px[0] = u8(a[0]) ; px[1] = u8(a[1]) ; px[2] = u8(a[2]) ; px[3] = 255 ;
+    }
+    else
+    {
+        float nn = std::sqrt( a[0]*a[0] + a[1]*a[1] + a[2]*a[2] ) ;
+        float s = nn > 0.f ? 1.f/nn : 0.f ;
+        px[0] = u8( a[0]*s*0.5f + 0.5f ) ;
+        px[1] = u8( a[1]*s*0.5f + 0.5f ) ;
+        px[2] = u8( a[2]*s*0.5f + 0.5f ) ;
+        px[3] = u8( z ) ;
+    }
+}
+
+/**
+SRaster::save
+---------------
+
+.ppm via sppm::Write and .npy of shape (height, width, 4) both with
+the yflip that puts row 0 at the top. For .jpg .png see SRaster_Scene::save
+which uses SIMG.
+
+**/
+
+inline void SRaster::save( const char* path ) const
+{
+    if( path == nullptr ) return ;
+    int n = strlen(path) ;
+    bool npy = n > 4 && strcmp(path + n - 4, ".npy") == 0 ;
+    if( npy )
+    {
+        NP* a = get_pixels() ;
+        a->save(path);
+        delete a ;
+    }
+    else
+    {
+        bool yflip = true ;
+        int ncomp = 4 ;
+        sppm::Write(path, width, height, ncomp, pixels.data(), yflip );
+    }
+}
+
+inline NP* SRaster::get_pixels() const
+{
+    NP* a = NP::Make<unsigned char>( height, width, 4 ) ;
+    unsigned char* aa = a->values<unsigned char>() ;
+    size_t row = 4*size_t(width) ;
+    for(int y=0 ; y < height ; y++) memcpy( aa + size_t(height-1-y)*row, pixels.data() + size_t(y)*row, row );
+    return a ;
+}
+
+inline std::string SRaster::desc() const
+{
+    std::stringstream ss ;
+    ss << "SRaster::desc"
+       << " width " << width
+       << " height " << height
+       << " shade " << Shade(shade)
+       << " num_thread " << num_thread
+       << " num_worker " << num_worker
+       << " tile " << tile
+       << " batch " << batch
+       << " num_mesh " << mesh.size()
+       << " num_draw " << draw.size()
+       << " num_cull " << num_cull
+       << " num_tri " << num_tri
+       << " num_setup " << num_setup
+       << " num_frag " << num_frag
+       << " t_bin " << t_bin
+       << " t_raster " << t_raster
+       << " t_total " << t_total
+       ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,142 @@
+#pragma once
+/**
+SRaster_Scene.h : CPU raster render of SScene triangulated geometry with SGLM view
+=====================================================================================
+
+Connects SScene meshes and instances with the SRaster.h software rasterizer,
+in the same way as SGLFW_Scene.h for OpenGL and SOPTIX_Scene.h for OptiX.
+This allows headless rendering of geometry images without GPU.
+
+* meshes are the SScene::getMeshMerge of the SScene::getRenderLOD level
+* compound solids with more than one instance are drawn with each inst_tran,
+  the others with identity transform as SGLFW_Scene
+* the SGLM::vizmask selects compound solids with the same bits as
+  SOPTIX_Properties::visibilityMask
+* the view is SGLM::MVP with SGLM::Width SGLM::Height
+
+With the default SRaster::SHADE_RT the pixels follow SOPTIX.cu
+so CPU and GPU renders of the same frame can be compared directly.
+
+Usage::
+
+    SGLM gm ;
+    gm.set_frame( scene->getFrame(FRAME) );
+
+    SRaster_Scene rs(scene, gm);
+    rs.render();
+    rs.save("/tmp/render.jpg");
+
+NB for .jpg .png output the SIMG_IMPLEMENTATION needs to be defined in
+one compilation unit prior to including SIMG.h, as SIMG_Frame.h does.
+
+**/
+
+#include "SScene.h"
+#include "SGLM.h"
+#include "SRaster.h"
+#include "SIMG.h"
+
+struct SRaster_Scene
+{
+    static constexpr const char* _QUALITY = "SRaster_Scene__QUALITY" ;
+
+    const SScene* scene ;
+    SGLM&         gm ;
+    int           lod ;
+    SRaster       ras ;
+
+    SRaster_Scene(const SScene* scene, SGLM& gm);
+    void init();
+    void render();
+    void save(const char* path);
+    std::string desc() const ;
+};
+
+inline SRaster_Scene::SRaster_Scene(const SScene* _scene, SGLM& _gm)
+    :
+    scene(_scene),
+    gm(_gm),
+    lod(scene->getRenderLOD())
+{
+    init();
+}
+
+inline void SRaster_Scene::init()
+{
+    const std::vector<glm::tmat4x4<float>>& inst_tran = scene->inst_tran ;
+    int num_meshmerge = scene->meshmerge.size() ;
+
+    for(int i=0 ; i < num_meshmerge ; i++)
+    {
+        if(!gm.is_vizmask_set(std::min(i, 7))) continue ;
+
+        const int4& _inst_info = scene->inst_info[i] ;
+        int num_inst = _inst_info.y ;
+        int offset   = _inst_info.z ;
+        bool is_instanced = num_inst > 1 ;
+
+        const SMesh* _mm = scene->getMeshMerge(i, lod) ;
+        int m = ras.add_mesh(
+             _mm->vtx->cvalues<float>(),
+             _mm->nrm ? _mm->nrm->cvalues<float>() : nullptr,
+             _mm->tri->cvalues<int>(),
+             _mm->vtx->shape[0],
+             _mm->tri->shape[0] );
+
+        if( is_instanced )
+        {
+            for(int k=0 ; k < num_inst ; k++) ras.add_draw( m, glm::value_ptr(inst_tran[offset+k]) );
+        }
+        else
+        {
+            ras.add_draw( m, nullptr );
+        }
+    }
+}
+
+inline void SRaster_Scene::render()
+{
+    ras.set_view( glm::value_ptr(gm.MVP), gm.Width(), gm.Height() );
+    ras.render();
+}
+
+/**
+SRaster_Scene::save
+---------------------
+
+.jpg and .png are written with SIMG after flipping to row 0 at top,
+other paths use SRaster::save (.ppm .npy)
+
+**/
+
+inline void SRaster_Scene::save(const char* path)
+{
+    if( path == nullptr ) return ;
+    bool jpg = SIMG::EndsWith(path, ".jpg") ;
+    bool png = SIMG::EndsWith(path, ".png") ;
+    if( jpg || png )
+    {
+        NP* a = ras.get_pixels() ;   // already flipped
+        SIMG img(ras.width, ras.height, 4, a->values<unsigned char>() );
+        if(jpg) img.writeJPG(path, ssys::getenvint(_QUALITY, 50) );
+        if(png) img.writePNG(path);
+        delete a ;
+    }
+    else
+    {
+        ras.save(path);
+    }
+}
+
+inline std::string SRaster_Scene::desc() const
+{
+    std::stringstream ss ;
+    ss << "SRaster_Scene::desc"
+       << " lod " << lod
+       << " num_meshmerge " << scene->meshmerge.size()
+       << "\n"
+       << ras.desc()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
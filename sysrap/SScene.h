@@ -33,6 +33,14 @@ with OptiX ray trace and OpenGL rasterized.
     with applying the selection as all the identity info needed is
     available within the tree
 
+* Level-of-detail : SScene__LOD envvar eg "0.01,0.1,1" configures
+  additional LOD levels of meshgroup and meshmerge, simplified with
+  SMeshSimplify to bound the surface deviation to each max_error in mm.
+  Level 0 is always the full resolution meshgroup and meshmerge.
+  The triangulated simulation (SBT::createGAS) uses getSimulationLOD
+  which only picks a simplified level when SScene__SIM_LOD_MAX_ERROR
+  permits, rendering uses getRenderLOD which defaults to the coarsest.
+
 * WIP: incorporate into standard workflow
 
   * treat SScene.h as sibling to stree.h within SSim.hh
@@ -53,6 +61,9 @@ with OptiX ray trace and OpenGL rasterized.
 struct SScene
 {
     static constexpr const char* __level = "SScene__level" ;
+    static constexpr const char* __LOD = "SScene__LOD" ;
+    static constexpr const char* __SIM_LOD_MAX_ERROR = "SScene__SIM_LOD_MAX_ERROR" ;
+    static constexpr const char* __RENDER_LOD = "SScene__RENDER_LOD" ;
 
     static constexpr const char* BASE = "$CFBaseFromGEOM/CSGFoundry/SSim" ;
     static constexpr const char* RELDIR = "scene" ;
@@ -60,6 +71,8 @@ struct SScene
     static constexpr const char* MESHGROUP = "meshgroup" ;
     static constexpr const char* MESHMERGE = "meshmerge" ;
     static constexpr const char* FRAME = "frame" ;
+    static constexpr const char* LOD = "lod" ;
+    static constexpr const char* LOD_MAX_ERROR = "max_error" ;
     static constexpr const char* INST_TRAN = "inst_tran.npy" ;
     static constexpr const char* INST_COL3 = "inst_col3.npy" ;
     static constexpr const char* INST_INFO = "inst_info.npy" ;
@@ -78,6 +91,10 @@ struct SScene
     std::vector<glm::tmat4x4<float>>  inst_tran ;  // instance level
     std::vector<glm::tvec4<int32_t>>  inst_col3 ;
 
+    std::vector<double>                          lod_error ;      // max_error mm of LOD levels 1,2,...
+    std::vector<std::vector<const SMeshGroup*>>  lod_meshgroup ;  // [lod-1][idx]
+    std::vector<std::vector<const SMesh*>>       lod_meshmerge ;
+
 
     static SScene* Load_(const char* dir=BASE);
     static SScene* Load(const char* dir=BASE);
@@ -96,10 +113,19 @@ struct SScene
     void initFromTree_Factor_(int ridx, const stree* st);
     void initFromTree_Node(SMeshGroup* mg, int ridx, const snode& node, const stree* st);
     void initFromTree_Instance (const stree* st);
+    void initFromTree_LOD();
 
     const SMeshGroup* getMeshGroup(int idx) const ;
     const SMesh*      getMeshMerge(int idx) const ;
 
+    void   addLOD(double max_error);
+    int    num_lod() const ;
+    double getLODError(int lod) const ;
+    int    getSimulationLOD() const ;
+    int    getRenderLOD() const ;
+    const SMeshGroup* getMeshGroup(int idx, int lod) const ;
+    const SMesh*      getMeshMerge(int idx, int lod) const ;
+
 
     const SMesh* get_mm(int mmidx) const ;
     const float* get_mn(int mmidx) const ;
@@ -114,6 +140,7 @@ struct SScene
     std::string descCol3() const ;
     std::string descFrame() const ;
     std::string descRange() const ;
+    std::string descLOD() const ;
     static std::string DescCompare(const SScene* a, const SScene* b);
 
     NPFold* serialize_meshmerge() const ;
@@ -125,6 +152,9 @@ struct SScene
     NPFold* serialize_frame() const ;
     void import_frame(const NPFold* _frame ) ;
 
+    NPFold* serialize_lod() const ;
+    void import_lod(const NPFold* _lod ) ;
+
     NPFold* serialize() const ;
     void import_(const NPFold* fold);
 
@@ -224,6 +254,11 @@ inline void SScene::check() const
 
     assert( num_frame_expect );
     assert( meshmerge.size() == meshgroup.size() );
+
+    assert( lod_meshgroup.size() == lod_error.size() );
+    assert( lod_meshmerge.size() == lod_error.size() );
+    for(size_t l=0 ; l < lod_error.size() ; l++) assert( lod_meshgroup[l].size() == meshgroup.size() );
+    for(size_t l=0 ; l < lod_error.size() ; l++) assert( lod_meshmerge[l].size() == meshmerge.size() );
 }
 
 
@@ -263,6 +298,7 @@ inline void SScene::initFromTree(const stree* st)
     initFromTree_Triangulate(st);
 
     initFromTree_Instance(st);
+    initFromTree_LOD();
 
     addFrames("$SScene__initFromTree_addFrames", st );
 }
@@ -463,6 +499,110 @@ inline void SScene::initFromTree_Instance(const stree* st)
 
 
 
+/**
+SScene::initFromTree_LOD
+--------------------------
+
+Adds LOD levels for each max_error in mm listed in the
+SScene__LOD envvar, eg "0.01,0.1,1". Nothing is added by default.
+
+**/
+
+inline void SScene::initFromTree_LOD()
+{
+    std::vector<double>* errs = ssys::getenv_vec<double>(__LOD, nullptr) ;
+    if( errs == nullptr ) return ;
+    for(size_t i=0 ; i < errs->size() ; i++) addLOD( (*errs)[i] );
+    delete errs ;
+    if(level>0) std::cout << descLOD() ;
+}
+
+/**
+SScene::addLOD
+----------------
+
+Each LOD level is simplified from the full resolution meshgroup
+subs, not from the previous level, so the max_error bound of each
+level does not accumulate. The meshmerge of the level is the
+concatenation of the simplified subs, as for level 0.
+
+**/
+
+inline void SScene::addLOD(double max_error)
+{
+    assert( max_error > 0. );
+    assert( lod_error.empty() || max_error > lod_error.back() );  // levels get coarser
+
+    std::vector<const SMeshGroup*> mgs ;
+    std::vector<const SMesh*> mms ;
+    int num_mg = meshgroup.size() ;
+    for(int i=0 ; i < num_mg ; i++)
+    {
+        SMeshGroup* mg = meshgroup[i]->simplify(max_error) ;
+        const SMesh* mm = SMesh::Concatenate( mg->subs, i );
+        mgs.push_back(mg);
+        mms.push_back(mm);
+    }
+    lod_error.push_back(max_error);
+    lod_meshgroup.push_back(mgs);
+    lod_meshmerge.push_back(mms);
+}
+
+inline int SScene::num_lod() const
+{
+    return 1 + lod_error.size() ;
+}
+inline double SScene::getLODError(int lod) const
+{
+    return lod > 0 && lod < num_lod() ? lod_error[lod-1] : 0. ;
+}
+
+/**
+SScene::getSimulationLOD
+--------------------------
+
+Coarsest level with max_error not exceeding SScene__SIM_LOD_MAX_ERROR,
+which defaults to zero, so the full resolution level 0 is used
+unless the surface deviation is explicitly permitted.
+
+**/
+
+inline int SScene::getSimulationLOD() const
+{
+    double allowed = ssys::getenvdouble(__SIM_LOD_MAX_ERROR, 0.) ;
+    int lod = 0 ;
+    for(int l=1 ; l < num_lod() ; l++) if( lod_error[l-1] <= allowed ) lod = l ;
+    return lod ;
+}
+
+/**
+SScene::getRenderLOD
+----------------------
+
+SScene__RENDER_LOD level, defaulting to -1 for the coarsest
+
+**/
+
+inline int SScene::getRenderLOD() const
+{
+    int lod = ssys::getenvint(__RENDER_LOD, -1) ;
+    if( lod < 0 || lod >= num_lod() ) lod = num_lod() - 1 ;
+    return lod ;
+}
+
+inline const SMeshGroup* SScene::getMeshGroup(int idx, int lod) const
+{
+    if( lod <= 0 || lod >= num_lod() ) return getMeshGroup(idx) ;
+    const std::vector<const SMeshGroup*>& mgs = lod_meshgroup[lod-1] ;
+    return idx < int(mgs.size()) ? mgs[idx] : nullptr ;
+}
+inline const SMesh* SScene::getMeshMerge(int idx, int lod) const
+{
+    if( lod <= 0 || lod >= num_lod() ) return getMeshMerge(idx) ;
+    const std::vector<const SMesh*>& mms = lod_meshmerge[lod-1] ;
+    return idx < int(mms.size()) ? mms[idx] : nullptr ;
+}
+
 inline const SMeshGroup* SScene::getMeshGroup(int idx) const
 {
     return idx < int(meshgroup.size()) ? meshgroup[idx] : nullptr ;
@@ -510,6 +650,7 @@ inline std::string SScene::desc() const
     ss << descSize() ;
     ss << descInstInfo() ;
     ss << descCol3() ;
+    if(!lod_error.empty()) ss << descLOD() ;
     //ss << descFrame() ;
     ss << "] SScene::desc \n" ;
     std::string str = ss.str();
@@ -528,6 +669,25 @@ inline std::string SScene::descDetail() const
 
 
 
+inline std::string SScene::descLOD() const
+{
+    std::stringstream ss ;
+    ss << "[SScene::descLOD num_lod " << num_lod() << "\n" ;
+    for(int l=0 ; l < num_lod() ; l++)
+    {
+        int tot_tri = 0 ;
+        for(int i=0 ; i < int(meshgroup.size()) ; i++) tot_tri += getMeshGroup(i, l)->num_tri() ;
+        ss << " lod " << l
+           << " max_error " << std::setw(8) << getLODError(l)
+           << " tot_tri " << std::setw(10) << tot_tri
+           << "\n"
+           ;
+    }
+    ss << "]SScene::descLOD\n" ;
+    std::string str = ss.str();
+    return str ;
+}
+
 inline std::string SScene::descSize() const
 {
     std::stringstream ss ;
@@ -743,11 +903,74 @@ inline void SScene::import_frame(const NPFold* _frame )
 
 
 
+/**
+SScene::serialize_lod
+-----------------------
+
+Each LOD level is a subfold named by the level, with meshmerge and
+meshgroup subfolds and the max_error in the metadata. Returns nullptr
+with no LOD levels, keeping the scene fold layout unchanged.
+
+**/
+
+inline NPFold* SScene::serialize_lod() const
+{
+    int num_level = lod_error.size() ;
+    if( num_level == 0 ) return nullptr ;
+
+    NPFold* _lod = new NPFold ;
+    for(int l=0 ; l < num_level ; l++)
+    {
+        NPFold* _meshmerge = new NPFold ;
+        NPFold* _meshgroup = new NPFold ;
+        for(int i=0 ; i < int(lod_meshmerge[l].size()) ; i++)
+        {
+            const SMesh* m = lod_meshmerge[l][i] ;
+            _meshmerge->add_subfold( m->name, m->serialize() );
+        }
+        for(int i=0 ; i < int(lod_meshgroup[l].size()) ; i++)
+        {
+            const SMeshGroup* mg = lod_meshgroup[l][i] ;
+            _meshgroup->add_subfold( SMesh::FormName(i), mg->serialize() );
+        }
+        NPFold* _level = new NPFold ;
+        _level->set_meta<double>(LOD_MAX_ERROR, lod_error[l]) ;
+        _level->add_subfold( MESHMERGE, _meshmerge );
+        _level->add_subfold( MESHGROUP, _meshgroup );
+        _lod->add_subfold( SMesh::FormName(l+1), _level );
+    }
+    return _lod ;
+}
+
+inline void SScene::import_lod(const NPFold* _lod )
+{
+    int num_level = _lod ? _lod->get_num_subfold() : 0 ;
+    for(int l=0 ; l < num_level ; l++)
+    {
+        const NPFold* _level = _lod->get_subfold(l);
+        const NPFold* _meshmerge = _level->get_subfold(MESHMERGE);
+        const NPFold* _meshgroup = _level->get_subfold(MESHGROUP);
+
+        std::vector<const SMesh*> mms ;
+        std::vector<const SMeshGroup*> mgs ;
+        int num_mm = _meshmerge ? _meshmerge->get_num_subfold() : 0 ;
+        int num_mg = _meshgroup ? _meshgroup->get_num_subfold() : 0 ;
+        for(int i=0 ; i < num_mm ; i++) mms.push_back( SMesh::Import(_meshmerge->get_subfold(i)) );
+        for(int i=0 ; i < num_mg ; i++) mgs.push_back( SMeshGroup::Import(_meshgroup->get_subfold(i)) );
+
+        lod_error.push_back( _level->get_meta<double>(LOD_MAX_ERROR, 0.) );
+        lod_meshmerge.push_back(mms);
+        lod_meshgroup.push_back(mgs);
+    }
+}
+
+
 inline NPFold* SScene::serialize() const
 {
     NPFold* _meshmerge = serialize_meshmerge() ;
     NPFold* _meshgroup = serialize_meshgroup() ;
     NPFold* _frame     = serialize_frame() ;
+    NPFold* _lod       = serialize_lod() ;
     NP* _inst_tran = NPX::ArrayFromVec<float, glm::tmat4x4<float>>( inst_tran, 4, 4) ;
     NP* _inst_info = NPX::ArrayFromVec<int,int4>( inst_info, 4 ) ;
     NP* _inst_col3 = NPX::ArrayFromVec<int,glm::tvec4<int32_t>>( inst_col3, 4 ) ;
@@ -757,6 +980,7 @@ inline NPFold* SScene::serialize() const
     fold->add_subfold( MESHMERGE, _meshmerge );
     fold->add_subfold( MESHGROUP, _meshgroup );
     fold->add_subfold( FRAME,     _frame );
+    if(_lod) fold->add_subfold( LOD, _lod );
     fold->add( INST_INFO, _inst_info );
     fold->add( INST_TRAN, _inst_tran );
     fold->add( INST_COL3, _inst_col3 );
@@ -776,6 +1000,7 @@ inline void SScene::import_(const NPFold* fold)
     import_meshmerge( _meshmerge );
     import_meshgroup( _meshgroup );
     import_frame(     _frame );
+    import_lod(       fold->get_subfold(LOD) );
 
     const NP* _inst_info = fold->get(INST_INFO);
     const NP* _inst_tran = fold->get(INST_TRAN);
@@ -1005,6 +1230,11 @@ inline SScene* SScene::CopySelect( const SScene* src, const SBitSet* elv ) // st
 {
     SScene* dst = new SScene ;
     int s_num_mg = src->meshgroup.size() ;
+    int s_num_level = src->lod_error.size() ;
+
+    dst->lod_error = src->lod_error ;
+    dst->lod_meshgroup.resize(s_num_level);
+    dst->lod_meshmerge.resize(s_num_level);
 
     int* solidMap = new int[s_num_mg];
 
@@ -1028,6 +1258,14 @@ inline SScene* SScene::CopySelect( const SScene* src, const SBitSet* elv ) // st
 
         const SMesh* d_mesh = SMesh::Concatenate( d_mg->subs, ridx );
         dst->meshmerge.push_back(d_mesh);
+
+        for(int l=0 ; l < s_num_level ; l++)  // LOD subs have the same lvid so the same selection
+        {
+            SMeshGroup* d_lmg = src->lod_meshgroup[l][i]->copy(elv) ;
+            assert( d_lmg );
+            dst->lod_meshgroup[l].push_back(d_lmg);
+            dst->lod_meshmerge[l].push_back( SMesh::Concatenate( d_lmg->subs, ridx ) );
+        }
     }
 
 
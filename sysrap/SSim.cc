@@ -141,6 +141,22 @@ SSim* SSim::Load(const char* base, const char* reldir)
     return sim ;
 }
 
+/**
+SSim::Import
+--------------
+
+From an already loaded top fold, eg from sbundle::fold, rather than
+from the directory form.
+
+**/
+
+SSim* SSim::Import(NPFold* top)
+{
+    SSim* sim = new SSim ;
+    sim->import_top(top);
+    return sim ;
+}
+
 
 
 
@@ -464,13 +480,20 @@ void SSim::load_(const char* dir)
 
     LOG(LEVEL) << "] top.load [" << dir << "] toploadtime/1e6 " << std::fixed << std::setw(9) << std::setprecision(6) << toploadtime/1e6 ;
 
+    import_top(top);
+
+    LOG(LEVEL) << "]" ;
+}
+
+void SSim::import_top(NPFold* top_)
+{
+    top = top_ ;
+
     NPFold* f_tree = top->get_subfold( stree::RELDIR ) ;
     tree->import_( f_tree );
 
     NPFold* f_scene = top->get_subfold( SScene::RELDIR ) ;
     scene->import_( f_scene );
-
-    LOG(LEVEL) << "]" ;
 }
 
 
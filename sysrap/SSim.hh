@@ -66,6 +66,7 @@ struct SYSRAP_API SSim
     static SSim* Load();
     static SSim* Load_(const char* dir);
     static SSim* Load(const char* base, const char* reldir=RELDIR );
+    static SSim* Import(NPFold* top);
 
 private:
     SSim();
@@ -106,6 +107,7 @@ public:
     void save(const char* base, const char* reldir=RELDIR) ;  // not const as may serialize
     void load(const char* base, const char* reldir=RELDIR) ;
     void load_(const char* dir);
+    void import_top(NPFold* top_);
     void serialize();
     bool hasTop() const ;
 
@@ -1,21 +1,76 @@
 #pragma once
 /**
-s_mock_texture : exploring CUDA texture lookup API on CPU
-=============================================================
+s_mock_texture : CPU implementation of CUDA 2D texture lookups
+================================================================
 
-The cudaTextureObject_t just probably typedef to unsigned long 
-so its an "int" pointer. 
+The cudaTextureObject_t just probably typedef to unsigned long
+so its an "int" pointer. Here it is used as the index of the
+MockTexture within the MockTextureManager.
 
 The .cc that includes this needs to plant the INSTANCE, eg::
 
     #include "s_mock_texture.h"
-    MockTextureManager* MockTextureManager::INSTANCE = nullptr ; 
+    MockTextureManager* MockTextureManager::INSTANCE = nullptr ;
+
+
+Fidelity to CUDA textures
+---------------------------
+
+So that the MOCK_CUDA qsim/qbnd/qscint paths match the GPU the
+lookups follow the texture fetching described in the
+CUDA programming guide appendix "Texture Fetching":
+
+filterMode 'P' (cudaFilterModePoint)
+    texel i = floor(x) where x is the texel coordinate,
+    ie normalized coordinate times width
+
+filterMode 'L' (cudaFilterModeLinear)
+    bilinear interpolation between texels at floor(x-0.5) and
+    floor(x-0.5)+1 with the weight alpha = frac(x-0.5)
+    held in 9-bit fixed point with 8 bits of fraction,
+    so weights are multiples of 1/256
+
+addressMode
+    wrap, clamp, mirror and border applied to the integer texel
+    indices. As with CUDA, wrap and mirror are only supported with
+    normalized coordinates, falling back to clamp otherwise
+
+layers
+    layered 2D textures with tex2DLayered, there is no filtering
+    across layers and the layer index is clamped
+
+
+Zero-copy handles
+-------------------
+
+MockTexture holds a pointer to the float texel data rather than
+a copy, so adding textures from QTex is free.
+Copies are only made when the source array is not float32, eg double
+arrays are narrowed. MockTextureManager::get returns a reference.
+
+
+Batched lookups
+-----------------
+
+MockTexture::lookup_batch and MockTextureManager::tex2D_batch
+do many lookups into the same texture. The linear filtered path
+first computes texel offsets and weights for a block of
+coordinates in branch free loops that the compiler can vectorize
+and then gathers and blends.
+
+::
+
+   ~/o/sysrap/tests/s_mock_texture_test.sh
 
 **/
 
 #include <vector>
+#include <string>
+#include <sstream>
 #include <iomanip>
+#include <cmath>
 #include <cassert>
+#include <algorithm>
 
 #include <vector_types.h>
 #include "NP.hh"
@@ -23,181 +78,422 @@ The .cc that includes this needs to plant the INSTANCE, eg::
 
 struct MockTexture
 {
-    NP* a ; 
-    NP::INT width ; 
-    NP::INT height ; 
-    float4 dom ; 
+    enum { AddressWrap = 0, AddressClamp = 1, AddressMirror = 2, AddressBorder = 3 } ;  // cudaTextureAddressMode values
+    static constexpr const int BLOCK = 64 ;
+
+    NP* a ;              // array with domain metadata, texel data viewed when float32
+    bool owned ;         // true when a is a narrowed/converted copy owned by the texture
+    const float* data ;  // texel data : height*layers rows of width texels of channels floats
+    NP::INT width ;
+    NP::INT height ;
+    NP::INT layers ;
+    NP::INT channels ;
+    float4 dom ;
+    char filterMode ;       // 'P' or 'L'
+    bool normalizedCoords ;
+    int addressMode[2] ;
+
+    MockTexture(const NP* a);
+    MockTexture(const NP* a, const float* data, NP::INT width, NP::INT height, NP::INT channels, char filterMode, bool normalizedCoords, int addressMode=AddressWrap, NP::INT layers=1 );
+
+    void init_domain();
+    std::string desc() const ;
+
+    static float Alpha9(float f);
+    static int   Address(int i, int n, int mode);
+    int  offset(int ix, int iy, int layer) const ;   // -1 for border
+
+    template<typename T> static T Make(const float* v);
+    template<typename T> T lookup(float x, float y, int layer=0 ) const ;
+    template<typename T> void lookup_batch(T* out, const float* x, const float* y, int n, int layer=0 ) const ;
+    template<typename T> std::string dump() const ;
+};
+
+
+/**
+MockTexture::MockTexture(const NP* a)
+----------------------------------------
 
-    MockTexture(const NP* a); 
+Former interface : nearest texel lookup into the conventional
+2D layout of the array with float4 payload last dimension,
+see NP::size_2D.
 
-    std::string desc() const ; 
-    template<typename T> T lookup(float x, float y ) const ; 
-    template<typename T> std::string dump() const ; 
-}; 
+**/
 
 inline MockTexture::MockTexture(const NP* a_ )
     :
-    a(NP::MakeNarrowIfWide(a_)),  // NB even if narrow already, still copies
+    a(a_ && a_->uifc == 'f' && a_->ebyte == 4 ? const_cast<NP*>(a_) : NP::MakeWithType<float>(a_)),
+    owned(a != a_),
+    data(a->cvalues<float>()),
     width(0),
-    height(0)
+    height(0),
+    layers(1),
+    channels(4),
+    filterMode('P'),
+    normalizedCoords(true),
+    addressMode{AddressWrap, AddressWrap}
+{
+    a->size_2D<4>(width, height);
+    init_domain();
+}
+
+/**
+MockTexture::MockTexture(const NP* a, const float* data, ...)
+---------------------------------------------------------------
+
+As used from QTex, *data* is the texel data passed to QTex
+which may be offset within the array *a*. When *data* is null
+it is taken from *a* which is narrowed/converted when not float32.
+
+**/
+
+inline MockTexture::MockTexture(const NP* a_, const float* data_, NP::INT width_, NP::INT height_, NP::INT channels_, char filterMode_, bool normalizedCoords_, int addressMode_, NP::INT layers_ )
+    :
+    a(data_ || a_ == nullptr || (a_->uifc == 'f' && a_->ebyte == 4) ? const_cast<NP*>(a_) : NP::MakeWithType<float>(a_)),
+    owned(a != a_),
+    data(data_ ? data_ : ( a ? a->cvalues<float>() : nullptr )),
+    width(width_),
+    height(height_),
+    layers(layers_),
+    channels(channels_),
+    filterMode(filterMode_),
+    normalizedCoords(normalizedCoords_),
+    addressMode{addressMode_, addressMode_}
+{
+    assert( data );
+    assert( filterMode == 'P' || filterMode == 'L' );
+    assert( channels >= 1 && channels <= 4 );
+    if( a ) assert( NP::INT(a->num_values()) >= width*height*layers*channels || data_ );
+    init_domain();
+}
+
+inline void MockTexture::init_domain()
 {
-    a->size_2D<4>(width, height); 
- 
-    dom.x = a->get_meta<float>("domain_low",  0.f );
-    dom.y = a->get_meta<float>("domain_high",  0.f );
-    dom.z = a->get_meta<float>("domain_step",  0.f );
-    dom.w = a->get_meta<float>("domain_range", 0.f );
+    dom.x = a ? a->get_meta<float>("domain_low",  0.f ) : 0.f ;
+    dom.y = a ? a->get_meta<float>("domain_high",  0.f ) : 0.f ;
+    dom.z = a ? a->get_meta<float>("domain_step",  0.f ) : 0.f ;
+    dom.w = a ? a->get_meta<float>("domain_range", 0.f ) : 0.f ;
 }
 
-inline std::string MockTexture::desc() const 
+inline std::string MockTexture::desc() const
 {
-    std::stringstream ss ; 
-    ss << "MockTexture::desc"  
+    std::stringstream ss ;
+    ss << "MockTexture::desc"
        << " a " << ( a ? a->sstr() : "-" )
+       << " owned " << ( owned ? "Y" : "N" )
        << " width " << width
        << " height " << height
-       << " dom " << dom 
-       ; 
+       << " layers " << layers
+       << " channels " << channels
+       << " filterMode " << filterMode
+       << " normalizedCoords " << ( normalizedCoords ? "Y" : "N" )
+       << " addressMode " << addressMode[0] << "," << addressMode[1]
+       << " dom " << dom
+       ;
+
+    std::string str = ss.str();
+    return str ;
+}
+
+/**
+MockTexture::Alpha9
+---------------------
+
+Filtering weight in 9-bit fixed point with 8 bits of fraction,
+as used by the texture hardware.
+
+**/
+
+inline float MockTexture::Alpha9(float f)
+{
+    return std::floor( f*256.f + 0.5f )*(1.f/256.f) ;
+}
+
+inline int MockTexture::Address(int i, int n, int mode)
+{
+    if( i >= 0 && i < n ) return i ;
+    switch(mode)
+    {
+        case AddressWrap:   i = i % n ; if( i < 0 ) i += n ;                           break ;
+        case AddressMirror: i = i % (2*n) ; if( i < 0 ) i += 2*n ; if( i >= n ) i = 2*n - 1 - i ; break ;
+        case AddressBorder: i = -1 ;                                                     break ;
+        default:            i = i < 0 ? 0 : n - 1 ;                                       break ;
+    }
+    return i ;
+}
+
+inline int MockTexture::offset(int ix, int iy, int layer) const
+{
+    int mx = normalizedCoords ? addressMode[0] : ( addressMode[0] == AddressBorder ? AddressBorder : AddressClamp ) ;
+    int my = normalizedCoords ? addressMode[1] : ( addressMode[1] == AddressBorder ? AddressBorder : AddressClamp ) ;
+    int jx = Address(ix, width, mx );
+    int jy = Address(iy, height, my );
+    if( jx < 0 || jy < 0 ) return -1 ;
+    return int( ( (layer*height + jy)*width + jx )*channels ) ;
+}
+
+
+template<> inline float  MockTexture::Make<float>( const float* v){ return v[0] ; }
+template<> inline float2 MockTexture::Make<float2>(const float* v){ return make_float2(v[0], v[1]) ; }
+template<> inline float4 MockTexture::Make<float4>(const float* v){ return make_float4(v[0], v[1], v[2], v[3]) ; }
+template<> inline uchar4 MockTexture::Make<uchar4>(const float* v){ return make_uchar4(v[0], v[1], v[2], v[3]) ; }
+
+
+/**
+MockTexture::lookup
+---------------------
+
+x, y are normalized coordinates (0:1 across the texture) or
+texel coordinates (0:width, 0:height) depending on normalizedCoords.
+
+**/
+
+template<typename T>
+inline T MockTexture::lookup(float x, float y, int layer ) const
+{
+    int nc = channels ;
+    float fx = normalizedCoords ? x*float(width)  : x ;
+    float fy = normalizedCoords ? y*float(height) : y ;
+    layer = std::min( std::max( layer, 0 ), int(layers) - 1 ) ;
 
-    std::string str = ss.str(); 
-    return str ; 
+    float v[4] = { 0.f, 0.f, 0.f, 0.f } ;
+
+    if( filterMode == 'P' )
+    {
+        int o = offset( int(std::floor(fx)), int(std::floor(fy)), layer ) ;
+        if( o > -1 ) for(int c=0 ; c < nc ; c++) v[c] = data[o+c] ;
+    }
+    else
+    {
+        float xb = fx - 0.5f ;
+        float yb = fy - 0.5f ;
+        float x0 = std::floor(xb) ;
+        float y0 = std::floor(yb) ;
+        float ax = Alpha9( xb - x0 ) ;
+        float ay = Alpha9( yb - y0 ) ;
+        int ix = int(x0) ;
+        int iy = int(y0) ;
+
+        int   oo[4] = { offset(ix, iy, layer), offset(ix+1, iy, layer), offset(ix, iy+1, layer), offset(ix+1, iy+1, layer) } ;
+        float ww[4] = { (1.f-ax)*(1.f-ay), ax*(1.f-ay), (1.f-ax)*ay, ax*ay } ;
+
+        for(int t=0 ; t < 4 ; t++)
+        {
+            if( oo[t] < 0 ) continue ;  // border texels are zero
+            for(int c=0 ; c < nc ; c++) v[c] += ww[t]*data[oo[t]+c] ;
+        }
+    }
+    return Make<T>(v) ;
 }
 
-template<typename T> 
-inline T MockTexture::lookup(float x, float y ) const
+/**
+MockTexture::lookup_batch
+---------------------------
+
+out[i] = lookup<T>(x[i], y[i], layer) for i in 0:n
+
+**/
+
+template<typename T>
+inline void MockTexture::lookup_batch(T* out, const float* x, const float* y, int n, int layer ) const
 {
-    const T* vv = a->cvalues<T>() ; 
-    int nx = width ; 
-    int ny = height ; 
+    if( filterMode == 'P' )
+    {
+        for(int i=0 ; i < n ; i++) out[i] = lookup<T>(x[i], y[i], layer) ;
+        return ;
+    }
 
-    int ix = int(x*float(nx)) ;  // NB no subtraction of 0.5f to get match 
-    int iy = int(y*float(ny)) ; 
-    int idx = iy*nx + ix ; 
+    int nc = channels ;
+    layer = std::min( std::max( layer, 0 ), int(layers) - 1 ) ;
+    float sx = normalizedCoords ? float(width)  : 1.f ;
+    float sy = normalizedCoords ? float(height) : 1.f ;
 
-    T v0 = vv[idx] ;     // hmm should be interpolating between v0 and v1 presumably 
-    //T v1 = vv[idx+1] ;  // can this go beyond the array ?
-    return v0  ; 
+    float ax[BLOCK], ay[BLOCK] ;
+    int   ix[BLOCK], iy[BLOCK] ;
+
+    for(int i0=0 ; i0 < n ; i0 += BLOCK)
+    {
+        int nb = std::min( BLOCK, n - i0 ) ;
+
+        for(int b=0 ; b < nb ; b++)   // weights : branch free
+        {
+            float xb = x[i0+b]*sx - 0.5f ;
+            float yb = y[i0+b]*sy - 0.5f ;
+            float x0 = std::floor(xb) ;
+            float y0 = std::floor(yb) ;
+            ax[b] = std::floor( (xb - x0)*256.f + 0.5f )*(1.f/256.f) ;
+            ay[b] = std::floor( (yb - y0)*256.f + 0.5f )*(1.f/256.f) ;
+            ix[b] = int(x0) ;
+            iy[b] = int(y0) ;
+        }
+
+        for(int b=0 ; b < nb ; b++)   // gather and blend
+        {
+            int   oo[4] = { offset(ix[b], iy[b], layer), offset(ix[b]+1, iy[b], layer), offset(ix[b], iy[b]+1, layer), offset(ix[b]+1, iy[b]+1, layer) } ;
+            float ww[4] = { (1.f-ax[b])*(1.f-ay[b]), ax[b]*(1.f-ay[b]), (1.f-ax[b])*ay[b], ax[b]*ay[b] } ;
+            float v[4] = { 0.f, 0.f, 0.f, 0.f } ;
+            for(int t=0 ; t < 4 ; t++)
+            {
+                if( oo[t] < 0 ) continue ;
+                for(int c=0 ; c < nc ; c++) v[c] += ww[t]*data[oo[t]+c] ;
+            }
+            out[i0+b] = Make<T>(v) ;
+        }
+    }
 }
 
-template<typename T> 
+template<typename T>
 inline std::string MockTexture::dump() const
 {
-    std::stringstream ss ; 
-    ss << "MockTexture::dump<" <<  (sizeof(T) == 16 ? "float4" : "float" ) << ">" << std::endl ;    
-    const T* vv = a->cvalues<T>() ; 
+    std::stringstream ss ;
+    ss << "MockTexture::dump<" <<  (sizeof(T) == 16 ? "float4" : "float" ) << ">" << std::endl ;
+    const T* vv = (const T*)data ;
     for(NP::INT i=0 ; i < std::min(NP::INT(10), width*height) ; i++)
     {
-        ss << " *(vv+" << std::setw(3) << i << ") : " << *(vv+i) << std::endl; 
+        ss << " *(vv+" << std::setw(3) << i << ") : " << *(vv+i) << std::endl;
     }
-    std::string str = ss.str(); 
-    return str ; 
+    std::string str = ss.str();
+    return str ;
 }
 
 
 
-struct MockTextureManager 
+struct MockTextureManager
 {
-    static MockTextureManager* INSTANCE ; 
-    static MockTextureManager* Get(); 
-    static MockTexture Get(cudaTextureObject_t tex); 
-    static cudaTextureObject_t Add(const NP* a ); 
+    static MockTextureManager* INSTANCE ;
+    static MockTextureManager* Get();
+    static const MockTexture& Get(cudaTextureObject_t tex);
+    static cudaTextureObject_t Add(const NP* a );
+    static cudaTextureObject_t Add(const NP* a, const float* data, NP::INT width, NP::INT height, NP::INT channels, char filterMode, bool normalizedCoords, int addressMode=MockTexture::AddressWrap, NP::INT layers=1 );
 
-    std::vector<MockTexture> tt ; 
+    std::vector<MockTexture> tt ;
 
     MockTextureManager() ;
+    ~MockTextureManager() ;
 
-    cudaTextureObject_t add( const NP* a ); 
-
-    static std::string Desc(); 
-    std::string desc() const ; 
-    MockTexture get(cudaTextureObject_t tex ) const ; 
+    cudaTextureObject_t add( const MockTexture& tex );
 
-    template<typename T> T tex2D( cudaTextureObject_t t, float x, float y ) const  ; 
+    static std::string Desc();
+    std::string desc() const ;
+    const MockTexture& get(cudaTextureObject_t tex ) const ;
 
-    float4 boundary_lookup(cudaTextureObject_t tex,  float nm, int line, int k ) const ; 
+    template<typename T> T tex2D( cudaTextureObject_t t, float x, float y ) const  ;
+    template<typename T> T tex2DLayered( cudaTextureObject_t t, float x, float y, int layer ) const  ;
+    template<typename T> void tex2D_batch( cudaTextureObject_t t, T* out, const float* x, const float* y, int n ) const  ;
 
-    template<typename T> std::string dump(cudaTextureObject_t tex) const ; 
+    template<typename T> std::string dump(cudaTextureObject_t tex) const ;
 };
 
 
-inline MockTextureManager* MockTextureManager::Get()  // static 
+inline MockTextureManager* MockTextureManager::Get()  // static
 {
-    return INSTANCE ; 
+    return INSTANCE ;
 }
 
 inline MockTextureManager::MockTextureManager()
 {
-    INSTANCE = this ; 
+    INSTANCE = this ;
+}
+
+inline MockTextureManager::~MockTextureManager()
+{
+    for(size_t i=0 ; i < tt.size() ; i++) if(tt[i].owned) delete tt[i].a ;
+    if( INSTANCE == this ) INSTANCE = nullptr ;
 }
 
-inline MockTexture MockTextureManager::Get(cudaTextureObject_t obj) // static
+inline const MockTexture& MockTextureManager::Get(cudaTextureObject_t obj) // static
 {
-    assert(INSTANCE); 
-    return INSTANCE->get(obj) ; 
+    assert(INSTANCE);
+    return INSTANCE->get(obj) ;
 }
 inline cudaTextureObject_t MockTextureManager::Add(const NP* a )
 {
-    if(INSTANCE == nullptr) new MockTextureManager ; 
-    assert(INSTANCE); 
-    return INSTANCE->add(a); 
+    if(INSTANCE == nullptr) new MockTextureManager ;
+    assert(INSTANCE);
+    return INSTANCE->add(MockTexture(a));
+}
+inline cudaTextureObject_t MockTextureManager::Add(const NP* a, const float* data, NP::INT width, NP::INT height, NP::INT channels, char filterMode, bool normalizedCoords, int addressMode, NP::INT layers )
+{
+    if(INSTANCE == nullptr) new MockTextureManager ;
+    assert(INSTANCE);
+    return INSTANCE->add(MockTexture(a, data, width, height, channels, filterMode, normalizedCoords, addressMode, layers));
 }
 
-inline cudaTextureObject_t MockTextureManager::add(const NP* a )
+inline cudaTextureObject_t MockTextureManager::add(const MockTexture& tex )
 {
-    cudaTextureObject_t idx = tt.size() ; 
-    MockTexture tex(a) ; 
-    tt.push_back(tex); 
-    return idx ; 
+    cudaTextureObject_t idx = tt.size() ;
+    tt.push_back(tex);
+    return idx ;
 }
 
 inline std::string MockTextureManager::Desc() // static
 {
-    return INSTANCE ? INSTANCE->desc() : "-" ; 
+    return INSTANCE ? INSTANCE->desc() : "-" ;
 }
-inline std::string MockTextureManager::desc() const 
+inline std::string MockTextureManager::desc() const
 {
-    int num_tex = tt.size(); 
+    int num_tex = tt.size();
     std::stringstream ss ;
-    ss << "MockTextureManager::desc num_tex " << num_tex << std::endl ; 
-    for(int i=0 ; i < num_tex ; i++) ss << std::setw(4) << i << " : " << tt[i].desc() << std::endl ;  
-    std::string str = ss.str(); 
-    return str ; 
+    ss << "MockTextureManager::desc num_tex " << num_tex << std::endl ;
+    for(int i=0 ; i < num_tex ; i++) ss << std::setw(4) << i << " : " << tt[i].desc() << std::endl ;
+    std::string str = ss.str();
+    return str ;
 }
 
-inline MockTexture MockTextureManager::get(cudaTextureObject_t t ) const
+inline const MockTexture& MockTextureManager::get(cudaTextureObject_t t ) const
 {
-    assert( t < tt.size() ); 
-    return tt[t] ; 
+    assert( t < tt.size() );
+    return tt[t] ;
 }
 
-template<typename T> 
+template<typename T>
 inline std::string MockTextureManager::dump( cudaTextureObject_t t ) const
 {
-    MockTexture tex = get(t) ; 
-    return tex.dump<T>(); 
+    return get(t).dump<T>();
 }
 
-template<typename T> 
-inline T MockTextureManager::tex2D( cudaTextureObject_t t, float x, float y ) const 
+template<typename T>
+inline T MockTextureManager::tex2D( cudaTextureObject_t t, float x, float y ) const
 {
-    MockTexture tex = get(t) ; 
-    return tex.lookup<T>(x,y) ; 
+    return get(t).lookup<T>(x,y) ;
 }
 
-template<typename T> T tex2D(cudaTextureObject_t t, float x, float y )
+template<typename T>
+inline T MockTextureManager::tex2DLayered( cudaTextureObject_t t, float x, float y, int layer ) const
+{
+    return get(t).lookup<T>(x,y,layer) ;
+}
+
+template<typename T>
+inline void MockTextureManager::tex2D_batch( cudaTextureObject_t t, T* out, const float* x, const float* y, int n ) const
+{
+    get(t).lookup_batch<T>(out, x, y, n) ;
+}
+
+
+inline MockTextureManager* MockTextureManager_Check()
 {
-    MockTextureManager* mgr = MockTextureManager::Get() ; 
-    if( mgr == nullptr ) 
+    MockTextureManager* mgr = MockTextureManager::Get() ;
+    if( mgr == nullptr )
     {
-         std::cerr 
+         std::cerr
              << "s_mock_texture.h/tex2D : FATAL : null MockTextureManager "
-             << std::endl 
+             << std::endl
              << " manager is instanciated when adding MOCK texture arrays with MockTextureManager::Add "
-             << std::endl 
-             ; 
-        assert(0);   
+             << std::endl
+             ;
+        assert(0);
     }
-    return mgr->tex2D<T>( t, x, y ); 
+    return mgr ;
 }
 
+template<typename T> T tex2D(cudaTextureObject_t t, float x, float y )
+{
+    return MockTextureManager_Check()->tex2D<T>( t, x, y );
+}
+
+template<typename T> T tex2DLayered(cudaTextureObject_t t, float x, float y, int layer )
+{
+    return MockTextureManager_Check()->tex2DLayered<T>( t, x, y, layer );
+}
 
@@ -0,0 +1,363 @@
+#pragma once
+/**
+s_seqpager.h : lazily memory mapped chunks of precooked randoms
+=================================================================
+
+Loading precooked randoms with NP::Load reads all the chunk files of
+the sequence folder into memory, concatenating them. With (ni,16,16)
+float randoms that is 1kB per photon, capping the number of photons
+usable for aligned running at what fits in memory.
+
+s_seqpager instead only reads the headers of the .npy chunk files,
+in the U::DirList sorted order used by NP::Load, and memory maps
+chunks as their items are accessed. At most *max_resident* chunks are
+mapped at once with the least recently used chunk unmapped to make room,
+so memory is flat no matter the total number of items.
+
+Each chunk also has per-item int cursors, allocated on first access
+to the chunk. When a chunk is unmapped its cursors are released if none
+of its items were consumed, otherwise they are retained as the
+consumption state must persist, eg for reemission continuing the stream
+of the same photon. So the limit is 4 bytes per item of the chunks with
+consumed items, compared to the 4*nv bytes of the randoms : eg 4GB of
+cursors for 1e9 consumed items. When that matters call reset_cursors
+between events, as U4Random::setSequenceIndex streams normally start
+afresh for each event.
+
+The *path* can be a single .npy file, which is then a single chunk,
+or a directory of .npy chunk files that must all have the same item shape.
+
+Usage::
+
+    s_seqpager* pg = s_seqpager::Create(path, 2);
+    int* cursor = nullptr ;
+    const float* rr = pg->item(idx, &cursor);   // nv values for item idx
+    float u = rr[(*cursor)++ % pg->nv] ;
+
+**/
+
+#include <cstring>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "NP.hh"
+
+struct s_seqpager
+{
+    typedef unsigned long long ULL ;
+
+    struct Chunk
+    {
+        std::string path ;
+        ULL   i0 ;                // global index of first item
+        ULL   ni ;                // number of items
+        ULL   hdr ;               // header bytes before the data
+        void* map ;
+        ULL   map_size ;
+        const float* values ;
+        ULL   last_use ;
+        std::vector<int> cursor ;
+    };
+
+    static constexpr const char* _MAX_RESIDENT = "s_seqpager__MAX_RESIDENT" ;
+
+    const char* path ;
+    unsigned max_resident ;
+    ULL      ni ;        // total items over all chunks
+    int      nv ;        // values per item
+    std::vector<Chunk> chunks ;
+    std::vector<int>   resident ;
+    int      last ;      // chunk of the last access
+    ULL      use_count ;
+    ULL      num_map ;
+    ULL      num_unmap ;
+
+    static s_seqpager* Create(const char* path, unsigned max_resident=0);
+
+    s_seqpager(const char* path, unsigned max_resident);
+    ~s_seqpager();
+
+    bool init();
+    bool add_chunk(const char* chunk_path);
+    bool is_ready() const ;
+
+    int  find_chunk(ULL idx) const ;
+    bool map_chunk(int c);
+    void unmap_chunk(int c);
+    void touch(int c);
+
+    const float* item(ULL idx, int** cursor=nullptr);
+    void reset_cursors();
+    ULL  resident_bytes() const ;
+    ULL  cursor_bytes() const ;
+    std::string desc() const ;
+};
+
+
+inline s_seqpager* s_seqpager::Create(const char* _path, unsigned _max_resident) // static
+{
+    s_seqpager* pg = new s_seqpager(_path, _max_resident) ;
+    if(pg->is_ready()) return pg ;
+    delete pg ;
+    return nullptr ;
+}
+
+inline s_seqpager::s_seqpager(const char* _path, unsigned _max_resident)
+    :
+    path(_path ? strdup(_path) : nullptr),
+    max_resident(_max_resident > 0 ? _max_resident : std::max(1, U::GetEnvInt(_MAX_RESIDENT, 2))),
+    ni(0),
+    nv(0),
+    last(-1),
+    use_count(0),
+    num_map(0),
+    num_unmap(0)
+{
+    init();
+}
+
+inline s_seqpager::~s_seqpager()
+{
+    for(unsigned c=0 ; c < chunks.size() ; c++) unmap_chunk(c);
+    free((void*)path);
+}
+
+inline bool s_seqpager::init()
+{
+    if(path == nullptr) return false ;
+    if(U::EndsWith(path, ".npy")) return add_chunk(path) ;
+
+    std::vector<std::string> nms ;
+    U::DirList(nms, path, ".npy");
+    for(unsigned i=0 ; i < nms.size() ; i++)
+    {
+        std::string p = std::string(path) + "/" + nms[i] ;
+        if(!add_chunk(p.c_str())) return false ;
+    }
+    return true ;
+}
+
+/**
+s_seqpager::add_chunk
+-----------------------
+
+Reads just the header using the NP nodata "@" prefix.
+
+**/
+
+inline bool s_seqpager::add_chunk(const char* chunk_path)
+{
+    std::string np = std::string("@") + chunk_path ;
+    NP* a = NP::Load_(np.c_str()) ;
+    if(a == nullptr) return false ;
+
+    bool expected = a->uifc == 'f' && a->ebyte == 4 && a->shape.size() > 1 ;
+    int _nv = 1 ;
+    for(unsigned d=1 ; d < a->shape.size() ; d++) _nv *= a->shape[d] ;
+    bool consistent = nv == 0 || nv == _nv ;
+
+    if(!expected || !consistent) std::cerr
+        << "s_seqpager::add_chunk UNEXPECTED"
+        << " chunk_path " << chunk_path
+        << " sstr " << a->sstr()
+        << " dtype " << a->dtype
+        << " nv " << nv
+        << " _nv " << _nv
+        << "\n"
+        ;
+
+    if(!expected || !consistent)
+    {
+        delete a ;
+        return false ;
+    }
+
+    Chunk ch = {} ;
+    ch.path = chunk_path ;
+    ch.i0 = ni ;
+    ch.ni = a->shape[0] ;
+    ch.hdr = a->hdr_bytes() ;
+    ch.map = nullptr ;
+    ch.map_size = 0 ;
+    ch.values = nullptr ;
+    ch.last_use = 0 ;
+
+    chunks.push_back(ch);
+    nv = _nv ;
+    ni += ch.ni ;
+    delete a ;
+    return true ;
+}
+
+inline bool s_seqpager::is_ready() const
+{
+    return ni > 0 && nv > 0 ;
+}
+
+inline int s_seqpager::find_chunk(ULL idx) const
+{
+    if( idx >= ni ) return -1 ;
+    int lo = 0 ;
+    int hi = chunks.size() ;
+    while( hi - lo > 1 )
+    {
+        int mid = (lo + hi)/2 ;
+        if( chunks[mid].i0 <= idx ) lo = mid ; else hi = mid ;
+    }
+    return lo ;
+}
+
+/**
+s_seqpager::map_chunk
+-----------------------
+
+Maps the entire file, the values start after the header.
+MADV_RANDOM as access is per item, not sequential.
+
+**/
+
+inline bool s_seqpager::map_chunk(int c)
+{
+    Chunk& ch = chunks[c] ;
+    if( ch.map ) return true ;
+
+    if( resident.size() >= max_resident )
+    {
+        int lru = resident[0] ;
+        for(unsigned i=1 ; i < resident.size() ; i++) if( chunks[resident[i]].last_use < chunks[lru].last_use ) lru = resident[i] ;
+        unmap_chunk(lru);
+    }
+
+    int fd = open(ch.path.c_str(), O_RDONLY);
+    if( fd < 0 ) std::cerr << "s_seqpager::map_chunk unable to open [" << ch.path << "]\n" ;
+    if( fd < 0 ) return false ;
+
+    struct stat st ;
+    fstat(fd, &st);
+    ULL expect_size = ch.hdr + ch.ni*nv*sizeof(float) ;
+    bool size_ok = ULL(st.st_size) >= expect_size ;
+    if(!size_ok) std::cerr << "s_seqpager::map_chunk truncated [" << ch.path << "] st_size " << st.st_size << " expect " << expect_size << "\n" ;
+
+    void* m = size_ok ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 ) : MAP_FAILED ;
+    close(fd);
+    if( m == MAP_FAILED ) return false ;
+    madvise(m, st.st_size, MADV_RANDOM);
+
+    ch.map = m ;
+    ch.map_size = st.st_size ;
+    ch.values = (const float*)( (const char*)m + ch.hdr ) ;
+    if( ch.cursor.empty() ) ch.cursor.resize(ch.ni, 0) ;
+
+    resident.push_back(c);
+    num_map += 1 ;
+    return true ;
+}
+
+inline void s_seqpager::unmap_chunk(int c)
+{
+    Chunk& ch = chunks[c] ;
+    if( ch.map == nullptr ) return ;
+    munmap(ch.map, ch.map_size);
+    ch.map = nullptr ;
+    ch.map_size = 0 ;
+    ch.values = nullptr ;
+    resident.erase( std::remove(resident.begin(), resident.end(), c), resident.end() );
+    if( last == c ) last = -1 ;
+    num_unmap += 1 ;
+
+    bool consumed = std::any_of( ch.cursor.begin(), ch.cursor.end(), [](int cur){ return cur != 0 ; } );
+    if(!consumed) std::vector<int>().swap(ch.cursor) ;
+}
+
+inline void s_seqpager::touch(int c)
+{
+    use_count += 1 ;
+    chunks[c].last_use = use_count ;
+    last = c ;
+}
+
+/**
+s_seqpager::item
+------------------
+
+Returns pointer to the *nv* values of item *idx*, mapping its chunk
+when not resident, or nullptr when *idx* is out of range.
+The optional *cursor* is set to point at the cursor of the item.
+
+The pointer remains valid until a subsequent access to another
+chunk evicts the chunk of this item.
+
+**/
+
+inline const float* s_seqpager::item(ULL idx, int** cursor)
+{
+    int c = last > -1 && idx - chunks[last].i0 < chunks[last].ni ? last : find_chunk(idx) ;
+    if( c < 0 ) return nullptr ;
+    if( !map_chunk(c) ) return nullptr ;
+    touch(c);
+
+    Chunk& ch = chunks[c] ;
+    ULL j = idx - ch.i0 ;
+    if(cursor) *cursor = ch.cursor.data() + j ;
+    return ch.values + j*nv ;
+}
+
+/**
+s_seqpager::reset_cursors
+---------------------------
+
+Releases the cursors of all chunks that are not resident and zeros
+those of the resident chunks, restarting the streams of all items.
+
+**/
+
+inline void s_seqpager::reset_cursors()
+{
+    for(unsigned c=0 ; c < chunks.size() ; c++)
+    {
+        Chunk& ch = chunks[c] ;
+        if( ch.map ) std::fill( ch.cursor.begin(), ch.cursor.end(), 0 );
+        else std::vector<int>().swap(ch.cursor) ;
+    }
+}
+
+inline s_seqpager::ULL s_seqpager::cursor_bytes() const
+{
+    ULL tot = 0 ;
+    for(unsigned c=0 ; c < chunks.size() ; c++) tot += chunks[c].cursor.capacity()*sizeof(int) ;
+    return tot ;
+}
+
+inline s_seqpager::ULL s_seqpager::resident_bytes() const
+{
+    ULL tot = 0 ;
+    for(unsigned i=0 ; i < resident.size() ; i++) tot += chunks[resident[i]].map_size ;
+    return tot ;
+}
+
+inline std::string s_seqpager::desc() const
+{
+    std::stringstream ss ;
+    ss << "s_seqpager::desc"
+       << " path " << ( path ? path : "-" )
+       << " num_chunk " << chunks.size()
+       << " ni " << ni
+       << " nv " << nv
+       << " max_resident " << max_resident
+       << " resident " << resident.size()
+       << " resident_bytes " << resident_bytes()
+       << " cursor_bytes " << cursor_bytes()
+       << " num_map " << num_map
+       << " num_unmap " << num_unmap
+       ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,229 @@
+#pragma once
+/**
+sarena.h : pooled hostside storage for SEvt per-photon output arrays
+======================================================================
+
+Replaces the std::vector members of SEvt that were formerly resized
+(and shrink_to_fit) for every event in SEvt::hostside_running_resize_.
+That approach reallocated the photon/record/rec/seq/aux/sup buffers
+for every event giving allocation churn and RSS growth over long runs,
+as visible in SProf::Delta_RS.
+
+Instead each sarena holds a single char buffer whose capacity only ever
+grows, up to the limit from SEventConfig maxima (*max_item*),
+and which is reused across events:
+
+clear
+    O(1) per-event reset, sets the active item count to zero
+    keeping the capacity
+
+resize
+    sets the active item count with std::vector::resize semantics,
+    existing items are preserved and added items are zeroed,
+    no reallocation unless exceeding the high water mark.
+    This matters as U4 hostside running resizes repeatedly within
+    an event as gensteps are collected
+
+lend
+    zero-copy gather : the buffer is swapped into the NP array data
+    so the array views the arena memory without copying
+
+reclaim
+    swaps the buffer back from the lent array, must be done before
+    the array is deleted, see SEvt::clear_output_vector which is
+    called prior to the NPFold::clear_except of the topfold.
+    When the lent array can no longer be found in the fold the
+    buffer is regarded as lost and a fresh one is allocated at
+    the next resize.
+
+While lent the arena has no storage, so hostside running
+must not continue to write into the arena between gather and clear.
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+#include "NP.hh"
+#include "NPFold.h"
+
+template<typename T>
+struct sarena
+{
+    static constexpr const size_t ITEM = sizeof(T) ;
+
+    std::vector<char> buf ;
+    size_t num ;          // active items
+    size_t max_item ;     // capacity limit from SEventConfig, 0:no limit
+    NP*    lent ;         // array currently holding the buffer
+    int    num_alloc ;    // count of reallocations : should stay small
+    int    num_lend ;
+    int    num_reclaim ;
+
+    sarena();
+
+    void set_max_item(size_t _max_item);
+    void reserve(size_t n);
+    void resize(size_t n);
+    void clear();
+
+    size_t size() const ;
+    size_t capacity() const ;
+    bool   empty() const ;
+
+    T*       data() ;
+    const T* data() const ;
+    T&       operator[](size_t i);
+    const T& operator[](size_t i) const ;
+
+    void lend(NP* a);
+    bool reclaim(const NPFold* fold, const char* key);
+
+    std::string desc() const ;
+};
+
+template<typename T>
+inline sarena<T>::sarena()
+    :
+    num(0),
+    max_item(0),
+    lent(nullptr),
+    num_alloc(0),
+    num_lend(0),
+    num_reclaim(0)
+{
+}
+
+template<typename T>
+inline void sarena<T>::set_max_item(size_t _max_item)
+{
+    max_item = _max_item ;
+}
+
+/**
+sarena::reserve
+-----------------
+
+Grows capacity geometrically up to max_item, so a sequence of events
+with increasing photon counts settles quickly to the high water mark.
+
+**/
+
+template<typename T>
+inline void sarena<T>::reserve(size_t n)
+{
+    if( n*ITEM <= buf.capacity() ) return ;
+    size_t cap = std::max( n, 2*buf.capacity()/ITEM ) ;
+    if( max_item > 0 && cap > max_item ) cap = std::max( n, max_item ) ;
+    buf.reserve( cap*ITEM );
+    num_alloc += 1 ;
+}
+
+template<typename T>
+inline void sarena<T>::resize(size_t n)
+{
+    assert( lent == nullptr );
+    reserve(n);
+    buf.resize( n*ITEM );   // preserves existing items, zero fills any added items
+    num = n ;
+}
+
+template<typename T>
+inline void sarena<T>::clear()
+{
+    buf.resize(0) ;   // keeps capacity
+    num = 0 ;
+}
+
+template<typename T> inline size_t sarena<T>::size() const {     return num ; }
+template<typename T> inline size_t sarena<T>::capacity() const { return buf.capacity()/ITEM ; }
+template<typename T> inline bool   sarena<T>::empty() const {    return num == 0 ; }
+
+template<typename T> inline T*       sarena<T>::data() {       return num > 0 ? (T*)buf.data() : nullptr ; }
+template<typename T> inline const T* sarena<T>::data() const { return num > 0 ? (const T*)buf.data() : nullptr ; }
+
+template<typename T> inline T&       sarena<T>::operator[](size_t i) {       assert( i < num ); return *((T*)buf.data() + i) ; }
+template<typename T> inline const T& sarena<T>::operator[](size_t i) const { assert( i < num ); return *((const T*)buf.data() + i) ; }
+
+/**
+sarena::lend
+--------------
+
+The array *a* must have been created with zero items, eg NP::Make<float>(0,4,4)
+for sphoton. The array item can hold multiple T, eg record arrays
+with shape (0,max_record,4,4) hold max_record sphoton per item.
+After the swap the array views the arena buffer.
+
+**/
+
+template<typename T>
+inline void sarena<T>::lend(NP* a)
+{
+    assert( lent == nullptr );
+    assert( a && a->shape.size() > 0 && a->shape[0] == 0 );
+
+    size_t nbyte = num*ITEM ;
+    size_t item_bytes = a->item_bytes() ;
+    assert( item_bytes > 0 && nbyte % item_bytes == 0 );
+    size_t ni = nbyte/item_bytes ;
+
+    a->swap_data( buf, ni );
+    lent = a ;
+    num = 0 ;
+    num_lend += 1 ;
+}
+
+/**
+sarena::reclaim
+-----------------
+
+Only swaps the buffer back when the lent array is still present
+within the fold, avoiding touching an array that may have been
+deleted by other means.
+
+**/
+
+template<typename T>
+inline bool sarena<T>::reclaim(const NPFold* fold, const char* key)
+{
+    if( lent == nullptr ) return false ;
+
+    std::vector<const NP*> rr ;
+    std::vector<std::string> tt ;
+    if(fold) fold->find_arrays_with_key_r(rr, tt, key);
+
+    bool found = std::find( rr.begin(), rr.end(), lent ) != rr.end() ;
+    if(found)
+    {
+        std::vector<char> empty ;
+        lent->swap_data( empty, 0 );
+        buf.swap(empty);
+        buf.resize(0);
+        num_reclaim += 1 ;
+    }
+    lent = nullptr ;
+    num = 0 ;
+    return found ;
+}
+
+template<typename T>
+inline std::string sarena<T>::desc() const
+{
+    std::stringstream ss ;
+    ss << "sarena"
+       << " ITEM " << ITEM
+       << " num " << num
+       << " capacity " << capacity()
+       << " max_item " << max_item
+       << " lent " << ( lent ? "Y" : "N" )
+       << " num_alloc " << num_alloc
+       << " num_lend " << num_lend
+       << " num_reclaim " << num_reclaim
+       ;
+    std::string str = ss.str();
+    return str ;
+}
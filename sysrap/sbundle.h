@@ -0,0 +1,737 @@
+#pragma once
+/**
+sbundle.h : single file memory mapped bundle of a directory tree of .npy and .txt files
+=========================================================================================
+
+Loading a persisted CSGFoundry directory with NPFold and CSGFoundry::loadArray
+opens, reads and parses many small files. That is slow on shared or networked
+filesystems. A bundle holds the same files in one file that is opened with a
+single mmap and needs no parsing of the array headers.
+
+Layout::
+
+    sbundle_header           64 bytes : magic, version, section count, table checksum, file bytes
+    sbundle_section[num]    256 bytes each : one per file of the directory form
+    ...                      file bytes of each section, placed such that array data
+                             (after the npy header) starts at an ALIGN multiple
+
+Each section holds the unchanged bytes of one file keyed by its path relative
+to the bundled directory, eg "solid.npy" "SSim/stree/nds.npy" "meshname.txt".
+For .npy sections the table also records the dtype, shape and header length
+parsed when the bundle is created, so accessing array data needs only a table
+lookup.
+
+Create
+    directory form to bundle
+
+Open
+    mmap the bundle, checks the header, table checksum and file size,
+    with sbundle__VERIFY (default 1) also checks every section checksum
+
+extract
+    bundle to directory form, bytes are identical to those bundled
+
+copy/view
+    POD array access with no parsing, copy resizes and memcpy into a vector
+
+array/fold
+    NP and NPFold from the sections, following NPFold::load using the
+    NPFold_index.txt when present
+
+**/
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <unordered_map>
+#include <cassert>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ssys.h"
+#include "NPFold.h"
+
+struct sbundle_header
+{
+    char     magic[8] ;
+    uint32_t version ;
+    uint32_t num_section ;
+    uint64_t align ;
+    uint64_t table_checksum ;
+    uint64_t file_bytes ;
+    uint64_t reserved[3] ;
+};
+
+struct sbundle_section
+{
+    static constexpr const int KEY = 160 ;
+    static constexpr const int NDIM = 6 ;
+
+    char     key[KEY] ;     // path relative to the bundled directory
+    char     descr[8] ;     // npy dtype eg "<f4", empty for non-array sections
+    uint64_t offset ;       // of the section bytes from start of file
+    uint64_t bytes ;        // of the whole section including any npy header
+    uint64_t checksum ;     // of the section bytes
+    uint32_t hdr ;          // npy header bytes, data starts at offset + hdr
+    int32_t  nd ;           // number of dimensions, -1 for non-array sections
+    int64_t  shape[NDIM] ;
+
+    bool is_array() const { return nd > -1 ; }
+    uint64_t data_offset() const { return offset + hdr ; }
+    uint64_t data_bytes() const { return bytes - hdr ; }
+};
+
+struct sbundle
+{
+    static constexpr const char* MAGIC = "SBUNDLE" ;
+    static constexpr const uint32_t VERSION = 1 ;
+    static constexpr const uint64_t ALIGN = 64 ;
+    static constexpr const char* EXT = ".bundle" ;
+    static constexpr const char* sbundle__VERIFY = "sbundle__VERIFY" ;
+    static constexpr const char* sbundle__DUMP = "sbundle__DUMP" ;
+
+    const char* path ;
+    int         fd ;
+    const char* base ;
+    uint64_t    file_bytes ;
+
+    const sbundle_header*  header ;
+    const sbundle_section* table ;
+    std::unordered_map<std::string, int> index ;
+
+    static uint64_t Checksum(const char* p, uint64_t n);
+    static uint64_t AlignUp(uint64_t x, uint64_t a);
+    static std::string Join(const char* prefix, const char* key);
+    static bool IsNPY(const char* key);
+    static std::string Sidecar(const char* key, const char* ext);
+
+    static void Collect(std::vector<std::string>& keys, const char* dir, const char* rel);
+    static bool ReadFile(std::string& buf, const char* path);
+    static int  Create(const char* path, const char* dir);
+
+    static sbundle* Open(const char* path, bool verify_sections=true);
+    static sbundle* Load(const char* path);
+
+    sbundle(const char* path);
+    ~sbundle();
+
+    int  open_();
+    bool verify(int i) const ;
+    int  verify() const ;
+
+    int  num_section() const ;
+    int  find(const char* key) const ;
+    bool has(const char* key) const ;
+    const sbundle_section* section(const char* key) const ;
+    const char* bytes(const sbundle_section* s) const ;
+
+    template<typename T> const T* view(const char* key, int64_t* ni=nullptr) const ;
+    template<typename T> int copy(std::vector<T>& vec, const char* key) const ;
+
+    std::string text(const char* key) const ;
+    std::string string(const char* key) const ;
+    int lines(std::vector<std::string>& ll, const char* key) const ;
+
+    NP*     array(const char* key) const ;
+    NPFold* fold(const char* prefix=nullptr) const ;
+    bool    has_fold(const char* prefix) const ;
+
+    int extract(const char* dir) const ;
+
+    std::string desc() const ;
+};
+
+
+/**
+sbundle::Checksum
+-------------------
+
+FNV-1a over 64 bit words then tail bytes. Each step is a bijection of
+the running hash so any change confined to a single word is always detected.
+
+**/
+
+inline uint64_t sbundle::Checksum(const char* p, uint64_t n) // static
+{
+    const uint64_t prime = 0x100000001b3ull ;
+    uint64_t h = 0xcbf29ce484222325ull ;
+    uint64_t nw = n/8 ;
+    for(uint64_t i=0 ; i < nw ; i++)
+    {
+        uint64_t w ;
+        memcpy( &w, p + 8*i, 8 );
+        h ^= w ;
+        h *= prime ;
+    }
+    for(uint64_t i=8*nw ; i < n ; i++)
+    {
+        h ^= (unsigned char)p[i] ;
+        h *= prime ;
+    }
+    h ^= n ;
+    h ^= h >> 33 ;
+    h *= 0xff51afd7ed558ccdull ;
+    h ^= h >> 33 ;
+    return h ;
+}
+
+inline uint64_t sbundle::AlignUp(uint64_t x, uint64_t a) // static
+{
+    return ( x + a - 1 )/a*a ;
+}
+
+inline std::string sbundle::Join(const char* prefix, const char* key) // static
+{
+    std::string k ;
+    if(prefix && strlen(prefix) > 0)
+    {
+        k += prefix ;
+        k += "/" ;
+    }
+    k += key ;
+    return k ;
+}
+
+inline bool sbundle::IsNPY(const char* key) // static
+{
+    return U::EndsWith(key, ".npy") ;
+}
+
+inline std::string sbundle::Sidecar(const char* key, const char* ext) // static
+{
+    return U::ChangeExt(key, ".npy", ext );
+}
+
+
+/**
+sbundle::Collect
+------------------
+
+Recursively collects the relative paths of all files beneath dir, in the
+sorted order of U::DirList.
+
+**/
+
+inline void sbundle::Collect(std::vector<std::string>& keys, const char* dir, const char* rel) // static
+{
+    std::string d = Join(dir, rel ? rel : "") ;
+    std::vector<std::string> names ;
+    U::DirList(names, d.c_str(), nullptr, false, true) ;
+    for(unsigned i=0 ; i < names.size() ; i++)
+    {
+        const char* name = names[i].c_str() ;
+        std::string k = Join(rel, name) ;
+        int type = U::PathType(d.c_str(), name) ;
+        if( type == U::DIR_PATH )
+        {
+            Collect(keys, dir, k.c_str());
+        }
+        else if( type == U::FILE_PATH )
+        {
+            keys.push_back(k);
+        }
+    }
+}
+
+inline bool sbundle::ReadFile(std::string& buf, const char* path) // static
+{
+    std::ifstream fp(path, std::ios::in|std::ios::binary);
+    if(fp.fail()) return false ;
+    std::stringstream ss ;
+    ss << fp.rdbuf() ;
+    buf = ss.str() ;
+    return true ;
+}
+
+
+/**
+sbundle::Create
+-----------------
+
+Bundles all files beneath dir into a single file at path, the
+npy headers are parsed here once so loading never needs to.
+Returns non-zero on failure.
+
+**/
+
+inline int sbundle::Create(const char* path, const char* _dir) // static
+{
+    const char* dir = U::Resolve(_dir) ;
+    std::vector<std::string> keys ;
+    Collect(keys, dir, nullptr);
+    int num = keys.size() ;
+    if( num == 0 ) return 1 ;
+
+    std::vector<sbundle_section> tab(num) ;
+    std::vector<std::string> buf(num) ;
+
+    uint64_t cur = AlignUp( sizeof(sbundle_header) + num*sizeof(sbundle_section), ALIGN ) ;
+
+    for(int i=0 ; i < num ; i++)
+    {
+        const char* key = keys[i].c_str() ;
+        sbundle_section& s = tab[i] ;
+        memset( &s, 0, sizeof(sbundle_section) );
+
+        if( keys[i].size() >= sbundle_section::KEY )
+        {
+            std::cerr << "sbundle::Create key too long [" << key << "]\n" ;
+            return 2 ;
+        }
+        strncpy( s.key, key, sbundle_section::KEY - 1 );
+
+        std::string fpath = Join(dir, key) ;
+        if(!ReadFile(buf[i], fpath.c_str()))
+        {
+            std::cerr << "sbundle::Create failed to read [" << fpath << "]\n" ;
+            return 3 ;
+        }
+        const std::string& b = buf[i] ;
+
+        s.nd = -1 ;
+        s.hdr = 0 ;
+        if(IsNPY(key))
+        {
+            size_t nl = b.find('\n') ;
+            if( nl == std::string::npos )
+            {
+                std::cerr << "sbundle::Create invalid npy [" << fpath << "]\n" ;
+                return 4 ;
+            }
+            std::string h = b.substr(0, nl + 1) ;
+            std::vector<NP::INT> shape ;
+            std::string descr ;
+            char uifc ;
+            NP::INT ebyte ;
+            NPU::parse_header( shape, descr, uifc, ebyte, h );
+            if( int(shape.size()) > sbundle_section::NDIM || descr.size() >= sizeof(s.descr) )
+            {
+                std::cerr << "sbundle::Create unsupported npy [" << fpath << "]\n" ;
+                return 5 ;
+            }
+            s.hdr = nl + 1 ;
+            s.nd = shape.size() ;
+            for(int d=0 ; d < s.nd ; d++) s.shape[d] = shape[d] ;
+            strncpy( s.descr, descr.c_str(), sizeof(s.descr) - 1 );
+        }
+
+        s.bytes = b.size() ;
+        s.offset = AlignUp( cur + s.hdr, ALIGN ) - s.hdr ;
+        s.checksum = Checksum( b.data(), b.size() );
+        cur = s.offset + s.bytes ;
+    }
+
+    sbundle_header hd ;
+    memset( &hd, 0, sizeof(sbundle_header) );
+    strncpy( hd.magic, MAGIC, sizeof(hd.magic) );
+    hd.version = VERSION ;
+    hd.num_section = num ;
+    hd.align = ALIGN ;
+    hd.table_checksum = Checksum( (const char*)tab.data(), num*sizeof(sbundle_section) );
+    hd.file_bytes = cur ;
+
+    U::MakeDirsForFile(path);
+    std::ofstream fp(path, std::ios::out|std::ios::binary);
+    if(fp.fail()) return 6 ;
+
+    fp.write( (const char*)&hd, sizeof(sbundle_header) );
+    fp.write( (const char*)tab.data(), num*sizeof(sbundle_section) );
+
+    uint64_t pos = sizeof(sbundle_header) + num*sizeof(sbundle_section) ;
+    std::string pad ;
+    for(int i=0 ; i < num ; i++)
+    {
+        const sbundle_section& s = tab[i] ;
+        pad.assign( s.offset - pos, '\0' );
+        fp.write( pad.data(), pad.size() );
+        fp.write( buf[i].data(), buf[i].size() );
+        pos = s.offset + s.bytes ;
+    }
+    fp.close();
+    return fp.fail() ? 7 : 0 ;
+}
+
+
+/**
+sbundle::Open
+---------------
+
+Returns nullptr when the file is missing, truncated or its table
+or (when verifying) any section fails its checksum.
+
+**/
+
+inline sbundle* sbundle::Open(const char* path, bool verify_sections) // static
+{
+    sbundle* b = new sbundle(path) ;
+    int rc = b->open_() ;
+    if( rc == 0 && verify_sections ) rc = b->verify() ;
+    if( rc != 0 )
+    {
+        std::cerr << "sbundle::Open FAILED rc " << rc << " path [" << ( path ? path : "-" ) << "]\n" ;
+        delete b ;
+        return nullptr ;
+    }
+    return b ;
+}
+
+inline sbundle* sbundle::Load(const char* path) // static
+{
+    return Open(path, ssys::getenvint(sbundle__VERIFY, 1) > 0 ) ;
+}
+
+inline sbundle::sbundle(const char* path_)
+    :
+    path(path_ ? U::Resolve(path_) : nullptr),
+    fd(-1),
+    base(nullptr),
+    file_bytes(0),
+    header(nullptr),
+    table(nullptr)
+{
+}
+
+inline sbundle::~sbundle()
+{
+    if(base) munmap( (void*)base, file_bytes );
+    if(fd > -1) close(fd);
+}
+
+inline int sbundle::open_()
+{
+    if(path == nullptr) return 1 ;
+    fd = open(path, O_RDONLY) ;
+    if( fd < 0 ) return 2 ;
+
+    struct stat st ;
+    if( fstat(fd, &st) != 0 ) return 3 ;
+    file_bytes = st.st_size ;
+    if( file_bytes < sizeof(sbundle_header) ) return 4 ;
+
+    int flags = MAP_PRIVATE ;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE ;   // every page is read by the checksums and copies anyhow
+#endif
+    void* m = mmap( nullptr, file_bytes, PROT_READ, flags, fd, 0 ) ;
+    if( m == MAP_FAILED ) return 5 ;
+    base = (const char*)m ;
+
+    header = (const sbundle_header*)base ;
+    if( strncmp(header->magic, MAGIC, sizeof(header->magic)) != 0 ) return 6 ;
+    if( header->version != VERSION ) return 7 ;
+    if( header->file_bytes != file_bytes ) return 8 ;
+
+    uint64_t table_bytes = uint64_t(header->num_section)*sizeof(sbundle_section) ;
+    if( sizeof(sbundle_header) + table_bytes > file_bytes ) return 9 ;
+    table = (const sbundle_section*)(base + sizeof(sbundle_header)) ;
+    if( Checksum( (const char*)table, table_bytes ) != header->table_checksum ) return 10 ;
+
+    for(int i=0 ; i < num_section() ; i++)
+    {
+        const sbundle_section& s = table[i] ;
+        if( s.offset + s.bytes > file_bytes || s.hdr > s.bytes ) return 11 ;
+        if( strnlen(s.key, sbundle_section::KEY) == sbundle_section::KEY ) return 12 ;
+        index[s.key] = i ;
+    }
+    return 0 ;
+}
+
+inline bool sbundle::verify(int i) const
+{
+    const sbundle_section& s = table[i] ;
+    return Checksum( base + s.offset, s.bytes ) == s.checksum ;
+}
+
+/**
+sbundle::verify
+-----------------
+
+Returns the number of sections failing their checksum.
+
+**/
+
+inline int sbundle::verify() const
+{
+    int num_fail = 0 ;
+    for(int i=0 ; i < num_section() ; i++)
+    {
+        bool ok = verify(i) ;
+        if(!ok) std::cerr << "sbundle::verify checksum FAIL [" << table[i].key << "]\n" ;
+        num_fail += int(!ok) ;
+    }
+    return num_fail ;
+}
+
+inline int sbundle::num_section() const
+{
+    return header ? header->num_section : 0 ;
+}
+
+inline int sbundle::find(const char* key) const
+{
+    auto it = index.find(key) ;
+    return it == index.end() ? -1 : it->second ;
+}
+
+inline bool sbundle::has(const char* key) const
+{
+    return find(key) > -1 ;
+}
+
+inline const sbundle_section* sbundle::section(const char* key) const
+{
+    int i = find(key) ;
+    return i > -1 ? table + i : nullptr ;
+}
+
+inline const char* sbundle::bytes(const sbundle_section* s) const
+{
+    return base + s->offset ;
+}
+
+
+/**
+sbundle::view
+---------------
+
+Pointer to the array data within the mapping, nullptr when the key is missing,
+is not an array or the item size of the array is not a multiple of sizeof(T).
+The first dimension of the array is returned in ni.
+
+**/
+
+template<typename T>
+inline const T* sbundle::view(const char* key, int64_t* ni) const
+{
+    const sbundle_section* s = section(key) ;
+    if( s == nullptr || !s->is_array() || s->nd < 1 ) return nullptr ;
+    uint64_t num_item = s->shape[0] ;
+    if( num_item > 0 && s->data_bytes() != num_item*sizeof(T) ) return nullptr ;
+    if(ni) *ni = num_item ;
+    return (const T*)( base + s->data_offset() ) ;
+}
+
+/**
+sbundle::copy
+---------------
+
+Fills vec with the items of the array, as CSGFoundry::loadArray but
+without opening or parsing anything. Returns non-zero when the key is
+missing or the item size does not match.
+
+**/
+
+template<typename T>
+inline int sbundle::copy(std::vector<T>& vec, const char* key) const
+{
+    int64_t ni = 0 ;
+    const T* vv = view<T>(key, &ni) ;
+    if( vv == nullptr ) return 1 ;
+    vec.resize(ni) ;
+    if( ni > 0 ) memcpy( (void*)vec.data(), vv, ni*sizeof(T) );
+    return 0 ;
+}
+
+inline std::string sbundle::text(const char* key) const
+{
+    const sbundle_section* s = section(key) ;
+    return s ? std::string( bytes(s), s->bytes ) : std::string() ;
+}
+
+/**
+sbundle::string
+-----------------
+
+Text without the trailing newline, as U::ReadString gives.
+
+**/
+
+inline std::string sbundle::string(const char* key) const
+{
+    std::vector<std::string> ll ;
+    lines(ll, key) ;
+    std::string str ;
+    for(unsigned i=0 ; i < ll.size() ; i++)
+    {
+        str += ll[i] ;
+        if( i < ll.size() - 1 ) str += "\n" ;
+    }
+    return str ;
+}
+
+/**
+sbundle::lines
+----------------
+
+Splits text into lines as NP::ReadNames does with std::getline.
+Returns non-zero when the key is missing.
+
+**/
+
+inline int sbundle::lines(std::vector<std::string>& ll, const char* key) const
+{
+    const sbundle_section* s = section(key) ;
+    if( s == nullptr ) return 1 ;
+    std::istringstream ss( std::string( bytes(s), s->bytes ) ) ;
+    std::string line ;
+    while(std::getline(ss, line)) ll.push_back(line) ;
+    return 0 ;
+}
+
+/**
+sbundle::array
+----------------
+
+Copy of the array with its metadata, names and labels sidecars
+as NP::Load would give.
+
+**/
+
+inline NP* sbundle::array(const char* key) const
+{
+    const sbundle_section* s = section(key) ;
+    if( s == nullptr || !s->is_array() ) return nullptr ;
+
+    std::vector<NP::INT> shape( s->shape, s->shape + s->nd ) ;
+    NP* a = new NP( s->descr, shape ) ;
+    assert( uint64_t(a->arr_bytes()) == s->data_bytes() );
+    memcpy( a->bytes(), base + s->data_offset(), s->data_bytes() );
+
+    std::string meta_key = Sidecar(key, "_meta.txt") ;
+    if(has(meta_key.c_str())) a->meta = text(meta_key.c_str()) ;
+
+    std::string names_key = Sidecar(key, "_names.txt") ;
+    lines(a->names, names_key.c_str()) ;
+
+    std::string labels_key = Sidecar(key, "_labels.txt") ;
+    if(has(labels_key.c_str()))
+    {
+        a->labels = new std::vector<std::string> ;
+        lines(*a->labels, labels_key.c_str()) ;
+    }
+    return a ;
+}
+
+inline bool sbundle::has_fold(const char* prefix) const
+{
+    std::string pfx = Join(prefix, "") ;
+    for(int i=0 ; i < num_section() ; i++) if(U::StartsWith(table[i].key, pfx.c_str())) return true ;
+    return false ;
+}
+
+/**
+sbundle::fold
+---------------
+
+NPFold of the sections beneath prefix, following NPFold::load. With an
+NPFold_index.txt the keys are taken in index order, otherwise the direct
+children are taken as NPFold::load_dir does skipping metadata sidecars and
+directories starting with underscore. Returns nullptr when there is nothing
+beneath prefix.
+
+**/
+
+inline NPFold* sbundle::fold(const char* prefix) const
+{
+    if(!has_fold(prefix)) return nullptr ;
+
+    NPFold* f = new NPFold ;
+    f->meta = string( Join(prefix, NPFold::META).c_str() ) ;
+    lines( f->names, Join(prefix, NPFold::NAMES).c_str() ) ;
+
+    std::vector<std::string> keys ;
+    if(lines(keys, Join(prefix, NPFold::INDEX).c_str()) != 0)
+    {
+        std::string pfx = Join(prefix, "") ;
+        for(int i=0 ; i < num_section() ; i++)
+        {
+            const char* k = table[i].key ;
+            if(!U::StartsWith(k, pfx.c_str())) continue ;
+            std::string rel = k + pfx.size() ;
+            size_t slash = rel.find('/') ;
+            std::string child = rel.substr(0, slash) ;
+            bool is_dir = slash != std::string::npos ;
+            if( is_dir ? U::StartsWith(child.c_str(), "_") : !IsNPY(child.c_str()) ) continue ;
+            if( std::find(keys.begin(), keys.end(), child) == keys.end() ) keys.push_back(child) ;
+        }
+    }
+
+    for(unsigned i=0 ; i < keys.size() ; i++)
+    {
+        const char* k = keys[i].c_str() ;
+        std::string pk = Join(prefix, k) ;
+        if(IsNPY(k))
+        {
+            NP* a = array(pk.c_str()) ;
+            if(a) f->add(k, a) ;
+        }
+        else
+        {
+            NPFold* sub = fold(pk.c_str()) ;
+            if(sub) f->add_subfold(k, sub) ;
+        }
+    }
+    return f ;
+}
+
+/**
+sbundle::extract
+------------------
+
+Writes every section back into the directory form beneath dir.
+Returns the number of failed writes.
+
+**/
+
+inline int sbundle::extract(const char* _dir) const
+{
+    const char* dir = U::Resolve(_dir) ;
+    int num_fail = 0 ;
+    for(int i=0 ; i < num_section() ; i++)
+    {
+        const sbundle_section& s = table[i] ;
+        std::string fpath = Join(dir, s.key) ;
+        U::MakeDirsForFile(fpath.c_str());
+        std::ofstream fp(fpath.c_str(), std::ios::out|std::ios::binary);
+        fp.write( base + s.offset, s.bytes );
+        fp.close();
+        num_fail += int(fp.fail()) ;
+    }
+    return num_fail ;
+}
+
+inline std::string sbundle::desc() const
+{
+    std::stringstream ss ;
+    ss << "sbundle::desc"
+       << " path " << ( path ? path : "-" )
+       << " file_bytes " << file_bytes
+       << " num_section " << num_section()
+       << "\n"
+       ;
+    if(ssys::getenvbool(sbundle__DUMP))
+    {
+        for(int i=0 ; i < num_section() ; i++)
+        {
+            const sbundle_section& s = table[i] ;
+            ss << std::setw(4) << i
+               << " offset " << std::setw(10) << s.offset
+               << " bytes " << std::setw(10) << s.bytes
+               << " " << std::setw(4) << s.descr
+               << " " << s.key
+               << "\n"
+               ;
+        }
+    }
+    std::string str = ss.str() ;
+    return str ;
+}
@@ -0,0 +1,208 @@
+#pragma once
+/**
+scerenkov_cdf.h : cumulative envelope integrals for Cerenkov energy sampling
+==============================================================================
+
+Cerenkov photon energies are distributed in proportion to::
+
+    s2(E) = max( 0, 1 - BetaInverse^2/n(E)^2 )
+
+within the genstep energy range Pmin:Pmax. The standard rejection sampling
+of qcerenkov::wavelength_sampled_bndtex samples energy flat and accepts with
+probability s2/maxSin2, which needs many iterations where s2 is far below
+maxSin2, eg when n(E) is close to BetaInverse over much of the range.
+
+This instead prepares for each material with RINDEX a table of cumulative
+integrals of a tight piecewise constant envelope of s2 for a grid of
+BetaInverse rows::
+
+    b_j = bi0 + j*bistep     bi0 = 1, bistep = (nMax - 1)/(num_bi - 1)
+
+The energy edges are the wavelength domain samples, so within each segment
+the boundary texture RINDEX is a convex combination of the two bracketing
+texels and the envelope::
+
+    env_jk = (1 + MARGIN)*max( 0, 1 - b_j^2/max(n_k, n_k+1)^2 )
+
+bounds s2 for any BetaInverse >= b_j irrespective of texture filter weight
+quantization. qcerenkov::wavelength_sampled_cdf picks the row with b_j <= BetaInverse,
+inverts the cumulative at a uniform random restricted to Pmin:Pmax and accepts
+with probability s2/env_jk, giving the exact s2 distribution typically after
+a little more than one iteration.
+
+The cumulative is accumulated in float such that the float differences
+used on device never fall below env times the float segment width.
+
+Arrays:
+
+cdf (num_cdf, num_bi, num_energy)
+    cumulative integral of env in eV, starting from zero at the lowest energy
+
+energy (num_energy,)
+    ascending energy edges in eV
+
+line (num_bnd*4,)  int32
+    cdf index for each bnd line, -1 for surface lines and materials without
+    a RINDEX above 1
+
+Created from the standard arrays with::
+
+    scerenkov_cdf* ck = scerenkov_cdf::Create(wavelength, mat, bd) ;
+
+**/
+
+#include <vector>
+#include <sstream>
+#include <cmath>
+#include <cfloat>
+#include <cassert>
+
+#include "ssys.h"
+#include "sdomain.h"
+#include "NP.hh"
+#include "NPFold.h"
+
+struct scerenkov_cdf
+{
+    static constexpr const char* scerenkov_cdf__NUM_BI = "scerenkov_cdf__NUM_BI" ;
+    static constexpr const double MARGIN = 1e-3 ;
+
+    NP* cdf ;
+    NP* energy ;
+    NP* line ;
+
+    float bi0 ;
+    float bistep ;
+
+    static scerenkov_cdf* Create(const NP* wavelength, const NP* mat, const NP* bd, int num_bi=0 );
+
+    scerenkov_cdf();
+    NPFold* serialize() const ;
+    std::string desc() const ;
+};
+
+
+inline scerenkov_cdf::scerenkov_cdf()
+    :
+    cdf(nullptr),
+    energy(nullptr),
+    line(nullptr),
+    bi0(1.f),
+    bistep(0.f)
+{
+}
+
+
+/**
+scerenkov_cdf::Create
+-----------------------
+
+wavelength (num_domain,)
+    ascending nm, the standard domain which may be non-uniform
+
+mat (num_mat, 2, num_domain, 4)
+    standard material array with RINDEX at [:,0,:,0]
+
+bd (num_bnd, 4)
+    omat,osur,isur,imat indices
+
+**/
+
+inline scerenkov_cdf* scerenkov_cdf::Create(const NP* wavelength, const NP* mat, const NP* bd, int num_bi ) // static
+{
+    assert( mat && mat->shape.size() == 4 && mat->shape[1] == 2 && mat->shape[3] == 4 );
+    assert( bd && bd->shape.size() == 2 && bd->shape[1] == 4 );
+
+    int num_mat = mat->shape[0] ;
+    int nl = mat->shape[2] ;
+    assert( wavelength && wavelength->num_values() == nl );
+
+    assert( wavelength->uifc == 'f' && wavelength->ebyte == 8 );
+    assert( mat->uifc == 'f' && mat->ebyte == 8 );
+    const double* nm = wavelength->cvalues<double>() ;
+    const double* mv = mat->cvalues<double>() ;
+    auto rindex = [&](int m, int i){ return mv[((m*2 + 0)*nl + i)*4 + 0] ; } ;
+
+    std::vector<int> mi ;
+    double nmax = 1. ;
+    for(int m=0 ; m < num_mat ; m++)
+    {
+        double mx = 0. ;
+        for(int i=0 ; i < nl ; i++) mx = std::max( mx, rindex(m,i) ) ;
+        mi.push_back( mx > 1. ? 1 : -1 ) ;
+        nmax = std::max( nmax, mx ) ;
+    }
+
+    int num_cdf = 0 ;
+    for(int m=0 ; m < num_mat ; m++) if( mi[m] > -1 ) mi[m] = num_cdf++ ;
+
+    scerenkov_cdf* ck = new scerenkov_cdf ;
+    int nb = num_bi > 1 ? num_bi : ssys::getenvint(scerenkov_cdf__NUM_BI, 64) ;
+    ck->bi0 = 1.f ;
+    ck->bistep = float( (nmax - 1.)/double(nb - 1) ) ;
+
+    ck->energy = NP::Make<float>(nl) ;
+    float* ee = ck->energy->values<float>() ;
+    for(int k=0 ; k < nl ; k++) ee[k] = float( sdomain::hc_eVnm/nm[nl-1-k] ) ;   // ascending energy
+
+    ck->cdf = NP::Make<float>(num_cdf, nb, nl) ;
+    float* cc = ck->cdf->values<float>() ;
+    for(int m=0 ; m < num_mat ; m++)
+    {
+        if( mi[m] < 0 ) continue ;
+        for(int j=0 ; j < nb ; j++)
+        {
+            double b = double(ck->bi0) + double(ck->bistep)*j ;
+            float* c = cc + (mi[m]*nb + j)*nl ;
+            c[0] = 0.f ;
+            for(int k=0 ; k < nl - 1 ; k++)
+            {
+                double n = std::max( rindex(m, nl-1-k), rindex(m, nl-2-k) ) ;
+                double env = (1. + MARGIN)*std::max( 0., 1. - b*b/(n*n) ) ;
+                float de = ee[k+1] - ee[k] ;
+                float c1 = c[k] + float(env*de) ;
+                while( double(c1 - c[k]) < env*de ) c1 = std::nextafter(c1, FLT_MAX) ;  // float differences must still bound
+                c[k+1] = c1 ;
+            }
+        }
+    }
+
+    int num_bnd = bd->shape[0] ;
+    const int* bb = bd->cvalues<int>() ;
+    ck->line = NP::Make<int>(num_bnd*4) ;
+    int* ll = ck->line->values<int>() ;
+    for(int i=0 ; i < num_bnd*4 ; i++)
+    {
+        int j = i % 4 ;
+        int m = j == 0 || j == 3 ? bb[i] : -1 ;
+        ll[i] = m > -1 && m < num_mat ? mi[m] : -1 ;
+    }
+
+    ck->cdf->set_meta<float>("bi0", ck->bi0 );
+    ck->cdf->set_meta<float>("bistep", ck->bistep );
+    return ck ;
+}
+
+inline NPFold* scerenkov_cdf::serialize() const
+{
+    NPFold* fold = new NPFold ;
+    fold->add("cdf", cdf );
+    fold->add("energy", energy );
+    fold->add("line", line );
+    return fold ;
+}
+
+inline std::string scerenkov_cdf::desc() const
+{
+    std::stringstream ss ;
+    ss << "scerenkov_cdf::desc"
+       << " cdf " << ( cdf ? cdf->sstr() : "-" )
+       << " energy " << ( energy ? energy->sstr() : "-" )
+       << " line " << ( line ? line->sstr() : "-" )
+       << " bi0 " << bi0
+       << " bistep " << bistep
+       << " bytes " << ( cdf ? cdf->arr_bytes() : 0 ) + ( energy ? energy->arr_bytes() : 0 ) + ( line ? line->arr_bytes() : 0 )
+       ;
+    std::string str = ss.str();
+    return str ;
+}
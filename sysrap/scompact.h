@@ -0,0 +1,233 @@
+#pragma once
+/**
+scompact.h : compact encodings of per-node transforms and digests
+====================================================================
+
+Used from stree::serialize with stree__serialize_compact to shrink the
+persisted tree, and from stree::import_ which accepts both the full and
+compact forms.
+
+Transforms are double 4x4 in glm column major layout, so an array of shape
+(num,4,4) has the translation at [:,3,:3] and the fourth element of each
+column at [:,:,3]. For affine transforms those elements are 0,0,0,1
+so the (num,4,3) form loses nothing.
+
+Affine
+    (num,4,3) from (num,4,4) affine transforms
+
+Full
+    (num,4,4) from (num,4,3), or copy of (num,4,4)
+
+Dedup
+    unique (num_tran,2,4,3) pairs of transforms and (num,) int index,
+    the local transforms of most nodes are repeated many times, for
+    example PMTs of the same type within a layer differ only in their
+    placement transform and their internal volumes are all identical
+
+Redup
+    fills full transform vectors from the unique pairs and the index
+
+Digest
+    (num,16) uint8 from 32 char hex digest strings, returns nullptr when
+    any string is not a 32 char hex digest
+
+Hex
+    32 char hex digest strings from (num,16) uint8
+
+**/
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <cassert>
+
+#include "NP.hh"
+
+struct scompact
+{
+    static constexpr const int DIGEST_BYTES = 16 ;
+
+    static bool IsAffine(const double* m);
+    static bool IsAffine(const double* mm, int num);
+    static NP*  Affine(const double* mm, int num);
+    static NP*  Full(const NP* a);
+    static NP*  Dedup(const double* aa, const double* bb, int num, NP** idx );
+    static void Redup(double* aa, double* bb, const NP* tran, const NP* idx );
+
+    static int  HexValue(char c);
+    static NP*  Digest(const std::vector<std::string>& digs);
+    static void Hex(std::vector<std::string>& digs, const NP* a);
+};
+
+
+inline bool scompact::IsAffine(const double* m) // static
+{
+    return m[3] == 0. && m[7] == 0. && m[11] == 0. && m[15] == 1. ;
+}
+
+inline bool scompact::IsAffine(const double* mm, int num) // static
+{
+    for(int i=0 ; i < num ; i++) if(!IsAffine(mm + 16*i)) return false ;
+    return true ;
+}
+
+inline NP* scompact::Affine(const double* mm, int num) // static
+{
+    NP* a = NP::Make<double>(num, 4, 3) ;
+    double* aa = a->values<double>() ;
+    for(int i=0 ; i < num ; i++)
+    for(int c=0 ; c < 4 ; c++)
+    for(int r=0 ; r < 3 ; r++) aa[(i*4 + c)*3 + r] = mm[(i*4 + c)*4 + r] ;
+    return a ;
+}
+
+inline NP* scompact::Full(const NP* a) // static
+{
+    assert( a && a->uifc == 'f' && a->ebyte == 8 );
+    int nd = a->shape.size() ;
+    assert( nd == 3 && a->shape[1] == 4 && ( a->shape[2] == 3 || a->shape[2] == 4 ) );
+    if( a->shape[2] == 4 ) return NP::MakeCopy(a) ;
+
+    int num = a->shape[0] ;
+    NP* b = NP::Make<double>(num, 4, 4) ;
+    const double* aa = a->cvalues<double>() ;
+    double* bb = b->values<double>() ;
+    for(int i=0 ; i < num ; i++)
+    for(int c=0 ; c < 4 ; c++)
+    {
+        for(int r=0 ; r < 3 ; r++) bb[(i*4 + c)*4 + r] = aa[(i*4 + c)*3 + r] ;
+        bb[(i*4 + c)*4 + 3] = c == 3 ? 1. : 0. ;
+    }
+    return b ;
+}
+
+/**
+scompact::Dedup
+------------------
+
+The pairs are keyed on their bytes so only bitwise identical
+transforms are shared, making the roundtrip exact.
+
+**/
+
+inline NP* scompact::Dedup(const double* aa, const double* bb, int num, NP** idx ) // static
+{
+    NP* _idx = NP::Make<int>(num) ;
+    int* ii = _idx->values<int>() ;
+
+    std::vector<double> uu ;
+    std::unordered_map<std::string, int> seen ;
+    double pair[24] ;
+
+    for(int i=0 ; i < num ; i++)
+    {
+        for(int c=0 ; c < 4 ; c++)
+        for(int r=0 ; r < 3 ; r++)
+        {
+            pair[     c*3 + r] = aa[(i*4 + c)*4 + r] ;
+            pair[12 + c*3 + r] = bb[(i*4 + c)*4 + r] ;
+        }
+        std::string key( (const char*)pair, sizeof(pair) );
+        auto it = seen.find(key) ;
+        if( it == seen.end() )
+        {
+            int u = seen.size() ;
+            seen[key] = u ;
+            uu.insert( uu.end(), pair, pair + 24 );
+            ii[i] = u ;
+        }
+        else
+        {
+            ii[i] = it->second ;
+        }
+    }
+
+    int num_tran = seen.size() ;
+    NP* tran = NP::Make<double>(num_tran, 2, 4, 3) ;
+    if(num_tran > 0) memcpy( tran->values<double>(), uu.data(), uu.size()*sizeof(double) );
+    *idx = _idx ;
+    return tran ;
+}
+
+inline void scompact::Redup(double* aa, double* bb, const NP* tran, const NP* idx ) // static
+{
+    assert( tran && tran->shape.size() == 4 && tran->shape[1] == 2 && tran->shape[2] == 4 && tran->shape[3] == 3 );
+    assert( idx && idx->uifc == 'i' && idx->ebyte == 4 );
+    int num_tran = tran->shape[0] ;
+    int num = idx->shape[0] ;
+    const double* uu = tran->cvalues<double>() ;
+    const int* ii = idx->cvalues<int>() ;
+
+    for(int i=0 ; i < num ; i++)
+    {
+        int u = ii[i] ;
+        assert( u > -1 && u < num_tran );
+        const double* pair = uu + 24*u ;
+        for(int c=0 ; c < 4 ; c++)
+        {
+            for(int r=0 ; r < 3 ; r++)
+            {
+                aa[(i*4 + c)*4 + r] = pair[     c*3 + r] ;
+                bb[(i*4 + c)*4 + r] = pair[12 + c*3 + r] ;
+            }
+            aa[(i*4 + c)*4 + 3] = c == 3 ? 1. : 0. ;
+            bb[(i*4 + c)*4 + 3] = c == 3 ? 1. : 0. ;
+        }
+    }
+}
+
+inline int scompact::HexValue(char c) // static
+{
+    if( c >= '0' && c <= '9' ) return c - '0' ;
+    if( c >= 'a' && c <= 'f' ) return c - 'a' + 10 ;
+    return -1 ;   // sdigest::Finalize uses lowercase, anything else cannot roundtrip
+}
+
+inline NP* scompact::Digest(const std::vector<std::string>& digs) // static
+{
+    int num = digs.size() ;
+    NP* a = NP::Make<unsigned char>(num, DIGEST_BYTES) ;
+    unsigned char* aa = a->values<unsigned char>() ;
+    for(int i=0 ; i < num ; i++)
+    {
+        const std::string& d = digs[i] ;
+        if( d.size() != 2*DIGEST_BYTES )
+        {
+            delete a ;
+            return nullptr ;
+        }
+        for(int j=0 ; j < DIGEST_BYTES ; j++)
+        {
+            int hi = HexValue(d[2*j+0]) ;
+            int lo = HexValue(d[2*j+1]) ;
+            if( hi < 0 || lo < 0 )
+            {
+                delete a ;
+                return nullptr ;
+            }
+            aa[i*DIGEST_BYTES + j] = (unsigned char)( hi*16 + lo ) ;
+        }
+    }
+    return a ;
+}
+
+inline void scompact::Hex(std::vector<std::string>& digs, const NP* a) // static
+{
+    assert( a && a->shape.size() == 2 && a->shape[1] == DIGEST_BYTES && a->ebyte == 1 );
+    static const char* HEX = "0123456789abcdef" ;
+    int num = a->shape[0] ;
+    const unsigned char* aa = a->cvalues<unsigned char>() ;
+    digs.resize(num) ;
+    char buf[2*DIGEST_BYTES] ;
+    for(int i=0 ; i < num ; i++)
+    {
+        for(int j=0 ; j < DIGEST_BYTES ; j++)
+        {
+            unsigned char b = aa[i*DIGEST_BYTES + j] ;
+            buf[2*j+0] = HEX[b >> 4] ;
+            buf[2*j+1] = HEX[b & 0xf] ;
+        }
+        digs[i].assign(buf, 2*DIGEST_BYTES) ;
+    }
+}
@@ -9,6 +9,10 @@ there is slight difference from smath.h float value : could be arising from CLHE
 
 Wavelength fine domain np.linspace(60,820,761)
 
+The sdomain(nm) ctor creates a non-uniform domain with step zero
+from ascending wavelength knots, see sdomain_adaptive.h
+
+
 **/
 
 
@@ -16,6 +20,7 @@ Wavelength fine domain np.linspace(60,820,761)
 #include <sstream>
 #include <cassert>
 #include <iomanip>
+#include <vector>
 
 #include "NPFold.h"
 
@@ -40,6 +45,7 @@ struct sdomain
     static constexpr int    DomainLength(){  return DOMAIN_TYPE == 'F' ? FINE_DOMAIN_LENGTH : COARSE_DOMAIN_LENGTH ; }
 
     sdomain(); 
+    sdomain(const std::vector<double>& nm); 
 
     NP* get_wavelength_nm() const ; 
     NP* get_energy_eV() const ; 
@@ -76,6 +82,27 @@ inline sdomain::sdomain()
 
 
 
+inline sdomain::sdomain(const std::vector<double>& nm)
+    :
+    length(nm.size()),
+    step(0.),
+    wavelength_nm(new double[length]),
+    energy_eV(new double[length]),
+    spec4(new double[4])
+{
+    assert( length > 1 ); 
+    for(int i=0 ; i < length ; i++) wavelength_nm[i] = nm[i] ; 
+    assert( wavelength_nm[0] == DOMAIN_LOW ); 
+    assert( wavelength_nm[length-1] == DOMAIN_HIGH ); 
+    for(int i=0 ; i < length ; i++) energy_eV[i] = hc_eVnm/wavelength_nm[i] ; 
+
+    spec4[0] = DomainLow(); 
+    spec4[1] = DomainHigh();
+    spec4[2] = 0. ; 
+    spec4[3] = DomainRange(); 
+}
+
+
 inline NP* sdomain::get_wavelength_nm() const 
 {
     return NP::MakeFromValues<double>( wavelength_nm, length ) ; 
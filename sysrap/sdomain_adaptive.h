@@ -0,0 +1,390 @@
+#pragma once
+/**
+sdomain_adaptive.h : non-uniform wavelength domain chosen per property
+=========================================================================
+
+sdomain.h fixes every material and surface property to 761 samples on a
+uniform 1nm grid from 60 to 820 nm. Most properties are smooth and are
+over-sampled by that while a few, such as scintillator emission or PMT
+efficiency edges, vary faster than 1nm can follow.
+
+sdomain_adaptive instead picks wavelength knots for each property:
+
+1. properties are sampled onto a fine base grid, *base_step* nm
+   (envvar sdomain_adaptive__BASE_STEP default 0.25, must divide 1nm)
+
+2. knots for each property alone are chosen by Douglas-Peucker style
+   subdivision, splitting each interval at its point of largest deviation
+   from linear interpolation (ie where the curvature is) until the error
+   at every base point is within tolerance::
+
+       |y - y_lin| <= rtol * max( |y|, FLOOR*max|y| )
+
+   with rtol from envvar sdomain_adaptive__RTOL default 1e-3.
+   Intervals are also split when the change across them is so large
+   that the 1/256 weight resolution of GPU linear texture filtering would
+   give errors beyond tolerance, ie when |y1 - y0|/512 exceeds it
+
+3. as all properties share the texture x coordinate the knots of all
+   properties are combined and further refined until every property is
+   within tolerance with the combined knots
+
+4. the *remap* table gives the fractional knot index at every base grid
+   point. As knots are on the base grid the mapping from wavelength to
+   texel coordinate is linear between base points, so linear
+   interpolation into the remap table is exact and lookups need only one
+   remap fetch and one texture fetch, see qbnd::domain_remap_lookup
+
+The *report* array (num_prop, 4) gives for each property the number of
+knots it needs alone and the max relative errors on the base grid with
+the adaptive knots and with the uniform 1nm grid, plus the max absolute
+adaptive error.
+
+Usage with U4Tree, envvar sstandard__ADAPTIVE, see U4Tree::initAdaptive::
+
+    sdomain_adaptive ad ;
+    ad.add_fn("Water/RINDEX", [&](double nm){ return ... ; });
+    ad.finalize();
+    sdomain dom(ad.knots) ;     // non-uniform domain for the standard arrays
+
+Note that accuracy beyond the uniform 1nm grid only comes where the
+source properties have structure finer than 1nm.
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cassert>
+
+#include "ssys.h"
+#include "NPFold.h"
+#include "sdomain.h"
+
+struct sdomain_adaptive
+{
+    static constexpr const char* sdomain_adaptive__RTOL = "sdomain_adaptive__RTOL" ;
+    static constexpr const char* sdomain_adaptive__BASE_STEP = "sdomain_adaptive__BASE_STEP" ;
+    static constexpr const double FLOOR = 1e-2 ;  // fraction of max|y| below which errors are absolute
+    static constexpr const double WEIGHT_ERR = 1./512. ;  // half of the 8-bit fraction texture filter weight step
+    enum { REPORT_NUM_OWN, REPORT_ERR_ADAPTIVE, REPORT_ERR_UNIFORM, REPORT_ABS_ADAPTIVE, REPORT_NUM } ;
+
+    double rtol ;
+    double base_step ;
+    int    base_per_nm ;
+    int    num_base ;
+    std::vector<double> base_nm ;
+
+    std::vector<std::string> names ;
+    std::vector<std::vector<double>> values ;   // each property on the base grid
+    std::vector<int> num_own ;
+
+    std::vector<unsigned char> mask ;   // combined knots on the base grid
+    std::vector<int>    knot_index ;    // base grid index of each knot
+    std::vector<double> knots ;         // wavelength nm of each knot
+    NP* report ;
+
+    sdomain_adaptive(double rtol=0., double base_step=0. );
+
+    void add(const char* name, const double* y );
+    template<typename F> void add_fn(const char* name, F f );
+
+    static double Scale(const double* y, int n );
+    static double Err(double y, double y_lin, double scale, double rtol );
+    static bool   Refine(std::vector<unsigned char>& mask, const double* y, int n, double rtol, int i0, int i1 );
+    static bool   RefineAll(std::vector<unsigned char>& mask, const double* y, int n, double rtol );
+    static double MaxErr(const std::vector<int>& kidx, const double* y, int n, double rtol, double* abs_err );
+
+    void finalize();
+
+    NP* get_wavelength_nm() const ;
+    NP* get_remap() const ;
+    static double Remap(const float* remap, int num_remap, double fx );
+
+    NPFold* serialize() const ;
+    std::string desc() const ;
+};
+
+
+inline sdomain_adaptive::sdomain_adaptive(double rtol_, double base_step_)
+    :
+    rtol( rtol_ > 0. ? rtol_ : ssys::getenvdouble(sdomain_adaptive__RTOL, 1e-3) ),
+    base_step( base_step_ > 0. ? base_step_ : ssys::getenvdouble(sdomain_adaptive__BASE_STEP, 0.25) ),
+    base_per_nm( int(std::round(1./base_step)) ),
+    num_base( int(std::round((sdomain::DOMAIN_HIGH - sdomain::DOMAIN_LOW)/base_step)) + 1 ),
+    report(nullptr)
+{
+    bool base_step_expect = base_per_nm > 0 && std::abs( base_per_nm*base_step - 1. ) < 1e-12 ;
+    if(!base_step_expect) std::cerr << "sdomain_adaptive::sdomain_adaptive base_step must divide 1nm " << base_step << "\n" ;
+    assert( base_step_expect );
+
+    base_nm.resize(num_base);
+    for(int i=0 ; i < num_base ; i++) base_nm[i] = sdomain::DOMAIN_LOW + base_step*double(i) ;
+    mask.resize(num_base, 0);
+    mask[0] = 1 ;
+    mask[num_base-1] = 1 ;
+}
+
+/**
+sdomain_adaptive::add
+-----------------------
+
+Adds property sampled at *base_nm* and selects its own knots
+
+**/
+
+inline void sdomain_adaptive::add(const char* name, const double* y )
+{
+    names.push_back(name);
+    values.push_back( std::vector<double>(y, y + num_base) );
+
+    std::vector<unsigned char> own(num_base, 0) ;
+    own[0] = 1 ;
+    own[num_base-1] = 1 ;
+    RefineAll(own, y, num_base, rtol );
+    int n = 0 ;
+    for(int i=0 ; i < num_base ; i++) n += int(own[i]) ;
+    num_own.push_back(n);
+    for(int i=0 ; i < num_base ; i++) mask[i] |= own[i] ;
+}
+
+template<typename F>
+inline void sdomain_adaptive::add_fn(const char* name, F f )
+{
+    std::vector<double> y(num_base) ;
+    for(int i=0 ; i < num_base ; i++) y[i] = f(base_nm[i]) ;
+    add(name, y.data() );
+}
+
+inline double sdomain_adaptive::Scale(const double* y, int n )
+{
+    double mx = 0. ;
+    for(int i=0 ; i < n ; i++) mx = std::max( mx, std::abs(y[i]) ) ;
+    return FLOOR*mx ;
+}
+
+inline double sdomain_adaptive::Err(double y, double y_lin, double scale, double rtol )
+{
+    double d = std::max( std::abs(y), scale ) ;
+    return d > 0. ? std::abs(y - y_lin)/(rtol*d) : 0. ;   // <= 1 within tolerance
+}
+
+/**
+sdomain_adaptive::Refine
+--------------------------
+
+Adds knots within (i0,i1) at the points of largest deviation from
+linear interpolation until all points are within tolerance.
+
+**/
+
+inline bool sdomain_adaptive::Refine(std::vector<unsigned char>& mask, const double* y, int n, double rtol, int i0, int i1 )
+{
+    double scale = Scale(y, n) ;
+    bool changed = false ;
+    std::vector<std::pair<int,int>> stack ;
+    stack.push_back( {i0, i1} );
+    while(!stack.empty())
+    {
+        std::pair<int,int> iv = stack.back() ;
+        stack.pop_back();
+        int a = iv.first ;
+        int b = iv.second ;
+        if( b - a < 2 ) continue ;
+
+        int imax = -1 ;
+        double emax = 1. ;
+        for(int i=a+1 ; i < b ; i++)
+        {
+            double t = double(i - a)/double(b - a) ;
+            double y_lin = y[a] + t*(y[b] - y[a]) ;
+            double e = Err(y[i], y_lin, scale, rtol) ;
+            if( e > emax ) { emax = e ; imax = i ; }
+        }
+        if( imax < 0 )   // filter weight resolution, worst at the smaller end
+        {
+            double ymin = std::min( std::abs(y[a]), std::abs(y[b]) ) ;
+            if( Err( WEIGHT_ERR*(y[b] - y[a]), 0., std::max(ymin, scale), rtol ) > 1. ) imax = (a + b)/2 ;
+        }
+        if( imax < 0 ) continue ;
+        mask[imax] = 1 ;
+        changed = true ;
+        stack.push_back( {a, imax} );
+        stack.push_back( {imax, b} );
+    }
+    return changed ;
+}
+
+inline bool sdomain_adaptive::RefineAll(std::vector<unsigned char>& mask, const double* y, int n, double rtol )
+{
+    std::vector<int> kidx ;
+    for(int i=0 ; i < n ; i++) if(mask[i]) kidx.push_back(i) ;
+    bool changed = false ;
+    for(int k=0 ; k < int(kidx.size()) - 1 ; k++) changed |= Refine(mask, y, n, rtol, kidx[k], kidx[k+1] );
+    return changed ;
+}
+
+/**
+sdomain_adaptive::MaxErr
+--------------------------
+
+Max relative error in units of rtol over all base points from linear
+interpolation between the kidx base points.
+
+**/
+
+inline double sdomain_adaptive::MaxErr(const std::vector<int>& kidx, const double* y, int n, double rtol, double* abs_err )
+{
+    double scale = Scale(y, n) ;
+    double emax = 0. ;
+    double amax = 0. ;
+    for(int k=0 ; k < int(kidx.size()) - 1 ; k++)
+    {
+        int a = kidx[k] ;
+        int b = kidx[k+1] ;
+        for(int i=a ; i <= b ; i++)
+        {
+            double t = double(i - a)/double(b - a) ;
+            double y_lin = y[a] + t*(y[b] - y[a]) ;
+            emax = std::max( emax, Err(y[i], y_lin, scale, rtol) ) ;
+            amax = std::max( amax, std::abs(y[i] - y_lin) ) ;
+        }
+    }
+    if(abs_err) *abs_err = amax ;
+    return emax*rtol ;
+}
+
+/**
+sdomain_adaptive::finalize
+----------------------------
+
+Refines the combined knots until no property needs more, then
+collects the knots and prepares the report.
+
+**/
+
+inline void sdomain_adaptive::finalize()
+{
+    int num_prop = names.size() ;
+    bool changed = true ;
+    while(changed)
+    {
+        changed = false ;
+        for(int p=0 ; p < num_prop ; p++) changed |= RefineAll(mask, values[p].data(), num_base, rtol );
+    }
+
+    knot_index.clear();
+    knots.clear();
+    for(int i=0 ; i < num_base ; i++) if(mask[i])
+    {
+        knot_index.push_back(i);
+        knots.push_back(base_nm[i]);
+    }
+
+    std::vector<int> uniform ;
+    for(int i=0 ; i < num_base ; i += base_per_nm) uniform.push_back(i) ;
+    if( uniform.back() != num_base - 1 ) uniform.push_back(num_base - 1) ;
+
+    report = NP::Make<double>(num_prop, REPORT_NUM) ;
+    report->set_names(names);
+    report->set_meta<double>("rtol", rtol );
+    report->set_meta<double>("base_step", base_step );
+    report->set_meta<int>("num_knots", knots.size() );
+    double* rr = report->values<double>() ;
+    for(int p=0 ; p < num_prop ; p++)
+    {
+        const double* y = values[p].data() ;
+        double abs_err = 0. ;
+        rr[p*REPORT_NUM+REPORT_NUM_OWN]      = num_own[p] ;
+        rr[p*REPORT_NUM+REPORT_ERR_ADAPTIVE] = MaxErr(knot_index, y, num_base, rtol, &abs_err ) ;
+        rr[p*REPORT_NUM+REPORT_ERR_UNIFORM]  = MaxErr(uniform, y, num_base, rtol, nullptr ) ;
+        rr[p*REPORT_NUM+REPORT_ABS_ADAPTIVE] = abs_err ;
+    }
+}
+
+inline NP* sdomain_adaptive::get_wavelength_nm() const
+{
+    return NP::MakeFromValues<double>( knots.data(), knots.size() ) ;
+}
+
+/**
+sdomain_adaptive::get_remap
+-----------------------------
+
+Fractional knot index at each base grid point, ie the texel coordinate
+of each base wavelength in a texture with the knots as x samples
+
+**/
+
+inline NP* sdomain_adaptive::get_remap() const
+{
+    assert( knot_index.size() > 1 );
+    NP* r = NP::Make<float>(num_base) ;
+    float* rr = r->values<float>() ;
+    int k = 0 ;
+    for(int i=0 ; i < num_base ; i++)
+    {
+        while( k < int(knot_index.size()) - 2 && knot_index[k+1] <= i ) k++ ;
+        int a = knot_index[k] ;
+        int b = knot_index[k+1] ;
+        rr[i] = float( double(k) + double(i - a)/double(b - a) ) ;
+    }
+    r->set_meta<float>("domain_low", sdomain::DOMAIN_LOW );
+    r->set_meta<float>("domain_step", base_step );
+    r->set_meta<int>("num_knots", knots.size() );
+    return r ;
+}
+
+/**
+sdomain_adaptive::Remap
+-------------------------
+
+Host equivalent of qbnd::domain_remap_lookup, fx is the fractional
+base grid coordinate (nm - DOMAIN_LOW)/base_step
+
+**/
+
+inline double sdomain_adaptive::Remap(const float* remap, int num_remap, double fx )
+{
+    double fb = std::min( std::max( fx, 0. ), double(num_remap - 1) ) ;
+    int i = std::min( int(fb), num_remap - 2 ) ;
+    double f = fb - double(i) ;
+    return remap[i] + f*( remap[i+1] - remap[i] ) ;
+}
+
+inline NPFold* sdomain_adaptive::serialize() const
+{
+    NPFold* fold = new NPFold ;
+    fold->add("wavelength_nm", get_wavelength_nm() );
+    fold->add("remap", get_remap() );
+    fold->add("report", report );
+    return fold ;
+}
+
+inline std::string sdomain_adaptive::desc() const
+{
+    int num_prop = names.size() ;
+    std::stringstream ss ;
+    ss << "sdomain_adaptive::desc"
+       << " rtol " << rtol
+       << " base_step " << base_step
+       << " num_base " << num_base
+       << " num_prop " << num_prop
+       << " num_knots " << knots.size()
+       << " uniform " << sdomain::FINE_DOMAIN_LENGTH
+       << "\n"
+       ;
+    const double* rr = report ? report->cvalues<double>() : nullptr ;
+    for(int p=0 ; p < num_prop && rr ; p++) ss
+       << std::setw(40) << names[p]
+       << " own " << std::setw(5) << int(rr[p*REPORT_NUM+REPORT_NUM_OWN])
+       << " err_adaptive " << std::scientific << std::setprecision(3) << rr[p*REPORT_NUM+REPORT_ERR_ADAPTIVE]
+       << " err_uniform " << rr[p*REPORT_NUM+REPORT_ERR_UNIFORM]
+       << " abs_adaptive " << rr[p*REPORT_NUM+REPORT_ABS_ADAPTIVE]
+       << "\n"
+       ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -15,6 +15,8 @@ struct snam
     static constexpr const char* BND = "bnd.npy" ;
     static constexpr const char* OPTICAL = "optical.npy" ;
     static constexpr const char* ICDF = "icdf.npy" ;
+    static constexpr const char* REMAP = "remap.npy" ;
+    static constexpr const char* DOMAIN_REPORT = "domain_report.npy" ;
 
     static constexpr const char* MULTIFILM = "multifilm.npy" ;
     static constexpr const char* PROPCOM = "propcom.npy" ;
@@ -0,0 +1,80 @@
+#pragma once
+/**
+sparallel.h : contiguous range parallel loop with std::thread
+================================================================
+
+For passes over large vectors where each item is independent, such as the
+per-node passes of stree::factorize. The range [0,num) is split into
+contiguous chunks, one per thread in order, so per-thread results that
+are concatenated in thread order give the same result as a serial pass
+whatever the number of threads.
+
+NumThread
+    number of threads to use for num items, num_thread when positive otherwise
+    std::thread::hardware_concurrency, limited such that each thread gets at
+    least min_per_thread items so small passes stay on the calling thread
+
+NumThreadEnv
+    as NumThread with num_thread when positive otherwise the value of
+    the envvar ekey, conventionally named Struct__NUM_THREAD, with 0 or
+    unset meaning hardware_concurrency
+
+For
+    invokes fn(t, i0, i1) for each thread index t with its item range [i0,i1),
+    directly on the calling thread when num_thread is 1. The index type of the
+    range follows that of num.
+
+::
+
+    int nt = sparallel::NumThread(num, 0) ;
+    std::vector<std::vector<int>> found(nt) ;
+    sparallel::For(num, nt, [&](int t, int i0, int i1){ for(int i=i0 ; i < i1 ; i++) if(pred(i)) found[t].push_back(i) ; }) ;
+
+**/
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+
+#include "ssys.h"
+
+struct sparallel
+{
+    static constexpr const int MIN_PER_THREAD = 1024 ;
+    static int NumThread(int64_t num, int num_thread, int min_per_thread=MIN_PER_THREAD);
+    static int NumThreadEnv(int64_t num, const char* ekey, int num_thread=0, int min_per_thread=MIN_PER_THREAD);
+    template<typename I, typename F> static void For(I num, int num_thread, F fn);
+};
+
+inline int sparallel::NumThread(int64_t num, int num_thread, int min_per_thread) // static
+{
+    int nt = num_thread > 0 ? num_thread : int(std::max( 1u, std::thread::hardware_concurrency() )) ;
+    int64_t mx = std::max( int64_t(1), num/std::max(1, min_per_thread) ) ;
+    return int(std::min( int64_t(nt), mx )) ;
+}
+
+inline int sparallel::NumThreadEnv(int64_t num, const char* ekey, int num_thread, int min_per_thread) // static
+{
+    int nt = num_thread > 0 ? num_thread : ssys::getenvint(ekey, 0) ;
+    return NumThread(num, nt, min_per_thread) ;
+}
+
+template<typename I, typename F>
+inline void sparallel::For(I num, int num_thread, F fn) // static
+{
+    if( num_thread <= 1 )
+    {
+        fn(0, I(0), num);
+        return ;
+    }
+    I per_thread = ( num + num_thread - 1 )/num_thread ;
+    std::vector<std::thread> workers ;
+    for(int t=0 ; t < num_thread ; t++)
+    {
+        I i0 = std::min( num, I(t)*per_thread );
+        I i1 = std::min( num, i0 + per_thread );
+        workers.emplace_back( fn, t, i0, i1 );
+    }
+    for(int t=0 ; t < num_thread ; t++) workers[t].join();
+}
@@ -0,0 +1,393 @@
+#pragma once
+/**
+sphoton_soa.h : columnar (structure-of-arrays) photon layout
+==============================================================
+
+sphoton is a 64-byte AoS record, persisted as (n,4,4) float arrays.
+Analyses that need only a few fields, eg flag histories or positions
+of hits, still read and stride over all 64 bytes of every photon.
+
+sphoton_soa transposes (n,4,4) photon/hit arrays into an NPFold of
+separate contiguous column arrays and back again::
+
+    column          word  shape   type
+    --------------  ----  ------  -----
+    pos             0     (n,3)   f4
+    time            3     (n,)    f4
+    mom             4     (n,3)   f4
+    iindex          7     (n,)    u4
+    pol             8     (n,3)   f4
+    wavelength      11    (n,)    f4
+    boundary_flag   12    (n,)    u4
+    identity        13    (n,)    u4
+    orient_idx      14    (n,)    u4
+    flagmask        15    (n,)    u4
+
+Columns are saved as separate .npy into a "<key>_soa" folder,
+eg "photon_soa/flagmask.npy", so selective analyses load
+only the columns they need with sphoton_soa::Load. From python::
+
+    flagmask = np.load("photon_soa/flagmask.npy")
+
+Persisting events in columnar form is switched on with envvar
+SEvt__COLUMNAR listing the keys, eg "photon,hit", SEvt::loadfold
+restores the AoS arrays so existing consumers are unchanged.
+
+The sphoton_soa instance is a lightweight view of column pointers
+with accessors matching the sphoton bit field methods.
+
+**/
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+
+#include "NPFold.h"
+
+struct sphoton_soa
+{
+    struct Column
+    {
+        const char* name ;
+        int  word ;    // offset in the 16 words of the record
+        int  width ;   // 1 or 3
+        char uifc ;    // 'f' or 'u'
+    };
+
+    static constexpr const int NUM_COLUMN = 10 ;
+    static const Column COLUMNS[NUM_COLUMN] ;
+    static constexpr const char* SUFFIX = "_soa" ;
+
+    static int  FindColumn(const char* name);
+    static bool IsPhotonArray(const NP* a);
+
+    static NPFold* Transpose(const NP* photon, const char* cols=nullptr, char delim=',');
+    static NP*     Combine(const NPFold* soa);
+    static NPFold* Load(const char* dir, const char* key, const char* cols=nullptr, char delim=',');
+
+    static int Columnarize_r(  NPFold* fold, const char* keys, std::vector<NPFold*>* created=nullptr, char delim=',');
+    static int Decolumnarize_r(NPFold* fold);
+
+    int             num ;
+    const float*    pos ;
+    const float*    time ;
+    const float*    mom ;
+    const unsigned* iindex ;
+    const float*    pol ;
+    const float*    wavelength ;
+    const unsigned* boundary_flag ;
+    const unsigned* identity ;
+    const unsigned* orient_idx ;
+    const unsigned* flagmask ;
+
+    sphoton_soa(const NPFold* soa);
+
+    unsigned flag(int i) const {     return boundary_flag[i] & 0xffffu ; }
+    unsigned boundary(int i) const { return boundary_flag[i] >> 16 ; }
+    unsigned idx(int i) const {      return orient_idx[i] & 0x7fffffffu ; }
+    float    orient(int i) const {   return ( orient_idx[i] & 0x80000000u ) ? -1.f : 1.f ; }
+
+    void where_flagmask(std::vector<int>& ii, unsigned mask) const ;
+    std::string desc() const ;
+};
+
+inline const sphoton_soa::Column sphoton_soa::COLUMNS[NUM_COLUMN] = {
+    { "pos",           0, 3, 'f' },
+    { "time",          3, 1, 'f' },
+    { "mom",           4, 3, 'f' },
+    { "iindex",        7, 1, 'u' },
+    { "pol",           8, 3, 'f' },
+    { "wavelength",   11, 1, 'f' },
+    { "boundary_flag",12, 1, 'u' },
+    { "identity",     13, 1, 'u' },
+    { "orient_idx",   14, 1, 'u' },
+    { "flagmask",     15, 1, 'u' }
+};
+
+inline int sphoton_soa::FindColumn(const char* name) // static
+{
+    std::string n = NPFold::BareKey(name) ;
+    for(int c=0 ; c < NUM_COLUMN ; c++) if(strcmp(COLUMNS[c].name, n.c_str()) == 0) return c ;
+    return -1 ;
+}
+
+inline bool sphoton_soa::IsPhotonArray(const NP* a) // static
+{
+    return a && a->uifc == 'f' && a->ebyte == 4 && a->shape.size() == 3 && a->shape[1] == 4 && a->shape[2] == 4 ;
+}
+
+/**
+sphoton_soa::Transpose
+------------------------
+
+Creates fold of column arrays from (n,4,4) photon array, with *cols*
+delimited list selecting columns, default all. Single pass over the
+records writing all selected columns, as photon arrays are typically
+much larger than cache. The photon array metadata is carried in the
+fold meta.
+
+**/
+
+inline NPFold* sphoton_soa::Transpose(const NP* photon, const char* cols, char delim) // static
+{
+    if(!IsPhotonArray(photon)) return nullptr ;
+
+    std::vector<int> sel ;
+    if(cols == nullptr)
+    {
+        for(int c=0 ; c < NUM_COLUMN ; c++) sel.push_back(c) ;
+    }
+    else
+    {
+        std::vector<std::string> elem ;
+        NPFold::SplitKeys(elem, cols, delim);
+        for(unsigned i=0 ; i < elem.size() ; i++)
+        {
+            int c = FindColumn(elem[i].c_str()) ;
+            if(c < 0) std::cerr << "sphoton_soa::Transpose unknown column [" << NPFold::BareKey(elem[i].c_str()) << "]\n" ;
+            if(c > -1) sel.push_back(c) ;
+        }
+    }
+
+    int ni = photon->shape[0] ;
+    int num_sel = sel.size() ;
+    std::vector<NP*> arr(num_sel) ;
+    std::vector<unsigned*> dst(num_sel) ;
+
+    for(int s=0 ; s < num_sel ; s++)
+    {
+        const Column& col = COLUMNS[sel[s]] ;
+        arr[s] = col.uifc == 'f' ?
+                    ( col.width == 1 ? NP::Make<float>(ni)    : NP::Make<float>(ni, col.width) )
+                 :
+                    ( col.width == 1 ? NP::Make<unsigned>(ni) : NP::Make<unsigned>(ni, col.width) )
+                 ;
+        dst[s] = (unsigned*)arr[s]->bytes() ;
+    }
+
+    const unsigned* src = (const unsigned*)photon->bytes() ;  // bit copy, no float conversion
+    for(int i=0 ; i < ni ; i++)
+    {
+        const unsigned* rec = src + i*16 ;
+        for(int s=0 ; s < num_sel ; s++)
+        {
+            const Column& col = COLUMNS[sel[s]] ;
+            unsigned* d = dst[s] + i*col.width ;
+            for(int k=0 ; k < col.width ; k++) d[k] = rec[col.word+k] ;
+        }
+    }
+
+    NPFold* soa = new NPFold ;
+    for(int s=0 ; s < num_sel ; s++) soa->add(COLUMNS[sel[s]].name, arr[s]) ;
+    soa->meta = photon->meta ;
+    return soa ;
+}
+
+/**
+sphoton_soa::Combine
+----------------------
+
+Inverse of Transpose, creating (n,4,4) photon array from the
+column arrays of the fold. Absent columns are zeroed.
+Returns nullptr when there are no columns or their item counts differ.
+
+**/
+
+inline NP* sphoton_soa::Combine(const NPFold* soa) // static
+{
+    if(soa == nullptr) return nullptr ;
+    int ni = -1 ;
+    const unsigned* src[NUM_COLUMN] = {} ;
+    for(int c=0 ; c < NUM_COLUMN ; c++)
+    {
+        const Column& col = COLUMNS[c] ;
+        const NP* a = soa->get(col.name) ;
+        if(a == nullptr) continue ;
+        bool expected = a->ebyte == 4 && a->num_values() == a->shape[0]*col.width ;
+        bool consistent = ni == -1 || ni == a->shape[0] ;
+        if(!expected || !consistent) std::cerr
+            << "sphoton_soa::Combine UNEXPECTED column " << col.name
+            << " sstr " << a->sstr()
+            << " ni " << ni
+            << "\n"
+            ;
+        if(!expected || !consistent) return nullptr ;
+        ni = a->shape[0] ;
+        src[c] = (const unsigned*)a->bytes() ;
+    }
+    if(ni < 0) return nullptr ;
+
+    NP* photon = NP::Make<float>(ni, 4, 4) ;
+    unsigned* dst = (unsigned*)photon->bytes() ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        unsigned* rec = dst + i*16 ;
+        for(int c=0 ; c < NUM_COLUMN ; c++)
+        {
+            if(src[c] == nullptr) continue ;
+            const Column& col = COLUMNS[c] ;
+            const unsigned* s = src[c] + i*col.width ;
+            for(int k=0 ; k < col.width ; k++) rec[col.word+k] = s[k] ;
+        }
+    }
+    photon->meta = soa->meta ;
+    return photon ;
+}
+
+/**
+sphoton_soa::Load
+-------------------
+
+Loads only the selected columns from "<dir>/<key>_soa", default all
+columns present. This is the point of the columnar layout : eg loading
+just flagmask reads 1/16 of the bytes.
+
+**/
+
+inline NPFold* sphoton_soa::Load(const char* dir, const char* key, const char* cols, char delim) // static
+{
+    std::string sub = std::string(dir) + "/" + key + SUFFIX ;
+    if(cols == nullptr) return NPFold::LoadIfExists(sub.c_str()) ;
+
+    std::vector<std::string> elem ;
+    NPFold::SplitKeys(elem, cols, delim);
+
+    NPFold* soa = nullptr ;
+    for(unsigned i=0 ; i < elem.size() ; i++)
+    {
+        std::string k = NPFold::BareKey(elem[i].c_str()) ;
+        if(FindColumn(k.c_str()) < 0) continue ;
+        std::string path = sub + "/" + k + NPFold::DOT_NPY ;
+        if(!NP::Exists(path.c_str())) continue ;
+        if(soa == nullptr) soa = new NPFold ;
+        soa->add(k.c_str(), NP::Load(path.c_str()));
+    }
+    return soa ;
+}
+
+/**
+sphoton_soa::Columnarize_r
+----------------------------
+
+For each fold of the tree replaces (n,4,4) arrays with keys
+listed in *keys* with a "<key>_soa" subfold of column arrays.
+
+The replaced arrays are removed without being deleted as SEvt::save
+applies this to a shallowcopy that does not own its arrays. The created
+subfolds are collected so the caller can delete them after saving.
+
+**/
+
+inline int sphoton_soa::Columnarize_r(NPFold* fold, const char* keys, std::vector<NPFold*>* created, char delim) // static
+{
+    if(fold == nullptr || keys == nullptr) return 0 ;
+    int count = 0 ;
+    for(int i=0 ; i < fold->get_num_subfold() ; i++) count += Columnarize_r(fold->get_subfold(i), keys, created, delim) ;
+
+    std::vector<std::string> elem ;
+    NPFold::SplitKeys(elem, keys, delim);
+    for(unsigned i=0 ; i < elem.size() ; i++)
+    {
+        const char* k = elem[i].c_str() ;
+        if(!IsPhotonArray(fold->get(k))) continue ;
+        std::string f = std::string(NPFold::BareKey(k)) + SUFFIX ;
+        if(fold->has_subfold(f.c_str())) continue ;
+
+        const NP* a = fold->remove(k) ;
+        NPFold* soa = Transpose(a) ;
+        fold->add_subfold(f.c_str(), soa);
+        if(created) created->push_back(soa) ;
+        count += 1 ;
+    }
+    return count ;
+}
+
+/**
+sphoton_soa::Decolumnarize_r
+------------------------------
+
+For each fold of the tree adds AoS arrays combined from any "<key>_soa"
+subfolds, unless an array with the key is already present.
+The column subfolds are retained.
+
+**/
+
+inline int sphoton_soa::Decolumnarize_r(NPFold* fold) // static
+{
+    if(fold == nullptr) return 0 ;
+    int count = 0 ;
+    for(int i=0 ; i < fold->get_num_subfold() ; i++)
+    {
+        NPFold* sub = fold->get_subfold(i) ;
+        std::string f = fold->get_subfold_key(i) ;
+        bool is_soa = NPFold::HasSuffix(f.c_str(), SUFFIX) ;
+        if(!is_soa)
+        {
+            count += Decolumnarize_r(sub) ;
+            continue ;
+        }
+        std::string k = f.substr(0, f.size() - strlen(SUFFIX)) ;
+        if(fold->has_key(k.c_str())) continue ;
+        NP* a = Combine(sub) ;
+        if(a == nullptr) continue ;
+        fold->add(k.c_str(), a) ;
+        count += 1 ;
+    }
+    return count ;
+}
+
+inline sphoton_soa::sphoton_soa(const NPFold* soa)
+    :
+    num(0),
+    pos(nullptr),
+    time(nullptr),
+    mom(nullptr),
+    iindex(nullptr),
+    pol(nullptr),
+    wavelength(nullptr),
+    boundary_flag(nullptr),
+    identity(nullptr),
+    orient_idx(nullptr),
+    flagmask(nullptr)
+{
+    if(soa == nullptr) return ;
+    const void** pp[NUM_COLUMN] = {
+        (const void**)&pos, (const void**)&time, (const void**)&mom, (const void**)&iindex,
+        (const void**)&pol, (const void**)&wavelength, (const void**)&boundary_flag,
+        (const void**)&identity, (const void**)&orient_idx, (const void**)&flagmask } ;
+
+    for(int c=0 ; c < NUM_COLUMN ; c++)
+    {
+        const NP* a = soa->get(COLUMNS[c].name) ;
+        if(a == nullptr) continue ;
+        *pp[c] = a->bytes() ;
+        num = a->shape[0] ;
+    }
+}
+
+/**
+sphoton_soa::where_flagmask
+-----------------------------
+
+Collects indices of photons with any of the *mask* bits in their
+flagmask, eg SURFACE_DETECT for hits. Reads only the flagmask column.
+
+**/
+
+inline void sphoton_soa::where_flagmask(std::vector<int>& ii, unsigned mask) const
+{
+    if(flagmask == nullptr) return ;
+    for(int i=0 ; i < num ; i++) if(flagmask[i] & mask) ii.push_back(i) ;
+}
+
+inline std::string sphoton_soa::desc() const
+{
+    std::stringstream ss ;
+    ss << "sphoton_soa::desc num " << num << " columns" ;
+    const void* pp[NUM_COLUMN] = { pos, time, mom, iindex, pol, wavelength, boundary_flag, identity, orient_idx, flagmask } ;
+    for(int c=0 ; c < NUM_COLUMN ; c++) if(pp[c]) ss << " " << COLUMNS[c].name ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,454 @@
+#pragma once
+/**
+ssimtrace_refine.h : adaptive boundary refining simtrace
+===========================================================
+
+The uniform CEGS grid of SFrameGenstep::MakeCenterExtentGenstep
+needs to be scaled up by orders of magnitude to resolve thin layers
+and coincident faces, with almost all of the extra rays landing far
+from any surface. This instead starts from the coarse base gensteps
+and recursively adds finer gensteps only where the geometry changes::
+
+    ssimtrace_refine rf(fn, num_ray, max_level) ;
+    rf.init(genstep, local_scale) ;   // base gensteps and their grid spacing
+    rf.run() ;
+    NPFold* f = rf.serialize() ;      // genstep, simtrace, cell
+
+fn : std::function<bool(quad4&)>
+    intersects one ray in simtrace layout (origin q2, direction q3,
+    tmin q1.f.w) writing normal and distance to q0 and position to q1,
+    eg CSGQuery::simtrace. Returns true for a valid intersect.
+
+Every genstep is a point on the lattice of its level, level L having
+spacing local_scale/2^L. Points are keyed in units of the finest spacing so
+coarse points coincide with finer ones and are never traced twice.
+Each point traces the same num_ray fixed directions, an even phi wheel in the
+grid plane or a spherical Fibonacci set for XYZ grids.
+
+At each level L all points on the level L lattice, including coarser ones,
+are refined when either:
+
+1. a ray intersects within NEAR times the level spacing : a surface
+   passes through or close to the cell
+2. the region identity differs from that of a neighbouring point on the
+   level L lattice, both are then refined
+
+The region identity of a point is the signature of its first ray that exits,
+combining the exit with the boundary in q2.u.w of GPU simtrace, or zero
+when no ray exits. Refining adds the 3x3 (or 3x3x3) level L+1 points centered
+on the point, which are traced and examined in turn up to max_level.
+
+The refined gensteps are standard FRAME gensteps with the parent gsid,
+the cell array (num_genstep, 4) int gives the finest unit key kx,ky,kz
+and the level of each.
+
+**/
+
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <sstream>
+#include <cmath>
+#include <cassert>
+
+#include "scuda.h"
+#include "squad.h"
+#include "sqat4.h"
+#include "sc4u.h"
+#include "sxyz.h"
+#include "ssys.h"
+#include "SGenstep.h"
+#include "NP.hh"
+#include "NPFold.h"
+
+struct ssimtrace_refine
+{
+    typedef std::function<bool(quad4&)> FN ;
+    typedef unsigned long long KEY ;
+
+    static constexpr const char* ssimtrace_refine__NUM_RAY = "ssimtrace_refine__NUM_RAY" ;
+    static constexpr const int MAX_LEVEL = 8 ;
+    static constexpr const float NEAR = 1.5f ;
+
+    FN  fn ;
+    int num_ray ;
+    int max_level ;
+    float local_scale ;
+    int gridaxes ;
+
+    std::vector<quad6> genstep ;
+    std::vector<quad4> simtrace ;     // num_ray for each genstep
+    std::vector<int4>  cell ;         // kx,ky,kz,level for each genstep
+    std::vector<unsigned> sig ;       // num_ray for each genstep
+    std::unordered_map<KEY, int> index ;
+
+    std::vector<int> level_count ;    // gensteps added at each level
+    int num_intersect ;
+
+    static KEY Key(int kx, int ky, int kz, int ip);
+    static void Direction(float4& dir, int gridaxes, int j, int n);
+    static unsigned Signature(const quad4& p, bool valid);
+
+    ssimtrace_refine(FN fn, int num_ray=0, int max_level=4 );
+
+    void init(const std::vector<quad6>& base, float local_scale);
+    int  run();
+
+    int  add(const quad6& gs, int kx, int ky, int kz, int level);
+    void trace(int i);
+    int  unit(int level) const ;
+    float spacing_world(int i, int level) const ;
+    unsigned region(int i) const ;
+    bool differs(int i, int j) const ;
+    int  find(int kx, int ky, int kz, int ip) const ;
+    int  refine(int level);
+
+    NP* get_genstep() const ;
+    NP* get_simtrace() const ;
+    NP* get_cell() const ;
+    NPFold* serialize() const ;
+    std::string desc() const ;
+};
+
+
+inline ssimtrace_refine::ssimtrace_refine(FN fn_, int num_ray_, int max_level_ )
+    :
+    fn(fn_),
+    num_ray(num_ray_ > 0 ? num_ray_ : ssys::getenvint(ssimtrace_refine__NUM_RAY, 32)),
+    max_level(std::min(max_level_, MAX_LEVEL)),
+    local_scale(0.f),
+    gridaxes(XYZ),
+    num_intersect(0)
+{
+    assert( num_ray > 0 && num_ray < 256 );   // photon index within the gsid is a byte
+}
+
+/**
+ssimtrace_refine::Key
+------------------------
+
+Four 16 bit fields, finest unit lattice coordinates are within
++-127*2^MAX_LEVEL so fit in signed short.
+
+**/
+
+inline ssimtrace_refine::KEY ssimtrace_refine::Key(int kx, int ky, int kz, int ip) // static
+{
+    KEY k = 0 ;
+    k |= KEY(uint16_t(kx)) << 0 ;
+    k |= KEY(uint16_t(ky)) << 16 ;
+    k |= KEY(uint16_t(kz)) << 32 ;
+    k |= KEY(uint16_t(ip)) << 48 ;
+    return k ;
+}
+
+/**
+ssimtrace_refine::Direction
+------------------------------
+
+Fixed directions, as SFrameGenstep::SetGridPlaneDirection but without
+randomness so the same ray index can be compared between points.
+
+**/
+
+inline void ssimtrace_refine::Direction(float4& dir, int gridaxes, int j, int n) // static
+{
+    if( gridaxes == XYZ )
+    {
+        double golden = M_PI*(3. - std::sqrt(5.)) ;
+        double cosTheta = 1. - 2.*(double(j) + 0.5)/double(n) ;
+        double sinTheta = std::sqrt( std::max(0., 1. - cosTheta*cosTheta) ) ;
+        double phi = golden*double(j) ;
+        dir = make_float4( sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta, 0.f );
+    }
+    else
+    {
+        double phi = 2.*M_PI*double(j)/double(n) ;
+        float c = std::cos(phi) ;
+        float s = std::sin(phi) ;
+        switch( gridaxes )
+        {
+            case YZ: dir = make_float4( 0.f, c,   s,   0.f ) ; break ;
+            case XZ: dir = make_float4( c,   0.f, s,   0.f ) ; break ;
+            case XY: dir = make_float4( c,   s,   0.f, 0.f ) ; break ;
+        }
+    }
+}
+
+inline unsigned ssimtrace_refine::Signature(const quad4& p, bool valid) // static
+{
+    if(!valid) return 0u ;
+    float nd = p.q0.f.x*p.q3.f.x + p.q0.f.y*p.q3.f.y + p.q0.f.z*p.q3.f.z ;
+    return nd < 0.f ? 1u : ( 2u | ( p.q2.u.w << 2 ) ) ;   // enter : exit with boundary
+}
+
+/**
+ssimtrace_refine::region
+-------------------------
+
+Identity of the region containing point i : zero when no ray exits,
+otherwise the signature of the first ray that exits. Comparing every
+ray would refine along the shadow lines of tangent rays far from
+any surface.
+
+**/
+
+inline unsigned ssimtrace_refine::region(int i) const
+{
+    for(int r=0 ; r < num_ray ; r++)
+    {
+        unsigned s = sig[i*num_ray + r] ;
+        if( s & 2u ) return s ;
+    }
+    return 0u ;
+}
+
+/**
+ssimtrace_refine::init
+-------------------------
+
+base
+    gensteps from SFrameGenstep::MakeCenterExtentGenstep, the grid
+    coordinates are taken from the gsid, gensteps duplicating an already
+    present grid point (eg from CEHIGH) are skipped
+
+local_scale
+    grid spacing in the frame of the genstep transforms, ie gridscale*ce.w
+    with the default ce_scale
+
+**/
+
+inline void ssimtrace_refine::init(const std::vector<quad6>& base, float local_scale_)
+{
+    local_scale = local_scale_ ;
+    int u = unit(0) ;
+    for(unsigned i=0 ; i < base.size() ; i++)
+    {
+        const quad6& gs = base[i] ;
+        if( i == 0 ) gridaxes = gs.q0.i.y ;
+        assert( gs.q0.i.y == gridaxes );
+        C4U gsid ;
+        gsid.u = gs.q0.u.z ;
+        int ix = int(static_cast<signed char>(gsid.c4.x)) ;
+        int iy = int(static_cast<signed char>(gsid.c4.y)) ;
+        int iz = int(static_cast<signed char>(gsid.c4.z)) ;
+        int ip = int(gsid.c4.w) ;
+        if( find(ix*u, iy*u, iz*u, ip) > -1 ) continue ;
+        add(gs, ix*u, iy*u, iz*u, 0 );
+    }
+}
+
+inline int ssimtrace_refine::unit(int level) const
+{
+    return 1 << ( max_level - level ) ;
+}
+
+inline int ssimtrace_refine::find(int kx, int ky, int kz, int ip) const
+{
+    auto it = index.find(Key(kx, ky, kz, ip)) ;
+    return it == index.end() ? -1 : it->second ;
+}
+
+/**
+ssimtrace_refine::add
+------------------------
+
+Appends the genstep and traces its rays.
+
+**/
+
+inline int ssimtrace_refine::add(const quad6& gs, int kx, int ky, int kz, int level)
+{
+    C4U gsid ;
+    gsid.u = gs.q0.u.z ;
+    int i = genstep.size() ;
+    index[Key(kx, ky, kz, gsid.c4.w)] = i ;
+
+    quad6 g = gs ;
+    SGenstep::SetNumPhoton(g, num_ray) ;
+    genstep.push_back(g) ;
+    cell.push_back( make_int4(kx, ky, kz, level) ) ;
+    if( int(level_count.size()) <= level ) level_count.resize(level+1, 0) ;
+    level_count[level] += 1 ;
+
+    simtrace.resize( genstep.size()*num_ray ) ;
+    sig.resize( genstep.size()*num_ray ) ;
+    trace(i);
+    return i ;
+}
+
+inline void ssimtrace_refine::trace(int i)
+{
+    const quad6& gs = genstep[i] ;
+    qat4 qt(gs) ;
+    C4U gsid ;
+    gsid.u = gs.q0.u.z ;
+
+    for(int j=0 ; j < num_ray ; j++)
+    {
+        float4 ori = make_float4( gs.q1.f.x, gs.q1.f.y, gs.q1.f.z, 1.f );
+        float4 dir ;
+        Direction(dir, gridaxes, j, num_ray );
+        qt.right_multiply_inplace( ori, 1.f );
+        qt.right_multiply_inplace( dir, 0.f );
+
+        gsid.c4.w = j ;
+
+        quad4& p = simtrace[i*num_ray + j] ;
+        p.zero();
+        p.q2.f = ori ;
+        p.q3.f = dir ;
+        p.q3.u.w = gsid.u ;
+
+        bool valid = fn(p) ;
+        if(valid) num_intersect += 1 ;
+        sig[i*num_ray + j] = Signature(p, valid) ;
+    }
+}
+
+inline float ssimtrace_refine::spacing_world(int i, int level) const
+{
+    qat4 qt(genstep[i]) ;
+    float s = local_scale/float(1 << level) ;
+    float3 a = qt.right_multiply( make_float3( gridaxes == YZ ? 0.f : s, gridaxes == YZ ? s : 0.f, 0.f ), 0.f ) ;
+    return std::sqrt( a.x*a.x + a.y*a.y + a.z*a.z ) ;
+}
+
+inline bool ssimtrace_refine::differs(int i, int j) const
+{
+    return region(i) != region(j) ;
+}
+
+/**
+ssimtrace_refine::refine
+---------------------------
+
+Examines the points added at *level* marking those to refine, then adds
+and traces the level+1 points around them. Returns the number added.
+
+**/
+
+inline int ssimtrace_refine::refine(int level)
+{
+    int u = unit(level) ;
+    bool ax[3] = { gridaxes != YZ, gridaxes != XZ, gridaxes != XY } ;
+    std::vector<int> mark(genstep.size(), 0) ;
+
+    for(unsigned i=0 ; i < genstep.size() ; i++)
+    {
+        const int4& c = cell[i] ;
+        if( c.w > level ) continue ;   // coarser points are also on the level lattice
+
+        float h = NEAR*spacing_world(i, level) ;
+        for(int r=0 ; r < num_ray && mark[i] == 0 ; r++)
+        {
+            const quad4& p = simtrace[i*num_ray + r] ;
+            if( sig[i*num_ray + r] != 0u && p.q0.f.w <= h ) mark[i] = 1 ;
+        }
+
+        C4U gsid ;
+        gsid.u = genstep[i].q0.u.z ;
+        for(int a=0 ; a < 3 ; a++)
+        {
+            if(!ax[a]) continue ;
+            for(int s=-1 ; s <= 1 ; s += 2)
+            {
+                int j = find( c.x + (a == 0 ? s*u : 0), c.y + (a == 1 ? s*u : 0), c.z + (a == 2 ? s*u : 0), gsid.c4.w ) ;
+                if( j > -1 && differs(i, j) )
+                {
+                    mark[i] = 1 ;
+                    mark[j] = 1 ;
+                }
+            }
+        }
+    }
+
+    int num_marked = genstep.size() ;
+    int v = u/2 ;
+    float s = local_scale/float(1 << (level+1)) ;
+    int num_added = 0 ;
+    for(int i=0 ; i < num_marked ; i++)
+    {
+        if( mark[i] == 0 ) continue ;
+        int4 c = cell[i] ;
+        C4U gsid ;
+        gsid.u = genstep[i].q0.u.z ;
+        for(int dx=-1 ; dx <= 1 ; dx++)
+        for(int dy=-1 ; dy <= 1 ; dy++)
+        for(int dz=-1 ; dz <= 1 ; dz++)
+        {
+            if( (dx != 0 && !ax[0]) || (dy != 0 && !ax[1]) || (dz != 0 && !ax[2]) ) continue ;
+            if( dx == 0 && dy == 0 && dz == 0 ) continue ;
+            if( find(c.x + dx*v, c.y + dy*v, c.z + dz*v, gsid.c4.w) > -1 ) continue ;
+
+            quad6 gs = genstep[i] ;
+            qat4 qt(gs) ;
+            float3 t = qt.right_multiply( make_float3( dx*s, dy*s, dz*s ), 1.f ) ;   // parent transform then child shift
+            gs.q5.f.x = t.x ;
+            gs.q5.f.y = t.y ;
+            gs.q5.f.z = t.z ;
+            add(gs, c.x + dx*v, c.y + dy*v, c.z + dz*v, level+1 );
+            num_added += 1 ;
+        }
+    }
+    return num_added ;
+}
+
+inline int ssimtrace_refine::run()
+{
+    for(int level=0 ; level < max_level ; level++)
+    {
+        int num_added = refine(level) ;
+        if( num_added == 0 ) break ;
+    }
+    return num_intersect ;
+}
+
+inline NP* ssimtrace_refine::get_genstep() const
+{
+    return SGenstep::MakeArray(genstep) ;
+}
+
+inline NP* ssimtrace_refine::get_simtrace() const
+{
+    NP* a = NP::Make<float>( simtrace.size(), 4, 4 ) ;
+    a->read2<float>( (float*)simtrace.data() );
+    return a ;
+}
+
+inline NP* ssimtrace_refine::get_cell() const
+{
+    NP* a = NP::Make<int>( cell.size(), 4 ) ;
+    a->read2<int>( (int*)cell.data() );
+    a->set_meta<int>("max_level", max_level );
+    a->set_meta<int>("num_ray", num_ray );
+    a->set_meta<float>("local_scale", local_scale );
+    return a ;
+}
+
+inline NPFold* ssimtrace_refine::serialize() const
+{
+    NPFold* fold = new NPFold ;
+    fold->add("genstep", get_genstep() );
+    fold->add("simtrace", get_simtrace() );
+    fold->add("cell", get_cell() );
+    return fold ;
+}
+
+inline std::string ssimtrace_refine::desc() const
+{
+    std::stringstream ss ;
+    ss << "ssimtrace_refine::desc"
+       << " num_ray " << num_ray
+       << " max_level " << max_level
+       << " local_scale " << local_scale
+       << " gridaxes " << SGenstep::GridAxesName(gridaxes)
+       << " num_genstep " << genstep.size()
+       << " num_simtrace " << simtrace.size()
+       << " num_intersect " << num_intersect
+       << " level_count [" ;
+    for(unsigned i=0 ; i < level_count.size() ; i++) ss << " " << level_count[i] ;
+    ss << " ]" ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -47,6 +47,12 @@ energy
 rayleigh
    populated by U4Tree::initRayleigh
 
+remap, domain_report
+   only with envvar sstandard__ADAPTIVE, when U4Tree::initAdaptive
+   fills mat and sur on the non-uniform wavelength domain of
+   sdomain_adaptive. The remap gives the texel coordinate of
+   each wavelength, see qbnd::domain_remap_lookup
+
 
 
 
@@ -85,6 +91,7 @@ In the old X4/GGeo workflow, the bnd buffer was created with::
 #include "NPX.h"
 #include "sproplist.h"
 #include "sdomain.h"
+#include "sdomain_adaptive.h"
 #include "smatsur.h"
 #include "snam.h"
 
@@ -92,7 +99,9 @@ struct sstandard
 {
     static constexpr const bool VERBOSE = false ;
     static constexpr const char* IMPLICIT_PREFIX = "Implicit_RINDEX_NoRINDEX" ;
+    static constexpr const char* sstandard__ADAPTIVE = "sstandard__ADAPTIVE" ;
     const sdomain* dom ;
+    const sdomain_adaptive* adaptive ;
 
     const NP* wavelength ;
     const NP* energy ;
@@ -104,6 +113,8 @@ struct sstandard
     const NP* optical ;
 
     const NP* icdf ;
+    const NP* remap ;
+    const NP* domain_report ;
 
 
     sstandard();
@@ -137,7 +148,8 @@ struct sstandard
         const std::vector<int4>& vbd,
         const std::vector<std::string>& bdname,
         const NP* mat,
-        const NP* sur
+        const NP* sur,
+        const NP* remap=nullptr
     );
 
     static void column_range(int4& mn, int4& mx,  const std::vector<int4>& vbd) ;
@@ -150,6 +162,7 @@ struct sstandard
 inline sstandard::sstandard()
     :
     dom(nullptr),
+    adaptive(nullptr),
     wavelength(nullptr),
     energy(nullptr),
     rayleigh(nullptr),
@@ -158,7 +171,9 @@ inline sstandard::sstandard()
     bd(nullptr),
     bnd(nullptr),
     optical(nullptr),
-    icdf(nullptr)
+    icdf(nullptr),
+    remap(nullptr),
+    domain_report(nullptr)
 {
 }
 
@@ -173,6 +188,9 @@ after mat and sur have been filled.
 * standard->mat is populated by U4Tree::initMaterials
   using U4Material::MakeStandardArray
 
+* with adaptive set by U4Tree::initAdaptive the domain has the
+  non-uniform knots of sdomain_adaptive
+
 
 **/
 
@@ -183,13 +201,15 @@ inline void sstandard::deferred_init(
         const NPFold* surface
     )
 {
-    dom = new sdomain ;
+    dom = adaptive ? new sdomain(adaptive->knots) : new sdomain ;
 
     wavelength = dom->get_wavelength_nm() ;
     energy = dom->get_energy_eV() ;
+    remap = adaptive ? adaptive->get_remap() : nullptr ;
+    domain_report = adaptive ? adaptive->report : nullptr ;
 
     bd      = make_bd(     vbd, bdname );
-    bnd     = make_bnd(    vbd, bdname, mat, sur ) ;
+    bnd     = make_bnd(    vbd, bdname, mat, sur, remap ) ;
     optical = make_optical(vbd, suname, surface) ;
 }
 
@@ -210,6 +230,8 @@ inline NPFold* sstandard::serialize() const
     fold->add(snam::OPTICAL, optical );
 
     fold->add(snam::ICDF, icdf) ;
+    fold->add(snam::REMAP, remap) ;
+    fold->add(snam::DOMAIN_REPORT, domain_report) ;
 
     return fold ;
 }
@@ -228,6 +250,8 @@ inline void sstandard::import(const NPFold* fold )
     optical = fold->get(snam::OPTICAL);
 
     icdf = fold->get(snam::ICDF);
+    remap = fold->get(snam::REMAP);
+    domain_report = fold->get(snam::DOMAIN_REPORT);
 }
 
 inline void sstandard::save(const char* base, const char* rel )
@@ -442,13 +466,17 @@ sstandard::make_bnd
 
 Form bnd array by interleaving mat and sur array entries as directed by vbd int pointers.
 
+With a non-uniform domain the remap array is required, its base step is
+used as domain_step and the texture is accessed via the remap.
+
 **/
 
 inline NP* sstandard::make_bnd(
     const std::vector<int4>& vbd,
     const std::vector<std::string>& bdname,
     const NP* mat,
-    const NP* sur )
+    const NP* sur,
+    const NP* remap )
 {
     assert( mat->shape.size() == 4 );
     assert( sur->shape.size() == 4 );
@@ -502,8 +530,9 @@ inline NP* sstandard::make_bnd(
     // metadata needed by QBnd::MakeBoundaryTex
     bnd_->set_meta<float>("domain_low",  sdomain::DomainLow() );
     bnd_->set_meta<float>("domain_high", sdomain::DomainHigh() );
-    bnd_->set_meta<float>("domain_step", sdomain::DomainStep() );
+    bnd_->set_meta<float>("domain_step", remap ? remap->get_meta<float>("domain_step", 0.f) : float(sdomain::DomainStep()) );
     bnd_->set_meta<float>("domain_range", sdomain::DomainRange() );
+    if(remap) bnd_->set_meta<int>("domain_remap", remap->shape[0] );
 
     double* bnd_v = bnd_->values<double>() ;
 
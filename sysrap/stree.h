@@ -117,6 +117,15 @@ gtd
 inst_f4
 iinst_f4
 
+With envvar stree__serialize_compact the per-node m2w, w2m are persisted
+deduplicated as 3x4 affine with gtd recomputed on import and digs, subs
+as binary 128 bit digests, see stree::serialize_transforms and scompact.h.
+stree::import_ accepts both forms.
+
+With envvar stree__serialize_soname_index the SNameIndex over soname is also
+persisted as the soname_index subfold, which stree::import_ uses when its digest
+matches the soname, otherwise the index is created on import.
+
 POSSIBLY : make saving full nds nodes optional as the
 factorization might be made to replace the full info ?
 
@@ -206,6 +215,7 @@ When SSim not in use can also use::
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <functional>
 
 #include <glm/glm.hpp>
@@ -221,6 +231,8 @@ When SSim not in use can also use::
 #include "scuda.h"
 #include "snode.h"
 #include "sdigest.h"
+#include "scompact.h"
+#include "sparallel.h"
 #include "sfreq.h"
 #include "sstr.h"
 #include "strid.h"
@@ -237,6 +249,7 @@ When SSim not in use can also use::
 #include "sstandard.h"
 #include "smatsur.h"
 #include "snam.h"
+#include "SNameIndex.h"
 #include "SBnd.h"
 #include "SCenterExtentFrame.h"
 
@@ -264,6 +277,10 @@ struct stree
     static constexpr const char* _EXTENT_PFX = "EXTENT:" ;
     static constexpr const char* stree__force_triangulate_solid = "stree__force_triangulate_solid" ;
     static constexpr const char* stree__get_frame_dump = "stree__get_frame_dump" ;
+    static constexpr const char* stree__serialize_compact = "stree__serialize_compact" ;
+    static constexpr const char* stree__serialize_soname_index = "stree__serialize_soname_index" ;
+    static constexpr const char* stree__import_skip_gtd = "stree__import_skip_gtd" ;
+    static constexpr const char* stree__NUM_THREAD = "stree__NUM_THREAD" ;   // factorize and add_inst threads, 0:hardware_concurrency
 
     static constexpr const int MAXDEPTH = 15 ; // presentational limit only
 
@@ -284,6 +301,8 @@ struct stree
     static constexpr const char* W2M = "w2m.npy" ;
     static constexpr const char* GTD = "gtd.npy" ;  // GGeo transform debug, populated in X4PhysicalVolume::convertStructure_r
     static constexpr const char* TRS = "trs.npy" ;  // optional, when use save_trs
+    static constexpr const char* TRAN = "tran.npy" ;          // compact: unique local m2w,w2m pairs (num_tran,2,4,3)
+    static constexpr const char* TRAN_IDX = "tran_idx.npy" ;  // compact: tran index for all nodes
     static constexpr const char* MTNAME = "mtname.txt" ;
     static constexpr const char* MTNAME_NO_RINDEX = "mtname_no_rindex.txt" ;
     static constexpr const char* MTINDEX = "mtindex.npy" ;
@@ -302,11 +321,14 @@ struct stree
 
 
     static constexpr const char* SONAME = "soname.txt" ;
+    static constexpr const char* SONAME_INDEX = "soname_index" ;
     static constexpr const char* CSG = "csg" ;
     static constexpr const char* _CSG = "_csg" ;
     static constexpr const char* SN = "sn" ;
     static constexpr const char* DIGS = "digs.txt" ;
     static constexpr const char* SUBS = "subs.txt" ;
+    static constexpr const char* DIGS_U8 = "digs.npy" ;  // compact: (num_nodes,16) binary digests
+    static constexpr const char* SUBS_U8 = "subs.npy" ;
     static constexpr const char* SUBS_FREQ = "subs_freq" ;
     static constexpr const char* FACTOR = "factor.npy" ;
     static constexpr const char* MATERIAL = "material" ;
@@ -337,6 +359,9 @@ struct stree
     const char*      force_triangulate_solid ;
     std::vector<int> force_triangulate_lvid ;
     bool get_frame_dump ;
+    bool serialize_compact ;
+    bool serialize_soname_index ;
+    int  num_thread ;
 
 
     std::vector<std::string> mtname ;       // unique material names
@@ -354,6 +379,7 @@ struct stree
 
     std::vector<std::string> soname_raw ;   // solid names, my have 0x pointer suffix
     std::vector<std::string> soname ;       // unique solid names, created with sstr::StripTail_Unique with _1 _2 ... uniqing
+    SNameIndex*              soname_index ; // lookup index over soname, see init_soname_index
     std::vector<sn*>         solids ;       // used from U4Tree::initSolid but not available postcache, instead use sn::Get methods
 
     std::vector<glm::tmat4x4<double>> m2w ; // local (relative to parent) "model2world" transforms for all nodes
@@ -366,6 +392,7 @@ struct stree
     std::vector<snode> tri ;               // subset of nds which are configured to be force triangulated (expected to otherwise be remainder nodes)
     std::vector<std::string> digs ;        // per-node digest for all nodes
     std::vector<std::string> subs ;        // subtree digest for all nodes
+    std::unordered_map<std::string,int> subs_first ;  // first node of each subtree digest, from classifySubtrees, not persisted
     std::vector<sfactor> factor ;          // small number of unique subtree factor, digest and freq
 
     std::vector<int> sensor_id ;           // updated by reorderSensors
@@ -461,6 +488,8 @@ struct stree
 
 
 
+    void init_soname_index();
+    const SNameIndex* get_soname_index() const ;
     int  find_lvid(const char* soname_, bool starting=true  ) const ;
 
     const std::vector<snode>* get_node_vector(      char _src ) const ; // 'N':nds 'R':rem 'T':tri
@@ -599,6 +628,9 @@ struct stree
     void save_( const char* fold ) const ;
     void save( const char* base, const char* reldir=RELDIR ) const ;
     NPFold* serialize() const ;
+    void serialize_transforms(NPFold* fold) const ;
+    void serialize_digests(NPFold* fold) const ;
+    void recompute_gtd(std::vector<glm::tmat4x4<double>>& _gtd) const ;
 
 
     template<typename S, typename T>   // S:compound type T:atomic "transport" type
@@ -612,6 +644,8 @@ struct stree
     int load( const char* base, const char* reldir=RELDIR );
     int load_( const char* fold );
     void import_(const NPFold* fold);
+    void import_transforms(const NPFold* fold);
+    void import_digests(const NPFold* fold);
 
 
     static int Compare( const std::vector<int>& a, const std::vector<int>& b ) ;
@@ -688,6 +722,7 @@ struct stree
 
 
     void add_inst( glm::tmat4x4<double>& m2w, glm::tmat4x4<double>& w2m, int gas_idx, int nidx );
+    void set_inst( int ins_idx, glm::tmat4x4<double>& m2w, glm::tmat4x4<double>& w2m, int gas_idx, int nidx );
     void add_inst_identity( int gas_idx, int nidx );
     void add_inst();
 
@@ -788,6 +823,10 @@ inline stree::stree()
     FREQ_CUT(ssys::getenvint(_FREQ_CUT, FREQ_CUT_DEFAULT)),
     force_triangulate_solid(ssys::getenvvar(stree__force_triangulate_solid,nullptr)),
     get_frame_dump(ssys::getenvbool(stree__get_frame_dump)),
+    serialize_compact(ssys::getenvbool(stree__serialize_compact)),
+    serialize_soname_index(ssys::getenvbool(stree__serialize_soname_index)),
+    num_thread(ssys::getenvint(stree__NUM_THREAD, 0)),
+    soname_index(nullptr),
     sensor_count(0),
     subs_freq(new sfreq),
     _csg(new s_csg),
@@ -1737,16 +1776,53 @@ inline sfreq* stree::make_freq(const std::vector<int>& nodes ) const
     return sf ;
 }
 
+/**
+stree::init_soname_index
+--------------------------
+
+Creates the lookup index over soname, called once the soname are
+complete from U4Tree::initSolids_Keys and from stree::import_
+(which uses the persisted index when present and matching the soname digest)
+so the const queries never need to create it.
+
+**/
+
+inline void stree::init_soname_index()
+{
+    delete soname_index ;
+    soname_index = SNameIndex::Create(soname) ;
+}
+
+/**
+stree::get_soname_index
+-------------------------
+
+Returns nullptr when the index was not created or soname has changed since.
+
+**/
+
+inline const SNameIndex* stree::get_soname_index() const
+{
+    return soname_index && soname_index->is_current() ? soname_index : nullptr ;
+}
+
 /**
 stree::find_lvid
 ------------------
 
-Find lvid index of solid with name q_soname
+Find lvid index of first solid with name q_soname, or starting with it
 
 **/
 
 inline int stree::find_lvid(const char* q_soname, bool starting ) const
 {
+    const SNameIndex* idx = get_soname_index() ;
+    if(idx)
+    {
+        unsigned count = 0 ;
+        return idx->find( q_soname, count, starting ? 'S' : 'E' ) ;
+    }
+
     int lvid = -1 ;
     for(unsigned i=0 ; i < soname.size() ; i++)
     {
@@ -3255,9 +3331,14 @@ of that factor.  This is done by stree::get_factor_nodes
 
 inline void stree::get_nodes(std::vector<int>& nodes, const char* sub) const
 {
-    for(unsigned i=0 ; i < subs.size() ; i++)
-        if(strcmp(subs[i].c_str(), sub)==0)
-            nodes.push_back(int(i)) ;
+    int num = subs.size() ;
+    int nt = sparallel::NumThread(num, num_thread) ;
+    std::vector<std::vector<int>> found(nt) ;
+    sparallel::For(num, nt, [this, &found, sub](int t, int i0, int i1)
+    {
+        for(int i=i0 ; i < i1 ; i++) if(strcmp(subs[i].c_str(), sub)==0) found[t].push_back(i) ;
+    });
+    for(int t=0 ; t < nt ; t++) nodes.insert( nodes.end(), found[t].begin(), found[t].end() );
 }
 
 inline void stree::get_depth_range(unsigned& mn, unsigned& mx, const char* sub) const
@@ -3276,8 +3357,22 @@ inline void stree::get_depth_range(unsigned& mn, unsigned& mx, const char* sub)
 }
 
 
+/**
+stree::get_first
+------------------
+
+Uses the subs_first map when populated by classifySubtrees, as the
+linear search made sortSubtrees quadratic in the number of nodes.
+
+**/
+
 inline int stree::get_first( const char* sub ) const
 {
+    if(!subs_first.empty())
+    {
+        auto it = subs_first.find(sub) ;
+        return it == subs_first.end() ? -1 : it->second ;
+    }
     for(unsigned i=0 ; i < subs.size() ; i++) if(strcmp(subs[i].c_str(), sub)==0) return int(i) ;
     return -1 ;
 }
@@ -3526,16 +3621,11 @@ inline NPFold* stree::serialize() const
     NP* _nds = NPX::ArrayFromVec<int,snode>( nds, snode::NV ) ;
     NP* _rem = NPX::ArrayFromVec<int,snode>( rem, snode::NV ) ;
     NP* _tri = NPX::ArrayFromVec<int,snode>( tri, snode::NV ) ;
-    NP* _m2w = NPX::ArrayFromVec<double,glm::tmat4x4<double>>( m2w, 4, 4 ) ;
-    NP* _w2m = NPX::ArrayFromVec<double,glm::tmat4x4<double>>( w2m, 4, 4 ) ;
-    NP* _gtd = NPX::ArrayFromVec<double,glm::tmat4x4<double>>( gtd, 4, 4 ) ;
 
     fold->add( NDS, _nds );
     fold->add( REM, _rem );
     fold->add( TRI, _tri );
-    fold->add( M2W, _m2w );
-    fold->add( W2M, _w2m );
-    fold->add( GTD, _gtd );
+    serialize_transforms(fold);
 
     NP* _mtname = NPX::Holder(mtname) ;
     NP* _mtname_no_rindex = NPX::Holder(mtname_no_rindex) ;
@@ -3564,9 +3654,9 @@ inline NPFold* stree::serialize() const
     fold->add_subfold( STANDARD, f_standard );
     fold->add_subfold( _CSG, _csg->serialize() );
     fold->add( SONAME, NPX::Holder(soname) );
+    if(serialize_soname_index && soname_index) fold->add_subfold( SONAME_INDEX, soname_index->serialize() );
 
-    fold->add( DIGS, NPX::Holder(digs) );
-    fold->add( SUBS, NPX::Holder(subs) );
+    serialize_digests(fold);
 
     NPFold* f_subs_freq = subs_freq->serialize() ;
     fold->add_subfold( SUBS_FREQ, f_subs_freq );
@@ -3636,6 +3726,108 @@ inline NPFold* stree::serialize() const
 
 
 
+/**
+stree::serialize_transforms
+-----------------------------
+
+Default full form is m2w, w2m and gtd as (num_nodes,4,4) double.
+
+With stree__serialize_compact the local m2w,w2m pairs are stored
+deduplicated as 3x4 affine in TRAN (num_tran,2,4,3) with TRAN_IDX giving
+the tran index of every node. As the gtd are the products of m2w down the
+node hierarchy they are omitted and recomputed on import, after checking here
+that the recomputation is exact. Otherwise gtd is stored 3x4 affine.
+Non-affine transforms, which are not expected, use the full form.
+
+**/
+
+inline void stree::serialize_transforms(NPFold* fold) const
+{
+    int num = m2w.size() ;
+    const double* aa = num > 0 ? glm::value_ptr(m2w[0]) : nullptr ;
+    const double* bb = num > 0 && int(w2m.size()) == num ? glm::value_ptr(w2m[0]) : nullptr ;
+    bool compact = serialize_compact && aa && bb && scompact::IsAffine(aa, num) && scompact::IsAffine(bb, num) ;
+
+    if(!compact)
+    {
+        fold->add( M2W, NPX::ArrayFromVec<double,glm::tmat4x4<double>>( m2w, 4, 4 ) );
+        fold->add( W2M, NPX::ArrayFromVec<double,glm::tmat4x4<double>>( w2m, 4, 4 ) );
+        fold->add( GTD, NPX::ArrayFromVec<double,glm::tmat4x4<double>>( gtd, 4, 4 ) );
+        return ;
+    }
+
+    NP* _tran_idx = nullptr ;
+    NP* _tran = scompact::Dedup( aa, bb, num, &_tran_idx );
+
+    int num_gtd = gtd.size() ;
+    bool gtd_recompute = false ;
+    if( num_gtd == num && int(nds.size()) == num )
+    {
+        std::vector<glm::tmat4x4<double>> _gtd ;
+        recompute_gtd(_gtd);
+        gtd_recompute = memcmp( _gtd.data(), gtd.data(), num*sizeof(glm::tmat4x4<double>) ) == 0 ;
+    }
+    _tran->set_meta<int>("num_gtd", num_gtd );
+    _tran->set_meta<int>("gtd_recompute", int(gtd_recompute) );
+
+    fold->add( TRAN, _tran );
+    fold->add( TRAN_IDX, _tran_idx );
+
+    if( num_gtd > 0 && !gtd_recompute )
+    {
+        const double* gg = glm::value_ptr(gtd[0]) ;
+        fold->add( GTD, scompact::IsAffine(gg, num_gtd) ? scompact::Affine(gg, num_gtd) : NPX::ArrayFromVec<double,glm::tmat4x4<double>>( gtd, 4, 4 ) );
+    }
+}
+
+/**
+stree::serialize_digests
+--------------------------
+
+With stree__serialize_compact the 32 char hex digs and subs are
+stored as (num_nodes,16) uint8, unless some are not hex digests.
+
+**/
+
+inline void stree::serialize_digests(NPFold* fold) const
+{
+    NP* _digs = serialize_compact ? scompact::Digest(digs) : nullptr ;
+    NP* _subs = serialize_compact ? scompact::Digest(subs) : nullptr ;
+
+    if(_digs) fold->add( DIGS_U8, _digs );
+    else      fold->add( DIGS, NPX::Holder(digs) );
+
+    if(_subs) fold->add( SUBS_U8, _subs );
+    else      fold->add( SUBS, NPX::Holder(subs) );
+}
+
+/**
+stree::recompute_gtd
+----------------------
+
+Forms the product of m2w transforms from root down to every node
+with the same operations in the same order as stree::get_node_product
+with local:false, reusing the parent product as parents precede children.
+
+**/
+
+inline void stree::recompute_gtd(std::vector<glm::tmat4x4<double>>& _gtd) const
+{
+    int num = nds.size() ;
+    assert( int(m2w.size()) == num );
+    _gtd.resize(num) ;
+    for(int nidx=0 ; nidx < num ; nidx++)
+    {
+        int parent = nds[nidx].parent ;
+        assert( parent < nidx );
+        glm::tmat4x4<double> tp(1.) ;
+        if( parent > -1 ) tp = _gtd[parent] ;
+        tp *= m2w[nidx] ;
+        _gtd[nidx] = tp ;
+    }
+}
+
+
 
 template<typename S, typename T>
 inline void stree::ImportArray( std::vector<S>& vec, const NP* a, const char* label  )
@@ -3667,6 +3859,63 @@ inline void stree::ImportNames( std::vector<std::string>& names, const NP* a, co
     a->get_names(names);
 }
 
+/**
+stree::import_transforms
+--------------------------
+
+Accepts both the full and compact forms of stree::serialize_transforms.
+The gtd recomputation can be skipped with stree__import_skip_gtd
+as the gtd are only used for debugging.
+
+**/
+
+inline void stree::import_transforms(const NPFold* fold)
+{
+    const NP* _tran = fold->get(TRAN) ;
+    if( _tran == nullptr )
+    {
+        ImportArray<glm::tmat4x4<double>, double>(m2w, fold->get(M2W), M2W );
+        ImportArray<glm::tmat4x4<double>, double>(w2m, fold->get(W2M), W2M );
+        ImportArray<glm::tmat4x4<double>, double>(gtd, fold->get(GTD), GTD );
+        return ;
+    }
+
+    const NP* _tran_idx = fold->get(TRAN_IDX) ;
+    assert( _tran_idx );
+    int num = _tran_idx->shape[0] ;
+    m2w.resize(num);
+    w2m.resize(num);
+    if(num > 0) scompact::Redup( glm::value_ptr(m2w[0]), glm::value_ptr(w2m[0]), _tran, _tran_idx );
+
+    const NP* _gtd = fold->get(GTD) ;
+    bool gtd_recompute = _tran->get_meta<int>("gtd_recompute", 0) == 1 ;
+    bool skip_gtd = ssys::getenvbool(stree__import_skip_gtd) ;
+
+    if( _gtd )
+    {
+        NP* _gtd_full = scompact::Full(_gtd) ;
+        ImportArray<glm::tmat4x4<double>, double>(gtd, _gtd_full, GTD );
+        delete _gtd_full ;
+    }
+    else if( gtd_recompute && !skip_gtd )
+    {
+        recompute_gtd(gtd);
+    }
+}
+
+inline void stree::import_digests(const NPFold* fold)
+{
+    const NP* _digs = fold->get(DIGS_U8) ;
+    const NP* _subs = fold->get(SUBS_U8) ;
+
+    if(_digs) scompact::Hex( digs, _digs );
+    else      ImportNames( digs, fold->get(DIGS), DIGS );
+
+    if(_subs) scompact::Hex( subs, _subs );
+    else      ImportNames( subs, fold->get(SUBS), SUBS );
+}
+
+
 
 inline stree* stree::Load(const char* _base, const char* reldir ) // static
 {
@@ -3711,11 +3960,11 @@ inline void stree::import_(const NPFold* fold)
     ImportArray<snode, int>( nds,                  fold->get(NDS), NDS );
     ImportArray<snode, int>( rem,                  fold->get(REM), REM );
     ImportArray<snode, int>( tri,                  fold->get(TRI), TRI );
-    ImportArray<glm::tmat4x4<double>, double>(m2w, fold->get(M2W), M2W );
-    ImportArray<glm::tmat4x4<double>, double>(w2m, fold->get(W2M), W2M );
-    ImportArray<glm::tmat4x4<double>, double>(gtd, fold->get(GTD), GTD );
+    import_transforms(fold);
 
     ImportNames( soname,            fold->get(SONAME) , SONAME);
+    delete soname_index ;
+    soname_index = SNameIndex::Load( soname, fold->get_subfold(SONAME_INDEX) );
     ImportNames( mtname,            fold->get(MTNAME) , MTNAME);
     ImportNames( mtname_no_rindex,  fold->get(MTNAME_NO_RINDEX), MTNAME_NO_RINDEX );
     ImportNames( suname,            fold->get(SUNAME) ,  SUNAME );
@@ -3761,8 +4010,7 @@ inline void stree::import_(const NPFold* fold)
     _csg->import(csg_f);
 
 
-    ImportNames( digs, fold->get(DIGS), DIGS );
-    ImportNames( subs, fold->get(SUBS), SUBS );
+    import_digests(fold);
 
     NPFold* f_subs_freq = fold->get_subfold(SUBS_FREQ) ;
     subs_freq->import(f_subs_freq);
@@ -3933,18 +4181,67 @@ This is invoked by stree::factorize
 Traverse all nodes, computing and collecting subtree digests and adding them to subs_freq
 to find the top repeaters.
 
+The digests are computed and counted by num_thread threads over contiguous
+node ranges, each with its own (sub,freq) pairs in first occurrence order.
+Merging those in thread order gives subs_freq the same order and counts
+as adding the digests one by one in node order.
+
 **/
 
 inline void stree::classifySubtrees()
 {
     if(level>0) std::cout << "[ stree::classifySubtrees " << std::endl ;
-    for(int nidx=0 ; nidx < int(nds.size()) ; nidx++)
+
+    int num_nds = nds.size() ;
+    subs.resize(num_nds) ;
+
+    int nt = sparallel::NumThread(num_nds, num_thread) ;
+    std::vector<sfreq::VSU> t_vsu(nt) ;
+    std::vector<std::vector<int>> t_first(nt) ;
+
+    sparallel::For(num_nds, nt, [this, &t_vsu, &t_first](int t, int i0, int i1)
+    {
+        std::unordered_map<std::string,int> idx ;
+        for(int nidx=i0 ; nidx < i1 ; nidx++)
+        {
+            subs[nidx] = subtree_digest(nidx) ;
+            const std::string& sub = subs[nidx] ;
+            auto it = idx.find(sub) ;
+            if( it == idx.end() )
+            {
+                idx[sub] = t_vsu[t].size() ;
+                t_vsu[t].push_back( sfreq::SU(sub, 1) );
+                t_first[t].push_back( nidx );
+            }
+            else
+            {
+                t_vsu[t][it->second].second += 1 ;
+            }
+        }
+    });
+
+    sfreq::VSU& vsu = subs_freq->vsu ;
+    std::unordered_map<std::string,int> idx ;
+    for(int i=0 ; i < int(vsu.size()) ; i++) idx[vsu[i].first] = i ;
+
+    for(int t=0 ; t < nt ; t++)
+    for(int k=0 ; k < int(t_vsu[t].size()) ; k++)
     {
-        std::string sub = subtree_digest(nidx) ;
-        subs.push_back(sub) ;
-        subs_freq->add(sub.c_str());
+        const sfreq::SU& su = t_vsu[t][k] ;
+        auto it = idx.find(su.first) ;
+        if( it == idx.end() )
+        {
+            idx[su.first] = vsu.size() ;
+            vsu.push_back(su) ;
+            subs_first[su.first] = t_first[t][k] ;
+        }
+        else
+        {
+            vsu[it->second].second += su.second ;
+        }
     }
-    if(level>0) std::cout << "] stree::classifySubtrees " << std::endl ;
+
+    if(level>0) std::cout << "] stree::classifySubtrees num_thread " << nt << std::endl ;
 }
 
 
@@ -4140,6 +4437,11 @@ stree::labelFactorSubtrees
 label all nodes of subtrees of all repeats with repeat_index,
 leaving remainder nodes at default of zero repeat_index
 
+The outer nodes of each factor are labelled by num_thread threads.
+The subtrees of the outer nodes of one factor cannot overlap, as a
+subtree cannot contain another with the same digest, so each node is
+written by one thread. Factors are labelled in order, as before.
+
 **/
 
 inline void stree::labelFactorSubtrees()
@@ -4158,47 +4460,40 @@ inline void stree::labelFactorSubtrees()
         get_nodes( outer_node, sub.c_str() );
         assert( int(outer_node.size()) ==  fac.freq );
 
-        int fac_olvid = -1 ;
-        int fac_subtree = -1 ;
-        for(unsigned i=0 ; i < outer_node.size() ; i++)
-        {
-            int outer = outer_node[i] ;
-
-            const snode& ond = nds[outer] ;
+        int num_outer = outer_node.size() ;
+        std::vector<int> outer_lvid(num_outer, -1) ;
+        std::vector<int> outer_subtree(num_outer, -1) ;
 
-            if( fac_olvid == -1 )
-            {
-                fac_olvid = ond.lvid ;
-            }
-            else
-            {
-                // all the instances should have the same outer lvid
-                assert( ond.lvid == fac_olvid );
-            }
-
-            std::vector<int> subtree ;
-            get_progeny(subtree, outer);
-            subtree.push_back(outer);
-
-            if(fac_subtree == -1)
-            {
-                fac_subtree = subtree.size() ;
-            }
-            else
+        int nt = sparallel::NumThread(num_outer, num_thread, 64) ;
+        sparallel::For(num_outer, nt, [this, &outer_node, &outer_lvid, &outer_subtree, repeat_index](int, int i0, int i1)
+        {
+            for(int i=i0 ; i < i1 ; i++)
             {
-                // all the instances must have same number of nodes
-                assert( int(subtree.size()) == fac_subtree );
+                int outer = outer_node[i] ;
+                outer_lvid[i] = nds[outer].lvid ;
+
+                std::vector<int> subtree ;
+                get_progeny(subtree, outer);
+                subtree.push_back(outer);
+                outer_subtree[i] = subtree.size() ;
+
+                for(unsigned j=0 ; j < subtree.size() ; j++)
+                {
+                    int nidx = subtree[j] ;
+                    snode& nd = nds[nidx] ;
+                    assert( nd.index == nidx );
+                    nd.repeat_index = repeat_index ;
+                    nd.repeat_ordinal = i ;
+                }
             }
+        });
 
-
-            for(unsigned j=0 ; j < subtree.size() ; j++)
-            {
-                int nidx = subtree[j] ;
-                snode& nd = nds[nidx] ;
-                assert( nd.index == nidx );
-                nd.repeat_index = repeat_index ;
-                nd.repeat_ordinal = i ;
-            }
+        int fac_olvid = num_outer > 0 ? outer_lvid[0] : -1 ;
+        int fac_subtree = num_outer > 0 ? outer_subtree[0] : -1 ;
+        for(int i=0 ; i < num_outer ; i++)
+        {
+            assert( outer_lvid[i] == fac_olvid );       // all the instances should have the same outer lvid
+            assert( outer_subtree[i] == fac_subtree );  // all the instances must have same number of nodes
         }
         fac.subtree = fac_subtree ;
         fac.olvid = fac_olvid ;
@@ -4305,20 +4600,34 @@ inline void stree::collectGlobalNodes()
     assert( rem.size() == 0u );
     assert( tri.size() == 0u );
 
-    for(int nidx=0 ; nidx < int(nds.size()) ; nidx++)
+    int num_nds = nds.size() ;
+    int nt = sparallel::NumThread(num_nds, num_thread) ;
+    std::vector<std::vector<snode>> t_rem(nt) ;
+    std::vector<std::vector<snode>> t_tri(nt) ;
+
+    sparallel::For(num_nds, nt, [this, &t_rem, &t_tri](int t, int i0, int i1)
     {
-        const snode& nd = nds[nidx] ;
-        assert( nd.index == nidx );
-        bool do_force_triangulate = is_force_triangulate(nd.lvid) ;
-        if( nd.repeat_index == 0 )
-        {
-            std::vector<snode>& dst = do_force_triangulate ? tri : rem  ;
-            dst.push_back(nd) ;
-        }
-        else
+        for(int nidx=i0 ; nidx < i1 ; nidx++)
         {
-            assert( do_force_triangulate == false && "force triangulate solid is currently only supported for remainder nodes" );
+            const snode& nd = nds[nidx] ;
+            assert( nd.index == nidx );
+            bool do_force_triangulate = is_force_triangulate(nd.lvid) ;
+            if( nd.repeat_index == 0 )
+            {
+                std::vector<snode>& dst = do_force_triangulate ? t_tri[t] : t_rem[t]  ;
+                dst.push_back(nd) ;
+            }
+            else
+            {
+                assert( do_force_triangulate == false && "force triangulate solid is currently only supported for remainder nodes" );
+            }
         }
+    });
+
+    for(int t=0 ; t < nt ; t++)
+    {
+        rem.insert( rem.end(), t_rem[t].begin(), t_rem[t].end() );
+        tri.insert( tri.end(), t_tri[t].begin(), t_tri[t].end() );
     }
     if(level>0) std::cout
        << "stree::collectGlobalNodes "
@@ -4376,6 +4685,10 @@ collectGlobalNodes
    collect global non-instanced nodes into *rem* vector and depending on envvars collect
    nodes to be force triangulated into *tri* vector
 
+The per-node passes use stree__NUM_THREAD threads (default 0 for hardware_concurrency,
+1 for serial) over contiguous node ranges, combining per-thread results in thread
+order so the factors, labels and *rem* are the same for any number of threads.
+
 
 **/
 
@@ -5060,12 +5373,36 @@ inline void stree::add_inst(
     glm::tmat4x4<double>& tr_w2m,
     int gas_idx,
     int nidx )
+{
+    int ins_idx = int(inst.size()); // follow sqat4.h::setIdentity
+
+    inst.resize(ins_idx+1);
+    iinst.resize(ins_idx+1);
+    inst_nidx.resize(ins_idx+1);
+
+    set_inst(ins_idx, tr_m2w, tr_w2m, gas_idx, nidx );
+}
+
+/**
+stree::set_inst
+-----------------
+
+Fills slot ins_idx of the already sized inst, iinst and inst_nidx vectors,
+allowing the slots of one factor to be filled concurrently.
+
+**/
+
+inline void stree::set_inst(
+    int ins_idx,
+    glm::tmat4x4<double>& tr_m2w,
+    glm::tmat4x4<double>& tr_w2m,
+    int gas_idx,
+    int nidx )
 {
     assert( nidx > -1 && nidx < int(nds.size()) );
+    assert( ins_idx > -1 && ins_idx < int(inst.size()) );
     const snode& nd = nds[nidx];    // structural volume node
 
-    int ins_idx = int(inst.size()); // follow sqat4.h::setIdentity
-
     glm::tvec4<int64_t> col3 ;   // formerly uint64_t
 
     col3.x = ins_idx ;            // formerly  +1
@@ -5076,10 +5413,9 @@ inline void stree::add_inst(
     strid::Encode(tr_m2w, col3 );
     strid::Encode(tr_w2m, col3 );
 
-    inst.push_back(tr_m2w);
-    iinst.push_back(tr_w2m);
-
-    inst_nidx.push_back(nidx);
+    inst[ins_idx] = tr_m2w ;
+    iinst[ins_idx] = tr_w2m ;
+    inst_nidx[ins_idx] = nidx ;
 }
 
 inline void stree::add_inst_identity( int gas_idx, int nidx )
@@ -5164,9 +5500,6 @@ inline void stree::add_inst()
     tot_inst += num_inst  ;
 
 
-    glm::tmat4x4<double> tr_m2w(1.) ;
-    glm::tmat4x4<double> tr_w2m(1.) ;
-
     unsigned num_factor = get_num_factor();
     for(int i=0 ; i < int(num_factor) ; i++)
     {
@@ -5187,16 +5520,25 @@ inline void stree::add_inst()
         inst_info.push_back( {ridx,num_inst,tot_inst,0} );
         tot_inst += num_inst ;
 
-        for(int j=0 ; j < num_inst ; j++)
-        {
-            nidx = nodes[j];
+        // instance transform products of the factor computed concurrently into their slots
+        int ins0 = inst.size() ;
+        inst.resize(ins0 + num_inst);
+        iinst.resize(ins0 + num_inst);
+        inst_nidx.resize(ins0 + num_inst);
 
-            bool local = false ;
-            bool reverse = false ;
-            get_node_product( tr_m2w, tr_w2m, nidx, local, reverse, nullptr  );
-
-            add_inst(tr_m2w, tr_w2m, ridx, nidx );
-        }
+        int nt = sparallel::NumThread(num_inst, num_thread, 256) ;
+        sparallel::For(num_inst, nt, [this, &nodes, ins0, ridx](int, int j0, int j1)
+        {
+            glm::tmat4x4<double> tr_m2w(1.) ;
+            glm::tmat4x4<double> tr_w2m(1.) ;
+            for(int j=j0 ; j < j1 ; j++)
+            {
+                bool local = false ;
+                bool reverse = false ;
+                get_node_product( tr_m2w, tr_w2m, nodes[j], local, reverse, nullptr  );
+                set_inst(ins0 + j, tr_m2w, tr_w2m, ridx, nodes[j] );
+            }
+        });
     }
 
 
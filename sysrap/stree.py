@@ -182,8 +182,70 @@ class stree(object):
         ta = np.array( lines, dtype="|S%d" % maxlen )
         return ta
 
+    @classmethod
+    def Full(cls, a):
+        """
+        :param a: (...,4,3) affine transforms, as scompact::Affine
+        :return b: (...,4,4) with the last column 0,0,0,1 as scompact::Full
+        """
+        b = np.zeros( a.shape[:-1] + (4,), dtype=a.dtype )
+        b[...,:3] = a
+        b[...,3,3] = 1.
+        return b
+
+    @classmethod
+    def RecomputeGTD(cls, m2w, parent, depth):
+        """
+        :param m2w: (num_nodes,4,4) local transforms
+        :param parent: (num_nodes,) parent node index, -1 for root
+        :param depth: (num_nodes,) node depth
+        :return gtd: (num_nodes,4,4) products of m2w down the node hierarchy
+
+        Follows stree::recompute_gtd gtd[nidx] = gtd[parent] * m2w[nidx]
+        with the glm summation order, processing nodes a depth at a time.
+        """
+        num = len(m2w)
+        gtd = np.zeros( (num,4,4), dtype=np.float64 )
+        for d in range(depth.max()+1 if num > 0 else 0):
+            ii = np.where( depth == d )[0]
+            L = m2w[ii]
+            G = gtd[parent[ii]] if d > 0 else np.broadcast_to( np.eye(4), L.shape )
+            gtd[ii] = G[:,0,None,:]*L[:,:,0,None] + G[:,1,None,:]*L[:,:,1,None] + G[:,2,None,:]*L[:,:,2,None] + G[:,3,None,:]*L[:,:,3,None]
+        pass
+        return gtd
+
+    @classmethod
+    def Uncompact(cls, f):
+        """
+        With stree__serialize_compact the fold has tran.npy and tran_idx.npy
+        instead of m2w, w2m and gtd (which is omitted or 3x4 affine) and
+        digs.npy subs.npy (num_nodes,16) uint8 binary digests instead of
+        the 32 char hex txt. This sets f.m2w f.w2m f.gtd f.digs f.subs
+        to the full forms, see stree::import_transforms stree::import_digests
+        """
+        tran = getattr(f, "tran", None)
+        if not tran is None:
+            pair = cls.Full(tran)[f.tran_idx]
+            f.m2w = pair[:,0]
+            f.w2m = pair[:,1]
+            gtd = getattr(f, "gtd", None)
+            if not gtd is None:
+                f.gtd = cls.Full(gtd) if gtd.shape[-1] == 3 else gtd
+            elif not getattr(f, "nds", None) is None:
+                f.gtd = cls.RecomputeGTD(f.m2w, f.nds[:,3], f.nds[:,1])   ## snode parent, depth
+            pass
+        pass
+        for key in ["digs", "subs"]:
+            a = getattr(f, key, None)
+            if not a is None and a.dtype == np.uint8:
+                setattr(f, key, np.array([bytes(d).hex() for d in a]))
+            pass
+        pass
+
     def __init__(self, f, symbol="st"):
 
+        self.Uncompact(f)
+
         #sff = Fold.Load(f.base,"subs_freq",  symbol="sf")
         sff = f.subs_freq if getattr( f, "subs_freq", None ) != None else None
 
@@ -367,7 +429,7 @@ class stree(object):
         assert type(nodes) is np.ndarray
         if self.raw_subs is None:
             path = os.path.join(self.f.base, "subs.txt")
-            self.raw_subs = np.loadtxt( path, dtype="|S32")
+            self.raw_subs = np.loadtxt( path, dtype="|S32") if os.path.exists(path) else self.f.subs.astype("|S32")
         pass
         ssub = self.raw_subs[nodes]
         ssf = sfreq.CreateFromArray(ssub)
@@ -0,0 +1,267 @@
+/**
+NP_where_test.cc
+==================
+
+::
+
+   ~/o/sysrap/tests/NP_where_test.sh
+   TEST=bench ~/o/sysrap/tests/NP_where_test.sh
+   TEST=ALL ~/o/sysrap/tests/NP_where_test.sh
+
+parity
+    for a range of predicates on sphoton fields and element forms
+    compares NP::LoadWhere and NP::LoadWhereIndex with loading the
+    entire array and filtering in memory, with block sizes that do and
+    do not divide the number of items. Also checks the saved index
+    array used as where spec for another array, predicates via
+    NP::LoadSlice and rejection of malformed predicates.
+
+bench
+    time and bytes held for selecting hits with NP::LoadWhere compared
+    with NP::Load of the entire array then filtering
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cstring>
+
+#include "ssys.h"
+#include "schrono.h"
+#include "NP.hh"
+
+struct NP_where_test
+{
+    typedef std::int64_t INT ;
+    static const char* FOLD ;
+    static NP* MakePhoton(int ni, unsigned seed);
+    static void Select(std::vector<INT>& idx, const NP* a, const char* expr);
+
+    static int parity();
+    static int bench();
+    static int Main();
+};
+
+const char* NP_where_test::FOLD = ssys::getenvvar("FOLD", "/tmp/NP_where_test") ;
+
+/**
+NP_where_test::MakePhoton
+---------------------------
+
+(ni,4,4) photons with random time, wavelength, boundary, flag, identity
+and flagmask in the sphoton layout.
+
+**/
+
+inline NP* NP_where_test::MakePhoton(int ni, unsigned seed)
+{
+    NP* a = NP::Make<float>(ni, 4, 4) ;
+    float* ff = a->values<float>() ;
+    unsigned* uu = (unsigned*)ff ;
+    std::mt19937 rng(seed) ;
+    std::uniform_real_distribution<float> u(0.f, 100.f) ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        float* f = ff + i*16 ;
+        unsigned* q = uu + i*16 ;
+        for(int j=0 ; j < 3 ; j++) f[j] = u(rng) - 50.f ;
+        f[3] = u(rng) ;                      // time
+        f[11] = 300.f + 4.f*u(rng) ;         // wavelength
+        unsigned flag = 0x1u << ( rng() % 14 ) ;
+        unsigned boundary = rng() % 20 ;
+        q[12] = ( boundary << 16 ) | flag ;
+        q[13] = rng() % 50000 ;              // identity
+        q[14] = ( rng() % 2 ) << 31 | ( i & 0x7fffffff ) ;
+        q[15] = flag | ( 0x1u << ( rng() % 14 )) ;
+    }
+    return a ;
+}
+
+/**
+NP_where_test::Select
+-----------------------
+
+Reference in memory selection, written against the sphoton layout
+independently of NP_where.
+
+**/
+
+inline void NP_where_test::Select(std::vector<INT>& idx, const NP* a, const char* expr)
+{
+    const float* ff = a->cvalues<float>() ;
+    const unsigned* uu = (const unsigned*)ff ;
+    for(INT i=0 ; i < a->shape[0] ; i++)
+    {
+        const float* f = ff + i*16 ;
+        const unsigned* q = uu + i*16 ;
+        unsigned flag = q[12] & 0xffff ;
+        unsigned boundary = q[12] >> 16 ;
+        bool sel = false ;
+        if(strcmp(expr, "flag==0x40") == 0)                     sel = flag == 0x40 ;
+        if(strcmp(expr, "flag==0x40&&boundary==3") == 0)        sel = flag == 0x40 && boundary == 3 ;
+        if(strcmp(expr, "time>10&&time<20") == 0)               sel = f[3] > 10.f && f[3] < 20.f ;
+        if(strcmp(expr, "identity>=1000 && identity<2000") == 0) sel = q[13] >= 1000 && q[13] < 2000 ;
+        if(strcmp(expr, "flagmask&0x40") == 0)                  sel = ( q[15] & 0x40 ) != 0 ;
+        if(strcmp(expr, "boundary==3||boundary==7") == 0)       sel = boundary == 3 || boundary == 7 ;
+        if(strcmp(expr, "u[3,0]>>16<=2&&f[2,3]>=500") == 0)     sel = boundary <= 2 && f[11] >= 500.f ;
+        if(strcmp(expr, "idx<100||pos_x>49.5") == 0)            sel = ( q[14] & 0x7fffffff ) < 100 || f[0] > 49.5f ;
+        if(strcmp(expr, "i[0,3]!=0") == 0)                      sel = *(const int*)(f + 3) != 0 ;
+        if(sel) idx.push_back(i) ;
+    }
+}
+
+inline int NP_where_test::parity()
+{
+    int ni = 100003 ;
+    NP* a = MakePhoton(ni, 1) ;
+    NP* b = NP::Make<int>(ni, 2) ;   // stand-in for another array of the same event
+    int* bb = b->values<int>() ;
+    for(int i=0 ; i < ni*2 ; i++) bb[i] = i ;
+
+    std::string dir = std::string(FOLD) + "/parity" ;
+    a->save(dir.c_str(), "photon.npy");
+    b->save(dir.c_str(), "other.npy");
+    std::string path = dir + "/photon.npy" ;
+    std::string other = dir + "/other.npy" ;
+    std::string wpath = dir + "/w.npy" ;
+
+    const char* EXPR[] = {
+        "flag==0x40",
+        "flag==0x40&&boundary==3",
+        "time>10&&time<20",
+        "identity>=1000 && identity<2000",
+        "flagmask&0x40",
+        "boundary==3||boundary==7",
+        "u[3,0]>>16<=2&&f[2,3]>=500",
+        "idx<100||pos_x>49.5",
+        "i[0,3]!=0"
+    } ;
+    const char* CHUNK[] = { "65536", "1000", "1" } ;
+
+    int rc = 0 ;
+    for(unsigned c=0 ; c < sizeof(CHUNK)/sizeof(char*) ; c++)
+    {
+        setenv(NP::NP__WHERE_CHUNK, CHUNK[c], 1) ;
+        for(unsigned e=0 ; e < sizeof(EXPR)/sizeof(char*) ; e++)
+        {
+            const char* expr = EXPR[e] ;
+            std::vector<INT> ref ;
+            Select(ref, a, expr);
+
+            NP* s = NP::LoadWhere(path.c_str(), expr, wpath.c_str()) ;
+            NP* w = NP::LoadWhereIndex(path.c_str(), expr) ;
+            NP* o = NP::LoadSlice(other.c_str(), wpath.c_str()) ;
+
+            int mismatch = 0 ;
+            mismatch += int( s == nullptr || w == nullptr || o == nullptr ) ;
+            if( mismatch ) std::cout << "NP_where_test::parity FAIL expr [" << expr << "]\n" ;
+            if( mismatch ) { rc += 1 ; continue ; }
+
+            mismatch += int( s->shape[0] != INT(ref.size()) || w->shape[0] != INT(ref.size()) || o->shape[0] != INT(ref.size()) ) ;
+            mismatch += int( NP::get_meta_string(s->meta, "where") != expr ) ;
+            const INT* ww = w->cvalues<INT>() ;
+            for(unsigned i=0 ; i < ref.size() && mismatch == 0 ; i++)
+            {
+                mismatch += int( ww[i] != ref[i] ) ;
+                mismatch += int( memcmp( s->bytes() + i*64, a->bytes() + ref[i]*64, 64 ) != 0 ) ;
+                mismatch += int( o->cvalues<int>()[2*i] != 2*ref[i] ) ;
+            }
+            if( c == 0 ) std::cout
+                << "NP_where_test::parity"
+                << " expr " << std::setw(35) << expr
+                << " count " << std::setw(7) << ref.size()
+                << " mismatch " << mismatch
+                << "\n"
+                ;
+            rc += int( mismatch > 0 ) ;
+            delete s ;
+            delete w ;
+            delete o ;
+        }
+    }
+    unsetenv(NP::NP__WHERE_CHUNK) ;
+
+    NP* l = NP::LoadSlice(path.c_str(), "flagmask&0x40") ;
+    std::vector<INT> ref ;
+    Select(ref, a, "flagmask&0x40");
+    rc += int( l == nullptr || l->shape[0] != INT(ref.size()) ) ;
+    delete l ;
+
+    const char* BAD[] = { "nonesuch==1", "flag===1", "u[4,0]==1", "u[3]==1", "time&0x1", "flag==", "" } ;
+    for(unsigned i=0 ; i < sizeof(BAD)/sizeof(char*) ; i++)
+    {
+        NP* x = NP::LoadWhereIndex(path.c_str(), BAD[i]) ;
+        rc += int( x != nullptr ) ;
+        delete x ;
+    }
+
+    std::cout << "NP_where_test::parity rc " << rc << "\n" ;
+    delete a ;
+    delete b ;
+    return rc ;
+}
+
+inline int NP_where_test::bench()
+{
+    int ni = ssys::getenvint("NUM_PHOTON", 4000000) ;
+    const char* expr = ssys::getenvvar("EXPR", "flagmask&0x40&&time<20") ;
+    std::string dir = std::string(FOLD) + "/bench" ;
+    {
+        NP* a = MakePhoton(ni, 2) ;
+        a->save(dir.c_str(), "photon.npy");
+        delete a ;
+    }
+    std::string path = dir + "/photon.npy" ;
+
+    schrono::TP t0 = schrono::stamp();
+    NP* a = NP::Load(path.c_str()) ;
+    std::vector<INT> ref ;
+    const unsigned* uu = (const unsigned*)a->bytes() ;
+    const float* ff = a->cvalues<float>() ;
+    for(INT i=0 ; i < ni ; i++) if(( uu[i*16+15] & 0x40 ) && ff[i*16+3] < 20.f ) ref.push_back(i) ;
+    NP* h0 = NP::Make<float>(ref.size(), 4, 4) ;
+    for(unsigned i=0 ; i < ref.size() ; i++) memcpy( h0->bytes() + i*64, a->bytes() + ref[i]*64, 64 ) ;
+    schrono::TP t1 = schrono::stamp();
+    INT held0 = a->arr_bytes() + h0->arr_bytes() ;
+    delete a ;
+
+    schrono::TP t2 = schrono::stamp();
+    NP* h1 = NP::LoadWhere(path.c_str(), expr) ;
+    schrono::TP t3 = schrono::stamp();
+    INT held1 = h1->arr_bytes() + 64*U::GetEnvInt(NP::NP__WHERE_CHUNK, 65536) ;
+
+    std::cout
+        << "NP_where_test::bench"
+        << " ni " << ni
+        << " expr " << expr
+        << " count " << h1->shape[0]
+        << "\n"
+        << " load_then_filter " << std::fixed << std::setprecision(4) << schrono::duration(t0, t1)
+        << " held_bytes " << held0
+        << "\n"
+        << " load_where       " << schrono::duration(t2, t3)
+        << " held_bytes " << held1
+        << "\n"
+        ;
+
+    int rc = int( h0->shape[0] != h1->shape[0] || memcmp(h0->bytes(), h1->bytes(), h0->arr_bytes()) != 0 ) ;
+    delete h0 ;
+    delete h1 ;
+    return rc ;
+}
+
+inline int NP_where_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "parity") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"parity")==0) rc += parity();
+    if(ALL||strcmp(TEST,"bench")==0)  rc += bench();
+    return rc ;
+}
+
+int main()
+{
+    return NP_where_test::Main() ;
+}
@@ -0,0 +1,42 @@
+#!/bin/bash
+usage(){ cat << EOU
+NP_where_test.sh
+=======================
+
+::
+
+   ~/o/sysrap/tests/NP_where_test.sh
+   TEST=bench ~/o/sysrap/tests/NP_where_test.sh
+   TEST=ALL ~/o/sysrap/tests/NP_where_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=NP_where_test
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=${TMP:-/tmp/$USER/opticks}/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+vars="BASH_SOURCE PWD FOLD name bin TEST"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc -std=c++17 -O3 -lstdc++ -I.. -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE compile error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
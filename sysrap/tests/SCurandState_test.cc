@@ -23,6 +23,8 @@ struct SCurandState_test
     static int ChunkLoadSave();
     static int load();
     static int loadAndUpload();
+    static int generate();
+    static int loadRange();
 
     static int Main();
 };
@@ -117,6 +119,71 @@ inline int SCurandState_test::loadAndUpload()
 }
 
 
+/**
+SCurandState_test::generate
+-----------------------------
+
+Compares host generated states with those of the chunk file, 
+which when created by QCurandState::initChunk on GPU checks the 
+host curand_init implementation is bitwise compatible. 
+
+**/
+
+inline int SCurandState_test::generate()
+{
+    SCurandChunk c = Chunk(); 
+    scurandref<RNG> lref = c.load(); 
+    if( lref.states == nullptr ) return 0 ;  // no chunk file to compare with 
+
+    RNG* h = c.generate(); 
+    unsigned long long mismatch = 0 ; 
+    for(unsigned long long i=0 ; i < lref.num ; i++)
+    {
+        const RNG& a = lref.states[i] ; 
+        const RNG& b = h[i] ; 
+        bool same = a.d == b.d && memcmp(a.v, b.v, sizeof(a.v)) == 0 ; 
+        if(!same) mismatch += 1 ; 
+    }
+    std::cout 
+        << "SCurandState_test::generate"
+        << " num " << lref.num 
+        << " mismatch " << mismatch 
+        << "\n" 
+        ; 
+    free(h); 
+    free(lref.states); 
+    return mismatch == 0 ? 0 : 1 ; 
+}
+
+inline int SCurandState_test::loadRange()
+{
+    SCurandState cs ; 
+    if(!cs.is_complete()) return 0 ; 
+
+    typedef unsigned long long ULL ; 
+    ULL slot0 = cs.all.num/2 - 1000 ;   // typically straddles chunks  
+    ULL num = 2000 ; 
+    scurandref<RNG> r = cs.loadRange(slot0, num); 
+
+    RNG* h = (RNG*)malloc(sizeof(RNG)*num); 
+    SCurandXORWOW::Get().fill( h, num, cs.all.seed, slot0, cs.all.offset ); 
+
+    int mismatch = 0 ; 
+    for(ULL i=0 ; i < num ; i++) mismatch += memcmp(r.states[i].v, h[i].v, sizeof(h[i].v)) != 0 ; 
+
+    std::cout 
+        << "SCurandState_test::loadRange"
+        << " slot0 " << slot0 
+        << " num " << num 
+        << " mismatch " << mismatch 
+        << "\n" 
+        ; 
+    free(h); 
+    free(r.states); 
+    return mismatch == 0 ? 0 : 1 ; 
+}
+
+
 inline int SCurandState_test::Main()
 {
     const char* TEST = ssys::getenvvar("TEST", "ALL");
@@ -129,6 +196,8 @@ inline int SCurandState_test::Main()
     if(ALL||strcmp(TEST,"ChunkLoadSave") == 0)   rc += ChunkLoadSave(); 
     if(ALL||strcmp(TEST,"load") == 0)            rc += load(); 
     if(ALL||strcmp(TEST,"loadAndUpload") == 0)   rc += loadAndUpload(); 
+    if(ALL||strcmp(TEST,"generate") == 0)        rc += generate(); 
+    if(ALL||strcmp(TEST,"loadRange") == 0)       rc += loadRange(); 
     return rc ; 
 }
 
@@ -21,6 +21,9 @@ bin=$FOLD/$name
 #test=ChunkLoadSave
 #test=ctor
 #test=load
+#test=loadAndUpload
+#test=generate
+#test=loadRange
 test=loadAndUpload
 
 export TEST=${TEST:-$test}
@@ -67,7 +70,7 @@ fi
 
 if [ "${arg/build}" != "$arg" ]; then
     gcc $name.cc \
-          -std=c++11 -lstdc++ -lm -lcrypto -lssl -g -I.. \
+          -std=c++11 -lstdc++ -lm -lcrypto -lssl -lpthread -g -I.. \
           -I$CUDA_PREFIX/include \
           -L$CUDA_PREFIX/lib64 -lcudart \
          -o $bin
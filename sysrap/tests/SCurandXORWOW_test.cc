@@ -0,0 +1,186 @@
+/**
+SCurandXORWOW_test.cc
+=======================
+
+::
+
+   ~/o/sysrap/tests/SCurandXORWOW_test.sh
+
+Checks the host curand_init equivalent for internal consistency:
+
+1. skipahead by n matches n xorwow steps
+2. table matrix-vector product matches the bitwise one
+3. subsequence skipping composes additively
+4. multithreaded fill matches per-state init
+
+And for bitwise compatibility with device curand_init:
+
+5. fill matches ranges at the start, middle and end of each SCurandChunk
+   file found in the RNG directory, as created on GPU by QCurandState::initChunk.
+   Skipped when there are no chunk files.
+
+**/
+
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <chrono>
+#include <cstdlib>
+
+#include "SCurandXORWOW.h"
+#include "SCurandChunk.h"
+
+typedef SCurandXORWOW::State State ;
+typedef unsigned long long ULL ;
+
+struct SCurandXORWOW_test
+{
+    static bool Same(const State& a, const State& b);
+    static int skipahead();
+    static int tabvec();
+    static int sequence();
+    static int fill();
+    static int chunk();
+    static int Main();
+};
+
+inline bool SCurandXORWOW_test::Same(const State& a, const State& b)
+{
+    return a.d == b.d && memcmp(a.v, b.v, sizeof(a.v)) == 0 ;
+}
+
+inline int SCurandXORWOW_test::skipahead()
+{
+    const SCurandXORWOW& x = SCurandXORWOW::Get();
+    ULL nn[] = { 0, 1, 2, 3, 7, 100, 1023, 4096, 12345 } ;
+    for(int i=0 ; i < int(sizeof(nn)/sizeof(ULL)) ; i++)
+    {
+        State a, b ;
+        x.init(42ull, 0ull, 0ull, a );
+        x.init(42ull, 0ull, nn[i], b );
+
+        uint32_t last_a = 0 ;
+        for(ULL j=0 ; j < nn[i] ; j++) last_a = SCurandXORWOW::Next(a) ;
+        assert( Same(a, b) );
+        if( nn[i] > 0 ) assert( last_a == a.v[4] + a.d );
+    }
+    std::cout << "SCurandXORWOW_test::skipahead\n" ;
+    return 0 ;
+}
+
+inline int SCurandXORWOW_test::tabvec()
+{
+    const SCurandXORWOW& x = SCurandXORWOW::Get();
+    srand(1);
+    for(int i=0 ; i < 1000 ; i++)
+    {
+        uint32_t a[5], b[5] ;
+        for(int w=0 ; w < 5 ; w++) a[w] = b[w] = uint32_t(rand()) ^ (uint32_t(rand()) << 16) ;
+        SCurandXORWOW::MatVec(a, x.seq_pow[0]);
+        SCurandXORWOW::TabVec(b, x.seq_tab.data());
+        assert( memcmp(a, b, sizeof(a)) == 0 );
+    }
+    std::cout << "SCurandXORWOW_test::tabvec\n" ;
+    return 0 ;
+}
+
+inline int SCurandXORWOW_test::sequence()
+{
+    const SCurandXORWOW& x = SCurandXORWOW::Get();
+    ULL aa[] = { 1, 5, 1000, 1000000, 123456789ull, 3000000000ull } ;
+    for(int i=0 ; i < int(sizeof(aa)/sizeof(ULL)) ; i++)
+    {
+        ULL a = aa[i] ;
+        ULL b = 3*a + 1 ;
+        State s0, s1 ;
+        x.init(0ull, a+b, 10ull, s0 );
+        x.init(0ull, a, 10ull, s1 );
+        uint32_t v[5] ;
+        for(int w=0 ; w < 5 ; w++) v[w] = s1.v[w] ;
+        x.skipahead_sequence(b, v);
+        assert( memcmp(v, s0.v, sizeof(v)) == 0 );
+        assert( s0.d == s1.d );
+    }
+    std::cout << "SCurandXORWOW_test::sequence\n" ;
+    return 0 ;
+}
+
+inline int SCurandXORWOW_test::fill()
+{
+    const SCurandXORWOW& x = SCurandXORWOW::Get();
+    ULL num = 1000000 ;
+    ULL id0 = 5000000 ;
+    std::vector<State> ss(num) ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    x.fill( ss.data(), num, 0ull, id0, 0ull );
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> dt = t1 - t0 ;
+
+    for(ULL i=0 ; i < num ; i += 9973 )
+    {
+        State s ;
+        x.init(0ull, id0+i, 0ull, s );
+        assert( Same(s, ss[i]) );
+    }
+    std::cout << "SCurandXORWOW_test::fill num " << num << " dt " << dt.count() << " s " << x.desc() << "\n" ;
+    return 0 ;
+}
+
+inline int SCurandXORWOW_test::chunk()
+{
+    std::vector<SCurandChunk> chunks ;
+    SCurandChunk::ParseDir(chunks);
+    if( chunks.size() == 0 ) std::cout << "SCurandXORWOW_test::chunk no chunk files in " << SCurandChunk::Dir() << " : SKIP\n" ;
+    if( chunks.size() == 0 ) return 0 ;
+
+    const SCurandXORWOW& x = SCurandXORWOW::Get();
+    const ULL num = 1000 ;
+    std::vector<State> ss(num) ;
+
+    int rc = 0 ;
+    for(unsigned c=0 ; c < chunks.size() ; c++)
+    {
+        const scurandref<curandStateXORWOW>& ref = chunks[c].ref ;
+        if( ref.num < num ) continue ;
+        ULL ii[3] = { 0, ref.num/2, ref.num - num } ;
+
+        for(int j=0 ; j < 3 ; j++)
+        {
+            scurandref<curandStateXORWOW> r = chunks[c].loadRange(ii[j], num) ;
+            if( r.states == nullptr ) continue ;   // invalid chunk file
+
+            x.fill( ss.data(), num, ref.seed, r.chunk_offset, ref.offset );
+
+            ULL mismatch = 0 ;
+            for(ULL i=0 ; i < num ; i++) mismatch += ( r.states[i].d != ss[i].d || memcmp(r.states[i].v, ss[i].v, sizeof(ss[i].v)) != 0 ) ;
+            rc += int( mismatch > 0 ) ;
+
+            std::cout
+                << "SCurandXORWOW_test::chunk"
+                << " " << chunks[c].name()
+                << " slot0 " << r.chunk_offset
+                << " num " << num
+                << " mismatch " << mismatch
+                << "\n"
+                ;
+            free(r.states);
+        }
+    }
+    return rc ;
+}
+
+inline int SCurandXORWOW_test::Main()
+{
+    const char* TEST = getenv("TEST") ;
+    bool ALL = TEST == nullptr || strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"skipahead")==0) rc += skipahead();
+    if(ALL||strcmp(TEST,"tabvec")==0)    rc += tabvec();
+    if(ALL||strcmp(TEST,"sequence")==0)  rc += sequence();
+    if(ALL||strcmp(TEST,"fill")==0)      rc += fill();
+    if(ALL||strcmp(TEST,"chunk")==0)     rc += chunk();
+    return rc ;
+}
+
+int main(){ return SCurandXORWOW_test::Main() ; }
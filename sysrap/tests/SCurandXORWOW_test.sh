@@ -0,0 +1,48 @@
+#!/bin/bash
+usage(){ cat << EOU
+SCurandXORWOW_test.sh
+=======================
+
+::
+
+   ~/o/sysrap/tests/SCurandXORWOW_test.sh
+   TEST=fill ~/o/sysrap/tests/SCurandXORWOW_test.sh
+   TEST=chunk ~/o/sysrap/tests/SCurandXORWOW_test.sh
+
+The chunk test compares with the SCurandChunk files in the RNG directory,
+default \$HOME/.opticks/rngcache/RNG, skipping when there are none.
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=SCurandXORWOW_test
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=${TMP:-/tmp/$USER/opticks}/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+vars="BASH_SOURCE PWD FOLD name bin TEST CUDA_PREFIX"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc -std=c++11 -O2 -lstdc++ -lm -lcrypto -lssl -lpthread -I.. -I$CUDA_PREFIX/include -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE compile error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
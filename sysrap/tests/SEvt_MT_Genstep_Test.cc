@@ -0,0 +1,275 @@
+/**
+SEvt_MT_Genstep_Test.cc
+=========================
+
+Stress test of SEvt::AddGenstep from many concurrent std::thread
+with SEvt::MT_GENSTEP per-thread collection, checking the gensteps
+gathered after SEvt::MergeThreadGenstep are complete and
+ordered by (thread index, sequence) with consistent photon offsets.
+
+ConcurrentMerge
+    a merging thread repeatedly merges while the workers are still adding,
+    no genstep may be lost or duplicated and the sequence of each thread
+    must remain in order
+
+WorkerMerge
+    each worker merges only its own gensteps as at the end of a G4 worker
+    event, the gensteps of each thread must be contiguous
+
+EventConsume
+    each worker runs several events, each collecting then merging and
+    consuming its gensteps as SEvt::endOfEvent does (merge, gather, clear_genstep)
+    under SEvt::LockMTGenstep while other workers are still adding, merging
+    and clearing. Each consumer must see exactly the gensteps of its own
+    event with photon offsets starting from zero
+
+::
+
+    ~/opticks/sysrap/tests/SEvt_MT_Genstep_Test.sh
+
+**/
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cassert>
+
+#include "OPTICKS_LOG.hh"
+#include "OpticksGenstep.h"
+#include "SEvt.hh"
+#include "NP.hh"
+
+struct SEvt_MT_Genstep_Test
+{
+    static constexpr const int NUM_THREAD = 32 ;
+    static constexpr const int NUM_PER_THREAD = 2000 ;
+
+    static int NumPhoton(int seq){ return 1 + seq % 5 ; }
+    static void Collect(int thread);
+    static int Check(const SEvt* evt, bool contiguous);
+    static int Joined(SEvt* evt);
+    static int ConcurrentMerge(SEvt* evt);
+    static int WorkerMerge(SEvt* evt);
+    static int Consume(SEvt* evt, int thread);
+    static int EventConsume(SEvt* evt);
+    static int Main();
+};
+
+/**
+SEvt_MT_Genstep_Test::Collect
+-------------------------------
+
+Thread index is the reverse of the launch order, so ordering
+by registration would fail the check.
+
+**/
+
+void SEvt_MT_Genstep_Test::Collect(int t)
+{
+    int thread = NUM_THREAD - 1 - t ;
+    SEvt::SetGenstepThreadIndex(thread);
+    for(int i=0 ; i < NUM_PER_THREAD ; i++)
+    {
+        quad6 q ;
+        q.zero();
+        q.q0.u.x = OpticksGenstep_TORCH ;
+        q.q0.u.w = NumPhoton(i) ;
+        q.q1.u.x = thread ;
+        q.q1.u.y = i ;
+        SEvt::AddGenstep(q);
+    }
+}
+
+int SEvt_MT_Genstep_Test::Joined(SEvt* evt)
+{
+    for(int ev=0 ; ev < 3 ; ev++)
+    {
+        std::vector<std::thread> workers ;
+        for(int t=0 ; t < NUM_THREAD ; t++) workers.emplace_back( Collect, t );
+        for(int t=0 ; t < NUM_THREAD ; t++) workers[t].join();
+
+        assert( evt->getNumGenstepFromGenstep() == 0 );  // nothing reaches SEvt before merge
+
+        int num = SEvt::MergeThreadGenstep();
+        assert( num == NUM_THREAD*NUM_PER_THREAD );
+
+        NP* gs = evt->gatherGenstep();
+        NP* gl = evt->gatherGS();
+        std::cout << " ev " << ev << " gs " << gs->sstr() << " gl " << gl->sstr() << std::endl ;
+        assert( gs->shape[0] == num );
+        assert( gl->shape[0] == num );
+
+        const quad6* qq = (const quad6*)gs->cvalues<float>() ;
+        const sgs* ll = (const sgs*)gl->cvalues<int>() ;
+
+        int offset = 0 ;
+        for(int j=0 ; j < num ; j++)
+        {
+            int thread = j / NUM_PER_THREAD ;
+            int seq = j % NUM_PER_THREAD ;
+            assert( int(qq[j].q1.u.x) == thread );
+            assert( int(qq[j].q1.u.y) == seq );
+            assert( ll[j].index == j );
+            assert( ll[j].photons == NumPhoton(seq) );
+            assert( ll[j].offset == offset );
+            offset += ll[j].photons ;
+        }
+        assert( evt->getNumPhotonCollected() == offset );
+
+        delete gs ;
+        delete gl ;
+        evt->clear_genstep();
+    }
+    return 0 ;
+}
+
+/**
+SEvt_MT_Genstep_Test::Check
+-----------------------------
+
+All gensteps of all threads are present once with the sequence of each
+thread in order. With contiguous the gensteps of each thread must also
+form a single run, as expected when each thread merges its own.
+
+**/
+
+int SEvt_MT_Genstep_Test::Check(const SEvt* evt, bool contiguous)
+{
+    NP* gs = evt->gatherGenstep();
+    int num = gs->shape[0] ;
+    const quad6* qq = (const quad6*)gs->cvalues<float>() ;
+
+    std::vector<int> next(NUM_THREAD, 0) ;
+    int num_run = 0 ;
+    for(int j=0 ; j < num ; j++)
+    {
+        int thread = qq[j].q1.u.x ;
+        int seq = qq[j].q1.u.y ;
+        assert( thread >= 0 && thread < NUM_THREAD );
+        assert( seq == next[thread] );
+        next[thread] += 1 ;
+        if( j == 0 || int(qq[j-1].q1.u.x) != thread ) num_run += 1 ;
+    }
+    for(int t=0 ; t < NUM_THREAD ; t++) assert( next[t] == NUM_PER_THREAD );
+    assert( num == NUM_THREAD*NUM_PER_THREAD );
+    if(contiguous) assert( num_run == NUM_THREAD );
+
+    std::cout << " num " << num << " num_run " << num_run << std::endl ;
+    delete gs ;
+    return 0 ;
+}
+
+int SEvt_MT_Genstep_Test::ConcurrentMerge(SEvt* evt)
+{
+    std::atomic<bool> done(false) ;
+    std::atomic<int> num_merge(0) ;
+    std::thread merger([&]()
+        {
+            while(!done) num_merge += int( SEvt::MergeThreadGenstep() > 0 ) ;
+        });
+
+    std::vector<std::thread> workers ;
+    for(int t=0 ; t < NUM_THREAD ; t++) workers.emplace_back( Collect, t );
+    for(int t=0 ; t < NUM_THREAD ; t++) workers[t].join();
+    done = true ;
+    merger.join();
+    SEvt::MergeThreadGenstep();
+
+    std::cout << "SEvt_MT_Genstep_Test::ConcurrentMerge num_merge " << num_merge << std::endl ;
+    Check(evt, false);
+    evt->clear_genstep();
+    return 0 ;
+}
+
+int SEvt_MT_Genstep_Test::WorkerMerge(SEvt* evt)
+{
+    std::vector<std::thread> workers ;
+    for(int t=0 ; t < NUM_THREAD ; t++) workers.emplace_back( [t]()
+        {
+            Collect(t);
+            SEvt::MergeThreadGenstep();
+        });
+    for(int t=0 ; t < NUM_THREAD ; t++) workers[t].join();
+
+    std::cout << "SEvt_MT_Genstep_Test::WorkerMerge" << std::endl ;
+    Check(evt, true);
+    evt->clear_genstep();
+    return 0 ;
+}
+
+/**
+SEvt_MT_Genstep_Test::Consume
+-------------------------------
+
+End of event style consumer of the gensteps of the calling thread.
+Without the lock the merge of another worker or its clear_genstep
+could land between this merge and gather.
+
+**/
+
+int SEvt_MT_Genstep_Test::Consume(SEvt* evt, int thread)
+{
+    std::unique_lock<std::recursive_mutex> lock = SEvt::LockMTGenstep() ;
+
+    int num = SEvt::MergeThreadGenstep();
+    NP* gs = evt->gatherGenstep();
+    NP* gl = evt->gatherGS();
+
+    int bad = int( num != NUM_PER_THREAD ) + int( gs->shape[0] != num ) + int( gl->shape[0] != num ) ;
+    const quad6* qq = (const quad6*)gs->cvalues<float>() ;
+    const sgs* ll = (const sgs*)gl->cvalues<int>() ;
+
+    int offset = 0 ;
+    for(int j=0 ; j < int(gs->shape[0]) && bad == 0 ; j++)
+    {
+        bad += int( int(qq[j].q1.u.x) != thread ) ;
+        bad += int( int(qq[j].q1.u.y) != j ) ;
+        bad += int( ll[j].offset != offset ) ;
+        offset += ll[j].photons ;
+    }
+
+    delete gs ;
+    delete gl ;
+    evt->clear_genstep();
+    return bad ;
+}
+
+int SEvt_MT_Genstep_Test::EventConsume(SEvt* evt)
+{
+    std::atomic<int> num_bad(0) ;
+    std::vector<std::thread> workers ;
+    for(int t=0 ; t < NUM_THREAD ; t++) workers.emplace_back( [t, evt, &num_bad]()
+        {
+            for(int ev=0 ; ev < 5 ; ev++)
+            {
+                Collect(t);
+                num_bad += int( Consume(evt, NUM_THREAD - 1 - t) > 0 ) ;
+            }
+        });
+    for(int t=0 ; t < NUM_THREAD ; t++) workers[t].join();
+
+    std::cout << "SEvt_MT_Genstep_Test::EventConsume num_bad " << num_bad << std::endl ;
+    assert( num_bad == 0 );
+    assert( evt->getNumGenstepFromGenstep() == 0 );
+    return num_bad == 0 ? 0 : 1 ;
+}
+
+int SEvt_MT_Genstep_Test::Main()
+{
+    SEvt::SetMTGenstep(true);
+    SEvt* evt = SEvt::Create(SEvt::EGPU) ;
+    assert(evt);
+
+    int rc = 0 ;
+    rc += Joined(evt);
+    rc += ConcurrentMerge(evt);
+    rc += WorkerMerge(evt);
+    rc += EventConsume(evt);
+    return rc ;
+}
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+    return SEvt_MT_Genstep_Test::Main() ;
+}
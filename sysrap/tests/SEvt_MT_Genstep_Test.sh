@@ -0,0 +1,22 @@
+#!/bin/bash
+usage(){ cat << EOU
+SEvt_MT_Genstep_Test.sh
+=========================
+
+::
+
+   ~/opticks/sysrap/tests/SEvt_MT_Genstep_Test.sh
+
+Drives concurrent SEvt::AddGenstep from many std::thread with
+SEvt__MT_GENSTEP per-thread collection and checks the merged gensteps.
+
+EOU
+}
+
+bin=SEvt_MT_Genstep_Test
+
+export SEvt__MT_GENSTEP=1
+$bin
+[ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 1
+
+exit 0
@@ -0,0 +1,199 @@
+/**
+SGenstepShard_test.cc
+=======================
+
+~/o/sysrap/tests/SGenstepShard_test.sh
+
+TEST=Shards ~/o/sysrap/tests/SGenstepShard_test.sh
+TEST=Simulate ~/o/sysrap/tests/SGenstepShard_test.sh
+
+**/
+
+#include "ssys.h"
+#include "SGenstepShard.h"
+
+struct SGenstepShard_test
+{
+    static NP* MakeGenstep(int num_gs, int seed);
+    static NP* FakeSimulate(const NP* gs, int backend);
+
+    static int Shards();
+    static int Simulate();
+    static int SaveLoadMerge();
+
+    static int Main();
+};
+
+/**
+SGenstepShard_test::MakeGenstep
+---------------------------------
+
+Gensteps with irregular photon counts, the genstep index
+is kept in q0.u.z so the fake simulation can label its hits.
+
+**/
+
+NP* SGenstepShard_test::MakeGenstep(int num_gs, int seed)
+{
+    std::vector<int> num_ph(num_gs) ;
+    unsigned s = seed ;
+    for(int i=0 ; i < num_gs ; i++)
+    {
+        s = s*1664525u + 1013904223u ;
+        num_ph[i] = 1 + ( s >> 16 ) % 1000 ;
+    }
+    NP* gs = SGenstep::MakeTestArray(num_ph);
+    quad6* qq = (quad6*)gs->values<float>() ;
+    for(int i=0 ; i < num_gs ; i++) qq[i].q0.u.z = i ;
+    return gs ;
+}
+
+/**
+SGenstepShard_test::FakeSimulate
+----------------------------------
+
+Stand-in for a simulation backend : every third photon of each
+genstep becomes a hit, with idx local to the slice as required
+by the SGenstepShard protocol.
+
+**/
+
+NP* SGenstepShard_test::FakeSimulate(const NP* gs, int backend)
+{
+    const quad6* qq = (const quad6*)gs->cvalues<float>() ;
+    int num_gs = gs->shape[0] ;
+
+    std::vector<sphoton> hh ;
+    unsigned idx = 0 ;
+    for(int i=0 ; i < num_gs ; i++)
+    {
+        int num_ph = SGenstep::GetNumPhoton(qq[i]) ;
+        for(int j=0 ; j < num_ph ; j++)
+        {
+            if( j % 3 == 0 )
+            {
+                sphoton p = {} ;
+                p.pos.x = float(qq[i].q0.u.z) ;
+                p.pos.y = float(j) ;
+                p.set_idx(idx) ;
+                hh.push_back(p);
+            }
+            idx += 1 ;
+        }
+    }
+    NP* hit = NP::Make<float>( hh.size(), 4, 4 );
+    if(hh.size() > 0) hit->read2<float>( (float*)hh.data() );
+    return hit ;
+}
+
+int SGenstepShard_test::Shards()
+{
+    NP* gs = MakeGenstep(1000, 42);
+    int total = SGenstep::GetPhotonTotal(gs);
+
+    for(int num_shard=1 ; num_shard <= 16 ; num_shard*=2 )
+    {
+        std::vector<sslice> shard ;
+        SGenstepShard::GetShards(shard, gs, num_shard);
+        std::cout << "num_shard " << num_shard << "\n" << sslice::Desc(shard) ;
+
+        assert( int(shard.size()) == num_shard );
+        assert( sslice::TotalPhoton(shard) == total );
+        for(int i=0 ; i < int(shard.size()) ; i++)
+        {
+            // balance limited by largest genstep of 1000 photons
+            int ideal = total/num_shard ;
+            assert( std::abs(shard[i].ph_count - ideal) <= 2*1000 );
+            if(i > 0) assert( shard[i].gs_start == shard[i-1].gs_stop );
+        }
+    }
+    return 0 ;
+}
+
+/**
+SGenstepShard_test::Simulate
+------------------------------
+
+Sharded hits must be identical to unsharded hits, with
+idx the global photon index.
+
+**/
+
+int SGenstepShard_test::Simulate()
+{
+    NP* gs = MakeGenstep(1000, 42);
+    int total = SGenstep::GetPhotonTotal(gs);
+
+    int max_slot = total ;
+    NP* h0 = SGenstepShard::Simulate(gs, 1, max_slot, FakeSimulate );
+
+    std::vector<int> cum(1, 0) ;
+    const quad6* qq = (const quad6*)gs->cvalues<float>() ;
+    for(int i=0 ; i < gs->shape[0] ; i++) cum.push_back( cum.back() + SGenstep::GetNumPhoton(qq[i]) );
+
+    const sphoton* hh = (const sphoton*)h0->cvalues<float>() ;
+    for(int i=0 ; i < h0->shape[0] ; i++)
+    {
+        int igs = int(hh[i].pos.x) ;
+        int j = int(hh[i].pos.y) ;
+        assert( int(hh[i].idx()) == cum[igs] + j );
+    }
+
+    for(int num_shard=2 ; num_shard <= 8 ; num_shard*=2 )
+    {
+        NP* h1 = SGenstepShard::Simulate(gs, num_shard, max_slot/7, FakeSimulate );
+        std::cout << " num_shard " << num_shard << " h0 " << h0->sstr() << " h1 " << h1->sstr() << "\n" ;
+        assert( h1->shape[0] == h0->shape[0] );
+        assert( memcmp( h0->bytes(), h1->bytes(), h0->arr_bytes() ) == 0 );
+        delete h1 ;
+    }
+    delete h0 ;
+    return 0 ;
+}
+
+int SGenstepShard_test::SaveLoadMerge()
+{
+    const char* dir = ssys::getenvvar("FOLD", "/tmp/SGenstepShard_test") ;
+    NP* gs = MakeGenstep(100, 1);
+    int num_shard = 3 ;
+    SGenstepShard::Save(gs, num_shard, dir );
+
+    // stand-in for separate processes each simulating one shard folder
+    NPFold* fold = NPFold::Load(dir);
+    for(int i=0 ; i < fold->get_num_subfold() ; i++)
+    {
+        std::string name = SGenstepShard::ShardName(i) ;
+        NPFold* sub = fold->get_subfold(name.c_str());
+        const NP* sgs = sub->get(SGenstepShard::GENSTEP);
+        NP* hit = SGenstepShard::SimulateShard(sgs, { 0, sgs->shape[0], 0, SGenstep::GetPhotonTotal(sgs) }, 1000000, FakeSimulate, i );
+        hit->save(dir, name.c_str(), "hit.npy");
+    }
+
+    NP* h0 = SGenstepShard::Simulate(gs, 1, 1000000, FakeSimulate );
+    NP* h1 = SGenstepShard::LoadMerge(dir);
+    assert( h1->shape[0] == h0->shape[0] );
+    assert( memcmp( h0->bytes(), h1->bytes(), h0->arr_bytes() ) == 0 );
+    return 0 ;
+}
+
+
+int SGenstepShard_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST","ALL");
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"Shards") == 0 )        rc += Shards();
+    if(ALL||strcmp(TEST,"Simulate") == 0 )      rc += Simulate();
+    if(ALL||strcmp(TEST,"SaveLoadMerge") == 0 ) rc += SaveLoadMerge();
+
+    std::cout
+        << "SGenstepShard_test::Main"
+        << " TEST " << TEST
+        << " rc " << rc
+        << "\n"
+        ;
+    return rc ;
+}
+
+int main(){ return SGenstepShard_test::Main() ; }
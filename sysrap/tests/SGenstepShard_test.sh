@@ -0,0 +1,46 @@
+#!/bin/bash 
+usage(){ cat << EOU
+SGenstepShard_test.sh
+======================
+
+~/o/sysrap/tests/SGenstepShard_test.sh
+
+EOU
+}
+cd $(dirname $(realpath $BASH_SOURCE))
+
+
+name=SGenstepShard_test
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+
+bin=$FOLD/$name
+
+defarg=info_build_run
+arg=${1:-$defarg}
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+#test=Simulate
+test=ALL
+export TEST=${TEST:-$test}
+
+vars="BASH_SOURCE name test TEST"
+
+if [ "${arg/info}" != "$arg" ]; then 
+   for var in $vars ; do printf "%20s : %s\n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -lstdc++ -g -I$CUDA_PREFIX/include -I$OPTICKS_PREFIX/externals/glm/glm -I.. -lm -lpthread -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+fi
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
+
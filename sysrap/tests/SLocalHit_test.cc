@@ -0,0 +1,183 @@
+/**
+SLocalHit_test.cc
+===================
+
+::
+
+   ~/o/sysrap/tests/SLocalHit_test.sh
+
+Compares SLocalHit batch conversion against per-hit conversion
+following SEvt::getLocalHit, using a synthetic stree with translated
+instance transforms carrying encoded sensor identity.
+
+**/
+
+#include <iostream>
+#include <cassert>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ssys.h"
+#include "SLocalHit.h"
+
+struct SLocalHit_test
+{
+    static constexpr const int NUM_INST = 1000 ;
+    static void Populate(stree& st);
+    static NP*  MakeHit(int num_hit);
+    static void Reference(sphit& ht, sphoton& lp, const sphoton& p, const stree& st );
+
+    static int Convert();
+    static int Cull();
+    static int Main();
+};
+
+inline void SLocalHit_test::Populate(stree& st)
+{
+    for(int i=0 ; i < NUM_INST ; i++)
+    {
+        glm::tvec3<double> t( 100.*i, -50.*i, 25.*(i % 7) );
+        glm::tmat4x4<double> m2w = glm::translate( glm::tmat4x4<double>(1.), t );
+        glm::tmat4x4<double> w2m = glm::inverse(m2w) ;
+
+        glm::tvec4<int64_t> col3 = { i, 0, 1000 + i, i % 17 } ;   // iindex, gas, sensor_identifier, sensor_index
+        strid::Encode( m2w, col3 );
+        strid::Encode( w2m, col3 );
+
+        st.inst.push_back(m2w);
+        st.iinst.push_back(w2m);
+    }
+}
+
+inline NP* SLocalHit_test::MakeHit(int num_hit)
+{
+    NP* hit = NP::Make<float>( num_hit, 4, 4 );
+    sphoton* hh = (sphoton*)hit->bytes() ;
+    for(int i=0 ; i < num_hit ; i++)
+    {
+        sphoton& p = hh[i] ;
+        p.zero();
+        p.iindex = (i*31) % NUM_INST ;
+        p.pos = make_float3( 100.f*p.iindex + 1.f, -50.f*p.iindex + 2.f, float(i % 100) );
+        p.mom = make_float3( 0.f, 0.f, 1.f );
+        p.pol = make_float3( 1.f, 0.f, 0.f );
+        p.time = 0.1f*i ;
+        p.set_idx(i*3) ;
+    }
+    return hit ;
+}
+
+inline void SLocalHit_test::Reference(sphit& ht, sphoton& lp, const sphoton& p, const stree& st )
+{
+    lp = p ;
+    const glm::tmat4x4<double>* tr = st.get_iinst(p.iindex) ;
+    assert(tr);
+    lp.transform( *tr, true );
+
+    glm::tvec4<int64_t> col3 = {} ;
+    strid::Decode( *tr, col3 );
+    ht.iindex = col3[0] ;
+    ht.sensor_identifier = col3[2] ;
+    ht.sensor_index = col3[3] ;
+}
+
+inline int SLocalHit_test::Convert()
+{
+    stree st ;
+    Populate(st);
+    NP* hit = MakeHit(100000) ;
+    const sphoton* hh = (const sphoton*)hit->bytes() ;
+
+    int nt[] = { 1, 4, 16 } ;
+    for(int t=0 ; t < 3 ; t++)
+    {
+        SLocalHit lh ;
+        lh.convert(hit, &st, nt[t] );
+        std::cout << "SLocalHit_test::Convert num_thread " << nt[t] << " " << lh.desc() << "\n" ;
+        assert( lh.num() == hit->shape[0] );
+        assert( lh.num_missing == 0 );
+
+        for(int i=0 ; i < lh.num() ; i++)
+        {
+            sphit ht ;
+            sphoton lp ;
+            Reference(ht, lp, hh[i], st );
+            assert( lh.hidx[i] == i );
+            assert( lh.ht[i] == ht );
+            assert( lh.local[i].pos.x == lp.pos.x && lh.local[i].pos.y == lp.pos.y && lh.local[i].pos.z == lp.pos.z );
+            assert( lh.global[i].pos.x == hh[i].pos.x );
+        }
+    }
+    delete hit ;
+    return 0 ;
+}
+
+/**
+SLocalHit_test::Cull
+----------------------
+
+The culled selection must not depend on the number of threads
+and must keep close to the efficiency fraction.
+
+**/
+
+inline int SLocalHit_test::Cull()
+{
+    stree st ;
+    Populate(st);
+    NP* hit = MakeHit(100000) ;
+
+    SLocalHit a ;
+    a.efficiency = [](const sphit& ht){ return ht.sensor_index % 2 == 0 ? 0.5 : 1.0 ; } ;
+    a.convert(hit, &st, 1 );
+
+    SLocalHit b ;
+    b.efficiency = a.efficiency ;
+    b.convert(hit, &st, 8 );
+
+    std::cout << "SLocalHit_test::Cull a " << a.desc() << "\n" ;
+    std::cout << "SLocalHit_test::Cull b " << b.desc() << "\n" ;
+
+    assert( a.num() == b.num() );
+    assert( a.hidx == b.hidx );
+
+    int num_even = 0 ;
+    int kept_even = 0 ;
+    const sphoton* hh = (const sphoton*)hit->bytes() ;
+    for(int i=0 ; i < hit->shape[0] ; i++) num_even += ( ((hh[i].iindex) % 17) % 2 == 0 ) ;
+    for(int i=0 ; i < a.num() ; i++)
+    {
+        if( a.ht[i].sensor_index % 2 == 0 ) kept_even += 1 ;
+        assert( a.global[i].idx() == hh[a.hidx[i]].idx() );
+    }
+    int kept_odd = a.num() - kept_even ;
+    int num_odd = hit->shape[0] - num_even ;
+    double frac = double(kept_even)/double(num_even) ;
+
+    std::cout
+        << "SLocalHit_test::Cull"
+        << " num_even " << num_even
+        << " kept_even " << kept_even
+        << " frac " << frac
+        << " num_odd " << num_odd
+        << " kept_odd " << kept_odd
+        << "\n"
+        ;
+
+    assert( kept_odd == num_odd );
+    assert( frac > 0.48 && frac < 0.52 );
+
+    delete hit ;
+    return 0 ;
+}
+
+inline int SLocalHit_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "ALL");
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"Convert")==0) rc += Convert();
+    if(ALL||strcmp(TEST,"Cull")==0)    rc += Cull();
+    return rc ;
+}
+
+int main(){ return SLocalHit_test::Main() ; }
@@ -0,0 +1,48 @@
+#!/bin/bash
+usage(){ cat << EOU
+SLocalHit_test.sh
+===================
+
+::
+
+   ~/o/sysrap/tests/SLocalHit_test.sh
+   TEST=Cull ~/o/sysrap/tests/SLocalHit_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=SLocalHit_test
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+vars="BASH_SOURCE PWD FOLD CUDA_PREFIX name bin TEST"
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc -std=c++17 -lstdc++ -lm -lcrypto -lssl -lpthread \
+           -I.. \
+           -I$CUDA_PREFIX/include \
+           -I$OPTICKS_PREFIX/externals/glm/glm \
+           -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE compile error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
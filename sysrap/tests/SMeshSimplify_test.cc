@@ -0,0 +1,297 @@
+/**
+SMeshSimplify_test.cc
+=======================
+
+::
+
+   ~/o/sysrap/tests/SMeshSimplify_test.sh
+   TEST=sphere ~/o/sysrap/tests/SMeshSimplify_test.sh
+
+weld
+    UV sphere with duplicated seam vertices welds to a closed mesh
+
+box
+    finely subdivided box faces collapse to few triangles with zero error
+
+sphere
+    sphere simplified at several max_error stays closed (Euler characteristic 2)
+    with every vertex within max_error plus original sag of the true surface
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <cmath>
+#include <cstring>
+#include <cassert>
+
+#include "ssys.h"
+#include "SMeshSimplify.h"
+
+struct SMeshSimplify_test
+{
+    static void Sphere(NP*& vtx, NP*& tri, double radius, int nu, int nv );
+    static void Box(NP*& vtx, NP*& tri, double halfside, int n );
+    static int  Euler(const NP* vtx, const NP* tri, int& num_bad_edge );
+
+    static int weld();
+    static int box();
+    static int sphere();
+    static int Main();
+};
+
+/**
+SMeshSimplify_test::Sphere
+----------------------------
+
+Each latitude ring has nu+1 vertices, the last duplicating
+the first, and the poles are repeated for every segment.
+So the seam and poles are only closed after welding.
+
+**/
+
+inline void SMeshSimplify_test::Sphere(NP*& vtx, NP*& tri, double radius, int nu, int nv )
+{
+    vtx = NP::Make<double>( (nu+1)*(nv+1), 3 );
+    double* vv = vtx->values<double>() ;
+    for(int j=0 ; j <= nv ; j++)
+    for(int i=0 ; i <= nu ; i++)
+    {
+        double th = M_PI*double(j)/double(nv) ;
+        double ph = 2.*M_PI*double(i % nu)/double(nu) ;
+        double* p = vv + 3*(j*(nu+1)+i) ;
+        p[0] = radius*std::sin(th)*std::cos(ph) ;
+        p[1] = radius*std::sin(th)*std::sin(ph) ;
+        p[2] = radius*std::cos(th) ;
+    }
+
+    std::vector<int> tt ;
+    for(int j=0 ; j < nv ; j++)
+    for(int i=0 ; i < nu ; i++)
+    {
+        int a = j*(nu+1)+i ;
+        int b = a + 1 ;
+        int c = a + (nu+1) ;
+        int d = c + 1 ;
+        if( j > 0 )    { tt.push_back(a) ; tt.push_back(c) ; tt.push_back(b) ; }
+        if( j < nv-1 ) { tt.push_back(b) ; tt.push_back(c) ; tt.push_back(d) ; }
+    }
+    tri = NP::Make<int>( tt.size()/3, 3 );
+    memcpy( tri->bytes(), tt.data(), tri->arr_bytes() );
+}
+
+/**
+SMeshSimplify_test::Box
+-------------------------
+
+Six faces each of n*n quads with their own vertices,
+so shared box edges need welding.
+
+**/
+
+inline void SMeshSimplify_test::Box(NP*& vtx, NP*& tri, double h, int n )
+{
+    std::vector<double> pp ;
+    std::vector<int> tt ;
+    for(int face=0 ; face < 6 ; face++)
+    {
+        int axis = face/2 ;
+        double sign = face % 2 == 0 ? 1. : -1. ;
+        int a1 = (axis+1)%3 ;
+        int a2 = (axis+2)%3 ;
+        int base = pp.size()/3 ;
+        for(int j=0 ; j <= n ; j++)
+        for(int i=0 ; i <= n ; i++)
+        {
+            double p[3] ;
+            p[axis] = sign*h ;
+            p[a1] = -h + 2.*h*double(i)/double(n) ;
+            p[a2] = -h + 2.*h*double(j)/double(n) ;
+            pp.insert(pp.end(), p, p+3);
+        }
+        for(int j=0 ; j < n ; j++)
+        for(int i=0 ; i < n ; i++)
+        {
+            int a = base + j*(n+1)+i ;
+            int b = a + 1 ;
+            int c = a + (n+1) ;
+            int d = c + 1 ;
+            if( sign > 0. ) { int q[6] = { a,b,c, b,d,c } ; tt.insert(tt.end(), q, q+6) ; }
+            else            { int q[6] = { a,c,b, b,c,d } ; tt.insert(tt.end(), q, q+6) ; }
+        }
+    }
+    vtx = NP::Make<double>( pp.size()/3, 3 );
+    memcpy( vtx->bytes(), pp.data(), vtx->arr_bytes() );
+    tri = NP::Make<int>( tt.size()/3, 3 );
+    memcpy( tri->bytes(), tt.data(), tri->arr_bytes() );
+}
+
+/**
+SMeshSimplify_test::Euler
+---------------------------
+
+Returns V - E + F and counts edges not shared by exactly two faces
+
+**/
+
+inline int SMeshSimplify_test::Euler(const NP* vtx, const NP* tri, int& num_bad_edge )
+{
+    const int* tt = tri->cvalues<int>() ;
+    int nt = tri->shape[0] ;
+    std::map<std::pair<int,int>, int> edge ;
+    for(int t=0 ; t < nt ; t++)
+    for(int j=0 ; j < 3 ; j++)
+    {
+        int a = tt[3*t+j] ;
+        int b = tt[3*t+(j+1)%3] ;
+        edge[std::make_pair(std::min(a,b), std::max(a,b))] += 1 ;
+    }
+    num_bad_edge = 0 ;
+    for(auto it = edge.begin() ; it != edge.end() ; it++) if( it->second != 2 ) num_bad_edge += 1 ;
+    return vtx->shape[0] - int(edge.size()) + nt ;
+}
+
+inline int SMeshSimplify_test::weld()
+{
+    NP* vtx = nullptr ;
+    NP* tri = nullptr ;
+    Sphere(vtx, tri, 100., 64, 32 );
+
+    int bad0 = 0 ;
+    Euler(vtx, tri, bad0);
+
+    NP* o_vtx = nullptr ;
+    NP* o_tri = nullptr ;
+    SMeshSimplify::Apply(o_vtx, o_tri, vtx, tri, 0. );
+
+    int bad1 = 0 ;
+    int chi = Euler(o_vtx, o_tri, bad1);
+
+    std::cout
+        << "SMeshSimplify_test::weld"
+        << " vtx " << vtx->sstr() << " -> " << o_vtx->sstr()
+        << " tri " << tri->sstr() << " -> " << o_tri->sstr()
+        << " bad_edge " << bad0 << " -> " << bad1
+        << " euler " << chi
+        << "\n"
+        ;
+
+    assert( bad0 > 0 );
+    assert( bad1 == 0 );
+    assert( chi == 2 );
+    assert( o_vtx->shape[0] == 64*31 + 2 );
+    assert( o_tri->shape[0] == tri->shape[0] );
+    return 0 ;
+}
+
+inline int SMeshSimplify_test::box()
+{
+    NP* vtx = nullptr ;
+    NP* tri = nullptr ;
+    Box(vtx, tri, 50., 20 );
+
+    SMeshSimplify ms(1e-6) ;
+    ms.load(vtx, tri);
+    ms.weld();
+    ms.simplify();
+    ms.compact();
+    std::cout << ms.desc() << "\n" ;
+
+    NP* o_vtx = ms.get_vtx();
+    NP* o_tri = ms.get_tri();
+
+    int bad = 0 ;
+    int chi = Euler(o_vtx, o_tri, bad);
+
+    const double* vv = o_vtx->cvalues<double>() ;
+    double dev = 0. ;   // max distance of vertices from the box surface
+    for(int i=0 ; i < o_vtx->shape[0] ; i++)
+    {
+        double m = std::max( std::abs(vv[3*i+0]), std::max( std::abs(vv[3*i+1]), std::abs(vv[3*i+2]) )) ;
+        dev = std::max( dev, std::abs(m - 50.) ) ;
+    }
+
+    std::cout
+        << "SMeshSimplify_test::box"
+        << " tri " << tri->shape[0] << " -> " << o_tri->shape[0]
+        << " euler " << chi
+        << " bad_edge " << bad
+        << " dev " << dev
+        << "\n"
+        ;
+
+    assert( chi == 2 && bad == 0 );
+    assert( o_tri->shape[0] < tri->shape[0]/20 );
+    assert( dev < 1e-6 );
+    return 0 ;
+}
+
+inline int SMeshSimplify_test::sphere()
+{
+    double radius = 100. ;
+    int nu = ssys::getenvint("SMeshSimplify_test__NU", 256) ;
+    int nv = nu/2 ;
+
+    NP* vtx = nullptr ;
+    NP* tri = nullptr ;
+    Sphere(vtx, tri, radius, nu, nv );
+
+    double sag = radius*(1. - std::cos(M_PI/double(nv))) ;   // max chord sag of the input
+    double errs[] = { 0.01, 0.1, 1., 5. } ;
+
+    for(int k=0 ; k < int(sizeof(errs)/sizeof(double)) ; k++)
+    {
+        SMeshSimplify ms(errs[k]) ;
+        ms.load(vtx, tri);
+        ms.weld();
+        ms.simplify();
+        ms.compact();
+
+        NP* o_vtx = ms.get_vtx();
+        NP* o_tri = ms.get_tri();
+
+        int bad = 0 ;
+        int chi = Euler(o_vtx, o_tri, bad);
+
+        const double* vv = o_vtx->cvalues<double>() ;
+        double dev = 0. ;
+        for(int i=0 ; i < o_vtx->shape[0] ; i++)
+        {
+            double r = std::sqrt( vv[3*i+0]*vv[3*i+0] + vv[3*i+1]*vv[3*i+1] + vv[3*i+2]*vv[3*i+2] ) ;
+            dev = std::max( dev, std::abs(r - radius) ) ;
+        }
+
+        std::cout
+            << "SMeshSimplify_test::sphere"
+            << " max_error " << std::setw(5) << errs[k]
+            << " tri " << tri->shape[0] << " -> " << std::setw(7) << o_tri->shape[0]
+            << " euler " << chi
+            << " bad_edge " << bad
+            << " vertex_dev " << std::setprecision(4) << dev
+            << " sag " << sag
+            << "\n"
+            ;
+
+        assert( chi == 2 && bad == 0 );
+        assert( dev <= errs[k] + sag );
+        assert( o_tri->shape[0] <= tri->shape[0] );
+    }
+    return 0 ;
+}
+
+inline int SMeshSimplify_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "ALL") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"weld")==0)   rc += weld();
+    if(ALL||strcmp(TEST,"box")==0)    rc += box();
+    if(ALL||strcmp(TEST,"sphere")==0) rc += sphere();
+    return rc ;
+}
+
+int main()
+{
+    return SMeshSimplify_test::Main() ;
+}
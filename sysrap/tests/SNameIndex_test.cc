@@ -0,0 +1,244 @@
+/**
+SNameIndex_test.cc
+====================
+
+::
+
+   ~/o/sysrap/tests/SNameIndex_test.sh
+   TEST=bench ~/o/sysrap/tests/SNameIndex_test.sh
+   TEST=ALL ~/o/sysrap/tests/SNameIndex_test.sh
+
+parity
+    compares indexed SName::getIndex, findIndex (exact and starting) and
+    findIndices (E,S,C) with the scans of an SName without index,
+    for queries that are full names, prefixes, substrings and misses
+
+persist
+    saves the index, loads it back for the same names and checks
+    queries, then checks that a changed name list is detected as stale
+
+bench
+    timings of scans and indexed queries
+
+The names are the meshname.txt of the GEOM geometry when available,
+otherwise synthetic names with common prefixes, 0x pointer suffixes
+and duplicates.
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cstring>
+
+#include "ssys.h"
+#include "schrono.h"
+#include "SName.h"
+
+struct SNameIndex_test
+{
+    static void Names(std::vector<std::string>& names);
+    static void Queries(std::vector<std::string>& qq, const std::vector<std::string>& names, unsigned seed);
+
+    static int parity();
+    static int persist();
+    static int bench();
+    static int Main();
+};
+
+inline void SNameIndex_test::Names(std::vector<std::string>& names)
+{
+    SName* geom = SName::GEOMLoad() ;
+    if(geom && geom->getNumName() > 0)
+    {
+        names = geom->name ;
+        return ;
+    }
+
+    const char* base[] = { "sTopRock_dome", "sBar", "sPanel", "HamamatsuR12860sMask_virtual", "NNVTMCPPMT_PMT_20inch_inner", "PMT_3inch_body", "sStrut", "GLw1" } ;
+    unsigned num_base = sizeof(base)/sizeof(char*) ;
+    std::mt19937 rng(1) ;
+    for(unsigned i=0 ; i < 20000 ; i++)
+    {
+        std::stringstream ss ;
+        ss << base[rng() % num_base] ;
+        if( i % 7 != 0 ) ss << "_" << ( rng() % 5000 ) ;
+        if( i % 3 == 0 ) ss << "0x" << std::hex << ( 0x5f00000 + rng() % 0x100000 ) ;
+        names.push_back(ss.str());
+    }
+    names.push_back("sBar");   // duplicates
+    names.push_back("sBar");
+    names.push_back("");
+}
+
+inline void SNameIndex_test::Queries(std::vector<std::string>& qq, const std::vector<std::string>& names, unsigned seed)
+{
+    std::mt19937 rng(seed) ;
+    unsigned num_name = names.size() ;
+    for(unsigned i=0 ; i < 300 ; i++)
+    {
+        const std::string& n = names[rng() % num_name] ;
+        size_t a = n.empty() ? 0 : rng() % n.size() ;
+        size_t b = n.empty() ? 0 : rng() % ( n.size() - a + 1 ) ;
+        qq.push_back(n);
+        qq.push_back(n.substr(0, b));
+        qq.push_back(n.substr(a, b));
+        qq.push_back(n + "x");
+    }
+    qq.push_back("sBar");
+    qq.push_back("sBa");
+    qq.push_back("0x");
+    qq.push_back("_virtual0x");
+    qq.push_back("");
+    qq.push_back("NoSuchName");
+}
+
+inline int SNameIndex_test::parity()
+{
+    std::vector<std::string> names ;
+    Names(names);
+    std::vector<std::string> qq ;
+    Queries(qq, names, 2);
+
+    SName scan(names) ;
+    SName fast(names) ;
+    fast.make_index();
+
+    int mismatch = 0 ;
+    const char* qts = "ESC" ;
+    for(unsigned i=0 ; i < qq.size() ; i++)
+    {
+        const char* q = qq[i].c_str() ;
+        unsigned c0, c1 ;
+        mismatch += int( scan.getIndex(q, c0) != fast.getIndex(q, c1) || c0 != c1 ) ;
+        for(int s=0 ; s < 2 ; s++)
+        {
+            mismatch += int( scan.findIndex(q, c0, -1, s) != fast.findIndex(q, c1, -1, s) || c0 != c1 ) ;
+            mismatch += int( scan.findIndex(q, c0, 1, s) != fast.findIndex(q, c1, 1, s) ) ;
+        }
+        for(int t=0 ; t < 3 ; t++)
+        {
+            std::vector<unsigned> i0, i1 ;
+            scan.findIndices(i0, q, qts[t]);
+            fast.findIndices(i1, q, qts[t]);
+            mismatch += int( i0 != i1 ) ;
+        }
+    }
+
+    std::cout
+        << "SNameIndex_test::parity"
+        << " num_name " << names.size()
+        << " num_query " << qq.size()
+        << " mismatch " << mismatch
+        << "\n"
+        << fast.index->desc()
+        << "\n"
+        ;
+    return mismatch == 0 ? 0 : 1 ;
+}
+
+inline int SNameIndex_test::persist()
+{
+    std::vector<std::string> names ;
+    Names(names);
+    std::vector<std::string> qq ;
+    Queries(qq, names, 3);
+
+    const char* dir = ssys::getenvvar("FOLD", "/tmp/SNameIndex_test") ;
+    SNameIndex* a = SNameIndex::Create(names) ;
+    a->save(dir, "names");
+
+    SNameIndex* b = SNameIndex::Load(names, dir, "names") ;
+    int mismatch = 0 ;
+    mismatch += int( a->table != b->table || a->order != b->order || a->tri_post != b->tri_post ) ;
+    for(unsigned i=0 ; i < qq.size() ; i++)
+    {
+        const char* q = qq[i].c_str() ;
+        unsigned c0, c1 ;
+        mismatch += int( a->find(q, c0, 'S') != b->find(q, c1, 'S') || c0 != c1 ) ;
+        mismatch += int( a->find(q, c0, 'C') != b->find(q, c1, 'C') || c0 != c1 ) ;
+    }
+
+    std::vector<std::string> changed(names) ;
+    changed[0] += "_changed" ;
+    SNameIndex* c = SNameIndex::Load(changed, dir, "names") ;   // stale : rebuilt
+    unsigned count = 0 ;
+    mismatch += int( c->exact(changed[0].c_str(), count) != 0 ) ;
+
+    std::cout
+        << "SNameIndex_test::persist"
+        << " dir " << dir
+        << " mismatch " << mismatch
+        << "\n"
+        ;
+    return mismatch == 0 ? 0 : 1 ;
+}
+
+inline int SNameIndex_test::bench()
+{
+    std::vector<std::string> names ;
+    Names(names);
+    std::vector<std::string> qq ;
+    Queries(qq, names, 4);
+
+    SName scan(names) ;
+    SName fast(names) ;
+
+    schrono::TP t0 = schrono::stamp();
+    fast.make_index();
+    schrono::TP t1 = schrono::stamp();
+
+    const char* qts = "ESC" ;
+    double dt[2][3] = {} ;
+    unsigned total[2] = {} ;
+    for(int k=0 ; k < 2 ; k++)
+    {
+        const SName& sn = k == 0 ? scan : fast ;
+        for(int t=0 ; t < 3 ; t++)
+        {
+            schrono::TP ta = schrono::stamp();
+            for(unsigned i=0 ; i < qq.size() ; i++)
+            {
+                std::vector<unsigned> idxs ;
+                sn.findIndices(idxs, qq[i].c_str(), qts[t]);
+                total[k] += idxs.size() ;
+            }
+            schrono::TP tb = schrono::stamp();
+            dt[k][t] = schrono::duration(ta, tb) ;
+        }
+    }
+
+    std::cout
+        << "SNameIndex_test::bench"
+        << " num_name " << names.size()
+        << " num_query " << qq.size()
+        << " build " << std::setw(10) << std::fixed << std::setprecision(5) << schrono::duration(t0, t1)
+        << "\n"
+        ;
+    for(int t=0 ; t < 3 ; t++) std::cout
+        << " " << qts[t]
+        << " scan " << std::setw(10) << dt[0][t]
+        << " index " << std::setw(10) << dt[1][t]
+        << " ratio " << std::setw(10) << dt[0][t]/dt[1][t]
+        << "\n"
+        ;
+
+    return total[0] == total[1] ? 0 : 1 ;
+}
+
+inline int SNameIndex_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "parity") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"parity")==0)  rc += parity();
+    if(ALL||strcmp(TEST,"persist")==0) rc += persist();
+    if(ALL||strcmp(TEST,"bench")==0)   rc += bench();
+    return rc ;
+}
+
+int main()
+{
+    return SNameIndex_test::Main() ;
+}
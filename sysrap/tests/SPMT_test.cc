@@ -1,10 +1,90 @@
+/**
+SPMT_test.cc
+=============
+
+TEST=testfold (default)
+    serialize SPMT and save the testfold arrays
+
+TEST=interp
+    compare the SPropInterp.h lookups of the PMT rindex and qeshape tables
+    with NP::combined_interp_5/3, timing the scalar and batched forms,
+    returns non-zero on any mismatch
+
+**/
+
 #include "SPMT.h"
+#include "schrono.h"
+
+struct SPMT_test
+{
+    static int interp(const SPMT* pmt);
+};
+
+inline int SPMT_test::interp(const SPMT* pmt)
+{
+    const int num = 100000 ;
+    std::vector<float> en(num) ;
+    for(int i=0 ; i < num ; i++) en[i] = pmt->get_energy(i, num) ;
+
+    std::vector<float> ref(num) ;
+    std::vector<float> one(num) ;
+    std::vector<float> many(num) ;
+
+    int mismatch = 0 ;
+    double d_ref = 0. ;
+    double d_one = 0. ;
+    double d_many = 0. ;
+
+    for(int i=0 ; i < SPMT::NUM_PMTCAT ; i++)
+    for(int j=0 ; j < SPMT::NUM_LAYER ; j++)
+    for(int k=0 ; k < SPMT::NUM_PROP ; k++)
+    {
+        schrono::TP t0 = schrono::stamp();
+        for(int l=0 ; l < num ; l++) ref[l] = pmt->rindex->combined_interp_5( i, j, k, en[l] ) ;
+        schrono::TP t1 = schrono::stamp();
+        for(int l=0 ; l < num ; l++) one[l] = pmt->get_rindex( i, j, k, en[l] ) ;
+        schrono::TP t2 = schrono::stamp();
+        pmt->get_rindex_many( many.data(), en.data(), num, i, j, k );
+        schrono::TP t3 = schrono::stamp();
+
+        d_ref += schrono::duration(t0, t1) ;
+        d_one += schrono::duration(t1, t2) ;
+        d_many += schrono::duration(t2, t3) ;
+
+        for(int l=0 ; l < num ; l++) if( ref[l] != one[l] || ref[l] != many[l] ) mismatch += 1 ;
+    }
+
+    for(int i=0 ; i < SPMT::NUM_PMTCAT ; i++)
+    {
+        for(int l=0 ; l < num ; l++) ref[l] = pmt->qeshape->combined_interp_3( i, en[l] ) ;
+        for(int l=0 ; l < num ; l++) one[l] = pmt->get_qeshape( i, en[l] ) ;
+        pmt->get_qeshape_many( many.data(), en.data(), num, i );
+        for(int l=0 ; l < num ; l++) if( ref[l] != one[l] || ref[l] != many[l] ) mismatch += 1 ;
+    }
+
+    std::cout
+        << "SPMT_test::interp"
+        << " num " << num
+        << " rindex combined_interp_5 " << d_ref
+        << " get_rindex " << d_one
+        << " get_rindex_many " << d_many
+        << " speedup(many) " << ( d_many > 0. ? d_ref/d_many : 0. )
+        << " mismatch " << mismatch
+        << std::endl
+        ;
+
+    return mismatch == 0 ? 0 : 1 ;
+}
+
 
 int main(int argc, char** argv)
 {
     SPMT* pmt = SPMT::CreateFromJPMT();
     if(pmt == nullptr) return 1 ;
 
+    const char* TEST = ssys::getenvvar("TEST", "testfold");
+    if(strcmp(TEST, "interp") == 0) return SPMT_test::interp(pmt) ;
+
     std::cout << pmt->desc() << std::endl ;
     NPFold* spmt_f = pmt->serialize();
     spmt_f->save("$FOLD/spmt");
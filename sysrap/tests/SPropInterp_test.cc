@@ -0,0 +1,269 @@
+/**
+SPropInterp_test.cc
+=====================
+
+::
+
+   ~/o/sysrap/tests/SPropInterp_test.sh
+   TEST=bench ~/o/sysrap/tests/SPropInterp_test.sh
+
+parity
+    bitwise comparison of SPropInterp::interpolate, interpolate_many
+    and interpolate_props with NP::combined_interp_3 for x below, within
+    (including exactly on domain values) and beyond each property domain
+
+bench
+    timings of the binary search reference against the indexed scalar
+    and batched paths
+
+The tables are all the real material properties of the GEOM geometry
+from SPropMockup::MaterialCombination when available, falling back to
+SPropMockup::CombinationDemo and then a synthetic mix of uniform and
+non-uniform properties with typical item counts.
+For the real PMT rindex and qeshape tables see TEST=interp SPMT_test.sh
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cstring>
+#include <cassert>
+
+#include "ssys.h"
+#include "schrono.h"
+#include "SPropMockup.h"
+#include "SPropInterp.h"
+
+struct SPropInterp_test
+{
+    static const NP* Synthetic();
+    static const NP* Table();
+    static void MakeX(std::vector<float>& xx, const SPropInterp<float>& pi, int iprop, int nx, unsigned seed );
+
+    static int parity();
+    static int bench();
+    static int Main();
+};
+
+/**
+SPropInterp_test::Synthetic
+-----------------------------
+
+Uniform energy domains of different lengths, non-uniform
+domains with clustered values as for ABSLENGTH or RAYLEIGH
+tables and a domain with repeated values.
+
+**/
+
+inline const NP* SPropInterp_test::Synthetic()
+{
+    std::mt19937 rng(1) ;
+    std::uniform_real_distribution<double> u(0., 1.) ;
+    std::vector<const NP*> aa ;
+
+    int nn[] = { 2, 18, 39, 101, 275, 500 } ;
+    int num_n = sizeof(nn)/sizeof(int) ;
+
+    for(int k=0 ; k < 2*num_n ; k++)
+    {
+        int ni = nn[k % num_n] ;
+        bool uniform = k < num_n ;
+        NP* a = NP::Make<double>(ni, 2) ;
+        double* vv = a->values<double>() ;
+        double x = 1.55 ;
+        for(int i=0 ; i < ni ; i++)
+        {
+            vv[2*i+0] = x ;
+            vv[2*i+1] = 1.3 + 0.2*u(rng) ;
+            x += uniform ? 13.95/double(ni-1) : 0.001 + 0.2*u(rng)*u(rng)*u(rng) ;
+        }
+        aa.push_back(a);
+    }
+
+    NP* r = NP::Make<double>(6, 2) ;   // repeated domain values
+    double rv[] = { 1., 0.1, 2., 0.2, 2., 0.5, 3., 0.3, 4., 0.9, 4., 1.0 } ;
+    memcpy( r->values<double>(), rv, sizeof(rv) );
+    aa.push_back(r);
+
+    return SPropMockup::NarrowCombine(aa) ;
+}
+
+inline const NP* SPropInterp_test::Table()
+{
+    bool synthetic = ssys::getenvbool("SPropInterp_test__SYNTHETIC") ;
+    const NP* a = synthetic ? nullptr : SPropMockup::MaterialCombination() ;
+    if( a == nullptr && !synthetic ) a = SPropMockup::CombinationDemo() ;
+    if( a == nullptr || a->ebyte != 4 ) a = Synthetic() ;
+    std::cout << "SPropInterp_test::Table " << a->sstr() << "\n" ;
+    return a ;
+}
+
+/**
+SPropInterp_test::MakeX
+-------------------------
+
+Mostly within the domain, with some beyond and some exactly on domain values
+
+**/
+
+inline void SPropInterp_test::MakeX(std::vector<float>& xx, const SPropInterp<float>& pi, int iprop, int nx, unsigned seed )
+{
+    const float* vv = pi.row(iprop) ;
+    int ni = pi.num_items(iprop) ;
+    float x0 = vv[0] ;
+    float x1 = vv[2*(ni-1)] ;
+    float ext = 0.1f*(x1 - x0) + 1e-3f ;
+
+    std::mt19937 rng(seed) ;
+    std::uniform_real_distribution<float> u(x0 - ext, x1 + ext) ;
+    std::uniform_int_distribution<int> d(0, ni-1) ;
+
+    xx.resize(nx);
+    for(int i=0 ; i < nx ; i++) xx[i] = i % 16 == 0 ? vv[2*d(rng)] : u(rng) ;
+}
+
+inline int SPropInterp_test::parity()
+{
+    const NP* a = Table() ;
+    SPropInterp<float> pi(a) ;
+    std::cout << pi.desc() << "\n" ;
+
+    int nx = 10000 ;
+    int mismatch = 0 ;
+    std::vector<float> xx, y0(nx), y1(nx), y2(nx) ;
+
+    for(int p=0 ; p < pi.height ; p++)
+    {
+        MakeX(xx, pi, p, nx, p+1 );
+        for(int i=0 ; i < nx ; i++) y0[i] = a->combined_interp_3<float>(p, xx[i]) ;
+        for(int i=0 ; i < nx ; i++) y1[i] = pi.interpolate(p, xx[i]) ;
+        pi.interpolate_many( y2.data(), xx.data(), nx, p );
+
+        int m1 = 0, m2 = 0 ;
+        for(int i=0 ; i < nx ; i++)
+        {
+            if( memcmp(&y0[i], &y1[i], sizeof(float)) != 0 ) m1 += 1 ;
+            if( memcmp(&y0[i], &y2[i], sizeof(float)) != 0 ) m2 += 1 ;
+            if( memcmp(&y0[i], &y2[i], sizeof(float)) != 0 && m2 < 5 ) std::cout
+                << " p " << p << " x " << std::setprecision(10) << xx[i]
+                << " y0 " << y0[i] << " y2 " << y2[i] << "\n" ;
+        }
+        const SPropInterp<float>::Index& ix = pi.index[p] ;
+        std::cout
+            << " p " << std::setw(3) << p
+            << " ni " << std::setw(4) << ix.ni
+            << " " << std::setw(8) << SPropInterp<float>::Mode(ix.mode)
+            << " mismatch scalar " << m1
+            << " many " << m2
+            << "\n"
+            ;
+        mismatch += m1 + m2 ;
+    }
+
+    std::vector<float> yp(pi.height) ;
+    for(int i=0 ; i < 1000 ; i++)
+    {
+        float x = 1.f + 0.02f*float(i) ;
+        pi.interpolate_props( yp.data(), x, nullptr, pi.height );
+        for(int p=0 ; p < pi.height ; p++)
+        {
+            float y = a->combined_interp_3<float>(p, x) ;
+            if( memcmp(&y, &yp[p], sizeof(float)) != 0 ) mismatch += 1 ;
+        }
+    }
+
+    std::cout << "SPropInterp_test::parity mismatch " << mismatch << "\n" ;
+    assert( mismatch == 0 );
+    return mismatch == 0 ? 0 : 1 ;
+}
+
+/**
+SPropInterp_test::bench
+-------------------------
+
+The checksum keeps the compiler from eliding the loops.
+
+**/
+
+inline int SPropInterp_test::bench()
+{
+    const NP* a = Table() ;
+    SPropInterp<float> pi(a) ;
+    std::cout << pi.desc() << "\n" ;
+
+    int nx = ssys::getenvint("SPropInterp_test__NX", 1000000) ;
+    std::vector<float> xx, y(nx) ;
+
+    double t_ref = 0., t_one = 0., t_many = 0. ;
+    double s_ref = 0., s_one = 0., s_many = 0. ;
+
+    for(int p=0 ; p < pi.height ; p++)
+    {
+        MakeX(xx, pi, p, nx, p+1 );
+
+        schrono::TP t0 = schrono::stamp();
+        for(int i=0 ; i < nx ; i++) y[i] = pi.reference(p, xx[i]) ;
+        schrono::TP t1 = schrono::stamp();
+        for(int i=0 ; i < nx ; i++) s_ref += y[i] ;
+
+        schrono::TP t2 = schrono::stamp();
+        for(int i=0 ; i < nx ; i++) y[i] = pi.interpolate(p, xx[i]) ;
+        schrono::TP t3 = schrono::stamp();
+        for(int i=0 ; i < nx ; i++) s_one += y[i] ;
+
+        schrono::TP t4 = schrono::stamp();
+        pi.interpolate_many( y.data(), xx.data(), nx, p );
+        schrono::TP t5 = schrono::stamp();
+        for(int i=0 ; i < nx ; i++) s_many += y[i] ;
+
+        double d_ref = schrono::duration(t0, t1) ;
+        double d_one = schrono::duration(t2, t3) ;
+        double d_many = schrono::duration(t4, t5) ;
+
+        std::cout
+            << " p " << std::setw(3) << p
+            << " ni " << std::setw(4) << pi.index[p].ni
+            << " " << std::setw(8) << SPropInterp<float>::Mode(pi.index[p].mode)
+            << " reference " << std::fixed << std::setprecision(4) << d_ref
+            << " interpolate " << d_one
+            << " interpolate_many " << d_many
+            << " speedup " << std::setprecision(2) << d_ref/d_many
+            << "\n"
+            ;
+        t_ref += d_ref ;
+        t_one += d_one ;
+        t_many += d_many ;
+    }
+
+    std::cout
+        << "SPropInterp_test::bench"
+        << " nx " << nx
+        << " height " << pi.height
+        << " reference " << std::fixed << std::setprecision(4) << t_ref
+        << " interpolate " << t_one
+        << " interpolate_many " << t_many
+        << " speedup " << std::setprecision(2) << t_ref/t_many
+        << "\n"
+        ;
+
+    bool same = s_ref == s_one && s_ref == s_many ;
+    assert( same );
+    return same ? 0 : 1 ;
+}
+
+inline int SPropInterp_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "parity") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"parity")==0) rc += parity();
+    if(ALL||strcmp(TEST,"bench")==0)  rc += bench();
+    return rc ;
+}
+
+int main()
+{
+    return SPropInterp_test::Main() ;
+}
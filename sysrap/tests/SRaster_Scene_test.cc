@@ -0,0 +1,42 @@
+/**
+SRaster_Scene_test.cc : writes image files with CPU raster render of SScene triangulated geometry
+===================================================================================================
+
+::
+
+    ~/o/sysrap/tests/SRaster_Scene_test.sh
+    ~/o/sysrap/tests/SRaster_Scene_test.cc
+
+CPU equivalent of SOPTIX_Scene_test.cc, using the same FRAME and SGLM
+view envvars so the images can be compared with the OptiX ones.
+
+**/
+
+#define SIMG_IMPLEMENTATION 1
+
+#include "ssys.h"
+#include "SGLM.h"
+#include "SScene.h"
+#include "SRaster_Scene.h"
+
+int main()
+{
+    SScene* _scn = SScene::Load("$SCENE_FOLD") ;
+
+    int FRAME = ssys::getenvint("FRAME", -1)  ;
+    std::cout << "FRAME=" << FRAME << " ~/o/sysrap/tests/SRaster_Scene_test.sh run \n" ;
+    sfr fr = _scn->getFrame(FRAME) ;
+
+    SGLM gm ;
+    gm.set_frame(fr);
+    std::cout << gm.desc() ;
+
+    SRaster_Scene rs(_scn, gm);
+    rs.render();
+    std::cout << rs.desc() << "\n" ;
+
+    rs.save(getenv("PPM_PATH"));
+    rs.save(getenv("JPG_PATH"));
+
+    return 0 ;
+}
@@ -0,0 +1,92 @@
+#!/bin/bash
+usage(){ cat << EOU
+SRaster_Scene_test.sh
+======================
+
+::
+
+    ~/o/sysrap/tests/SRaster_Scene_test.sh
+    ~/o/sysrap/tests/SRaster_Scene_test.cc
+
+    SRaster__SHADE=GL ~/o/sysrap/tests/SRaster_Scene_test.sh
+    SRaster__NUM_THREAD=1 ~/o/sysrap/tests/SRaster_Scene_test.sh
+
+CPU raster render of the SScene with the same view envvars as
+SOPTIX_Scene_test.sh, requires no GPU.
+
+Preqs::
+
+    ~/o/sysrap/tests/SScene_test.sh
+        ## create and persist SScene.h from loaded stree.h
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=SRaster_Scene_test
+
+export FOLD=/tmp/$name
+bin=$FOLD/$name
+mkdir -p $FOLD
+
+export PPM_PATH=$FOLD/$name.ppm
+export JPG_PATH=$FOLD/$name.jpg
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+sysrap_dir=..
+SYSRAP_DIR=${SYSRAP_DIR:-$sysrap_dir}
+
+scene_fold=/tmp/SScene_test
+export SCENE_FOLD=${SCENE_FOLD:-$scene_fold}
+
+wh=1920,1080
+eye=-1,-1,0
+up=0,0,1
+look=0,0,0
+cam=perspective
+tmin=0.1
+escale=extent
+
+export WH=${WH:-$wh}
+export EYE=${EYE:-$eye}
+export LOOK=${LOOK:-$look}
+export UP=${UP:-$up}
+export TMIN=${TMIN:-$tmin}
+export ESCALE=${ESCALE:-$escale}
+export CAM=${CAM:-$cam}
+
+defarg="info_build_run_open"
+arg=${1:-$defarg}
+
+vars="BASH_SOURCE CUDA_PREFIX OPTICKS_PREFIX SCENE_FOLD FOLD PPM_PATH JPG_PATH"
+
+if [ "${arg/info}" != "$arg" ]; then
+   for var in $vars ; do printf "%20s : %s\n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc \
+        -std=c++17 -lstdc++ -lm -ldl -O2 -pthread \
+        -I${SYSRAP_DIR} \
+        -I$CUDA_PREFIX/include \
+        -I$OPTICKS_PREFIX/externals/glm/glm \
+        -DWITH_CHILD \
+        -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 3
+fi
+
+if [ "${arg/open}" != "$arg" ]; then
+    [ -z "$DISPLAY" ] && echo $BASH_SOURCE adhoc setting DISPLAY && export DISPLAY=:0
+    open $JPG_PATH
+    [ $? -ne 0 ] && echo $BASH_SOURCE : open error && exit 4
+fi
+
+exit 0
@@ -0,0 +1,325 @@
+/**
+SRaster_test.cc
+=================
+
+::
+
+   ~/o/sysrap/tests/SRaster_test.sh
+   TEST=bench ~/o/sysrap/tests/SRaster_test.sh
+
+cover
+    a square tessellated into many triangles covers exactly the
+    same pixel samples as the same square from two triangles,
+    so shared edges leave no cracks and are not drawn twice
+
+depth
+    two overlapping quads give the nearer color whatever the draw order,
+    a quad straddling the near plane is clipped not dropped
+
+threads
+    instanced sphere grid rendered with 1 and N threads and different
+    batch sizes gives identical pixels
+
+bench
+    1080p render of a large instanced sphere grid, for the scene
+    level equivalent see SRaster_Scene_test.sh
+
+See SRaster_Scene_test.sh for rendering SScene geometry.
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cassert>
+
+#include "ssys.h"
+#include "SRaster.h"
+
+struct SRaster_test
+{
+    static void Perspective( float* m, float fovy, float aspect, float near, float far );
+    static void LookAt( float* m, const float* eye, const float* look, const float* up );
+    static void Sphere( std::vector<float>& vtx, std::vector<float>& nrm, std::vector<int>& tri, float radius, int nu, int nv );
+    static void Grid( std::vector<float>& vtx, std::vector<float>& nrm, std::vector<int>& tri, float z, int n );
+    static void Instances( std::vector<float>& tran, int n, float pitch );
+    static void View( float* world2clip, float dist, float aspect );
+    static int  Covered( const SRaster& r );
+
+    static int cover();
+    static int depth();
+    static int threads();
+    static int bench();
+    static int Main();
+};
+
+inline void SRaster_test::Perspective( float* m, float fovy, float aspect, float near, float far )
+{
+    float f = 1.f/std::tan(0.5f*fovy) ;
+    for(int i=0 ; i < 16 ; i++) m[i] = 0.f ;
+    m[0] = f/aspect ;
+    m[5] = f ;
+    m[10] = (far + near)/(near - far) ;
+    m[11] = -1.f ;
+    m[14] = 2.f*far*near/(near - far) ;
+}
+
+inline void SRaster_test::LookAt( float* m, const float* eye, const float* look, const float* up )
+{
+    auto norm = [](float* v){ float n = std::sqrt(v[0]*v[0]+v[1]*v[1]+v[2]*v[2]) ; for(int i=0 ; i < 3 ; i++) v[i] /= n ; } ;
+    auto cross = [](float* r, const float* a, const float* b){ r[0] = a[1]*b[2]-a[2]*b[1] ; r[1] = a[2]*b[0]-a[0]*b[2] ; r[2] = a[0]*b[1]-a[1]*b[0] ; } ;
+    float f[3] = { look[0]-eye[0], look[1]-eye[1], look[2]-eye[2] } ;
+    norm(f);
+    float s[3] ; cross(s, f, up) ; norm(s);
+    float u[3] ; cross(u, s, f) ;
+    for(int i=0 ; i < 16 ; i++) m[i] = 0.f ;
+    for(int i=0 ; i < 3 ; i++)
+    {
+        m[i*4+0] = s[i] ;
+        m[i*4+1] = u[i] ;
+        m[i*4+2] = -f[i] ;
+    }
+    m[12] = -(s[0]*eye[0]+s[1]*eye[1]+s[2]*eye[2]) ;
+    m[13] = -(u[0]*eye[0]+u[1]*eye[1]+u[2]*eye[2]) ;
+    m[14] =  (f[0]*eye[0]+f[1]*eye[1]+f[2]*eye[2]) ;
+    m[15] = 1.f ;
+}
+
+inline void SRaster_test::Sphere( std::vector<float>& vtx, std::vector<float>& nrm, std::vector<int>& tri, float radius, int nu, int nv )
+{
+    vtx.clear(); nrm.clear(); tri.clear();
+    for(int j=0 ; j <= nv ; j++)
+    for(int i=0 ; i <= nu ; i++)
+    {
+        float th = float(M_PI)*float(j)/float(nv) ;
+        float ph = 2.f*float(M_PI)*float(i)/float(nu) ;
+        float n[3] = { std::sin(th)*std::cos(ph), std::sin(th)*std::sin(ph), std::cos(th) } ;
+        for(int k=0 ; k < 3 ; k++) { vtx.push_back(radius*n[k]) ; nrm.push_back(n[k]) ; }
+    }
+    for(int j=0 ; j < nv ; j++)
+    for(int i=0 ; i < nu ; i++)
+    {
+        int a = j*(nu+1)+i, b = a + 1, c = a + (nu+1), d = c + 1 ;
+        if( j > 0 )    { tri.push_back(a) ; tri.push_back(c) ; tri.push_back(b) ; }
+        if( j < nv-1 ) { tri.push_back(b) ; tri.push_back(c) ; tri.push_back(d) ; }
+    }
+}
+
+/**
+SRaster_test::Grid
+--------------------
+
+Square -0.5:0.5 at NDC depth z, n*n quads each of two triangles
+with alternating diagonals
+
+**/
+
+inline void SRaster_test::Grid( std::vector<float>& vtx, std::vector<float>& nrm, std::vector<int>& tri, float z, int n )
+{
+    vtx.clear(); nrm.clear(); tri.clear();
+    for(int j=0 ; j <= n ; j++)
+    for(int i=0 ; i <= n ; i++)
+    {
+        float p[3] = { -0.5f + float(i)/float(n), -0.5f + float(j)/float(n), z } ;
+        float q[3] = { 0.f, 0.f, 1.f } ;
+        vtx.insert(vtx.end(), p, p+3);
+        nrm.insert(nrm.end(), q, q+3);
+    }
+    for(int j=0 ; j < n ; j++)
+    for(int i=0 ; i < n ; i++)
+    {
+        int a = j*(n+1)+i, b = a + 1, c = a + (n+1), d = c + 1 ;
+        if( (i+j) % 2 == 0 ) { int q[6] = { a,b,d, a,d,c } ; tri.insert(tri.end(), q, q+6) ; }
+        else                 { int q[6] = { a,b,c, b,d,c } ; tri.insert(tri.end(), q, q+6) ; }
+    }
+}
+
+inline void SRaster_test::Instances( std::vector<float>& tran, int n, float pitch )
+{
+    tran.clear();
+    for(int j=0 ; j < n ; j++)
+    for(int i=0 ; i < n ; i++)
+    {
+        float c = std::cos(0.1f*float(i+j)), s = std::sin(0.1f*float(i+j)) ;
+        float m[16] = { c, s, 0.f, 0.f,  -s, c, 0.f, 0.f,  0.f, 0.f, 1.f, 0.f,
+                        pitch*(float(i) - 0.5f*float(n-1)), pitch*(float(j) - 0.5f*float(n-1)), 0.f, 1.f } ;
+        tran.insert(tran.end(), m, m+16);
+    }
+}
+
+inline void SRaster_test::View( float* world2clip, float dist, float aspect )
+{
+    float eye[3] = { 0.3f*dist, -0.6f*dist, 0.8f*dist } ;
+    float look[3] = { 0.f, 0.f, 0.f } ;
+    float up[3] = { 0.f, 0.f, 1.f } ;
+    float V[16], P[16] ;
+    LookAt(V, eye, look, up);
+    Perspective(P, 45.f*float(M_PI)/180.f, aspect, 0.01f*dist, 10.f*dist );
+    SRaster::Mul(world2clip, P, V);
+}
+
+inline int SRaster_test::Covered( const SRaster& r )
+{
+    int n = 0 ;
+    for(size_t i=0 ; i < r.depth.size() ; i++) if( r.depth[i] < 1.f ) n += 1 ;
+    return n ;
+}
+
+inline int SRaster_test::cover()
+{
+    float I[16] = { 1.f,0.f,0.f,0.f, 0.f,1.f,0.f,0.f, 0.f,0.f,1.f,0.f, 0.f,0.f,0.f,1.f } ;
+    int nn[] = { 1, 7, 64 } ;
+    int ref = -1 ;
+    int rc = 0 ;
+    for(int k=0 ; k < 3 ; k++)
+    {
+        std::vector<float> vtx, nrm ;
+        std::vector<int> tri ;
+        Grid(vtx, nrm, tri, 0.f, nn[k]);
+
+        SRaster r ;
+        r.tile = 16 ;
+        r.add_mesh( vtx.data(), nrm.data(), tri.data(), vtx.size()/3, tri.size()/3 );
+        r.add_draw( 0, nullptr );
+        r.set_view( I, 640, 480 );
+        r.render();
+
+        int n = Covered(r) ;
+        if( ref < 0 ) ref = n ;
+        std::cout << "SRaster_test::cover n " << std::setw(3) << nn[k] << " tri " << tri.size()/3 << " covered " << n << " frag " << r.num_frag << "\n" ;
+        if( n != ref || uint64_t(n) != r.num_frag ) rc += 1 ;   // num_frag == covered : no sample drawn twice
+    }
+    std::cout << "SRaster_test::cover ref " << ref << "\n" ;
+    assert( rc == 0 );
+    return rc ;
+}
+
+inline int SRaster_test::depth()
+{
+    float I[16] = { 1.f,0.f,0.f,0.f, 0.f,1.f,0.f,0.f, 0.f,0.f,1.f,0.f, 0.f,0.f,0.f,1.f } ;
+    std::vector<float> v0, n0, v1, n1 ;
+    std::vector<int> t0, t1 ;
+    Grid(v0, n0, t0, 0.5f, 4);
+    Grid(v1, n1, t1, -0.2f, 3);
+    for(size_t i=0 ; i < n0.size() ; i+=3) { n0[i] = 1.f ; n0[i+2] = 0.f ; }   // far quad normal +X
+
+    int rc = 0 ;
+    for(int order=0 ; order < 2 ; order++)
+    {
+        SRaster r ;
+        int m0 = r.add_mesh( v0.data(), n0.data(), t0.data(), v0.size()/3, t0.size()/3 );
+        int m1 = r.add_mesh( v1.data(), n1.data(), t1.data(), v1.size()/3, t1.size()/3 );
+        r.add_draw( order == 0 ? m0 : m1, nullptr );
+        r.add_draw( order == 0 ? m1 : m0, nullptr );
+        r.set_view( I, 200, 100 );
+        r.render();
+
+        const unsigned char* px = r.pixels.data() + 4*(50*200 + 100) ;
+        std::cout << "SRaster_test::depth order " << order << " center " << int(px[0]) << "," << int(px[1]) << "," << int(px[2]) << "," << int(px[3]) << "\n" ;
+        if(!( px[0] == 127 && px[2] == 255 && px[3] == 0 )) rc += 1 ;   // +Z normal of near quad, negative depth clamps to 0
+    }
+
+    // quad spanning the near plane of a perspective view
+    float P[16] ;
+    Perspective(P, 1.f, 1.f, 1.f, 100.f );
+    float vq[12] = { -1.f, 0.f, 2.f,  1.f, 0.f, 2.f,  1.f, 0.f, -50.f,  -1.f, 0.f, -50.f } ;
+    float nq[12] = { 0.f, 1.f, 0.f,  0.f, 1.f, 0.f,  0.f, 1.f, 0.f,  0.f, 1.f, 0.f } ;
+    int tq[6] = { 0,1,2, 0,2,3 } ;
+    float Y[16] = { 1.f,0.f,0.f,0.f, 0.f,1.f,0.f,0.f, 0.f,0.f,1.f,0.f, 0.f,-0.5f,0.f,1.f } ;   // floor below eye
+    float M[16] ;
+    SRaster::Mul(M, P, Y);
+    SRaster r ;
+    r.add_mesh( vq, nq, tq, 4, 2 );
+    r.add_draw( 0, nullptr );
+    r.set_view( M, 64, 64 );
+    r.render();
+    int n = Covered(r) ;
+    std::cout << "SRaster_test::depth near clipped floor covered " << n << " " << r.desc() << "\n" ;
+    if( n == 0 || r.depth[4*64+32] >= 1.f ) rc += 1 ;   // bottom rows nearest the eye must be covered
+
+    assert( rc == 0 );
+    return rc ;
+}
+
+inline int SRaster_test::threads()
+{
+    std::vector<float> vtx, nrm, tran ;
+    std::vector<int> tri ;
+    Sphere(vtx, nrm, tri, 1.f, 32, 16 );
+    Instances(tran, 30, 2.5f );
+
+    float VP[16] ;
+    View(VP, 80.f, 4.f/3.f );
+
+    int num_thread[] = { 1, 3, 0 } ;
+    int batch[] = { 1 << 20, 5000, 1 << 20 } ;
+    std::vector<unsigned char> ref ;
+    int rc = 0 ;
+    for(int k=0 ; k < 3 ; k++)
+    {
+        SRaster r ;
+        if( num_thread[k] > 0 ) r.num_thread = num_thread[k] ;
+        r.batch = batch[k] ;
+        int m = r.add_mesh( vtx.data(), nrm.data(), tri.data(), vtx.size()/3, tri.size()/3 );
+        for(int i=0 ; i < int(tran.size()/16) ; i++) r.add_draw( m, tran.data() + 16*i );
+        r.set_view( VP, 400, 300 );
+        r.render();
+        std::cout << r.desc() << "\n" ;
+        if( k == 0 ) ref = r.pixels ;
+        else if( ref != r.pixels ) rc += 1 ;
+    }
+    std::cout << "SRaster_test::threads rc " << rc << "\n" ;
+    assert( rc == 0 );
+    return rc ;
+}
+
+inline int SRaster_test::bench()
+{
+    int n = ssys::getenvint("SRaster_test__GRID", 200) ;
+    std::vector<float> vtx, nrm, tran ;
+    std::vector<int> tri ;
+    Sphere(vtx, nrm, tri, 1.f, 48, 24 );
+    Instances(tran, n, 2.5f );
+
+    float VP[16] ;
+    View(VP, 2.5f*float(n), 16.f/9.f );
+
+    SRaster r ;
+    int m = r.add_mesh( vtx.data(), nrm.data(), tri.data(), vtx.size()/3, tri.size()/3 );
+    for(int i=0 ; i < n*n ; i++) r.add_draw( m, tran.data() + 16*i );
+    r.set_view( VP, 1920, 1080 );
+    r.render();
+
+    std::cout
+        << "SRaster_test::bench"
+        << " instances " << n*n
+        << " tri/instance " << tri.size()/3
+        << " total_tri " << uint64_t(n)*uint64_t(n)*uint64_t(tri.size()/3)
+        << "\n"
+        << r.desc()
+        << "\n"
+        ;
+
+    const char* path = ssys::getenvvar("PPM_PATH") ;
+    if(path) r.save(path);
+    return Covered(r) > 0 ? 0 : 1 ;
+}
+
+inline int SRaster_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "ALL") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"cover")==0)   rc += cover();
+    if(ALL||strcmp(TEST,"depth")==0)   rc += depth();
+    if(ALL||strcmp(TEST,"threads")==0) rc += threads();
+    if(ALL||strcmp(TEST,"bench")==0)   rc += bench();
+    return rc ;
+}
+
+int main()
+{
+    return SRaster_test::Main() ;
+}
@@ -7,11 +7,14 @@ Aim is to be able to use QBnd.hh/qbnd.h in MOCK_CUDA manner on CPU.
 ::
 
    ./s_mock_texture_test.sh
+   TEST=ALL ./s_mock_texture_test.sh
 
 
 **/
 
 #include <cstdio>
+#include <cstring>
+#include <cmath>
 #include "NPFold.h"
 
 #include "s_mock_texture.h"
@@ -208,7 +211,7 @@ NPFold* test_boundary_lookup()
     cudaTextureObject_t obj = create_boundary_texture(); 
     MockTexture tex = MockTextureManager::Get(obj) ; 
 
-    const std::vector<int>& sh = tex.a->shape ; 
+    const std::vector<NP::INT>& sh = tex.a->shape ; 
     int nd = sh.size() ; 
     assert( nd == 5 ); 
     assert( sh[nd-1] == 4 );  
@@ -238,12 +241,272 @@ NPFold* test_boundary_lookup()
     return f ; 
 }
 
+/**
+test_filter
+-------------
+
+Linear filtering of a ramp texture compared with the CUDA
+texture fetching formula using 9-bit fixed point weights.
+Between texel centers the result is the ramp value at the
+quantized weight, beyond the edge centers clamp addressing
+gives the edge value.
+
+**/
+
+NPFold* test_filter()
+{
+    int nx = 16 ; 
+    int ny = 2 ; 
+    NP* a = NP::Make<float>(ny, nx) ; 
+    float* aa = a->values<float>(); 
+    for(int iy=0 ; iy < ny ; iy++) for(int ix=0 ; ix < nx ; ix++) aa[iy*nx+ix] = float(ix*ix) ; 
+
+    cudaTextureObject_t obj = MockTextureManager::Add(a, nullptr, nx, ny, 1, 'L', true, MockTexture::AddressClamp ) ; 
+
+    int num = 1000 ; 
+    NP* b = NP::Make<float>(num, 3) ; 
+    float* bb = b->values<float>(); 
+    int mismatch = 0 ; 
+
+    for(int i=0 ; i < num ; i++)
+    {
+        float x = float(i)/float(num) ; 
+        float y = 0.25f ; 
+        float v = tex2D<float>(obj, x, y ) ; 
+
+        float xb = x*float(nx) - 0.5f ; 
+        int   i0 = int(std::floor(xb)) ; 
+        float al = std::floor( (xb - std::floor(xb))*256.f + 0.5f )/256.f ;  
+        int   j0 = std::min(std::max(i0,0),nx-1) ; 
+        int   j1 = std::min(std::max(i0+1,0),nx-1) ; 
+        float expect = (1.f-al)*aa[j0] + al*aa[j1] ; 
+
+        if( std::abs(v - expect) > 1e-4f*std::max(1.f, expect) ) mismatch += 1 ; 
+        bb[i*3+0] = x ; 
+        bb[i*3+1] = v ; 
+        bb[i*3+2] = expect ; 
+    }
+    std::cout << "test_filter mismatch " << mismatch << std::endl ; 
+    assert( mismatch == 0 ); 
+
+    NPFold* f = new NPFold ; 
+    f->add("a", a ); 
+    f->add("b", b ); 
+    return f ; 
+}
+
+/**
+test_address
+--------------
+
+Point lookups outside 0:1 with each address mode. 
+
+**/
+
+NPFold* test_address()
+{
+    int nx = 4 ; 
+    NP* a = NP::Make<float>(1, nx) ; 
+    float* aa = a->values<float>(); 
+    for(int ix=0 ; ix < nx ; ix++) aa[ix] = float(ix+1) ; 
+
+    cudaTextureObject_t wrap   = MockTextureManager::Add(a, nullptr, nx, 1, 1, 'P', true, MockTexture::AddressWrap ) ; 
+    cudaTextureObject_t clamp  = MockTextureManager::Add(a, nullptr, nx, 1, 1, 'P', true, MockTexture::AddressClamp ) ; 
+    cudaTextureObject_t mirror = MockTextureManager::Add(a, nullptr, nx, 1, 1, 'P', true, MockTexture::AddressMirror ) ; 
+    cudaTextureObject_t border = MockTextureManager::Add(a, nullptr, nx, 1, 1, 'P', true, MockTexture::AddressBorder ) ; 
+    cudaTextureObject_t unorm  = MockTextureManager::Add(a, nullptr, nx, 1, 1, 'P', false, MockTexture::AddressWrap ) ; 
+
+    float x = 1.375f ;   // texel 5 : one and a half texels beyond the end  
+    float y = 0.5f ; 
+    float v_wrap   = tex2D<float>(wrap,   x, y ); 
+    float v_clamp  = tex2D<float>(clamp,  x, y ); 
+    float v_mirror = tex2D<float>(mirror, x, y ); 
+    float v_border = tex2D<float>(border, x, y ); 
+    float v_unorm  = tex2D<float>(unorm,  5.5f, 0.5f );  // wrap not supported with unnormalized : clamps 
+
+    std::cout 
+        << "test_address"
+        << " wrap " << v_wrap 
+        << " clamp " << v_clamp 
+        << " mirror " << v_mirror 
+        << " border " << v_border 
+        << " unorm " << v_unorm 
+        << std::endl 
+        ; 
+
+    assert( v_wrap == 2.f ); 
+    assert( v_clamp == 4.f ); 
+    assert( v_mirror == 3.f ); 
+    assert( v_border == 0.f ); 
+    assert( v_unorm == 4.f ); 
+
+    NPFold* f = new NPFold ; 
+    f->add("a", a ); 
+    return f ; 
+}
+
+NPFold* test_layered()
+{
+    int nx = 8 ; 
+    int ny = 4 ; 
+    int nl = 3 ; 
+    NP* a = NP::Make<float>(nl, ny, nx, 4) ; 
+    float4* aa = (float4*)a->values<float>(); 
+    for(int l=0 ; l < nl ; l++)
+    for(int iy=0 ; iy < ny ; iy++)
+    for(int ix=0 ; ix < nx ; ix++) aa[(l*ny+iy)*nx+ix] = make_float4( l, iy, ix, 0.f ); 
+
+    cudaTextureObject_t obj = MockTextureManager::Add(a, nullptr, nx, ny, 4, 'L', true, MockTexture::AddressClamp, nl ) ; 
+
+    for(int l=0 ; l < nl ; l++)
+    {
+        float4 v = tex2DLayered<float4>(obj, 0.5f, 0.5f, l ); 
+        assert( v.x == float(l) );   // no filtering across layers 
+        assert( v.y == 1.5f && v.z == 3.5f ); 
+    }
+    float4 over = tex2DLayered<float4>(obj, 0.5f, 0.5f, nl+5 ); 
+    assert( over.x == float(nl-1) ); 
+    std::cout << "test_layered" << std::endl ; 
+
+    NPFold* f = new NPFold ; 
+    f->add("a", a ); 
+    return f ; 
+}
+
+NPFold* test_batch()
+{
+    int nx = 761 ; 
+    int ny = 64 ; 
+    NP* a = NP::Make<float>(ny, nx, 4) ; 
+    float* aa = a->values<float>(); 
+    for(int i=0 ; i < ny*nx*4 ; i++) aa[i] = std::sin(0.001f*float(i)) ; 
+
+    cudaTextureObject_t obj = MockTextureManager::Add(a, nullptr, nx, ny, 4, 'L', true ) ; 
+    MockTextureManager* mgr = MockTextureManager::Get();  
+
+    int num = 100000 ; 
+    std::vector<float> xx(num), yy(num) ; 
+    for(int i=0 ; i < num ; i++)
+    {
+        xx[i] = float((i*7919) % 100003)/100003.f ; 
+        yy[i] = float((i*104729) % 1009)/1009.f ; 
+    }
+
+    std::vector<float4> b(num) ; 
+    mgr->tex2D_batch<float4>(obj, b.data(), xx.data(), yy.data(), num ); 
+
+    int mismatch = 0 ; 
+    for(int i=0 ; i < num ; i++)
+    {
+        float4 s = tex2D<float4>(obj, xx[i], yy[i] ) ; 
+        if( s.x != b[i].x || s.y != b[i].y || s.z != b[i].z || s.w != b[i].w ) mismatch += 1 ;  
+    }
+    std::cout << "test_batch num " << num << " mismatch " << mismatch << std::endl ; 
+    assert( mismatch == 0 ); 
+
+    NPFold* f = new NPFold ; 
+    f->add("a", a ); 
+    return f ; 
+}
+
+/**
+test_parity
+-------------
+
+Compares with GPU texture lookups recorded by QBndTest, 
+which saves the boundary texture as src.npy and 
+lookups at each texel center as dst.npy. 
+When xy.npy with shape (n,2) normalized coordinates is present 
+along with dst_xy.npy of shape (n,4) lookups at those 
+arbitrary coordinates are also compared. 
+
+**/
+
+NPFold* test_parity()
+{
+    const char* dir = getenv("s_mock_texture_test__PARITY") ? getenv("s_mock_texture_test__PARITY") : "$TMP/QBndTest" ; 
+    if(!NP::Exists(dir, "src.npy")) 
+    {
+        std::cout << "test_parity : SKIP no recorded GPU lookups in " << dir << std::endl ; 
+        return new NPFold ; 
+    }
+
+    const NP* src = NP::Load(dir, "src.npy"); 
+    const NP* dst = NP::Load(dir, "dst.npy"); 
+
+    NP::INT width, height ; 
+    src->size_2D<4>(width, height); 
+    cudaTextureObject_t obj = MockTextureManager::Add(src, nullptr, width, height, 4, 'L', true ); 
+
+    const float4* dd = (const float4*)dst->cvalues<float>(); 
+    NP* b = NP::MakeLike(dst) ; 
+    float4* bb = (float4*)b->values<float>(); 
+
+    float maxdiff = 0.f ; 
+    for(int iy=0 ; iy < height ; iy++)
+    for(int ix=0 ; ix < width ; ix++)
+    {
+        int idx = iy*width + ix ; 
+        bb[idx] = tex2D<float4>(obj, (float(ix)+0.5f)/width, (float(iy)+0.5f)/height ) ; 
+        maxdiff = std::max( maxdiff, std::abs(bb[idx].x - dd[idx].x) ); 
+        maxdiff = std::max( maxdiff, std::abs(bb[idx].w - dd[idx].w) ); 
+    }
+
+    float maxdiff_xy = 0.f ; 
+    if(NP::Exists(dir, "xy.npy"))
+    {
+        const NP* xy = NP::Load(dir, "xy.npy"); 
+        const NP* dxy = NP::Load(dir, "dst_xy.npy"); 
+        const float* q = xy->cvalues<float>(); 
+        const float4* dq = (const float4*)dxy->cvalues<float>(); 
+        for(int i=0 ; i < xy->shape[0] ; i++)
+        {
+            float4 v = tex2D<float4>(obj, q[2*i+0], q[2*i+1] ); 
+            maxdiff_xy = std::max( maxdiff_xy, std::abs(v.x - dq[i].x) ); 
+            maxdiff_xy = std::max( maxdiff_xy, std::abs(v.w - dq[i].w) ); 
+        }
+    }
+
+    std::cout 
+        << "test_parity"
+        << " dir " << dir 
+        << " maxdiff " << maxdiff 
+        << " maxdiff_xy " << maxdiff_xy 
+        << std::endl 
+        ; 
+    assert( maxdiff < 1e-5f ); 
+
+    NPFold* f = new NPFold ; 
+    f->add("b", b ); 
+    return f ; 
+}
+
+
 int main(int argc, char** argv)
 {
-    //NPFold* f = test_demo_3(); 
-    //NPFold* f = test_demo_5(); 
-    NPFold* f = test_bnd(); 
-    //NPFold* f = test_boundary_lookup(); 
+    const char* TEST = getenv("TEST") ? getenv("TEST") : "bnd" ; 
+
+    NPFold* f = nullptr ; 
+    if(strcmp(TEST,"demo_3")==0)          f = test_demo_3(); 
+    if(strcmp(TEST,"demo_5")==0)          f = test_demo_5(); 
+    if(strcmp(TEST,"bnd")==0)             f = test_bnd(); 
+    if(strcmp(TEST,"boundary_lookup")==0) f = test_boundary_lookup(); 
+    if(strcmp(TEST,"filter")==0)          f = test_filter(); 
+    if(strcmp(TEST,"address")==0)         f = test_address(); 
+    if(strcmp(TEST,"layered")==0)         f = test_layered(); 
+    if(strcmp(TEST,"batch")==0)           f = test_batch(); 
+    if(strcmp(TEST,"parity")==0)          f = test_parity(); 
+
+    if(strcmp(TEST,"ALL")==0)
+    {
+        f = new NPFold ; 
+        f->add_subfold("filter",  test_filter()); 
+        f->add_subfold("address", test_address()); 
+        f->add_subfold("layered", test_layered()); 
+        f->add_subfold("batch",   test_batch()); 
+        f->add_subfold("parity",  test_parity()); 
+    }
+    assert(f); 
 
     f->save("$FOLD"); 
     return 0;
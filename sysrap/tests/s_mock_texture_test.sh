@@ -3,6 +3,13 @@ usage(){ cat << EOU
 s_mock_texture_test.sh
 =======================
 
+::
+
+   TEST=ALL ./s_mock_texture_test.sh     # filter, address, layered, batch, parity 
+   TEST=parity s_mock_texture_test__PARITY=/tmp/QBndTest ./s_mock_texture_test.sh
+
+The parity test compares with GPU lookups recorded by QBndTest. 
+
 
 EOU
 }
@@ -0,0 +1,185 @@
+/**
+s_seqpager_test.cc
+====================
+
+::
+
+   ~/o/sysrap/tests/s_seqpager_test.sh
+   TEST=bench ~/o/sysrap/tests/s_seqpager_test.sh
+
+parity
+    writes a folder of chunk files of precooked-like randoms of differing
+    item counts, checks items accessed via s_seqpager in sequential, random
+    and back-and-forth orders match NP::Load concatenation, that the number
+    of resident chunks never exceeds max_resident and that cursors persist
+    across eviction. Also checks single file paths.
+
+bench
+    time for sequential access to all items with the memory of a few chunks,
+    compared with NP::Load of the entire folder
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cstring>
+
+#include "ssys.h"
+#include "schrono.h"
+#include "s_seqpager.h"
+
+struct s_seqpager_test
+{
+    static const char* FOLD ;
+    static void MakeChunks(const char* dir, const std::vector<int>& counts, int nj, int nk);
+    static int parity();
+    static int bench();
+    static int Main();
+};
+
+const char* s_seqpager_test::FOLD = ssys::getenvvar("FOLD", "/tmp/s_seqpager_test") ;
+
+inline void s_seqpager_test::MakeChunks(const char* dir, const std::vector<int>& counts, int nj, int nk)
+{
+    int i0 = 0 ;
+    for(unsigned c=0 ; c < counts.size() ; c++)
+    {
+        NP* a = NP::Make<float>( counts[c], nj, nk );
+        float* aa = a->values<float>();
+        for(int i=0 ; i < counts[c]*nj*nk ; i++) aa[i] = float(i0*nj*nk + i) ;
+        std::stringstream ss ;
+        ss << "rng_sequence_f_ni" << counts[c] << "_nj" << nj << "_nk" << nk << "_ioffset" << std::setw(6) << std::setfill('0') << i0 << ".npy" ;
+        std::string name = ss.str();
+        a->save(dir, name.c_str());
+        delete a ;
+        i0 += counts[c] ;
+    }
+}
+
+inline int s_seqpager_test::parity()
+{
+    std::string dir = std::string(FOLD) + "/parity" ;
+    std::vector<int> counts = { 1000, 500, 1500, 7, 993 } ;
+    MakeChunks(dir.c_str(), counts, 4, 4);
+
+    NP* ref = NP::Load(dir.c_str());
+    const float* rr = ref->cvalues<float>();
+    int ni = ref->shape[0] ;
+
+    s_seqpager* pg = s_seqpager::Create(dir.c_str(), 2) ;
+    int rc = 0 ;
+    rc += int( pg == nullptr ) ;
+    if(pg == nullptr) return rc ;
+    rc += int( int(pg->ni) != ni || pg->nv != 16 ) ;
+
+    std::vector<unsigned long long> order ;
+    for(int i=0 ; i < ni ; i++) order.push_back(i) ;
+    std::mt19937 rng(1) ;
+    for(int i=0 ; i < 20000 ; i++) order.push_back( rng() % ni ) ;
+    for(int i=0 ; i < 2000 ; i++) order.push_back( i % 2 == 0 ? i : ni - 1 - i ) ;
+
+    unsigned max_seen = 0 ;
+    for(unsigned k=0 ; k < order.size() ; k++)
+    {
+        unsigned long long idx = order[k] ;
+        int* cursor = nullptr ;
+        const float* vv = pg->item(idx, &cursor);
+        rc += int( memcmp( vv, rr + idx*16, 16*sizeof(float)) != 0 ) ;
+        *cursor += 1 ;
+        max_seen = std::max( max_seen, unsigned(pg->resident.size()) );
+    }
+    rc += int( max_seen > pg->max_resident ) ;
+
+    // cursor counts persist across eviction
+    std::vector<int> expect(ni, 0) ;
+    for(unsigned k=0 ; k < order.size() ; k++) expect[order[k]] += 1 ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        int* cursor = nullptr ;
+        pg->item(i, &cursor);
+        rc += int( *cursor != expect[i] ) ;
+    }
+    rc += int( pg->item(ni) != nullptr ) ;
+
+    // reset releases the cursors of non-resident chunks, unconsumed chunks release on eviction
+    pg->reset_cursors();
+    for(int i=0 ; i < ni ; i++) pg->item(i) ;
+    unsigned long long resident_ni = 0 ;
+    for(unsigned i=0 ; i < pg->resident.size() ; i++) resident_ni += pg->chunks[pg->resident[i]].ni ;
+    rc += int( pg->cursor_bytes() > resident_ni*sizeof(int) ) ;
+
+    // NB chunk order is the sorted file name order of NP::Load, not the ioffset
+    const s_seqpager::Chunk& ch = pg->chunks[1] ;
+    s_seqpager* one = s_seqpager::Create(ch.path.c_str(), 1) ;
+    rc += int( one == nullptr || one->ni != ch.ni || memcmp( one->item(5), rr + (ch.i0+5)*16, 16*sizeof(float) ) != 0 ) ;
+
+    std::cout
+        << "s_seqpager_test::parity"
+        << " ni " << ni
+        << " num_access " << order.size()
+        << " max_seen " << max_seen
+        << " rc " << rc
+        << "\n"
+        << pg->desc()
+        << "\n"
+        ;
+
+    delete pg ;
+    delete one ;
+    return rc ;
+}
+
+inline int s_seqpager_test::bench()
+{
+    std::string dir = std::string(FOLD) + "/bench" ;
+    int num_chunk = ssys::getenvint("NUM_CHUNK", 10) ;
+    std::vector<int> counts(num_chunk, 100000) ;
+    MakeChunks(dir.c_str(), counts, 16, 16);
+
+    schrono::TP t0 = schrono::stamp();
+    NP* ref = NP::Load(dir.c_str());
+    schrono::TP t1 = schrono::stamp();
+
+    s_seqpager* pg = s_seqpager::Create(dir.c_str(), 2) ;
+    double sum = 0. ;
+    schrono::TP t2 = schrono::stamp();
+    for(unsigned long long i=0 ; i < pg->ni ; i++)
+    {
+        int* cursor = nullptr ;
+        const float* vv = pg->item(i, &cursor);
+        for(int j=0 ; j < 32 ; j++) sum += vv[(*cursor)++] ;   // typical photon consumption
+    }
+    schrono::TP t3 = schrono::stamp();
+
+    std::cout
+        << "s_seqpager_test::bench"
+        << " ni " << pg->ni
+        << " NP::Load " << std::fixed << std::setprecision(4) << schrono::duration(t0, t1)
+        << " bytes " << ref->arr_bytes()
+        << " paged " << schrono::duration(t2, t3)
+        << " resident_bytes " << pg->resident_bytes()
+        << " sum " << sum
+        << "\n"
+        << pg->desc()
+        << "\n"
+        ;
+    delete ref ;
+    delete pg ;
+    return 0 ;
+}
+
+inline int s_seqpager_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "parity") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"parity")==0) rc += parity();
+    if(ALL||strcmp(TEST,"bench")==0)  rc += bench();
+    return rc ;
+}
+
+int main()
+{
+    return s_seqpager_test::Main() ;
+}
@@ -0,0 +1,137 @@
+// ~/opticks/sysrap/tests/sarena_test.sh
+
+#include <iostream>
+#include "sarena.h"
+
+struct sarena_test
+{
+    struct item { float q[16] ; } ;
+
+    static int reuse();
+    static int lend_reclaim();
+    static int regather();
+    static int main();
+};
+
+/**
+sarena_test::reuse
+--------------------
+
+Repeated events with varying photon counts should only allocate
+until reaching the high water mark.
+
+**/
+
+int sarena_test::reuse()
+{
+    sarena<item> a ;
+    a.set_max_item(1000);
+
+    const int N = 10 ;
+    int nn[N] = { 100, 50, 200, 10, 200, 150, 0, 199, 200, 1 } ;
+    for(int i=0 ; i < N ; i++)
+    {
+        a.clear();
+        a.resize(nn[i]);
+        for(int j=0 ; j < nn[i] ; j++) assert( a[j].q[0] == 0.f );  // added items are zeroed
+        for(int j=0 ; j < nn[i] ; j++) a[j].q[0] = float(j) ;
+    }
+    std::cout << "sarena_test::reuse " << a.desc() << std::endl ;
+    assert( a.num_alloc <= 2 );
+
+    // resize within an event preserves prior items, as needed by hostside genstep collection
+    a.clear();
+    a.resize(10);
+    for(int j=0 ; j < 10 ; j++) a[j].q[0] = float(j) ;
+    a.resize(20);
+    for(int j=0 ; j < 10 ; j++) assert( a[j].q[0] == float(j) );
+    for(int j=10 ; j < 20 ; j++) assert( a[j].q[0] == 0.f );
+    return 0 ;
+}
+
+int sarena_test::lend_reclaim()
+{
+    sarena<item> a ;
+    NPFold* fold = new NPFold ;
+
+    for(int ev=0 ; ev < 5 ; ev++)
+    {
+        a.resize(100+ev);
+        for(int j=0 ; j < int(a.size()) ; j++) a[j].q[15] = float(j+ev) ;
+        const char* ptr = (const char*)a.data() ;
+
+        NP* p = NP::Make<float>(0, 4, 4) ;
+        a.lend(p);
+        assert( p->shape[0] == 100+ev );
+        assert( p->bytes() == ptr );   // zero-copy : array views arena memory
+        assert( p->cvalues<float>()[16*(99+ev)+15] == float(99+ev+ev) );
+
+        fold->add("photon", p);
+        bool found = a.reclaim(fold, "photon");
+        assert( found );
+        assert( p->shape[0] == 0 );
+        fold->clear();
+    }
+    std::cout << "sarena_test::lend_reclaim " << a.desc() << std::endl ;
+    assert( a.num_reclaim == 5 );
+    assert( a.num_alloc <= 2 );
+    int num_alloc = a.num_alloc ;
+
+    // reclaim from fold without the array : buffer is lost and reallocated
+    a.resize(10);
+    NP* q = NP::Make<float>(0, 4, 4) ;
+    a.lend(q);
+    delete q ;
+    bool found = a.reclaim(fold, "photon");
+    assert( found == false );
+    a.resize(10);
+    assert( a.num_alloc == num_alloc + 1 );
+    return 0 ;
+}
+
+/**
+sarena_test::regather
+-----------------------
+
+Repeated gather before clear, as SEvt::gatherPhoton does when the arena
+is already lent : the data pointer obtained before lending (the sevent.h
+pointer) still reads the lent array data, so a copy can be made from it.
+
+**/
+
+int sarena_test::regather()
+{
+    sarena<item> a ;
+    NPFold* fold = new NPFold ;
+
+    a.resize(10);
+    for(int j=0 ; j < 10 ; j++) a[j].q[0] = float(j) ;
+    const item* ptr = a.data() ;
+
+    NP* p = NP::Make<float>(0, 4, 4) ;
+    a.lend(p);
+    fold->add("photon", p);
+    assert( a.lent == p );
+
+    NP* c = NP::Make<float>(10, 4, 4) ;
+    c->read2( (const float*)ptr );
+    assert( c->bytes() != p->bytes() );
+    assert( memcmp( c->bytes(), p->bytes(), p->arr_bytes() ) == 0 );
+    delete c ;
+
+    bool found = a.reclaim(fold, "photon");
+    assert( found );
+    assert( a.lent == nullptr );
+    return 0 ;
+}
+
+int sarena_test::main()
+{
+    int rc = 0 ;
+    rc += reuse();
+    rc += lend_reclaim();
+    rc += regather();
+    return rc ;
+}
+
+int main(){ return sarena_test::main() ; }
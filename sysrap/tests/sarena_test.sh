@@ -0,0 +1,37 @@
+#!/bin/bash -l
+usage(){ cat << EOU
+sarena_test.sh
+================
+
+~/opticks/sysrap/tests/sarena_test.sh
+
+Checks the pooled hostside storage used by SEvt for per-photon
+arrays : capacity reuse across events and zero-copy lending
+of the buffer to NP arrays.
+
+EOU
+}
+
+name=sarena_test
+
+TMP=${TMP:-/tmp/$USER/opticks}
+export FOLD=$TMP/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cd $(dirname $BASH_SOURCE)
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc -std=c++11 -lstdc++ -I.. -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 2
+fi
+
+exit 0
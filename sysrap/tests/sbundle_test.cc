@@ -0,0 +1,274 @@
+/**
+sbundle_test.cc
+=================
+
+::
+
+   ~/o/sysrap/tests/sbundle_test.sh
+   TEST=bench NUM=1000 ~/o/sysrap/tests/sbundle_test.sh
+
+roundtrip
+    NPFold with subfold, metadata and names saved to $FOLD/dir is bundled,
+    loaded back as NPFold and extracted into $FOLD/extract checking the
+    arrays and the extracted file bytes match, and POD access with copy
+
+corrupt
+    a flipped byte within a section is detected by the checksums,
+    a truncated bundle fails to open
+
+bench
+    load time of a directory of NUM small arrays with NPFold::Load compared
+    with sbundle::Load and sbundle::fold
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+#include "ssys.h"
+#include "sstamp.h"
+#include "sbundle.h"
+
+struct sbundle_test
+{
+    struct Item { float v[16] ; } ;
+
+    static const char* FOLD ;
+    static NPFold* Make(int num);
+    static int Compare(const NP* a, const NP* b);
+    static int Compare(const NPFold* a, const NPFold* b);
+    static int CompareFiles(const char* adir, const char* bdir);
+
+    static int roundtrip();
+    static int corrupt();
+    static int bench();
+    static int Main();
+};
+
+const char* sbundle_test::FOLD = ssys::getenvvar("FOLD", "/tmp/sbundle_test") ;
+
+inline NPFold* sbundle_test::Make(int num)
+{
+    NPFold* f = new NPFold ;
+    f->set_meta<int>("num", num) ;
+
+    NP* item = NP::Make<float>(num, 4, 4) ;
+    item->fillIndexFlat() ;
+    item->set_meta<std::string>("creator", "sbundle_test") ;
+    f->add("item.npy", item );
+
+    NP* idx = NP::Make<int>(num) ;
+    idx->fillIndexFlat() ;
+    f->add("idx.npy", idx );
+
+    NPFold* sub = new NPFold ;
+    for(int i=0 ; i < 3 ; i++)
+    {
+        NP* a = NP::Make<double>(2+i, 3) ;
+        a->fillIndexFlat() ;
+        std::vector<std::string> names ;
+        for(int j=0 ; j < 2+i ; j++) names.push_back( "name" + std::to_string(j) ) ;
+        a->set_names(names) ;
+        sub->add( ("a" + std::to_string(i) + ".npy").c_str(), a );
+    }
+    NP* u8 = NP::Make<unsigned char>(num, 16) ;
+    u8->fillIndexFlat() ;
+    sub->add("u8.npy", u8 );
+    f->add_subfold("sub", sub );
+    return f ;
+}
+
+inline int sbundle_test::Compare(const NP* a, const NP* b)
+{
+    int rc = 0 ;
+    rc += int( a == nullptr || b == nullptr ) ;
+    if(rc) return rc ;
+    rc += int( a->shape != b->shape ) ;
+    rc += int( a->uifc != b->uifc || a->ebyte != b->ebyte ) ;
+    rc += int( a->arr_bytes() != b->arr_bytes() ) ;
+    rc += int( memcmp( a->bytes(), b->bytes(), a->arr_bytes() ) != 0 ) ;
+    rc += int( a->meta != b->meta ) ;
+    rc += int( a->names != b->names ) ;
+    return rc ;
+}
+
+inline int sbundle_test::Compare(const NPFold* a, const NPFold* b)
+{
+    int rc = 0 ;
+    rc += int( a->kk != b->kk ) ;
+    rc += int( a->ff != b->ff ) ;
+    rc += int( a->meta != b->meta ) ;
+    if(rc) return rc ;
+    for(unsigned i=0 ; i < a->kk.size() ; i++) rc += Compare( a->aa[i], b->aa[i] ) ;
+    for(unsigned i=0 ; i < a->ff.size() ; i++) rc += Compare( a->subfold[i], b->subfold[i] ) ;
+    return rc ;
+}
+
+inline int sbundle_test::CompareFiles(const char* adir, const char* bdir)
+{
+    std::vector<std::string> akeys ;
+    std::vector<std::string> bkeys ;
+    sbundle::Collect(akeys, adir, nullptr );
+    sbundle::Collect(bkeys, bdir, nullptr );
+    int rc = int( akeys != bkeys || akeys.size() == 0 ) ;
+    for(unsigned i=0 ; rc == 0 && i < akeys.size() ; i++)
+    {
+        std::string abuf ;
+        std::string bbuf ;
+        sbundle::ReadFile(abuf, sbundle::Join(adir, akeys[i].c_str()).c_str() );
+        sbundle::ReadFile(bbuf, sbundle::Join(bdir, akeys[i].c_str()).c_str() );
+        rc += int( abuf != bbuf ) ;
+    }
+    return rc ;
+}
+
+inline int sbundle_test::roundtrip()
+{
+    std::string dir = sbundle::Join(FOLD, "dir") ;
+    std::string extract = sbundle::Join(FOLD, "extract") ;
+    std::string path = sbundle::Join(FOLD, "roundtrip.bundle") ;
+
+    NPFold* f = Make(100) ;
+    f->save(dir.c_str()) ;
+    NPFold* g = NPFold::Load(dir.c_str()) ;
+
+    int rc = 0 ;
+    rc += sbundle::Create( path.c_str(), dir.c_str() ) ;
+
+    sbundle* b = sbundle::Load( path.c_str() ) ;
+    rc += int( b == nullptr ) ;
+    if( b == nullptr ) return rc ;
+    std::cout << b->desc() ;
+
+    NPFold* h = b->fold() ;
+    rc += Compare(g, h) ;
+
+    NPFold* s = b->fold("sub") ;
+    rc += Compare(g->get_subfold("sub"), s) ;
+
+    for(int i=0 ; i < b->num_section() ; i++)
+    {
+        const sbundle_section& sec = b->table[i] ;
+        if(sec.is_array()) rc += int( sec.data_offset() % sbundle::ALIGN != 0 ) ;
+    }
+
+    std::vector<Item> items ;
+    rc += b->copy(items, "item.npy") ;
+    const NP* item = g->get("item.npy") ;
+    rc += int( items.size() != size_t(item->shape[0]) ) ;
+    rc += int( memcmp( items.data(), item->bytes(), item->arr_bytes() ) != 0 ) ;
+    rc += int( b->copy(items, "idx.npy") == 0 ) ;   // item size mismatch
+    rc += int( b->copy(items, "missing.npy") == 0 ) ;
+
+    rc += b->extract( extract.c_str() ) ;
+    rc += CompareFiles( dir.c_str(), extract.c_str() ) ;
+
+    std::cout
+        << "sbundle_test::roundtrip"
+        << " num_section " << b->num_section()
+        << " file_bytes " << b->file_bytes
+        << " rc " << rc
+        << "\n"
+        ;
+    delete b ;
+    return rc ;
+}
+
+inline int sbundle_test::corrupt()
+{
+    std::string dir = sbundle::Join(FOLD, "dir") ;
+    std::string path = sbundle::Join(FOLD, "corrupt.bundle") ;
+
+    NPFold* f = Make(100) ;
+    f->save(dir.c_str()) ;
+
+    int rc = 0 ;
+    rc += sbundle::Create( path.c_str(), dir.c_str() ) ;
+
+    std::string buf ;
+    sbundle::ReadFile(buf, path.c_str()) ;
+
+    sbundle* b = sbundle::Open( path.c_str() ) ;
+    rc += int( b == nullptr ) ;
+    if( b == nullptr ) return rc ;
+    const sbundle_section* s = b->section("item.npy") ;
+    uint64_t pos = s->data_offset() + 17 ;
+    delete b ;
+
+    std::string flip = buf ;
+    flip[pos] ^= 0x10 ;
+    { std::ofstream fp(path.c_str(), std::ios::out|std::ios::binary) ; fp << flip ; }
+
+    rc += int( sbundle::Open( path.c_str(), true ) != nullptr ) ;
+    sbundle* u = sbundle::Open( path.c_str(), false ) ;
+    rc += int( u == nullptr ) ;
+    if(u) rc += int( u->verify() != 1 ) ;
+    delete u ;
+
+    std::string trunc = buf.substr(0, buf.size() - 1) ;
+    { std::ofstream fp(path.c_str(), std::ios::out|std::ios::binary) ; fp << trunc ; }
+    rc += int( sbundle::Open( path.c_str(), false ) != nullptr ) ;
+
+    std::cout << "sbundle_test::corrupt rc " << rc << "\n" ;
+    return rc ;
+}
+
+inline int sbundle_test::bench()
+{
+    int NUM = ssys::getenvint("NUM", 200) ;
+    std::string name = "bench_" + std::to_string(NUM) ;
+    std::string dir = sbundle::Join(FOLD, name.c_str()) ;
+    std::string path = dir + sbundle::EXT ;
+
+    NPFold* f = new NPFold ;
+    for(int i=0 ; i < NUM ; i++)
+    {
+        NP* a = NP::Make<float>(1 + i % 10, 4, 4) ;
+        a->fillIndexFlat() ;
+        f->add( ("a" + std::to_string(i) + ".npy").c_str(), a );
+    }
+    f->save(dir.c_str()) ;
+
+    int rc = 0 ;
+    rc += sbundle::Create( path.c_str(), dir.c_str() ) ;
+
+    int64_t t0 = sstamp::Now() ;
+    NPFold* g = NPFold::Load(dir.c_str()) ;
+    int64_t t1 = sstamp::Now() ;
+    sbundle* b = sbundle::Load(path.c_str()) ;
+    int64_t t2 = sstamp::Now() ;
+    NPFold* h = b ? b->fold() : nullptr ;
+    int64_t t3 = sstamp::Now() ;
+
+    rc += int( h == nullptr ) ;
+    if(h) rc += Compare(g, h) ;
+
+    std::cout
+        << "sbundle_test::bench"
+        << " NUM " << NUM
+        << " NPFold::Load " << std::setw(8) << (t1 - t0) << " us"
+        << " sbundle::Load " << std::setw(8) << (t2 - t1) << " us"
+        << " sbundle::fold " << std::setw(8) << (t3 - t2) << " us"
+        << " rc " << rc
+        << "\n"
+        ;
+    delete b ;
+    return rc ;
+}
+
+inline int sbundle_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "ALL") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"roundtrip")==0) rc += roundtrip();
+    if(ALL||strcmp(TEST,"corrupt")==0)   rc += corrupt();
+    if(ALL||strcmp(TEST,"bench")==0)     rc += bench();
+    return rc ;
+}
+
+int main()
+{
+    return sbundle_test::Main() ;
+}
@@ -0,0 +1,166 @@
+/**
+scompact_test.cc
+==================
+
+::
+
+   ~/o/sysrap/tests/scompact_test.sh
+
+transforms
+    affine transform pairs with many repeats, as for the local transforms
+    of a detector tree, are deduplicated into 3x4 form and expanded back,
+    checking the roundtrip is bitwise exact and reporting the bytes of
+    the full and compact forms
+
+digests
+    hex digests roundtrip via binary, strings that are not hex
+    digests give nullptr
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cstring>
+
+#include "ssys.h"
+#include "scompact.h"
+
+struct scompact_test
+{
+    static void Fill(double* m, double* v, int k);
+    static int transforms();
+    static int digests();
+    static int Main();
+};
+
+/**
+scompact_test::Fill
+---------------------
+
+Rotation about z by angle k with translation and its inverse,
+in glm column major layout.
+
+**/
+
+inline void scompact_test::Fill(double* m, double* v, int k)
+{
+    double a = 0.1*k ;
+    double c = std::cos(a) ;
+    double s = std::sin(a) ;
+    double tx = 10.*k ;
+    double ty = -5.*k ;
+    double tz = 1000./(k+1) ;
+
+    double mm[16] = { c, s, 0., 0.,   -s, c, 0., 0.,   0., 0., 1., 0.,   tx, ty, tz, 1. } ;
+    double vx = -( c*tx + s*ty) ;
+    double vy = -(-s*tx + c*ty) ;
+    double vv[16] = { c, -s, 0., 0.,   s, c, 0., 0.,   0., 0., 1., 0.,   vx, vy, -tz, 1. } ;
+    memcpy( m, mm, sizeof(mm) );
+    memcpy( v, vv, sizeof(vv) );
+}
+
+inline int scompact_test::transforms()
+{
+    int num = ssys::getenvint("NUM", 400000) ;
+    int num_distinct = 2000 ;
+    std::vector<double> m2w(16*num) ;
+    std::vector<double> w2m(16*num) ;
+
+    std::mt19937 rng(1) ;
+    std::uniform_int_distribution<int> pick(0, num_distinct - 1) ;
+    for(int i=0 ; i < num ; i++)
+    {
+        int k = i < num_distinct ? i : pick(rng) ;
+        Fill( m2w.data() + 16*i, w2m.data() + 16*i, k );
+    }
+
+    int rc = 0 ;
+    rc += int( !scompact::IsAffine(m2w.data(), num) ) ;
+
+    NP* idx = nullptr ;
+    NP* tran = scompact::Dedup( m2w.data(), w2m.data(), num, &idx );
+    rc += int( tran->shape[0] != num_distinct ) ;
+
+    std::vector<double> m2w_(16*num) ;
+    std::vector<double> w2m_(16*num) ;
+    scompact::Redup( m2w_.data(), w2m_.data(), tran, idx );
+    rc += int( memcmp( m2w.data(), m2w_.data(), m2w.size()*sizeof(double) ) != 0 ) ;
+    rc += int( memcmp( w2m.data(), w2m_.data(), w2m.size()*sizeof(double) ) != 0 ) ;
+
+    NP* aff = scompact::Affine( m2w.data(), num ) ;
+    NP* full = scompact::Full( aff ) ;
+    rc += int( memcmp( m2w.data(), full->cvalues<double>(), m2w.size()*sizeof(double) ) != 0 ) ;
+
+    long full_bytes = 2*m2w.size()*sizeof(double) ;
+    long compact_bytes = tran->arr_bytes() + idx->arr_bytes() ;
+
+    std::cout
+        << "scompact_test::transforms"
+        << " num " << num
+        << " num_tran " << tran->shape[0]
+        << " full_bytes " << full_bytes
+        << " compact_bytes " << compact_bytes
+        << " ratio " << std::fixed << std::setprecision(4) << double(compact_bytes)/double(full_bytes)
+        << " affine_ratio " << double(aff->arr_bytes())/double(full->arr_bytes())
+        << " rc " << rc
+        << "\n"
+        ;
+    return rc ;
+}
+
+inline int scompact_test::digests()
+{
+    std::mt19937 rng(2) ;
+    std::uniform_int_distribution<int> byte(0, 255) ;
+    const char* HEX = "0123456789abcdef" ;
+    int num = 1000 ;
+    std::vector<std::string> digs(num) ;
+    for(int i=0 ; i < num ; i++)
+    for(int j=0 ; j < 16 ; j++)
+    {
+        int b = byte(rng) ;
+        digs[i] += HEX[b >> 4] ;
+        digs[i] += HEX[b & 0xf] ;
+    }
+
+    int rc = 0 ;
+    NP* a = scompact::Digest(digs) ;
+    rc += int( a == nullptr ) ;
+
+    std::vector<std::string> digs_ ;
+    if(a) scompact::Hex(digs_, a) ;
+    rc += int( digs_ != digs ) ;
+
+    std::vector<std::string> other = { "Dummy0", "Dummy1" } ;
+    rc += int( scompact::Digest(other) != nullptr ) ;
+
+    std::vector<std::string> upper = digs ;
+    upper[0][0] = 'A' ;
+    rc += int( scompact::Digest(upper) != nullptr ) ;
+
+    std::cout
+        << "scompact_test::digests"
+        << " num " << num
+        << " txt_bytes " << num*33
+        << " bin_bytes " << ( a ? a->arr_bytes() : 0 )
+        << " rc " << rc
+        << "\n"
+        ;
+    return rc ;
+}
+
+inline int scompact_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "ALL") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"transforms")==0) rc += transforms();
+    if(ALL||strcmp(TEST,"digests")==0)    rc += digests();
+    return rc ;
+}
+
+int main()
+{
+    return scompact_test::Main() ;
+}
@@ -0,0 +1,194 @@
+/**
+sdomain_adaptive_test.cc
+==========================
+
+::
+
+   ~/o/sysrap/tests/sdomain_adaptive_test.sh
+   TEST=accuracy ~/o/sysrap/tests/sdomain_adaptive_test.sh
+
+check
+    every property is within tolerance with the combined knots,
+    knots are a subset of the base grid including the domain ends and
+    the remap gives the same values as binary search interpolation
+    on the knots at random wavelengths
+
+accuracy
+    max relative errors against the analytic functions evaluated on a
+    0.01nm grid for the adaptive knots and the uniform 1nm domain,
+    with the number of samples of each, the adaptive error is required
+    to be no worse than uniform and close to rtol where the base grid
+    resolves the features
+
+The synthetic properties mimic a smooth RINDEX, an ABSLENGTH with a
+sharp absorption edge, a narrow scintillator emission peak and a PMT
+efficiency with a steep cutoff.
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <functional>
+#include <cstring>
+
+#include "sdomain_adaptive.h"
+
+struct sdomain_adaptive_test
+{
+    typedef std::function<double(double)> FN ;
+    static void Props(std::vector<std::string>& names, std::vector<FN>& fns);
+    static double Interp(const std::vector<double>& x, const std::vector<double>& y, double xq);
+    static int check();
+    static int accuracy();
+    static int Main();
+};
+
+inline void sdomain_adaptive_test::Props(std::vector<std::string>& names, std::vector<FN>& fns)
+{
+    names.push_back("Water/RINDEX") ;
+    fns.push_back( [](double nm){ return 1.32 + 3.0e3/(nm*nm) + 3.0e8/(nm*nm*nm*nm) ; } );
+
+    names.push_back("LS/ABSLENGTH") ;
+    fns.push_back( [](double nm){ return 1e-3 + 2e4/(1. + std::exp(-(nm - 390.)/2.0)) ; } );
+
+    names.push_back("LS/EMISSION") ;
+    fns.push_back( [](double nm){ double d = (nm - 430.)/5.0 ; return 0.02 + std::exp(-0.5*d*d) ; } );
+
+    names.push_back("PMT/EFFICIENCY") ;
+    fns.push_back( [](double nm){ return nm < 300. ? 0. : 0.3*(1. - std::exp(-(nm - 300.)/4.0))*std::exp(-(nm - 300.)/400.) ; } );
+
+    names.push_back("Rock/CONST") ;
+    fns.push_back( [](double){ return 1e6 ; } );
+}
+
+inline double sdomain_adaptive_test::Interp(const std::vector<double>& x, const std::vector<double>& y, double xq)
+{
+    int n = x.size() ;
+    if( xq <= x[0] ) return y[0] ;
+    if( xq >= x[n-1] ) return y[n-1] ;
+    int i = std::upper_bound(x.begin(), x.end(), xq) - x.begin() - 1 ;
+    double t = (xq - x[i])/(x[i+1] - x[i]) ;
+    return y[i] + t*(y[i+1] - y[i]) ;
+}
+
+inline int sdomain_adaptive_test::check()
+{
+    std::vector<std::string> names ;
+    std::vector<FN> fns ;
+    Props(names, fns);
+
+    sdomain_adaptive ad ;
+    for(unsigned p=0 ; p < names.size() ; p++) ad.add_fn(names[p].c_str(), fns[p]) ;
+    ad.finalize();
+    std::cout << ad.desc() ;
+
+    int rc = 0 ;
+    int num_knots = ad.knots.size() ;
+    rc += int( ad.knots[0] != sdomain::DOMAIN_LOW || ad.knots[num_knots-1] != sdomain::DOMAIN_HIGH ) ;
+    for(int k=0 ; k < num_knots ; k++) rc += int( ad.knots[k] != ad.base_nm[ad.knot_index[k]] ) ;
+
+    const double* rr = ad.report->cvalues<double>() ;
+    for(unsigned p=0 ; p < names.size() ; p++) rc += int( rr[p*sdomain_adaptive::REPORT_NUM+sdomain_adaptive::REPORT_ERR_ADAPTIVE] > ad.rtol ) ;
+
+    // remap into the knots gives the same as searching the knots
+    NP* remap = ad.get_remap() ;
+    const float* r = remap->cvalues<float>() ;
+    int num_remap = remap->shape[0] ;
+    for(int k=0 ; k < num_knots ; k++) rc += int( r[ad.knot_index[k]] != float(k) ) ;
+
+    std::mt19937 rng(1) ;
+    std::uniform_real_distribution<double> u(sdomain::DOMAIN_LOW - 5., sdomain::DOMAIN_HIGH + 5.) ;
+    double dmax = 0. ;
+    for(unsigned p=0 ; p < names.size() ; p++)
+    {
+        std::vector<double> y(num_knots) ;
+        for(int k=0 ; k < num_knots ; k++) y[k] = fns[p](ad.knots[k]) ;
+        double ymax = 0. ;
+        for(int k=0 ; k < num_knots ; k++) ymax = std::max(ymax, std::abs(y[k])) ;
+
+        for(int n=0 ; n < 100000 ; n++)
+        {
+            double nm = u(rng) ;
+            double fx = ( nm - sdomain::DOMAIN_LOW )/ad.base_step ;
+            double uk = sdomain_adaptive::Remap(r, num_remap, fx) ;
+            int i = std::min( int(uk), num_knots - 2 ) ;
+            double t = uk - double(i) ;
+            double v_remap = y[i] + t*(y[i+1] - y[i]) ;
+            double v_search = Interp(ad.knots, y, nm) ;
+            dmax = std::max( dmax, std::abs(v_remap - v_search)/ymax ) ;
+        }
+    }
+    rc += int( dmax > 1e-6 ) ;
+
+    std::cout
+        << "sdomain_adaptive_test::check"
+        << " num_knots " << num_knots
+        << " num_remap " << num_remap
+        << " remap_vs_search_dmax " << std::scientific << dmax
+        << " rc " << rc
+        << "\n"
+        ;
+    delete remap ;
+    return rc ;
+}
+
+inline int sdomain_adaptive_test::accuracy()
+{
+    std::vector<std::string> names ;
+    std::vector<FN> fns ;
+    Props(names, fns);
+
+    sdomain_adaptive ad ;
+    for(unsigned p=0 ; p < names.size() ; p++) ad.add_fn(names[p].c_str(), fns[p]) ;
+    ad.finalize();
+
+    sdomain uni ;
+    std::vector<double> ux(uni.wavelength_nm, uni.wavelength_nm + uni.length) ;
+
+    int rc = 0 ;
+    for(unsigned p=0 ; p < names.size() ; p++)
+    {
+        std::vector<double> ay, uy ;
+        for(unsigned k=0 ; k < ad.knots.size() ; k++) ay.push_back( fns[p](ad.knots[k]) ) ;
+        for(unsigned k=0 ; k < ux.size() ; k++)        uy.push_back( fns[p](ux[k]) ) ;
+
+        double ymax = 0. ;
+        for(double nm = sdomain::DOMAIN_LOW ; nm <= sdomain::DOMAIN_HIGH ; nm += 0.01 ) ymax = std::max(ymax, std::abs(fns[p](nm))) ;
+        double scale = sdomain_adaptive::FLOOR*ymax ;
+
+        double ea = 0. ;
+        double eu = 0. ;
+        for(double nm = sdomain::DOMAIN_LOW ; nm <= sdomain::DOMAIN_HIGH ; nm += 0.01 )
+        {
+            double y = fns[p](nm) ;
+            double d = std::max( std::abs(y), scale ) ;
+            ea = std::max( ea, std::abs( Interp(ad.knots, ay, nm) - y )/d ) ;
+            eu = std::max( eu, std::abs( Interp(ux, uy, nm) - y )/d ) ;
+        }
+        std::cout
+            << "sdomain_adaptive_test::accuracy"
+            << " " << std::setw(16) << names[p]
+            << " adaptive(" << std::setw(4) << ad.knots.size() << ") " << std::scientific << std::setprecision(3) << ea
+            << " uniform(" << std::setw(4) << ux.size() << ") " << eu
+            << "\n"
+            ;
+        rc += int( ea > std::max( 2.*ad.rtol, eu ) ) ;  // between base grid points features narrower than base_step are not resolved
+    }
+    return rc ;
+}
+
+inline int sdomain_adaptive_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "check") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"check")==0)    rc += check();
+    if(ALL||strcmp(TEST,"accuracy")==0) rc += accuracy();
+    return rc ;
+}
+
+int main()
+{
+    return sdomain_adaptive_test::Main() ;
+}
@@ -0,0 +1,251 @@
+/**
+sphoton_soa_test.cc
+=====================
+
+::
+
+   ~/o/sysrap/tests/sphoton_soa_test.sh
+   TEST=bench ~/o/sysrap/tests/sphoton_soa_test.sh
+   TEST=ALL ~/o/sysrap/tests/sphoton_soa_test.sh
+
+parity
+    bitwise round trip of random (n,4,4) photons through Transpose and
+    Combine, checks view accessors against the AoS words, and zeroing of
+    columns absent from the fold
+
+persist
+    Columnarize_r of a fold tree with photon and hit arrays, save,
+    selective sphoton_soa::Load of single columns, and NPFold load
+    followed by Decolumnarize_r giving back the original arrays
+
+bench
+    count of photons with a flagmask bit : loading the AoS photon array
+    and striding over the records compared with loading only the
+    flagmask column
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cstring>
+
+#include "ssys.h"
+#include "schrono.h"
+#include "sphoton_soa.h"
+
+struct sphoton_soa_test
+{
+    static const char* FOLD ;
+    static NP* MakePhoton(int ni, unsigned seed);
+
+    static int parity();
+    static int persist();
+    static int bench();
+    static int Main();
+};
+
+const char* sphoton_soa_test::FOLD = ssys::getenvvar("FOLD", "/tmp/sphoton_soa_test") ;
+
+inline NP* sphoton_soa_test::MakePhoton(int ni, unsigned seed)
+{
+    NP* a = NP::Make<float>(ni, 4, 4) ;
+    float* ff = a->values<float>() ;
+    unsigned* uu = (unsigned*)ff ;
+    std::mt19937 rng(seed) ;
+    std::uniform_real_distribution<float> u(-1000.f, 1000.f) ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        for(int j=0 ; j < 12 ; j++) ff[i*16+j] = u(rng) ;
+        uu[i*16+7] = rng() % 50000 ;
+        for(int j=12 ; j < 16 ; j++) uu[i*16+j] = rng() ;
+    }
+    a->set_meta<int>("index", 42 );
+    return a ;
+}
+
+inline int sphoton_soa_test::parity()
+{
+    int ni = 100003 ;
+    NP* a = MakePhoton(ni, 1) ;
+    const unsigned* uu = (const unsigned*)a->bytes() ;
+
+    NPFold* soa = sphoton_soa::Transpose(a) ;
+    NP* b = sphoton_soa::Combine(soa) ;
+
+    int rc = 0 ;
+    rc += int( b == nullptr || b->shape != a->shape ) ;
+    rc += int( memcmp( a->bytes(), b->bytes(), a->arr_bytes() ) != 0 ) ;
+    rc += int( b->get_meta<int>("index") != 42 ) ;
+
+    sphoton_soa v(soa) ;
+    rc += int( v.num != ni ) ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        const unsigned* r = uu + i*16 ;
+        rc += int( v.flag(i) != ( r[12] & 0xffffu ) ) ;
+        rc += int( v.boundary(i) != ( r[12] >> 16 ) ) ;
+        rc += int( v.idx(i) != ( r[14] & 0x7fffffffu ) ) ;
+        rc += int( memcmp( v.pol + 3*i, r + 8, 3*sizeof(float) ) != 0 ) ;
+    }
+
+    NPFold* some = sphoton_soa::Transpose(a, "pos,flagmask,nonesuch") ;
+    NP* c = sphoton_soa::Combine(some) ;
+    const unsigned* cc = (const unsigned*)c->bytes() ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        const unsigned* r = uu + i*16 ;
+        const unsigned* s = cc + i*16 ;
+        rc += int( memcmp( r, s, 3*sizeof(unsigned)) != 0 || s[3] != 0u || s[4] != 0u || s[12] != 0u || s[15] != r[15] ) ;
+    }
+    rc += int( some->num_items() != 2 ) ;
+    rc += int( sphoton_soa::Transpose(soa->get("pos")) != nullptr ) ;
+
+    std::cout
+        << "sphoton_soa_test::parity"
+        << " a " << a->sstr()
+        << " rc " << rc
+        << "\n"
+        << v.desc()
+        << "\n"
+        ;
+
+    soa->clear();
+    some->clear();
+    delete soa ;
+    delete some ;
+    delete a ;
+    delete b ;
+    delete c ;
+    return rc ;
+}
+
+inline int sphoton_soa_test::persist()
+{
+    NP* photon = MakePhoton(1000, 2) ;
+    NP* hit = MakePhoton(100, 3) ;
+    NP* seq = NP::Make<int>(1000, 2) ;
+
+    NPFold* top = new NPFold ;
+    NPFold* f000 = top->add_subfold();
+    f000->add("photon", photon);
+    f000->add("hit", hit);
+    f000->add("seq", seq);
+
+    NPFold* save_fold = top->shallowcopy() ;
+    std::vector<NPFold*> created ;
+    int num_soa = sphoton_soa::Columnarize_r(save_fold, "photon,hit,seq", &created);
+
+    int rc = 0 ;
+    rc += int( num_soa != 2 || created.size() != 2 ) ;
+    rc += int( f000->get("photon") != photon ) ;    // source fold unchanged
+
+    std::string dir = std::string(FOLD) + "/persist" ;
+    save_fold->save(dir.c_str());
+    for(unsigned i=0 ; i < created.size() ; i++)
+    {
+        created[i]->clear();
+        delete created[i] ;
+    }
+
+    std::string sub = dir + "/f000" ;
+    NPFold* flags = sphoton_soa::Load(sub.c_str(), "photon", "flagmask,boundary_flag") ;
+    rc += int( flags == nullptr || flags->num_items() != 2 ) ;
+    sphoton_soa v(flags) ;
+    const unsigned* pp = (const unsigned*)photon->bytes() ;
+    for(int i=0 ; i < v.num ; i++) rc += int( v.flagmask[i] != pp[i*16+15] || v.boundary_flag[i] != pp[i*16+12] ) ;
+    rc += int( v.num != 1000 || v.pos != nullptr ) ;
+
+    NPFold* back = NPFold::Load(dir.c_str()) ;
+    int num_aos = sphoton_soa::Decolumnarize_r(back) ;
+    rc += int( num_aos != 2 ) ;
+    const NPFold* b000 = back->get_subfold("f000") ;
+    const NP* photon2 = b000 ? b000->get("photon") : nullptr ;
+    const NP* hit2 = b000 ? b000->get("hit") : nullptr ;
+    rc += int( photon2 == nullptr || memcmp(photon2->bytes(), photon->bytes(), photon->arr_bytes()) != 0 ) ;
+    rc += int( hit2 == nullptr || memcmp(hit2->bytes(), hit->bytes(), hit->arr_bytes()) != 0 ) ;
+    rc += int( b000 == nullptr || b000->get("seq") == nullptr ) ;
+
+    std::cout
+        << "sphoton_soa_test::persist"
+        << " dir " << dir
+        << " num_soa " << num_soa
+        << " num_aos " << num_aos
+        << " rc " << rc
+        << "\n"
+        << v.desc()
+        << "\n"
+        ;
+
+    top->clear();
+    back->clear();
+    flags->clear();
+    delete top ;
+    delete back ;
+    delete flags ;
+    return rc ;
+}
+
+inline int sphoton_soa_test::bench()
+{
+    int ni = ssys::getenvint("NUM_PHOTON", 2000000) ;
+    NP* a = MakePhoton(ni, 4) ;
+    std::string dir = std::string(FOLD) + "/bench" ;
+    a->save(dir.c_str(), "photon.npy");
+
+    schrono::TP t0 = schrono::stamp();
+    NPFold* soa = sphoton_soa::Transpose(a) ;
+    schrono::TP t1 = schrono::stamp();
+    soa->save((dir + "/photon" + sphoton_soa::SUFFIX).c_str());
+    soa->clear();
+    delete soa ;
+
+    unsigned mask = 0x1u << 6 ;
+
+    schrono::TP t2 = schrono::stamp();
+    NP* aos = NP::Load(dir.c_str(), "photon.npy") ;
+    const unsigned* uu = (const unsigned*)aos->bytes() ;
+    int n_aos = 0 ;
+    for(int i=0 ; i < ni ; i++) n_aos += int( ( uu[i*16+15] & mask ) != 0 ) ;
+    schrono::TP t3 = schrono::stamp();
+
+    NPFold* col = sphoton_soa::Load(dir.c_str(), "photon", "flagmask") ;
+    sphoton_soa v(col) ;
+    int n_soa = 0 ;
+    for(int i=0 ; i < v.num ; i++) n_soa += int( ( v.flagmask[i] & mask ) != 0 ) ;
+    schrono::TP t4 = schrono::stamp();
+
+    std::cout
+        << "sphoton_soa_test::bench"
+        << " ni " << ni
+        << " transpose " << std::fixed << std::setprecision(4) << schrono::duration(t0, t1)
+        << " aos_load_count " << schrono::duration(t2, t3)
+        << " soa_load_count " << schrono::duration(t3, t4)
+        << " ratio " << schrono::duration(t2, t3)/schrono::duration(t3, t4)
+        << " n_aos " << n_aos
+        << " n_soa " << n_soa
+        << "\n"
+        ;
+
+    col->clear();
+    delete col ;
+    delete aos ;
+    delete a ;
+    return n_aos == n_soa ? 0 : 1 ;
+}
+
+inline int sphoton_soa_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "parity") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"parity")==0)  rc += parity();
+    if(ALL||strcmp(TEST,"persist")==0) rc += persist();
+    if(ALL||strcmp(TEST,"bench")==0)   rc += bench();
+    return rc ;
+}
+
+int main()
+{
+    return sphoton_soa_test::Main() ;
+}
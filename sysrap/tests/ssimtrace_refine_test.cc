@@ -0,0 +1,212 @@
+/**
+ssimtrace_refine_test.cc
+==========================
+
+::
+
+   ~/o/sysrap/tests/ssimtrace_refine_test.sh
+   TEST=ALL LEVEL=6 ~/o/sysrap/tests/ssimtrace_refine_test.sh
+
+Uses an analytic intersector in place of CSGQuery::simtrace with
+a 0.5mm thick spherical shell of radius 100mm, much thinner than the
+10mm base grid spacing, and a solid sphere of radius 30mm.
+
+check
+    refined points cover every surface in the XZ plane at the finest spacing,
+    no grid point is traced twice and the adaptive ray count is compared
+    with that of a uniform grid at the finest spacing
+
+save
+    writes the genstep, simtrace and cell arrays to $FOLD
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+#include "ssimtrace_refine.h"
+
+struct ssimtrace_refine_test
+{
+    static constexpr const float R_SHELL = 100.f ;
+    static constexpr const float T_SHELL = 0.5f ;
+    static constexpr const float R_BALL  = 30.f ;
+    static constexpr const int NX = 16 ;
+    static constexpr const int NZ = 9 ;
+    static constexpr const float SCALE = 10.f ;
+
+    static bool Sphere(float& t, float3& n, const float3& o, const float3& d, float r, float tmin, float sign);
+    static bool Intersect(quad4& p);
+    static void MakeBase(std::vector<quad6>& base);
+
+    static int check();
+    static int save();
+    static int Main();
+};
+
+/**
+ssimtrace_refine_test::Sphere
+--------------------------------
+
+Closest root beyond tmin, normal is radial times sign which
+is -1 for the inner surface of the shell.
+
+**/
+
+inline bool ssimtrace_refine_test::Sphere(float& t, float3& n, const float3& o, const float3& d, float r, float tmin, float sign)
+{
+    float b = dot(o, d) ;
+    float c = dot(o, o) - r*r ;
+    float disc = b*b - c ;
+    if( disc < 0.f ) return false ;
+    float sd = std::sqrt(disc) ;
+    float t0 = -b - sd ;
+    float t1 = -b + sd ;
+    float tt = t0 > tmin ? t0 : ( t1 > tmin ? t1 : -1.f ) ;
+    if( tt < 0.f || tt > t ) return false ;
+    t = tt ;
+    n = sign*normalize( o + tt*d ) ;
+    return true ;
+}
+
+inline bool ssimtrace_refine_test::Intersect(quad4& p)
+{
+    float3 o = make_float3( p.q2.f.x, p.q2.f.y, p.q2.f.z );
+    float3 d = make_float3( p.q3.f.x, p.q3.f.y, p.q3.f.z );
+    float tmin = p.q1.f.w ;
+    float t = 1e30f ;
+    float3 n = make_float3(0.f, 0.f, 0.f) ;
+    bool hit = false ;
+    hit |= Sphere(t, n, o, d, R_SHELL,           tmin,  1.f );
+    hit |= Sphere(t, n, o, d, R_SHELL - T_SHELL, tmin, -1.f );
+    hit |= Sphere(t, n, o, d, R_BALL,            tmin,  1.f );
+    if(!hit) return false ;
+    p.q0.f = make_float4( n.x, n.y, n.z, t );
+    p.q1.f.x = o.x + t*d.x ;
+    p.q1.f.y = o.y + t*d.y ;
+    p.q1.f.z = o.z + t*d.z ;
+    return true ;
+}
+
+/**
+ssimtrace_refine_test::MakeBase
+---------------------------------
+
+XZ grid of gensteps with identity frame, as SFrameGenstep::MakeCenterExtentGenstep
+with CEGS 16:0:9 and local_scale SCALE.
+
+**/
+
+inline void ssimtrace_refine_test::MakeBase(std::vector<quad6>& base)
+{
+    for(int ix=-NX ; ix <= NX ; ix++)
+    for(int iz=-NZ ; iz <= NZ ; iz++)
+    {
+        quad6 gs ;
+        gs.zero();
+        gs.q1.f.w = 1.f ;
+        qat4 qt ;
+        qt.init();
+        qt.q3.f.x = float(ix)*SCALE ;
+        qt.q3.f.z = float(iz)*SCALE ;
+        qt.write(gs);
+        SGenstep::ConfigureGenstep(gs, OpticksGenstep_FRAME, XZ, SGenstep::GenstepID(ix,0,iz,0), 1 );
+        base.push_back(gs);
+    }
+}
+
+inline int ssimtrace_refine_test::check()
+{
+    int LEVEL = ssys::getenvint("LEVEL", 5) ;
+    std::vector<quad6> base ;
+    MakeBase(base);
+
+    ssimtrace_refine rf(Intersect, 0, LEVEL) ;
+    rf.init(base, SCALE);
+    rf.run();
+    std::cout << rf.desc() << "\n" ;
+
+    int rc = 0 ;
+    rc += int( rf.index.size() != rf.genstep.size() ) ;
+
+    // every genstep position matches its key
+    float fine = SCALE/float(1 << rf.max_level) ;
+    float dmax = 0.f ;
+    for(unsigned i=0 ; i < rf.genstep.size() ; i++)
+    {
+        const int4& c = rf.cell[i] ;
+        const quad6& gs = rf.genstep[i] ;
+        dmax = std::max( dmax, std::abs( gs.q5.f.x - c.x*fine ) ) ;
+        dmax = std::max( dmax, std::abs( gs.q5.f.z - c.z*fine ) ) ;
+    }
+    rc += int( dmax > 1e-3f ) ;
+
+    // surfaces are covered by finest level points
+    int num_sample = 0 ;
+    int num_uncovered = 0 ;
+    float radii[3] = { R_SHELL, R_SHELL - T_SHELL, R_BALL } ;
+    for(int s=0 ; s < 3 ; s++)
+    for(int k=0 ; k < 3600 ; k++)
+    {
+        double phi = 2.*M_PI*double(k)/3600. ;
+        float x = radii[s]*std::cos(phi) ;
+        float z = radii[s]*std::sin(phi) ;
+        if( std::abs(x) > NX*SCALE || std::abs(z) > NZ*SCALE ) continue ;
+        num_sample += 1 ;
+        int kx = int(std::lround(x/fine)) ;
+        int kz = int(std::lround(z/fine)) ;
+        int j = rf.find(kx, 0, kz, 0) ;
+        num_uncovered += int( j < 0 ) ;
+    }
+    rc += int( num_uncovered > 0 ) ;
+
+    long num_uniform = long(2*NX*(1 << rf.max_level) + 1)*long(2*NZ*(1 << rf.max_level) + 1)*rf.num_ray ;
+    long num_adaptive = rf.simtrace.size() ;
+    double ratio = double(num_adaptive)/double(num_uniform) ;
+    rc += int( ratio > 0.5 ) ;
+
+    std::cout
+        << "ssimtrace_refine_test::check"
+        << " finest " << fine
+        << " dmax " << dmax
+        << " num_sample " << num_sample
+        << " num_uncovered " << num_uncovered
+        << "\n"
+        << " rays adaptive " << num_adaptive
+        << " uniform " << num_uniform
+        << " ratio " << std::fixed << std::setprecision(4) << ratio
+        << " rc " << rc
+        << "\n"
+        ;
+    return rc ;
+}
+
+inline int ssimtrace_refine_test::save()
+{
+    const char* FOLD = ssys::getenvvar("FOLD", "/tmp/ssimtrace_refine_test") ;
+    std::vector<quad6> base ;
+    MakeBase(base);
+    ssimtrace_refine rf(Intersect, 0, ssys::getenvint("LEVEL", 5)) ;
+    rf.init(base, SCALE);
+    rf.run();
+    NPFold* f = rf.serialize() ;
+    f->save(FOLD);
+    std::cout << "ssimtrace_refine_test::save " << FOLD << "\n" ;
+    return 0 ;
+}
+
+inline int ssimtrace_refine_test::Main()
+{
+    const char* TEST = ssys::getenvvar("TEST", "check") ;
+    bool ALL = strcmp(TEST, "ALL") == 0 ;
+    int rc = 0 ;
+    if(ALL||strcmp(TEST,"check")==0) rc += check();
+    if(ALL||strcmp(TEST,"save")==0)  rc += save();
+    return rc ;
+}
+
+int main()
+{
+    return ssimtrace_refine_test::Main() ;
+}
@@ -0,0 +1,44 @@
+#!/bin/bash
+usage(){ cat << EOU
+ssimtrace_refine_test.sh
+=========================
+
+::
+
+   ~/o/sysrap/tests/ssimtrace_refine_test.sh
+   TEST=ALL LEVEL=6 ~/o/sysrap/tests/ssimtrace_refine_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=ssimtrace_refine_test
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=${TMP:-/tmp/$USER/opticks}/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+vars="BASH_SOURCE PWD FOLD name bin TEST LEVEL"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc -std=c++11 -O2 -lstdc++ -lm -I$CUDA_PREFIX/include -I$OPTICKS_PREFIX/externals/glm/glm -I.. -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE compile error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
@@ -0,0 +1,233 @@
+/**
+stree_factorize_test.cc
+=========================
+
+::
+
+   ~/o/sysrap/tests/stree_factorize_test.sh
+   NUM_PMT=200000 ~/o/sysrap/tests/stree_factorize_test.sh
+
+Synthetic geometry of NUM_PMT PMTs each with nested body and inner volumes
+plus NUM_PANEL panels of 64 bars each with an inner volume. The PMT and bar
+subtrees become the factors with their nested repeats disqualified as
+contained repeats, the panels are below the FREQ_CUT so stay global.
+
+The factorize passes and instance transform collection are run serially
+(stree__NUM_THREAD 1) and with the default number of threads, checking
+that the factors, node labels, remainder nodes and instance transforms
+are identical and reporting the time taken by each pass.
+
+The populate_prim_nidx passes of stree::factorize are not run as they
+need the CSG nodes which are not present in the synthetic geometry.
+
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+#include "ssys.h"
+#include "sstamp.h"
+#include "sdigest.h"
+#include "stree.h"
+
+struct stree_factorize_test
+{
+    static constexpr const int NUM_PASS = 7 ;
+    static constexpr const char* PASS[NUM_PASS] = {
+         "classifySubtrees",
+         "disqualifyContainedRepeats",
+         "sortSubtrees",
+         "enumerateFactors",
+         "labelFactorSubtrees",
+         "collectGlobalNodes",
+         "add_inst"
+       } ;
+
+    std::vector<int> last_child ;
+
+    int add(stree& st, int parent, int lvid, double tx, double ty, double tz );
+    void build(stree& st, int num_pmt, int num_panel, int num_bar );
+    static void Factorize(stree& st, int64_t* t );
+    static int Compare(const stree& a, const stree& b);
+    static int Main();
+};
+
+constexpr const char* stree_factorize_test::PASS[NUM_PASS] ;
+
+/**
+stree_factorize_test::add
+---------------------------
+
+Appends node with translation relative to the parent, linking it to the
+parent and previous sibling. The node digest covers the lvid and the local
+transform as done by U4Tree.
+
+**/
+
+inline int stree_factorize_test::add(stree& st, int parent, int lvid, double tx, double ty, double tz )
+{
+    int nidx = st.nds.size() ;
+
+    snode nd = {} ;
+    nd.index = nidx ;
+    nd.depth = parent > -1 ? st.nds[parent].depth + 1 : 0 ;
+    nd.sibdex = parent > -1 ? st.nds[parent].num_child : 0 ;
+    nd.parent = parent ;
+    nd.num_child = 0 ;
+    nd.first_child = -1 ;
+    nd.next_sibling = -1 ;
+    nd.lvid = lvid ;
+    nd.copyno = nd.sibdex ;
+    nd.sensor_id = -1 ;
+    nd.sensor_index = -1 ;
+    nd.repeat_index = 0 ;
+    nd.repeat_ordinal = -1 ;
+    nd.boundary = 0 ;
+    nd.sensor_name = -1 ;
+    st.nds.push_back(nd);
+
+    if( parent > -1 )
+    {
+        snode& pnd = st.nds[parent] ;
+        if( pnd.num_child == 0 ) pnd.first_child = nidx ;
+        else st.nds[last_child[parent]].next_sibling = nidx ;
+        pnd.num_child += 1 ;
+        last_child[parent] = nidx ;
+    }
+    last_child.push_back(-1);
+
+    glm::tmat4x4<double> tr(1.) ;
+    glm::tmat4x4<double> tv(1.) ;
+    tr[3] = glm::tvec4<double>(  tx,  ty,  tz, 1. );
+    tv[3] = glm::tvec4<double>( -tx, -ty, -tz, 1. );
+    st.m2w.push_back(tr);
+    st.w2m.push_back(tv);
+    st.gtd.push_back(tr);
+
+    sdigest u ;
+    u.add(lvid);
+    u.add(reinterpret_cast<const char*>(&tr[3][0]), 3*sizeof(double));
+    st.digs.push_back(u.finalize());
+
+    return nidx ;
+}
+
+inline void stree_factorize_test::build(stree& st, int num_pmt, int num_panel, int num_bar )
+{
+    int world = add(st, -1, 0, 0., 0., 0. );
+    for(int i=0 ; i < num_pmt ; i++)
+    {
+        int pmt = add(st, world, 1, 10.*(i % 1000), 10.*(i / 1000), 0. );
+        int body = add(st, pmt, 2, 0., 0., 1. );
+        add(st, body, 3, 0., 0., 2. );
+        add(st, body, 4, 0., 0., -2. );
+    }
+    for(int i=0 ; i < num_panel ; i++)
+    {
+        int panel = add(st, world, 5, 100.*i, 0., 5000. );
+        for(int j=0 ; j < num_bar ; j++)
+        {
+            int bar = add(st, panel, 6, 0., 5.*j, 0. );
+            add(st, bar, 7, 0., 0., 0. );
+        }
+    }
+}
+
+inline void stree_factorize_test::Factorize(stree& st, int64_t* t )
+{
+    int i = 0 ;
+    t[i++] = sstamp::Now() ; st.classifySubtrees();
+    t[i++] = sstamp::Now() ; st.disqualifyContainedRepeats();
+    t[i++] = sstamp::Now() ; st.sortSubtrees();
+    t[i++] = sstamp::Now() ; st.enumerateFactors();
+    t[i++] = sstamp::Now() ; st.labelFactorSubtrees();
+    t[i++] = sstamp::Now() ; st.collectGlobalNodes();
+    t[i++] = sstamp::Now() ; st.add_inst();
+    t[i++] = sstamp::Now() ;
+}
+
+inline int stree_factorize_test::Compare(const stree& a, const stree& b)
+{
+    int rc = 0 ;
+    rc += int( a.subs != b.subs ) ;
+    rc += int( a.subs_freq->vsu != b.subs_freq->vsu ) ;
+    rc += int( a.factor.size() != b.factor.size() ) ;
+    for(unsigned i=0 ; rc == 0 && i < a.factor.size() ; i++)
+    {
+        const sfactor& fa = a.factor[i] ;
+        const sfactor& fb = b.factor[i] ;
+        rc += int( fa.get_sub() != fb.get_sub() || fa.freq != fb.freq || fa.subtree != fb.subtree || fa.olvid != fb.olvid ) ;
+    }
+    rc += int( a.nds.size() != b.nds.size() ) ;
+    for(unsigned i=0 ; rc == 0 && i < a.nds.size() ; i++)
+    {
+        rc += int( a.nds[i].repeat_index != b.nds[i].repeat_index || a.nds[i].repeat_ordinal != b.nds[i].repeat_ordinal ) ;
+    }
+    rc += int( a.rem.size() != b.rem.size() ) ;
+    for(unsigned i=0 ; rc == 0 && i < a.rem.size() ; i++) rc += int( a.rem[i].index != b.rem[i].index ) ;
+
+    rc += int( a.inst_nidx != b.inst_nidx ) ;
+    rc += int( a.inst.size() != b.inst.size() || memcmp(a.inst.data(), b.inst.data(), a.inst.size()*sizeof(glm::tmat4x4<double>)) != 0 ) ;
+    rc += int( a.iinst.size() != b.iinst.size() || memcmp(a.iinst.data(), b.iinst.data(), a.iinst.size()*sizeof(glm::tmat4x4<double>)) != 0 ) ;
+    return rc ;
+}
+
+inline int stree_factorize_test::Main()
+{
+    int num_pmt = ssys::getenvint("NUM_PMT", 50000) ;
+    int num_panel = ssys::getenvint("NUM_PANEL", 100) ;
+    int num_bar = 64 ;
+
+    stree_factorize_test ta ;
+    stree_factorize_test tb ;
+    stree a ;
+    stree b ;
+    ta.build(a, num_pmt, num_panel, num_bar );
+    tb.build(b, num_pmt, num_panel, num_bar );
+
+    a.num_thread = 1 ;
+    b.num_thread = ssys::getenvint("NUM_THREAD", 0) ;
+
+    int64_t t_a[NUM_PASS+1] ;
+    int64_t t_b[NUM_PASS+1] ;
+    Factorize(a, t_a );
+    Factorize(b, t_b );
+
+    int rc = Compare(a, b) ;
+    rc += int( a.factor.size() != 2 ) ;
+    rc += int( a.factor.size() == 2 && ( a.factor[0].freq != num_pmt || a.factor[1].freq != num_panel*num_bar )) ;
+    rc += int( a.rem.size() != size_t(1 + num_panel) ) ;
+    rc += int( a.inst.size() != size_t(1 + num_pmt + num_panel*num_bar) ) ;
+
+    std::cout
+        << "stree_factorize_test::Main"
+        << " nds " << a.nds.size()
+        << " num_factor " << a.factor.size()
+        << " rem " << a.rem.size()
+        << " inst " << a.inst.size()
+        << " num_thread " << sparallel::NumThread(a.nds.size(), b.num_thread)
+        << "\n"
+        ;
+
+    for(int i=0 ; i < NUM_PASS ; i++) std::cout
+        << std::setw(30) << PASS[i]
+        << " serial " << std::setw(10) << (t_a[i+1] - t_a[i]) << " us"
+        << " parallel " << std::setw(10) << (t_b[i+1] - t_b[i]) << " us"
+        << "\n"
+        ;
+
+    std::cout
+        << std::setw(30) << "total"
+        << " serial " << std::setw(10) << (t_a[NUM_PASS] - t_a[0]) << " us"
+        << " parallel " << std::setw(10) << (t_b[NUM_PASS] - t_b[0]) << " us"
+        << " rc " << rc
+        << "\n"
+        ;
+    return rc ;
+}
+
+int main()
+{
+    return stree_factorize_test::Main() ;
+}
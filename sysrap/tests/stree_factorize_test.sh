@@ -0,0 +1,49 @@
+#!/bin/bash
+usage(){ cat << EOU
+stree_factorize_test.sh
+=========================
+
+Synthetic geometry factorize serial vs parallel comparison and timing::
+
+   ~/o/sysrap/tests/stree_factorize_test.sh
+   NUM_PMT=200000 ~/o/sysrap/tests/stree_factorize_test.sh
+   NUM_THREAD=4 ~/o/sysrap/tests/stree_factorize_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=stree_factorize_test
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=${TMP:-/tmp/$USER/opticks}/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+CUDA_PREFIX=${CUDA_PREFIX:-/usr/local/cuda}
+
+vars="BASH_SOURCE PWD FOLD name bin NUM_PMT NUM_PANEL NUM_THREAD"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc ../snd.cc ../scsg.cc \
+          -std=c++11 -O3 -lstdc++ -lm -pthread \
+          -I.. \
+          -I$CUDA_PREFIX/include \
+          -I$OPTICKS_PREFIX/externals/glm/glm \
+          -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE compile error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
@@ -2,12 +2,44 @@
 stree_loadsave_test.cc
 =========================
 
+Also saves the compact (stree__serialize_compact) form into $FOLD/compact
+and loads it back comparing the per-node transforms and digests with the
+original and reporting the bytes of the persisted arrays of both forms.
 
 **/
 
 
 #include "stree.h"
 
+struct stree_loadsave_test
+{
+    static int Compare(const stree& a, const stree& b, const char* label);
+    static long Bytes(const char* dir);
+};
+
+inline int stree_loadsave_test::Compare(const stree& a, const stree& b, const char* label)
+{
+    int rc = 0 ;
+    rc += int( a.m2w.size() != b.m2w.size() || memcmp(a.m2w.data(), b.m2w.data(), a.m2w.size()*sizeof(glm::tmat4x4<double>)) != 0 ) ;
+    rc += int( a.w2m.size() != b.w2m.size() || memcmp(a.w2m.data(), b.w2m.data(), a.w2m.size()*sizeof(glm::tmat4x4<double>)) != 0 ) ;
+    rc += int( a.gtd.size() != b.gtd.size() || memcmp(a.gtd.data(), b.gtd.data(), a.gtd.size()*sizeof(glm::tmat4x4<double>)) != 0 ) ;
+    rc += int( a.digs != b.digs ) ;
+    rc += int( a.subs != b.subs ) ;
+    std::cout << "stree_loadsave_test::Compare " << label << " rc " << rc << std::endl ;
+    return rc ;
+}
+
+inline long stree_loadsave_test::Bytes(const char* dir)
+{
+    const char* keys[] = { stree::M2W, stree::W2M, stree::GTD, stree::TRAN, stree::TRAN_IDX, stree::DIGS, stree::SUBS, stree::DIGS_U8, stree::SUBS_U8 } ;
+    long bytes = 0 ;
+    for(unsigned i=0 ; i < sizeof(keys)/sizeof(keys[0]) ; i++)
+    {
+        if(spath::Exists(dir, keys[i])) bytes += spath::Filesize(dir, keys[i]) ;
+    }
+    return bytes ;
+}
+
 int main(int argc, char** argv)
 {
     const char* ss = "$HOME/.opticks/GEOM/$GEOM/CSGFoundry/SSim" ; 
@@ -27,6 +59,24 @@ int main(int argc, char** argv)
  
     std::cout << "b.desc" << std::endl << b.desc_size() << std::endl ; 
 
+    a.serialize_compact = true ;
+    a.save("$FOLD/compact") ;
+
+    stree c ;
+    rc = c.load("$FOLD/compact");
+    if( rc != 0 ) return rc ;
+
+    int mismatch = 0 ;
+    mismatch += stree_loadsave_test::Compare(a, b, "full" );
+    mismatch += stree_loadsave_test::Compare(a, c, "compact" );
+
+    std::cout
+        << " transform and digest bytes"
+        << " full " << stree_loadsave_test::Bytes("$FOLD/stree")
+        << " compact " << stree_loadsave_test::Bytes("$FOLD/compact/stree")
+        << std::endl
+        ;
+    if( mismatch != 0 ) return 1 ;
 
     return 0 ; 
 }
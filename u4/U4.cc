@@ -10,6 +10,7 @@
 #include "G4Track.hh"
 #include "G4OpticalPhoton.hh"
 #include "G4Event.hh"
+#include "G4Threading.hh"
 
 #include "SEvt.hh"
 #include "scuda.h"
@@ -54,19 +55,22 @@ That is like the PImpl pattern : pointer to implementation.
 
 HMM: perhapa this state belongs better within SEvt together with the full gensteps ?
 
+The state is thread_local as with G4MTRunManager each worker thread
+runs its own photon generation loops, see SEvt::MT_GENSTEP.
+
 **/
 
 
 #ifdef WITH_CUSTOM4
-static C4GS gs = {} ;            // updated by eg U4::CollectGenstep_DsG4Scintillation_r4695 prior to each photon generation loop
-static C4Pho ancestor = {} ;     // updated by U4::GenPhotonAncestor prior to the photon generation loop(s)
-static C4Pho pho = {} ;          // updated by U4::GenPhotonBegin at start of photon generation loop
-static C4Pho secondary = {} ;    // updated by U4::GenPhotonEnd   at end of photon generation loop
+static thread_local C4GS gs = {} ;            // updated by eg U4::CollectGenstep_DsG4Scintillation_r4695 prior to each photon generation loop
+static thread_local C4Pho ancestor = {} ;     // updated by U4::GenPhotonAncestor prior to the photon generation loop(s)
+static thread_local C4Pho pho = {} ;          // updated by U4::GenPhotonBegin at start of photon generation loop
+static thread_local C4Pho secondary = {} ;    // updated by U4::GenPhotonEnd   at end of photon generation loop
 #else
-static sgs gs = {} ;            // updated by eg U4::CollectGenstep_DsG4Scintillation_r4695 prior to each photon generation loop
-static spho ancestor = {} ;     // updated by U4::GenPhotonAncestor prior to the photon generation loop(s)
-static spho pho = {} ;          // updated by U4::GenPhotonBegin at start of photon generation loop
-static spho secondary = {} ;    // updated by U4::GenPhotonEnd   at end of photon generation loop
+static thread_local sgs gs = {} ;            // updated by eg U4::CollectGenstep_DsG4Scintillation_r4695 prior to each photon generation loop
+static thread_local spho ancestor = {} ;     // updated by U4::GenPhotonAncestor prior to the photon generation loop(s)
+static thread_local spho pho = {} ;          // updated by U4::GenPhotonBegin at start of photon generation loop
+static thread_local spho secondary = {} ;    // updated by U4::GenPhotonEnd   at end of photon generation loop
 #endif
 
 static bool dump = false ;
@@ -165,6 +169,7 @@ void U4::CollectGenstep_DsG4Scintillation_r4695(
 
 
     quad6 gs_ = MakeGenstep_DsG4Scintillation_r4695( aTrack, aStep, numPhotons, scnt, ScintillationTime);
+    if(SEvt::MT_GENSTEP) SEvt::SetGenstepThreadIndex(G4Threading::G4GetThreadId());
 
 #ifdef WITH_CUSTOM4
     sgs _gs = SEvt::AddGenstep(gs_);    // returns sgs struct which is a simple 4 int label
@@ -277,6 +282,7 @@ void U4::CollectGenstep_G4Cerenkov_modified(
 
 
     quad6 gs_ = MakeGenstep_G4Cerenkov_modified( aTrack, aStep, numPhotons, betaInverse, pmin, pmax, maxCos, maxSin2, meanNumberOfPhotons1, meanNumberOfPhotons2 );
+    if(SEvt::MT_GENSTEP) SEvt::SetGenstepThreadIndex(G4Threading::G4GetThreadId());
 
 #ifdef WITH_CUSTOM4
     sgs _gs = SEvt::AddGenstep(gs_);    // returns sgs struct which is a simple 4 int label
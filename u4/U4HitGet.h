@@ -5,12 +5,17 @@ U4HitGet.h
 
 See: u4/tests/U4HitTest.cc
 
+FromEvt_Batch converts all hits of the event in one call using
+SEvt::getLocalHits, for use from sensitive detector EndOfEvent
+in place of looping over FromEvt for each hit.
+
 
 **/
 
 #include "scuda.h"
 #include "sphoton.h"
 #include "sphit.h"
+#include "SLocalHit.h"
 
 #include "SEvt.hh"
 #include "U4Hit.h"
@@ -22,6 +27,8 @@ struct U4HitGet
     static void FromEvt_EGPU(U4Hit& hit, unsigned idx );  
     static void FromEvt_ECPU(U4Hit& hit, unsigned idx );  
     static void FromEvt(U4Hit& hit, unsigned idx, int eidx );  
+    static void FromLocalHit(U4Hit& hit, const SLocalHit& lh, int i ); 
+    static int  FromEvt_Batch(std::vector<U4Hit>& hits, SLocalHit& lh, int eidx, int num_thread=0 ); 
 }; 
 
 inline void U4HitGet::ConvertFromPhoton(U4Hit& hit,  const sphoton& global, const sphoton& local, const sphit& ht )
@@ -68,5 +75,29 @@ inline void U4HitGet::FromEvt(U4Hit& hit, unsigned idx, int eidx )
     ConvertFromPhoton(hit, global, local, ht ); 
 }
 
+inline void U4HitGet::FromLocalHit(U4Hit& hit, const SLocalHit& lh, int i )
+{
+    ConvertFromPhoton(hit, lh.global[i], lh.local[i], lh.ht[i] ); 
+}
+
+/**
+U4HitGet::FromEvt_Batch
+-------------------------
+
+Fills *hits* with all hits of the event, after any efficiency
+culling configured on *lh*. The photonIndex of each U4Hit
+is the sphoton idx, *lh.hidx* gives the index into the hit array.
 
+**/
+
+inline int U4HitGet::FromEvt_Batch(std::vector<U4Hit>& hits, SLocalHit& lh, int eidx, int num_thread )
+{
+    SEvt* sev = SEvt::Get(eidx); 
+    sev->getLocalHits(lh, num_thread); 
+
+    int num = lh.num(); 
+    hits.resize(num); 
+    for(int i=0 ; i < num ; i++) FromLocalHit(hits[i], lh, i ); 
+    return num ; 
+}
 
@@ -15,6 +15,7 @@
 #include "SSim.hh"
 #include "SBnd.h"
 #include "sdomain.h"
+#include "sdomain_adaptive.h"
 #include "sproplist.h"
 
 #include "NPFold.h"
@@ -627,13 +628,18 @@ of G4OpRayleigh process.
 
 So need to override the source of some props.
 
+The dom_ argument is used for the non-uniform domain of sdomain_adaptive,
+see U4Tree::initAdaptive, default is the standard uniform domain. 
+
 **/
 
 NP* U4Material::MakeStandardArray(
     std::vector<const G4Material*>& mats,
-    const std::map<std::string,G4PhysicsVector*>& prop_override ) // static
+    const std::map<std::string,G4PhysicsVector*>& prop_override,
+    const sdomain* dom_ ) // static
 {
-    sdomain dom ;
+    sdomain dom0 ;
+    const sdomain& dom = dom_ ? *dom_ : dom0 ;
     const sproplist* pl = sproplist::Material() ;
 
     int ni = mats.size() ;
@@ -721,6 +727,50 @@ NP* U4Material::MakeStandardArray(
 
 
 
+/**
+U4Material::AddAdaptive
+-------------------------
+
+Adds the standard properties of all materials that have them,
+with the same overrides as U4Material::MakeStandardArray, 
+to the sdomain_adaptive which chooses the non-uniform domain knots. 
+Defaulted properties are constant so need no knots. 
+
+**/
+
+void U4Material::AddAdaptive(
+    sdomain_adaptive* ad, 
+    std::vector<const G4Material*>& mats,
+    const std::map<std::string,G4PhysicsVector*>& prop_override ) // static 
+{
+    const sproplist* pl = sproplist::Material() ;
+    int ni = mats.size() ;
+    int nj = sprop::NUM_PAYLOAD_GRP ;
+    int nl = sprop::NUM_PAYLOAD_VAL ;
+
+    for(int i=0 ; i < ni ; i++)
+    {
+        const G4Material* mat = mats[i] ;
+        const G4String& name = mat->GetName() ;
+        G4MaterialPropertiesTable* mpt = mat->GetMaterialPropertiesTable();
+
+        for(int j=0 ; j < nj ; j++)
+        for(int l=0 ; l < nl ; l++)
+        {
+            const sprop* p = pl->get(j,l) ;
+            const char* key = p->name ;
+            std::string spec = std::string(name) + "/" + key ;  // eg "Water/RAYLEIGH"
+
+            bool has_override = prop_override.count(spec) > 0 ;
+            G4PhysicsVector* prop = has_override ? prop_override.at(spec) : ( mpt ? mpt->GetProperty(key) : nullptr ) ;
+            if( prop == nullptr ) continue ;
+
+            ad->add_fn( spec.c_str(), [prop](double nm){ return prop->Value( sdomain::hc_eVnm/nm*eV ) ; } );
+        }
+    }
+}
+
+
 /**
 U4Material::Classify
 ---------------------
@@ -15,6 +15,8 @@ HMM: make this header-only .h ?
 
 struct NP ; 
 struct NPFold ; 
+struct sdomain ; 
+struct sdomain_adaptive ; 
 
 class G4Material ; 
 class G4MaterialPropertiesTable ;
@@ -66,6 +68,12 @@ struct U4_API U4Material
     static G4MaterialPropertyVector* MakeProperty(const NP* a); 
     static NP* MakePropertyArray( double value ); 
     static NP* MakeStandardArray(
+          std::vector<const G4Material*>& mats,
+          const std::map<std::string,G4PhysicsVector*>& prop_override,
+          const sdomain* dom_=nullptr
+       ); 
+    static void AddAdaptive(
+          sdomain_adaptive* ad, 
           std::vector<const G4Material*>& mats,
           const std::map<std::string,G4PhysicsVector*>& prop_override
        ); 
@@ -12,6 +12,7 @@
 
 #include "NP.hh"
 #include "spath.h"
+#include "s_seqpager.h"
 #include "ssys.h"
 
 #include "SEvt.hh"
@@ -79,7 +80,8 @@ full-sample and sub-sample running.
 
 Not that *seq* can either be the path to an .npy file
 or the path to a directory containing .npy files which 
-are concatenated using NP::Load/NP::Concatenate.
+are paged by s_seqpager or with U4Random__PAGED=0 are 
+concatenated using NP::Load/NP::Concatenate.
 
 TODO: when next need to use seqmask, change the interface to enabling it 
 to be envvar OR SEventConfig based and eliminate the U4Random arguments 
@@ -91,14 +93,18 @@ U4Random::U4Random(const char* seq, const char* seqmask)
     m_seqpath_( seq ? seq : SeqPath() ), 
     m_seqpath(spath::Resolve(m_seqpath_)), 
     m_seqpath_exists( NP::Exists( m_seqpath ) || NP::ExistsArrayFolder(m_seqpath) ),
-    m_seq(m_seqpath_exists ? NP::Load(m_seqpath) : nullptr),
+    m_paged(ssys::getenvint(_PAGED, 1) > 0),
+    m_pager(m_seqpath_exists && m_paged ? s_seqpager::Create(m_seqpath) : nullptr),
+    m_seq(m_seqpath_exists && m_pager == nullptr ? NP::Load(m_seqpath) : nullptr),
     m_seq_values(m_seq ? m_seq->cvalues<float>() : nullptr ),
-    m_seq_ni(m_seq ? m_seq->shape[0] : 0 ),                        // num items
-    m_seq_nv(m_seq ? m_seq->shape[1]*m_seq->shape[2] : 0 ),        // num values in each item 
+    m_seq_ni(m_pager ? m_pager->ni : ( m_seq ? m_seq->shape[0] : 0 )),                        // num items
+    m_seq_nv(m_pager ? m_pager->nv : ( m_seq ? m_seq->shape[1]*m_seq->shape[2] : 0 )),        // num values in each item 
     m_seq_index(-1),
 
-    m_cur(m_seq_ni > 0 ? NP::Make<int>(m_seq_ni) : nullptr),
+    m_cur(m_seq ? NP::Make<int>(m_seq_ni) : nullptr),    // paged cursors are held by s_seqpager 
     m_cur_values(m_cur ? m_cur->values<int>() : nullptr),
+    m_item(nullptr),
+    m_item_cursor(nullptr),
     m_recycle(true),
     m_default(CLHEP::HepRandom::getTheEngine()),
 
@@ -177,7 +183,7 @@ std::string U4Random::descSelect(int photon_idx, int flat_cursor ) const
 void U4Random::init()
 {
     INSTANCE = this ; 
-    m_ready = m_seq != nullptr ; 
+    m_ready = m_seq != nullptr || m_pager != nullptr ; 
     LOG_IF(error, m_ready == false)
         << desc()
         << std::endl 
@@ -199,6 +205,7 @@ std::string U4Random::desc() const
          << " m_seqpath " << ( m_seqpath ? m_seqpath : "-" )
          << " m_seq_ni " << m_seq_ni 
          << " m_seq_nv " << m_seq_nv 
+         << " m_paged " << ( m_paged ? "YES" : "NO" )
          ; 
     return ss.str();
 }
@@ -212,6 +219,7 @@ std::string U4Random::detail() const
        << std::setw(20) << "m_seqpath"         << " : " << ( m_seqpath  ? m_seqpath : "-" ) << "\n"
        << std::setw(20) << "m_seqpath_exists"  << " : " << ( m_seqpath_exists  ? "YES" : "NO " ) << "\n"
        << std::setw(20) << "m_seq"             << " : " << ( m_seq ? m_seq->desc() : "-" ) << "\n"
+       << std::setw(20) << "m_pager"           << " : " << ( m_pager ? m_pager->desc() : "-" ) << "\n"
        << std::setw(20) << "m_seq_index"       << " : " << m_seq_index  << "\n"
        << std::setw(20) << "m_cur"             << " : " << ( m_cur ? m_cur->desc() : "-" ) << "\n"
        << std::setw(20) << "m_seqmask "        << " : " << ( m_seqmask ? m_seqmask->desc() : "-" ) << "\n"
@@ -227,13 +235,14 @@ U4Random::getNumIndices
 -----------------------------
 
 With seqmask running returned the number of seqmask indices otherwise returns the total number of indices. 
-This corresponds to the total number of available streams of randoms. 
+This corresponds to the total number of available streams of randoms, whether loaded or paged. 
 
 **/
 
 size_t U4Random::getNumIndices() const
 {
-   return m_seq && m_seqmask ? m_seqmask_ni : ( m_seq ? m_seq_ni : 0 ) ; 
+   bool has_seq = m_seq != nullptr || m_pager != nullptr ; 
+   return has_seq && m_seqmask ? m_seqmask_ni : ( has_seq ? m_seq_ni : 0 ) ; 
 }
 
 /**
@@ -321,13 +330,42 @@ void U4Random::setSequenceIndex(int index_)
                 ; 
         assert( idx_in_range );
         m_seq_index = idx ; 
+        setItem(); 
         enable();
     }   
 }
 
 
+/**
+U4Random::setItem
+-------------------
+
+Sets the pointers to the randoms and cursor of the current m_seq_index. 
+When paged this maps the chunk of the index if not already resident, 
+the pointers remain valid until the next setSequenceIndex as 
+only that can change the resident chunks. 
+
+**/
+
+void U4Random::setItem()
+{
+    if( m_pager )
+    {
+        m_item = m_pager->item(m_seq_index, &m_item_cursor ); 
+        LOG_IF(fatal, m_item == nullptr) << " FAILED to page item " << m_seq_index << " " << m_pager->desc() ; 
+        assert( m_item ); 
+    }
+    else
+    {
+        m_item = m_seq_values + size_t(m_seq_index)*m_seq_nv ; 
+        m_item_cursor = m_cur_values + m_seq_index ; 
+    }
+}
+
+
 U4Random::~U4Random()
 {
+    delete m_pager ; 
 }
 
 /**
@@ -387,7 +425,7 @@ U4Random::flat
 
 This is the engine method that gets invoked by G4UniformRand calls 
 and which returns pre-cooked randoms. 
-The *m_cur_values* cursor is updated to maintain the place in the sequence. 
+The *m_item_cursor* cursor is updated to maintain the place in the sequence. 
 
 **/
 
@@ -395,7 +433,7 @@ double U4Random::flat()
 {
     assert(m_seq_index > -1) ;  // must not call when disabled, use G4UniformRand to use standard engine
 
-    int cursor = *(m_cur_values + m_seq_index) ;  // get the cursor value to use for this generation, starting from 0 
+    int cursor = *m_item_cursor ;  // get the cursor value to use for this generation, starting from 0 
 
     if( cursor >= m_seq_nv )
     {
@@ -429,13 +467,13 @@ double U4Random::flat()
 
 
 
-    int idx = m_seq_index*m_seq_nv + cursor ;
+    size_t idx = size_t(m_seq_index)*m_seq_nv + cursor ;
 
-    float  f = m_seq_values[idx] ;
+    float  f = m_item[cursor] ;
     double d = f ;     // promote random float to double 
     m_flat_prior = d ; 
 
-    *(m_cur_values + m_seq_index) += 1 ;          // increment the cursor in the array, for the next generation 
+    *m_item_cursor += 1 ;          // increment the cursor in the array, for the next generation 
 
     if(m_seq_index == SEvt::PIDX)
     { 
@@ -508,7 +546,7 @@ of the index. A comparison between the below counts is made:
 void U4Random::check_cursor_vs_tagslot() 
 {
     assert(m_seq_index > -1) ;  // must not call when disabled, use G4UniformRand to use standard engine
-    int cursor = *(m_cur_values + m_seq_index) ;  // get the cursor value to use for this generation, starting from 0 
+    int cursor = *m_item_cursor ;  // get the cursor value to use for this generation, starting from 0 
 
     if(SEvt::Exists(1) == false)
     {
@@ -584,7 +622,7 @@ unsigned U4Random::getFlatTag()
 int U4Random::getFlatCursor() const 
 {
     if(m_seq_index < 0) return -1 ; 
-    int cursor = *(m_cur_values + m_seq_index) ;  // get the cursor value to use for this generation, starting from 0 
+    int cursor = *m_item_cursor ;  // get the cursor value to use for this generation, starting from 0 
     return cursor ; 
 }
 
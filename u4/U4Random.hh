@@ -16,6 +16,13 @@ The idea is to control the random stream separately for each photon slot.
 
 This was developed from examples/Geant4/CerenkovStandalone/OpticksRandom.hh
 
+By default the precooked randoms are paged with s_seqpager, memory mapping
+the chunk files of the OPTICKS_RANDOM_SEQPATH folder as the photon indices
+passed to *setSequenceIndex* require them, keeping at most
+s_seqpager__MAX_RESIDENT chunks resident. This allows aligned running with
+any number of photons with flat memory. Use U4Random__PAGED=0 to instead
+load and concatenate all the chunks into memory as formerly.
+
 **/
 
 #include <vector>
@@ -25,6 +32,7 @@ This was developed from examples/Geant4/CerenkovStandalone/OpticksRandom.hh
 #include "SRandom.h"
 #include "U4_API_EXPORT.hh"
 struct NP ; 
+struct s_seqpager ; 
 
 struct U4_API U4Random : public CLHEP::HepRandomEngine, public SRandom 
 {
@@ -36,6 +44,7 @@ struct U4_API U4Random : public CLHEP::HepRandomEngine, public SRandom
     static constexpr const char* DEFAULT_SEQPATH = "${PrecookedDir:-$HOME/.opticks/precooked}/QSimTest/rng_sequence/rng_sequence_f_ni1000000_nj16_nk16_tranche100000/rng_sequence_f_ni100000_nj16_nk16_ioffset000000.npy" ; 
 
     static constexpr const char* OPTICKS_RANDOM_SEQPATH = "OPTICKS_RANDOM_SEQPATH" ; 
+    static constexpr const char* _PAGED = "U4Random__PAGED" ; 
     static const char* SeqPath(); 
 
     static constexpr const char* NOTES = R"LITERAL(
@@ -75,6 +84,8 @@ Steps to fix:
     const char*              m_seqpath_ ; 
     const char*              m_seqpath ; 
     bool                     m_seqpath_exists ; 
+    bool                     m_paged ; 
+    s_seqpager*              m_pager ; 
     const NP*                m_seq;  
     const float*             m_seq_values ; 
     int                      m_seq_ni ; 
@@ -84,6 +95,8 @@ Steps to fix:
 
     NP*                      m_cur ; 
     int*                     m_cur_values ; 
+    const float*             m_item ;           // randoms of the current m_seq_index 
+    int*                     m_item_cursor ;    // cursor of the current m_seq_index 
     bool                     m_recycle ; 
 
     CLHEP::HepRandomEngine*  m_default ;
@@ -124,6 +137,7 @@ public:
     size_t getNumIndices() const ;
     size_t getMaskedIndex(int index_);
     void setSequenceIndex(int index_);  
+    void setItem(); 
 #ifndef PRODUCTION
 #ifdef DEBUG_TAG
     void check_cursor_vs_tagslot(); 
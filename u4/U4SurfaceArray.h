@@ -51,6 +51,7 @@ into the optical buffer by sstandard::make_optical
 
 #include "NP.hh"
 #include "sdomain.h"
+#include "sdomain_adaptive.h"
 #include "sprop.h"
 
 #include "U4SurfacePerfect.h"
@@ -78,9 +79,12 @@ struct U4SurfaceArray
     U4SurfaceArray(
         const std::vector<const G4LogicalSurface*>& surface, 
         const std::vector<std::string>& implicit, 
-        const std::vector<U4SurfacePerfect>& perfect  
+        const std::vector<U4SurfacePerfect>& perfect,
+        const sdomain* dom_=nullptr
         ); 
 
+    static void AddAdaptive( sdomain_adaptive* ad, const std::vector<const G4LogicalSurface*>& surface ); 
+
     void addSurface( int i, const G4LogicalSurface* ls); 
     void addImplicit(int i, const char* name); 
     void addPerfect( int i, const U4SurfacePerfect& perfect ); 
@@ -90,8 +94,10 @@ struct U4SurfaceArray
 inline U4SurfaceArray::U4SurfaceArray(
         const std::vector<const G4LogicalSurface*>& surface, 
         const std::vector<std::string>& implicit, 
-        const std::vector<U4SurfacePerfect>& perfect  )
+        const std::vector<U4SurfacePerfect>& perfect,
+        const sdomain* dom_ )
     :
+    dom(dom_ ? *dom_ : sdomain()),
     num_surface(surface.size()),
     num_implicit(implicit.size()),
     num_perfect(perfect.size()),
@@ -129,6 +135,35 @@ inline U4SurfaceArray::U4SurfaceArray(
 
 
 
+/**
+U4SurfaceArray::AddAdaptive
+-----------------------------
+
+The payload probabilities are linear in EFFICIENCY and REFLECTIVITY
+so adding those to the sdomain_adaptive is sufficient for it to 
+choose knots that also suit the sur array. 
+Implicit and perfect surfaces are constant.
+
+**/
+
+inline void U4SurfaceArray::AddAdaptive( sdomain_adaptive* ad, const std::vector<const G4LogicalSurface*>& surface ) // static
+{
+    const char* KEYS[] = { "EFFICIENCY", "REFLECTIVITY" } ; 
+    for(unsigned i=0 ; i < surface.size() ; i++)
+    {
+        const G4LogicalSurface* ls = surface[i] ; 
+        G4OpticalSurface* os = dynamic_cast<G4OpticalSurface*>(ls->GetSurfaceProperty());
+        G4MaterialPropertiesTable* mpt = os ? os->GetMaterialPropertiesTable() : nullptr ;
+        for(unsigned k=0 ; k < 2 ; k++)
+        {
+            G4MaterialPropertyVector* prop = mpt ? mpt->GetProperty(KEYS[k]) : nullptr ; 
+            if( prop == nullptr ) continue ; 
+            std::string spec = std::string(ls->GetName()) + "/" + KEYS[k] ; 
+            ad->add_fn( spec.c_str(), [prop](double nm){ return prop->Value( sdomain::hc_eVnm/nm*eV ) ; } ); 
+        }
+    }
+}
+
 /**
 U4SurfaceArray::addSurface
 ----------------------------
@@ -146,6 +146,7 @@ private:
     static U4PhysicsTable<G4OpRayleigh>* CreateRayleighTable();
     void initRayleigh();
     void initMaterials();
+    void getPropOverride(std::map<std::string, G4PhysicsVector*>& prop_override) const ;
     void initMaterials_NoRINDEX();
 
     void initMaterials_r(const G4VPhysicalVolume* const pv);
@@ -174,6 +175,7 @@ private:
         );
 
     void initSurfaces_Serialize();
+    void initAdaptive();
     void initStandard();
     void initRecorder();
 
@@ -302,6 +304,9 @@ inline void U4Tree::init()
     LOG(LEVEL) << "-initSurfaces_Serialize" ;
     initSurfaces_Serialize();
 
+    LOG(LEVEL) << "-initAdaptive" ;
+    initAdaptive();
+
     LOG(LEVEL) << "-initStandard" ;
     initStandard();
 
@@ -347,15 +352,19 @@ inline void U4Tree::initMaterials()
     st->material = U4Material::MakePropertyFold(materials);
 
     std::map<std::string, G4PhysicsVector*> prop_override ;
-
-    G4PhysicsVector* Water_RAYLEIGH = rayleigh_table->find("Water") ;
-    if(Water_RAYLEIGH) prop_override["Water/RAYLEIGH"] = Water_RAYLEIGH ;
+    getPropOverride(prop_override);
 
     st->standard->mat = U4Material::MakeStandardArray(materials, prop_override) ;
 
     LOG_IF(info, material_debug > 0 ) << "]" ;
 }
 
+inline void U4Tree::getPropOverride(std::map<std::string, G4PhysicsVector*>& prop_override) const
+{
+    G4PhysicsVector* Water_RAYLEIGH = rayleigh_table->find("Water") ;
+    if(Water_RAYLEIGH) prop_override["Water/RAYLEIGH"] = Water_RAYLEIGH ;
+}
+
 inline void U4Tree::initMaterials_NoRINDEX()
 {
     int num_materials = materials.size() ;
@@ -589,6 +598,44 @@ inline void U4Tree::initSurfaces_Serialize()
 
 
 
+/**
+U4Tree::initAdaptive
+----------------------
+
+Only with envvar sstandard__ADAPTIVE. Chooses a non-uniform wavelength
+domain from the material and surface properties with sdomain_adaptive
+and recreates the standard mat and sur arrays on that domain.
+This has to wait until after initSurfaces_Serialize as the surfaces
+are needed to choose the domain. The domain remap and the per property
+error report are persisted by sstandard, see sdomain_adaptive.h
+
+**/
+
+inline void U4Tree::initAdaptive()
+{
+    if(!ssys::getenvbool(sstandard::sstandard__ADAPTIVE)) return ;
+
+    std::map<std::string, G4PhysicsVector*> prop_override ;
+    getPropOverride(prop_override);
+
+    sdomain_adaptive* ad = new sdomain_adaptive ;
+    U4Material::AddAdaptive(ad, materials, prop_override );
+    U4SurfaceArray::AddAdaptive(ad, surfaces );
+    ad->finalize();
+    LOG(LEVEL) << ad->desc() ;
+
+    sdomain dom(ad->knots) ;
+    st->standard->mat = U4Material::MakeStandardArray(materials, prop_override, &dom ) ;
+
+    std::vector<U4SurfacePerfect> perfect ;
+    U4SurfacePerfect::Get(perfect);
+    U4SurfaceArray serialize(surfaces, st->implicit, perfect, &dom ) ;
+    st->standard->sur = serialize.sur ;
+    st->standard->adaptive = ad ;
+}
+
+
+
 /**
 U4Tree::initSolids
 -------------------
@@ -631,7 +678,7 @@ U4Tree::initSolids_Keys
 
 The st->soname_raw which may have 0x suffixes are
 tail stripped and if needed uniqued with _0 _1 suffix
-to form st->soname
+to form st->soname, which is then indexed for stree::find_lvid
 
 **/
 
@@ -639,6 +686,7 @@ inline void U4Tree::initSolids_Keys()
 {
     sstr::StripTail_Unique( st->soname, st->soname_raw, "0x" );
     assert( st->soname.size() == st->soname_raw.size() );
+    st->init_soname_index();
 }
 
 